@@ -282,6 +282,11 @@ extern void XrmPutFileDatabase(
     _Xconst char*	/* filename */
 );
 
+extern void XrmPutBinaryFileDatabase(
+    XrmDatabase		/* database */,
+    _Xconst char*	/* filename */
+);
+
 extern void XrmMergeDatabases(
     XrmDatabase		/* source_db */,
     XrmDatabase*	/* target_db */
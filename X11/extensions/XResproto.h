@@ -224,4 +224,74 @@ typedef struct {
 } xXResQueryResourceBytesReply;
 #define sz_xXResQueryResourceBytesReply  32
 
+/* XResQueryClientLatency                                                */
+/* Server-side addition, not part of the published X-Resource protocol:  */
+/* returns per-major-opcode request latency histograms for a client.     */
+/* The first query arms collection for that client, so counts accumulate */
+/* from the first query onwards.                                         */
+
+#define X_XResQueryClientLatency      6
+
+typedef struct _XResQueryClientLatency {
+   CARD8   reqType;
+   CARD8   XResReqType;
+   CARD16  length;
+   CARD32  xid;
+} xXResQueryClientLatencyReq;
+#define sz_xXResQueryClientLatencyReq 8
+
+typedef struct {
+   CARD8   type;
+   CARD8   pad1;
+   CARD16  sequenceNumber;
+   CARD32  length;
+   CARD32  num_opcodes;  /* xXResOpcodeLatency entries following */
+   CARD32  num_buckets;  /* CARD32 counts per entry */
+   CARD32  pad2;
+   CARD32  pad3;
+   CARD32  pad4;
+   CARD32  pad5;
+} xXResQueryClientLatencyReply;
+#define sz_xXResQueryClientLatencyReply  32
+
+typedef struct _XResOpcodeLatency {
+   CARD32  opcode;       /* major opcode */
+   // followed by num_buckets CARD32s; count n holds requests that
+   // completed in [2^(n-1), 2^n) microseconds, the last one everything
+   // slower
+} xXResOpcodeLatency;
+#define sz_xXResOpcodeLatency 4
+
+/* XResQueryWindowFrameTiming                                            */
+/* Server-side addition, not part of the published X-Resource protocol:  */
+/* returns the frame count and frame interval histogram for a window,    */
+/* as collected from DBE buffer swaps and Present executions.  Windows   */
+/* that have never presented report zero frames.                         */
+
+#define X_XResQueryWindowFrameTiming  7
+
+typedef struct _XResQueryWindowFrameTiming {
+   CARD8   reqType;
+   CARD8   XResReqType;
+   CARD16  length;
+   CARD32  window;
+} xXResQueryWindowFrameTimingReq;
+#define sz_xXResQueryWindowFrameTimingReq 8
+
+typedef struct {
+   CARD8   type;
+   CARD8   pad1;
+   CARD16  sequenceNumber;
+   CARD32  length;
+   CARD32  frames;        /* total frames recorded */
+   CARD32  msecSinceLast; /* milliseconds since the latest frame */
+   CARD32  num_buckets;   /* CARD32 interval counts following; count n
+                             holds intervals of [2^(n-1), 2^n) ms, the
+                             last one everything slower */
+   CARD32  pad2;
+   CARD32  pad3;
+   CARD32  pad4;
+} xXResQueryWindowFrameTimingReply;
+#define sz_xXResQueryWindowFrameTimingReply  32
+
 #endif /* _XRESPROTO_H */
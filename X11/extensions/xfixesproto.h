@@ -566,6 +566,17 @@ typedef struct {
 
 #define sz_xXFixesGetClientDisconnectModeReply	32
 
+typedef struct {
+    CARD8   reqType;
+    CARD8   xfixesReqType;
+    CARD16  length;
+    CARD32  cursorSerial;
+} xXFixesGetCursorImageIfNewerReq;
+
+#define sz_xXFixesGetCursorImageIfNewerReq  8
+
+/* GetCursorImageIfNewer reply is xXFixesGetCursorImageReply */
+
 #undef Barrier
 #undef Region
 #undef Picture
@@ -92,8 +92,9 @@
 /*************** Version 6 ******************/
 #define X_XFixesSetClientDisconnectMode	    33
 #define X_XFixesGetClientDisconnectMode	    34
+#define X_XFixesGetCursorImageIfNewer	    35
 
-#define XFixesNumberRequests		    (X_XFixesGetClientDisconnectMode+1)
+#define XFixesNumberRequests		    (X_XFixesGetCursorImageIfNewer+1)
 
 /* Selection events share one event number */
 #define XFixesSelectionNotify		    0
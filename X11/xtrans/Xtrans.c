@@ -1276,60 +1276,62 @@ TRANS(MakeAllCOTSServerListeners) (const char *port, int *partial,
 #ifdef WIN32
 
 /*
- * emulate readv
+ * Scatter-gather I/O over winsock.
+ *
+ * These used to be emulated with one send()/recv() call per iovec
+ * element, which cost a syscall per buffer and made partially written
+ * gathers common.  WSASend()/WSARecv() take the whole vector at once;
+ * the iovecs only need repacking because WSABUF stores (len, base)
+ * rather than (base, len).
  */
 
+#define XTRANS_MAX_WSABUF 16
+
 static int TRANS(ReadV) (XtransConnInfo ciptr, struct iovec *iov, int iovcnt)
 
 {
-    int i, len, total;
-    char *base;
-
-    ESET(0);
-    for (i = 0, total = 0;  i < iovcnt;  i++, iov++) {
-	len = iov->iov_len;
-	base = iov->iov_base;
-	while (len > 0) {
-	    register int nbytes;
-	    nbytes = TRANS(Read) (ciptr, base, len);
-	    if (nbytes < 0 && total == 0)  return -1;
-	    if (nbytes <= 0)  return total;
-	    ESET(0);
-	    len   -= nbytes;
-	    total += nbytes;
-	    base  += nbytes;
-	}
-    }
-    return total;
-}
+    WSABUF wsabufs[XTRANS_MAX_WSABUF];
+    DWORD nread, flags;
+    int i;
 
+    if (iovcnt > XTRANS_MAX_WSABUF)
+	iovcnt = XTRANS_MAX_WSABUF;
 
-/*
- * emulate writev
- */
+    for (i = 0; i < iovcnt; i++) {
+	wsabufs[i].buf = iov[i].iov_base;
+	wsabufs[i].len = iov[i].iov_len;
+    }
+
+    flags = 0;
+    if (WSARecv ((SOCKET) ciptr->fd, wsabufs, iovcnt, &nread,
+		 &flags, NULL, NULL) == SOCKET_ERROR) {
+	errno = WSAGetLastError ();
+	return -1;
+    }
+    return nread;
+}
 
 static int TRANS(WriteV) (XtransConnInfo ciptr, struct iovec *iov, int iovcnt)
 
 {
-    int i, len, total;
-    char *base;
-
-    ESET(0);
-    for (i = 0, total = 0;  i < iovcnt;  i++, iov++) {
-	len = iov->iov_len;
-	base = iov->iov_base;
-	while (len > 0) {
-	    register int nbytes;
-	    nbytes = TRANS(Write) (ciptr, base, len);
-	    if (nbytes < 0 && total == 0)  return -1;
-	    if (nbytes <= 0)  return total;
-	    ESET(0);
-	    len   -= nbytes;
-	    total += nbytes;
-	    base  += nbytes;
-	}
+    WSABUF wsabufs[XTRANS_MAX_WSABUF];
+    DWORD nwritten;
+    int i;
+
+    if (iovcnt > XTRANS_MAX_WSABUF)
+	iovcnt = XTRANS_MAX_WSABUF;
+
+    for (i = 0; i < iovcnt; i++) {
+	wsabufs[i].buf = iov[i].iov_base;
+	wsabufs[i].len = iov[i].iov_len;
+    }
+
+    if (WSASend ((SOCKET) ciptr->fd, wsabufs, iovcnt, &nwritten,
+		 0, NULL, NULL) == SOCKET_ERROR) {
+	errno = WSAGetLastError ();
+	return -1;
     }
-    return total;
+    return nwritten;
 }
 
 #endif /* WIN32 */
@@ -136,6 +136,25 @@ from the copyright holders.
 #define XOS_USE_MTSAFE_NETDBAPI
 #include <X11/Xos_r.h>
 
+#if defined(UNIXCONN)
+/*
+ * Windows 10 1803 and later support AF_UNIX stream sockets.  The
+ * <afunix.h> header is missing from older SDKs, so declare the
+ * address structure ourselves; on systems without AF_UNIX support
+ * socket() simply fails and the caller falls back to TCP.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef UNIX_PATH_MAX
+#define UNIX_PATH_MAX 108
+struct sockaddr_un
+{
+    ADDRESS_FAMILY sun_family;
+    char sun_path[UNIX_PATH_MAX];
+};
+#endif
+#endif /* UNIXCONN */
+
 #if defined(HYPERV)
 #define AF_HYPERV 34
 #define HV_PROTOCOL_RAW 1
@@ -1417,6 +1436,11 @@ TRANS(SocketUNIXCreateListener) (XtransConnInfo ciptr, const char *port,
     mode = 01777;
 #else
     mode = 0777;
+#endif
+#ifdef WIN32
+    /* There is no /tmp by default on Windows; create the parent so
+       the trans_mkdir of UNIX_DIR below can succeed */
+    mkdir ("/tmp");
 #endif
     if (!abstract && trans_mkdir(UNIX_DIR, mode) == -1) {
 	prmsg (1, "SocketUNIXCreateListener: mkdir(%s) failed, errno = %d\n",
@@ -80,6 +80,8 @@ NULL };
     static const char *suffixmsg[] = {
 "A dash may be used with the \"merge\" and \"source\" to read from the",
 "standard input.  Commands beginning with \"n\" use numeric format.",
+"Several commands may be given in one invocation by separating them",
+"with \";\" arguments; the authority file is read and written once.",
 "",
 NULL };
     const char **msg;
@@ -195,7 +197,24 @@ main(int argc, const char *argv[])
 	exit (1);
     }
 
-    status = process_command (sourcename, 1, nargs, arglist);
+    /* Commands given on the command line may be batched by separating
+     * them with ";" arguments; the authority file is read above and
+     * written below just once for the whole run, so session bring-up
+     * scripts need not lock and rewrite it per command.
+     */
+    status = 0;
+    {
+	int start = 0;
+
+	for (i = 0; i <= nargs; i++) {
+	    if (i == nargs || strcmp (arglist[i], ";") == 0) {
+		if (i > start)
+		    status |= process_command (sourcename, 1, i - start,
+					       arglist + start);
+		start = i + 1;
+	    }
+	}
+    }
 
     (void) auth_finalize ();
     exit ((status != 0) ? 1 : 0);
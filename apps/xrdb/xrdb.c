@@ -46,6 +46,7 @@
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xatom.h>
+#include <X11/Xresource.h>
 #include <X11/Xos.h>
 #include <X11/Xmu/SysUtil.h>
 #include <stdio.h>
@@ -127,6 +128,7 @@ static char tmpname3[32];
 #endif
 static int oper = OPLOAD;
 static char *editFile = NULL;
+static char *compiledFile = NULL;
 static const char *cpp_program = NULL;
 static const char* const cpp_locations[] = { CPP };
 static char *backup_suffix = BACKUP_SUFFIX;
@@ -737,6 +739,7 @@ Syntax (void)
 	     " -merge              merge resources from file & sort\n"
 	     " -edit filename      edit resources into file\n"
 	     " -backup string      backup suffix for -edit [%s]\n"
+	     " -compile filename   also write compiled resources to file\n"
 	     " -symbols            show preprocessor symbols\n"
 	     " -remove             remove resources\n"
 	     " -retain             avoid server reset (avoid using this)\n"
@@ -928,6 +931,10 @@ main(int argc, char *argv[])
 		if (++i >= argc) Syntax ();
 		backup_suffix = argv[i];
 		continue;
+	    } else if (isabbreviation ("-compile", arg, 4)) {
+		if (++i >= argc) Syntax ();
+		compiledFile = argv[i];
+		continue;
 	    } else if (isabbreviation ("-all", arg, 2)) {
 		whichResources = RALL;
 		continue;
@@ -1133,6 +1140,25 @@ FormatEntries(Buffer *buffer, Entries *entries)
     }
 }
 
+/* write the formatted resources as a compiled database (see
+ * XrmPutBinaryFileDatabase) so clients pointed at the file skip
+ * re-lexing the text on every startup
+ */
+static void
+CompileEntries(Buffer *b)
+{
+    XrmDatabase db;
+
+    AppendToBuffer(b, "", 1);	/* NUL terminate for Xrm */
+    b->used--;
+    db = XrmGetStringDatabase(b->buff);
+    if (!db)
+	fatal("%s: can't parse resources for '%s'\n", ProgramName,
+	      compiledFile);
+    XrmPutBinaryFileDatabase(db, compiledFile);
+    XrmDestroyDatabase(db);
+}
+
 static void
 StoreProperty(Display *dpy, Window root, Atom res_prop)
 {
@@ -1313,6 +1339,8 @@ Process(int scrno, Bool doScreen, Bool execute)
 	GetEntries(&newDB, &buffer, 0);
 	if (execute) {
 	    FormatEntries(&buffer, &newDB);
+	    if (compiledFile && !dont_execute)
+		CompileEntries(&buffer);
 	    if (dont_execute) {
 		if (buffer.used > 0) {
 		    fwrite (buffer.buff, 1, buffer.used, stdout);
@@ -227,6 +227,22 @@ struct wininfo {
     xcb_size_hints_t *			normal_hints;
 };
 
+/*
+ * A prefetched node of the window tree, built breadth-first by
+ * fetch_tree_nodes so that the QueryTree requests for every window of a
+ * level are issued in one batch before any reply of that level is
+ * waited for.  A full -tree walk then costs one round trip per tree
+ * level instead of one per window.  The per-window info cookies are
+ * issued as each level is read; their replies are consumed during the
+ * depth-first printing pass, by which time they are already in flight.
+ */
+struct tree_node {
+    struct wininfo			info;
+    xcb_query_tree_reply_t *		tree;
+    struct tree_node *			children; /* num_children nodes */
+    unsigned int			num_children;
+};
+
 static void scale_init (xcb_screen_t *scrn);
 static char *nscale (int, int, int, char *, size_t);
 static char *xscale (int);
@@ -241,7 +257,8 @@ static void Display_Bits_Info (struct wininfo *);
 static void Display_Event_Mask (long);
 static void Display_Events_Info (struct wininfo *);
 static void Display_Tree_Info (struct wininfo *, int);
-static void display_tree_info_1 (struct wininfo *, int, int);
+static void fetch_tree_nodes (struct tree_node **, unsigned int, int);
+static void display_tree_info_1 (struct tree_node *, int, int);
 static void Display_Hints (xcb_size_hints_t *);
 static void Display_Size_Hints (struct wininfo *);
 static void Display_Window_Shape (xcb_window_t);
@@ -1282,24 +1299,90 @@ Display_Events_Info (struct wininfo *w)
 static void
 Display_Tree_Info (struct wininfo *w, int recurse)
 {
-    display_tree_info_1 (w, recurse, 0);
+    struct tree_node root;
+    struct tree_node *level0 = &root;
+
+    memset (&root, 0, sizeof (root));
+    root.info = *w;
+
+    fetch_tree_nodes (&level0, 1, recurse);
+    display_tree_info_1 (&root, recurse, 0);
+}
+
+/*
+ * Read the QueryTree replies for one level of windows, issue the
+ * requests for all of their children in a single batch, and recurse
+ * into the next level.
+ */
+static void
+fetch_tree_nodes (struct tree_node **level, unsigned int num, int recurse)
+{
+    struct tree_node **next_level;
+    unsigned int next_num = 0;
+    unsigned int i, j, n;
+
+    for (i = 0; i < num; i++) {
+	struct tree_node *node = level[i];
+	xcb_window_t *child_list;
+
+	node->tree = xcb_query_tree_reply (dpy, node->info.tree_cookie, &err);
+	if (!node->tree) {
+	    Print_X_Error (dpy, err);
+	    Fatal_Error ("Can't query window tree.");
+	}
+
+	n = xcb_query_tree_children_length (node->tree);
+	node->num_children = n;
+	if (n == 0)
+	    continue;
+
+	child_list = xcb_query_tree_children (node->tree);
+	node->children = calloc (n, sizeof (struct tree_node));
+	if (node->children == NULL)
+	    Fatal_Error ("Failed to allocate memory in fetch_tree_nodes");
+
+	for (j = 0; j < n; j++) {
+	    struct wininfo *cw = &node->children[j].info;
+
+	    cw->window = child_list[j];
+	    cw->net_wm_name_cookie = get_net_wm_name (dpy, child_list[j]);
+	    cw->wm_name_cookie = xcb_icccm_get_wm_name (dpy, child_list[j]);
+	    cw->wm_class_cookie = xcb_icccm_get_wm_class (dpy, child_list[j]);
+	    cw->geometry_cookie = xcb_get_geometry (dpy, child_list[j]);
+	    cw->trans_coords_cookie = xcb_translate_coordinates
+		(dpy, child_list[j], node->tree->root, 0, 0);
+	    if (recurse)
+		cw->tree_cookie = xcb_query_tree (dpy, child_list[j]);
+	}
+	next_num += n;
+    }
+    xcb_flush (dpy);
+
+    if (!recurse || next_num == 0)
+	return;
+
+    next_level = calloc (next_num, sizeof (struct tree_node *));
+    if (next_level == NULL)
+	Fatal_Error ("Failed to allocate memory in fetch_tree_nodes");
+
+    n = 0;
+    for (i = 0; i < num; i++)
+	for (j = 0; j < level[i]->num_children; j++)
+	    next_level[n++] = &level[i]->children[j];
+
+    fetch_tree_nodes (next_level, next_num, recurse);
+    free (next_level);
 }
 
 /*
  * level - recursion level
  */
 static void
-display_tree_info_1 (struct wininfo *w, int recurse, int level)
+display_tree_info_1 (struct tree_node *node, int recurse, int level)
 {
     int i, j;
     unsigned int num_children;
-    xcb_query_tree_reply_t *tree;
-
-    tree = xcb_query_tree_reply (dpy, w->tree_cookie, &err);
-    if (!tree) {
-	Print_X_Error (dpy, err);
-	Fatal_Error ("Can't query window tree.");
-    }
+    xcb_query_tree_reply_t *tree = node->tree;
 
     if (level == 0) {
 	struct wininfo rw, pw;
@@ -1318,7 +1401,7 @@ display_tree_info_1 (struct wininfo *w, int recurse, int level)
 	Display_Window_Id (&pw, True);
     }
 
-    num_children = xcb_query_tree_children_length (tree);
+    num_children = node->num_children;
 
     if (level == 0  ||  num_children > 0) {
 	printf ("     ");
@@ -1328,30 +1411,9 @@ display_tree_info_1 (struct wininfo *w, int recurse, int level)
     }
 
     if (num_children > 0) {
-	xcb_window_t *child_list = xcb_query_tree_children (tree);
-	struct wininfo *children
-	    = calloc (num_children, sizeof(struct wininfo));
-
-	if (children == NULL)
-	    Fatal_Error ("Failed to allocate memory in display_tree_info");
-
-	for (i = (int)num_children - 1; i >= 0; i--) {
-	    struct wininfo *cw = &children[i];
-
-	    cw->window = child_list[i];
-	    cw->net_wm_name_cookie = get_net_wm_name (dpy, child_list[i]);
-	    cw->wm_name_cookie = xcb_icccm_get_wm_name (dpy, child_list[i]);
-	    cw->wm_class_cookie = xcb_icccm_get_wm_class (dpy, child_list[i]);
-	    cw->geometry_cookie = xcb_get_geometry (dpy, child_list[i]);
-	    cw->trans_coords_cookie = xcb_translate_coordinates
-		(dpy, child_list[i], tree->root, 0, 0);
-	    if (recurse)
-		cw->tree_cookie = xcb_query_tree (dpy, child_list[i]);
-	}
-	xcb_flush (dpy);
-
 	for (i = (int)num_children - 1; i >= 0; i--) {
-	    struct wininfo *cw = &children[i];
+	    struct tree_node *cn = &node->children[i];
+	    struct wininfo *cw = &cn->info;
 	    Bool got_wm_class = False;
 	    char *instance_name = NULL, *class_name = NULL;
 	    int instance_name_len, class_name_len;
@@ -1446,14 +1508,16 @@ display_tree_info_1 (struct wininfo *w, int recurse, int level)
 	    printf ("\n");
 
 	    if (recurse)
-		display_tree_info_1 (cw, 1, level+1);
+		display_tree_info_1 (cn, 1, level+1);
 
 	    wininfo_wipe (cw);
 	}
-	free (children);
+	free (node->children);
+	node->children = NULL;
     }
 
     free (tree); /* includes storage for child_list[] */
+    node->tree = NULL;
 }
 
 
@@ -78,6 +78,7 @@ extern Bool bdfSpecialProperty ( FontPtr pFont, FontPropPtr prop,
 extern int bdfReadFont( FontPtr pFont, FontFilePtr file,
 			int bit, int byte, int glyph, int scan );
 extern int bdfReadFontInfo( FontInfoPtr pFontInfo, FontFilePtr file );
+extern void bdfFreeFontBits ( FontPtr pFont );
 
 extern void FontCharInkMetrics ( FontPtr pFont, CharInfoPtr pCI,
 				 xCharInfo *pInk );
@@ -224,7 +224,7 @@ bdfSkipBitmap(FontFilePtr file, int height)
 
 /***====================================================================***/
 
-static void
+void
 bdfFreeFontBits(FontPtr pFont)
 {
     BitmapFontPtr  bitmapFont;
@@ -48,21 +48,117 @@ from The Open Group.
 #define STDOUT_FILENO 1
 #endif
 
-int
-main(int argc, char *argv[])
+static char *program_name;
+
+/*
+ * Convert one BDF file (or stdin) to one PCF file (or stdout).
+ */
+static int
+convert_file(const char *input_name, const char *output_name,
+             int bit, int byte, int glyph, int scan)
 {
     FontRec font = { 0 };
 
     FontFilePtr input, output;
 
-    char *input_name = NULL, *output_name = NULL;
+    if (input_name) {
+        input = FontFileOpen(input_name);
+        if (!input) {
+            fprintf(stderr, "%s: can't open bdf source file %s\n",
+                    program_name, input_name);
+            return 1;
+        }
+    }
+    else
+        input = FontFileOpenFd(STDIN_FILENO);
+    if (bdfReadFont(&font, input, bit, byte, glyph, scan) != Successful) {
+        fprintf(stderr, "%s: bdf input, %s, corrupt\n",
+                program_name, input_name ? input_name : "<stdin>");
+        FontFileClose(input);
+        return 1;
+    }
+    FontFileClose(input);
+    if (output_name) {
+        output = FontFileOpenWrite(output_name);
+        if (!output) {
+            fprintf(stderr, "%s: can't open pcf sink file %s\n",
+                    program_name, output_name);
+            bdfFreeFontBits(&font);
+            return 1;
+        }
+    }
+    else
+        output = FontFileOpenWriteFd(STDOUT_FILENO);
+    if (pcfWriteFont(&font, output) != Successful) {
+        fprintf(stderr, "%s: can't write pcf file %s\n",
+                program_name, output_name ? output_name : "<stdout>");
+        if (output_name)
+            remove(output_name);
+        bdfFreeFontBits(&font);
+        return 1;
+    }
+    FontFileClose(output);
+    bdfFreeFontBits(&font);
+    return 0;
+}
+
+/*
+ * Build the output name for one input of a batch: the input's base
+ * name with any ".bdf" suffix replaced by ".pcf", placed in output_dir
+ * when one was given and next to the input otherwise.
+ */
+static char *
+make_output_name(const char *input_name, const char *output_dir)
+{
+    const char *base = input_name, *p;
+    size_t len, dirlen;
+    char *name;
+
+    if (output_dir) {
+        for (p = input_name; *p; p++)
+            if (*p == '/' || *p == '\\')
+                base = p + 1;
+    }
+    len = strlen(base);
+    if (len > 4) {
+        p = base + len - 4;
+        if (p[0] == '.' &&
+            (p[1] == 'b' || p[1] == 'B') &&
+            (p[2] == 'd' || p[2] == 'D') &&
+            (p[3] == 'f' || p[3] == 'F'))
+            len -= 4;
+    }
+    dirlen = output_dir ? strlen(output_dir) + 1 : 0;
+    name = malloc(dirlen + len + 5);
+    if (!name) {
+        fprintf(stderr, "%s: out of memory\n", program_name);
+        return NULL;
+    }
+    if (output_dir)
+        sprintf(name, "%s/", output_dir);
+    memcpy(name + dirlen, base, len);
+    strcpy(name + dirlen + len, ".pcf");
+    return name;
+}
+
+int
+main(int argc, char *argv[])
+{
+    char **input_names, *output_name = NULL;
 
-    char *program_name;
+    int ninputs = 0;
 
     int bit, byte, glyph, scan;
 
+    int i, status;
+
     FontDefaultFormat(&bit, &byte, &glyph, &scan);
     program_name = argv[0];
+    input_names = malloc((argc + 1) * sizeof(char *));
+    if (!input_names) {
+        fprintf(stderr, "%s: out of memory\n", program_name);
+        exit(1);
+    }
     argc--, argv++;
     while (argc-- > 0) {
         if (argv[0][0] == '-') {
@@ -150,54 +246,42 @@ main(int argc, char *argv[])
             }
         }
         else {
-            if (input_name) {
- usage:
-                fprintf(stderr, "%s: invalid option '%s'\n",
-                        program_name, argv[0]);
-                fprintf(stderr,
-                        "usage: %s [-p#] [-u#] [-m] [-l] [-M] [-L] [-t] [-i] [-o pcf file] [bdf file]\n"
-                        "       where # for -p is 1, 2, 4, or 8\n"
-                        "       and   # for -u is 1, 2, or 4\n",
-                        program_name);
-                exit(1);
-            }
-            input_name = argv[0];
+            input_names[ninputs++] = argv[0];
         }
         argv++;
-    }
-    if (input_name) {
-        input = FontFileOpen(input_name);
-        if (!input) {
-            fprintf(stderr, "%s: can't open bdf source file %s\n",
-                    program_name, input_name);
-            exit(1);
-        }
-    }
-    else
-        input = FontFileOpenFd(STDIN_FILENO);
-    if (bdfReadFont(&font, input, bit, byte, glyph, scan) != Successful) {
-        fprintf(stderr, "%s: bdf input, %s, corrupt\n",
-                program_name, input_name ? input_name : "<stdin>");
+        continue;
+ usage:
+        fprintf(stderr, "%s: invalid option '%s'\n",
+                program_name, argv[0]);
+        fprintf(stderr,
+                "usage: %s [-p#] [-u#] [-m] [-l] [-M] [-L] [-t] [-i] [-o pcf file] [bdf files ...]\n"
+                "       where # for -p is 1, 2, 4, or 8\n"
+                "       and   # for -u is 1, 2, or 4\n"
+                "       with several bdf files, -o names a directory and each\n"
+                "       output is the input's base name with a .pcf suffix\n",
+                program_name);
         exit(1);
     }
-    if (output_name) {
-        output = FontFileOpenWrite(output_name);
-        if (!output) {
-            fprintf(stderr, "%s: can't open pcf sink file %s\n",
-                    program_name, output_name);
-            exit(1);
+    /*
+     * With a single input (or stdin) -o names the output file, as it
+     * always has.  With several inputs each output name is derived
+     * from its input, and the whole batch runs in this one process,
+     * which is where the time goes when converting a few thousand
+     * fonts one exec at a time.
+     */
+    if (ninputs > 1) {
+        status = 0;
+        for (i = 0; i < ninputs; i++) {
+            char *name = make_output_name(input_names[i], output_name);
+
+            if (!name)
+                exit(1);
+            status |= convert_file(input_names[i], name,
+                                   bit, byte, glyph, scan);
+            free(name);
         }
+        return status;
     }
-    else
-        output = FontFileOpenWriteFd(STDOUT_FILENO);
-    if (pcfWriteFont(&font, output) != Successful) {
-        fprintf(stderr, "%s: can't write pcf file %s\n",
-                program_name, output_name ? output_name : "<stdout>");
-        if (output_name)
-            remove(output_name);
-        exit(1);
-    }
-    else
-        FontFileClose(output);
-    return (0);
+    return convert_file(ninputs ? input_names[0] : NULL, output_name,
+                        bit, byte, glyph, scan);
 }
@@ -35,6 +35,13 @@ in this Software without prior written authorization from The Open Group.
 
 /* Utility functions for reformating font bitmaps */
 
+/* The reformatting transforms touch every byte of every glyph, so do
+ * the bulk of the work a machine word at a time; the scalar loops
+ * handle unaligned leading and trailing bytes.
+ */
+#define WORDBYTES	(sizeof(unsigned long))
+#define WORDONES	((unsigned long)-1 / 0xFF)
+
 static const unsigned char _reverse_byte[0x100] = {
 	0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0,
 	0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0,
@@ -78,6 +85,17 @@ BitOrderInvert(unsigned char *buf, int nbytes)
 {
     const unsigned char *rev = _reverse_byte;
 
+    for (; nbytes > 0 && ((size_t) buf & (WORDBYTES - 1)); nbytes--, buf++)
+	*buf = rev[*buf];
+    for (; nbytes >= (int) WORDBYTES; nbytes -= WORDBYTES, buf += WORDBYTES)
+    {
+	unsigned long v = *(unsigned long *) buf;
+
+	v = ((v >> 1) & (WORDONES * 0x55)) | ((v & (WORDONES * 0x55)) << 1);
+	v = ((v >> 2) & (WORDONES * 0x33)) | ((v & (WORDONES * 0x33)) << 2);
+	v = ((v >> 4) & (WORDONES * 0x0f)) | ((v & (WORDONES * 0x0f)) << 4);
+	*(unsigned long *) buf = v;
+    }
     for (; --nbytes >= 0; buf++)
 	*buf = rev[*buf];
 }
@@ -90,6 +108,23 @@ TwoByteSwap(unsigned char *buf, int nbytes)
 {
     unsigned char c;
 
+    if (!((size_t) buf & 1))
+    {
+	for (; nbytes > 1 && ((size_t) buf & (WORDBYTES - 1));
+	     nbytes -= 2, buf += 2)
+	{
+	    c = buf[0];
+	    buf[0] = buf[1];
+	    buf[1] = c;
+	}
+	for (; nbytes >= (int) WORDBYTES; nbytes -= WORDBYTES, buf += WORDBYTES)
+	{
+	    unsigned long v = *(unsigned long *) buf;
+	    unsigned long m = (unsigned long)-1 / 0xFFFF * 0xFF;
+
+	    *(unsigned long *) buf = ((v & m) << 8) | ((v >> 8) & m);
+	}
+    }
     for (; nbytes > 0; nbytes -= 2, buf += 2)
     {
 	c = buf[0];
@@ -106,6 +141,28 @@ FourByteSwap(unsigned char *buf, int nbytes)
 {
     unsigned char c;
 
+    if (!((size_t) buf & 3))
+    {
+	for (; nbytes > 3 && ((size_t) buf & (WORDBYTES - 1));
+	     nbytes -= 4, buf += 4)
+	{
+	    c = buf[0];
+	    buf[0] = buf[3];
+	    buf[3] = c;
+	    c = buf[1];
+	    buf[1] = buf[2];
+	    buf[2] = c;
+	}
+	for (; nbytes >= (int) WORDBYTES; nbytes -= WORDBYTES, buf += WORDBYTES)
+	{
+	    unsigned long v = *(unsigned long *) buf;
+	    unsigned long a = (unsigned long)-1 / 0xFFFFFFFF * 0xFF;
+	    unsigned long b = a << 8;
+
+	    *(unsigned long *) buf = ((v & a) << 24) | ((v & b) << 8) |
+				     ((v >> 8) & b) | ((v >> 24) & a);
+	}
+    }
     for (; nbytes > 0; nbytes -= 4, buf += 4)
     {
 	c = buf[0];
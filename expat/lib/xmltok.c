@@ -296,11 +296,63 @@ sb_charMatches(const ENCODING *enc, const char *p, int c)
 #define CHAR_MATCHES(enc, p, c) (*(p) == c)
 #endif
 
+static void PTRCALL unknown_toUtf8(const ENCODING *enc,
+                                   const char **fromP, const char *fromLim,
+                                   char **toP, const char *toLim);
+
+/* Looking up every byte of character data in the type table dominates
+   the tokenizing cost of text-heavy documents.  The content scanner
+   only needs to stop on '<', '&', ']', CR, LF, non-XML control
+   characters and bytes with the high bit set; in the built-in
+   single-byte type tables everything else is plain character data, so
+   runs of it can be skipped a word at a time.  Unknown encodings may
+   assign lead or malformed byte types to printable ASCII positions and
+   must keep using the byte loop.
+*/
+
+#define SDC_ONES ((unsigned long)-1 / 0xFF)
+#define SDC_HIGH_BITS (SDC_ONES * 0x80)
+/* nonzero if some byte of w is zero */
+#define SDC_HAS_ZERO(w) (((w) - SDC_ONES) & ~(w) & SDC_HIGH_BITS)
+/* nonzero if some byte of w equals the ASCII character c */
+#define SDC_HAS_CHAR(w, c) SDC_HAS_ZERO((w) ^ (SDC_ONES * (c)))
+/* nonzero if some byte of w is below 0x20 or has the high bit set */
+#define SDC_HAS_NON_PLAIN(w) \
+  (((w) | (((w) - SDC_ONES * 0x20) & ~(w))) & SDC_HIGH_BITS)
+
+static const char *PTRFASTCALL
+sb_skipDataChars(const ENCODING *enc, const char *ptr, const char *end)
+{
+  if (enc->utf8Convert == unknown_toUtf8)
+    return ptr;
+  while (((size_t)ptr & (sizeof(unsigned long) - 1)) && ptr != end) {
+    unsigned char c = (unsigned char)*ptr;
+    if (c < 0x20 || c >= 0x80
+        || c == ASCII_LT || c == ASCII_AMP || c == ASCII_RSQB)
+      return ptr;
+    ptr++;
+  }
+  while (end - ptr >= (ptrdiff_t)sizeof(unsigned long)) {
+    unsigned long w = *(const unsigned long *)ptr;
+    if (SDC_HAS_NON_PLAIN(w)
+        || SDC_HAS_CHAR(w, ASCII_LT)
+        || SDC_HAS_CHAR(w, ASCII_AMP)
+        || SDC_HAS_CHAR(w, ASCII_RSQB))
+      break;
+    ptr += sizeof(unsigned long);
+  }
+  return ptr;
+}
+
+#define SCAN_DATA_CHARS(enc, ptr, end) \
+  ((ptr) = sb_skipDataChars(enc, ptr, end))
+
 #define PREFIX(ident) normal_ ## ident
 #define XML_TOK_IMPL_C
 #include "xmltok_impl.c"
 #undef XML_TOK_IMPL_C
 
+#undef SCAN_DATA_CHARS
 #undef MINBPC
 #undef BYTE_TYPE
 #undef BYTE_TO_ASCII
@@ -349,6 +349,11 @@ PREFIX(cdataSectionTok)(const ENCODING *enc, const char *ptr,
     break;
   }
   while (ptr != end) {
+#ifdef SCAN_DATA_CHARS
+    SCAN_DATA_CHARS(enc, ptr, end);
+    if (ptr == end)
+      break;
+#endif
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: \
@@ -833,6 +838,11 @@ PREFIX(contentTok)(const ENCODING *enc, const char *ptr, const char *end,
     break;
   }
   while (ptr != end) {
+#ifdef SCAN_DATA_CHARS
+    SCAN_DATA_CHARS(enc, ptr, end);
+    if (ptr == end)
+      break;
+#endif
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: \
@@ -495,28 +495,178 @@ FcConfigAddCache (FcConfig *config, FcCache *cache,
     return FcTrue;
 }
 
+/*
+ * Reading one directory cache is dominated by the stat/open/mmap of the
+ * cache file (or a full directory scan when the cache is stale), so
+ * with many font directories — network shares in particular — the
+ * serial loop in FcConfigAddDirList pays one cold round trip per
+ * directory.  Map the caches for a batch of directories concurrently
+ * and add them to the configuration serially afterwards;
+ * FcDirCacheRead only touches per-directory files and the
+ * mutex-protected cache hash, so concurrent reads of distinct
+ * directories are safe.  Builds without thread support keep reading
+ * each cache in line.
+ */
+
+#if !defined (FC_NO_MT) && (defined (_MSC_VER) || defined (__MINGW32__))
+#include "fcwindows.h"
+#include <process.h>
+#define FC_CACHE_PRELOAD_THREADS 4
+#elif !defined (FC_NO_MT) && defined (HAVE_PTHREAD)
+#include <pthread.h>
+#define FC_CACHE_PRELOAD_THREADS 4
+#endif
+
+#ifdef FC_CACHE_PRELOAD_THREADS
+
+typedef struct _FcCachePreload {
+    FcConfig	*config;
+    FcStrSet	*dirSet;
+    FcCache	**caches;
+    int		first;
+    int		last;
+    FcMutex	lock;
+    int		next;
+} FcCachePreload;
+
+static void
+FcCachePreloadWork (FcCachePreload *preload)
+{
+    for (;;)
+    {
+	int i;
+
+	FcMutexLock (&preload->lock);
+	i = preload->next++;
+	FcMutexUnlock (&preload->lock);
+	if (i >= preload->last)
+	    break;
+	preload->caches[i - preload->first] =
+	    FcDirCacheRead (preload->dirSet->strs[i], FcFalse,
+			    preload->config);
+    }
+}
+
+#if defined (_MSC_VER) || defined (__MINGW32__)
+static unsigned int __stdcall
+FcCachePreloadThread (void *arg)
+{
+    FcCachePreloadWork ((FcCachePreload *) arg);
+    return 0;
+}
+#else
+static void *
+FcCachePreloadThread (void *arg)
+{
+    FcCachePreloadWork ((FcCachePreload *) arg);
+    return NULL;
+}
+#endif
+
+static void
+FcCachePreloadRun (FcConfig *config, FcStrSet *dirSet,
+		   FcCache **caches, int first, int last)
+{
+#if defined (_MSC_VER) || defined (__MINGW32__)
+    HANDLE	    threads[FC_CACHE_PRELOAD_THREADS - 1];
+#else
+    pthread_t	    threads[FC_CACHE_PRELOAD_THREADS - 1];
+#endif
+    FcCachePreload  preload;
+    int		    nthreads = 0;
+    int		    i;
+
+    preload.config = config;
+    preload.dirSet = dirSet;
+    preload.caches = caches;
+    preload.first = first;
+    preload.last = last;
+    preload.next = first;
+    FcMutexInit (&preload.lock);
+
+    /* the calling thread works too, so one thread fewer than dirs */
+    while (nthreads < FC_CACHE_PRELOAD_THREADS - 1 &&
+	   nthreads < last - first - 1)
+    {
+#if defined (_MSC_VER) || defined (__MINGW32__)
+	threads[nthreads] = (HANDLE) _beginthreadex (NULL, 0,
+						     FcCachePreloadThread,
+						     &preload, 0, NULL);
+	if (!threads[nthreads])
+	    break;
+#else
+	if (pthread_create (&threads[nthreads], NULL,
+			    FcCachePreloadThread, &preload) != 0)
+	    break;
+#endif
+	nthreads++;
+    }
+
+    FcCachePreloadWork (&preload);
+
+    for (i = 0; i < nthreads; i++)
+    {
+#if defined (_MSC_VER) || defined (__MINGW32__)
+	WaitForSingleObject (threads[i], INFINITE);
+	CloseHandle (threads[i]);
+#else
+	pthread_join (threads[i], NULL);
+#endif
+    }
+    FcMutexFinish (&preload.lock);
+}
+
+#endif /* FC_CACHE_PRELOAD_THREADS */
+
 static FcBool
 FcConfigAddDirList (FcConfig *config, FcSetName set, FcStrSet *dirSet)
 {
-    FcStrList	    *dirlist;
     FcChar8	    *dir;
     FcCache	    *cache;
+    int		    consumed = 0;
 
-    dirlist = FcStrListCreate (dirSet);
-    if (!dirlist)
-        return FcFalse;
-	
-    while ((dir = FcStrListNext (dirlist)))
+    /*
+     * FcConfigAddCache appends the subdirectories recorded in each
+     * cache to dirSet, so the set is processed in waves: read the
+     * caches for every directory not yet consumed, add them (which may
+     * grow the set), then repeat for the newly discovered tail.
+     */
+    while (consumed < dirSet->num)
     {
-	if (FcDebug () & FC_DBG_FONTSET)
-	    printf ("adding fonts from %s\n", dir);
-	cache = FcDirCacheRead (dir, FcFalse, config);
-	if (!cache)
-	    continue;
-	FcConfigAddCache (config, cache, set, dirSet, dir);
-	FcDirCacheUnload (cache);
+	int	first = consumed;
+	int	last = dirSet->num;
+	int	i;
+#ifdef FC_CACHE_PRELOAD_THREADS
+	FcCache	**caches = NULL;
+
+	if (last - first > 1)
+	{
+	    caches = malloc ((last - first) * sizeof (FcCache *));
+	    if (caches)
+		FcCachePreloadRun (config, dirSet, caches, first, last);
+	}
+#endif
+	for (i = first; i < last; i++)
+	{
+	    dir = dirSet->strs[i];
+	    if (FcDebug () & FC_DBG_FONTSET)
+		printf ("adding fonts from %s\n", dir);
+#ifdef FC_CACHE_PRELOAD_THREADS
+	    if (caches)
+		cache = caches[i - first];
+	    else
+#endif
+		cache = FcDirCacheRead (dir, FcFalse, config);
+	    if (!cache)
+		continue;
+	    FcConfigAddCache (config, cache, set, dirSet, dir);
+	    FcDirCacheUnload (cache);
+	}
+#ifdef FC_CACHE_PRELOAD_THREADS
+	free (caches);
+#endif
+	consumed = last;
     }
-    FcStrListDone (dirlist);
     return FcTrue;
 }
 
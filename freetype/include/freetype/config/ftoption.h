@@ -377,6 +377,23 @@ FT_BEGIN_HEADER
 #define FT_CONFIG_OPTION_INCREMENTAL
 
 
+  /*************************************************************************/
+  /*                                                                       */
+  /* Shared-memory glyph render cache                                      */
+  /*                                                                       */
+  /*   If this macro is defined, `FT_Render_Glyph' consults a small        */
+  /*   system-wide shared-memory cache of rendered bitmaps before          */
+  /*   running the rasterizer, and publishes fresh results into it.        */
+  /*   This lets many processes rendering the same fonts at the same       */
+  /*   sizes (e.g. concurrent sessions on a terminal server) share one     */
+  /*   rasterization instead of each redoing it.  Currently implemented    */
+  /*   for Windows only, using a named file mapping.                       */
+  /*                                                                       */
+#ifdef _WIN32
+#define FT_CONFIG_OPTION_SHM_GLYPH_CACHE
+#endif
+
+
   /*************************************************************************/
   /*                                                                       */
   /* The size in bytes of the render pool used by the scan-line converter  */
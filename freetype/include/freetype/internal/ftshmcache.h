@@ -0,0 +1,64 @@
+/***************************************************************************/
+/*                                                                         */
+/*  ftshmcache.h                                                           */
+/*                                                                         */
+/*    Shared-memory glyph render cache (specification).                    */
+/*                                                                         */
+/*  This file is part of the FreeType project, and may only be used,       */
+/*  modified, and distributed under the terms of the FreeType project      */
+/*  license, LICENSE.TXT.  By continuing to use, modify, or distribute     */
+/*  this file you indicate that you have read the license and              */
+/*  understand and accept it fully.                                        */
+/*                                                                         */
+/***************************************************************************/
+
+
+#ifndef FTSHMCACHE_H_
+#define FTSHMCACHE_H_
+
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+
+FT_BEGIN_HEADER
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* A small system-wide cache of rendered glyph bitmaps kept in a named   */
+  /* shared-memory section, so that concurrent processes rasterizing the   */
+  /* same outlines at the same size share one copy of the scan-converted   */
+  /* result instead of each running the rasterizer themselves.             */
+  /*                                                                       */
+  /* Entries are keyed by a hash of the loaded (and hinted) outline data   */
+  /* together with the render mode; the outline bytes subsume the face,    */
+  /* pixel size, glyph index, transformation, and variation coordinates,   */
+  /* since identical outlines rasterize to identical bitmaps.  Entries     */
+  /* are written once and never evicted or modified, which lets readers    */
+  /* probe the section without taking any lock.                            */
+  /*                                                                       */
+
+  /* Probe the cache for the bitmap of `slot->outline' rendered in        */
+  /* `render_mode'.  On a hit the slot's bitmap is filled in and TRUE is  */
+  /* returned.  On a miss `key' receives the outline hash for a later     */
+  /* `ft_shm_cache_store'; a key of { 0, 0 } means the glyph is not       */
+  /* cacheable.                                                           */
+  FT_BASE( FT_Bool )
+  ft_shm_cache_lookup( FT_GlyphSlot    slot,
+                       FT_Render_Mode  render_mode,
+                       FT_UInt32*      key );
+
+  /* Publish the freshly rendered bitmap in `slot' under `key', as       */
+  /* returned by a preceding `ft_shm_cache_lookup' miss.  Silently does  */
+  /* nothing if the key is { 0, 0 }, the bitmap is unsuitable, or the    */
+  /* shared section is full.                                             */
+  FT_BASE( void )
+  ft_shm_cache_store( FT_GlyphSlot      slot,
+                      const FT_UInt32*  key );
+
+FT_END_HEADER
+
+#endif /* FTSHMCACHE_H_ */
+
+
+/* END */
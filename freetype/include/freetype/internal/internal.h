@@ -38,6 +38,7 @@
 #define FT_INTERNAL_SERVICE_H             <freetype/internal/ftserv.h>
 #define FT_INTERNAL_RFORK_H               <freetype/internal/ftrfork.h>
 #define FT_INTERNAL_VALIDATE_H            <freetype/internal/ftvalid.h>
+#define FT_INTERNAL_SHM_CACHE_H           <freetype/internal/ftshmcache.h>
 
 #define FT_INTERNAL_TRUETYPE_TYPES_H      <freetype/internal/tttypes.h>
 #define FT_INTERNAL_TYPE1_TYPES_H         <freetype/internal/t1types.h>
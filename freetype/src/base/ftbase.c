@@ -33,6 +33,7 @@
 #include "ftpic.c"
 #include "ftpsprop.c"
 #include "ftrfork.c"
+#include "ftshmcache.c"
 #include "ftsnames.c"
 #include "ftstream.c"
 #include "fttrigon.c"
@@ -29,6 +29,10 @@
 #include FT_INTERNAL_SFNT_H            /* for SFNT_Load_Table_Func */
 #include FT_INTERNAL_POSTSCRIPT_AUX_H  /* for PS_Driver            */
 
+#ifdef FT_CONFIG_OPTION_SHM_GLYPH_CACHE
+#include FT_INTERNAL_SHM_CACHE_H
+#endif
+
 #include FT_TRUETYPE_TABLES_H
 #include FT_TRUETYPE_TAGS_H
 #include FT_TRUETYPE_IDS_H
@@ -4500,6 +4504,16 @@
       {
         FT_ListNode  node = NULL;
 
+#ifdef FT_CONFIG_OPTION_SHM_GLYPH_CACHE
+        FT_UInt32    shm_key[2] = { 0, 0 };
+
+
+        /* identical outlines rasterize identically; reuse a bitmap */
+        /* another process (or an earlier call) already produced    */
+        if ( slot->format == FT_GLYPH_FORMAT_OUTLINE           &&
+             ft_shm_cache_lookup( slot, render_mode, shm_key ) )
+          break;
+#endif
 
         /* small shortcut for the very common case */
         if ( slot->format == FT_GLYPH_FORMAT_OUTLINE )
@@ -4526,6 +4540,11 @@
           /* format.                                               */
           renderer = FT_Lookup_Renderer( library, slot->format, &node );
         }
+
+#ifdef FT_CONFIG_OPTION_SHM_GLYPH_CACHE
+        if ( !error )
+          ft_shm_cache_store( slot, shm_key );
+#endif
       }
     }
 
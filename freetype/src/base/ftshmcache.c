@@ -0,0 +1,422 @@
+/***************************************************************************/
+/*                                                                         */
+/*  ftshmcache.c                                                           */
+/*                                                                         */
+/*    Shared-memory glyph render cache (body).                             */
+/*                                                                         */
+/*  This file is part of the FreeType project, and may only be used,       */
+/*  modified, and distributed under the terms of the FreeType project      */
+/*  license, LICENSE.TXT.  By continuing to use, modify, or distribute     */
+/*  this file you indicate that you have read the license and              */
+/*  understand and accept it fully.                                        */
+/*                                                                         */
+/***************************************************************************/
+
+
+#include <ft2build.h>
+#include FT_INTERNAL_DEBUG_H
+#include FT_INTERNAL_OBJECTS_H
+#include FT_INTERNAL_SHM_CACHE_H
+
+
+#if defined( FT_CONFIG_OPTION_SHM_GLYPH_CACHE ) && defined( _WIN32 )
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+
+  /*************************************************************************/
+  /*                                                                       */
+  /* The components of the `FT_COMPONENT' macro used in calls to the       */
+  /* `FT_TRACE' macro.                                                     */
+  /*                                                                       */
+#undef  FT_COMPONENT
+#define FT_COMPONENT  trace_raster
+
+
+  /* Layout of the shared section:                                       */
+  /*                                                                     */
+  /*   header | entry table (power of two) | bitmap data arena           */
+  /*                                                                     */
+  /* The creating process initializes the header and publishes it by     */
+  /* writing the magic last; until then other processes treat the cache  */
+  /* as unavailable.  Entries go from EMPTY to BUSY (claimed by exactly  */
+  /* one writer through an interlocked exchange) to READY, and stay      */
+  /* READY for the lifetime of the section -- there is no eviction, so   */
+  /* readers never need a lock.  The data arena is a bump allocator;     */
+  /* when it runs out, stores become no-ops and the section degrades to  */
+  /* a read-only view of what is already there.                          */
+
+#define FT_SHM_CACHE_MAGIC       0x46545243UL   /* `FTRC' */
+#define FT_SHM_CACHE_VERSION     1
+#define FT_SHM_CACHE_ENTRIES     4096           /* power of two */
+#define FT_SHM_CACHE_DATA_SIZE   ( 4096UL * 1024 )
+#define FT_SHM_CACHE_MAX_PROBES  8
+#define FT_SHM_CACHE_MAX_BITMAP  ( 32UL * 1024 )
+
+#define FT_SHM_ENTRY_EMPTY  0
+#define FT_SHM_ENTRY_BUSY   1
+#define FT_SHM_ENTRY_READY  2
+
+
+  typedef struct  FT_ShmCacheHeaderRec_
+  {
+    volatile LONG  magic;        /* FT_SHM_CACHE_MAGIC once initialized */
+    FT_UInt32      version;
+    FT_UInt32      num_entries;
+    FT_UInt32      data_size;
+    volatile LONG  data_used;
+
+  } FT_ShmCacheHeaderRec;
+
+
+  typedef struct  FT_ShmCacheEntryRec_
+  {
+    volatile LONG  state;
+    FT_UInt32      hash0;
+    FT_UInt32      hash1;
+    FT_UInt32      data_offset;
+
+    FT_UInt32      rows;
+    FT_UInt32      width;
+    FT_Int32       pitch;
+    FT_Int32       left;
+    FT_Int32       top;
+    FT_UInt32      pixel_mode;
+    FT_UInt32      num_grays;
+
+  } FT_ShmCacheEntryRec;
+
+
+  static volatile LONG          ft_shm_cache_init_state = 0;
+  static FT_ShmCacheHeaderRec*  ft_shm_cache_header     = NULL;
+
+
+  static FT_ShmCacheHeaderRec*
+  ft_shm_cache_map( void )
+  {
+    FT_ShmCacheHeaderRec*  header;
+    HANDLE                 mapping;
+    DWORD                  size;
+    BOOL                   creator;
+
+
+    /* states: 0 untouched, 1 someone is mapping, 2 mapped, 3 failed */
+    for (;;)
+    {
+      LONG  state = InterlockedCompareExchange( &ft_shm_cache_init_state,
+                                                1, 0 );
+
+      if ( state == 0 )
+        break;                          /* we do the mapping below */
+      if ( state == 2 )
+        goto Check_Magic;
+      if ( state == 3 )
+        return NULL;
+
+      Sleep( 0 );                       /* another thread is mapping */
+    }
+
+    size = (DWORD)( sizeof ( FT_ShmCacheHeaderRec )                       +
+                    FT_SHM_CACHE_ENTRIES * sizeof ( FT_ShmCacheEntryRec ) +
+                    FT_SHM_CACHE_DATA_SIZE );
+
+    mapping = CreateFileMappingW( INVALID_HANDLE_VALUE, NULL,
+                                  PAGE_READWRITE, 0, size,
+                                  L"Local\\FreeTypeGlyphRenderCache-v1" );
+    if ( !mapping )
+    {
+      InterlockedExchange( &ft_shm_cache_init_state, 3 );
+      return NULL;
+    }
+
+    creator = ( GetLastError() != ERROR_ALREADY_EXISTS );
+
+    ft_shm_cache_header =
+      (FT_ShmCacheHeaderRec*)MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS,
+                                            0, 0, 0 );
+    if ( !ft_shm_cache_header )
+    {
+      CloseHandle( mapping );
+      InterlockedExchange( &ft_shm_cache_init_state, 3 );
+      return NULL;
+    }
+
+    /* the mapping handle is kept open for the lifetime of the process */
+    /* so that the section survives even if all views are unmapped     */
+
+    if ( creator )
+    {
+      ft_shm_cache_header->version     = FT_SHM_CACHE_VERSION;
+      ft_shm_cache_header->num_entries = FT_SHM_CACHE_ENTRIES;
+      ft_shm_cache_header->data_size   = FT_SHM_CACHE_DATA_SIZE;
+      ft_shm_cache_header->data_used   = 0;
+
+      /* the section is zero-filled, so all entries start out EMPTY; */
+      /* publish the header last                                     */
+      InterlockedExchange( &ft_shm_cache_header->magic,
+                           (LONG)FT_SHM_CACHE_MAGIC );
+    }
+
+    InterlockedExchange( &ft_shm_cache_init_state, 2 );
+
+  Check_Magic:
+    header = ft_shm_cache_header;
+
+    /* a concurrently attaching process may see the section before the */
+    /* creator has published the header; treat it as a miss until then */
+    if ( !header ||
+         InterlockedCompareExchange( &header->magic, 0, 0 ) !=
+           (LONG)FT_SHM_CACHE_MAGIC                         )
+      return NULL;
+
+    if ( header->version     != FT_SHM_CACHE_VERSION ||
+         header->num_entries != FT_SHM_CACHE_ENTRIES )
+      return NULL;
+
+    return header;
+  }
+
+
+  static FT_ShmCacheEntryRec*
+  ft_shm_cache_entries( FT_ShmCacheHeaderRec*  header )
+  {
+    return (FT_ShmCacheEntryRec*)( header + 1 );
+  }
+
+
+  static FT_Byte*
+  ft_shm_cache_data( FT_ShmCacheHeaderRec*  header )
+  {
+    return (FT_Byte*)( ft_shm_cache_entries( header ) +
+                       header->num_entries            );
+  }
+
+
+  /* Two independent FNV-1a accumulators over the outline data and the   */
+  /* render mode; the pair is stored in full so that a table collision   */
+  /* cannot hand back the wrong bitmap.                                  */
+  static void
+  ft_shm_cache_hash( FT_Outline*     outline,
+                     FT_Render_Mode  render_mode,
+                     FT_UInt32*      key )
+  {
+    FT_UInt32  h0 = 0x811C9DC5UL;
+    FT_UInt32  h1 = 0x01000193UL;
+    FT_Byte*   p;
+    FT_Byte*   limit;
+    FT_Int     n;
+
+
+#define FT_SHM_HASH_BYTE( b )                  \
+          do                                   \
+          {                                    \
+            h0 = ( h0 ^ (b) ) * 0x01000193UL;  \
+            h1 = ( h1 ^ (b) ) * 0x85EBCA6BUL;  \
+                                               \
+          } while ( 0 )
+
+    FT_SHM_HASH_BYTE( (FT_Byte)render_mode );
+    FT_SHM_HASH_BYTE( (FT_Byte)outline->flags );
+    FT_SHM_HASH_BYTE( (FT_Byte)outline->n_contours );
+    FT_SHM_HASH_BYTE( (FT_Byte)( outline->n_contours >> 8 ) );
+    FT_SHM_HASH_BYTE( (FT_Byte)outline->n_points );
+    FT_SHM_HASH_BYTE( (FT_Byte)( outline->n_points >> 8 ) );
+
+    p     = (FT_Byte*)outline->points;
+    limit = p + (FT_UInt)outline->n_points * sizeof ( FT_Vector );
+    for ( ; p < limit; p++ )
+      FT_SHM_HASH_BYTE( *p );
+
+    for ( n = 0; n < outline->n_points; n++ )
+      FT_SHM_HASH_BYTE( (FT_Byte)outline->tags[n] );
+
+    for ( n = 0; n < outline->n_contours; n++ )
+    {
+      FT_SHM_HASH_BYTE( (FT_Byte)outline->contours[n] );
+      FT_SHM_HASH_BYTE( (FT_Byte)( outline->contours[n] >> 8 ) );
+    }
+
+#undef FT_SHM_HASH_BYTE
+
+    key[0] = h0;
+    key[1] = h1;
+
+    /* { 0, 0 } is reserved for `not cacheable' */
+    if ( key[0] == 0 && key[1] == 0 )
+      key[1] = 1;
+  }
+
+
+  /* documentation is in ftshmcache.h */
+
+  FT_BASE_DEF( FT_Bool )
+  ft_shm_cache_lookup( FT_GlyphSlot    slot,
+                       FT_Render_Mode  render_mode,
+                       FT_UInt32*      key )
+  {
+    FT_ShmCacheHeaderRec*  header;
+    FT_ShmCacheEntryRec*   entries;
+    FT_UInt32              mask;
+    FT_UInt                probe;
+
+
+    key[0] = 0;
+    key[1] = 0;
+
+    /* empty outlines render trivially; don't spend cache space on them */
+    if ( slot->outline.n_points <= 0 || !slot->outline.points )
+      return FALSE;
+
+    ft_shm_cache_hash( &slot->outline, render_mode, key );
+
+    header = ft_shm_cache_map();
+    if ( !header )
+      return FALSE;
+
+    entries = ft_shm_cache_entries( header );
+    mask    = header->num_entries - 1;
+
+    for ( probe = 0; probe < FT_SHM_CACHE_MAX_PROBES; probe++ )
+    {
+      FT_ShmCacheEntryRec*  entry = entries + ( ( key[0] + probe ) & mask );
+      LONG                  state;
+
+
+      state = InterlockedCompareExchange( &entry->state,
+                                          FT_SHM_ENTRY_READY,
+                                          FT_SHM_ENTRY_READY );
+      if ( state == FT_SHM_ENTRY_EMPTY )
+        return FALSE;
+
+      if ( state == FT_SHM_ENTRY_READY &&
+           entry->hash0 == key[0]      &&
+           entry->hash1 == key[1]      )
+      {
+        FT_ULong  size = (FT_ULong)entry->rows * (FT_ULong)entry->pitch;
+
+
+        if ( ft_glyphslot_alloc_bitmap( slot, size ) )
+          return FALSE;
+
+        FT_MEM_COPY( slot->bitmap.buffer,
+                     ft_shm_cache_data( header ) + entry->data_offset,
+                     size );
+
+        slot->bitmap.rows       = entry->rows;
+        slot->bitmap.width      = entry->width;
+        slot->bitmap.pitch      = entry->pitch;
+        slot->bitmap.pixel_mode = (unsigned char)entry->pixel_mode;
+        slot->bitmap.num_grays  = (unsigned short)entry->num_grays;
+
+        slot->bitmap_left = entry->left;
+        slot->bitmap_top  = entry->top;
+        slot->format      = FT_GLYPH_FORMAT_BITMAP;
+
+        FT_TRACE7(( "ft_shm_cache_lookup: hit, %ux%u mode %d\n",
+                    entry->width, entry->rows, render_mode ));
+        return TRUE;
+      }
+    }
+
+    return FALSE;
+  }
+
+
+  /* documentation is in ftshmcache.h */
+
+  FT_BASE_DEF( void )
+  ft_shm_cache_store( FT_GlyphSlot      slot,
+                      const FT_UInt32*  key )
+  {
+    FT_ShmCacheHeaderRec*  header;
+    FT_ShmCacheEntryRec*   entries;
+    FT_UInt32              mask;
+    FT_UInt                probe;
+    FT_ULong               size;
+
+
+    if ( key[0] == 0 && key[1] == 0 )
+      return;
+
+    if ( slot->format != FT_GLYPH_FORMAT_BITMAP ||
+         !slot->bitmap.buffer                   ||
+         slot->bitmap.pitch <= 0                ||
+         slot->bitmap.rows  == 0                )
+      return;
+
+    size = (FT_ULong)slot->bitmap.rows * (FT_ULong)slot->bitmap.pitch;
+    if ( size > FT_SHM_CACHE_MAX_BITMAP )
+      return;
+
+    header = ft_shm_cache_map();
+    if ( !header )
+      return;
+
+    entries = ft_shm_cache_entries( header );
+    mask    = header->num_entries - 1;
+
+    for ( probe = 0; probe < FT_SHM_CACHE_MAX_PROBES; probe++ )
+    {
+      FT_ShmCacheEntryRec*  entry = entries + ( ( key[0] + probe ) & mask );
+      LONG                  state;
+      LONG                  offset;
+
+
+      state = InterlockedCompareExchange( &entry->state,
+                                          FT_SHM_ENTRY_BUSY,
+                                          FT_SHM_ENTRY_EMPTY );
+      if ( state == FT_SHM_ENTRY_READY &&
+           entry->hash0 == key[0]      &&
+           entry->hash1 == key[1]      )
+        return;                             /* someone beat us to it */
+
+      if ( state != FT_SHM_ENTRY_EMPTY )
+        continue;                           /* claimed by another key */
+
+      /* we own this entry now; reserve arena space (8-byte aligned) */
+      offset = InterlockedExchangeAdd( &header->data_used,
+                                       (LONG)( ( size + 7 ) & ~7UL ) );
+      if ( (FT_ULong)offset + size > header->data_size )
+      {
+        /* arena exhausted; give the entry back and stop caching */
+        InterlockedExchange( &entry->state, FT_SHM_ENTRY_EMPTY );
+        return;
+      }
+
+      FT_MEM_COPY( ft_shm_cache_data( header ) + offset,
+                   slot->bitmap.buffer, size );
+
+      entry->hash0       = key[0];
+      entry->hash1       = key[1];
+      entry->data_offset = (FT_UInt32)offset;
+      entry->rows        = slot->bitmap.rows;
+      entry->width       = slot->bitmap.width;
+      entry->pitch       = slot->bitmap.pitch;
+      entry->left        = slot->bitmap_left;
+      entry->top         = slot->bitmap_top;
+      entry->pixel_mode  = slot->bitmap.pixel_mode;
+      entry->num_grays   = slot->bitmap.num_grays;
+
+      /* publish: the interlocked exchange is a full barrier, so the */
+      /* payload above is visible before the entry turns READY       */
+      InterlockedExchange( &entry->state, FT_SHM_ENTRY_READY );
+
+      FT_TRACE7(( "ft_shm_cache_store: %ux%u, %lu bytes at %ld\n",
+                  slot->bitmap.width, slot->bitmap.rows, size, offset ));
+      return;
+    }
+  }
+
+
+#else /* !( FT_CONFIG_OPTION_SHM_GLYPH_CACHE && _WIN32 ) */
+
+  /* ANSI C doesn't like empty source files */
+  typedef int  _ft_shm_cache_dummy;
+
+#endif /* !( FT_CONFIG_OPTION_SHM_GLYPH_CACHE && _WIN32 ) */
+
+
+/* END */
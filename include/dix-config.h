@@ -271,7 +271,7 @@
 #undef LOCALCONN
 
 /* Support MIT-SHM Extension */
-#undef MITSHM
+#define MITSHM 1
 
 /* Disable some debugging code */
 #define NDEBUG 1
@@ -36,6 +36,42 @@ from The Open Group.
 #define REHASHVAL(sig) ((((sig) % (TABLESIZE-3)) + 2) | 1)
 #define REHASH(idx,rehash) ((idx + rehash) & (TABLESIZE-1))
 
+/*
+ * Atoms 1 through XA_LAST_PREDEFINED have the same values and names on
+ * every server, fixed by the core protocol, so they can be entered into
+ * the cache without ever asking the server.  Table order matches
+ * <X11/Xatom.h>.
+ */
+static const char *const predefined[] = {
+    "PRIMARY", "SECONDARY", "ARC", "ATOM",
+    "BITMAP", "CARDINAL", "COLORMAP", "CURSOR",
+    "CUT_BUFFER0", "CUT_BUFFER1", "CUT_BUFFER2", "CUT_BUFFER3",
+    "CUT_BUFFER4", "CUT_BUFFER5", "CUT_BUFFER6", "CUT_BUFFER7",
+    "DRAWABLE", "FONT", "INTEGER", "PIXMAP",
+    "POINT", "RECTANGLE", "RESOURCE_MANAGER", "RGB_COLOR_MAP",
+    "RGB_BEST_MAP", "RGB_BLUE_MAP", "RGB_DEFAULT_MAP", "RGB_GRAY_MAP",
+    "RGB_GREEN_MAP", "RGB_RED_MAP", "STRING", "VISUALID",
+    "WINDOW", "WM_COMMAND", "WM_HINTS", "WM_CLIENT_MACHINE",
+    "WM_ICON_NAME", "WM_ICON_SIZE", "WM_NAME", "WM_NORMAL_HINTS",
+    "WM_SIZE_HINTS", "WM_ZOOM_HINTS", "MIN_SPACE", "NORM_SPACE",
+    "MAX_SPACE", "END_SPACE", "SUPERSCRIPT_X", "SUPERSCRIPT_Y",
+    "SUBSCRIPT_X", "SUBSCRIPT_Y", "UNDERLINE_POSITION", "UNDERLINE_THICKNESS",
+    "STRIKEOUT_ASCENT", "STRIKEOUT_DESCENT", "ITALIC_ANGLE", "X_HEIGHT",
+    "QUAD_WIDTH", "WEIGHT", "POINT_SIZE", "RESOLUTION",
+    "COPYRIGHT", "NOTICE", "FONT_NAME", "FAMILY_NAME",
+    "FULL_NAME", "CAP_HEIGHT", "WM_CLASS", "WM_TRANSIENT_FOR",
+};
+
+static void
+_XSeedAtomCache(Display *dpy)
+{
+    int i;
+
+    for (i = 0; i < (int) (sizeof(predefined) / sizeof(predefined[0])); i++)
+	_XUpdateAtomCache(dpy, predefined[i], (Atom) (i + 1),
+			  (unsigned long) 0, -1, 0);
+}
+
 void
 _XFreeAtomTable(Display *dpy)
 {
@@ -75,6 +111,8 @@ Atom _XInternAtom(
     if (!(atoms = dpy->atoms)) {
 	dpy->atoms = atoms = Xcalloc(1, sizeof(AtomTable));
 	dpy->free_funcs->atoms = _XFreeAtomTable;
+	if (atoms)
+	    _XSeedAtomCache(dpy);
     }
     sig = 0;
     for (s1 = (char *)name; (c = *s1++); )
@@ -130,6 +168,8 @@ _XUpdateAtomCache(
 	if (idx < 0) {
 	    dpy->atoms = Xcalloc(1, sizeof(AtomTable));
 	    dpy->free_funcs->atoms = _XFreeAtomTable;
+	    if (dpy->atoms)
+		_XSeedAtomCache(dpy);
 	}
 	if (!dpy->atoms)
 	    return;
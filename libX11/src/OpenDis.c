@@ -245,6 +245,15 @@ XOpenDisplay (
 	dpy->xcb->real_bufmax = dpy->buffer + conn_buf_size;
 	dpy->bufmax = dpy->buffer;
 
+#ifdef XTHREADS
+	/* Opt-in: let _XSend release the display lock while it writes to
+	 * the socket, so threads composing independent requests don't
+	 * convoy behind the writer.  Only meaningful with the display
+	 * lock in place (i.e. XInitThreads was called). */
+	if (dpy->lock && getenv("XLIBCONCURRENTFLUSH") != NULL)
+	    dpy->xcb->concurrent_flush = 1;
+#endif
+
 	/* Set up the input event queue and input event queue parameters. */
 	dpy->head = dpy->tail = NULL;
 	dpy->qlen = 0;
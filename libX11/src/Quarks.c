@@ -65,7 +65,29 @@ typedef unsigned char Bits;
 #endif
 typedef unsigned long Entry; /* don't confuse with EntryRec from Xintatom.h */
 
-static XrmQuark nextQuark = 1;	/* next available quark number */
+/* Resource strings common to most clients, pre-interned as the quarks
+ * 1..STATICQUARKS.  The table is const, so it sits in the read-only
+ * image of the library and is shared between all client processes by
+ * the OS; looking one up takes no lock and allocates nothing.  The
+ * entries must stay in bytewise sorted order.
+ */
+static _Xconst char *_Xconst staticQuarks[] = {
+    "Background", "BorderColor", "BorderWidth", "Color",
+    "Cursor", "CursorColor", "Display", "Font",
+    "Foreground", "Geometry", "IconName", "Name",
+    "Pointer", "PointerColor", "ReverseVideo", "ScrollBar",
+    "String", "Synchronous", "Title", "background",
+    "borderColor", "borderWidth", "color", "cursor",
+    "cursorColor", "display", "font", "foreground",
+    "geometry", "iconName", "name", "pointer",
+    "pointerColor", "reverseVideo", "scrollBar", "synchronous",
+    "title"
+};
+
+#define STATICQUARKS \
+    ((XrmQuark)(sizeof(staticQuarks) / sizeof(staticQuarks[0])))
+
+static XrmQuark nextQuark = STATICQUARKS + 1; /* next available quark number */
 static unsigned long quarkMask = 0;
 static Entry zero = 0;
 static Entry *quarkTable = &zero; /* crock */
@@ -235,6 +257,28 @@ ExpandQuarkTable(void)
     return True;
 }
 
+static XrmQuark
+FindStaticQuark(
+    register _Xconst char *name, register int len)
+{
+    register int lo = 0, hi = STATICQUARKS - 1;
+
+    while (lo <= hi) {
+	int mid = (lo + hi) >> 1;
+	_Xconst char *s = staticQuarks[mid];
+	int cmp = strncmp(s, name, len);
+	if (!cmp)
+	    cmp = (unsigned char)s[len];
+	if (!cmp)
+	    return (XrmQuark)(mid + 1);
+	if (cmp < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid - 1;
+    }
+    return NULLQUARK;
+}
+
 XrmQuark
 _XrmInternalStringToQuark(
     register _Xconst char *name, register int len, register Signature sig,
@@ -246,6 +290,10 @@ _XrmInternalStringToQuark(
     register char *s1, *s2;
     char *new;
 
+    q = FindStaticQuark(name, len);
+    if (q != NULLQUARK)
+	return q;
+
     rehash = 0;
     idx = HASH(sig);
     _XLockMutex(_Xglobal_lock);
@@ -392,6 +440,8 @@ XrmString XrmQuarkToString(register XrmQuark quark)
 {
     XrmString s;
 
+    if (quark > 0 && quark <= STATICQUARKS)
+	return (XrmString)staticQuarks[quark - 1];
     _XLockMutex(_Xglobal_lock);
     if (quark <= 0 || quark >= nextQuark)
     	s = NULLSTRING;
@@ -7,7 +7,7 @@
 
 /* IntAtom.c */
 
-#define TABLESIZE 64
+#define TABLESIZE 512
 
 typedef struct _Entry {
     unsigned long sig;
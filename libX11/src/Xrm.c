@@ -1665,6 +1665,157 @@ GetIncludeFile(
     Xfree(str);
 }
 
+/*
+
+A compiled ("binary") database is a pre-tokenized dump of a database,
+written by XrmPutBinaryFileDatabase (xrdb -compile produces one).  Loading
+it bypasses the resource file lexer entirely: each specifier is stored as
+indices into a table of component strings, so every distinct component is
+hashed into a quark exactly once per load instead of once per occurrence.
+The format is host specific; the header carries a version and a byte-order
+stamp, and the loader rejects anything it does not recognize, so a stale
+or foreign cache fails cleanly instead of being misparsed.
+
+All words are unsigned 32-bit in host byte order:
+
+  header:  magic "XrmCache", version, byte-order stamp,
+	   string count, string bytes (word aligned), entry count
+  strings: NUL-terminated component strings, back to back
+  entries: type string index, component count,
+	   (string index << 1 | loose-binding flag) per component,
+	   value size in bytes, value bytes padded to a word
+
+*/
+
+#define XRMBIN_MAGIC		"XrmCache"
+#define XRMBIN_MAGIC_LEN	8
+#define XRMBIN_VERSION		1
+#define XRMBIN_BYTEORDER	0x01020304
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+typedef struct {
+    char	 magic[XRMBIN_MAGIC_LEN];
+    unsigned int version;
+    unsigned int byteOrder;
+    unsigned int numStrings;
+    unsigned int stringBytes;
+    unsigned int numEntries;
+} XrmBinHeader;
+
+/*	Function Name: GetBinaryDatabase
+ *	Description: Loads a compiled database file into a database.
+ *	Arguments: db - the database; its linfo mutex must be held by
+ *	                the caller, as for GetDatabase.
+ *                 filename - the name of the compiled file.
+ *	Returns: True if the file was a valid compiled database.
+ */
+
+static Bool
+GetBinaryDatabase(
+    XrmDatabase db,
+    _Xconst char *filename)
+{
+    register int fd;
+    int size, nread;
+    char *buf;
+    XrmQuark *qmap = NULL;
+    XrmBinHeader *head;
+    const char *sp, *send;
+    const unsigned int *wp, *wend;
+    unsigned int i;
+    Bool result = False;
+
+    if (!db)
+	return False;
+    if ((fd = _XOpenFile(filename, O_RDONLY | O_BINARY)) == -1)
+	return False;
+
+    {
+	struct stat status_buffer;
+	if (((fstat(fd, &status_buffer)) == -1) ||
+	    (status_buffer.st_size >= INT_MAX)) {
+	    close(fd);
+	    return False;
+	} else
+	    size = (int) status_buffer.st_size;
+    }
+
+    if ((unsigned int) size < sizeof(XrmBinHeader) ||
+	!(buf = Xmalloc(size))) {
+	close(fd);
+	return False;
+    }
+    nread = read(fd, buf, size);
+    close(fd);
+    if (nread != size)
+	goto bail;
+
+    head = (XrmBinHeader *) buf;
+    if (memcmp(head->magic, XRMBIN_MAGIC, XRMBIN_MAGIC_LEN) ||
+	head->version != XRMBIN_VERSION ||
+	head->byteOrder != XRMBIN_BYTEORDER ||
+	(head->stringBytes & 3) ||
+	head->stringBytes > (unsigned int) size - sizeof(XrmBinHeader))
+	goto bail;
+
+    /* intern each component string once */
+    sp = buf + sizeof(XrmBinHeader);
+    send = sp + head->stringBytes;
+    if (head->numStrings) {
+	if (head->stringBytes == 0 || send[-1] != '\0' ||
+	    !(qmap = Xmalloc(head->numStrings * sizeof(XrmQuark))))
+	    goto bail;
+	for (i = 0; i < head->numStrings; i++) {
+	    if (sp >= send)
+		goto bail;
+	    qmap[i] = XrmStringToQuark(sp);
+	    sp += strlen(sp) + 1;
+	}
+    }
+
+    wp = (const unsigned int *) send;
+    wend = (const unsigned int *) (buf + (size & ~3));
+    for (i = 0; i < head->numEntries; i++) {
+	XrmBinding bindings[MAXDBDEPTH + 1];
+	XrmQuark quarks[MAXDBDEPTH + 1];
+	XrmValue value;
+	unsigned int type, ncomp, vsize, j;
+
+	if (wend - wp < 2)
+	    goto bail;
+	type = *wp++;
+	ncomp = *wp++;
+	if (type >= head->numStrings || ncomp == 0 || ncomp > MAXDBDEPTH ||
+	    (unsigned int) (wend - wp) < ncomp + 1)
+	    goto bail;
+	for (j = 0; j < ncomp; j++) {
+	    unsigned int word = *wp++;
+
+	    bindings[j] = (word & 1) ? XrmBindLoosely : XrmBindTightly;
+	    if ((word >>= 1) >= head->numStrings)
+		goto bail;
+	    quarks[j] = qmap[word];
+	}
+	quarks[ncomp] = NULLQUARK;
+	vsize = *wp++;
+	if (((vsize + 3) >> 2) > (unsigned int) (wend - wp))
+	    goto bail;
+	value.size = vsize;
+	value.addr = (XPointer) wp;
+	PutEntry(db, bindings, quarks, qmap[type], &value);
+	wp += (vsize + 3) >> 2;
+    }
+    result = True;
+
+ bail:
+    Xfree(qmap);
+    Xfree(buf);
+    return result;
+}
+
 XrmDatabase
 XrmGetFileDatabase(
     _Xconst char    *filename)
@@ -1677,7 +1828,15 @@ XrmGetFileDatabase(
 
     db = NewDatabase();
     _XLockMutex(&db->linfo);
-    GetDatabase(db, str, filename, True, 0);
+    if (!strncmp(str, XRMBIN_MAGIC, XRMBIN_MAGIC_LEN)) {
+	if (!GetBinaryDatabase(db, filename)) {
+	    _XUnlockMutex(&db->linfo);
+	    XrmDestroyDatabase(db);
+	    Xfree(str);
+	    return (XrmDatabase)NULL;
+	}
+    } else
+	GetDatabase(db, str, filename, True, 0);
     _XUnlockMutex(&db->linfo);
     Xfree(str);
     return db;
@@ -1701,7 +1860,16 @@ XrmCombineFileDatabase(
     } else
 	db = NewDatabase();
     _XLockMutex(&db->linfo);
-    GetDatabase(db, str, filename, True, 0);
+    if (!strncmp(str, XRMBIN_MAGIC, XRMBIN_MAGIC_LEN)) {
+	if (!GetBinaryDatabase(db, filename)) {
+	    _XUnlockMutex(&db->linfo);
+	    if (!override)
+		XrmDestroyDatabase(db);
+	    Xfree(str);
+	    return 0;
+	}
+    } else
+	GetDatabase(db, str, filename, True, 0);
     _XUnlockMutex(&db->linfo);
     Xfree(str);
     if (!override)
@@ -2099,6 +2267,170 @@ XrmPutFileDatabase(
     fclose(file);
 }
 
+/* accumulates the string table and entry stream of a compiled database */
+typedef struct {
+    char	 *strings;
+    unsigned int stringsUsed;
+    unsigned int stringsSize;
+    unsigned int *entries;
+    unsigned int entriesUsed;	/* in words */
+    unsigned int entriesSize;
+    unsigned int *quarkIndex;	/* maps quark to string table index + 1 */
+    unsigned int quarkIndexSize;
+    unsigned int numStrings;
+    unsigned int numEntries;
+    Bool	 failed;	/* ran out of memory */
+} BinDumpRec;
+
+static void
+BinDumpWord(
+    register BinDumpRec *dump,
+    unsigned int word)
+{
+    if (dump->failed)
+	return;
+    if (dump->entriesUsed == dump->entriesSize) {
+	unsigned int size = dump->entriesSize ? dump->entriesSize << 1 : 1024;
+	unsigned int *entries = Xrealloc(dump->entries,
+					 size * sizeof(unsigned int));
+
+	if (!entries) {
+	    dump->failed = True;
+	    return;
+	}
+	dump->entries = entries;
+	dump->entriesSize = size;
+    }
+    dump->entries[dump->entriesUsed++] = word;
+}
+
+/* return the string table index of the quark's string, adding the string
+ * to the table the first time the quark is seen
+ */
+static unsigned int
+BinDumpStringIndex(
+    register BinDumpRec *dump,
+    XrmQuark q)
+{
+    const char *s;
+    unsigned int len;
+
+    if (dump->failed)
+	return 0;
+    if ((unsigned int) q >= dump->quarkIndexSize) {
+	unsigned int size = dump->quarkIndexSize ? dump->quarkIndexSize : 256;
+	unsigned int *index;
+
+	while ((unsigned int) q >= size)
+	    size <<= 1;
+	index = Xrealloc(dump->quarkIndex, size * sizeof(unsigned int));
+	if (!index) {
+	    dump->failed = True;
+	    return 0;
+	}
+	bzero((char *) &index[dump->quarkIndexSize],
+	      (size - dump->quarkIndexSize) * sizeof(unsigned int));
+	dump->quarkIndex = index;
+	dump->quarkIndexSize = size;
+    }
+    if (dump->quarkIndex[q])
+	return dump->quarkIndex[q] - 1;
+    s = XrmQuarkToString(q);
+    len = (unsigned int) strlen(s) + 1;
+    if (dump->stringsUsed + len > dump->stringsSize) {
+	unsigned int size = dump->stringsSize ? dump->stringsSize : 1024;
+	char *strings;
+
+	while (dump->stringsUsed + len > size)
+	    size <<= 1;
+	strings = Xrealloc(dump->strings, size);
+	if (!strings) {
+	    dump->failed = True;
+	    return 0;
+	}
+	dump->strings = strings;
+	dump->stringsSize = size;
+    }
+    memcpy(dump->strings + dump->stringsUsed, s, len);
+    dump->stringsUsed += len;
+    dump->quarkIndex[q] = ++dump->numStrings;
+    return dump->numStrings - 1;
+}
+
+/* append one entry to the compiled stream */
+/*ARGSUSED*/
+static Bool
+BinDumpEntry(
+    XrmDatabase		*db,
+    XrmBindingList      bindings,
+    XrmQuarkList	quarks,
+    XrmRepresentation   *type,
+    XrmValuePtr		value,
+    XPointer		data)
+{
+    register BinDumpRec *dump = (BinDumpRec *) data;
+    register XrmQuarkList q;
+    unsigned int ncomp, nwords, start;
+
+    for (ncomp = 0, q = quarks; *q; q++)
+	ncomp++;
+    BinDumpWord(dump, BinDumpStringIndex(dump, *type));
+    BinDumpWord(dump, ncomp);
+    for (; *quarks; bindings++, quarks++)
+	BinDumpWord(dump, (BinDumpStringIndex(dump, *quarks) << 1) |
+		    (*bindings == XrmBindLoosely ? 1 : 0));
+    BinDumpWord(dump, (unsigned int) value->size);
+    start = dump->entriesUsed;
+    nwords = ((unsigned int) value->size + 3) >> 2;
+    while (nwords--)
+	BinDumpWord(dump, 0);	/* reserve space, zero the pad bytes */
+    if (!dump->failed && value->size)
+	memcpy(dump->entries + start, value->addr, value->size);
+    dump->numEntries++;
+    return dump->failed;
+}
+
+void
+XrmPutBinaryFileDatabase(
+    XrmDatabase db,
+    _Xconst char *fileName)
+{
+    FILE	*file;
+    XrmQuark empty = NULLQUARK;
+    BinDumpRec dump;
+    XrmBinHeader head;
+
+    if (!db) return;
+    bzero((char *) &dump, sizeof(dump));
+    if (XrmEnumerateDatabase(db, &empty, &empty, XrmEnumAllLevels,
+			     BinDumpEntry, (XPointer) &dump) || dump.failed)
+	goto bail;
+
+    memcpy(head.magic, XRMBIN_MAGIC, XRMBIN_MAGIC_LEN);
+    head.version = XRMBIN_VERSION;
+    head.byteOrder = XRMBIN_BYTEORDER;
+    head.numStrings = dump.numStrings;
+    head.stringBytes = (dump.stringsUsed + 3) & ~(unsigned int) 3;
+    head.numEntries = dump.numEntries;
+
+    if (!(file = fopen(fileName, "wb")))
+	goto bail;
+    fwrite(&head, sizeof(head), 1, file);
+    if (dump.stringsUsed)
+	fwrite(dump.strings, 1, dump.stringsUsed, file);
+    if (head.stringBytes > dump.stringsUsed)
+	fwrite("\0\0\0", 1, head.stringBytes - dump.stringsUsed, file);
+    if (dump.entriesUsed)
+	fwrite(dump.entries, sizeof(unsigned int), dump.entriesUsed, file);
+    if (ferror(file))
+	unlink((char *)fileName);
+    fclose(file);
+ bail:
+    Xfree(dump.strings);
+    Xfree(dump.entries);
+    Xfree(dump.quarkIndex);
+}
+
 /* macros used in get/search functions */
 
 /* find entries named ename, leafness leaf, tight or loose, and call get */
@@ -40,6 +40,15 @@ typedef struct _X11XCBPrivate {
 	xcondition_t event_notify;
 	int event_waiter;
 	xcondition_t reply_notify;
+
+	/* opt-in concurrent flush (XLIBCONCURRENTFLUSH): _XSend gives up the
+	 * display lock during socket writes so other threads keep composing
+	 * requests; tickets keep the batches in sequence order on the wire */
+	int concurrent_flush;
+	char *spare_buffer;
+	uint64_t flush_next_ticket;
+	uint64_t flush_done_ticket;
+	xcondition_t flush_notify;
 } _X11XCBPrivate;
 
 /* xcb_disp.c */
@@ -85,10 +85,13 @@ int _XConnectXCB(Display *dpy, _Xconst char *display, int *screenp)
 
 	dpy->xcb->event_notify = xcondition_malloc();
 	dpy->xcb->reply_notify = xcondition_malloc();
-	if (!dpy->xcb->event_notify || !dpy->xcb->reply_notify)
+	dpy->xcb->flush_notify = xcondition_malloc();
+	if (!dpy->xcb->event_notify || !dpy->xcb->reply_notify ||
+	    !dpy->xcb->flush_notify)
 		return 0;
 	xcondition_init(dpy->xcb->event_notify);
 	xcondition_init(dpy->xcb->reply_notify);
+	xcondition_init(dpy->xcb->flush_notify);
 	return !xcb_connection_has_error(c);
 }
 
@@ -104,6 +107,8 @@ void _XFreeX11XCBStructure(Display *dpy)
 	}
 	xcondition_free(dpy->xcb->event_notify);
 	xcondition_free(dpy->xcb->reply_notify);
+	xcondition_free(dpy->xcb->flush_notify);
+	Xfree(dpy->xcb->spare_buffer);
 	Xfree(dpy->xcb);
 	dpy->xcb = NULL;
 }
@@ -54,6 +54,13 @@ static void return_socket(void *closure)
 	Display *dpy = closure;
 	InternalLockDisplay(dpy, /* don't skip user locks */ 0);
 	_XSend(dpy, NULL, 0);
+#ifdef XTHREADS
+	/* In concurrent-flush mode _XSend may have released the lock during
+	 * the write, letting other threads compose more requests; those must
+	 * reach the wire before XCB takes the socket back. */
+	while(dpy->xcb->concurrent_flush && dpy->bufptr != dpy->buffer)
+		_XSend(dpy, NULL, 0);
+#endif
 	dpy->bufmax = dpy->buffer;
 	UnlockDisplay(dpy);
 }
@@ -540,6 +547,12 @@ void _XSend(Display *dpy, const char *data, long size)
 	uint64_t dpy_request;
 	_XExtension *ext;
 	xcb_connection_t *c = dpy->xcb->connection;
+	long head_len;
+#ifdef XTHREADS
+	uint64_t ticket = 0;
+	int ticketed = 0;
+	char *flushed_buf = NULL;
+#endif
 	if(dpy->flags & XlibDisplayIOError)
 		return;
 
@@ -550,6 +563,35 @@ void _XSend(Display *dpy, const char *data, long size)
 	 * therefore we can get it outside of the loop and the if
 	 */
 	dpy_request = X_DPY_GET_REQUEST(dpy);
+	head_len = dpy->bufptr - dpy->buffer;
+
+#ifdef XTHREADS
+	if(dpy->xcb->concurrent_flush)
+	{
+		/* Writers are ticketed so batches reach the wire in sequence
+		 * order even though the write below may give up the display
+		 * lock.  While we wait for our turn, other threads keep
+		 * composing requests into the buffer; with a payload in @data
+		 * we keep the batch boundary captured above so the payload
+		 * stays contiguous with its request header. */
+		ticket = dpy->xcb->flush_next_ticket++;
+		ticketed = 1;
+		while(dpy->xcb->flush_done_ticket != ticket)
+			ConditionWait(dpy, dpy->xcb->flush_notify);
+		if(dpy->flags & XlibDisplayIOError)
+			goto out;
+		if(!size)
+		{
+			/* No payload to keep contiguous, so take everything
+			 * composed while we waited as well. */
+			dpy_request = X_DPY_GET_REQUEST(dpy);
+			head_len = dpy->bufptr - dpy->buffer;
+			if(!head_len)
+				goto out; /* an earlier ticket flushed it all */
+		}
+	}
+#endif
+
 	/* iff we asked XCB to set aside errors, we must pick those up
 	 * eventually. iff there are async handlers, we may have just
 	 * issued requests that will generate replies. in either case,
@@ -564,7 +606,7 @@ void _XSend(Display *dpy, const char *data, long size)
 	dpy->xcb->last_flushed = dpy_request;
 
 	vec[0].iov_base = dpy->buffer;
-	vec[0].iov_len = dpy->bufptr - dpy->buffer;
+	vec[0].iov_len = head_len;
 	vec[1].iov_base = (char *)data;
 	vec[1].iov_len = size;
 	vec[2].iov_base = (char *)pad;
@@ -578,12 +620,90 @@ void _XSend(Display *dpy, const char *data, long size)
 				ext->before_flush(dpy, &ext->codes, vec[i].iov_base, vec[i].iov_len);
 	}
 
+#ifdef XTHREADS
+	if(ticketed && dpy->bufptr == dpy->buffer + head_len)
+	{
+		/* The whole buffer goes out, so swap a fresh one in and drop
+		 * the display lock for the duration of the write; threads
+		 * doing independent work no longer convoy behind it.  If no
+		 * buffer is available we simply write in place under the
+		 * lock, as ever. */
+		long bufsize = dpy->xcb->real_bufmax - dpy->buffer;
+		char *fresh = dpy->xcb->spare_buffer;
+		dpy->xcb->spare_buffer = NULL;
+		if(!fresh)
+			fresh = Xmalloc(bufsize);
+		if(fresh)
+		{
+			Bool socket_owned = dpy->bufmax != dpy->buffer;
+			flushed_buf = dpy->buffer;
+			dpy->buffer = dpy->bufptr = fresh;
+			dpy->xcb->real_bufmax = fresh + bufsize;
+			dpy->bufmax = socket_owned ? dpy->xcb->real_bufmax : fresh;
+			dpy->last_req = (char *) &dummy_request;
+			if(dpy->lock)
+				(*dpy->lock->user_lock_display)(dpy);
+			UnlockDisplay(dpy);
+		}
+	}
+#endif
+
 	if(xcb_writev(c, vec, 3, requests) < 0) {
+#ifdef XTHREADS
+		if(flushed_buf)
+		{
+			InternalLockDisplay(dpy, /* don't skip user locks */ 0);
+			if(dpy->lock)
+				(*dpy->lock->user_unlock_display)(dpy);
+			Xfree(flushed_buf);
+		}
+		if(ticketed)
+		{
+			dpy->xcb->flush_done_ticket = ticket + 1;
+			ConditionBroadcast(dpy, dpy->xcb->flush_notify);
+		}
+#endif
 		_XIOError(dpy);
 		return;
 	}
-	dpy->bufptr = dpy->buffer;
-	dpy->last_req = (char *) &dummy_request;
+#ifdef XTHREADS
+	if(flushed_buf)
+	{
+		InternalLockDisplay(dpy, /* don't skip user locks */ 0);
+		if(dpy->lock)
+			(*dpy->lock->user_unlock_display)(dpy);
+		if(!dpy->xcb->spare_buffer)
+			dpy->xcb->spare_buffer = flushed_buf;
+		else
+			Xfree(flushed_buf);
+	}
+	else
+#endif
+	{
+		/* Wrote in place: drop our batch from the front of the buffer
+		 * but keep any requests composed behind it while we waited. */
+		long leftover = (dpy->bufptr - dpy->buffer) - head_len;
+		if(leftover > 0)
+		{
+			memmove(dpy->buffer, dpy->buffer + head_len, leftover);
+			if(dpy->last_req != (char *) &dummy_request)
+				dpy->last_req -= head_len;
+		}
+		else
+			dpy->last_req = (char *) &dummy_request;
+		dpy->bufptr = dpy->buffer + leftover;
+	}
+
+#ifdef XTHREADS
+out:
+	if(ticketed)
+	{
+		dpy->xcb->flush_done_ticket = ticket + 1;
+		ConditionBroadcast(dpy, dpy->xcb->flush_notify);
+	}
+	if(dpy->flags & XlibDisplayIOError)
+		return;
+#endif
 
 	if (!check_internal_connections(dpy))
 		return;
@@ -37,9 +37,133 @@ in this Software without prior written authorization from The Open Group.
 #define XOS_USE_NO_LOCKING
 #include <X11/Xos_r.h>
 #endif
+#include <sys/stat.h>
+#include <stdlib.h>
 
 #define binaryEqual(a, b, len) (memcmp(a, b, len) == 0)
 
+/*
+ * Parsed snapshot of the authority file.  The file is re-read only when
+ * its name, modification time or size change; otherwise lookups run over
+ * the in-memory entries, avoiding a per-connection open and parse of a
+ * file that can hold hundreds of entries.
+ */
+static Xauth	**cacheEntries = NULL;
+static int	cacheCount = 0;
+static char	*cacheName = NULL;
+static time_t	cacheMtime;
+static long	cacheSize;
+
+static void
+XauDisposeCache (void)
+{
+    int	i;
+
+    for (i = 0; i < cacheCount; i++)
+	XauDisposeAuth (cacheEntries[i]);
+    free (cacheEntries);
+    cacheEntries = NULL;
+    cacheCount = 0;
+    free (cacheName);
+    cacheName = NULL;
+}
+
+static int
+XauRefreshCache (_Xconst char *auth_name)
+{
+    struct stat	statb;
+    FILE	*auth_file;
+    Xauth	*entry;
+    Xauth	**entries;
+    int		alloced;
+
+    if (stat (auth_name, &statb) != 0)
+	return 0;
+    if (cacheName &&
+	strcmp (cacheName, auth_name) == 0 &&
+	cacheMtime == statb.st_mtime &&
+	cacheSize == (long) statb.st_size)
+	return 1;
+    XauDisposeCache ();
+    auth_file = fopen (auth_name, "rb");
+    if (!auth_file)
+	return 0;
+    alloced = 16;
+    entries = malloc (alloced * sizeof (Xauth *));
+    if (!entries) {
+	(void) fclose (auth_file);
+	return 0;
+    }
+    cacheEntries = entries;
+    while ((entry = XauReadAuth (auth_file)) != NULL) {
+	if (cacheCount == alloced) {
+	    alloced *= 2;
+	    entries = realloc (cacheEntries, alloced * sizeof (Xauth *));
+	    if (!entries) {
+		XauDisposeAuth (entry);
+		XauDisposeCache ();
+		(void) fclose (auth_file);
+		return 0;
+	    }
+	    cacheEntries = entries;
+	}
+	cacheEntries[cacheCount++] = entry;
+    }
+    (void) fclose (auth_file);
+    cacheName = malloc (strlen (auth_name) + 1);
+    if (!cacheName) {
+	XauDisposeCache ();
+	return 0;
+    }
+    strcpy (cacheName, auth_name);
+    cacheMtime = statb.st_mtime;
+    cacheSize = (long) statb.st_size;
+    return 1;
+}
+
+static char *
+XauCopyField (_Xconst char *src, unsigned short len)
+{
+    char    *dst;
+
+    if (!len)
+	return NULL;
+    dst = malloc (len);
+    if (dst)
+	memcpy (dst, src, len);
+    return dst;
+}
+
+/*
+ * Copy a cached entry so the caller can dispose of it as before.
+ */
+static Xauth *
+XauCopyAuth (_Xconst Xauth *auth)
+{
+    Xauth   *copy;
+
+    copy = malloc (sizeof (Xauth));
+    if (!copy)
+	return NULL;
+    copy->family = auth->family;
+    copy->address_length = auth->address_length;
+    copy->number_length = auth->number_length;
+    copy->name_length = auth->name_length;
+    copy->data_length = auth->data_length;
+    copy->address = XauCopyField (auth->address, auth->address_length);
+    copy->number = XauCopyField (auth->number, auth->number_length);
+    copy->name = XauCopyField (auth->name, auth->name_length);
+    copy->data = XauCopyField (auth->data, auth->data_length);
+    if ((auth->address_length && !copy->address) ||
+	(auth->number_length && !copy->number) ||
+	(auth->name_length && !copy->name) ||
+	(auth->data_length && !copy->data)) {
+	XauDisposeAuth (copy);
+	return NULL;
+    }
+    return copy;
+}
+
 Xauth *
 XauGetBestAuthByAddr (
 #if NeedWidePrototypes
@@ -60,12 +184,12 @@ XauGetBestAuthByAddr (
     char**		types,
     _Xconst int*	type_lengths)
 {
-    FILE    *auth_file;
     char    *auth_name;
     Xauth   *entry;
     Xauth   *best;
     int	    best_type;
     int	    type;
+    int	    i;
 #ifdef hpux
     char		*fully_qual_address;
     unsigned short	fully_qual_address_length;
@@ -76,8 +200,7 @@ XauGetBestAuthByAddr (
 	return NULL;
     if (access (auth_name, R_OK) != 0)		/* checks REAL id */
 	return NULL;
-    auth_file = fopen (auth_name, "rb");
-    if (!auth_file)
+    if (!XauRefreshCache (auth_name))
 	return NULL;
 
 #ifdef hpux
@@ -102,10 +225,8 @@ XauGetBestAuthByAddr (
 
     best = NULL;
     best_type = types_length;
-    for (;;) {
-	entry = XauReadAuth (auth_file);
-	if (!entry)
-	    break;
+    for (i = 0; i < cacheCount; i++) {
+	entry = cacheEntries[i];
 	/*
 	 * Match when:
 	 *   either family or entry->family are FamilyWild or
@@ -147,17 +268,14 @@ XauGetBestAuthByAddr (
 		}
 	    if (type < best_type)
 	    {
-		if (best)
-		    XauDisposeAuth (best);
 		best = entry;
 		best_type = type;
 		if (type == 0)
 		    break;
-		continue;
 	    }
 	}
-	XauDisposeAuth (entry);
     }
-    (void) fclose (auth_file);
-    return best;
+    if (!best)
+	return NULL;
+    return XauCopyAuth (best);
 }
@@ -394,6 +394,107 @@ Bail:
     return FALSE;
 }
 
+/*
+ * Deferred decoding of glyph bitmaps.
+ *
+ * Reading a font used to convert the entire bitmap table to the
+ * server's bit order and glyph padding at open time, which dominates
+ * OpenFont for multi-megabyte CJK fonts whose glyphs are mostly never
+ * drawn.  Instead, the table is kept raw as read from the file, glyph
+ * storage is calloc'd (so pages for untouched glyphs stay demand-zero),
+ * and glyphs are decoded in blocks of 256 the first time a request
+ * returns them.  Fonts whose byte order must be swapped still decode
+ * eagerly: the swap runs over scan units of the whole table, and glyph
+ * offsets need not be unit-aligned, so it cannot be replayed one glyph
+ * at a time.
+ */
+
+#define PCF_DECODE_BLOCK	256
+
+typedef struct _PCFFont {
+    BitmapFontRec bitmapFont;   /* pFont->fontPrivate points here */
+    char       *rawBitmaps;     /* bitmap table as stored in the file */
+    CARD32     *rawOffsets;     /* per-glyph offsets into rawBitmaps */
+    int         rawGlyphPad;    /* glyph padding used in the file */
+    int         glyphPad;       /* glyph padding wanted by the server */
+    Bool        invertBits;     /* file bit order differs from server's */
+    char       *blockDecoded;   /* one flag per block of glyphs */
+} PCFFontRec, *PCFFontPtr;
+
+/* Matches what RepadBitmap returns for the same metric and padding */
+static CARD32
+pcfGlyphBytes(xCharInfo *metric, int glyphPad)
+{
+    int         width = metric->rightSideBearing - metric->leftSideBearing;
+    int         height = metric->ascent + metric->descent;
+    int         widthBytes;
+
+    switch (glyphPad) {
+    case 1:
+	widthBytes = (width + 7) >> 3;
+	break;
+    case 2:
+	widthBytes = ((width + 15) >> 4) << 1;
+	break;
+    case 4:
+	widthBytes = ((width + 31) >> 5) << 2;
+	break;
+    case 8:
+	widthBytes = ((width + 63) >> 6) << 3;
+	break;
+    default:
+	return 0;
+    }
+    return widthBytes * height;
+}
+
+static void
+pcfDecodeGlyphBlock(PCFFontPtr priv, int block)
+{
+    BitmapFontPtr bitmapFont = &priv->bitmapFont;
+    int         i = block * PCF_DECODE_BLOCK;
+    int         limit = i + PCF_DECODE_BLOCK;
+    int         len;
+    xCharInfo  *metric;
+
+    if (limit > bitmapFont->num_chars)
+	limit = bitmapFont->num_chars;
+    for (; i < limit; i++) {
+	metric = &bitmapFont->metrics[i].metrics;
+	len = RepadBitmap(priv->rawBitmaps + priv->rawOffsets[i],
+			  bitmapFont->metrics[i].bits,
+			  priv->rawGlyphPad, priv->glyphPad,
+			  metric->rightSideBearing - metric->leftSideBearing,
+			  metric->ascent + metric->descent);
+	if (priv->invertBits)
+	    BitOrderInvert((unsigned char *) bitmapFont->metrics[i].bits, len);
+    }
+    priv->blockDecoded[block] = TRUE;
+}
+
+static int
+pcfGetGlyphs(FontPtr pFont, unsigned long count, unsigned char *chars,
+	     FontEncoding charEncoding, unsigned long *glyphCount,
+	     CharInfoPtr *glyphs)
+{
+    PCFFontPtr  priv = (PCFFontPtr) pFont->fontPrivate;
+    int         ret;
+    unsigned long i;
+    int         block;
+
+    ret = bitmapGetGlyphs(pFont, count, chars, charEncoding,
+			  glyphCount, glyphs);
+    if (ret == Successful) {
+	for (i = 0; i < *glyphCount; i++) {
+	    block = (int) (glyphs[i] - priv->bitmapFont.metrics) /
+		PCF_DECODE_BLOCK;
+	    if (!priv->blockDecoded[block])
+		pcfDecodeGlyphBlock(priv, block);
+	}
+    }
+    return ret;
+}
+
 int
 pcfReadFont(FontPtr pFont, FontFilePtr file,
 	    int bit, int byte, int glyph, int scan)
@@ -417,6 +518,14 @@ pcfReadFont(FontPtr pFont, FontFilePtr file,
     CARD32      bitmapSizes[GLYPHPADOPTIONS];
     CARD32     *offsets = 0;
     Bool	hasBDFAccelerators;
+    PCFFontPtr  priv = 0;
+    char       *decodedBitmaps = 0;
+    CARD32     *rawOffsets = 0;
+    char       *blockDecoded = 0;
+    Bool	fLazy = FALSE;
+    Bool	fInvert, fSwap;
+    int         scanunit;
+    int         rawGlyphPad = 0;
 
     pFont->info.nprops = 0;
     pFont->info.props = 0;
@@ -510,48 +619,95 @@ pcfReadFont(FontPtr pFont, FontFilePtr file,
     if (IS_EOF(file)) goto Bail;
     position += sizebitmaps;
 
-    if (PCF_BIT_ORDER(format) != bit)
-	BitOrderInvert((unsigned char *)bitmaps, sizebitmaps);
-    if ((PCF_BYTE_ORDER(format) == PCF_BIT_ORDER(format)) != (bit == byte)) {
-	switch (bit == byte ? PCF_SCAN_UNIT(format) : scan) {
-	case 1:
-	    break;
-	case 2:
-	    TwoByteSwap((unsigned char *)bitmaps, sizebitmaps);
-	    break;
-	case 4:
-	    FourByteSwap((unsigned char *)bitmaps, sizebitmaps);
-	    break;
+    scanunit = (bit == byte) ? PCF_SCAN_UNIT(format) : scan;
+    fSwap = ((PCF_BYTE_ORDER(format) == PCF_BIT_ORDER(format)) != (bit == byte))
+	&& (scanunit == 2 || scanunit == 4);
+    fInvert = (PCF_BIT_ORDER(format) != bit);
+
+    if (!fSwap && (fInvert || PCF_GLYPH_PAD(format) != glyph)) {
+	/*
+	 * Decode glyphs lazily on first use (see pcfGetGlyphs above).
+	 * Bit inversion and repadding are per-glyph transformations, so
+	 * they can be replayed one block at a time; only a byte-order
+	 * swap forces the eager path below.
+	 */
+	CARD32      total;
+	int         nblocks;
+
+	rawGlyphPad = PCF_GLYPH_PAD(format);
+	rawOffsets = malloc(nbitmaps * sizeof(CARD32));
+	if (!rawOffsets) {
+	    pcfError("pcfReadFont(): Couldn't allocate rawOffsets (%d*%d)\n",
+		     nbitmaps, (int) sizeof(CARD32));
+	    goto Bail;
 	}
-    }
-    if (PCF_GLYPH_PAD(format) != glyph) {
-	char       *padbitmaps;
-	int         sizepadbitmaps;
-	int         old,
-	            new;
-	xCharInfo  *metric;
-
-	sizepadbitmaps = bitmapSizes[PCF_SIZE_TO_INDEX(glyph)];
-	padbitmaps = malloc(sizepadbitmaps);
-	if (!padbitmaps) {
-          pcfError("pcfReadFont(): Couldn't allocate padbitmaps (%d)\n", sizepadbitmaps);
+	memcpy(rawOffsets, offsets, nbitmaps * sizeof(CARD32));
+	if (rawGlyphPad != glyph) {
+	    /* compute where each glyph lands with the server's padding */
+	    total = 0;
+	    for (i = 0; i < nbitmaps; i++) {
+		offsets[i] = total;
+		total += pcfGlyphBytes(&metrics[i].metrics, glyph);
+	    }
+	}
+	else
+	    total = sizebitmaps;
+	decodedBitmaps = calloc(1, total ? total : 1);
+	if (!decodedBitmaps) {
+	    pcfError("pcfReadFont(): Couldn't allocate decodedBitmaps (%d)\n",
+		     (int) (total ? total : 1));
 	    goto Bail;
 	}
-	new = 0;
-	for (i = 0; i < nbitmaps; i++) {
-	    old = offsets[i];
-	    metric = &metrics[i].metrics;
-	    offsets[i] = new;
-	    new += RepadBitmap(bitmaps + old, padbitmaps + new,
-			       PCF_GLYPH_PAD(format), glyph,
-			  metric->rightSideBearing - metric->leftSideBearing,
-			       metric->ascent + metric->descent);
+	nblocks = (nbitmaps + PCF_DECODE_BLOCK - 1) / PCF_DECODE_BLOCK;
+	blockDecoded = calloc(1, nblocks ? nblocks : 1);
+	if (!blockDecoded)
+	    goto Bail;
+	for (i = 0; i < nbitmaps; i++)
+	    metrics[i].bits = decodedBitmaps + offsets[i];
+	fLazy = TRUE;
+    }
+    else {
+	if (fInvert)
+	    BitOrderInvert((unsigned char *)bitmaps, sizebitmaps);
+	if (fSwap) {
+	    switch (scanunit) {
+	    case 2:
+		TwoByteSwap((unsigned char *)bitmaps, sizebitmaps);
+		break;
+	    case 4:
+		FourByteSwap((unsigned char *)bitmaps, sizebitmaps);
+		break;
+	    }
 	}
-	free(bitmaps);
-	bitmaps = padbitmaps;
+	if (PCF_GLYPH_PAD(format) != glyph) {
+	    char       *padbitmaps;
+	    int         sizepadbitmaps;
+	    int         old,
+			new;
+	    xCharInfo  *metric;
+
+	    sizepadbitmaps = bitmapSizes[PCF_SIZE_TO_INDEX(glyph)];
+	    padbitmaps = malloc(sizepadbitmaps);
+	    if (!padbitmaps) {
+	      pcfError("pcfReadFont(): Couldn't allocate padbitmaps (%d)\n", sizepadbitmaps);
+		goto Bail;
+	    }
+	    new = 0;
+	    for (i = 0; i < nbitmaps; i++) {
+		old = offsets[i];
+		metric = &metrics[i].metrics;
+		offsets[i] = new;
+		new += RepadBitmap(bitmaps + old, padbitmaps + new,
+				   PCF_GLYPH_PAD(format), glyph,
+			      metric->rightSideBearing - metric->leftSideBearing,
+				   metric->ascent + metric->descent);
+	    }
+	    free(bitmaps);
+	    bitmaps = padbitmaps;
+	}
+	for (i = 0; i < nbitmaps; i++)
+	    metrics[i].bits = bitmaps + offsets[i];
     }
-    for (i = 0; i < nbitmaps; i++)
-	metrics[i].bits = bitmaps + offsets[i];
 
     free(offsets);
     offsets = NULL;
@@ -640,19 +796,29 @@ pcfReadFont(FontPtr pFont, FontFilePtr file,
 	if (!pcfGetAccel (&pFont->info, file, tables, ntables, PCF_BDF_ACCELERATORS))
 	    goto Bail;
 
-    bitmapFont = malloc(sizeof *bitmapFont);
-    if (!bitmapFont) {
+    priv = calloc(1, sizeof *priv);
+    if (!priv) {
 	pcfError("pcfReadFont(): Couldn't allocate bitmapFont (%d)\n",
-		 (int) sizeof *bitmapFont);
+		 (int) sizeof *priv);
 	goto Bail;
     }
+    bitmapFont = &priv->bitmapFont;
+
+    if (fLazy) {
+	priv->rawBitmaps = bitmaps;
+	priv->rawOffsets = rawOffsets;
+	priv->rawGlyphPad = rawGlyphPad;
+	priv->glyphPad = glyph;
+	priv->invertBits = fInvert;
+	priv->blockDecoded = blockDecoded;
+    }
 
     bitmapFont->version_num = PCF_FILE_VERSION;
     bitmapFont->num_chars = nmetrics;
     bitmapFont->num_tables = ntables;
     bitmapFont->metrics = metrics;
     bitmapFont->ink_metrics = ink_metrics;
-    bitmapFont->bitmaps = bitmaps;
+    bitmapFont->bitmaps = fLazy ? decodedBitmaps : bitmaps;
     bitmapFont->encoding = encoding;
     bitmapFont->pDefault = (CharInfoPtr) 0;
     if (pFont->info.defaultCh != (unsigned short) NO_SUCH_CHAR) {
@@ -672,7 +838,7 @@ pcfReadFont(FontPtr pFont, FontFilePtr file,
     }
     bitmapFont->bitmapExtra = (BitmapExtraPtr) 0;
     pFont->fontPrivate = (pointer) bitmapFont;
-    pFont->get_glyphs = bitmapGetGlyphs;
+    pFont->get_glyphs = fLazy ? pcfGetGlyphs : bitmapGetGlyphs;
     pFont->get_metrics = bitmapGetMetrics;
     pFont->unload_font = pcfUnloadFont;
     pFont->unload_glyphs = NULL;
@@ -690,6 +856,9 @@ Bail:
     }
     free(encoding);
     free(bitmaps);
+    free(decodedBitmaps);
+    free(rawOffsets);
+    free(blockDecoded);
     free(metrics);
     free(pFont->info.props);
     pFont->info.nprops = 0;
@@ -782,6 +951,15 @@ pcfUnloadFont(FontPtr pFont)
     int i,nencoding;
 
     bitmapFont = (BitmapFontPtr) pFont->fontPrivate;
+    /* bitmapFont is the first member of the PCFFontRec allocated by
+       pcfReadFont; free the lazy-decode state carried behind it */
+    {
+	PCFFontPtr  priv = (PCFFontPtr) bitmapFont;
+
+	free(priv->rawBitmaps);
+	free(priv->rawOffsets);
+	free(priv->blockDecoded);
+    }
     free(bitmapFont->ink_metrics);
     if(bitmapFont->encoding) {
         nencoding = (pFont->info.lastCol - pFont->info.firstCol + 1) *
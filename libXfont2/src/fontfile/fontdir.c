@@ -340,6 +340,35 @@ SetupWildMatch(FontTablePtr table, FontNamePtr pat,
 	    else
 		left = center + 1;
 	}
+	if (left < right) {
+	    /*
+	     * center matched the literal prefix; narrow [left, right) to
+	     * exactly the run of entries sharing it, instead of handing
+	     * the caller everything between the last two probes.
+	     */
+	    int	lo, hi, mid;
+
+	    lo = left;
+	    hi = center;
+	    while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strncmp(name, table->entries[mid].name.name, first) <= 0)
+		    hi = mid;
+		else
+		    lo = mid + 1;
+	    }
+	    left = lo;
+	    lo = center + 1;
+	    hi = right;
+	    while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (strncmp(name, table->entries[mid].name.name, first) < 0)
+		    hi = mid;
+		else
+		    lo = mid + 1;
+	    }
+	    right = lo;
+	}
 	*leftp = left;
 	*rightp = right;
 	return -1;
@@ -14,7 +14,6 @@ typedef struct _xzip_buf {
   z_stream z;
   int zstat;
   BufChar b[BUFFILESIZE];
-  BufChar b_in[BUFFILESIZE];
   BufFilePtr f;
 } xzip_buf;
 
@@ -52,7 +51,7 @@ BufFilePushZIP (BufFilePtr f)
   /* now that the history buffer is allocated, we provide the data buffer */
   x->z.next_out = x->b;
   x->z.avail_out = BUFFILESIZE;
-  x->z.next_out = x->b_in;
+  x->z.next_in = Z_NULL;
   x->z.avail_in = 0;
 
   if (BufCheckZipHeader(x->f)) {
@@ -118,15 +117,18 @@ BufZipFileFill (BufFilePtr f)
   while (x->z.avail_out > 0) {
     /* if we don't have anything to work from... */
     if (x->z.avail_in == 0) {
-      /* ... fill the z buf from underlying file */
-      int i, c;
-      for (i = 0; i < sizeof(x->b_in); i++) {
-	c = BufFileGet(x->f);
-	if (c == BUFFILEEOF) break;
-	x->b_in[i] = c;
+      /* ... refill the underlying file's buffer and hand the whole
+	 of it to zlib in place, rather than draining it through
+	 BufFileGet a byte at a time into a copy of our own */
+      int c = BufFileGet(x->f);
+      if (c != BUFFILEEOF) {
+	--x->f->bufp;
+	++x->f->left;
+	x->z.next_in = x->f->bufp;
+	x->z.avail_in = x->f->left;
+	x->f->bufp += x->f->left;
+	x->f->left = 0;
       }
-      x->z.avail_in += i;
-      x->z.next_in = x->b_in;
     }
     /* so now we have some output space and some input data */
     x->zstat = inflate(&(x->z), Z_NO_FLUSH);
@@ -142,10 +144,14 @@ BufZipFileFill (BufFilePtr f)
   f->bufp = x->b;
   f->left = BUFFILESIZE - x->z.avail_out;
 
-  if (f->left >= 0) {
+  /* an empty deflate stream produces no output at all; returning a
+     byte here with left gone negative would send BufFileGet off the
+     end of the buffer */
+  if (f->left > 0) {
     f->left--;
     return *(f->bufp++);
   } else {
+    f->left = 0;
     return BUFFILEEOF;
   }
 }
@@ -94,6 +94,9 @@ extern void _XtCopyFromArg(XtArgVal src, char *dst, unsigned int size);
 extern XrmResourceList* _XtCreateIndirectionTable(XtResourceList resources,
 						  Cardinal num_resources);
 extern void _XtResourceListInitialize(void);
+extern void _XtSearchListCacheFlush(
+    XrmDatabase		/* db; NULL flushes every entry */
+);
 
 _XFUNCPROTOEND
 
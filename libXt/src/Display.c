@@ -643,12 +643,16 @@ static void CloseDisplay(Display *dpy)
 	    xtpd->per_screen_db[DefaultScreen(dpy)] = (XrmDatabase)NULL;
 	    for (i = ScreenCount(dpy); --i >= 0; ) {
 		db = xtpd->per_screen_db[i];
-		if (db)
+		if (db) {
+		    _XtSearchListCacheFlush(db);
 		    XrmDestroyDatabase(db);
+		}
 	    }
 	    XtFree((char *)xtpd->per_screen_db);
-	    if ((db = XrmGetDatabase(dpy)))
+	    if ((db = XrmGetDatabase(dpy))) {
+		_XtSearchListCacheFlush(db);
 		XrmDestroyDatabase(db);
+	    }
 	    if (xtpd->cmd_db)
 		XrmDestroyDatabase(xtpd->cmd_db);
 	    if (xtpd->server_db)
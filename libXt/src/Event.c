@@ -728,29 +728,34 @@ static Boolean CallEventHandlers(
     XtEventHandler procs[EHMAXSIZE];
     XtPointer closures[EHMAXSIZE];
     Boolean cont_to_disp = True;
-    int i, numprocs;
+    int i, numprocs, maxprocs;
 
     /* Have to copy the procs into an array, because one of them might
-     * call XtRemoveEventHandler, which would break our linked list. */
-
-    numprocs = 0;
-    for (p=widget->core.event_table; p; p = p->next) {
-	if ((!p->has_type_specifier && (mask & p->mask)) ||
-	    (p->has_type_specifier && event->type == EXT_TYPE(p)))
-	    numprocs++;
-    }
-    if (numprocs > EHMAXSIZE) {
-	proc = (XtEventHandler *)__XtMalloc(numprocs * (sizeof(XtEventHandler) +
-						      sizeof(XtPointer)));
-	closure = (XtPointer *)(proc + numprocs);
-    } else {
-	proc = procs;
-	closure = closures;
-    }
+     * call XtRemoveEventHandler, which would break our linked list.
+     * Collect in a single walk, growing off the stack buffer in the
+     * (rare) case of more than EHMAXSIZE matching handlers, instead of
+     * walking the list once to count and a second time to copy. */
+
+    proc = procs;
+    closure = closures;
+    maxprocs = EHMAXSIZE;
     numprocs = 0;
     for (p=widget->core.event_table; p; p = p->next) {
 	if ((!p->has_type_specifier && (mask & p->mask)) ||
 	    (p->has_type_specifier && event->type == EXT_TYPE(p))) {
+	    if (numprocs == maxprocs) {
+		XtEventHandler *newproc;
+		maxprocs *= 2;
+		newproc = (XtEventHandler *)
+		    __XtMalloc(maxprocs * (sizeof(XtEventHandler) +
+					   sizeof(XtPointer)));
+		XtMemmove(newproc, proc, numprocs * sizeof(XtEventHandler));
+		XtMemmove(newproc + maxprocs, closure,
+			  numprocs * sizeof(XtPointer));
+		if (proc != procs) XtFree((char *)proc);
+		proc = newproc;
+		closure = (XtPointer *)(newproc + maxprocs);
+	    }
 	    proc[numprocs] = p->proc;
 	    closure[numprocs] = p->closure;
 	    numprocs++;
@@ -771,7 +776,7 @@ static Boolean CallEventHandlers(
 		*/
     for (i = 0; i < numprocs && cont_to_disp; i++)
 	(*(proc[i]))(widget, closure[i], event, &cont_to_disp);
-    if (numprocs > EHMAXSIZE)
+    if (proc != procs)
 	XtFree((char *)proc);
     return cont_to_disp;
 }
@@ -240,6 +240,7 @@ _set_resource_values (
 	 */
 	XrmPutStringResource (&db, resource, value);
 	XrmMergeDatabases (db, &tmp_db);
+	_XtSearchListCacheFlush (tmp_db);
 	XrmGetResource (tmp_db, resource_name, resource_class,
 		&return_type, &return_value);
 	if (return_type)
@@ -458,6 +458,134 @@ XrmResourceList* _XtCreateIndirectionTable (
     return table;
 }
 
+/*
+ * Memo cache for XrmQGetSearchList results, keyed on the database and
+ * the complete name/class quark chains.  Widget creation derives the
+ * same search list more than once (normal resources, then constraint
+ * resources, then any subresources), and applications instantiating
+ * deep hierarchies re-derive nearly identical lists widget after
+ * widget; remembering the computed lists turns the repeats into a
+ * quark-chain compare.  Entries are discarded by
+ * _XtSearchListCacheFlush whenever the Intrinsics modify or destroy a
+ * database that might be cached here.
+ */
+
+#define SEARCHCACHESIZE 64	/* direct-mapped slots; power of two */
+
+typedef struct _SearchListCacheRec {
+    XrmDatabase	    db;		/* NULL in unused slots */
+    unsigned int    depth;	/* quarks per chain, excluding NULLQUARK */
+    unsigned int    count;	/* hash tables, including the terminator */
+    XrmQuarkList    quarks;	/* names then classes; 2*depth quarks */
+    XrmHashTable    *list;
+} SearchListCacheRec;
+
+static SearchListCacheRec searchListCache[SEARCHCACHESIZE];
+
+static SearchListCacheRec *SearchListCacheSlot(
+    XrmDatabase	    db,
+    XrmNameList     names,
+    XrmClassList    classes,
+    unsigned int    *depthp)
+{
+    register unsigned int hash = (unsigned int)(long)db;
+    register unsigned int depth;
+
+    for (depth = 0; names[depth]; depth++)
+	hash = (hash << 5) - hash + (unsigned int)names[depth]
+	       + ((unsigned int)classes[depth] << 16);
+    *depthp = depth;
+    return &searchListCache[hash & (SEARCHCACHESIZE - 1)];
+}
+
+void _XtSearchListCacheFlush(
+    XrmDatabase db)		/* NULL flushes every entry */
+{
+    register SearchListCacheRec *slot;
+
+    LOCK_PROCESS;
+    for (slot = searchListCache;
+	 slot < &searchListCache[SEARCHCACHESIZE]; slot++) {
+	if (slot->db == NULL || (db != NULL && slot->db != db))
+	    continue;
+	XtFree((char *)slot->quarks);
+	XtFree((char *)slot->list);
+	slot->quarks = NULL;
+	slot->list = NULL;
+	slot->db = NULL;
+    }
+    UNLOCK_PROCESS;
+}
+
+static void GetSearchList(
+    XrmDatabase	    db,
+    XrmNameList     names,
+    XrmClassList    classes,
+    XrmHashTable    **searchListP,	/* In/Out */
+    unsigned int    *searchListSizeP,	/* In/Out */
+    XrmHashTable    *stackSearchList)
+{
+    XrmHashTable    *searchList = *searchListP;
+    unsigned int    searchListSize = *searchListSizeP;
+    SearchListCacheRec *slot;
+    unsigned int    depth, count;
+
+    LOCK_PROCESS;
+    slot = SearchListCacheSlot(db, names, classes, &depth);
+    if (slot->db == db && slot->depth == depth &&
+	memcmp(slot->quarks, names, depth * sizeof(XrmQuark)) == 0 &&
+	memcmp(slot->quarks + depth, classes,
+	       depth * sizeof(XrmQuark)) == 0) {
+	while (slot->count > searchListSize) {
+	    if (searchList == stackSearchList)
+		searchList = NULL;
+	    searchList = (XrmHashTable*)XtRealloc((char*)searchList,
+						  sizeof(XrmHashTable) *
+						  (searchListSize *= 2));
+	}
+	(void) memmove((char *)searchList, (char *)slot->list,
+		       slot->count * sizeof(XrmHashTable));
+	UNLOCK_PROCESS;
+	*searchListP = searchList;
+	*searchListSizeP = searchListSize;
+	return;
+    }
+    UNLOCK_PROCESS;
+
+    while (!XrmQGetSearchList(db, names, classes,
+			      searchList, searchListSize)) {
+	if (searchList == stackSearchList)
+	    searchList = NULL;
+	searchList = (XrmHashTable*)XtRealloc((char*)searchList,
+					      sizeof(XrmHashTable) *
+					      (searchListSize *= 2));
+    }
+
+    /* The list is NULL-terminated; keep the terminator in the copy so
+       a hit can be replayed with a single memmove */
+    for (count = 0; searchList[count]; count++);
+    count++;
+
+    LOCK_PROCESS;
+    XtFree((char *)slot->quarks);
+    XtFree((char *)slot->list);
+    slot->db = db;
+    slot->depth = depth;
+    slot->count = count;
+    slot->quarks = (XrmQuarkList)__XtMalloc(2 * depth * sizeof(XrmQuark));
+    (void) memmove((char *)slot->quarks, (char *)names,
+		   depth * sizeof(XrmQuark));
+    (void) memmove((char *)(slot->quarks + depth), (char *)classes,
+		   depth * sizeof(XrmQuark));
+    slot->list = (XrmHashTable *)__XtMalloc(count * sizeof(XrmHashTable));
+    (void) memmove((char *)slot->list, (char *)searchList,
+		   count * sizeof(XrmHashTable));
+    UNLOCK_PROCESS;
+
+    *searchListP = searchList;
+    *searchListSizeP = searchListSize;
+}
+
 static XtCacheRef *GetResources(
     Widget	    widget,	    /* Widget resources are associated with */
     char*	    base,	    /* Base address of memory to write to   */
@@ -583,14 +711,8 @@ static XtCacheRef *GetResources(
        do a single-level search on each resource */
 
     db = XtScreenDatabase(XtScreenOfObject(widget));
-    while (!XrmQGetSearchList(db, names, classes,
-			      searchList, searchListSize)) {
-	if (searchList == stackSearchList)
-	    searchList = NULL;
-	searchList = (XrmHashTable*)XtRealloc((char*)searchList,
-					      sizeof(XrmHashTable) *
-					      (searchListSize *= 2));
-    }
+    GetSearchList(db, names, classes,
+		  &searchList, &searchListSize, stackSearchList);
 
     if (persistent_resources)
 	cache_base = NULL;
@@ -644,14 +766,8 @@ static XtCacheRef *GetResources(
 	/* now get the database to use for the rest of the resources */
 	if (widget->core.screen != oldscreen) {
 	    db = XtScreenDatabase(widget->core.screen);
-	    while (!XrmQGetSearchList(db, names, classes,
-				      searchList, searchListSize)) {
-		if (searchList == stackSearchList)
-		    searchList = NULL;
-		searchList = (XrmHashTable*)XtRealloc((char*)searchList,
-						      sizeof(XrmHashTable) *
-						      (searchListSize *= 2));
-	    }
+	    GetSearchList(db, names, classes,
+			  &searchList, &searchListSize, stackSearchList);
 	}
     }
 
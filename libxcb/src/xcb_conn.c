@@ -220,44 +220,30 @@ static int write_vec(xcb_connection_t *c, struct iovec **vector, int *count)
     int n;
 
 #ifdef _WIN32
-    int i = 0;
-    int cnt=*count;
-    struct iovec *vec;
-    n = 0;
+#define XCB_MAX_WSABUF 64
+    WSABUF wsabuf[XCB_MAX_WSABUF];
+    DWORD nsent = 0;
+    int i;
+    int cnt = *count;
+    struct iovec *vec = *vector;
     assert(!c->out.queue_len);
 
-    /* Could use the WSASend win32 function for scatter/gather i/o but setting up the WSABUF struct from
-       an iovec would require more work and I'm not sure of the benefit....works for now */
-    vec = *vector;
-    while(i < cnt)
+    /* Scatter/gather i/o: hand the whole iovec chain to WSASend in one
+       call instead of one blocking send() per entry. */
+    if(cnt > XCB_MAX_WSABUF)
+        cnt = XCB_MAX_WSABUF;
+    for(i = 0; i < cnt; ++i)
     {
-      char *p= vec->iov_base;
-      size_t l= vec->iov_len;
-      while (l > 0)
-      {
-         int ret = send(c->fd, p, l, 0); 
-         if(ret == SOCKET_ERROR)
-         {
-             int err  = WSAGetLastError();
-             if(err == WSAEWOULDBLOCK)
-             {
-                 if (n)
-                 {
-                   /* already return the data */
-                   i=cnt;
-                   break;
-                 }
-                 else
-                   return 1;
-             }
-         }
-         p += ret;
-         l -= ret;
-         n += ret;
-      }
-      vec++;
-      i++;
+        wsabuf[i].buf = vec[i].iov_base;
+        wsabuf[i].len = vec[i].iov_len;
     }
+    if(WSASend(c->fd, wsabuf, cnt, &nsent, 0, NULL, NULL) == SOCKET_ERROR)
+    {
+        if(WSAGetLastError() == WSAEWOULDBLOCK)
+            return 1;
+        nsent = 0;
+    }
+    n = nsent;
 #else
     assert(!c->out.queue_len);
     n = *count;
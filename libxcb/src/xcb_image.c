@@ -31,6 +31,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+
 #include <xcb/xcb.h>
 #include <xcb/shm.h>
 #include <xcb/xcb_aux.h>
@@ -531,6 +536,114 @@ xcb_image_shm_get (xcb_connection_t *      conn,
 }
 
 
+#ifndef _WIN32
+/* Create a private segment of the given size, map it and attach it to the
+ * server.  The segment is marked for deletion right away so it cannot leak
+ * even if the client crashes; it lives until both sides have detached. */
+static int
+shm_segment_create (xcb_connection_t *       conn,
+		    uint32_t                 size,
+		    xcb_shm_segment_info_t * shminfo)
+{
+  xcb_generic_error_t *  err;
+  int                    shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+
+  if (shmid == -1)
+      return 0;
+  shminfo->shmid = shmid;
+  shminfo->shmaddr = shmat(shmid, 0, 0);
+  if (shminfo->shmaddr == (uint8_t *) -1) {
+      shminfo->shmaddr = 0;
+      shmctl(shmid, IPC_RMID, 0);
+      return 0;
+  }
+  shminfo->shmseg = xcb_generate_id(conn);
+  err = xcb_request_check(conn, xcb_shm_attach_checked(conn, shminfo->shmseg,
+						       shmid, 0));
+  shmctl(shmid, IPC_RMID, 0);
+  if (err) {
+      free(err);
+      shmdt(shminfo->shmaddr);
+      shminfo->shmaddr = 0;
+      return 0;
+  }
+  return 1;
+}
+#endif /* !_WIN32 */
+
+
+xcb_image_t *
+xcb_image_shm_get_auto (xcb_connection_t *       conn,
+			xcb_drawable_t           draw,
+			int16_t                  x,
+			int16_t                  y,
+			uint16_t                 width,
+			uint16_t                 height,
+			uint32_t                 plane_mask,
+			xcb_image_format_t       format,
+			xcb_shm_segment_info_t * shminfo)
+{
+  shminfo->shmseg = 0;
+  shminfo->shmid = (uint32_t) -1;
+  shminfo->shmaddr = 0;
+#ifndef _WIN32
+  if (format == XCB_IMAGE_FORMAT_Z_PIXMAP) {
+      const xcb_query_extension_reply_t *  ext =
+	  xcb_get_extension_data(conn, &xcb_shm_id);
+
+      if (ext && ext->present) {
+	  xcb_get_geometry_reply_t *  geom =
+	      xcb_get_geometry_reply(conn, xcb_get_geometry(conn, draw), 0);
+
+	  if (geom) {
+	      xcb_image_t *  image =
+		  xcb_image_create_native(conn, width, height, format,
+					  geom->depth, 0, ~0, 0);
+
+	      free(geom);
+	      if (image) {
+		  if (shm_segment_create(conn, image->size, shminfo)) {
+		      image->data = shminfo->shmaddr;
+		      if (xcb_image_shm_get(conn, draw, image, *shminfo,
+					    x, y, plane_mask))
+			  return image;
+		      xcb_shm_detach(conn, shminfo->shmseg);
+		      shmdt(shminfo->shmaddr);
+		      shminfo->shmaddr = 0;
+		      shminfo->shmid = (uint32_t) -1;
+		      image->data = 0;
+		  }
+		  /* base is null, so this only frees the header */
+		  xcb_image_destroy(image);
+	      }
+	  }
+      }
+  }
+#endif /* !_WIN32 */
+  return xcb_image_get(conn, draw, x, y, width, height, plane_mask, format);
+}
+
+
+void
+xcb_image_shm_release (xcb_connection_t *       conn,
+		       xcb_image_t *            image,
+		       xcb_shm_segment_info_t * shminfo)
+{
+  if (shminfo->shmaddr) {
+      xcb_shm_detach(conn, shminfo->shmseg);
+#ifndef _WIN32
+      shmdt(shminfo->shmaddr);
+#endif
+      shminfo->shmaddr = 0;
+      shminfo->shmid = (uint32_t) -1;
+      if (image)
+	  image->data = 0;
+  }
+  if (image)
+      xcb_image_destroy(image);
+}
+
+
 static uint32_t
 xy_image_byte (xcb_image_t *image, uint32_t x)
 {
@@ -842,6 +955,39 @@ swap_image(uint8_t *	     src,
 	   int		     bitswap,
 	   int               nibbleswap)
 {
+  if (src_stride == dst_stride && (src_stride & 3) == 0 && byteswap != 2) {
+      /* Whole words can be converted at a time: the byte swap becomes a
+       * shift/mask permutation and bit/nibble reversal works on each
+       * byte of a word independently.  This is the path taken for the
+       * usual pad-32 images; the per-byte loop below remains for odd
+       * strides and mismatched-unit XY conversions. */
+      while (height--) {
+	  uint32_t    s;
+
+	  for (s = 0; s < src_stride; s += 4) {
+	      uint32_t	w;
+
+	      memcpy(&w, src + s, 4);
+	      if (byteswap == 1)
+		  w = ((w << 8) & 0xff00ff00) | ((w >> 8) & 0x00ff00ff);
+	      else if (byteswap == 3)
+		  w = (w << 24) | ((w << 8) & 0x00ff0000) |
+		      ((w >> 8) & 0x0000ff00) | (w >> 24);
+	      if (bitswap) {
+		  w = ((w & 0x0f0f0f0f) << 4) | ((w >> 4) & 0x0f0f0f0f);
+		  w = ((w & 0x33333333) << 2) | ((w >> 2) & 0x33333333);
+		  w = ((w & 0x55555555) << 1) | ((w >> 1) & 0x55555555);
+	      }
+	      if (nibbleswap)
+		  w = ((w & 0x0f0f0f0f) << 4) | ((w >> 4) & 0x0f0f0f0f);
+	      memcpy(dst + s, &w, 4);
+	  }
+	  src += src_stride;
+	  dst += dst_stride;
+      }
+      return;
+  }
+
   while (height--) {
       uint32_t    s;
 
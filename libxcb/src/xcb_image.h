@@ -562,6 +562,64 @@ int xcb_image_shm_get (xcb_connection_t *      conn,
 		       uint32_t                plane_mask);
 
 
+/**
+ * Fetch an image, using the MIT Shm Extension without a copy when possible.
+ * @param conn The connection to the X server.
+ * @param draw The drawable to get the image from.
+ * @param x The x coordinate, relative to the origin of the
+ * drawable, of the upper-left corner of the rectangle.
+ * @param y The y coordinate, relative to the origin of the
+ * drawable, of the upper-left corner of the rectangle.
+ * @param width The width of the subimage, in pixels.
+ * @param height The height of the subimage, in pixels.
+ * @param plane_mask The plane mask.
+ * @param format The format of the image.
+ * @param shminfo A @ref xcb_shm_segment_info_t structure filled in by
+ * this function.
+ * @return The subimage of @p draw defined by @p x, @p y, @p width,
+ * @p height, or 0 on error.
+ *
+ * When the server supports the MIT Shm Extension and @p format is
+ * ZPixmap, this function creates a shared memory segment, has the
+ * server write the image into it, and returns an image whose data is
+ * the mapped segment itself: the pixels are never copied through the
+ * connection.  Otherwise it falls back to a plain @ref xcb_image_get().
+ * Either way the returned image must be released with
+ * @ref xcb_image_shm_release() together with the @p shminfo this
+ * function filled in; the image data is invalid after that.
+ *
+ * @ingroup xcb__image_t
+ */
+xcb_image_t *
+xcb_image_shm_get_auto (xcb_connection_t *       conn,
+			xcb_drawable_t           draw,
+			int16_t                  x,
+			int16_t                  y,
+			uint16_t                 width,
+			uint16_t                 height,
+			uint32_t                 plane_mask,
+			xcb_image_format_t       format,
+			xcb_shm_segment_info_t * shminfo);
+
+
+/**
+ * Release an image obtained with @ref xcb_image_shm_get_auto().
+ * @param conn The connection to the X server.
+ * @param image The image to destroy; may be 0.
+ * @param shminfo The segment info filled in by @ref xcb_image_shm_get_auto().
+ *
+ * Detaches and unmaps the shared memory segment if one was used, then
+ * destroys the image.  Safe to call for images that came from the
+ * wire fallback path as well.
+ *
+ * @ingroup xcb__image_t
+ */
+void
+xcb_image_shm_release (xcb_connection_t *       conn,
+		       xcb_image_t *            image,
+		       xcb_shm_segment_info_t * shminfo);
+
+
 /**
  * Create an image from user-supplied bitmap data.
  * @param data Image data in packed bitmap format.
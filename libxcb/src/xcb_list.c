@@ -23,7 +23,9 @@
  * authorization from the authors.
  */
 
-/* A generic implementation of a list of void-pointers. */
+/* A hash map of void-pointers keyed on 64-bit sequence numbers. Sequence
+ * numbers are consecutive, so the low bits index the bucket table evenly
+ * and put/remove stay O(1) no matter how many requests are in flight. */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -36,68 +38,111 @@
 
 typedef struct node {
     struct node *next;
-    unsigned int key;
+    uint64_t key;
     void *data;
 } node;
 
 struct _xcb_map {
-    node *head;
-    node **tail;
+    node **buckets;
+    unsigned int nbuckets; /* always a power of two */
+    unsigned int count;
 };
 
+#define XCB_MAP_INITIAL_BUCKETS 64
+
+static node **get_bucket(_xcb_map *map, uint64_t key)
+{
+    return &map->buckets[key & (map->nbuckets - 1)];
+}
+
+/* Double the bucket table once the load factor reaches 1. Growth is best
+ * effort: if the new table can't be allocated the old one keeps working,
+ * just with longer chains. */
+static void grow_map(_xcb_map *map)
+{
+    node **buckets = calloc(map->nbuckets * 2, sizeof(node *));
+    node *cur, *next;
+    unsigned int i, old_nbuckets = map->nbuckets;
+    node **old_buckets = map->buckets;
+    if(!buckets)
+        return;
+    map->buckets = buckets;
+    map->nbuckets = old_nbuckets * 2;
+    for(i = 0; i < old_nbuckets; ++i)
+        for(cur = old_buckets[i]; cur; cur = next)
+        {
+            node **head = get_bucket(map, cur->key);
+            next = cur->next;
+            cur->next = *head;
+            *head = cur;
+        }
+    free(old_buckets);
+}
+
 /* Private interface */
 
 _xcb_map *_xcb_map_new(void)
 {
-    _xcb_map *list;
-    list = malloc(sizeof(_xcb_map));
-    if(!list)
+    _xcb_map *map;
+    map = malloc(sizeof(_xcb_map));
+    if(!map)
+        return 0;
+    map->buckets = calloc(XCB_MAP_INITIAL_BUCKETS, sizeof(node *));
+    if(!map->buckets)
+    {
+        free(map);
         return 0;
-    list->head = 0;
-    list->tail = &list->head;
-    return list;
+    }
+    map->nbuckets = XCB_MAP_INITIAL_BUCKETS;
+    map->count = 0;
+    return map;
 }
 
-void _xcb_map_delete(_xcb_map *list, xcb_list_free_func_t do_free)
+void _xcb_map_delete(_xcb_map *map, xcb_list_free_func_t do_free)
 {
-    if(!list)
+    unsigned int i;
+    if(!map)
         return;
-    while(list->head)
-    {
-        node *cur = list->head;
-        if(do_free)
-            do_free(cur->data);
-        list->head = cur->next;
-        free(cur);
-    }
-    free(list);
+    for(i = 0; i < map->nbuckets; ++i)
+        while(map->buckets[i])
+        {
+            node *cur = map->buckets[i];
+            if(do_free)
+                do_free(cur->data);
+            map->buckets[i] = cur->next;
+            free(cur);
+        }
+    free(map->buckets);
+    free(map);
 }
 
-int _xcb_map_put(_xcb_map *list, unsigned int key, void *data)
+int _xcb_map_put(_xcb_map *map, uint64_t key, void *data)
 {
+    node **head;
     node *cur = malloc(sizeof(node));
     if(!cur)
         return 0;
+    if(map->count >= map->nbuckets)
+        grow_map(map);
     cur->key = key;
     cur->data = data;
-    cur->next = 0;
-    *list->tail = cur;
-    list->tail = &cur->next;
+    head = get_bucket(map, key);
+    cur->next = *head;
+    *head = cur;
+    ++map->count;
     return 1;
 }
 
-void *_xcb_map_remove(_xcb_map *list, unsigned int key)
+void *_xcb_map_remove(_xcb_map *map, uint64_t key)
 {
     node **cur;
-    for(cur = &list->head; *cur; cur = &(*cur)->next)
+    for(cur = get_bucket(map, key); *cur; cur = &(*cur)->next)
         if((*cur)->key == key)
         {
             node *tmp = *cur;
             void *ret = (*cur)->data;
             *cur = (*cur)->next;
-            if(!*cur)
-                list->tail = cur;
-
+            --map->count;
             free(tmp);
             return ret;
         }
@@ -51,16 +51,40 @@ static __inline void send_request(xcb_connection_t *c, int isvoid, enum workarou
     if(workaround != WORKAROUND_NONE || flags != 0)
         _xcb_in_expect_reply(c, c->out.request, workaround, flags);
 
-    while(count && c->out.queue_len + vector[0].iov_len <= sizeof(c->out.queue))
+    for(;;)
     {
-        memcpy(c->out.queue + c->out.queue_len, vector[0].iov_base, vector[0].iov_len);
-        c->out.queue_len += vector[0].iov_len;
-        vector[0].iov_base = (char *) vector[0].iov_base + vector[0].iov_len;
-        vector[0].iov_len = 0;
-        ++vector, --count;
+        while(count && c->out.queue_len + vector[0].iov_len <= (size_t) c->out.queue_size)
+        {
+            memcpy(c->out.queue + c->out.queue_len, vector[0].iov_base, vector[0].iov_len);
+            c->out.queue_len += vector[0].iov_len;
+            vector[0].iov_base = (char *) vector[0].iov_base + vector[0].iov_len;
+            vector[0].iov_len = 0;
+            ++vector, --count;
+        }
+        if(!count)
+            return;
+        /* Grow the buffer (up to XCB_QUEUE_BUFFER_MAX) for storms of small
+         * requests so they keep coalescing into one write; larger chunks
+         * are cheaper to chain zero-copy below than to copy here. */
+        if(vector[0].iov_len < XCB_QUEUE_BUFFER_SIZE &&
+           c->out.queue_size < XCB_QUEUE_BUFFER_MAX)
+        {
+            int size = c->out.queue_size;
+            char *queue;
+            while(c->out.queue_len + vector[0].iov_len > (size_t) size)
+                size <<= 1;
+            if(size > XCB_QUEUE_BUFFER_MAX)
+                size = XCB_QUEUE_BUFFER_MAX;
+            queue = realloc(c->out.queue, size);
+            if(queue)
+            {
+                c->out.queue = queue;
+                c->out.queue_size = size;
+                continue;
+            }
+        }
+        break;
     }
-    if(!count)
-        return;
 
     --vector, ++count;
     vector[0].iov_base = c->out.queue;
@@ -415,7 +439,35 @@ int xcb_flush(xcb_connection_t *c)
     if(c->has_error)
         return 0;
     pthread_mutex_lock(&c->iolock);
-    ret = _xcb_out_flush_to(c, c->out.request);
+    /* While corked, flushes are deferred until xcb_uncork so bracketed
+     * bursts coalesce; reads still flush internally as needed, so waiting
+     * for a reply cannot deadlock. */
+    if(c->out.cork_depth)
+        ret = 1;
+    else
+        ret = _xcb_out_flush_to(c, c->out.request);
+    pthread_mutex_unlock(&c->iolock);
+    return ret;
+}
+
+int xcb_cork(xcb_connection_t *c)
+{
+    if(c->has_error)
+        return 0;
+    pthread_mutex_lock(&c->iolock);
+    ++c->out.cork_depth;
+    pthread_mutex_unlock(&c->iolock);
+    return 1;
+}
+
+int xcb_uncork(xcb_connection_t *c)
+{
+    int ret = 1;
+    if(c->has_error)
+        return 0;
+    pthread_mutex_lock(&c->iolock);
+    if(c->out.cork_depth && !--c->out.cork_depth)
+        ret = _xcb_out_flush_to(c, c->out.request);
     pthread_mutex_unlock(&c->iolock);
     return ret;
 }
@@ -434,7 +486,12 @@ int _xcb_out_init(_xcb_out *out)
         return 0;
     out->writing = 0;
 
+    out->queue = malloc(XCB_QUEUE_BUFFER_SIZE);
+    if(!out->queue)
+        return 0;
+    out->queue_size = XCB_QUEUE_BUFFER_SIZE;
     out->queue_len = 0;
+    out->cork_depth = 0;
 
     out->request = 0;
     out->request_written = 0;
@@ -450,6 +507,7 @@ void _xcb_out_destroy(_xcb_out *out)
 {
     pthread_cond_destroy(&out->cond);
     pthread_mutex_destroy(&out->reqlenlock);
+    free(out->queue);
 }
 
 int _xcb_out_send(xcb_connection_t *c, struct iovec *vector, int count)
@@ -41,6 +41,17 @@
 
 #ifdef _WIN32
 #include "xcb_windefs.h"
+/* Windows 10 1803 and later support AF_UNIX stream sockets.  The
+   <afunix.h> header is missing from older SDKs, so declare the address
+   structure ourselves; on older systems socket(AF_UNIX) fails and we
+   fall back to TCP below. */
+#ifndef UNIX_PATH_MAX
+#define UNIX_PATH_MAX 108
+struct sockaddr_un {
+    ADDRESS_FAMILY sun_family;
+    char sun_path[UNIX_PATH_MAX];
+};
+#endif
 #else
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -223,9 +234,7 @@ int xcb_parse_display(const char *name, char **host, int *displayp,
 }
 
 static int _xcb_open_tcp(const char *host, char *protocol, const unsigned short port);
-#ifndef _WIN32
 static int _xcb_open_unix(char *protocol, const char *file);
-#endif /* !WIN32 */
 #ifdef HAVE_ABSTRACT_SOCKETS
 static int _xcb_open_abstract(char *protocol, const char *file, size_t filelen);
 #endif
@@ -252,7 +261,6 @@ static int _xcb_open(const char *host, char *protocol, const int display)
         return _xcb_open_tcp(host, protocol, port);
     }
 
-#ifndef _WIN32
 #if defined(HAVE_TSOL_LABEL_H) && defined(HAVE_IS_SYSTEM_LABELED)
     /* Check special path for Unix sockets under Solaris Trusted Extensions */
     if (is_system_labeled())
@@ -310,8 +318,6 @@ static int _xcb_open(const char *host, char *protocol, const int display)
     }
 
     return fd;
-#endif /* !_WIN32 */
-    return -1; /* if control reaches here then something has gone wrong */
 }
 
 static int _xcb_socket(int family, int type, int proto)
@@ -452,7 +458,6 @@ static int _xcb_open_tcp(const char *host, char *protocol, const unsigned short
 #endif
 }
 
-#ifndef _WIN32
 static int _xcb_open_unix(char *protocol, const char *file)
 {
     int fd;
@@ -463,6 +468,8 @@ static int _xcb_open_unix(char *protocol, const char *file)
     if (protocol && strcmp("unix",protocol))
         return -1;
 
+    if (strlen(file) >= sizeof(addr.sun_path))
+        return -1;
     strcpy(addr.sun_path, file);
     addr.sun_family = AF_UNIX;
 #ifdef HAVE_SOCKADDR_SUN_LEN
@@ -471,10 +478,10 @@ static int _xcb_open_unix(char *protocol, const char *file)
     fd = _xcb_socket(AF_UNIX, SOCK_STREAM, 0);
     if(fd == -1)
         return -1;
-    if(getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &val, &len) == 0 && val < 64 * 1024)
+    if(getsockopt(fd, SOL_SOCKET, SO_SNDBUF, (char *) &val, &len) == 0 && val < 64 * 1024)
     {
         val = 64 * 1024;
-        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &val, sizeof(int));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, (char *) &val, sizeof(int));
     }
     if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
         close(fd);
@@ -482,7 +489,6 @@ static int _xcb_open_unix(char *protocol, const char *file)
     }
     return fd;
 }
-#endif /* !_WIN32 */
 
 #ifdef HAVE_ABSTRACT_SOCKETS
 static int _xcb_open_abstract(char *protocol, const char *file, size_t filelen)
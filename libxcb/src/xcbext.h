@@ -233,6 +233,31 @@ int xcb_take_socket(xcb_connection_t *c, void (*return_socket)(void *closure), v
  */
 int xcb_writev(xcb_connection_t *c, struct iovec *vector, int count, uint64_t requests);
 
+/**
+ * @brief Defer flushes of the outgoing request queue.
+ * @param c The connection to the X server.
+ * @return 1 on success, else 0.
+ *
+ * While a connection is corked, xcb_flush() reports success without
+ * writing, so a burst of requests bracketed by xcb_cork() and
+ * xcb_uncork() is coalesced into as few writes as possible. Corking
+ * only affects explicit flushes: the queue is still written out when it
+ * fills and whenever a reply or event must be waited for, so corked
+ * code cannot deadlock. Calls nest; each xcb_cork() must be paired with
+ * an xcb_uncork().
+ */
+int xcb_cork(xcb_connection_t *c);
+
+/**
+ * @brief Undo one xcb_cork() and flush if the connection is no longer corked.
+ * @param c The connection to the X server.
+ * @return 1 on success, else 0.
+ *
+ * Decrements the cork nesting depth. When the outermost xcb_uncork()
+ * is reached, all queued requests are flushed to the server.
+ */
+int xcb_uncork(xcb_connection_t *c);
+
 
 /* xcb_in.c */
 
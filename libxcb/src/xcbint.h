@@ -73,8 +73,8 @@ typedef struct _xcb_map _xcb_map;
 
 _xcb_map *_xcb_map_new(void);
 void _xcb_map_delete(_xcb_map *q, xcb_list_free_func_t do_free);
-int _xcb_map_put(_xcb_map *q, unsigned int key, void *data);
-void *_xcb_map_remove(_xcb_map *q, unsigned int key);
+int _xcb_map_put(_xcb_map *q, uint64_t key, void *data);
+void *_xcb_map_remove(_xcb_map *q, uint64_t key);
 
 
 /* xcb_out.c */
@@ -89,6 +89,10 @@ typedef struct _xcb_fd {
 } _xcb_fd;
 #endif
 
+/* Cap for adaptive output buffer growth; must be a power-of-two multiple
+ * of XCB_QUEUE_BUFFER_SIZE. */
+#define XCB_QUEUE_BUFFER_MAX (XCB_QUEUE_BUFFER_SIZE * 16)
+
 typedef struct _xcb_out {
     pthread_cond_t cond;
     int writing;
@@ -98,8 +102,10 @@ typedef struct _xcb_out {
     void *socket_closure;
     int socket_moving;
 
-    char queue[XCB_QUEUE_BUFFER_SIZE];
+    char *queue;        /* grows from XCB_QUEUE_BUFFER_SIZE up to XCB_QUEUE_BUFFER_MAX */
+    int queue_size;
     int queue_len;
+    int cork_depth;     /* xcb_cork nesting depth; xcb_flush is deferred while nonzero */
 
     uint64_t request;
     uint64_t request_written;
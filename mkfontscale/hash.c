@@ -35,13 +35,17 @@
 #define LOG2_NUMBUCKETS 10
 #define NUMBUCKETS (1 << LOG2_NUMBUCKETS)
 
+/* Keys are compared with strcasecmp and stored lowercased, so the
+   hash must not see case either, or the same key inserted once in
+   mixed case and once in lower case lands in two buckets. */
 static unsigned
 hash(const char *string)
 {
     int i;
     unsigned u = 0;
     for(i = 0; string[i] != '\0'; i++)
-        u = (u<<5) + (u >> (LOG2_NUMBUCKETS - 5)) + (unsigned char)string[i];
+        u = (u<<5) + (u >> (LOG2_NUMBUCKETS - 5)) +
+            (unsigned char)tolower((unsigned char)string[i]);
     return (u & (NUMBUCKETS - 1));
 }
 
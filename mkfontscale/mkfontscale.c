@@ -58,6 +58,18 @@
 #include "data.h"
 #include "ident.h"
 
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <process.h>
+#define HAVE_SCAN_THREADS 1
+#elif defined(HAVE_PTHREAD)
+#include <pthread.h>
+#define HAVE_SCAN_THREADS 1
+#endif
+
 #define NPREFIX 1024
 
 #ifndef MAXFONTFILENAMELEN
@@ -100,6 +112,7 @@ static const char *outfilename;
 #define countof(_a) (sizeof(_a)/sizeof((_a)[0]))
 
 static int doDirectory(const char*, int, ListPtr);
+static void buildEncodingCache(void);
 static int checkEncoding(FT_Face face, const char *encoding_name);
 static int checkExtraEncoding(FT_Face face, const char *encoding_name, int found);
 static int find_cmap(int type, int pid, int eid, FT_Face face);
@@ -119,10 +132,19 @@ static int doISO10646_1_encoding;
 static int onlyEncodings;
 static ListPtr encodingsToDo;
 static int reencodeLegacy;
+static int incremental;
+static int numThreads = 4;
 static char *encodingPrefix;
 static char *exclusionSuffix;
 static char *ProgramName;
 
+/* FontEncFind mutates libfontenc's global encoding list, so the
+   candidate encodings are resolved once up front; afterwards the
+   scanning threads only read this table. */
+static FontEncPtr *encodingCache;
+static const char **encodingCacheNames;
+static int encodingCacheCount;
+
 static void
 usage(void)
 {
@@ -130,7 +152,7 @@ usage(void)
             "mkfontscale [ -b ] [ -s ] [ -o filename ] [-x suffix ]\n"
             "            [ -a encoding ] [ -f fuzz ] [ -l ]\n"
             "            [ -e directory ] [ -p prefix ] [ -n ] [ -r ] \n"
-            "            [-u] [-U] [-v] [ directory ]...\n");
+            "            [-u] [-U] [-i] [-j threads] [-v] [ directory ]...\n");
     exit(1);
 }
 
@@ -237,6 +259,19 @@ main(int argc, char **argv)
         } else if(strcmp(argv[argn], "-l") == 0) {
             reencodeLegacy = !reencodeLegacy;
             argn++;
+        } else if(strcmp(argv[argn], "-i") == 0) {
+            incremental = 1;
+            argn++;
+        } else if(strcmp(argv[argn], "-j") == 0) {
+            if(argn >= argc - 1) {
+                missing_arg("-j");
+            }
+            numThreads = atoi(argv[argn + 1]);
+            if(numThreads < 1)
+                numThreads = 1;
+            else if(numThreads > 64)
+                numThreads = 64;
+            argn += 2;
         } else if(strcmp(argv[argn], "-o") == 0) {
             if(argn >= argc - 1) {
                 missing_arg("-o");
@@ -270,6 +305,8 @@ main(int argc, char **argv)
         exit(1);
     }
 
+    buildEncodingCache();
+
     ll = listLength(encodingsToDo);
 
     if (argn == argc)
@@ -708,23 +745,13 @@ makeXLFD(char *filename, FT_Face face, int isBitmap)
 }
 
 static int
-readFontScale(HashTablePtr entries, char *dirname)
+readIndexFile(HashTablePtr entries, const char *filename, int prio)
 {
-    size_t n = strlen(dirname);
-    char *filename;
     FILE *in;
     int rc, count, i;
     char file[MAXFONTFILENAMELEN+1], font[MAXFONTNAMELEN+1];
 
-    if(dirname[n - 1] == '/')
-        filename = dsprintf("%sfonts.scale", dirname);
-    else
-        filename = dsprintf("%s/fonts.scale", dirname);
-    if(filename == NULL)
-        return -1;
-
     in = fopen(filename, "r");
-    free(filename);
     if(in == NULL) {
         if(errno != ENOENT)
             perror("open(fonts.scale)");
@@ -733,7 +760,7 @@ readFontScale(HashTablePtr entries, char *dirname)
 
     rc = fscanf(in, "%d\n", &count);
     if(rc != 1) {
-        fprintf(stderr, "Invalid fonts.scale in %s.\n", dirname);
+        fprintf(stderr, "Invalid font index %s.\n", filename);
         fclose(in);
         return -1;
     }
@@ -745,7 +772,54 @@ readFontScale(HashTablePtr entries, char *dirname)
 		    file, font);
         if(rc != 2)
             break;
-        putHash(entries, font, file, 100);
+        putHash(entries, font, file, prio);
+    }
+    fclose(in);
+    return 1;
+}
+
+static int
+readFontScale(HashTablePtr entries, char *dirname)
+{
+    size_t n = strlen(dirname);
+    char *filename;
+    int rc;
+
+    if(dirname[n - 1] == '/')
+        filename = dsprintf("%sfonts.scale", dirname);
+    else
+        filename = dsprintf("%s/fonts.scale", dirname);
+    if(filename == NULL)
+        return -1;
+
+    rc = readIndexFile(entries, filename, 100);
+    free(filename);
+    return rc;
+}
+
+/* The stamp file records `size mtime filename' for every regular file
+   seen on the previous incremental run, including files that turned
+   out not to be fonts, so that those are not re-probed either. */
+static int
+readStampFile(HashTablePtr stamps, const char *filename)
+{
+    FILE *in;
+    unsigned long size, mtime;
+    char file[MAXFONTFILENAMELEN+1];
+
+    in = fopen(filename, "r");
+    if(in == NULL)
+        return -1;
+
+    while(fscanf(in,
+                 "%lu %lu "
+                 "%" STRINGIFY(MAXFONTFILENAMELEN) "[^\n]\n",
+                 &size, &mtime, file) == 3) {
+        char *stamp = dsprintf("%lu %lu", size, mtime);
+        if(stamp) {
+            putHash(stamps, file, stamp, 0);
+            free(stamp);
+        }
     }
     fclose(in);
     return 1;
@@ -784,24 +858,351 @@ filePrio(char *filename)
     return 0;
 }
 
+/* Probing a font file is dominated by FreeType opening and parsing it,
+   which is independent per file, so the files of a directory are
+   claimed one at a time from a shared queue by a small pool of
+   threads.  Each thread uses its own FT_Library and appends what it
+   finds to a per-file result list; the shared hash table is only
+   filled in afterwards, on the main thread, in the same order as the
+   old serial loop so that priority ties resolve identically. */
+
+typedef struct _ScanResult {
+    char *name;
+    char *file;
+    int prio;
+    struct _ScanResult *next;
+} ScanResultRec, *ScanResultPtr;
+
+typedef struct _ScanQueue {
+    const char *dirname;
+    struct dirent **namelist;
+    const unsigned char *skip;  /* incremental: files to leave alone */
+    ScanResultPtr *results;     /* one list per directory entry */
+    int count;
+    int next;
+#ifdef HAVE_SCAN_THREADS
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+#endif
+} ScanQueueRec, *ScanQueuePtr;
+
+#ifdef HAVE_SCAN_THREADS
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#define scanQueueLockInit(q) InitializeCriticalSection(&(q)->lock)
+#define scanQueueLock(q) EnterCriticalSection(&(q)->lock)
+#define scanQueueUnlock(q) LeaveCriticalSection(&(q)->lock)
+#define scanQueueLockDestroy(q) DeleteCriticalSection(&(q)->lock)
+#else
+#define scanQueueLockInit(q) pthread_mutex_init(&(q)->lock, NULL)
+#define scanQueueLock(q) pthread_mutex_lock(&(q)->lock)
+#define scanQueueUnlock(q) pthread_mutex_unlock(&(q)->lock)
+#define scanQueueLockDestroy(q) pthread_mutex_destroy(&(q)->lock)
+#endif
+#else
+#define scanQueueLockInit(q) do {} while(0)
+#define scanQueueLock(q) do {} while(0)
+#define scanQueueUnlock(q) do {} while(0)
+#define scanQueueLockDestroy(q) do {} while(0)
+#endif
+
+static void
+addScanResult(ScanResultPtr *head, const char *name, const char *file,
+              int prio)
+{
+    ScanResultPtr r;
+
+    r = malloc(sizeof(ScanResultRec));
+    if(r == NULL)
+        return;
+    r->name = strdup(name);
+    r->file = strdup(file);
+    r->prio = prio;
+    r->next = NULL;
+    if(r->name == NULL || r->file == NULL) {
+        free(r->name);
+        free(r->file);
+        free(r);
+        return;
+    }
+    while(*head)
+        head = &(*head)->next;
+    *head = r;
+}
+
+static void
+processFile(ScanQueuePtr q, int diri, FT_Library library)
+{
+    struct dirent *entry = q->namelist[diri];
+    char *filename;
+    FT_Error ftrc;
+    FT_Face face = NULL;
+    ConstListPtr encoding;
+    ListPtr xlfd = NULL, lp;
+    int found, rc;
+    int have_face = 0;
+    int isBitmap = 0;
+    char *xlfd_name = NULL;
+    struct stat f_stat;
+    int tprio = 1;
+
+    if(exclusionSuffix) {
+        size_t xl = strlen(exclusionSuffix);
+        size_t dl = strlen(entry->d_name);
+        if(dl >= xl &&
+           strcmp(entry->d_name + dl - xl, exclusionSuffix) == 0)
+            return;
+    }
+
+    filename = dsprintf("%s%s", q->dirname, entry->d_name);
+
+#define PRIO(x) ((x << 1) + tprio)
+#ifdef DT_LNK
+    if (entry->d_type != DT_UNKNOWN) {
+        if (entry->d_type == DT_LNK)
+            tprio = 0;
+    } else
+#endif
+#ifdef S_ISLNK
+    {
+#ifndef WIN32
+        if (lstat(filename, &f_stat))
+            goto done;
+        if (S_ISLNK(f_stat.st_mode))
+            tprio = 0;
+#endif
+    }
+#else
+    ;
+#endif
+    if(doBitmaps)
+        rc = bitmapIdentify(filename, &xlfd_name);
+    else
+        rc = 0;
+
+    if(rc < 0)
+        goto done;
+
+    if(rc == 0) {
+        ftrc = FT_New_Face(library, filename, 0, &face);
+        if(ftrc)
+            goto done;
+        have_face = 1;
+
+        isBitmap = ((face->face_flags & FT_FACE_FLAG_SCALABLE) == 0);
+
+        if(!isBitmap) {
+            /* Workaround for bitmap-only SFNT fonts */
+            if(FT_IS_SFNT(face) && face->num_fixed_sizes > 0 &&
+               strcmp(FT_Get_X11_Font_Format(face), "TrueType") == 0) {
+                TT_MaxProfile *maxp;
+                maxp = FT_Get_Sfnt_Table(face, ft_sfnt_maxp);
+                if(maxp != NULL && maxp->maxContours == 0)
+                    isBitmap = 1;
+            }
+        }
+
+        if(isBitmap) {
+            if(!doBitmaps)
+                goto done;
+        } else {
+            if(!doScalable)
+                goto done;
+        }
+
+        if(isBitmap) {
+            BDF_PropertyRec prop;
+            rc = FT_Get_BDF_Property(face, "FONT", &prop);
+            if(rc == 0 && prop.type == BDF_PROPERTY_TYPE_ATOM) {
+                xlfd_name = strdup(prop.u.atom);
+                if(xlfd_name == NULL)
+                    goto done;
+            }
+        }
+    }
+
+    if(xlfd_name) {
+        /* We know it's a bitmap font, and we know its XLFD */
+        size_t l = strlen(xlfd_name);
+        if(reencodeLegacy &&
+           l >= 12 && strcasecmp(xlfd_name + l - 11, "-iso10646-1") == 0) {
+            char *s;
+
+            s = malloc(l - 10);
+            memcpy(s, xlfd_name, l - 11);
+            s[l - 11] = '\0';
+            xlfd = listCons(s, xlfd);
+        } else {
+            /* Not a reencodable font -- skip all the rest of the loop body */
+            addScanResult(&q->results[diri], xlfd_name, entry->d_name,
+                          PRIO(filePrio(entry->d_name)));
+            goto done;
+        }
+    }
+
+    if(!have_face) {
+        ftrc = FT_New_Face(library, filename, 0, &face);
+        if(ftrc)
+            goto done;
+        have_face = 1;
+        isBitmap = ((face->face_flags & FT_FACE_FLAG_SCALABLE) == 0);
+
+        if(!isBitmap) {
+            if(face->num_fixed_sizes > 0) {
+                TT_MaxProfile *maxp;
+                maxp = FT_Get_Sfnt_Table(face, ft_sfnt_maxp);
+                if(maxp != NULL && maxp->maxContours == 0)
+                    isBitmap = 1;
+            }
+        }
+    }
+
+    if(xlfd == NULL)
+        xlfd = makeXLFD(entry->d_name, face, isBitmap);
+
+    found = 0;
+
+    for(lp = xlfd; lp; lp = lp->next) {
+        char buf[MAXFONTNAMELEN];
+        for(encoding = encodings; encoding; encoding = encoding->next) {
+            if(checkEncoding(face, encoding->value)) {
+                found = 1;
+                snprintf(buf, MAXFONTNAMELEN, "%s-%s",
+                        lp->value, encoding->value);
+                addScanResult(&q->results[diri], buf, entry->d_name,
+                              PRIO(filePrio(entry->d_name)));
+            }
+        }
+        for(encoding = extra_encodings; encoding;
+            encoding = encoding->next) {
+            if(checkExtraEncoding(face, encoding->value, found)) {
+                /* Do not set found! */
+                snprintf(buf, MAXFONTNAMELEN, "%s-%s",
+                        lp->value, encoding->value);
+                addScanResult(&q->results[diri], buf, entry->d_name,
+                              PRIO(filePrio(entry->d_name)));
+            }
+        }
+    }
+ done:
+    if(have_face)
+        FT_Done_Face(face);
+    deepDestroyList(xlfd);
+    free(xlfd_name);
+    free(filename);
+#undef PRIO
+}
+
+static void
+scanWork(ScanQueuePtr q, FT_Library library)
+{
+    for(;;) {
+        int i;
+
+        scanQueueLock(q);
+        i = q->next++;
+        scanQueueUnlock(q);
+        if(i >= q->count)
+            break;
+        if(q->skip && q->skip[i])
+            continue;
+        processFile(q, i, library);
+    }
+}
+
+#ifdef HAVE_SCAN_THREADS
+#if defined(_MSC_VER) || defined(__MINGW32__)
+static unsigned int __stdcall
+scanThread(void *arg)
+#else
+static void *
+scanThread(void *arg)
+#endif
+{
+    ScanQueuePtr q = arg;
+    FT_Library library;
+
+    if(FT_Init_FreeType(&library) == 0) {
+        scanWork(q, library);
+        FT_Done_FreeType(library);
+    }
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+#endif
+
+static void
+scanFiles(ScanQueuePtr q)
+{
+#ifdef HAVE_SCAN_THREADS
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    HANDLE *threads;
+#else
+    pthread_t *threads;
+#endif
+    int nthreads = 0;
+    int i;
+
+    scanQueueLockInit(q);
+
+    threads = numThreads > 1 ?
+        malloc((numThreads - 1) * sizeof(*threads)) : NULL;
+
+    /* the calling thread works too, so one thread fewer than files */
+    if(threads) {
+        while(nthreads < numThreads - 1 && nthreads < q->count - 1) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+            threads[nthreads] = (HANDLE)_beginthreadex(NULL, 0, scanThread,
+                                                       q, 0, NULL);
+            if(!threads[nthreads])
+                break;
+#else
+            if(pthread_create(&threads[nthreads], NULL, scanThread, q) != 0)
+                break;
+#endif
+            nthreads++;
+        }
+    }
+
+    scanWork(q, ft_library);
+
+    for(i = 0; i < nthreads; i++) {
+#if defined(_MSC_VER) || defined(__MINGW32__)
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+    free(threads);
+    scanQueueLockDestroy(q);
+#else
+    scanWork(q, ft_library);
+#endif
+}
+
 static int
 doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
 {
     char *dirname, *fontscale_name, *filename, *encdir;
     FILE *fontscale, *encfile;
     struct dirent** namelist;
-    FT_Error ftrc;
-    FT_Face face;
-    ConstListPtr encoding;
-    ListPtr xlfd, lp;
+    ListPtr lp;
     HashTablePtr entries;
+    HashTablePtr oldEntries = NULL, oldStamps = NULL, unchanged = NULL;
     HashBucketPtr *array;
-    int i, n, dirn, diri, found, rc;
-    int isBitmap=0;
-    size_t d, xl=0;
-
-    if (exclusionSuffix)
-        xl = strlen (exclusionSuffix);
+    ScanQueueRec queue;
+    ScanResultPtr r, rnext;
+    char *stamp_name = NULL;
+    char **stamps = NULL;
+    unsigned char *skip = NULL;
+    int i, n, dirn, diri;
+    size_t d;
 
     d = strlen(dirname_given);
     if(d == 0)
@@ -844,6 +1245,45 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
         return 0;
     }
 
+    /* the old index must be read before it is truncated for writing */
+    if(incremental && fontscale_name) {
+        struct stat f_stat;
+
+        oldEntries = makeHashTable();
+        if(readIndexFile(oldEntries, fontscale_name, 0) < 0) {
+            destroyHashTable(oldEntries);
+            oldEntries = NULL;
+        }
+
+        stamp_name = dsprintf("%s.stamp", fontscale_name);
+        oldStamps = makeHashTable();
+        if(stamp_name)
+            readStampFile(oldStamps, stamp_name);
+
+        unchanged = makeHashTable();
+        skip = calloc(dirn, 1);
+        stamps = calloc(dirn, sizeof(char*));
+
+        for(diri = 0; diri < dirn && skip && stamps; diri++) {
+            filename = dsprintf("%s%s", dirname, namelist[diri]->d_name);
+            if(filename == NULL)
+                continue;
+            if(stat(filename, &f_stat) == 0 && S_ISREG(f_stat.st_mode)) {
+                char *old;
+                stamps[diri] = dsprintf("%lu %lu",
+                                        (unsigned long)f_stat.st_size,
+                                        (unsigned long)f_stat.st_mtime);
+                old = getHash(oldStamps, namelist[diri]->d_name);
+                if(oldEntries && old && stamps[diri] &&
+                   strcmp(old, stamps[diri]) == 0) {
+                    skip[diri] = 1;
+                    putHash(unchanged, namelist[diri]->d_name, "", 0);
+                }
+            }
+            free(filename);
+        }
+    }
+
     if(fontscale_name == NULL)
         fontscale = stdout;
     else
@@ -855,156 +1295,68 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
         return 0;
     }
 
-    for(diri = dirn - 1; diri >= 0; diri--) {
-        struct dirent *entry = namelist[diri];
-        int have_face = 0;
-        char *xlfd_name = NULL;
-	struct stat f_stat;
-	int tprio = 1;
-
-        xlfd = NULL;
-
-	if (xl) {
-	    size_t dl = strlen (entry->d_name);
-	    if (strcmp (entry->d_name + dl - xl, exclusionSuffix) == 0)
-		continue;
-	}
-
-        filename = dsprintf("%s%s", dirname, entry->d_name);
+    queue.dirname = dirname;
+    queue.namelist = namelist;
+    queue.skip = skip;
+    queue.results = calloc(dirn, sizeof(ScanResultPtr));
+    queue.count = queue.results ? dirn : 0;
+    queue.next = 0;
 
-#define PRIO(x) ((x << 1) + tprio)
-#ifdef DT_LNK
-	if (entry->d_type != DT_UNKNOWN) {
-	    if (entry->d_type == DT_LNK)
-		tprio = 0;
-	} else
-#endif
-#ifdef S_ISLNK
-	{
-#ifndef WIN32
-	    if (lstat(filename, &f_stat))
-		goto done;
-	    if (S_ISLNK(f_stat.st_mode))
-		tprio = 0;
-#endif
-	}
-#else
-	;
-#endif
-        if(doBitmaps)
-            rc = bitmapIdentify(filename, &xlfd_name);
-        else
-            rc = 0;
-
-        if(rc < 0)
-            goto done;
+    if(queue.count > 0)
+        scanFiles(&queue);
 
-        if(rc == 0) {
-            ftrc = FT_New_Face(ft_library, filename, 0, &face);
-            if(ftrc)
-                goto done;
-            have_face = 1;
-
-            isBitmap = ((face->face_flags & FT_FACE_FLAG_SCALABLE) == 0);
-
-            if(!isBitmap) {
-                /* Workaround for bitmap-only SFNT fonts */
-                if(FT_IS_SFNT(face) && face->num_fixed_sizes > 0 &&
-                   strcmp(FT_Get_X11_Font_Format(face), "TrueType") == 0) {
-                    TT_MaxProfile *maxp;
-                    maxp = FT_Get_Sfnt_Table(face, ft_sfnt_maxp);
-                    if(maxp != NULL && maxp->maxContours == 0)
-                        isBitmap = 1;
-                }
-            }
-
-            if(isBitmap) {
-                if(!doBitmaps)
-                    goto done;
-            } else {
-                if(!doScalable)
-                    goto done;
-            }
-
-            if(isBitmap) {
-                BDF_PropertyRec prop;
-                rc = FT_Get_BDF_Property(face, "FONT", &prop);
-                if(rc == 0 && prop.type == BDF_PROPERTY_TYPE_ATOM) {
-                    xlfd_name = strdup(prop.u.atom);
-                    if(xlfd_name == NULL)
-                        goto done;
-                }
-            }
-        }
-
-        if(xlfd_name) {
-            /* We know it's a bitmap font, and we know its XLFD */
-            size_t l = strlen(xlfd_name);
-            if(reencodeLegacy &&
-               l >= 12 && strcasecmp(xlfd_name + l - 11, "-iso10646-1") == 0) {
-                char *s;
-
-                s = malloc(l - 10);
-                memcpy(s, xlfd_name, l - 11);
-                s[l - 11] = '\0';
-                xlfd = listCons(s, xlfd);
-            } else {
-                /* Not a reencodable font -- skip all the rest of the loop body */
-                putHash(entries, xlfd_name, entry->d_name, PRIO(filePrio(entry->d_name)));
-                goto done;
-            }
+    /* insert in the old reverse-alphabetical order so that priority
+       ties pick the same file as the serial scan did */
+    for(diri = dirn - 1; diri >= 0; diri--) {
+        for(r = queue.results ? queue.results[diri] : NULL; r; r = rnext) {
+            rnext = r->next;
+            putHash(entries, r->name, r->file, r->prio);
+            free(r->name);
+            free(r->file);
+            free(r);
         }
+    }
+    free(queue.results);
+
+    if(oldEntries) {
+        /* carry over the entries of files whose size and mtime are
+           unchanged since the stamp file was written */
+        int oldn = hashElements(oldEntries);
+        /* hashArray consumes the table */
+        HashBucketPtr *oldarray = hashArray(oldEntries, 0);
+        oldEntries = NULL;
+        for(i = 0; oldarray && i < oldn; i++)
+            if(getHash(unchanged, oldarray[i]->value))
+                putHash(entries, oldarray[i]->key, oldarray[i]->value,
+                        (filePrio(oldarray[i]->value) << 1) + 1);
+        if(oldarray)
+            destroyHashArray(oldarray);
+    }
 
-        if(!have_face) {
-            ftrc = FT_New_Face(ft_library, filename, 0, &face);
-            if(ftrc)
-                goto done;
-            have_face = 1;
-            isBitmap = ((face->face_flags & FT_FACE_FLAG_SCALABLE) == 0);
-
-            if(!isBitmap) {
-                if(face->num_fixed_sizes > 0) {
-                    TT_MaxProfile *maxp;
-                    maxp = FT_Get_Sfnt_Table(face, ft_sfnt_maxp);
-                    if(maxp != NULL && maxp->maxContours == 0)
-                        isBitmap = 1;
-                }
-            }
+    if(incremental && fontscale_name && stamps) {
+        FILE *stampfile = stamp_name ? fopen(stamp_name, "w") : NULL;
+        if(stampfile) {
+            for(diri = 0; diri < dirn; diri++)
+                if(stamps[diri])
+                    fprintf(stampfile, "%s %s\n",
+                            stamps[diri], namelist[diri]->d_name);
+            fclose(stampfile);
         }
+    }
 
-        if(xlfd == NULL)
-            xlfd = makeXLFD(entry->d_name, face, isBitmap);
-
-        found = 0;
-
-        for(lp = xlfd; lp; lp = lp->next) {
-            char buf[MAXFONTNAMELEN];
-            for(encoding = encodings; encoding; encoding = encoding->next) {
-                if(checkEncoding(face, encoding->value)) {
-                    found = 1;
-                    snprintf(buf, MAXFONTNAMELEN, "%s-%s",
-                            lp->value, encoding->value);
-                    putHash(entries, buf, entry->d_name, PRIO(filePrio(entry->d_name)));
-                }
-            }
-            for(encoding = extra_encodings; encoding;
-                encoding = encoding->next) {
-                if(checkExtraEncoding(face, encoding->value, found)) {
-                    /* Do not set found! */
-                    snprintf(buf, MAXFONTNAMELEN, "%s-%s",
-                            lp->value, encoding->value);
-                    putHash(entries, buf, entry->d_name, PRIO(filePrio(entry->d_name)));
-                }
-            }
-        }
-    done:
-        if(have_face)
-            FT_Done_Face(face);
-        deepDestroyList(xlfd);
-        xlfd = NULL;
-        free(filename);
-#undef PRIO
+    if(stamps) {
+        for(diri = 0; diri < dirn; diri++)
+            free(stamps[diri]);
+        free(stamps);
     }
+    free(skip);
+    free(stamp_name);
+    if(oldEntries)
+        destroyHashTable(oldEntries);
+    if(oldStamps)
+        destroyHashTable(oldStamps);
+    if(unchanged)
+        destroyHashTable(unchanged);
 
     while(dirn--)
         free(namelist[dirn]);
@@ -1052,6 +1404,45 @@ doDirectory(const char *dirname_given, int numEncodings, ListPtr encodingsToDo)
                          ((c) >= 0x7F && (c) <= 0xA0) || \
                          (c) == 0xAD || (c) == 0xF71B)
 
+static void
+buildEncodingCache(void)
+{
+    ConstListPtr enc;
+    int i = 0;
+
+    for(enc = encodings; enc; enc = enc->next)
+        encodingCacheCount++;
+
+    encodingCache = malloc(encodingCacheCount * sizeof(FontEncPtr));
+    encodingCacheNames =
+        malloc(encodingCacheCount * sizeof(const char *));
+    if(encodingCache == NULL || encodingCacheNames == NULL) {
+        free(encodingCache);
+        free(encodingCacheNames);
+        encodingCache = NULL;
+        encodingCacheNames = NULL;
+        encodingCacheCount = 0;
+        return;
+    }
+
+    for(enc = encodings; enc; enc = enc->next) {
+        encodingCacheNames[i] = enc->value;
+        encodingCache[i] = FontEncFind(enc->value, NULL);
+        i++;
+    }
+}
+
+static FontEncPtr
+cachedFontEncFind(const char *encoding_name)
+{
+    int i;
+
+    for(i = 0; i < encodingCacheCount; i++)
+        if(strcasecmp(encodingCacheNames[i], encoding_name) == 0)
+            return encodingCache[i];
+    return FontEncFind(encoding_name, NULL);
+}
+
 static int
 checkEncoding(FT_Face face, const char *encoding_name)
 {
@@ -1060,7 +1451,7 @@ checkEncoding(FT_Face face, const char *encoding_name)
     int i, j, c, koi8;
     char *n;
 
-    encoding = FontEncFind(encoding_name, NULL);
+    encoding = cachedFontEncFind(encoding_name);
     if(!encoding)
         return 0;
 
@@ -0,0 +1,584 @@
+/*
+ * Copyright © 2008 Rodrigo Kumpera
+ * Copyright © 2008 André Tupinambá
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Red Hat not be used in advertising or
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.  Red Hat makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * AVX2 versions of the highest-traffic SSE2 operations; everything not
+ * implemented here falls through to the SSE2 implementation below us in
+ * the chain.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <immintrin.h>
+
+#include "pixman-private.h"
+#include "pixman-combine32.h"
+#include "pixman-inlines.h"
+
+static force_inline __m256i
+load_256_unaligned (const __m256i *src)
+{
+    return _mm256_loadu_si256 (src);
+}
+
+static force_inline __m256i
+load_256_aligned (const __m256i *src)
+{
+    return _mm256_load_si256 (src);
+}
+
+static force_inline void
+save_256_aligned (__m256i *dst, __m256i data)
+{
+    _mm256_store_si256 (dst, data);
+}
+
+static force_inline int
+is_opaque_256 (__m256i x)
+{
+    __m256i ffs = _mm256_cmpeq_epi8 (x, x);
+
+    return (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, ffs)) & 0x88888888) ==
+	0x88888888;
+}
+
+static force_inline int
+is_zero_256 (__m256i x)
+{
+    return _mm256_movemask_epi8 (
+	_mm256_cmpeq_epi8 (x, _mm256_setzero_si256 ())) == 0xffffffff;
+}
+
+/* The 2x256 helpers work on 16-bit-expanded pixel channels, exactly
+ * like their 2x128 SSE2 counterparts; unpack/pack operate lane-wise,
+ * which is fine because unpack and pack mirror each other.
+ */
+static force_inline void
+unpack_256_2x256 (__m256i data, __m256i *data_lo, __m256i *data_hi)
+{
+    *data_lo = _mm256_unpacklo_epi8 (data, _mm256_setzero_si256 ());
+    *data_hi = _mm256_unpackhi_epi8 (data, _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+pack_2x256_256 (__m256i lo, __m256i hi)
+{
+    return _mm256_packus_epi16 (lo, hi);
+}
+
+static force_inline void
+expand_alpha_2x256 (__m256i data_lo, __m256i data_hi,
+		    __m256i *alpha_lo, __m256i *alpha_hi)
+{
+    __m256i lo, hi;
+
+    lo = _mm256_shufflelo_epi16 (data_lo, _MM_SHUFFLE (3, 3, 3, 3));
+    hi = _mm256_shufflelo_epi16 (data_hi, _MM_SHUFFLE (3, 3, 3, 3));
+
+    *alpha_lo = _mm256_shufflehi_epi16 (lo, _MM_SHUFFLE (3, 3, 3, 3));
+    *alpha_hi = _mm256_shufflehi_epi16 (hi, _MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline void
+pix_multiply_2x256 (__m256i *data_lo, __m256i *data_hi,
+		    __m256i *alpha_lo, __m256i *alpha_hi,
+		    __m256i *ret_lo, __m256i *ret_hi)
+{
+    __m256i lo, hi;
+    __m256i mask_0080 = _mm256_set1_epi16 (0x0080);
+    __m256i mask_0101 = _mm256_set1_epi16 (0x0101);
+
+    lo = _mm256_mullo_epi16 (*data_lo, *alpha_lo);
+    hi = _mm256_mullo_epi16 (*data_hi, *alpha_hi);
+    lo = _mm256_adds_epu16 (lo, mask_0080);
+    hi = _mm256_adds_epu16 (hi, mask_0080);
+    *ret_lo = _mm256_mulhi_epu16 (lo, mask_0101);
+    *ret_hi = _mm256_mulhi_epu16 (hi, mask_0101);
+}
+
+static force_inline void
+negate_2x256 (__m256i data_lo, __m256i data_hi,
+	      __m256i *neg_lo, __m256i *neg_hi)
+{
+    __m256i mask_00ff = _mm256_set1_epi16 (0x00ff);
+
+    *neg_lo = _mm256_xor_si256 (data_lo, mask_00ff);
+    *neg_hi = _mm256_xor_si256 (data_hi, mask_00ff);
+}
+
+static force_inline void
+over_2x256 (__m256i *src_lo, __m256i *src_hi,
+	    __m256i *alpha_lo, __m256i *alpha_hi,
+	    __m256i *dst_lo, __m256i *dst_hi)
+{
+    __m256i t1, t2;
+
+    negate_2x256 (*alpha_lo, *alpha_hi, &t1, &t2);
+
+    pix_multiply_2x256 (dst_lo, dst_hi, &t1, &t2, dst_lo, dst_hi);
+
+    *dst_lo = _mm256_adds_epu8 (*src_lo, *dst_lo);
+    *dst_hi = _mm256_adds_epu8 (*src_hi, *dst_hi);
+}
+
+static force_inline uint32_t
+core_combine_over_u_pixel (uint32_t src, uint32_t dst)
+{
+    uint8_t a = src >> 24;
+
+    if (a == 0xff)
+	return src;
+    else if (src)
+	UN8x4_MUL_UN8_ADD_UN8x4 (dst, (~a & MASK), src);
+
+    return dst;
+}
+
+static force_inline void
+core_combine_over_u_avx2_no_mask (uint32_t *	   pd,
+				  const uint32_t * ps,
+				  int		   w)
+{
+    uint32_t s, d;
+
+    /* Align dst on a 32-byte boundary */
+    while (w && ((uintptr_t)pd & 31))
+    {
+	d = *pd;
+	s = *ps;
+
+	if (s)
+	    *pd = core_combine_over_u_pixel (s, d);
+	pd++;
+	ps++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m256i src;
+	__m256i src_hi, src_lo, dst_hi, dst_lo;
+	__m256i alpha_hi, alpha_lo;
+
+	src = load_256_unaligned ((__m256i *)ps);
+
+	if (!is_zero_256 (src))
+	{
+	    if (is_opaque_256 (src))
+	    {
+		save_256_aligned ((__m256i *)pd, src);
+	    }
+	    else
+	    {
+		__m256i dst = load_256_aligned ((__m256i *)pd);
+
+		unpack_256_2x256 (src, &src_lo, &src_hi);
+		unpack_256_2x256 (dst, &dst_lo, &dst_hi);
+
+		expand_alpha_2x256 (src_lo, src_hi,
+				    &alpha_lo, &alpha_hi);
+		over_2x256 (&src_lo, &src_hi, &alpha_lo, &alpha_hi,
+			    &dst_lo, &dst_hi);
+
+		save_256_aligned (
+		    (__m256i *)pd,
+		    pack_2x256_256 (dst_lo, dst_hi));
+	    }
+	}
+
+	ps += 8;
+	pd += 8;
+	w -= 8;
+    }
+    while (w)
+    {
+	d = *pd;
+	s = *ps;
+
+	if (s)
+	    *pd = core_combine_over_u_pixel (s, d);
+	pd++;
+	ps++;
+
+	w--;
+    }
+}
+
+static force_inline void
+core_combine_over_u_avx2_mask (uint32_t *	  pd,
+			       const uint32_t *	  ps,
+			       const uint32_t *	  pm,
+			       int		  w)
+{
+    uint32_t s, d, m;
+
+    /* Align dst on a 32-byte boundary */
+    while (w && ((uintptr_t)pd & 31))
+    {
+	d = *pd;
+	s = *ps;
+	m = *pm >> 24;
+
+	if (m)
+	{
+	    if (m != 0xff)
+		UN8x4_MUL_UN8 (s, m);
+	    *pd = core_combine_over_u_pixel (s, d);
+	}
+	pd++;
+	ps++;
+	pm++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m256i mask = load_256_unaligned ((__m256i *)pm);
+
+	if (!is_zero_256 (mask))
+	{
+	    __m256i src;
+	    __m256i src_hi, src_lo;
+	    __m256i mask_hi, mask_lo;
+	    __m256i alpha_hi, alpha_lo;
+
+	    src = load_256_unaligned ((__m256i *)ps);
+
+	    if (is_opaque_256 (_mm256_and_si256 (src, mask)))
+	    {
+		save_256_aligned ((__m256i *)pd, src);
+	    }
+	    else
+	    {
+		__m256i dst = load_256_aligned ((__m256i *)pd);
+		__m256i dst_hi, dst_lo;
+
+		unpack_256_2x256 (mask, &mask_lo, &mask_hi);
+		unpack_256_2x256 (src, &src_lo, &src_hi);
+
+		expand_alpha_2x256 (mask_lo, mask_hi, &mask_lo, &mask_hi);
+		pix_multiply_2x256 (&src_lo, &src_hi,
+				    &mask_lo, &mask_hi,
+				    &src_lo, &src_hi);
+
+		unpack_256_2x256 (dst, &dst_lo, &dst_hi);
+
+		expand_alpha_2x256 (src_lo, src_hi,
+				    &alpha_lo, &alpha_hi);
+
+		over_2x256 (&src_lo, &src_hi, &alpha_lo, &alpha_hi,
+			    &dst_lo, &dst_hi);
+
+		save_256_aligned (
+		    (__m256i *)pd,
+		    pack_2x256_256 (dst_lo, dst_hi));
+	    }
+	}
+
+	pm += 8;
+	ps += 8;
+	pd += 8;
+	w -= 8;
+    }
+    while (w)
+    {
+	d = *pd;
+	s = *ps;
+	m = *pm >> 24;
+
+	if (m)
+	{
+	    if (m != 0xff)
+		UN8x4_MUL_UN8 (s, m);
+	    *pd = core_combine_over_u_pixel (s, d);
+	}
+	pd++;
+	ps++;
+	pm++;
+
+	w--;
+    }
+}
+
+static void
+avx2_combine_over_u (pixman_implementation_t *imp,
+		     pixman_op_t	      op,
+		     uint32_t *		      pd,
+		     const uint32_t *	      ps,
+		     const uint32_t *	      pm,
+		     int		      w)
+{
+    if (pm)
+	core_combine_over_u_avx2_mask (pd, ps, pm, w);
+    else
+	core_combine_over_u_avx2_no_mask (pd, ps, w);
+}
+
+static void
+avx2_combine_add_u (pixman_implementation_t *imp,
+		    pixman_op_t		     op,
+		    uint32_t *		     dst,
+		    const uint32_t *	     src,
+		    const uint32_t *	     mask,
+		    int			     width)
+{
+    int w = width;
+    uint32_t s, d;
+    uint32_t *pd = dst;
+    const uint32_t *ps = src;
+    const uint32_t *pm = mask;
+
+    if (pm)
+    {
+	while (w--)
+	{
+	    s = *ps++;
+	    if (s)
+	    {
+		uint32_t m = *pm >> 24;
+
+		if (m != 0xff)
+		    UN8x4_MUL_UN8 (s, m);
+		d = *pd;
+		UN8x4_ADD_UN8x4 (d, s);
+		*pd = d;
+	    }
+	    pd++;
+	    pm++;
+	}
+	return;
+    }
+
+    /* Align dst on a 32-byte boundary */
+    while (w && ((uintptr_t)pd & 31))
+    {
+	d = *pd;
+	s = *ps++;
+	UN8x4_ADD_UN8x4 (d, s);
+	*pd++ = d;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	save_256_aligned (
+	    (__m256i *)pd,
+	    _mm256_adds_epu8 (load_256_unaligned ((__m256i *)ps),
+			      load_256_aligned ((__m256i *)pd)));
+	pd += 8;
+	ps += 8;
+	w -= 8;
+    }
+
+    while (w--)
+    {
+	d = *pd;
+	s = *ps++;
+	UN8x4_ADD_UN8x4 (d, s);
+	*pd++ = d;
+    }
+}
+
+static void
+avx2_composite_over_8888_8888 (pixman_implementation_t *imp,
+			       pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    dst = dst_line;
+    src = src_line;
+
+    while (height--)
+    {
+	core_combine_over_u_avx2_no_mask (dst, src, width);
+
+	dst += dst_stride;
+	src += src_stride;
+    }
+}
+
+static void
+avx2_composite_add_8_8 (pixman_implementation_t *imp,
+			pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    uint8_t     *src_line, *src;
+    int dst_stride, src_stride;
+    int32_t w;
+    uint16_t t;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint8_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	src = src_line;
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	w = width;
+
+	/* Align dst on a 32-byte boundary */
+	while (w && (uintptr_t)dst & 31)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+
+	while (w >= 32)
+	{
+	    save_256_aligned (
+		(__m256i *)dst,
+		_mm256_adds_epu8 (load_256_unaligned ((__m256i *)src),
+				  load_256_aligned ((__m256i *)dst)));
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	while (w)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+    }
+}
+
+static void
+avx2_composite_add_8888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+
+	avx2_combine_add_u (imp, op, dst, src, NULL, width);
+    }
+}
+
+static void
+avx2_composite_src_x888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    __m256i ff000000 = _mm256_set1_epi32 (0xff000000);
+    int32_t w;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w && (uintptr_t)dst & 31)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+
+	while (w >= 8)
+	{
+	    save_256_aligned (
+		(__m256i *)dst, _mm256_or_si256 (
+		    load_256_unaligned ((__m256i *)src), ff000000));
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+
+	while (w)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+    }
+}
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    /* PIXMAN_OP_OVER */
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, avx2_composite_over_8888_8888),
+
+    /* PIXMAN_OP_ADD */
+    PIXMAN_STD_FAST_PATH (ADD, a8, null, a8, avx2_composite_add_8_8),
+    PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, avx2_composite_add_8888_8888),
+    PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, avx2_composite_add_8888_8888),
+
+    /* PIXMAN_OP_SRC */
+    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, avx2_composite_src_x888_8888),
+    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, avx2_composite_src_x888_8888),
+
+    { PIXMAN_OP_NONE },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp = _pixman_implementation_create (fallback, avx2_fast_paths);
+
+    /* Set up function pointers */
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    return imp;
+}
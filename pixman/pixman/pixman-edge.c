@@ -127,6 +127,44 @@ clip255 (int x)
     return x;
 }
 
+#if !defined (PIXMAN_FB_ACCESSORS) &&					\
+    (defined (__SSE2__) || defined (__x86_64__) || defined (_M_X64) ||	\
+     (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+
+#include <emmintrin.h>
+
+/* Saturating add of 'val' to a span of alpha bytes.  PADDUSB clips to
+ * 255 exactly as clip255() does, so 16 pixels go per instruction; the
+ * scalar tail handles the remainder.  Only usable when SSE2 is part of
+ * the compiler's baseline, and only without accessors, where READ and
+ * WRITE are plain memory references.
+ */
+static force_inline void
+add_saturate_8_span (uint8_t *buf, int val, int length)
+{
+    __m128i v = _mm_set1_epi8 ((char) val);
+
+    while (length >= 16)
+    {
+	_mm_storeu_si128 ((__m128i *) buf,
+			  _mm_adds_epu8 (
+			      _mm_loadu_si128 ((const __m128i *) buf), v));
+	buf += 16;
+	length -= 16;
+    }
+
+    while (length--)
+    {
+	*buf = clip255 (*buf + val);
+	buf++;
+    }
+}
+
+#define ADD_SATURATE_8(buf, val, length)				\
+    add_saturate_8_span ((buf), (val), (length))
+
+#else
+
 #define ADD_SATURATE_8(buf, val, length)				\
     do									\
     {									\
@@ -141,6 +179,8 @@ clip255 (int x)
 	}								\
     } while (0)
 
+#endif
+
 /*
  * We want to detect the case where we add the same value to a long
  * span of pixels.  The triangles on the end are filled in while we
@@ -2272,27 +2272,23 @@ typedef struct
     line_t		lines[2];
     pixman_fixed_t	y;
     pixman_fixed_t	x;
+    int *		x0s;	/* per-column left sample offset */
+    int32_t *		wxs;	/* per-column horizontal weight */
     uint64_t		data[1];
 } bilinear_info_t;
 
 static void
 fetch_horizontal (bits_image_t *image, line_t *line,
-		  int y, pixman_fixed_t x, pixman_fixed_t ux, int n)
+		  int y, const int *x0s, const int32_t *wxs, int n)
 {
     uint32_t *bits = image->bits + y * image->rowstride;
     int i;
 
     for (i = 0; i < n; ++i)
     {
-	int x0 = pixman_fixed_to_int (x);
-	int x1 = x0 + 1;
-	int32_t dist_x;
-
-	uint32_t left = *(bits + x0);
-	uint32_t right = *(bits + x1);
-
-	dist_x = pixman_fixed_to_bilinear_weight (x);
-	dist_x <<= (8 - BILINEAR_INTERPOLATION_BITS);
+	uint32_t left = *(bits + x0s[i]);
+	uint32_t right = *(bits + x0s[i] + 1);
+	int32_t dist_x = wxs[i];
 
 #if SIZEOF_LONG <= 4
 	{
@@ -2326,8 +2322,6 @@ fetch_horizontal (bits_image_t *image, line_t *line,
 	    line->buffer[i] = (lagrb << 8) + dist_x * (ragrb - lagrb);
 	}
 #endif
-
-	x += ux;
     }
 
     line->y = y;
@@ -2336,7 +2330,6 @@ fetch_horizontal (bits_image_t *image, line_t *line,
 static uint32_t *
 fast_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
 {
-    pixman_fixed_t fx, ux;
     bilinear_info_t *info = iter->data;
     line_t *line0, *line1;
     int y0, y1;
@@ -2345,9 +2338,6 @@ fast_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
 
     COMPILE_TIME_ASSERT (BILINEAR_INTERPOLATION_BITS < 8);
 
-    fx = info->x;
-    ux = iter->image->common.transform->matrix[0][0];
-
     y0 = pixman_fixed_to_int (info->y);
     y1 = y0 + 1;
     dist_y = pixman_fixed_to_bilinear_weight (info->y);
@@ -2359,13 +2349,13 @@ fast_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
     if (line0->y != y0)
     {
 	fetch_horizontal (
-	    &iter->image->bits, line0, y0, fx, ux, iter->width);
+	    &iter->image->bits, line0, y0, info->x0s, info->wxs, iter->width);
     }
 
     if (line1->y != y1)
     {
 	fetch_horizontal (
-	    &iter->image->bits, line1, y1, fx, ux, iter->width);
+	    &iter->image->bits, line1, y1, info->x0s, info->wxs, iter->width);
     }
 
     for (i = 0; i < iter->width; ++i)
@@ -2441,6 +2431,8 @@ fast_bilinear_cover_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *it
     int width = iter->width;
     bilinear_info_t *info;
     pixman_vector_t v;
+    pixman_fixed_t x, ux;
+    int i;
 
     /* Reference point is the center of the pixel */
     v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
@@ -2450,13 +2442,29 @@ fast_bilinear_cover_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *it
     if (!pixman_transform_point_3d (iter->image->common.transform, &v))
 	goto fail;
 
-    info = malloc (sizeof (*info) + (2 * width - 1) * sizeof (uint64_t));
+    info = malloc (sizeof (*info) + (2 * width - 1) * sizeof (uint64_t) +
+		   width * (sizeof (int) + sizeof (int32_t)));
     if (!info)
 	goto fail;
 
     info->x = v.vector[0] - pixman_fixed_1 / 2;
     info->y = v.vector[1] - pixman_fixed_1 / 2;
 
+    /* The horizontal sample positions and weights are the same for
+     * every fetched line, so compute them once instead of per row
+     */
+    info->x0s = (int *)&info->data[2 * width];
+    info->wxs = (int32_t *)(info->x0s + width);
+    x = info->x;
+    ux = iter->image->common.transform->matrix[0][0];
+    for (i = 0; i < width; ++i)
+    {
+	info->x0s[i] = pixman_fixed_to_int (x);
+	info->wxs[i] = pixman_fixed_to_bilinear_weight (x) <<
+	    (8 - BILINEAR_INTERPOLATION_BITS);
+	x += ux;
+    }
+
     /* It is safe to set the y coordinates to -1 initially
      * because COVER_CLIP_BILINEAR ensures that we will only
      * be asked to fetch lines in the [0, height) interval
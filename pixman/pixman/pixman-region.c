@@ -202,18 +202,98 @@ PIXREGION_SZOF (size_t n)
     return size + sizeof(region_data_type_t);
 }
 
+/*
+ * Freed data blocks are kept in a small per-thread cache, binned by
+ * power-of-two capacity, and handed back to later allocations instead
+ * of returning to malloc.  Region operations happen at a very high
+ * rate in some clients (an X server performs one per drawing request
+ * for damage tracking), almost always on regions with a modest number
+ * of boxes.  Allocations are rounded up to the bin capacity so a
+ * cached block always suffices; blocks larger than the biggest bin
+ * fall back to malloc/free.
+ */
+
+#define DATA_CACHE_BINS		6   /* capacities of 8 .. 256 boxes */
+#define DATA_CACHE_MIN_SHIFT	3
+#define DATA_CACHE_MAX_BLOCKS	16  /* blocks retained per bin */
+
+typedef struct
+{
+    region_data_type_t *blocks[DATA_CACHE_BINS][DATA_CACHE_MAX_BLOCKS];
+    int n_blocks[DATA_CACHE_BINS];
+} data_cache_t;
+
+PIXMAN_DEFINE_THREAD_LOCAL (data_cache_t, region_data_cache);
+
 static region_data_type_t *
 alloc_data (size_t n)
 {
-    size_t sz = PIXREGION_SZOF (n);
+    data_cache_t *cache = PIXMAN_GET_THREAD_LOCAL (region_data_cache);
+    region_data_type_t *data;
+    size_t sz;
+    int bin;
+
+    for (bin = 0; bin < DATA_CACHE_BINS; bin++)
+    {
+	size_t cap = (size_t)1 << (DATA_CACHE_MIN_SHIFT + bin);
+
+	if (cap < n)
+	    continue;
+
+	if (cache && cache->n_blocks[bin])
+	{
+	    data = cache->blocks[bin][--cache->n_blocks[bin]];
+	}
+	else
+	{
+	    data = malloc (PIXREGION_SZOF (cap));
+	    if (!data)
+		return NULL;
+	}
+	data->size = cap;
+	return data;
+    }
 
+    sz = PIXREGION_SZOF (n);
     if (!sz)
 	return NULL;
 
-    return malloc (sz);
+    data = malloc (sz);
+    if (data)
+	data->size = n;
+    return data;
 }
 
-#define FREE_DATA(reg) if ((reg)->data && (reg)->data->size) free ((reg)->data)
+static void
+free_data (region_data_type_t *data)
+{
+    data_cache_t *cache;
+    int bin;
+
+    if (!data || !data->size)
+	return;
+
+    /* bin by the largest capacity the block is known to hold; the size
+     * field never exceeds what was actually allocated
+     */
+    cache = PIXMAN_GET_THREAD_LOCAL (region_data_cache);
+    for (bin = DATA_CACHE_BINS; cache && bin-- > 0;)
+    {
+	if (((size_t)1 << (DATA_CACHE_MIN_SHIFT + bin)) <= (size_t)data->size)
+	{
+	    if (cache->n_blocks[bin] < DATA_CACHE_MAX_BLOCKS)
+	    {
+		cache->blocks[bin][cache->n_blocks[bin]++] = data;
+		return;
+	    }
+	    break;
+	}
+    }
+
+    free (data);
+}
+
+#define FREE_DATA(reg) free_data ((reg)->data)
 
 #define RECTALLOC_BAIL(region, n, bail)					\
     do									\
@@ -459,6 +539,8 @@ pixman_rect_alloc (region_type_t * region,
 
 	region->data->numRects = 1;
 	*PIXREGION_BOXPTR (region) = region->extents;
+
+	return TRUE;
     }
     else if (!region->data->size)
     {
@@ -468,6 +550,8 @@ pixman_rect_alloc (region_type_t * region,
 	    return pixman_break (region);
 
 	region->data->numRects = 0;
+
+	return TRUE;
     }
     else
     {
@@ -530,8 +614,6 @@ PREFIX (_copy) (region_type_t *dst, const region_type_t *src)
 
 	if (!dst->data)
 	    return pixman_break (dst);
-
-	dst->data->size = src->data->numRects;
     }
 
     dst->data->numRects = src->data->numRects;
@@ -827,7 +909,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     {
         if (!pixman_rect_alloc (new_reg, new_size))
         {
-            free (old_data);
+            free_data (old_data);
             return FALSE;
 	}
     }
@@ -1002,7 +1084,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
         APPEND_REGIONS (new_reg, r2_band_end, r2_end);
     }
 
-    free (old_data);
+    free_data (old_data);
 
     if (!(numRects = new_reg->data->numRects))
     {
@@ -1023,7 +1105,7 @@ pixman_op (region_type_t *  new_reg,               /* Place to store result
     return TRUE;
 
 bail:
-    free (old_data);
+    free_data (old_data);
 
     return pixman_break (new_reg);
 }
@@ -1153,6 +1235,157 @@ pixman_region_intersect_o (region_type_t *region,
     return TRUE;
 }
 
+/*-
+ *-----------------------------------------------------------------------
+ * pixman_region_intersect_box --
+ *	Intersection when one operand is a plain rectangle that does
+ *	not subsume the other operand.  Damage tracking hits this case
+ *	constantly (a region against some clip extents); clipping each
+ *	box against the rectangle in one tight pass avoids the band
+ *	walker in pixman_op entirely, and the branch-free min/max body
+ *	is something compilers vectorize on their own.  Uniform
+ *	clipping preserves bands, so the only repair needed for
+ *	canonical form is merging a band that has become identical to
+ *	a vertically adjacent predecessor.
+ *
+ * Results:
+ *	TRUE if successful.
+ *
+ * Side Effects:
+ *	new_reg is overwritten; it may be the same region as src.
+ *
+ *-----------------------------------------------------------------------
+ */
+static pixman_bool_t
+pixman_region_intersect_box (region_type_t *       new_reg,
+                              const region_type_t * src,
+                              const box_type_t *    rect)
+{
+    region_data_type_t *data;
+    region_data_type_t *old_data;
+    box_type_t *dst;
+    const box_type_t *box, *end;
+    int num_rects;
+    int prev_start, cur_start;
+
+    data = alloc_data (src->data->numRects);
+    if (!data)
+	return pixman_break (new_reg);
+
+    dst = (box_type_t *) (data + 1);
+    num_rects = 0;
+    prev_start = cur_start = 0;
+
+    for (box = PIXREGION_BOXPTR (src), end = box + src->data->numRects;
+         box != end;
+         box++)
+    {
+        int x1, y1, x2, y2;
+
+        if (box->y2 <= rect->y1)
+	    continue;
+
+        if (box->y1 >= rect->y2)
+	    break;
+
+        x1 = MAX (box->x1, rect->x1);
+        x2 = MIN (box->x2, rect->x2);
+
+        if (x1 >= x2)
+	    continue;
+
+        y1 = MAX (box->y1, rect->y1);
+        y2 = MIN (box->y2, rect->y2);
+
+        if (num_rects > cur_start && dst[cur_start].y1 != y1)
+        {
+            /* The current band is finished; merge it into the
+	     * previous one when they touch and match in x */
+            int len = num_rects - cur_start;
+            int i;
+
+            if (len == cur_start - prev_start &&
+                dst[prev_start].y2 == dst[cur_start].y1)
+            {
+                for (i = 0; i < len; i++)
+                {
+                    if (dst[prev_start + i].x1 != dst[cur_start + i].x1 ||
+                        dst[prev_start + i].x2 != dst[cur_start + i].x2)
+		        break;
+		}
+
+                if (i == len)
+                {
+                    for (i = 0; i < len; i++)
+			dst[prev_start + i].y2 = dst[cur_start].y2;
+                    num_rects = cur_start;
+		}
+	    }
+
+            if (num_rects != cur_start)
+		prev_start = cur_start;
+            cur_start = num_rects;
+	}
+
+        dst[num_rects].x1 = x1;
+        dst[num_rects].y1 = y1;
+        dst[num_rects].x2 = x2;
+        dst[num_rects].y2 = y2;
+        num_rects++;
+    }
+
+    /* Close the final band */
+    if (num_rects > cur_start && cur_start > prev_start)
+    {
+        int len = num_rects - cur_start;
+        int i;
+
+        if (len == cur_start - prev_start &&
+            dst[prev_start].y2 == dst[cur_start].y1)
+        {
+            for (i = 0; i < len; i++)
+            {
+                if (dst[prev_start + i].x1 != dst[cur_start + i].x1 ||
+                    dst[prev_start + i].x2 != dst[cur_start + i].x2)
+		    break;
+	    }
+
+            if (i == len)
+            {
+                for (i = 0; i < len; i++)
+		    dst[prev_start + i].y2 = dst[cur_start].y2;
+                num_rects = cur_start;
+	    }
+	}
+    }
+
+    old_data = new_reg->data;
+
+    if (!num_rects)
+    {
+        free_data (data);
+        new_reg->extents.x2 = new_reg->extents.x1;
+        new_reg->extents.y2 = new_reg->extents.y1;
+        new_reg->data = pixman_region_empty_data;
+    }
+    else if (num_rects == 1)
+    {
+        new_reg->extents = dst[0];
+        new_reg->data = NULL;
+        free_data (data);
+    }
+    else
+    {
+        data->numRects = num_rects;
+        new_reg->data = data;
+        pixman_set_extents (new_reg);
+    }
+
+    free_data (old_data);
+
+    return TRUE;
+}
+
 PIXMAN_EXPORT pixman_bool_t
 PREFIX (_intersect) (region_type_t *     new_reg,
                      const region_type_t *        reg1,
@@ -1204,13 +1437,22 @@ PREFIX (_intersect) (region_type_t *     new_reg,
     {
         return PREFIX (_copy) (new_reg, reg1);
     }
+    else if (!reg2->data)
+    {
+        /* Clip reg1 against a plain rectangle */
+        return pixman_region_intersect_box (new_reg, reg1, &reg2->extents);
+    }
+    else if (!reg1->data)
+    {
+        return pixman_region_intersect_box (new_reg, reg2, &reg1->extents);
+    }
     else
     {
         /* General purpose intersection */
 
         if (!pixman_op (new_reg, reg1, reg2, pixman_region_intersect_o, FALSE, FALSE))
 	    return FALSE;
-	
+
         pixman_set_extents (new_reg);
     }
 
@@ -2782,7 +3024,7 @@ PREFIX (_init_from_image) (region_type_t *region,
         region->extents.y2 = PIXREGION_END(region)->y2;
         if (region->data->numRects == 1)
         {
-            free (region->data);
+            free_data (region->data);
             region->data = NULL;
         }
     }
@@ -25,7 +25,8 @@
 
 #include "pixman-private.h"
 
-#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3)
+#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3) || \
+    defined (USE_AVX2)
 
 /* The CPU detection code needs to be in a file not compiled with
  * "-mmmx -msse", as gcc would generate CMOV instructions otherwise
@@ -40,7 +41,8 @@ typedef enum
     X86_SSE			= (1 << 2) | X86_MMX_EXTENSIONS,
     X86_SSE2			= (1 << 3),
     X86_CMOV			= (1 << 4),
-    X86_SSSE3			= (1 << 5)
+    X86_SSSE3			= (1 << 5),
+    X86_AVX2			= (1 << 6)
 } cpu_features_t;
 
 #ifdef HAVE_GETISAX
@@ -151,6 +153,59 @@ pixman_cpuid (uint32_t feature,
 #endif
 }
 
+static pixman_bool_t
+have_avx2 (void)
+{
+    uint32_t a, b, c, d;
+
+    /* AVX2 needs the CPUID bits and an OS that saves/restores the YMM
+     * state (OSXSAVE set and XCR0 advertising XMM|YMM)
+     */
+    pixman_cpuid (0x01, &a, &b, &c, &d);
+    if ((c & ((1 << 27) | (1 << 28))) != ((1 << 27) | (1 << 28)))
+	return FALSE;
+
+#if defined (__GNUC__)
+    /* xgetbv (0); spelled in bytes for the benefit of old assemblers */
+    __asm__ volatile (
+	".byte 0x0f, 0x01, 0xd0"
+	: "=a" (a), "=d" (d)
+	: "c" (0));
+#elif defined (_MSC_VER)
+    a = (uint32_t) _xgetbv (0);
+#else
+    return FALSE;
+#endif
+    if ((a & 6) != 6)
+	return FALSE;
+
+    /* Structured extended feature flags, subleaf 0 */
+#if defined (__GNUC__)
+#if _PIXMAN_X86_64
+    __asm__ volatile (
+        "cpuid"				"\n\t"
+	: "=a" (a), "=b" (b), "=c" (c), "=d" (d)
+	: "a" (0x07), "c" (0));
+#else
+    __asm__ volatile (
+	"xchg %%ebx, %1"		"\n\t"
+	"cpuid"				"\n\t"
+	"xchg %%ebx, %1"		"\n\t"
+	: "=a" (a), "=r" (b), "=c" (c), "=d" (d)
+	: "a" (0x07), "c" (0));
+#endif
+#elif defined (_MSC_VER)
+    {
+	int info[4];
+
+	__cpuidex (info, 0x07, 0);
+	b = info[1];
+    }
+#endif
+
+    return (b & (1 << 5)) != 0;
+}
+
 static cpu_features_t
 detect_cpu_features (void)
 {
@@ -172,6 +227,8 @@ detect_cpu_features (void)
 	features |= X86_SSE2;
     if (c & (1 << 9))
 	features |= X86_SSSE3;
+    if ((features & X86_SSE2) && have_avx2 ())
+	features |= X86_AVX2;
 
     /* Check for AMD specific features */
     if ((features & X86_MMX) && !(features & X86_SSE))
@@ -229,6 +286,7 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 #define MMX_BITS  (X86_MMX | X86_MMX_EXTENSIONS)
 #define SSE2_BITS (X86_MMX | X86_MMX_EXTENSIONS | X86_SSE | X86_SSE2)
 #define SSSE3_BITS (X86_SSE | X86_SSE2 | X86_SSSE3)
+#define AVX2_BITS (X86_SSE | X86_SSE2 | X86_AVX2)
 
 #ifdef USE_X86_MMX
     if (!_pixman_disabled ("mmx") && have_feature (MMX_BITS))
@@ -245,5 +303,10 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 	imp = _pixman_implementation_create_ssse3 (imp);
 #endif
 
+#ifdef USE_AVX2
+    if (!_pixman_disabled ("avx2") && have_feature (AVX2_BITS))
+	imp = _pixman_implementation_create_avx2 (imp);
+#endif
+
     return imp;
 }
@@ -127,6 +127,9 @@ public:
 
   bool IsNewer(const mh_time &Src) const { return m_Time>Src.m_Time+TIMESAFETY; }
   bool IsNewerOrSame(const mh_time &Src) const { return m_Time>=Src.m_Time-TIMESAFETY; }
+  bool IsSame(const mh_time &Src) const { return m_Time==Src.m_Time; }  /* Exact compare, no TIMESAFETY slack (for cache validation) */
+
+  mh_basetime_t GetTime(void) const { return m_Time; }
 };
 typedef mh_time mh_time_t;
 
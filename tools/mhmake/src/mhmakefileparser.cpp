@@ -642,9 +642,26 @@ void mhmakefileparser::GetAutoDepsIfNeeded(fileinfo *pTarget, const fileinfo *pF
   if (!Autodeps.first)
   {
     Autodeps.first=true;
+    if (!m_ForceAutoDepRescan && Autodeps.m_ScanDate.IsDateValid() &&
+        Autodeps.m_ScanDate.IsSame(pFirstDep->GetDate()))
+    {
+      /* The scanned file did not change since the dependencies were saved in
+         the autodep file, so the loaded dependencies are still valid (they
+         were added to the target in LoadAutoDepsFile). Only the included
+         files still have to be validated, since a changed header may include
+         new headers. */
+      deps_t::iterator DepIt=Autodeps.second.begin();
+      while (DepIt!=Autodeps.second.end())
+      {
+        GetAutoDepsIfNeeded(*DepIt,*DepIt);
+        DepIt++;
+      }
+      return;
+    }
     /* We are going to rescan, so throw away the old. */
     Autodeps.second.clear();
     GetAutoDeps(pFirstDep,Autodeps.second);
+    Autodeps.m_ScanDate=pFirstDep->GetDate();
     // Now add these dependencies also to the rules
     deps_t::iterator It=Autodeps.second.begin();
     while (It!=Autodeps.second.end())
@@ -709,6 +726,11 @@ const refptr<fileinfoarray> mhmakefileparser::GetIncludeDirs() const
   return m_pIncludeDirs;
 }
 
+/* Tag written as the first line of the autodep file. Bump it when the file
+   format changes, so that files written by an older mhmake are ignored
+   instead of misparsed. */
+#define AUTODEPFILE_VERSIONTAG "#mhmake-autodeps-v2"
+
 static void ReadStr(FILE *pFile,char *Str)
 {
   int i=0;
@@ -743,6 +765,15 @@ void mhmakefileparser::LoadAutoDepsFile(fileinfo *pDepFile)
     cerr << "Error opening autodep file "<<pDepFile->GetQuotedFullFileName()<<endl;
     return;
   }
+  char UsedEnvVars[1024];
+  ReadStr(pIn,UsedEnvVars);
+  if (strcmp(UsedEnvVars,AUTODEPFILE_VERSIONTAG))
+  {
+    /* Written by an older mhmake: ignore it. It is rewritten in the current
+       format when the dependencies are saved. */
+    fclose(pIn);
+    return;
+  }
   if (1!=fread(&m_EnvMd5_32,sizeof(m_EnvMd5_32),1,pIn))
   {
     cerr << "Wrong format of autodep file "<<pDepFile->GetQuotedFullFileName()<<endl;
@@ -753,7 +784,6 @@ void mhmakefileparser::LoadAutoDepsFile(fileinfo *pDepFile)
   if (g_PrintAdditionalInfo)
     cout << "Reading Env Md5 from "<<pDepFile->GetQuotedFullFileName()<<": "<<hex<<m_EnvMd5_32<<endl;
 #endif
-  char UsedEnvVars[1024];
   ReadStr(pIn,UsedEnvVars);
   SetVariable(USED_ENVVARS,UsedEnvVars);
 
@@ -763,6 +793,9 @@ void mhmakefileparser::LoadAutoDepsFile(fileinfo *pDepFile)
   {
     fileinfo *pTarget=GetFileInfo(FileName,m_MakeDir);
     autodeps_entry_t &Autodeps=m_AutoDeps[pTarget];
+    mh_basetime_t ScanDate;
+    if (1==fread(&ScanDate,sizeof(ScanDate),1,pIn))
+      Autodeps.m_ScanDate=mh_time_t(ScanDate);
     ReadStr(pIn,FileName);
     while (FileName[0])
     {
@@ -853,6 +886,7 @@ void mhmakefileparser::SaveAutoDepsFile()
       return;
     }
   }
+  fprintf(pOut,"%s\n",AUTODEPFILE_VERSIONTAG);
   // First update the USER_ENVVARS variable and then save it to the dep file together with the md5 string
   CreateUSED_ENVVARS();
   uint32 Md5_32=CreateEnvMd5_32();
@@ -865,6 +899,8 @@ void mhmakefileparser::SaveAutoDepsFile()
     if (!It->second.second.empty())
     {
       fprintf(pOut,"%s\n",It->first->GetFullFileName().c_str());
+      mh_basetime_t ScanDate=It->second.m_ScanDate.GetTime();
+      fwrite(&ScanDate,sizeof(ScanDate),1,pOut);
       deps_t::const_iterator DepIt=It->second.second.begin();
       while (DepIt!=It->second.second.end())
       {
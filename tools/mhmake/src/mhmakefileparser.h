@@ -43,7 +43,18 @@ class fileinfoarray : public refbase,public vector<fileinfo*>
 };
 
 typedef set<fileinfo*> deps_t;
-typedef pair< bool, deps_t > autodeps_entry_t;
+/* Scanned include dependencies of one file. first is set when the deps have
+ * been scanned (or validated against m_ScanDate) during this run. m_ScanDate
+ * is the date the scanned file had when the deps were gathered; it is stored
+ * in the autodep file so that dependencies of unchanged files can be reused
+ * on the next run without re-parsing them. */
+struct autodeps_entry_t
+{
+  autodeps_entry_t() : first(false) {}
+  bool first;
+  mh_time_t m_ScanDate;
+  deps_t second;
+};
 typedef map<fileinfo*, autodeps_entry_t > autodeps_t;
 
 namespace yy
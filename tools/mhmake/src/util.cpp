@@ -64,7 +64,9 @@ Usage: mhmake [-f <Makefile>] [-[c|C] <RunDir>] [<Var>=<Value>]\n\
   -P <Nr Parallel Builds> :\n\
                 Number of parallel build commands executed at the \n\
                 same time. Default is this the number of processor \n\
-                cores. 1 disables parallel builds.\n"
+                cores. 1 disables parallel builds.\n\
+  -j <Nr Parallel Builds> :\n\
+                Alias for -P (gnu make compatibility).\n"
 #ifdef _DEBUG
 "\n\
   The following options are additional options in mhmake_dbg which are not\n\
@@ -508,6 +510,8 @@ loadedmakefile::loadedmakefile(const fileinfo *pDir, vector<string> &Args,const
         case 'v':
           PrintVersionInfo();
           break;
+        case 'j':  /* gnu make compatible alias for -P */
+          /* Fall through */
         case 'P':
           if (ArgIt->size()>2)
             mhmakefileparser::SetNrParallelBuilds(atoi(ArgIt->substr(2).c_str()));
@@ -43,6 +43,17 @@ struct extension_info_t {
 
 struct xcb_errors_context_t {
 	struct extension_info_t *extensions;
+
+	/* Direct-mapped lookup tables indexed by the 8-bit code carried in
+	 * an error or event, filled in while the extensions register.  The
+	 * first_event/first_error tables hold, for each code, the extension
+	 * with the largest base not above that code, which is exactly what
+	 * the name lookups want; entries left NULL fall back to xproto.
+	 */
+	struct extension_info_t *by_major_opcode[256];
+	struct extension_info_t *by_first_event[256];
+	struct extension_info_t *by_first_error[256];
+	struct extension_info_t *xkb;
 };
 
 static const char *get_strings_entry(const char *strings, unsigned int index) {
@@ -79,6 +90,35 @@ int register_extension(xcb_errors_context_t *ctx, xcb_connection_t *conn,
 	ctx->extensions = info;
 	free(reply);
 
+	ctx->by_major_opcode[info->major_opcode] = info;
+
+	/* Claim every code from this extension's base upwards, unless an
+	 * extension with a higher base already owns the code.  This bakes
+	 * the "largest base not above the code" search into the table, so
+	 * lookups need no scan; it also does the right thing if the server
+	 * only supports an older version of some extension which had fewer
+	 * events or errors, since out-of-range codes still resolve to the
+	 * nearest lower base and get rejected against num_events/num_errors
+	 * in the lookup.
+	 */
+	if (info->first_event != 0) {
+		unsigned int i;
+		for (i = info->first_event; i < 256; i++)
+			if (ctx->by_first_event[i] == NULL ||
+			    ctx->by_first_event[i]->first_event < info->first_event)
+				ctx->by_first_event[i] = info;
+	}
+	if (info->first_error != 0) {
+		unsigned int i;
+		for (i = info->first_error; i < 256; i++)
+			if (ctx->by_first_error[i] == NULL ||
+			    ctx->by_first_error[i]->first_error < info->first_error)
+				ctx->by_first_error[i] = info;
+	}
+
+	if (strcmp(static_info->name, "xkb") == 0)
+		ctx->xkb = info;
+
 	return 0;
 }
 
@@ -86,7 +126,7 @@ int xcb_errors_context_new(xcb_connection_t *conn, xcb_errors_context_t **c)
 {
 	xcb_errors_context_t *ctx = NULL;
 
-	if ((*c = calloc(1, sizeof(*c))) == NULL)
+	if ((*c = calloc(1, sizeof(**c))) == NULL)
 		goto error_out;
 
 	ctx = *c;
@@ -127,9 +167,7 @@ const char *xcb_errors_get_name_for_major_code(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	info = ctx->extensions;
-	while (info && info->major_opcode != major_code)
-		info = info->next;
+	info = ctx->by_major_opcode[major_code];
 
 	if (info == NULL)
 		return get_strings_entry(xproto_info.strings_minor, major_code);
@@ -145,9 +183,7 @@ const char *xcb_errors_get_name_for_minor_code(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	info = ctx->extensions;
-	while (info && info->major_opcode != major_code)
-		info = info->next;
+	info = ctx->by_major_opcode[major_code];
 
 	if (info == NULL || minor_code >= info->static_info->num_minor)
 		return NULL;
@@ -162,9 +198,7 @@ const char *xcb_errors_get_name_for_xge_event(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	info = ctx->extensions;
-	while (info && info->major_opcode != major_code)
-		info = info->next;
+	info = ctx->by_major_opcode[major_code];
 
 	if (info == NULL || event_type >= info->static_info->num_xge_events)
 		return NULL;
@@ -175,8 +209,7 @@ const char *xcb_errors_get_name_for_xge_event(xcb_errors_context_t *ctx,
 const char *xcb_errors_get_name_for_core_event(xcb_errors_context_t *ctx,
 		uint8_t event_code, const char **extension)
 {
-	struct extension_info_t *best = NULL;
-	struct extension_info_t *next;
+	struct extension_info_t *best;
 
 	event_code &= 0x7f;
 	if (extension)
@@ -184,23 +217,13 @@ const char *xcb_errors_get_name_for_core_event(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	/* Find the extension with the largest first_event <= event_code. Thanks
-	 * to this we do the right thing if the server only supports an older
-	 * version of some extension which had less events.
+	/* The table holds the extension with the largest first_event <=
+	 * event_code. Thanks to this we do the right thing if the server only
+	 * supports an older version of some extension which had less events.
 	 */
-	next = ctx->extensions;
-	while (next) {
-		struct extension_info_t *current = next;
-		next = next->next;
-
-		if (current->first_event > event_code)
-			continue;
-		if (best != NULL && best->first_event > current->first_event)
-			continue;
-		best = current;
-	}
+	best = ctx->by_first_event[event_code];
 
-	if (best == NULL || best->first_event == 0
+	if (best == NULL
 			|| event_code - best->first_event >= best->static_info->num_events) {
 		/* Nothing found */
 		return get_strings_entry(xproto_info.strings_events, event_code);
@@ -214,31 +237,20 @@ const char *xcb_errors_get_name_for_core_event(xcb_errors_context_t *ctx,
 const char *xcb_errors_get_name_for_error(xcb_errors_context_t *ctx,
 		uint8_t error_code, const char **extension)
 {
-	struct extension_info_t *best = NULL;
-	struct extension_info_t *next;
+	struct extension_info_t *best;
 
 	if (extension)
 		*extension = NULL;
 
 	CHECK_CONTEXT(ctx);
 
-	/* Find the extension with the largest first_error <= error_code. Thanks
-	 * to this we do the right thing if the server only supports an older
-	 * version of some extension which had less events.
+	/* The table holds the extension with the largest first_error <=
+	 * error_code. Thanks to this we do the right thing if the server only
+	 * supports an older version of some extension which had less events.
 	 */
-	next = ctx->extensions;
-	while (next) {
-		struct extension_info_t *current = next;
-		next = next->next;
-
-		if (current->first_error > error_code)
-			continue;
-		if (best != NULL && best->first_error > current->first_error)
-			continue;
-		best = current;
-	}
+	best = ctx->by_first_error[error_code];
 
-	if (best == NULL || best->first_error == 0
+	if (best == NULL
 			|| error_code - best->first_error >= best->static_info->num_errors) {
 		/* Nothing found */
 		return get_strings_entry(xproto_info.strings_errors, error_code);
@@ -260,10 +272,8 @@ const char *xcb_errors_get_name_for_xcb_event(xcb_errors_context_t *ctx,
 
 	CHECK_CONTEXT(ctx);
 
-	/* Find the xkb extension, if present */
-	xkb = ctx->extensions;
-	while (xkb != NULL && strcmp(xkb->static_info->name, "xkb") != 0)
-		xkb = xkb->next;
+	/* The xkb extension, if present, was remembered at register time */
+	xkb = ctx->xkb;
 
 	response_type = event->response_type & 0x7f;
 	if (response_type == XCB_GE_GENERIC) {
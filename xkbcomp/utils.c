@@ -237,6 +237,20 @@ uError(const char *s, ...)
 
 /***====================================================================***/
 
+static jmp_buf *fatalRecovery = NULL;
+
+/**
+ * Register a place to longjmp to instead of exit()ing on a fatal error.
+ * Used when the compiler is linked into a long-lived host process; pass
+ * NULL to restore the normal exit() behaviour.
+ */
+void
+uSetFatalRecovery(jmp_buf * env)
+{
+    fatalRecovery = env;
+    return;
+}
+
 void
 uFatalError(const char *s, ...)
 {
@@ -253,6 +267,8 @@ uFatalError(const char *s, ...)
     fprintf(errorFile, "                  Exiting\n");
     fflush(errorFile);
     outCount++;
+    if (fatalRecovery != NULL)
+        longjmp(*fatalRecovery, 1);
     exit(1);
     /* NOTREACHED */
 }
@@ -35,6 +35,7 @@
 #include	<X11/Xfuncs.h>
 
 #include <stddef.h>
+#include <setjmp.h>
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -167,6 +168,9 @@ uInformation(const char * /* s */ , ...
      extern void uFatalError(const char * /* s  */ , ...
     ) _X_ATTRIBUTE_PRINTF(1, 2) _X_NORETURN;
 
+     extern void uSetFatalRecovery(jmp_buf *    /* env */
+    );
+
 /* WSGO stands for "Weird Stuff Going On" */
 #define WSGO6			uInternalError
 #define WSGO5			uInternalError
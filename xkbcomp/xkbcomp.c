@@ -1247,3 +1247,138 @@ main(int argc, char *argv[])
     uFinishUp();
     return (ok == 0);
 }
+
+/***====================================================================***/
+
+/*
+ * Entry point used when xkbcomp is built as a shared library and loaded
+ * into a long-lived host process (the X server compiles server-generated
+ * keymaps through this instead of spawning xkbcomp.exe).  It compiles a
+ * single keymap source file straight to an .xkm file, the equivalent of
+ *     xkbcomp -w <warningLvl> -R<baseDir> -xkm <input> <output>
+ * Fatal errors inside the compiler are diverted back here with
+ * uSetFatalRecovery() instead of exit()ing, so a broken keymap cannot
+ * take the host process down.  Returns 0 on success, 1 on any failure.
+ */
+int
+XkbCompCompileKeymapFile(const char *input,
+                         const char *output,
+                         const char *baseDir,
+                         unsigned warningLvl,
+                         const char *preMsg,
+                         const char *prefixMsg,
+                         const char *postMsg)
+{
+    static Bool pathInitialized = False;
+    static FILE *openFile = NULL;
+    FILE *file, *out;
+    XkbFile *rtrn, *mapToUse;
+    XkbFileInfo result;
+    int ok;
+    jmp_buf recovery;
+
+    uSetDebugFile(NullString);
+    uSetErrorFile(NullString);
+    warningLevel = warningLvl;
+    uSetPreErrorMessage((char *) preMsg);
+    uSetErrorPrefix((char *) prefixMsg);
+    uSetPostErrorMessage((char *) postMsg);
+
+    if (setjmp(recovery))
+    {
+        /* a FATAL somewhere in the compiler landed here instead of exiting */
+        if (openFile != NULL)
+        {
+            fclose(openFile);
+            openFile = NULL;
+        }
+        uSetFatalRecovery(NULL);
+        return 1;
+    }
+    uSetFatalRecovery(&recovery);
+
+    /* the include path and atom table survive from one call to the next */
+    if (!pathInitialized)
+    {
+        XkbInitIncludePath();
+        if ((baseDir != NULL) && (baseDir[0] != '\0'))
+            XkbAddDirectoryToPath(baseDir);
+        XkbAddDefaultDirectoriesToPath();
+        XkbInitAtoms(NULL);
+        pathInitialized = True;
+    }
+
+    ok = False;
+    bzero((char *) &result, sizeof(result));
+    file = fopen(input, "r");
+    if (file == NULL)
+    {
+        ERROR1("Cannot open \"%s\" to compile\n", input);
+        uSetFatalRecovery(NULL);
+        return 1;
+    }
+    openFile = file;
+    rtrn = NULL;
+    setScanState((char *) input, 1);
+    if (XKBParseFile(file, &rtrn) && (rtrn != NULL))
+    {
+        /* look for a map with the XkbLC_Default flag, as main() does */
+        for (mapToUse = rtrn; mapToUse;
+             mapToUse = (XkbFile *) mapToUse->common.next)
+        {
+            if (mapToUse->flags & XkbLC_Default)
+                break;
+        }
+        if (!mapToUse)
+            mapToUse = rtrn;
+        result.type = mapToUse->type;
+        if ((result.xkb = XkbAllocKeyboard()) == NULL)
+        {
+            WSGO("Cannot allocate keyboard description\n");
+        }
+        else if ((mapToUse->type == XkmSemanticsFile) ||
+                 (mapToUse->type == XkmLayoutFile) ||
+                 (mapToUse->type == XkmKeymapFile))
+        {
+            ok = CompileKeymap(mapToUse, &result, MergeReplace);
+            result.xkb->device_spec = XkbUseCoreKbd;
+        }
+        else
+        {
+            ERROR1("File \"%s\" is not a keymap file\n", input);
+        }
+    }
+    else
+    {
+        INFO1("Errors encountered in %s; not compiled.\n", input);
+    }
+    fclose(file);
+    openFile = NULL;
+    if (ok)
+    {
+        unlink(output);
+        out = fopen(output, "wb");
+        if (out == NULL)
+        {
+            ERROR1("Cannot open \"%s\" to write keyboard description\n",
+                   output);
+            ok = False;
+        }
+        else
+        {
+            ok = XkbWriteXKMFile(out, &result);
+            if (fclose(out) != 0)
+            {
+                ERROR1("Cannot close \"%s\" properly (not enough space?)\n",
+                       output);
+                ok = False;
+            }
+            if (!ok)
+                unlink(output);
+        }
+    }
+    if (result.xkb != NULL)
+        XkbFreeKeyboard(result.xkb, XkbAllComponentsMask, True);
+    uSetFatalRecovery(NULL);
+    return (ok ? 0 : 1);
+}
@@ -395,4 +395,13 @@ extern int AddMapOnly(char *    /* map */
 extern int GenerateListing(char *       /* filename */
     );
 
+extern int XkbCompCompileKeymapFile(const char * /* input */ ,
+                                    const char * /* output */ ,
+                                    const char * /* baseDir */ ,
+                                    unsigned /* warningLvl */ ,
+                                    const char * /* preMsg */ ,
+                                    const char * /* prefixMsg */ ,
+                                    const char *        /* postMsg */
+    );
+
 #endif /* XKBCOMP_H */
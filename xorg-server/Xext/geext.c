@@ -170,7 +170,7 @@ SGEGenericEvent(xEvent *from, xEvent *to)
     xGenericEvent *gefrom = (xGenericEvent *) from;
     xGenericEvent *geto = (xGenericEvent *) to;
 
-    if ((gefrom->extension & 0x7f) > MAXEXTENSIONS) {
+    if (EXT_MASK(gefrom->extension) >= MAXEXTENSIONS) {
         ErrorF("GE: Invalid extension offset for event.\n");
         return;
     }
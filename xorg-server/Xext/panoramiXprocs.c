@@ -51,6 +51,25 @@ Equipment Corporation.
 #define INPUTONLY_LEGAL_MASK (CWWinGravity | CWEventMask | \
                               CWDontPropagate | CWOverrideRedirect | CWCursor )
 
+/* Returns TRUE if a rendering operation on the root window whose panoramic
+ * extents are [x1,x2) x [y1,y2) can produce output on the given screen.
+ * Each screen's root window only covers that screen, so the operation is
+ * clipped away entirely on screens the extents miss and the fan-out loops
+ * can skip them instead of re-dispatching the whole request.  The extents
+ * are widened by a pixel on each edge to stay on the safe side of the
+ * fill rules.
+ */
+static Bool
+XineramaExtentsOnScreen(int screen, int x1, int y1, int x2, int y2)
+{
+    ScreenPtr pScreen = screenInfo.screens[screen];
+
+    return ((x2 + 1) > pScreen->x &&
+            (x1 - 1) < pScreen->x + (int) pScreen->width &&
+            (y2 + 1) > pScreen->y &&
+            (y1 - 1) < pScreen->y + (int) pScreen->height);
+}
+
 int
 PanoramiXCreateWindow(ClientPtr client)
 {
@@ -1374,6 +1393,7 @@ PanoramiXPolyPoint(ClientPtr client)
     int result, npoint, j;
     xPoint *origPts;
     Bool isRoot;
+    int ext_x1 = 0, ext_y1 = 0, ext_x2 = 0, ext_y2 = 0;
 
     REQUEST(xPolyPointReq);
 
@@ -1397,8 +1417,39 @@ PanoramiXPolyPoint(ClientPtr client)
     if (npoint > 0) {
         origPts = xallocarray(npoint, sizeof(xPoint));
         memcpy((char *) origPts, (char *) &stuff[1], npoint * sizeof(xPoint));
+
+        if (isRoot) {
+            /* Collect the panoramic extents so that screens the points
+             * cannot reach are skipped below.
+             */
+            int i, x = 0, y = 0;
+
+            for (i = 0; i < npoint; i++) {
+                if (stuff->coordMode == CoordModePrevious) {
+                    x += origPts[i].x;
+                    y += origPts[i].y;
+                }
+                else {
+                    x = origPts[i].x;
+                    y = origPts[i].y;
+                }
+                if (i == 0 || x < ext_x1)
+                    ext_x1 = x;
+                if (i == 0 || y < ext_y1)
+                    ext_y1 = y;
+                if (i == 0 || x + 1 > ext_x2)
+                    ext_x2 = x + 1;
+                if (i == 0 || y + 1 > ext_y2)
+                    ext_y2 = y + 1;
+            }
+        }
+
         FOR_NSCREENS_FORWARD(j) {
 
+            if (isRoot &&
+                !XineramaExtentsOnScreen(j, ext_x1, ext_y1, ext_x2, ext_y2))
+                continue;
+
             if (j)
                 memcpy(&stuff[1], origPts, npoint * sizeof(xPoint));
 
@@ -1704,6 +1755,7 @@ PanoramiXFillPoly(ClientPtr client)
     PanoramiXRes *gc, *draw;
     Bool isRoot;
     DDXPointPtr locPts;
+    int ext_x1 = 0, ext_y1 = 0, ext_x2 = 0, ext_y2 = 0;
 
     REQUEST(xFillPolyReq);
 
@@ -1729,8 +1781,39 @@ PanoramiXFillPoly(ClientPtr client)
         locPts = xallocarray(count, sizeof(DDXPointRec));
         memcpy((char *) locPts, (char *) &stuff[1],
                count * sizeof(DDXPointRec));
+
+        if (isRoot) {
+            /* A filled polygon cannot extend beyond the bounding box of
+             * its vertices; skip screens that box misses.
+             */
+            int i, x = 0, y = 0;
+
+            for (i = 0; i < count; i++) {
+                if (stuff->coordMode == CoordModePrevious) {
+                    x += locPts[i].x;
+                    y += locPts[i].y;
+                }
+                else {
+                    x = locPts[i].x;
+                    y = locPts[i].y;
+                }
+                if (i == 0 || x < ext_x1)
+                    ext_x1 = x;
+                if (i == 0 || y < ext_y1)
+                    ext_y1 = y;
+                if (i == 0 || x + 1 > ext_x2)
+                    ext_x2 = x + 1;
+                if (i == 0 || y + 1 > ext_y2)
+                    ext_y2 = y + 1;
+            }
+        }
+
         FOR_NSCREENS_FORWARD(j) {
 
+            if (isRoot &&
+                !XineramaExtentsOnScreen(j, ext_x1, ext_y1, ext_x2, ext_y2))
+                continue;
+
             if (j)
                 memcpy(&stuff[1], locPts, count * sizeof(DDXPointRec));
 
@@ -1770,6 +1853,7 @@ PanoramiXPolyFillRectangle(ClientPtr client)
     PanoramiXRes *gc, *draw;
     Bool isRoot;
     xRectangle *origRects;
+    int ext_x1 = 0, ext_y1 = 0, ext_x2 = 0, ext_y2 = 0;
 
     REQUEST(xPolyFillRectangleReq);
 
@@ -1798,8 +1882,29 @@ PanoramiXPolyFillRectangle(ClientPtr client)
         origRects = xallocarray(things, sizeof(xRectangle));
         memcpy((char *) origRects, (char *) &stuff[1],
                things * sizeof(xRectangle));
+
+        if (isRoot) {
+            /* Filled rectangles stay within their own bounds; skip
+             * screens the combined bounding box misses.
+             */
+            for (i = 0; i < things; i++) {
+                if (i == 0 || origRects[i].x < ext_x1)
+                    ext_x1 = origRects[i].x;
+                if (i == 0 || origRects[i].y < ext_y1)
+                    ext_y1 = origRects[i].y;
+                if (i == 0 || origRects[i].x + origRects[i].width > ext_x2)
+                    ext_x2 = origRects[i].x + origRects[i].width;
+                if (i == 0 || origRects[i].y + origRects[i].height > ext_y2)
+                    ext_y2 = origRects[i].y + origRects[i].height;
+            }
+        }
+
         FOR_NSCREENS_FORWARD(j) {
 
+            if (isRoot &&
+                !XineramaExtentsOnScreen(j, ext_x1, ext_y1, ext_x2, ext_y2))
+                continue;
+
             if (j)
                 memcpy(&stuff[1], origRects, things * sizeof(xRectangle));
 
@@ -1837,6 +1942,7 @@ PanoramiXPolyFillArc(ClientPtr client)
     Bool isRoot;
     int result, narcs, i, j;
     xArc *origArcs;
+    int ext_x1 = 0, ext_y1 = 0, ext_x2 = 0, ext_y2 = 0;
 
     REQUEST(xPolyFillArcReq);
 
@@ -1864,8 +1970,29 @@ PanoramiXPolyFillArc(ClientPtr client)
     if (narcs > 0) {
         origArcs = xallocarray(narcs, sizeof(xArc));
         memcpy((char *) origArcs, (char *) &stuff[1], narcs * sizeof(xArc));
+
+        if (isRoot) {
+            /* A filled arc stays within its bounding rectangle; skip
+             * screens the combined bounding box misses.
+             */
+            for (i = 0; i < narcs; i++) {
+                if (i == 0 || origArcs[i].x < ext_x1)
+                    ext_x1 = origArcs[i].x;
+                if (i == 0 || origArcs[i].y < ext_y1)
+                    ext_y1 = origArcs[i].y;
+                if (i == 0 || origArcs[i].x + origArcs[i].width > ext_x2)
+                    ext_x2 = origArcs[i].x + origArcs[i].width;
+                if (i == 0 || origArcs[i].y + origArcs[i].height > ext_y2)
+                    ext_y2 = origArcs[i].y + origArcs[i].height;
+            }
+        }
+
         FOR_NSCREENS_FORWARD(j) {
 
+            if (isRoot &&
+                !XineramaExtentsOnScreen(j, ext_x1, ext_y1, ext_x2, ext_y2))
+                continue;
+
             if (j)
                 memcpy(&stuff[1], origArcs, narcs * sizeof(xArc));
 
@@ -1925,6 +2052,15 @@ PanoramiXPutImage(ClientPtr client)
     orig_x = stuff->dstX;
     orig_y = stuff->dstY;
     FOR_NSCREENS_BACKWARD(j) {
+        /* The image lands entirely within its destination rectangle, so
+         * screens that rectangle misses can skip the whole dispatch.
+         */
+        if (isRoot &&
+            !XineramaExtentsOnScreen(j, orig_x, orig_y,
+                                     orig_x + stuff->width,
+                                     orig_y + stuff->height))
+            continue;
+
         if (isRoot) {
             stuff->dstX = orig_x - screenInfo.screens[j]->x;
             stuff->dstY = orig_y - screenInfo.screens[j]->y;
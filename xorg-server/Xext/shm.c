@@ -36,6 +36,8 @@ in this Software without prior written authorization from The Open Group.
 #if !defined(_MSC_VER)
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#else
+#include "shmwin.h"
 #endif
 #ifdef HAVE_MEMFD_CREATE
 #include <sys/mman.h>
@@ -59,7 +61,9 @@ in this Software without prior written authorization from The Open Group.
 #include "xace.h"
 #include <X11/extensions/shmproto.h>
 #include <X11/Xfuncproto.h>
+#if !defined(_MSC_VER)
 #include <sys/mman.h>
+#endif
 #include "protocol-versions.h"
 #include "busfault.h"
 
@@ -341,9 +345,6 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
             if (uid == 0) {
                 return 0;
             }
-            #ifdef _MSC_VER
-            __asm int 3;
-            #else
             /* Check the owner */
             if (SHMPERM_UID(perm) == uid || SHMPERM_CUID(perm) == uid) {
                 mask = S_IRUSR;
@@ -352,14 +353,10 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
                 }
                 return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
             }
-            #endif
         }
 
         if (gidset) {
             /* Check the group */
-            #ifdef _MSC_VER
-            __asm int 3;
-            #else
             if (SHMPERM_GID(perm) == gid || SHMPERM_CGID(perm) == gid) {
                 mask = S_IRGRP;
                 if (!readonly) {
@@ -367,20 +364,14 @@ shm_access(ClientPtr client, SHMPERM_TYPE * perm, int readonly)
                 }
                 return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
             }
-            #endif
         }
     }
-            #ifdef _MSC_VER
-            __asm int 3;
-            return -1;
-            #else
     /* Otherwise, check everyone else */
     mask = S_IROTH;
     if (!readonly) {
         mask |= S_IWOTH;
     }
     return (SHMPERM_MODE(perm) & mask) == mask ? 0 : -1;
-    #endif
 }
 
 static int
@@ -451,7 +442,6 @@ ShmDetachSegment(void *value, /* must conform to DeleteType */
 
     if (--shmdesc->refcnt)
         return TRUE;
-#ifndef _MSC_VER
 #if SHM_FD_PASSING
     if (shmdesc->is_fd) {
         if (shmdesc->busfault)
@@ -460,7 +450,6 @@ ShmDetachSegment(void *value, /* must conform to DeleteType */
     } else
 #endif
         shmdt(shmdesc->addr);
-#endif
     for (prev = &Shmsegs; *prev != shmdesc; prev = &(*prev)->next);
     *prev = shmdesc->next;
     free(shmdesc);
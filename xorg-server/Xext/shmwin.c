@@ -0,0 +1,173 @@
+/*
+ * SysV shared memory emulation over named Windows file mappings.
+ *
+ * See shmwin.h for the naming convention shared with local clients.
+ *
+ * Copyright 1989, 1998  The Open Group
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.
+ */
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <X11/Xwindows.h>
+#include <stdio.h>
+
+#include "misc.h"
+#include "os.h"
+#include "shmwin.h"
+
+#define WINSHM_NAME_FMT "Local\\X11-shm-%u"
+
+/* One record per attached segment view */
+typedef struct _winShmSeg {
+    int shmid;
+    HANDLE hMapping;
+    void *addr;
+    size_t size;
+    struct _winShmSeg *next;
+} winShmSeg;
+
+static winShmSeg *g_pSegs;
+
+static winShmSeg *
+winShmFindById(int shmid)
+{
+    winShmSeg *pSeg;
+
+    for (pSeg = g_pSegs; pSeg; pSeg = pSeg->next)
+        if (pSeg->shmid == shmid)
+            return pSeg;
+    return NULL;
+}
+
+/*
+ * Map a view of the client's file mapping into our address space
+ */
+
+void *
+shmat(int shmid, const void *shmaddr, int shmflg)
+{
+    char szName[64];
+    HANDLE hMapping;
+    DWORD dwAccess;
+    void *addr;
+    MEMORY_BASIC_INFORMATION mbi;
+    winShmSeg *pSeg;
+
+    /* The protocol always lets us pick the address */
+    if (shmaddr != NULL)
+        return (void *) -1;
+
+    snprintf(szName, sizeof(szName), WINSHM_NAME_FMT, (unsigned int) shmid);
+
+    dwAccess = FILE_MAP_READ;
+    if (!(shmflg & SHM_RDONLY))
+        dwAccess |= FILE_MAP_WRITE;
+
+    hMapping = OpenFileMapping(dwAccess, FALSE, szName);
+    if (hMapping == NULL) {
+        ErrorF("shmat - OpenFileMapping (\"%s\") failed: %d\n",
+               szName, (int) GetLastError());
+        return (void *) -1;
+    }
+
+    addr = MapViewOfFile(hMapping, dwAccess, 0, 0, 0);
+    if (addr == NULL) {
+        ErrorF("shmat - MapViewOfFile failed: %d\n", (int) GetLastError());
+        CloseHandle(hMapping);
+        return (void *) -1;
+    }
+
+    /* Recover the view size for shmctl(IPC_STAT) */
+    if (VirtualQuery(addr, &mbi, sizeof(mbi)) == 0) {
+        UnmapViewOfFile(addr);
+        CloseHandle(hMapping);
+        return (void *) -1;
+    }
+
+    pSeg = malloc(sizeof(winShmSeg));
+    if (pSeg == NULL) {
+        UnmapViewOfFile(addr);
+        CloseHandle(hMapping);
+        return (void *) -1;
+    }
+
+    pSeg->shmid = shmid;
+    pSeg->hMapping = hMapping;
+    pSeg->addr = addr;
+    pSeg->size = mbi.RegionSize;
+    pSeg->next = g_pSegs;
+    g_pSegs = pSeg;
+
+    return addr;
+}
+
+/*
+ * Unmap a previously attached view
+ */
+
+int
+shmdt(const void *shmaddr)
+{
+    winShmSeg **ppSeg, *pSeg;
+
+    for (ppSeg = &g_pSegs; *ppSeg; ppSeg = &(*ppSeg)->next)
+        if ((*ppSeg)->addr == shmaddr)
+            break;
+
+    pSeg = *ppSeg;
+    if (pSeg == NULL)
+        return -1;
+
+    *ppSeg = pSeg->next;
+
+    UnmapViewOfFile(pSeg->addr);
+    CloseHandle(pSeg->hMapping);
+    free(pSeg);
+
+    return 0;
+}
+
+/*
+ * IPC_STAT reports the view size of an attached segment; IPC_RMID is
+ * a no-op because a file mapping lives exactly as long as the handles
+ * referencing it.
+ */
+
+int
+shmctl(int shmid, int cmd, struct shmid_ds *buf)
+{
+    winShmSeg *pSeg;
+
+    switch (cmd) {
+    case IPC_STAT:
+        pSeg = winShmFindById(shmid);
+        if (pSeg == NULL)
+            return -1;
+
+        buf->shm_segsz = pSeg->size;
+
+        /* Access control is done by the session-local kernel object
+           namespace, so report world read/write to shm_access() */
+        buf->shm_perm.uid = 0;
+        buf->shm_perm.cuid = 0;
+        buf->shm_perm.gid = 0;
+        buf->shm_perm.cgid = 0;
+        buf->shm_perm.mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP
+            | S_IROTH | S_IWOTH;
+        return 0;
+
+    case IPC_RMID:
+        return 0;
+
+    default:
+        return -1;
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * SysV shared memory emulation over named Windows file mappings.
+ *
+ * Native Win32 clients cannot create SysV segments, so the MIT-SHM
+ * shmid carried in the protocol is instead taken as a token naming a
+ * session-local file mapping, "Local\X11-shm-<shmid>".  A local client
+ * creates the mapping, passes the token in ShmAttach, and the server
+ * opens a view of the same pages; pixel data for ShmPutImage then
+ * never crosses the transport.
+ *
+ * Only the small subset of the SysV API that Xext/shm.c uses is
+ * provided here.
+ *
+ * Copyright 1989, 1998  The Open Group
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation.
+ */
+
+#ifndef _SHMWIN_H_
+#define _SHMWIN_H_
+
+#include <stddef.h>
+
+/* Control commands */
+#define IPC_RMID 0
+#define IPC_STAT 2
+
+/* shmat() flags */
+#define SHM_RDONLY 010000
+
+struct ipc_perm {
+    int uid;
+    int cuid;
+    int gid;
+    int cgid;
+    int mode;
+};
+
+struct shmid_ds {
+    struct ipc_perm shm_perm;
+    size_t shm_segsz;
+};
+
+void *shmat(int shmid, const void *shmaddr, int shmflg);
+int shmdt(const void *shmaddr);
+int shmctl(int shmid, int cmd, struct shmid_ds *buf);
+
+/* Permission bits, if the C runtime does not provide them */
+#ifndef S_IRUSR
+#define S_IRUSR 0400
+#define S_IWUSR 0200
+#endif
+#ifndef S_IRGRP
+#define S_IRGRP 0040
+#define S_IWGRP 0020
+#endif
+#ifndef S_IROTH
+#define S_IROTH 0004
+#define S_IWOTH 0002
+#endif
+
+/* No process credentials on Win32; the session-local ("Local\")
+   kernel namespace already restricts mappings to this login session */
+#ifndef geteuid
+#define geteuid() 0
+#define getegid() 0
+#endif
+
+#endif                          /* _SHMWIN_H_ */
@@ -110,6 +110,18 @@ static const char *WARN_INVALID_COUNTER_ALARM =
 
 static void SyncComputeBracketValues(SyncCounter *);
 
+static Bool SyncTriggerIsPositive(const SyncTrigger *);
+
+static int SyncBracketIndexLowerBound(SysCounterInfo *, int64_t);
+
+static int SyncBracketIndexUpperBound(SysCounterInfo *, int64_t);
+
+static Bool SyncBracketIndexInsert(SyncCounter *, SyncTrigger *);
+
+static void SyncBracketIndexRemove(SyncCounter *, SyncTrigger *);
+
+static void SyncBracketIndexReposition(SyncCounter *, SyncTrigger *);
+
 static void SyncInitServerTime(void);
 
 static void SyncInitIdleTime(void);
@@ -174,8 +186,10 @@ SyncDeleteTriggerFromSyncObject(SyncTrigger * pTrigger)
     if (SYNC_COUNTER == pTrigger->pSync->type) {
         pCounter = (SyncCounter *) pTrigger->pSync;
 
-        if (IsSystemCounter(pCounter))
+        if (IsSystemCounter(pCounter)) {
+            SyncBracketIndexRemove(pCounter, pTrigger);
             SyncComputeBracketValues(pCounter);
+        }
     }
     else if (SYNC_FENCE == pTrigger->pSync->type) {
         SyncFence *pFence = (SyncFence *) pTrigger->pSync;
@@ -209,8 +223,14 @@ SyncAddTriggerToSyncObject(SyncTrigger * pTrigger)
     if (SYNC_COUNTER == pTrigger->pSync->type) {
         pCounter = (SyncCounter *) pTrigger->pSync;
 
-        if (IsSystemCounter(pCounter))
+        if (IsSystemCounter(pCounter)) {
+            if (!SyncBracketIndexInsert(pCounter, pTrigger)) {
+                pTrigger->pSync->pTriglist = pCur->next;
+                free(pCur);
+                return BadAlloc;
+            }
             SyncComputeBracketValues(pCounter);
+        }
     }
     else if (SYNC_FENCE == pTrigger->pSync->type) {
         SyncFence *pFence = (SyncFence *) pTrigger->pSync;
@@ -409,6 +429,8 @@ SyncInitTrigger(ClientPtr client, SyncTrigger * pTrigger, XID syncObject,
             return rc;
     }
     else if (pCounter && IsSystemCounter(pCounter)) {
+        /* test_value may have changed; keep the sorted index in step */
+        SyncBracketIndexReposition(pCounter, pTrigger);
         SyncComputeBracketValues(pCounter);
     }
 
@@ -599,6 +621,11 @@ SyncAlarmTriggerFired(SyncTrigger * pTrigger)
      */
     SyncSendAlarmNotifyEvents(pAlarm);
     pTrigger->test_value = new_test_value;
+
+    /* the re-armed test value moves the trigger in the sorted index */
+    if (pTrigger->pSync && SYNC_COUNTER == pTrigger->pSync->type &&
+        IsSystemCounter(((SyncCounter *) pTrigger->pSync)))
+        SyncBracketIndexReposition((SyncCounter *) pTrigger->pSync, pTrigger);
 }
 
 /*  This function is called when an Await unblocks, either as a result
@@ -707,19 +734,67 @@ SyncUpdateCounter(SyncCounter *pCounter, int64_t newval)
 /*  This function should always be used to change a counter's value so that
  *  any triggers depending on the counter will be checked.
  */
+/*
+ * Fire the triggers on a system counter that the change to newval could
+ * have satisfied, using the sorted index: positive tests can only hold
+ * for test_value <= newval and negative tests for test_value >= newval,
+ * so only those two ranges are visited.  The due triggers are
+ * snapshotted first because TriggerFired may delete triggers or, for a
+ * re-arming alarm, move them within the index.  Returns FALSE if the
+ * snapshot could not be allocated, in which case the caller falls back
+ * to walking the whole trigger list.
+ */
+static Bool
+SyncFireDueTriggers(SyncCounter * pCounter, int64_t oldval)
+{
+    SysCounterInfo *psci = pCounter->pSysCounterInfo;
+    SyncTrigger **due;
+    int num_due = 0;
+    int i;
+
+    if (psci->num_triggers == 0)
+        return TRUE;
+
+    due = xallocarray(psci->num_triggers, sizeof(SyncTrigger *));
+    if (!due)
+        return FALSE;
+
+    for (i = 0; i < SyncBracketIndexUpperBound(psci, pCounter->value); i++)
+        if (SyncTriggerIsPositive(psci->trigger_index[i]))
+            due[num_due++] = psci->trigger_index[i];
+
+    for (i = SyncBracketIndexLowerBound(psci, pCounter->value);
+         i < psci->num_triggers; i++)
+        if (!SyncTriggerIsPositive(psci->trigger_index[i]))
+            due[num_due++] = psci->trigger_index[i];
+
+    for (i = 0; i < num_due; i++)
+        if ((*due[i]->CheckTrigger) (due[i], oldval))
+            (*due[i]->TriggerFired) (due[i]);
+
+    free(due);
+    return TRUE;
+}
+
 void
 SyncChangeCounter(SyncCounter * pCounter, int64_t newval)
 {
     SyncTriggerList *ptl, *pnext;
     int64_t oldval;
+    Bool scanned = FALSE;
 
     oldval = SyncUpdateCounter(pCounter, newval);
 
+    if (IsSystemCounter(pCounter))
+        scanned = SyncFireDueTriggers(pCounter, oldval);
+
     /* run through triggers to see if any become true */
-    for (ptl = pCounter->sync.pTriglist; ptl; ptl = pnext) {
-        pnext = ptl->next;
-        if ((*ptl->pTrigger->CheckTrigger) (ptl->pTrigger, oldval))
-            (*ptl->pTrigger->TriggerFired) (ptl->pTrigger);
+    if (!scanned) {
+        for (ptl = pCounter->sync.pTriglist; ptl; ptl = pnext) {
+            pnext = ptl->next;
+            if ((*ptl->pTrigger->CheckTrigger) (ptl->pTrigger, oldval))
+                (*ptl->pTrigger->TriggerFired) (ptl->pTrigger);
+        }
     }
 
     if (IsSystemCounter(pCounter)) {
@@ -1002,6 +1077,9 @@ SyncCreateSystemCounter(const char *name,
         psci->private = NULL;
         psci->bracket_greater = LLONG_MAX;
         psci->bracket_less = LLONG_MIN;
+        psci->trigger_index = NULL;
+        psci->num_triggers = 0;
+        psci->size_triggers = 0;
         xorg_list_add(&psci->entry, &SysCounterList);
     }
     return pCounter;
@@ -1015,15 +1093,143 @@ SyncDestroySystemCounter(void *pSysCounter)
     FreeResource(pCounter->sync.id, RT_NONE);
 }
 
+/*
+ * Sorted index of the triggers on a system counter, ordered by
+ * ascending test_value.  Compositors leave hundreds of alarms on
+ * SERVERTIME and IDLETIME, and walking the whole trigger list both to
+ * recompute the brackets and to check triggers on every counter change
+ * made each wakeup O(number of alarms).  With the index, bracket
+ * recomputation binary-searches to the counter value and scans outward
+ * to the nearest qualifying trigger, and the wakeup scan visits only
+ * the triggers whose threshold the change could have satisfied.
+ */
+
+static Bool
+SyncTriggerIsPositive(const SyncTrigger * pTrigger)
+{
+    return pTrigger->test_type == XSyncPositiveComparison ||
+        pTrigger->test_type == XSyncPositiveTransition;
+}
+
+/* First index whose test_value is not less than value */
+static int
+SyncBracketIndexLowerBound(SysCounterInfo * psci, int64_t value)
+{
+    int lo = 0;
+    int hi = psci->num_triggers;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (psci->trigger_index[mid]->test_value < value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* First index whose test_value is greater than value */
+static int
+SyncBracketIndexUpperBound(SysCounterInfo * psci, int64_t value)
+{
+    int lo = 0;
+    int hi = psci->num_triggers;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (psci->trigger_index[mid]->test_value <= value)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static Bool
+SyncBracketIndexInsert(SyncCounter * pCounter, SyncTrigger * pTrigger)
+{
+    SysCounterInfo *psci = pCounter->pSysCounterInfo;
+    int i;
+
+    if (psci->num_triggers == psci->size_triggers) {
+        int size = psci->size_triggers ? psci->size_triggers * 2 : 16;
+        SyncTrigger **larger;
+
+        larger = realloc(psci->trigger_index, size * sizeof(SyncTrigger *));
+        if (!larger)
+            return FALSE;
+        psci->trigger_index = larger;
+        psci->size_triggers = size;
+    }
+
+    i = SyncBracketIndexUpperBound(psci, pTrigger->test_value);
+    memmove(&psci->trigger_index[i + 1], &psci->trigger_index[i],
+            (psci->num_triggers - i) * sizeof(SyncTrigger *));
+    psci->trigger_index[i] = pTrigger;
+    psci->num_triggers++;
+    return TRUE;
+}
+
+static void
+SyncBracketIndexRemove(SyncCounter * pCounter, SyncTrigger * pTrigger)
+{
+    SysCounterInfo *psci = pCounter->pSysCounterInfo;
+    int i;
+
+    for (i = 0; i < psci->num_triggers; i++) {
+        if (psci->trigger_index[i] == pTrigger) {
+            memmove(&psci->trigger_index[i], &psci->trigger_index[i + 1],
+                    (psci->num_triggers - i - 1) * sizeof(SyncTrigger *));
+            psci->num_triggers--;
+            return;
+        }
+    }
+}
+
+/*
+ * A trigger's test_value changed; move it to its new position in the
+ * sorted index.  Cannot fail: the remove leaves a free slot, so the
+ * insert never needs to grow the array.
+ */
+static void
+SyncBracketIndexReposition(SyncCounter * pCounter, SyncTrigger * pTrigger)
+{
+    SyncBracketIndexRemove(pCounter, pTrigger);
+    SyncBracketIndexInsert(pCounter, pTrigger);
+}
+
+/*
+ * A trigger with a test_value above the counter value can contribute a
+ * bracket_greater candidate if the counter type still allows motion in
+ * the trigger's direction; one below the value can likewise contribute
+ * a bracket_less candidate.  The counter-type filter is symmetric for
+ * both directions.
+ */
+static Bool
+SyncBracketTriggerQualifies(const SyncTrigger * pTrigger, SyncCounterType ct)
+{
+    switch (pTrigger->test_type) {
+    case XSyncPositiveComparison:
+    case XSyncNegativeTransition:
+        return ct != XSyncCounterNeverIncreases;
+    case XSyncNegativeComparison:
+    case XSyncPositiveTransition:
+        return ct != XSyncCounterNeverDecreases;
+    }
+    return FALSE;
+}
+
 static void
 SyncComputeBracketValues(SyncCounter * pCounter)
 {
-    SyncTriggerList *pCur;
     SyncTrigger *pTrigger;
     SysCounterInfo *psci;
     int64_t *pnewgtval = NULL;
     int64_t *pnewltval = NULL;
     SyncCounterType ct;
+    int i;
 
     if (!pCounter)
         return;
@@ -1036,73 +1242,57 @@ SyncComputeBracketValues(SyncCounter * pCounter)
     psci->bracket_greater = LLONG_MAX;
     psci->bracket_less = LLONG_MIN;
 
-    for (pCur = pCounter->sync.pTriglist; pCur; pCur = pCur->next) {
-        pTrigger = pCur->pTrigger;
-
-        if (pTrigger->test_type == XSyncPositiveComparison &&
-            ct != XSyncCounterNeverIncreases) {
-            if (pCounter->value < pTrigger->test_value &&
-                pTrigger->test_value < psci->bracket_greater) {
-                psci->bracket_greater = pTrigger->test_value;
-                pnewgtval = &psci->bracket_greater;
-            }
-            else if (pCounter->value > pTrigger->test_value &&
-                     pTrigger->test_value > psci->bracket_less) {
-                    psci->bracket_less = pTrigger->test_value;
-                    pnewltval = &psci->bracket_less;
-            }
-        }
-        else if (pTrigger->test_type == XSyncNegativeComparison &&
-                 ct != XSyncCounterNeverDecreases) {
-            if (pCounter->value > pTrigger->test_value &&
-                pTrigger->test_value > psci->bracket_less) {
-                psci->bracket_less = pTrigger->test_value;
-                pnewltval = &psci->bracket_less;
-            }
-            else if (pCounter->value < pTrigger->test_value &&
-                     pTrigger->test_value < psci->bracket_greater) {
-                    psci->bracket_greater = pTrigger->test_value;
-                    pnewgtval = &psci->bracket_greater;
-            }
-        }
-        else if (pTrigger->test_type == XSyncNegativeTransition &&
-                 ct != XSyncCounterNeverIncreases) {
-            if (pCounter->value >= pTrigger->test_value &&
-                pTrigger->test_value > psci->bracket_less) {
-                    /*
-                     * If the value is exactly equal to our threshold, we want one
-                     * more event in the negative direction to ensure we pick up
-                     * when the value is less than this threshold.
-                     */
-                    psci->bracket_less = pTrigger->test_value;
-                    pnewltval = &psci->bracket_less;
-            }
-            else if (pCounter->value < pTrigger->test_value &&
-                     pTrigger->test_value < psci->bracket_greater) {
-                    psci->bracket_greater = pTrigger->test_value;
-                    pnewgtval = &psci->bracket_greater;
-            }
+    /*
+     * Candidates for bracket_greater have test_value >= value and
+     * candidates for bracket_less have test_value <= value, so scan
+     * outward from the counter value in the sorted index; the first
+     * qualifying trigger in each direction is the tightest bracket.
+     */
+    for (i = SyncBracketIndexLowerBound(psci, pCounter->value);
+         i < psci->num_triggers; i++) {
+        pTrigger = psci->trigger_index[i];
+
+        if (pTrigger->test_value == pCounter->value) {
+            /*
+             * If the value is exactly equal to our threshold, we
+             * want one more event in the positive direction to
+             * ensure we pick up when the value *exceeds* this
+             * threshold; only a PositiveTransition needs that.
+             */
+            if (pTrigger->test_type != XSyncPositiveTransition ||
+                ct == XSyncCounterNeverDecreases)
+                continue;
         }
-        else if (pTrigger->test_type == XSyncPositiveTransition &&
-                 ct != XSyncCounterNeverDecreases) {
-            if (pCounter->value <= pTrigger->test_value &&
-                pTrigger->test_value < psci->bracket_greater) {
-                    /*
-                     * If the value is exactly equal to our threshold, we
-                     * want one more event in the positive direction to
-                     * ensure we pick up when the value *exceeds* this
-                     * threshold.
-                     */
-                    psci->bracket_greater = pTrigger->test_value;
-                    pnewgtval = &psci->bracket_greater;
-            }
-            else if (pCounter->value > pTrigger->test_value &&
-                     pTrigger->test_value > psci->bracket_less) {
-                    psci->bracket_less = pTrigger->test_value;
-                    pnewltval = &psci->bracket_less;
-            }
+        else if (!SyncBracketTriggerQualifies(pTrigger, ct))
+            continue;
+
+        psci->bracket_greater = pTrigger->test_value;
+        pnewgtval = &psci->bracket_greater;
+        break;
+    }
+
+    for (i = SyncBracketIndexUpperBound(psci, pCounter->value) - 1;
+         i >= 0; i--) {
+        pTrigger = psci->trigger_index[i];
+
+        if (pTrigger->test_value == pCounter->value) {
+            /*
+             * If the value is exactly equal to our threshold, we want
+             * one more event in the negative direction to ensure we
+             * pick up when the value is less than this threshold; only
+             * a NegativeTransition needs that.
+             */
+            if (pTrigger->test_type != XSyncNegativeTransition ||
+                ct == XSyncCounterNeverIncreases)
+                continue;
         }
-    }                           /* end for each trigger */
+        else if (!SyncBracketTriggerQualifies(pTrigger, ct))
+            continue;
+
+        psci->bracket_less = pTrigger->test_value;
+        pnewltval = &psci->bracket_less;
+        break;
+    }
 
     (*psci->BracketValues) ((void *) pCounter, pnewltval, pnewgtval);
 
@@ -1155,6 +1345,7 @@ FreeCounter(void *env, XID id)
         }
         if (IsSystemCounter(pCounter)) {
             xorg_list_del(&pCounter->pSysCounterInfo->entry);
+            free(pCounter->pSysCounterInfo->trigger_index);
             free(pCounter->pSysCounterInfo->name);
             free(pCounter->pSysCounterInfo->private);
             free(pCounter->pSysCounterInfo);
@@ -85,6 +85,16 @@ typedef struct _SysCounterInfo {
     SyncSystemCounterBracketValues BracketValues;
     void *private;
     struct xorg_list entry;
+
+    /*
+     * The counter's triggers sorted by ascending test_value, so that
+     * bracket recomputation and the wakeup trigger scan only visit the
+     * triggers near the counter value instead of walking the whole
+     * trigger list on every counter change.
+     */
+    SyncTrigger **trigger_index;
+    int num_triggers;
+    int size_triggers;
 } SysCounterInfo;
 
 typedef struct _SyncAlarmClientList {
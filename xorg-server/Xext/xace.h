@@ -62,9 +62,17 @@ extern _X_EXPORT CallbackListPtr XaceHooks[XACE_NUM_HOOKS];
 extern _X_EXPORT int XaceHook(int /*hook */ ,
                               ...       /*appropriate args for hook */
     );
+/* Checking the callback list inline keeps the no-policy case down to a
+ * load and branch; the out-of-line call with its argument marshalling
+ * only happens once a security module has registered for the hook. */
+#define XaceHook(hook, ...) \
+    (XaceHooks[(hook)] ? \
+    XaceHook((hook), __VA_ARGS__) : \
+    Success)
 
 /* determine whether any callbacks are present for the XACE hook */
 extern _X_EXPORT int XaceHookIsSet(int hook);
+#define XaceHookIsSet(hook) (XaceHooks[(hook)] != NULL)
 
 /* Special-cased hook functions
  */
@@ -77,8 +85,17 @@ extern _X_EXPORT int XaceHookDispatch(ClientPtr ptr, int major);
 extern _X_EXPORT int XaceHookPropertyAccess(ClientPtr ptr, WindowPtr pWin,
                                             PropertyPtr *ppProp,
                                             Mask access_mode);
+#define XaceHookPropertyAccess(c, w, pp, am) \
+    (XaceHooks[XACE_PROPERTY_ACCESS] ? \
+    XaceHookPropertyAccess((c), (w), (pp), (am)) : \
+    Success)
+
 extern _X_EXPORT int XaceHookSelectionAccess(ClientPtr ptr, Selection ** ppSel,
                                              Mask access_mode);
+#define XaceHookSelectionAccess(c, ps, am) \
+    (XaceHooks[XACE_SELECTION_ACCESS] ? \
+    XaceHookSelectionAccess((c), (ps), (am)) : \
+    Success)
 
 /* Register a callback for a given hook.
  */
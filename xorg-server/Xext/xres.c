@@ -412,6 +412,133 @@ ProcXResQueryClientPixmapBytes(ClientPtr client)
     return Success;
 }
 
+/** @brief Implements XResQueryClientLatency, a server-side addition to
+    the X-Resource protocol.  Returns the queried client's per-major-
+    opcode request latency histograms, as accumulated by the dispatch
+    loop (see RecordRequestLatency in dix/dispatch.c).  Collection is
+    off until the first query for a client arms it, so the first reply
+    is all zeroes and counts accumulate from that point on. */
+static int
+ProcXResQueryClientLatency(ClientPtr client)
+{
+    REQUEST(xXResQueryClientLatencyReq);
+    xXResQueryClientLatencyReply rep;
+    ClientPtr resClient;
+    int clientID, op, b;
+    CARD32 num_opcodes = 0;
+
+    REQUEST_SIZE_MATCH(xXResQueryClientLatencyReq);
+
+    clientID = CLIENT_ID(stuff->xid);
+
+    if ((clientID >= currentMaxClients) || !clients[clientID]) {
+        client->errorValue = stuff->xid;
+        return BadValue;
+    }
+    resClient = clients[clientID];
+
+    if (!StartClientLatencyRecording(resClient))
+        return BadAlloc;
+
+    /* Only opcodes with samples are reported */
+    for (op = 0; op < 256; op++)
+        for (b = 0; b < CLIENT_LATENCY_BUCKETS; b++)
+            if (resClient->requestLatency[op * CLIENT_LATENCY_BUCKETS + b]) {
+                num_opcodes++;
+                break;
+            }
+
+    rep = (xXResQueryClientLatencyReply) {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = num_opcodes * (1 + CLIENT_LATENCY_BUCKETS),
+        .num_opcodes = num_opcodes,
+        .num_buckets = CLIENT_LATENCY_BUCKETS
+    };
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swapl(&rep.num_opcodes);
+        swapl(&rep.num_buckets);
+    }
+    WriteToClient(client, sizeof(xXResQueryClientLatencyReply), &rep);
+
+    for (op = 0; op < 256; op++) {
+        CARD32 entry[1 + CLIENT_LATENCY_BUCKETS];
+        Bool any = FALSE;
+
+        for (b = 0; b < CLIENT_LATENCY_BUCKETS; b++) {
+            entry[1 + b] =
+                resClient->requestLatency[op * CLIENT_LATENCY_BUCKETS + b];
+            if (entry[1 + b])
+                any = TRUE;
+        }
+        if (!any)
+            continue;
+
+        entry[0] = op;
+        if (client->swapped) {
+            for (b = 0; b < 1 + CLIENT_LATENCY_BUCKETS; b++)
+                swapl(&entry[b]);
+        }
+        WriteToClient(client, sizeof(entry), entry);
+    }
+
+    return Success;
+}
+
+/** @brief Implements XResQueryWindowFrameTiming, a server-side addition
+    to the X-Resource protocol.  Returns the frame count and frame
+    interval histogram recorded for a window by DBE buffer swaps and
+    Present executions (see FrameTimingRecord in dix/dixutils.c).
+    Collection is always on; windows that have never presented, or whose
+    slot has been recycled, report zero frames. */
+static int
+ProcXResQueryWindowFrameTiming(ClientPtr client)
+{
+    REQUEST(xXResQueryWindowFrameTimingReq);
+    xXResQueryWindowFrameTimingReply rep;
+    CARD32 intervals[FRAME_TIMING_BUCKETS] = { 0 };
+    WindowPtr pWin;
+    FrameTimingSlot *slot;
+    int rc, b;
+
+    REQUEST_SIZE_MATCH(xXResQueryWindowFrameTimingReq);
+
+    rc = dixLookupWindow(&pWin, stuff->window, client, DixGetAttrAccess);
+    if (rc != Success)
+        return rc;
+
+    rep = (xXResQueryWindowFrameTimingReply) {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = FRAME_TIMING_BUCKETS,
+        .num_buckets = FRAME_TIMING_BUCKETS
+    };
+
+    slot = FrameTimingLookup(stuff->window);
+    if (slot) {
+        rep.frames = slot->frames;
+        rep.msecSinceLast = GetTimeInMillis() - slot->lastTime;
+        for (b = 0; b < FRAME_TIMING_BUCKETS; b++)
+            intervals[b] = slot->intervals[b];
+    }
+
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.length);
+        swapl(&rep.frames);
+        swapl(&rep.msecSinceLast);
+        swapl(&rep.num_buckets);
+        for (b = 0; b < FRAME_TIMING_BUCKETS; b++)
+            swapl(&intervals[b]);
+    }
+    WriteToClient(client, sizeof(rep), &rep);
+    WriteToClient(client, sizeof(intervals), intervals);
+
+    return Success;
+}
+
 /** @brief Finds out if a client's information need to be put into the
     response; marks client having been handled, if that is the case.
 
@@ -1011,6 +1138,10 @@ ProcResDispatch(ClientPtr client)
         return ProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return ProcXResQueryResourceBytes(client);
+    case X_XResQueryClientLatency:
+        return ProcXResQueryClientLatency(client);
+    case X_XResQueryWindowFrameTiming:
+        return ProcXResQueryWindowFrameTiming(client);
     default: break;
     }
 
@@ -1074,6 +1205,24 @@ SProcXResQueryResourceBytes (ClientPtr client)
     return ProcXResQueryResourceBytes(client);
 }
 
+static int _X_COLD
+SProcXResQueryClientLatency(ClientPtr client)
+{
+    REQUEST(xXResQueryClientLatencyReq);
+    REQUEST_SIZE_MATCH(xXResQueryClientLatencyReq);
+    swapl(&stuff->xid);
+    return ProcXResQueryClientLatency(client);
+}
+
+static int _X_COLD
+SProcXResQueryWindowFrameTiming(ClientPtr client)
+{
+    REQUEST(xXResQueryWindowFrameTimingReq);
+    REQUEST_SIZE_MATCH(xXResQueryWindowFrameTimingReq);
+    swapl(&stuff->window);
+    return ProcXResQueryWindowFrameTiming(client);
+}
+
 static int _X_COLD
 SProcResDispatch (ClientPtr client)
 {
@@ -1093,6 +1242,10 @@ SProcResDispatch (ClientPtr client)
         return SProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return SProcXResQueryResourceBytes(client);
+    case X_XResQueryClientLatency:
+        return SProcXResQueryClientLatency(client);
+    case X_XResQueryWindowFrameTiming:
+        return SProcXResQueryWindowFrameTiming(client);
     default: break;
     }
 
@@ -148,6 +148,147 @@ ProcXTestCompareCursor(ClientPtr client)
     return Success;
 }
 
+/*
+ * Inject one parsed fake event.  Sets *pneed_ptr_update when the event
+ * requires a cursor sprite update (so callers can defer it to the end
+ * of a batch), and *pslept when the event carried a delay and the
+ * client has been put to sleep to re-execute the request later.
+ */
+static int
+XTestFakeInputInject(ClientPtr client, DeviceIntPtr dev, xEvent *ev,
+                     int type, int flags, Bool extension, Bool batched,
+                     int firstValuator, int numValuators, int *valuators,
+                     Bool *pneed_ptr_update, Bool *pslept)
+{
+    WindowPtr root;
+    ValuatorMask mask;
+    int nevents = 0;
+    int i, rc;
+
+    /* If the event has a time set, wait for it to pass */
+    if (ev->u.keyButtonPointer.time) {
+        TimeStamp activateTime;
+        CARD32 ms;
+
+        if (batched) {
+            /*
+             * Sleeping re-executes the whole request, which would
+             * re-inject the events already processed, so events in a
+             * batch must not carry a delay.
+             */
+            client->errorValue = ev->u.keyButtonPointer.time;
+            return BadValue;
+        }
+
+        activateTime = currentTime;
+        ms = activateTime.milliseconds + ev->u.keyButtonPointer.time;
+        if (ms < activateTime.milliseconds)
+            activateTime.months++;
+        activateTime.milliseconds = ms;
+        ev->u.keyButtonPointer.time = 0;
+
+        /* see mbuf.c:QueueDisplayRequest (from the deprecated Multibuffer
+         * extension) for code similar to this */
+
+        if (!ClientSleepUntil(client, &activateTime, NULL, NULL)) {
+            return BadAlloc;
+        }
+        /* swap the request back so we can simply re-execute it */
+        if (client->swapped) {
+            xReq *req = (xReq *) client->requestBuffer;
+
+            (void) XTestSwapFakeInput(client, req);
+            swaps(&req->length);
+        }
+        ResetCurrentRequest(client);
+        client->sequence--;
+        *pslept = TRUE;
+        return Success;
+    }
+
+    switch (type) {
+    case KeyPress:
+    case KeyRelease:
+        if (!dev->key)
+            return BadDevice;
+
+        if (ev->u.u.detail < dev->key->xkbInfo->desc->min_key_code ||
+            ev->u.u.detail > dev->key->xkbInfo->desc->max_key_code) {
+            client->errorValue = ev->u.u.detail;
+            return BadValue;
+        }
+        break;
+    case MotionNotify:
+        if (!dev->valuator)
+            return BadDevice;
+
+        if (!(extension || ev->u.keyButtonPointer.root == None)) {
+            rc = dixLookupWindow(&root, ev->u.keyButtonPointer.root,
+                                 client, DixGetAttrAccess);
+            if (rc != Success)
+                return rc;
+            if (root->parent) {
+                client->errorValue = ev->u.keyButtonPointer.root;
+                return BadValue;
+            }
+
+            /* Add the root window's offset to the valuators */
+            if ((flags & POINTER_ABSOLUTE) && firstValuator <= 1 && numValuators > 0) {
+                if (firstValuator == 0)
+                    valuators[0] += root->drawable.pScreen->x;
+                if (firstValuator < 2 && firstValuator + numValuators > 1)
+                    valuators[1 - firstValuator] += root->drawable.pScreen->y;
+            }
+        }
+        if (ev->u.u.detail != xTrue && ev->u.u.detail != xFalse) {
+            client->errorValue = ev->u.u.detail;
+            return BadValue;
+        }
+
+        /* FIXME: Xinerama! */
+
+        break;
+    case ButtonPress:
+    case ButtonRelease:
+        if (!dev->button)
+            return BadDevice;
+
+        if (!ev->u.u.detail || ev->u.u.detail > dev->button->numButtons) {
+            client->errorValue = ev->u.u.detail;
+            return BadValue;
+        }
+        break;
+    }
+    if (screenIsSaved == SCREEN_SAVER_ON)
+        dixSaveScreens(serverClient, SCREEN_SAVER_OFF, ScreenSaverReset);
+
+    switch (type) {
+    case MotionNotify:
+        valuator_mask_set_range(&mask, firstValuator, numValuators, valuators);
+        nevents = GetPointerEvents(xtest_evlist, dev, type, 0, flags, &mask);
+        break;
+    case ButtonPress:
+    case ButtonRelease:
+        valuator_mask_set_range(&mask, firstValuator, numValuators, valuators);
+        nevents = GetPointerEvents(xtest_evlist, dev, type, ev->u.u.detail,
+                                   flags, &mask);
+        break;
+    case KeyPress:
+    case KeyRelease:
+        nevents =
+            GetKeyboardEvents(xtest_evlist, dev, type, ev->u.u.detail);
+        break;
+    }
+
+    for (i = 0; i < nevents; i++)
+        mieqProcessDeviceEvent(dev, &xtest_evlist[i],
+                               miPointerGetScreen(inputInfo.pointer));
+
+    if (type != KeyPress && type != KeyRelease)
+        *pneed_ptr_update = TRUE;
+    return Success;
+}
+
 static int
 ProcXTestFakeInput(ClientPtr client)
 {
@@ -155,17 +296,15 @@ ProcXTestFakeInput(ClientPtr client)
     int nev, n, type, rc;
     xEvent *ev;
     DeviceIntPtr dev = NULL;
-    WindowPtr root;
     Bool extension = FALSE;
-    ValuatorMask mask;
     int valuators[MAX_VALUATORS] = { 0 };
     int numValuators = 0;
     int firstValuator = 0;
-    int nevents = 0;
     int i;
     int base = 0;
     int flags = 0;
-    int need_ptr_update = 1;
+    Bool need_ptr_update = FALSE;
+    Bool slept = FALSE;
 
     nev = (stuff->length << 2) - sizeof(xReq);
     if ((nev % sizeof(xEvent)) || !nev)
@@ -286,148 +425,66 @@ ProcXTestFakeInput(ClientPtr client)
         }
         type = type - XI_DeviceKeyPress + KeyPress;
 
+        rc = XTestFakeInputInject(client, dev, ev, type, flags, TRUE, FALSE,
+                                  firstValuator, numValuators, valuators,
+                                  &need_ptr_update, &slept);
+        if (rc != Success || slept)
+            return rc;
     }
     else {
-        if (nev != 1)
-            return BadLength;
-        switch (type) {
-        case KeyPress:
-        case KeyRelease:
-            dev = PickKeyboard(client);
-            break;
-        case ButtonPress:
-        case ButtonRelease:
-            dev = PickPointer(client);
-            break;
-        case MotionNotify:
-            dev = PickPointer(client);
-            valuators[0] = ev->u.keyButtonPointer.rootX;
-            valuators[1] = ev->u.keyButtonPointer.rootY;
-            numValuators = 2;
+        /*
+         * Core events.  Clients may pack several fake events into one
+         * request; they are injected here in one pass, with the cursor
+         * sprite update deferred to the end of the batch, so drivers
+         * of synthetic input do not pay the per-request dispatch and
+         * sprite rendering cost for every event.  If an event in the
+         * middle of a batch is invalid, the events before it have
+         * already been injected when the error is returned.
+         */
+        Bool batched = (nev > 1);
+
+        for (i = 0; i < nev; i++, ev++) {
+            type = ev->u.u.type & 0177;
+            flags = 0;
+            numValuators = 0;
             firstValuator = 0;
-            if (ev->u.u.detail == xFalse)
-                flags = POINTER_ABSOLUTE | POINTER_DESKTOP;
-            break;
-        default:
-            client->errorValue = ev->u.u.type;
-            return BadValue;
-        }
-
-        /* Technically the protocol doesn't allow for BadAccess here but
-         * this can only happen when all MDs are disabled.  */
-        if (!dev)
-            return BadAccess;
-
-        dev = GetXTestDevice(dev);
-    }
-
-
-    /* If the event has a time set, wait for it to pass */
-    if (ev->u.keyButtonPointer.time) {
-        TimeStamp activateTime;
-        CARD32 ms;
-
-        activateTime = currentTime;
-        ms = activateTime.milliseconds + ev->u.keyButtonPointer.time;
-        if (ms < activateTime.milliseconds)
-            activateTime.months++;
-        activateTime.milliseconds = ms;
-        ev->u.keyButtonPointer.time = 0;
-
-        /* see mbuf.c:QueueDisplayRequest (from the deprecated Multibuffer
-         * extension) for code similar to this */
-
-        if (!ClientSleepUntil(client, &activateTime, NULL, NULL)) {
-            return BadAlloc;
-        }
-        /* swap the request back so we can simply re-execute it */
-        if (client->swapped) {
-            (void) XTestSwapFakeInput(client, (xReq *) stuff);
-            swaps(&stuff->length);
-        }
-        ResetCurrentRequest(client);
-        client->sequence--;
-        return Success;
-    }
-
-    switch (type) {
-    case KeyPress:
-    case KeyRelease:
-        if (!dev->key)
-            return BadDevice;
-
-        if (ev->u.u.detail < dev->key->xkbInfo->desc->min_key_code ||
-            ev->u.u.detail > dev->key->xkbInfo->desc->max_key_code) {
-            client->errorValue = ev->u.u.detail;
-            return BadValue;
-        }
-
-        need_ptr_update = 0;
-        break;
-    case MotionNotify:
-        if (!dev->valuator)
-            return BadDevice;
 
-        if (!(extension || ev->u.keyButtonPointer.root == None)) {
-            rc = dixLookupWindow(&root, ev->u.keyButtonPointer.root,
-                                 client, DixGetAttrAccess);
-            if (rc != Success)
-                return rc;
-            if (root->parent) {
-                client->errorValue = ev->u.keyButtonPointer.root;
+            switch (type) {
+            case KeyPress:
+            case KeyRelease:
+                dev = PickKeyboard(client);
+                break;
+            case ButtonPress:
+            case ButtonRelease:
+                dev = PickPointer(client);
+                break;
+            case MotionNotify:
+                dev = PickPointer(client);
+                valuators[0] = ev->u.keyButtonPointer.rootX;
+                valuators[1] = ev->u.keyButtonPointer.rootY;
+                numValuators = 2;
+                if (ev->u.u.detail == xFalse)
+                    flags = POINTER_ABSOLUTE | POINTER_DESKTOP;
+                break;
+            default:
+                client->errorValue = ev->u.u.type;
                 return BadValue;
             }
 
-            /* Add the root window's offset to the valuators */
-            if ((flags & POINTER_ABSOLUTE) && firstValuator <= 1 && numValuators > 0) {
-                if (firstValuator == 0)
-                    valuators[0] += root->drawable.pScreen->x;
-                if (firstValuator < 2 && firstValuator + numValuators > 1)
-                    valuators[1 - firstValuator] += root->drawable.pScreen->y;
-            }
-        }
-        if (ev->u.u.detail != xTrue && ev->u.u.detail != xFalse) {
-            client->errorValue = ev->u.u.detail;
-            return BadValue;
-        }
-
-        /* FIXME: Xinerama! */
+            /* Technically the protocol doesn't allow for BadAccess here but
+             * this can only happen when all MDs are disabled.  */
+            if (!dev)
+                return BadAccess;
 
-        break;
-    case ButtonPress:
-    case ButtonRelease:
-        if (!dev->button)
-            return BadDevice;
+            dev = GetXTestDevice(dev);
 
-        if (!ev->u.u.detail || ev->u.u.detail > dev->button->numButtons) {
-            client->errorValue = ev->u.u.detail;
-            return BadValue;
+            rc = XTestFakeInputInject(client, dev, ev, type, flags, FALSE,
+                                      batched, firstValuator, numValuators,
+                                      valuators, &need_ptr_update, &slept);
+            if (rc != Success || slept)
+                return rc;
         }
-        break;
     }
-    if (screenIsSaved == SCREEN_SAVER_ON)
-        dixSaveScreens(serverClient, SCREEN_SAVER_OFF, ScreenSaverReset);
-
-    switch (type) {
-    case MotionNotify:
-        valuator_mask_set_range(&mask, firstValuator, numValuators, valuators);
-        nevents = GetPointerEvents(xtest_evlist, dev, type, 0, flags, &mask);
-        break;
-    case ButtonPress:
-    case ButtonRelease:
-        valuator_mask_set_range(&mask, firstValuator, numValuators, valuators);
-        nevents = GetPointerEvents(xtest_evlist, dev, type, ev->u.u.detail,
-                                   flags, &mask);
-        break;
-    case KeyPress:
-    case KeyRelease:
-        nevents =
-            GetKeyboardEvents(xtest_evlist, dev, type, ev->u.u.detail);
-        break;
-    }
-
-    for (i = 0; i < nevents; i++)
-        mieqProcessDeviceEvent(dev, &xtest_evlist[i], miPointerGetScreen(inputInfo.pointer));
 
     if (need_ptr_update)
         miPointerUpdateSprite(dev);
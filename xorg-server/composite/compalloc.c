@@ -216,7 +216,7 @@ compRedirectWindow(ClientPtr pClient, WindowPtr pWin, int update)
             anyMarked = compMarkWindows(pWin, &pLayerWin);
     }
 
-    if (!compCheckRedirect(pWin)) {
+    if (!compCheckRedirect(pWin, FALSE)) {
         FreeResource(ccw->id, RT_NONE);
         return BadAlloc;
     }
@@ -528,7 +528,7 @@ compUnredirectOneSubwindow(WindowPtr pParent, WindowPtr pWin)
 }
 
 static PixmapPtr
-compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
+compNewPixmap(WindowPtr pWin, int x, int y, int w, int h, Bool seed)
 {
     ScreenPtr pScreen = pWin->drawable.pScreen;
     WindowPtr pParent = pWin->parent;
@@ -543,6 +543,15 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
     pPixmap->screen_x = x;
     pPixmap->screen_y = y;
 
+    /*
+     * Seeding writes every pixel of the backing pixmap, which commits all
+     * of its pages; when the caller knows the screen holds nothing worth
+     * keeping, leaving the pixmap untouched lets mostly-idle windows keep
+     * their never-drawn pages as cheap demand-zero memory
+     */
+    if (!seed)
+        return pPixmap;
+
     if (pParent->drawable.depth == pWin->drawable.depth) {
         GCPtr pGC = GetScratchGC(pWin->drawable.depth, pScreen);
 
@@ -596,14 +605,26 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
 }
 
 Bool
-compAllocPixmap(WindowPtr pWin)
+compAllocPixmap(WindowPtr pWin, Bool freshRealize)
 {
     int bw = (int) pWin->borderWidth;
     int x = pWin->drawable.x - bw;
     int y = pWin->drawable.y - bw;
     int w = pWin->drawable.width + (bw << 1);
     int h = pWin->drawable.height + (bw << 1);
-    PixmapPtr pPixmap = compNewPixmap(pWin, x, y, w, h);
+    /*
+     * A window being realized right now has no valid contents on screen,
+     * and if it has a background, map processing is about to paint that
+     * background and deliver exposures covering the whole window, so
+     * seeding the pixmap from the parent is pure overdraw.  Windows with
+     * background None keep whatever was on screen, matching the
+     * unredirected behaviour; windows redirected while already realized
+     * must keep their current bits.
+     */
+    Bool seed = !freshRealize ||
+        !(pWin->backgroundState == BackgroundPixel ||
+          pWin->backgroundState == BackgroundPixmap);
+    PixmapPtr pPixmap = compNewPixmap(pWin, x, y, w, h, seed);
     CompWindowPtr cw = GetCompWindow(pWin);
 
     if (!pPixmap)
@@ -680,7 +701,7 @@ compReallocPixmap(WindowPtr pWin, int draw_x, int draw_y,
     pix_w = w + (bw << 1);
     pix_h = h + (bw << 1);
     if (pix_w != pOld->drawable.width || pix_h != pOld->drawable.height) {
-        pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h);
+        pNew = compNewPixmap(pWin, pix_x, pix_y, pix_w, pix_h, TRUE);
         if (!pNew)
             return FALSE;
         cw->pOldPixmap = pOld;
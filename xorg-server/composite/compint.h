@@ -222,7 +222,7 @@ int
  compUnredirectOneSubwindow(WindowPtr pParent, WindowPtr pWin);
 
 Bool
- compAllocPixmap(WindowPtr pWin);
+ compAllocPixmap(WindowPtr pWin, Bool freshRealize);
 
 void
  compSetParentPixmap(WindowPtr pWin);
@@ -278,7 +278,7 @@ void
  compSetPixmap(WindowPtr pWin, PixmapPtr pPixmap, int bw);
 
 Bool
- compCheckRedirect(WindowPtr pWin);
+ compCheckRedirect(WindowPtr pWin, Bool freshRealize);
 
 Bool
  compPositionWindow(WindowPtr pWin, int x, int y);
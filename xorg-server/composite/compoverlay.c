@@ -156,8 +156,11 @@ compCreateOverlayWindow(ScreenPtr pScreen)
     if (pWin == NULL)
         return FALSE;
 
-    if (!AddResource(pWin->drawable.id, RT_WINDOW, (void *) pWin))
+    if (!AddResource(pWin->drawable.id, RT_WINDOW, (void *) pWin)) {
+        DeleteWindow(pWin, None);
+        cs->pOverlayWin = NullWindow;
         return FALSE;
+    }
 
     MapWindow(pWin, serverClient);
 
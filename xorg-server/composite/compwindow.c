@@ -153,7 +153,7 @@ compSetPixmap(WindowPtr pWindow, PixmapPtr pPixmap, int bw)
 }
 
 Bool
-compCheckRedirect(WindowPtr pWin)
+compCheckRedirect(WindowPtr pWin, Bool freshRealize)
 {
     CompWindowPtr cw = GetCompWindow(pWin);
     CompScreenPtr cs = GetCompScreen(pWin->drawable.pScreen);
@@ -171,7 +171,7 @@ compCheckRedirect(WindowPtr pWin)
 
     if (should != (pWin->redirectDraw != RedirectDrawNone)) {
         if (should)
-            return compAllocPixmap(pWin);
+            return compAllocPixmap(pWin, freshRealize);
         else {
             ScreenPtr pScreen = pWin->drawable.pScreen;
             PixmapPtr pPixmap = (*pScreen->GetWindowPixmap) (pWin);
@@ -271,7 +271,7 @@ compRealizeWindow(WindowPtr pWin)
     Bool ret = TRUE;
 
     pScreen->RealizeWindow = cs->RealizeWindow;
-    compCheckRedirect(pWin);
+    compCheckRedirect(pWin, TRUE);
     if (!(*pScreen->RealizeWindow) (pWin))
         ret = FALSE;
     cs->RealizeWindow = pScreen->RealizeWindow;
@@ -288,7 +288,7 @@ compUnrealizeWindow(WindowPtr pWin)
     Bool ret = TRUE;
 
     pScreen->UnrealizeWindow = cs->UnrealizeWindow;
-    compCheckRedirect(pWin);
+    compCheckRedirect(pWin, FALSE);
     if (!(*pScreen->UnrealizeWindow) (pWin))
         ret = FALSE;
     cs->UnrealizeWindow = pScreen->UnrealizeWindow;
@@ -462,7 +462,7 @@ compReparentWindow(WindowPtr pWin, WindowPtr pPriorParent)
      * Allocate any necessary redirect pixmap
      * (this actually should never be true; pWin is always unmapped)
      */
-    compCheckRedirect(pWin);
+    compCheckRedirect(pWin, FALSE);
 
     /*
      * Reset pixmap pointers as appropriate
@@ -132,6 +132,91 @@ DamageExtNotify(DamageExtPtr pDamageExt, BoxPtr pBoxes, int nBoxes)
     DamageNoteCritical(pClient);
 }
 
+/*
+ * Batched event delivery.
+ *
+ * At the delta and bounding-box report levels each rendering operation
+ * used to turn into an immediate DamageNotify, so a full-rate video
+ * update could wake the listening client tens of thousands of times a
+ * second.  Instead the reported regions are accumulated per Damage and
+ * flushed by a work proc, which the dispatch loop runs before the
+ * server blocks again - so a burst of rendering produces one batch of
+ * events per dispatch cycle without adding unbounded latency.
+ *
+ * Raw-rectangles listeners are still notified immediately: that level
+ * promises an event per rectangle as it happens, and coalescing the
+ * regions would merge rectangles the client asked to see individually.
+ */
+static DamageExtPtr pPendingDamageExts;
+static Bool damageExtFlushQueued;
+
+static Bool
+DamageExtFlushNotify(ClientPtr pUnused, void *closure)
+{
+    damageExtFlushQueued = FALSE;
+
+    while (pPendingDamageExts) {
+        DamageExtPtr pDamageExt = pPendingDamageExts;
+
+        pPendingDamageExts = pDamageExt->pNextPending;
+        pDamageExt->pNextPending = NULL;
+        pDamageExt->notifyPending = FALSE;
+
+        switch (pDamageExt->level) {
+        case DamageReportDeltaRegion:
+            DamageExtNotify(pDamageExt,
+                            RegionRects(&pDamageExt->pendingRegion),
+                            RegionNumRects(&pDamageExt->pendingRegion));
+            break;
+        case DamageReportBoundingBox:
+            DamageExtNotify(pDamageExt,
+                            RegionExtents(&pDamageExt->pendingRegion), 1);
+            break;
+        default:
+            break;
+        }
+
+        RegionEmpty(&pDamageExt->pendingRegion);
+    }
+
+    return TRUE;
+}
+
+static void
+DamageExtBatchNotify(DamageExtPtr pDamageExt, RegionPtr pRegion)
+{
+    RegionUnion(&pDamageExt->pendingRegion, &pDamageExt->pendingRegion,
+                pRegion);
+
+    if (!pDamageExt->notifyPending) {
+        pDamageExt->notifyPending = TRUE;
+        pDamageExt->pNextPending = pPendingDamageExts;
+        pPendingDamageExts = pDamageExt;
+    }
+
+    if (!damageExtFlushQueued) {
+        damageExtFlushQueued = TRUE;
+        QueueWorkProc(DamageExtFlushNotify, NULL, NULL);
+    }
+}
+
+static void
+DamageExtUnbatchNotify(DamageExtPtr pDamageExt)
+{
+    DamageExtPtr *ppPending = &pPendingDamageExts;
+
+    if (!pDamageExt->notifyPending)
+        return;
+
+    while (*ppPending && *ppPending != pDamageExt)
+        ppPending = &(*ppPending)->pNextPending;
+    if (*ppPending)
+        *ppPending = pDamageExt->pNextPending;
+
+    pDamageExt->pNextPending = NULL;
+    pDamageExt->notifyPending = FALSE;
+}
+
 static void
 DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 {
@@ -139,12 +224,12 @@ DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 
     switch (pDamageExt->level) {
     case DamageReportRawRegion:
-    case DamageReportDeltaRegion:
         DamageExtNotify(pDamageExt, RegionRects(pRegion),
                         RegionNumRects(pRegion));
         break;
+    case DamageReportDeltaRegion:
     case DamageReportBoundingBox:
-        DamageExtNotify(pDamageExt, RegionExtents(pRegion), 1);
+        DamageExtBatchNotify(pDamageExt, pRegion);
         break;
     case DamageReportNonEmpty:
         DamageExtNotify(pDamageExt, NullBox, 0);
@@ -236,6 +321,9 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
+    RegionNull(&pDamageExt->pendingRegion);
+    pDamageExt->notifyPending = FALSE;
+    pDamageExt->pNextPending = NULL;
     pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
                                        FALSE, pDrawable->pScreen, pDamageExt);
     if (!pDamageExt->pDamage) {
@@ -576,6 +664,8 @@ FreeDamageExt(void *value, XID did)
     /*
      * Get rid of the resource table entry hanging from the window id
      */
+    DamageExtUnbatchNotify(pDamageExt);
+    RegionUninit(&pDamageExt->pendingRegion);
     pDamageExt->id = 0;
     if (pDamageExt->pDamage) {
         DamageDestroy(pDamageExt->pDamage);
@@ -55,6 +55,10 @@ typedef struct _DamageExt {
     ClientPtr pClient;
     XID id;
     XID drawable;
+    /* Batched event delivery for the delta/bounding-box report levels */
+    RegionRec pendingRegion;
+    Bool notifyPending;
+    struct _DamageExt *pNextPending;
 } DamageExtRec, *DamageExtPtr;
 
 #define VERIFY_DAMAGEEXT(pDamageExt, rid, client, mode) { \
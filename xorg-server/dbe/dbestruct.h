@@ -40,6 +40,9 @@
 #include "windowstr.h"
 #include "privates.h"
 
+/* Opaque damage record from miext/damage, used for region-limited swaps. */
+struct _damage;
+
 typedef struct {
     VisualID visual;            /* one visual ID that supports double-buffering */
     int depth;                  /* depth of visual in bits                      */
@@ -157,6 +160,34 @@ typedef struct _DbeWindowPrivRec {
      */
     PixmapPtr pFrontBuffer;
 
+    /* Damage records used to limit buffer swaps to modified areas.
+     * pBackDamage tracks client rendering into the back buffer pixmap;
+     * pFrontDamage tracks rendering done directly to the window (the
+     * front buffer).  Both are NULL when damage tracking could not be
+     * set up, in which case swaps fall back to full-size copies.
+     */
+    struct _damage *pBackDamage;
+    struct _damage *pFrontDamage;
+
+    /* Area of the window modified by the most recent swap.  The buffer
+     * the client renders into always lags the window by one frame, so
+     * this region must be folded into the next swap's copy region.
+     */
+    RegionRec prevSwapRegion;
+
+    /* Area in which the front pixmap may be out of date with respect to
+     * the window.  Only the XdbeUntouched swap action keeps the front
+     * pixmap in sync; the other swap actions accumulate their swap
+     * regions here so that a later XdbeUntouched swap can catch up.
+     */
+    RegionRec frontStaleRegion;
+
+    /* TRUE when the back buffer is known to hold the window background
+     * everywhere the client has not drawn, allowing XdbeBackground swaps
+     * to clear only the client-rendered areas.
+     */
+    Bool backClearedToBg;
+
     /* Device-specific private information.
      */
     PrivateRec *devPrivates;
@@ -51,6 +51,7 @@
 #include "regionstr.h"
 #include "gcstruct.h"
 #include "inputstr.h"
+#include "damage.h"
 #include "midbe.h"
 #include "xace.h"
 
@@ -119,6 +120,34 @@ miDbeGetVisualInfo(ScreenPtr pScreen, XdbeScreenVisualInfo * pScrVisInfo)
 
 }                               /* miDbeGetVisualInfo() */
 
+/******************************************************************************
+ *
+ * DBE MI Procedure: miDbeCopyRegion
+ *
+ * Description:
+ *
+ *     This function copies the rectangles of a region between two
+ *     drawables of equal size.  It is used by miDbeSwapBuffers() to limit
+ *     buffer swaps to the modified areas of a buffer.
+ *
+ *****************************************************************************/
+
+static void
+miDbeCopyRegion(DrawablePtr pSrc, DrawablePtr pDst, GCPtr pGC,
+                RegionPtr pRegion)
+{
+    BoxPtr pBox = RegionRects(pRegion);
+    int nBox = RegionNumRects(pRegion);
+
+    while (nBox--) {
+        (*pGC->ops->CopyArea) (pSrc, pDst, pGC, pBox->x1, pBox->y1,
+                               pBox->x2 - pBox->x1, pBox->y2 - pBox->y1,
+                               pBox->x1, pBox->y1);
+        pBox++;
+    }
+
+}                               /* miDbeCopyRegion() */
+
 /******************************************************************************
  *
  * DBE MI Procedure: miAllocBackBufferName
@@ -137,6 +166,7 @@ miDbeAllocBackBufferName(WindowPtr pWin, XID bufId, int swapAction)
     DbeScreenPrivPtr pDbeScreenPriv;
     GCPtr pGC;
     xRectangle clearRect;
+    BoxRec fullBox;
     int rc;
 
     pScreen = pWin->drawable.pScreen;
@@ -190,9 +220,48 @@ miDbeAllocBackBufferName(WindowPtr pWin, XID bufId, int swapAction)
             clearRect.height = pDbeWindowPriv->pBackBuffer->drawable.height;
             (*pGC->ops->PolyFillRect) ((DrawablePtr) pDbeWindowPriv->
                                        pBackBuffer, pGC, 1, &clearRect);
+            pDbeWindowPriv->backClearedToBg = TRUE;
         }
         FreeScratchGC(pGC);
 
+        /* Register damage tracking on the back buffer and the window so
+         * that buffer swaps can be limited to the modified areas.  A
+         * failure here is not fatal; miDbeSwapBuffers() simply falls back
+         * to full-size copies.
+         */
+        pDbeWindowPriv->pBackDamage =
+            DamageCreate((DamageReportFunc) NULL, (DamageDestroyFunc) NULL,
+                         DamageReportNone, TRUE, pScreen, NULL);
+        pDbeWindowPriv->pFrontDamage =
+            DamageCreate((DamageReportFunc) NULL, (DamageDestroyFunc) NULL,
+                         DamageReportNone, TRUE, pScreen, NULL);
+
+        if (pDbeWindowPriv->pBackDamage && pDbeWindowPriv->pFrontDamage) {
+            DamageRegister((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                           pDbeWindowPriv->pBackDamage);
+            DamageRegister((DrawablePtr) pWin, pDbeWindowPriv->pFrontDamage);
+
+            /* The window contents are unrelated to the fresh back buffer,
+             * so the first swap has to copy everything.
+             */
+            fullBox.x1 = 0;
+            fullBox.y1 = 0;
+            fullBox.x2 = pDbeWindowPriv->width;
+            fullBox.y2 = pDbeWindowPriv->height;
+            RegionInit(&pDbeWindowPriv->prevSwapRegion, &fullBox, 1);
+            RegionInit(&pDbeWindowPriv->frontStaleRegion, &fullBox, 1);
+        }
+        else {
+            if (pDbeWindowPriv->pBackDamage) {
+                DamageDestroy(pDbeWindowPriv->pBackDamage);
+            }
+            if (pDbeWindowPriv->pFrontDamage) {
+                DamageDestroy(pDbeWindowPriv->pFrontDamage);
+            }
+            pDbeWindowPriv->pBackDamage = (DamagePtr) NULL;
+            pDbeWindowPriv->pFrontDamage = (DamagePtr) NULL;
+        }
+
     }                           /* if no buffer associated with the window */
 
     else {
@@ -254,12 +323,57 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
     WindowPtr pWin;
     PixmapPtr pTmpBuffer;
     xRectangle clearRect;
+    RegionRec swapRegion;
+    RegionRec winRegion;
+    BoxRec winBox;
+    BoxPtr pBox;
+    int nBox;
+    Bool regionSwap;
+    Bool clearedWholeBack = FALSE;
 
     pWin = swapInfo[0].pWindow;
     pDbeScreenPriv = DBE_SCREEN_PRIV_FROM_WINDOW(pWin);
     pDbeWindowPriv = DBE_WINDOW_PRIV(pWin);
+
+    /* frame statistics for the X-Resource frame timing query */
+    FrameTimingRecord(pWin->drawable.id);
     pGC = GetScratchGC(pWin->drawable.depth, pWin->drawable.pScreen);
 
+    winBox.x1 = 0;
+    winBox.y1 = 0;
+    winBox.x2 = pWin->drawable.width;
+    winBox.y2 = pWin->drawable.height;
+
+    /* For the XdbeUntouched and XdbeBackground swap actions, the window
+     * and the back buffer can only differ where the client has rendered
+     * since the last swap or where the last swap itself changed the
+     * window.  Collect those areas so the copies below can be limited to
+     * them instead of blitting the whole buffer.
+     */
+    regionSwap = (pDbeWindowPriv->pBackDamage != NULL) &&
+        (swapInfo[0].swapAction == XdbeUntouched ||
+         swapInfo[0].swapAction == XdbeBackground);
+
+    if (regionSwap) {
+        RegionNull(&swapRegion);
+        RegionUnion(&swapRegion,
+                    DamageRegion(pDbeWindowPriv->pBackDamage),
+                    DamageRegion(pDbeWindowPriv->pFrontDamage));
+        RegionUnion(&swapRegion, &swapRegion, &pDbeWindowPriv->prevSwapRegion);
+
+        if (swapInfo[0].swapAction == XdbeUntouched) {
+            /* The front pixmap was not kept in sync by any preceding
+             * non-XdbeUntouched swaps; catch up on those areas as well.
+             */
+            RegionUnion(&swapRegion, &swapRegion,
+                        &pDbeWindowPriv->frontStaleRegion);
+        }
+
+        RegionInit(&winRegion, &winBox, 1);
+        RegionIntersect(&swapRegion, &swapRegion, &winRegion);
+        RegionUninit(&winRegion);
+    }
+
     /*
      **********************************************************************
      ** Setup before swap.
@@ -275,10 +389,17 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
 
     case XdbeUntouched:
         ValidateGC((DrawablePtr) pDbeWindowPriv->pFrontBuffer, pGC);
-        (*pGC->ops->CopyArea) ((DrawablePtr) pWin,
-                               (DrawablePtr) pDbeWindowPriv->pFrontBuffer,
-                               pGC, 0, 0, pWin->drawable.width,
-                               pWin->drawable.height, 0, 0);
+        if (regionSwap) {
+            miDbeCopyRegion((DrawablePtr) pWin,
+                            (DrawablePtr) pDbeWindowPriv->pFrontBuffer,
+                            pGC, &swapRegion);
+        }
+        else {
+            (*pGC->ops->CopyArea) ((DrawablePtr) pWin,
+                                   (DrawablePtr) pDbeWindowPriv->pFrontBuffer,
+                                   pGC, 0, 0, pWin->drawable.width,
+                                   pWin->drawable.height, 0, 0);
+        }
         break;
 
     case XdbeCopied:
@@ -293,9 +414,16 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
      */
 
     ValidateGC((DrawablePtr) pWin, pGC);
-    (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
-                           (DrawablePtr) pWin, pGC, 0, 0,
-                           pWin->drawable.width, pWin->drawable.height, 0, 0);
+    if (regionSwap) {
+        miDbeCopyRegion((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                        (DrawablePtr) pWin, pGC, &swapRegion);
+    }
+    else {
+        (*pGC->ops->CopyArea) ((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                               (DrawablePtr) pWin, pGC, 0, 0,
+                               pWin->drawable.width, pWin->drawable.height,
+                               0, 0);
+    }
 
     /*
      **********************************************************************
@@ -310,12 +438,37 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
     case XdbeBackground:
         if ((*pDbeScreenPriv->SetupBackgroundPainter) (pWin, pGC)) {
             ValidateGC((DrawablePtr) pDbeWindowPriv->pBackBuffer, pGC);
-            clearRect.x = 0;
-            clearRect.y = 0;
-            clearRect.width = pDbeWindowPriv->pBackBuffer->drawable.width;
-            clearRect.height = pDbeWindowPriv->pBackBuffer->drawable.height;
-            (*pGC->ops->PolyFillRect) ((DrawablePtr) pDbeWindowPriv->
-                                       pBackBuffer, pGC, 1, &clearRect);
+            if (regionSwap && pDbeWindowPriv->backClearedToBg) {
+                /* The areas outside the swap region still hold the
+                 * background from the previous clear.
+                 */
+                pBox = RegionRects(&swapRegion);
+                nBox = RegionNumRects(&swapRegion);
+                while (nBox--) {
+                    clearRect.x = pBox->x1;
+                    clearRect.y = pBox->y1;
+                    clearRect.width = pBox->x2 - pBox->x1;
+                    clearRect.height = pBox->y2 - pBox->y1;
+                    (*pGC->ops->PolyFillRect) ((DrawablePtr) pDbeWindowPriv->
+                                               pBackBuffer, pGC, 1,
+                                               &clearRect);
+                    pBox++;
+                }
+            }
+            else {
+                clearRect.x = 0;
+                clearRect.y = 0;
+                clearRect.width = pDbeWindowPriv->pBackBuffer->drawable.width;
+                clearRect.height =
+                    pDbeWindowPriv->pBackBuffer->drawable.height;
+                (*pGC->ops->PolyFillRect) ((DrawablePtr) pDbeWindowPriv->
+                                           pBackBuffer, pGC, 1, &clearRect);
+                clearedWholeBack = TRUE;
+            }
+            pDbeWindowPriv->backClearedToBg = TRUE;
+        }
+        else {
+            pDbeWindowPriv->backClearedToBg = FALSE;
         }
         break;
 
@@ -327,6 +480,21 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
 
         miDbeAliasBuffers(pDbeWindowPriv);
 
+        if (regionSwap) {
+            /* Keep the damage record attached to the pixmap the client
+             * renders into.
+             */
+            DamageUnregister(pDbeWindowPriv->pBackDamage);
+            DamageRegister((DrawablePtr) pDbeWindowPriv->pBackBuffer,
+                           pDbeWindowPriv->pBackDamage);
+
+            /* The old back buffer became the front pixmap and matches the
+             * window exactly after the copy above.
+             */
+            RegionEmpty(&pDbeWindowPriv->frontStaleRegion);
+        }
+        pDbeWindowPriv->backClearedToBg = FALSE;
+
         break;
 
     case XdbeCopied:
@@ -334,6 +502,45 @@ miDbeSwapBuffers(ClientPtr client, int *pNumWindows, DbeSwapInfoPtr swapInfo)
 
     }
 
+    /* Update the damage bookkeeping for the next swap. */
+    if (regionSwap) {
+        if (clearedWholeBack) {
+            /* The whole back buffer was repainted with the background, so
+             * everything the window shows beyond that may now differ from
+             * the back buffer.
+             */
+            RegionUninit(&pDbeWindowPriv->prevSwapRegion);
+            RegionInit(&pDbeWindowPriv->prevSwapRegion, &winBox, 1);
+        }
+        else {
+            RegionCopy(&pDbeWindowPriv->prevSwapRegion, &swapRegion);
+        }
+
+        if (swapInfo[0].swapAction == XdbeBackground) {
+            /* The front pixmap was left untouched while the window
+             * changed in the swap region.
+             */
+            RegionUnion(&pDbeWindowPriv->frontStaleRegion,
+                        &pDbeWindowPriv->frontStaleRegion, &swapRegion);
+        }
+
+        DamageEmpty(pDbeWindowPriv->pBackDamage);
+        DamageEmpty(pDbeWindowPriv->pFrontDamage);
+        RegionUninit(&swapRegion);
+    }
+    else if (pDbeWindowPriv->pBackDamage) {
+        /* A full-size copy was done: window and back buffer now match
+         * exactly, but the back buffer no longer holds pure background
+         * and the front pixmap is out of date everywhere.
+         */
+        RegionEmpty(&pDbeWindowPriv->prevSwapRegion);
+        RegionUninit(&pDbeWindowPriv->frontStaleRegion);
+        RegionInit(&pDbeWindowPriv->frontStaleRegion, &winBox, 1);
+        DamageEmpty(pDbeWindowPriv->pBackDamage);
+        DamageEmpty(pDbeWindowPriv->pFrontDamage);
+        pDbeWindowPriv->backClearedToBg = FALSE;
+    }
+
     /* Remove the swapped window from the swap information array and decrement
      * pNumWindows to indicate to the DIX level how many windows were actually
      * swapped.
@@ -426,6 +633,20 @@ miDbeWinPrivDelete(DbeWindowPrivPtr pDbeWindowPriv, XID bufId)
      * free some stuff.
      */
 
+    /* Tear down damage tracking before destroying the drawables that the
+     * damage records are registered on.
+     */
+    if (pDbeWindowPriv->pBackDamage) {
+        DamageDestroy(pDbeWindowPriv->pBackDamage);
+        pDbeWindowPriv->pBackDamage = (DamagePtr) NULL;
+    }
+    if (pDbeWindowPriv->pFrontDamage) {
+        DamageDestroy(pDbeWindowPriv->pFrontDamage);
+        pDbeWindowPriv->pFrontDamage = (DamagePtr) NULL;
+    }
+    RegionUninit(&pDbeWindowPriv->prevSwapRegion);
+    RegionUninit(&pDbeWindowPriv->frontStaleRegion);
+
     /* Destroy the front and back pixmaps. */
     if (pDbeWindowPriv->pFrontBuffer) {
         (*pDbeWindowPriv->pWindow->drawable.pScreen->
@@ -464,6 +685,7 @@ miDbePositionWindow(WindowPtr pWin, int x, int y)
     Bool clear;
     GCPtr pGC;
     xRectangle clearRect;
+    BoxRec fullBox;
     Bool ret;
 
     /*
@@ -643,12 +865,40 @@ miDbePositionWindow(WindowPtr pWin, int x, int y)
          * pixmaps.
          */
 
+        /* Detach the damage record before the old back pixmap goes away;
+         * damageDestroyPixmap() would otherwise destroy it with the
+         * pixmap.
+         */
+        if (pDbeWindowPriv->pBackDamage) {
+            DamageUnregister(pDbeWindowPriv->pBackDamage);
+        }
+
         (*pScreen->DestroyPixmap) (pDbeWindowPriv->pFrontBuffer);
         (*pScreen->DestroyPixmap) (pDbeWindowPriv->pBackBuffer);
 
         pDbeWindowPriv->pFrontBuffer = pFrontBuffer;
         pDbeWindowPriv->pBackBuffer = pBackBuffer;
 
+        if (pDbeWindowPriv->pBackDamage) {
+            /* The new buffers were seeded with a mix of old contents and
+             * background, so the next swap has to copy everything.
+             */
+            DamageRegister((DrawablePtr) pBackBuffer,
+                           pDbeWindowPriv->pBackDamage);
+            DamageEmpty(pDbeWindowPriv->pBackDamage);
+            DamageEmpty(pDbeWindowPriv->pFrontDamage);
+
+            fullBox.x1 = 0;
+            fullBox.y1 = 0;
+            fullBox.x2 = width;
+            fullBox.y2 = height;
+            RegionUninit(&pDbeWindowPriv->prevSwapRegion);
+            RegionInit(&pDbeWindowPriv->prevSwapRegion, &fullBox, 1);
+            RegionUninit(&pDbeWindowPriv->frontStaleRegion);
+            RegionInit(&pDbeWindowPriv->frontStaleRegion, &fullBox, 1);
+            pDbeWindowPriv->backClearedToBg = FALSE;
+        }
+
         /* Make sure all XID are associated with the new back pixmap. */
         miDbeAliasBuffers(pDbeWindowPriv);
 
@@ -672,6 +922,13 @@ miDbePositionWindow(WindowPtr pWin, int x, int y)
 Bool
 miDbeInit(ScreenPtr pScreen, DbeScreenPrivPtr pDbeScreenPriv)
 {
+    /* Set up the damage machinery used to limit buffer swaps to the
+     * modified areas of the back buffer.
+     */
+    if (!DamageSetup(pScreen)) {
+        return FALSE;
+    }
+
     /* Wrap functions. */
     pDbeScreenPriv->PositionWindow = pScreen->PositionWindow;
     pScreen->PositionWindow = miDbePositionWindow;
@@ -58,49 +58,83 @@ SOFTWARE.
 
 #define InitialTableSize 256
 
+/* Must be a power of two, comfortably above 2/3 load for the
+   XA_LAST_PREDEFINED built-ins plus the atoms a typical toolkit interns */
+#define InitialHashSize 1024
+
 typedef struct _Node {
-    struct _Node *left, *right;
     Atom a;
     unsigned int fingerPrint;
+    unsigned int length;
     const char *string;
 } NodeRec, *NodePtr;
 
 static Atom lastAtom = None;
-static NodePtr atomRoot = NULL;
 static unsigned long tableLength;
 static NodePtr *nodeTable;
 
+/*
+ * Open-addressed hash table mapping fingerprints to atoms, replacing the
+ * old fingerprint-ordered binary tree: the tree was never rebalanced, so
+ * lookups of hot atoms degraded as clients interned more of them, and
+ * every probe paid a strncmp plus a strlen.  Double hashing with an odd
+ * step walks every slot of a power-of-two table, and the stored length
+ * makes most collisions a pair of integer compares.
+ */
+static unsigned long hashSize;
+static unsigned long hashMask;
+static Atom *hashTable;         /* None marks an empty slot */
+
+#define ATOM_HASH_STEP(fp, mask) ((((fp) >> 16) | 1) & (mask))
+
+static void
+ResizeHashTable(void)
+{
+    unsigned long newSize = hashSize << 1;
+    unsigned long newMask = newSize - 1;
+    Atom *newTable;
+    Atom a;
+
+    newTable = calloc(newSize, sizeof(Atom));
+    if (!newTable)
+        return;                 /* keep probing the denser table */
+    for (a = 1; a <= lastAtom; a++) {
+        unsigned int fp = nodeTable[a]->fingerPrint;
+        unsigned long h = fp & newMask;
+        unsigned long step = ATOM_HASH_STEP(fp, newMask);
+
+        while (newTable[h] != None)
+            h = (h + step) & newMask;
+        newTable[h] = a;
+    }
+    free(hashTable);
+    hashTable = newTable;
+    hashSize = newSize;
+    hashMask = newMask;
+}
+
 Atom
 MakeAtom(const char *string, unsigned len, Bool makeit)
 {
-    NodePtr *np;
+    NodePtr nd;
     unsigned i;
-    int comp;
     unsigned int fp = 0;
+    unsigned long h, step;
 
-    np = &atomRoot;
     for (i = 0; i < (len + 1) / 2; i++) {
         fp = fp * 27 + string[i];
         fp = fp * 27 + string[len - 1 - i];
     }
-    while (*np != NULL) {
-        if (fp < (*np)->fingerPrint)
-            np = &((*np)->left);
-        else if (fp > (*np)->fingerPrint)
-            np = &((*np)->right);
-        else {                  /* now start testing the strings */
-            comp = strncmp(string, (*np)->string, (int) len);
-            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
-                np = &((*np)->left);
-            else if (comp > 0)
-                np = &((*np)->right);
-            else
-                return (*np)->a;
-        }
+    h = fp & hashMask;
+    step = ATOM_HASH_STEP(fp, hashMask);
+    while (hashTable[h] != None) {
+        nd = nodeTable[hashTable[h]];
+        if ((nd->fingerPrint == fp) && (nd->length == len) &&
+            (strncmp(string, nd->string, (int) len) == 0))
+            return nd->a;
+        h = (h + step) & hashMask;
     }
     if (makeit) {
-        NodePtr nd;
-
         nd = malloc(sizeof(NodeRec));
         if (!nd)
             return BAD_RESOURCE;
@@ -129,11 +163,13 @@ MakeAtom(const char *string, unsigned len, Bool makeit)
             tableLength <<= 1;
             nodeTable = table;
         }
-        *np = nd;
-        nd->left = nd->right = NULL;
         nd->fingerPrint = fp;
+        nd->length = len;
         nd->a = ++lastAtom;
         nodeTable[lastAtom] = nd;
+        hashTable[h] = nd->a;
+        if (((unsigned long) lastAtom + 1) * 3 >= hashSize * 2)
+            ResizeHashTable();
         return nd->a;
     }
     else
@@ -164,32 +200,28 @@ AtomError(void)
     FatalError("initializing atoms");
 }
 
-static void
-FreeAtom(NodePtr patom)
-{
-    if (patom->left)
-        FreeAtom(patom->left);
-    if (patom->right)
-        FreeAtom(patom->right);
-    if (patom->a > XA_LAST_PREDEFINED) {
-        /*
-         * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
-         * cast here
-         */
-        free((char *) patom->string);
-    }
-    free(patom);
-}
-
 void
 FreeAllAtoms(void)
 {
-    if (atomRoot == NULL)
+    Atom a;
+
+    if (nodeTable == NULL)
         return;
-    FreeAtom(atomRoot);
-    atomRoot = NULL;
+    for (a = 1; a <= lastAtom; a++) {
+        if (a > XA_LAST_PREDEFINED) {
+            /*
+             * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's
+             * safe to cast here
+             */
+            free((char *) nodeTable[a]->string);
+        }
+        free(nodeTable[a]);
+    }
     free(nodeTable);
     nodeTable = NULL;
+    free(hashTable);
+    hashTable = NULL;
+    hashSize = hashMask = 0;
     lastAtom = None;
 }
 
@@ -202,6 +234,11 @@ InitAtoms(void)
     if (!nodeTable)
         AtomError();
     nodeTable[None] = NULL;
+    hashSize = InitialHashSize;
+    hashMask = hashSize - 1;
+    hashTable = calloc(hashSize, sizeof(Atom));
+    if (!hashTable)
+        AtomError();
     MakePredeclaredAtoms();
     if (lastAtom != XA_LAST_PREDEFINED)
         AtomError();
@@ -139,6 +139,8 @@ int ProcInitialConnection();
 #include "probes.h"
 #endif
 
+#include "xserver-trace.h"
+
 #define mskcnt ((MAXCLIENTS + 31) / 32)
 #define BITMASK(i) (1U << ((i) & 31))
 #define MASKIDX(i) ((i) >> 5)
@@ -244,6 +246,9 @@ UpdateCurrentTimeIf(void)
 #define SMART_SCHEDULE_DEFAULT_INTERVAL	5
 #define SMART_SCHEDULE_MAX_SLICE	15
 
+/* requests dispatched between clock reads when no interval timer runs */
+#define SMART_SCHEDULE_CHECK_BATCH	16
+
 #ifdef HAVE_SETITIMER
 Bool SmartScheduleSignalEnable = TRUE;
 #endif
@@ -344,8 +349,20 @@ SmartScheduleClient(void)
     xorg_list_for_each_entry(pClient, &ready_clients, ready) {
         nready++;
 
-        /* Praise clients which haven't run in a while */
-        if ((now - pClient->smart_stop_tick) >= idle) {
+        /*
+         * Praise clients which haven't run in a while.  Interactive
+         * clients recover after half the idle time and may climb above
+         * zero, so a terminal waiting on a keystroke outranks batch
+         * clients at the next scheduling decision; bulk clients need
+         * twice the idle time and never climb past zero.
+         */
+        if (pClient->smart_class == SMART_CLASS_INTERACTIVE) {
+            if ((now - pClient->smart_stop_tick) >= idle / 2 &&
+                pClient->smart_priority < SMART_MAX_PRIORITY / 2)
+                pClient->smart_priority++;
+        }
+        else if ((now - pClient->smart_stop_tick) >=
+                 (pClient->smart_class == SMART_CLASS_BULK ? 2 * idle : idle)) {
             if (pClient->smart_priority < 0)
                 pClient->smart_priority++;
         }
@@ -474,6 +491,67 @@ DisableLimitedSchedulingLatency(void)
         SmartScheduleLatencyLimited = 0;
 }
 
+/*
+ * Per-client, per-major-opcode request latency histograms, armed by the
+ * X-Resource extension so fleet monitoring can see which client and
+ * which request type is inflating server latency.  Off by default: the
+ * dispatch loop deliberately avoids per-request clock reads (see the
+ * batched SmartScheduleTime update below), so the two clock stamps are
+ * only taken for clients a monitoring tool has asked about.
+ *
+ * Bucket 0 counts requests that completed in under a microsecond,
+ * bucket n those in [2^(n-1), 2^n) microseconds, and the last bucket
+ * collects everything slower.
+ */
+
+Bool
+StartClientLatencyRecording(ClientPtr client)
+{
+    if (!client->requestLatency)
+        client->requestLatency =
+            calloc(256 * CLIENT_LATENCY_BUCKETS, sizeof(CARD32));
+    return client->requestLatency != NULL;
+}
+
+static void
+RecordRequestLatency(ClientPtr client, int majorOp, CARD64 micros)
+{
+    int bucket = 0;
+
+    while (micros && bucket < CLIENT_LATENCY_BUCKETS - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    client->requestLatency[majorOp * CLIENT_LATENCY_BUCKETS + bucket]++;
+}
+
+/*
+ * Reusable per-client scratch storage for request processing.  Several
+ * handlers need a temporary buffer sized from the request or its reply;
+ * taking one from the heap on every request makes the allocator a
+ * measurable slice of the dispatch profile, so each client keeps its
+ * last buffer around for the next request instead.  The buffer only
+ * grows; an oversized one (a full-screen GetImage, say) is trimmed back
+ * by the dispatch loop when its request finishes, and the rest goes
+ * away with the client.  Callers must not free the returned pointer and
+ * must not assume it is zeroed.
+ */
+#define REQUEST_SCRATCH_KEEP    (64 * 1024)
+
+void *
+GetRequestScratch(ClientPtr client, size_t size)
+{
+    if (size > client->requestScratchSize) {
+        void *scratch = realloc(client->requestScratch, size);
+
+        if (!scratch)
+            return NULL;
+        client->requestScratch = scratch;
+        client->requestScratchSize = size;
+    }
+    return client->requestScratch;
+}
+
 Bool isThereSomething(Bool are_ready);
 
 void DispatchQueuedEvents(Bool wait)
@@ -525,6 +603,7 @@ void DispatchQueuedEvents(Bool wait)
         if (!dispatchException && clients_are_ready())
         {
             long start_tick;
+            int requestsThisBatch = 0;
             ClientPtr client;
             client = SmartScheduleClient();
 
@@ -543,9 +622,27 @@ void DispatchQueuedEvents(Bool wait)
                 FlushIfCriticalOutputPending();
                 if ((SmartScheduleTime - start_tick) >= SmartScheduleSlice)
                 {
-                    /* Penalize clients which consume ticks */
-                    if (client->smart_priority > SMART_MIN_PRIORITY)
+                    /*
+                     * Penalize clients which consume ticks.  A single
+                     * huge request (a big PutImage, a PolyFillRect
+                     * storm) can only be preempted here, between
+                     * requests, so it may have overrun several slices
+                     * by now; penalize one point per slice consumed so
+                     * the next scheduling decision prefers everyone
+                     * else by a proportional margin.
+                     */
+                    long slices =
+                        (SmartScheduleTime - start_tick) / SmartScheduleSlice;
+
+                    while (slices-- > 0 &&
+                           client->smart_priority > SMART_MIN_PRIORITY)
                         client->smart_priority--;
+
+                    /* A run of exhausted slices marks a bulk client */
+                    if (client->smart_full_slices < 255)
+                        client->smart_full_slices++;
+                    if (client->smart_full_slices >= 3)
+                        client->smart_class = SMART_CLASS_BULK;
                     break;
                 }
 
@@ -555,6 +652,18 @@ void DispatchQueuedEvents(Bool wait)
                 {
                     if (result < 0)
                         CloseDownClient(client);
+                    else {
+                        /*
+                         * Ran out of requests with slice time left: the
+                         * behaviour of an interactive client.  Unwind
+                         * the exhausted-slice run first so one short
+                         * burst doesn't reclassify a batch client.
+                         */
+                        if (client->smart_full_slices > 0)
+                            client->smart_full_slices--;
+                        else
+                            client->smart_class = SMART_CLASS_INTERACTIVE;
+                    }
                     break;
                 }
 
@@ -579,6 +688,14 @@ void DispatchQueuedEvents(Bool wait)
                                           client->requestBuffer);
                 }
 #endif
+                CARD64 latencyStart = 0;
+
+                if (client->requestLatency)
+                    latencyStart = GetTimeInMicros();
+
+                if (xserverTraceHooks)
+                    xserverTraceHooks->RequestBegin(client, client->majorOp);
+
                 if (result > (maxBigRequestSize << 2))
                     result = BadLength;
                 else
@@ -591,8 +708,34 @@ void DispatchQueuedEvents(Bool wait)
                         currentClient = NULL;
                     }
                 }
-                if (!SmartScheduleSignalEnable)
+                client->requestsProcessed++;
+
+                if (xserverTraceHooks)
+                    xserverTraceHooks->RequestEnd(client, client->majorOp,
+                                                  result);
+
+                if (client->requestLatency)
+                    RecordRequestLatency(client, client->majorOp,
+                                         GetTimeInMicros() - latencyStart);
+
+                if (client->requestScratchSize > REQUEST_SCRATCH_KEEP) {
+                    free(client->requestScratch);
+                    client->requestScratch = NULL;
+                    client->requestScratchSize = 0;
+                }
+
+                /*
+                 * Without the interval timer, re-reading the clock after
+                 * every request costs a syscall per request.  The slice is
+                 * several milliseconds, so checking it once per batch of
+                 * requests loses nothing while letting cheap requests
+                 * (ChangeGC, PolyFillRect, ...) dispatch back to back.
+                 */
+                if (!SmartScheduleSignalEnable &&
+                    ++requestsThisBatch >= SMART_SCHEDULE_CHECK_BATCH) {
+                    requestsThisBatch = 0;
                     SmartScheduleTime = GetTimeInMillis();
+                }
 
 #ifdef XSERVER_DTRACE
                 if (XSERVER_REQUEST_DONE_ENABLED())
@@ -630,9 +773,16 @@ void DispatchQueuedEvents(Bool wait)
                     break;
                 }
             }
+            /* a batched configure run may have left clip lists stale;
+             * settle them before any other client runs */
+            ValidateDeferredTrees();
             FlushAllOutput();
-            if (client == SmartLastClient)
+            if (client == SmartLastClient) {
+                /* Charge the elapsed slice to the client */
+                if ((SmartScheduleTime - start_tick) > 0)
+                    client->ticksConsumed += SmartScheduleTime - start_tick;
                 client->smart_stop_tick = SmartScheduleTime;
+            }
         }
         dispatchException &= ~DE_PRIORITYCHANGE;
     }
@@ -1165,7 +1315,7 @@ ProcQueryTree(ClientPtr client)
     if (numChildren) {
         int curChild = 0;
 
-        childIDs = xallocarray(numChildren, sizeof(Window));
+        childIDs = GetRequestScratch(client, numChildren * sizeof(Window));
         if (!childIDs)
             return BadAlloc;
         for (pChild = pWin->lastChild; pChild != pHead;
@@ -1184,7 +1334,6 @@ ProcQueryTree(ClientPtr client)
         client->pSwapReplyFunc = (ReplySwapPtr) Swap32Write;
         WriteSwappedDataToClient(client, numChildren * sizeof(Window),
                                  childIDs);
-        free(childIDs);
     }
 
     return Success;
@@ -1436,33 +1585,27 @@ ProcQueryFont(ClientPtr client)
         return rc;
 
     {
-        xCharInfo *pmax = FONTINKMAX(pFont);
-        xCharInfo *pmin = FONTINKMIN(pFont);
-        int nprotoxcistructs;
         int rlength;
+        xQueryFontReplyPtr cached = QueryFontCached(pFont, &rlength);
 
-        nprotoxcistructs = (pmax->rightSideBearing == pmin->rightSideBearing &&
-                            pmax->leftSideBearing == pmin->leftSideBearing &&
-                            pmax->descent == pmin->descent &&
-                            pmax->ascent == pmin->ascent &&
-                            pmax->characterWidth == pmin->characterWidth) ?
-            0 : N2dChars(pFont);
-
-        rlength = sizeof(xQueryFontReply) +
-            FONTINFONPROPS(FONTCHARSET(pFont)) * sizeof(xFontProp) +
-            nprotoxcistructs * sizeof(xCharInfo);
-        reply = calloc(1, rlength);
-        if (!reply) {
+        if (!cached)
             return BadAlloc;
-        }
 
-        reply->type = X_Reply;
-        reply->length = bytes_to_int32(rlength - sizeof(xGenericReply));
-        reply->sequenceNumber = client->sequence;
-        QueryFont(pFont, reply, nprotoxcistructs);
-
-        WriteReplyToClient(client, rlength, reply);
-        free(reply);
+        if (client->swapped) {
+            /* SQueryFontReply byte-swaps the reply in place, so it must
+               not run on the cached copy */
+            reply = malloc(rlength);
+            if (!reply)
+                return BadAlloc;
+            memcpy(reply, cached, rlength);
+            reply->sequenceNumber = client->sequence;
+            WriteReplyToClient(client, rlength, reply);
+            free(reply);
+        }
+        else {
+            cached->sequenceNumber = client->sequence;
+            WriteReplyToClient(client, rlength, cached);
+        }
         return Success;
     }
 }
@@ -2346,8 +2489,13 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             length += widthBytesLine;
         }
     }
-    if (!(pBuf = calloc(1, length)))
-        return BadAlloc;
+    if (length) {
+        if (!(pBuf = GetRequestScratch(client, length)))
+            return BadAlloc;
+        memset(pBuf, 0, length);
+    }
+    else
+        pBuf = NULL;
     WriteReplyToClient(client, sizeof(xGetImageReply), &xgi);
 
     if (pDraw->type == DRAWABLE_WINDOW) {
@@ -2413,7 +2561,6 @@ DoGetImage(ClientPtr client, int format, Drawable drawable,
             }
         }
     }
-    free(pBuf);
     return Success;
 }
 
@@ -2666,9 +2813,9 @@ ProcListInstalledColormaps(ClientPtr client)
     if (rc != Success)
         return rc;
 
-    preply = malloc(sizeof(xListInstalledColormapsReply) +
-                    pWin->drawable.pScreen->maxInstalledCmaps *
-                    sizeof(Colormap));
+    preply = GetRequestScratch(client, sizeof(xListInstalledColormapsReply) +
+                               pWin->drawable.pScreen->maxInstalledCmaps *
+                               sizeof(Colormap));
     if (!preply)
         return BadAlloc;
 
@@ -2681,7 +2828,6 @@ ProcListInstalledColormaps(ClientPtr client)
     WriteReplyToClient(client, sizeof(xListInstalledColormapsReply), preply);
     client->pSwapReplyFunc = (ReplySwapPtr) Swap32Write;
     WriteSwappedDataToClient(client, nummaps * sizeof(Colormap), &preply[1]);
-    free(preply);
     return Success;
 }
 
@@ -2793,16 +2939,14 @@ ProcAllocColorCells(ClientPtr client)
         }
         nmasks = stuff->planes;
         length = ((long) npixels + (long) nmasks) * sizeof(Pixel);
-        ppixels = malloc(length);
+        ppixels = GetRequestScratch(client, length);
         if (!ppixels)
             return BadAlloc;
         pmasks = ppixels + npixels;
 
         if ((rc = AllocColorCells(client->index, pcmp, npixels, nmasks,
-                                  (Bool) stuff->contiguous, ppixels, pmasks))) {
-            free(ppixels);
+                                  (Bool) stuff->contiguous, ppixels, pmasks)))
             return rc;
-        }
 #ifdef PANORAMIX
         if (noPanoramiXExtension || !pcmp->pScreen->myNum)
 #endif
@@ -2817,7 +2961,6 @@ ProcAllocColorCells(ClientPtr client)
             client->pSwapReplyFunc = (ReplySwapPtr) Swap32Write;
             WriteSwappedDataToClient(client, length, ppixels);
         }
-        free(ppixels);
         return Success;
     }
     else {
@@ -2859,17 +3002,15 @@ ProcAllocColorPlanes(ClientPtr client)
         
         length = (long) npixels *sizeof(Pixel);
 
-        ppixels = malloc(length);
+        ppixels = GetRequestScratch(client, length);
         if (!ppixels)
             return BadAlloc;
         if ((rc = AllocColorPlanes(client->index, pcmp, npixels,
                                    (int) stuff->red, (int) stuff->green,
                                    (int) stuff->blue, (Bool) stuff->contiguous,
                                    ppixels, &acpr.redMask, &acpr.greenMask,
-                                   &acpr.blueMask))) {
-            free(ppixels);
+                                   &acpr.blueMask)))
             return rc;
-        }
         acpr.length = bytes_to_int32(length);
 #ifdef PANORAMIX
         if (noPanoramiXExtension || !pcmp->pScreen->myNum)
@@ -2879,7 +3020,6 @@ ProcAllocColorPlanes(ClientPtr client)
             client->pSwapReplyFunc = (ReplySwapPtr) Swap32Write;
             WriteSwappedDataToClient(client, length, ppixels);
         }
-        free(ppixels);
         return Success;
     }
     else {
@@ -2986,14 +3126,15 @@ ProcQueryColors(ClientPtr client)
 
         count =
             bytes_to_int32((client->req_len << 2) - sizeof(xQueryColorsReq));
-        prgbs = calloc(count, sizeof(xrgb));
-        if (!prgbs && count)
-            return BadAlloc;
+        prgbs = GetRequestScratch(client, count * sizeof(xrgb));
+        if (count) {
+            if (!prgbs)
+                return BadAlloc;
+            memset(prgbs, 0, count * sizeof(xrgb));
+        }
         if ((rc =
-             QueryColors(pcmp, count, (Pixel *) &stuff[1], prgbs, client))) {
-            free(prgbs);
+             QueryColors(pcmp, count, (Pixel *) &stuff[1], prgbs, client)))
             return rc;
-        }
         memset(&qcr, 0, sizeof(xQueryColorsReply));
         qcr.type = X_Reply;
         qcr.sequenceNumber = client->sequence;
@@ -3005,7 +3146,6 @@ ProcQueryColors(ClientPtr client)
             client->pSwapReplyFunc = (ReplySwapPtr) SQColorsExtend;
             WriteSwappedDataToClient(client, count * sizeof(xrgb), prgbs);
         }
-        free(prgbs);
         return Success;
 
     }
@@ -3627,6 +3767,11 @@ CloseDownClient(ClientPtr client)
         /* Disable client ID tracking. This must be done after
          * ClientStateCallback. */
         ReleaseClientIds(client);
+        free(client->requestLatency);
+        client->requestLatency = NULL;
+        free(client->requestScratch);
+        client->requestScratch = NULL;
+        client->requestScratchSize = 0;
 #ifdef XSERVER_DTRACE
         XSERVER_CLIENT_DISCONNECT(client->index);
 #endif
@@ -86,6 +86,19 @@ static int size_slept_fpes = 0;
 static FontPathElementPtr *slept_fpes = (FontPathElementPtr *) 0;
 static xfont2_pattern_cache_ptr patternCache;
 
+/*
+ * The encoded QueryFont reply depends only on the font, not on the
+ * requesting client (the sequence number is patched in at send time),
+ * so it is built once per font and kept in a font private until the
+ * font is closed.  The header and the variable-length tail live in a
+ * single allocation following this record.
+ */
+typedef struct _QFcache {
+    int length;                 /* total encoded reply length in bytes */
+} QFcacheRec, *QFcachePtr;
+
+static int queryFontPrivateIndex = -1;
+
 static int
 FontToXError(int err)
 {
@@ -485,6 +498,8 @@ CloseFont(void *value, XID fid)
 #ifdef XF86BIGFONT
         XF86BigfontFreeFontShm(pfont);
 #endif
+        if (queryFontPrivateIndex >= 0)
+            free(FontGetPrivate(pfont, queryFontPrivateIndex));
         fpe = pfont->fpe;
         (*fpe_functions[fpe->type]->close_font) (fpe, pfont);
         FreeFPE(fpe);
@@ -558,6 +573,76 @@ QueryFont(FontPtr pFont, xQueryFontReply * pReply, int nProtoCCIStructs)
     return;
 }
 
+/**
+ * Returns the encoded QueryFont reply for pFont, building and caching
+ * it on first use.  The caller must patch the sequence number before
+ * sending and must not write to the reply otherwise.
+ *
+ *  \param lengthp returns the total encoded length in bytes
+ */
+xQueryFontReplyPtr
+QueryFontCached(FontPtr pFont, int *lengthp)
+{
+    QFcachePtr priv;
+
+    priv = (QFcachePtr) FontGetPrivate(pFont, queryFontPrivateIndex);
+    if (!priv) {
+        xCharInfo *pmax = FONTINKMAX(pFont);
+        xCharInfo *pmin = FONTINKMIN(pFont);
+        xQueryFontReplyPtr reply;
+        int nprotoxcistructs;
+        int rlength;
+
+        nprotoxcistructs = (pmax->rightSideBearing == pmin->rightSideBearing &&
+                            pmax->leftSideBearing == pmin->leftSideBearing &&
+                            pmax->descent == pmin->descent &&
+                            pmax->ascent == pmin->ascent &&
+                            pmax->characterWidth == pmin->characterWidth) ?
+            0 : N2dChars(pFont);
+
+        rlength = sizeof(xQueryFontReply) +
+            FONTINFONPROPS(FONTCHARSET(pFont)) * sizeof(xFontProp) +
+            nprotoxcistructs * sizeof(xCharInfo);
+        priv = calloc(1, sizeof(QFcacheRec) + rlength);
+        if (!priv)
+            return NULL;
+        priv->length = rlength;
+        reply = (xQueryFontReplyPtr) (priv + 1);
+        reply->type = X_Reply;
+        reply->length = bytes_to_int32(rlength - sizeof(xGenericReply));
+        QueryFont(pFont, reply, nprotoxcistructs);
+        xfont2_font_set_private(pFont, queryFontPrivateIndex, priv);
+    }
+    *lengthp = priv->length;
+    return (xQueryFontReplyPtr) (priv + 1);
+}
+
+/*
+ * FPEs that implement list_fonts rather than
+ * start_list_fonts_and_aliases (remote font servers and the builtins)
+ * get their list_fonts issued up front when the ListFonts closure is
+ * set up, so that the round trips of several font servers overlap
+ * instead of running back to back.  preErr[i] is Suspended while FPE i
+ * still has such a request in flight, LF_PRE_NONE when there is no
+ * overlapped result for it, and the completion code otherwise; the
+ * names collected in preNames[i] are merged into the reply when the
+ * main scan reaches that FPE.
+ */
+#define LF_PRE_NONE (-1)
+
+static Bool
+listFontsPrestartPending(LFclosurePtr c)
+{
+    int i;
+
+    if (!c->preErr)
+        return FALSE;
+    for (i = 0; i < c->num_fpes; i++)
+        if (c->preErr[i] == Suspended)
+            return TRUE;
+    return FALSE;
+}
+
 static Bool
 doListFontsAndAliases(ClientPtr client, LFclosurePtr c)
 {
@@ -583,6 +668,15 @@ doListFontsAndAliases(ClientPtr client, LFclosurePtr c)
             fpe = c->fpe_list[c->current.current_fpe];
             (*fpe_functions[fpe->type]->client_died) ((void *) client, fpe);
         }
+        if (c->preErr) {
+            /* abort overlapped list_fonts still in flight on other FPEs */
+            for (i = 0; i < c->num_fpes; i++)
+                if (c->preErr[i] == Suspended &&
+                    i != c->current.current_fpe &&
+                    fpe_functions[c->fpe_list[i]->type]->client_died)
+                    (*fpe_functions[c->fpe_list[i]->type]->client_died)
+                        ((void *) client, c->fpe_list[i]);
+        }
         err = Successful;
         goto bail;
     }
@@ -591,22 +685,69 @@ doListFontsAndAliases(ClientPtr client, LFclosurePtr c)
         goto finish;
 
     while (c->current.current_fpe < c->num_fpes) {
+        /* Once the name budget is filled, keep going only to drain
+           overlapped list_fonts requests that are still in flight. */
+        if (!c->haveSaved && c->names->nnames >= c->current.max_names &&
+            (!c->preErr || c->preErr[c->current.current_fpe] != Suspended)) {
+            c->current.current_fpe++;
+            continue;
+        }
+
         fpe = c->fpe_list[c->current.current_fpe];
         err = Successful;
 
         if (!fpe_functions[fpe->type]->start_list_fonts_and_aliases) {
             /* This FPE doesn't support/require list_fonts_and_aliases */
+            int fi = c->current.current_fpe;
 
-            err = (*fpe_functions[fpe->type]->list_fonts)
-                ((void *) c->client, fpe, c->current.pattern,
-                 c->current.patlen, c->current.max_names - c->names->nnames,
-                 c->names);
+            if (c->preErr && c->preErr[fi] == Suspended) {
+                /* pick up the list_fonts issued when the closure was
+                   set up; the pattern arguments are ignored while the
+                   request is in flight */
+                err = (*fpe_functions[fpe->type]->list_fonts)
+                    ((void *) c->client, fpe, c->current.pattern,
+                     c->current.patlen,
+                     c->current.max_names - c->names->nnames,
+                     c->preNames[fi]);
 
-            if (err == Suspended) {
-                if (!ClientIsAsleep(client))
-                    ClientSleep(client,
-                                (ClientSleepProcPtr) doListFontsAndAliases, c);
-                return TRUE;
+                if (err == Suspended) {
+                    if (!ClientIsAsleep(client))
+                        ClientSleep(client,
+                                    (ClientSleepProcPtr) doListFontsAndAliases,
+                                    c);
+                    return TRUE;
+                }
+                c->preErr[fi] = err;
+            }
+
+            if (c->preErr && !c->haveSaved && c->preErr[fi] != LF_PRE_NONE) {
+                /* merge the overlapped result, clipped to the budget */
+                FontNamesPtr pre = c->preNames[fi];
+
+                for (i = 0; pre && i < pre->nnames &&
+                     c->names->nnames < c->current.max_names; i++)
+                    (void) xfont2_add_font_names_name(c->names, pre->names[i],
+                                                      pre->length[i]);
+                if (pre)
+                    xfont2_free_font_names(pre);
+                c->preNames[fi] = NULL;
+                c->preErr[fi] = LF_PRE_NONE;
+            }
+            else {
+                /* no overlapped result for this FPE (or we are resolving
+                   an alias against a different pattern): ask it directly */
+                err = (*fpe_functions[fpe->type]->list_fonts)
+                    ((void *) c->client, fpe, c->current.pattern,
+                     c->current.patlen,
+                     c->current.max_names - c->names->nnames, c->names);
+
+                if (err == Suspended) {
+                    if (!ClientIsAsleep(client))
+                        ClientSleep(client,
+                                    (ClientSleepProcPtr) doListFontsAndAliases,
+                                    c);
+                    return TRUE;
+                }
             }
 
             err = BadFontName;
@@ -735,7 +876,8 @@ doListFontsAndAliases(ClientPtr client, LFclosurePtr c)
                     continue;
                 }
             }
-            if (c->names->nnames == c->current.max_names)
+            if (c->names->nnames == c->current.max_names &&
+                !listFontsPrestartPending(c))
                 break;
         }
     }
@@ -798,6 +940,13 @@ doListFontsAndAliases(ClientPtr client, LFclosurePtr c)
         free(c->fpe_list);
         free(c->savedName);
         xfont2_free_font_names(names);
+        if (c->preNames) {
+            for (i = 0; i < c->num_fpes; i++)
+                if (c->preNames[i])
+                    xfont2_free_font_names(c->preNames[i]);
+            free(c->preNames);
+        }
+        free(c->preErr);
         free(c);
     }
     free(resolved);
@@ -852,6 +1001,37 @@ ListFonts(ClientPtr client, unsigned char *pattern, unsigned length,
     c->haveSaved = FALSE;
     c->from_dispatch = TRUE;
     c->savedName = 0;
+    c->preNames = xallocarray(num_fpes, sizeof(FontNamesPtr));
+    c->preErr = xallocarray(num_fpes, sizeof(int));
+    if (!c->preNames || !c->preErr) {
+        /* fall back to scanning the FPEs one after another */
+        free(c->preNames);
+        free(c->preErr);
+        c->preNames = NULL;
+        c->preErr = NULL;
+    }
+    if (c->preErr) {
+        for (i = 0; i < num_fpes; i++) {
+            c->preNames[i] = NULL;
+            c->preErr[i] = LF_PRE_NONE;
+        }
+        /* issue list_fonts on every FPE that uses it before collecting
+           any results, so that remote FPEs answer in parallel */
+        for (i = 0; i < num_fpes; i++) {
+            FontPathElementPtr fpe = c->fpe_list[i];
+
+            if (fpe_functions[fpe->type]->start_list_fonts_and_aliases ||
+                !length)
+                continue;
+            c->preNames[i] = xfont2_make_font_names_record(max_names < 100 ?
+                                                           max_names : 100);
+            if (!c->preNames[i])
+                continue;
+            c->preErr[i] = (*fpe_functions[fpe->type]->list_fonts)
+                ((void *) client, fpe, c->current.pattern, c->current.patlen,
+                 max_names, c->preNames[i]);
+        }
+    }
     doListFontsAndAliases(client, c);
     return Success;
 }
@@ -2091,5 +2271,6 @@ InitFonts(void)
     if (fontPatternCache)
 	xfont2_free_font_pattern_cache(fontPatternCache);
     fontPatternCache = xfont2_make_font_pattern_cache();
+    queryFontPrivateIndex = xfont2_allocate_font_private_index();
     xfont2_init(&xfont2_client_funcs);
 }
@@ -669,6 +669,67 @@ ClientWakeup(ClientPtr client)
     }
 }
 
+/*
+ * Always-on per-window frame timing statistics.  DBE buffer swaps and
+ * Present executions record into a fixed table of per-window slots, so
+ * the frame path never allocates; the X-Resource extension reports the
+ * counts (see ProcXResQueryWindowFrameTiming in Xext/xres.c) so
+ * monitoring can spot sessions whose frame rate has collapsed.  Bucket
+ * 0 counts frame intervals under a millisecond, bucket n intervals of
+ * [2^(n-1), 2^n) milliseconds, and the last bucket collects everything
+ * slower.
+ */
+
+static FrameTimingSlot frameTimingSlots[FRAME_TIMING_SLOTS];
+
+FrameTimingSlot *
+FrameTimingLookup(XID window)
+{
+    int i;
+
+    for (i = 0; i < FRAME_TIMING_SLOTS; i++)
+        if (frameTimingSlots[i].window == window)
+            return &frameTimingSlots[i];
+    return NULL;
+}
+
+void
+FrameTimingRecord(XID window)
+{
+    FrameTimingSlot *slot = FrameTimingLookup(window);
+    CARD32 now = GetTimeInMillis();
+
+    if (!slot) {
+        /* recycle the slot that has gone longest without a frame */
+        int i, victim = 0;
+
+        for (i = 1; i < FRAME_TIMING_SLOTS; i++) {
+            if (frameTimingSlots[i].window == None) {
+                victim = i;
+                break;
+            }
+            if ((int) (frameTimingSlots[victim].lastTime -
+                       frameTimingSlots[i].lastTime) > 0)
+                victim = i;
+        }
+        slot = &frameTimingSlots[victim];
+        memset(slot, 0, sizeof(*slot));
+        slot->window = window;
+    }
+    else {
+        CARD32 interval = now - slot->lastTime;
+        int bucket = 0;
+
+        while (interval && bucket < FRAME_TIMING_BUCKETS - 1) {
+            interval >>= 1;
+            bucket++;
+        }
+        slot->intervals[bucket]++;
+    }
+    slot->frames++;
+    slot->lastTime = now;
+}
+
 Bool
 ClientIsAsleep(ClientPtr client)
 {
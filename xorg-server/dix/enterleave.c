@@ -215,10 +215,35 @@ SetFocusOut(DeviceIntPtr dev)
 static WindowPtr
 CommonAncestor(WindowPtr a, WindowPtr b)
 {
-    for (b = b->parent; b; b = b->parent)
-        if (IsParent(b, a))
-            return b;
-    return NullWindow;
+    WindowPtr w;
+    int depth_a = 0, depth_b = 0;
+
+    /* Testing IsParent for each ancestor of b walks a's chain once per
+       step, which makes focus transitions between deep windows
+       quadratic in tree depth.  Instead bring both windows to the same
+       depth and walk up in lockstep; the chains merge exactly at the
+       common ancestor, after one pass over each chain. */
+    for (w = a; w; w = w->parent)
+        depth_a++;
+    for (w = b; w; w = w->parent)
+        depth_b++;
+
+    while (depth_a > depth_b) {
+        a = a->parent;
+        depth_a--;
+    }
+    while (depth_b > depth_a) {
+        b = b->parent;
+        depth_b--;
+    }
+
+    /* the result must be a proper ancestor of both windows */
+    do {
+        a = a->parent;
+        b = b->parent;
+    } while (a != b);
+
+    return a;
 }
 
 /**
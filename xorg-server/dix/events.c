@@ -642,6 +642,7 @@ XineramaConfineCursorToWindow(DeviceIntPtr pDev,
         pSprite->hotShape = &pSprite->Reg1;
     else
         pSprite->hotShape = NullRegion;
+    pSprite->hotShapeBox.x1 = pSprite->hotShapeBox.x2 = 0;
 
     pSprite->confined = FALSE;
     pSprite->confineWin =
@@ -685,12 +686,25 @@ SetCriticalEvent(int event)
 void
 ConfineToShape(DeviceIntPtr pDev, RegionPtr shape, int *px, int *py)
 {
+    SpritePtr pSprite = pDev->spriteInfo->sprite;
     BoxRec box;
     int x = *px, y = *py;
     int incx = 1, incy = 1;
 
-    if (RegionContainsPoint(shape, x, y, &box))
+    /* Motion is spatially coherent, so the shape box the hot spot was
+     * found in last time usually still contains it; checking that is
+     * just four compares and spares the region walk per event.  The
+     * cached box is reset whenever hotShape is assigned. */
+    if (shape == pSprite->hotShape &&
+        x >= pSprite->hotShapeBox.x1 && x < pSprite->hotShapeBox.x2 &&
+        y >= pSprite->hotShapeBox.y1 && y < pSprite->hotShapeBox.y2)
+        return;
+
+    if (RegionContainsPoint(shape, x, y, &box)) {
+        if (shape == pSprite->hotShape)
+            pSprite->hotShapeBox = box;
         return;
+    }
     box = *RegionExtents(shape);
     /* this is rather crude */
     do {
@@ -711,6 +725,8 @@ ConfineToShape(DeviceIntPtr pDev, RegionPtr shape, int *px, int *py)
                 return;         /* should never get here! */
         }
     } while (!RegionContainsPoint(shape, x, y, &box));
+    if (shape == pSprite->hotShape)
+        pSprite->hotShapeBox = box;
     *px = x;
     *py = y;
 }
@@ -912,6 +928,7 @@ ConfineCursorToWindow(DeviceIntPtr pDev, WindowPtr pWin, Bool generateEvents,
         pSprite->hotLimits = *RegionExtents(&pWin->borderSize);
         pSprite->hotShape = wBoundingShape(pWin) ? &pWin->borderSize
             : NullRegion;
+        pSprite->hotShapeBox.x1 = pSprite->hotShapeBox.x2 = 0;
         CheckPhysLimits(pDev, pSprite->current, generateEvents,
                         confineToScreen, pWin->drawable.pScreen);
 
@@ -1220,8 +1237,14 @@ EnqueueEvent(InternalEvent *ev, DeviceIntPtr device)
     qe->event = (InternalEvent *) (qe + 1);
     memcpy(qe->event, event, eventlen);
     xorg_list_append(&qe->next, &syncEvents.pending);
+    device->deviceGrab.sync.pendingEvents++;
 }
 
+/* Bumped whenever FreezeThaw() thaws a device, so PlayReleasedEvents()
+ * only restarts its queue scan when replaying an event has actually
+ * released another device. */
+static unsigned long freezeGeneration;
+
 /**
  * Run through the list of events queued up in syncEvents.
  * For each event do:
@@ -1236,14 +1259,16 @@ PlayReleasedEvents(void)
 {
     QdEventPtr tmp;
     QdEventPtr qe=NULL;
-    DeviceIntPtr dev;
     DeviceIntPtr pDev;
 
  restart:
     xorg_list_for_each_entry_safe(qe, tmp, &syncEvents.pending, next) {
         if (!qe->device->deviceGrab.sync.frozen) {
+            unsigned long generation = freezeGeneration;
+
             xorg_list_del(&qe->next);
             pDev = qe->device;
+            pDev->deviceGrab.sync.pendingEvents--;
             if (qe->event->any.type == ET_Motion)
                 CheckVirtualMotion(pDev, qe, NullWindow);
             syncEvents.time.months = qe->months;
@@ -1279,14 +1304,13 @@ PlayReleasedEvents(void)
 #endif
             (*qe->device->public.processInputProc) (qe->event, qe->device);
             free(qe);
-            for (dev = inputInfo.devices; dev && dev->deviceGrab.sync.frozen;
-                 dev = dev->next);
-            if (!dev)
-                break;
 
-            /* Playing the event may have unfrozen another device. */
-            /* So to play it safe, restart at the head of the queue */
-            goto restart;
+            /* Playing the event may have unfrozen another device whose
+             * queued events precede the remaining ones; only then
+             * restart at the head of the queue.  Entries for devices
+             * that are still frozen cost no more than a flag check. */
+            if (freezeGeneration != generation)
+                goto restart;
         }
     }
 }
@@ -1302,6 +1326,8 @@ PlayReleasedEvents(void)
 static void
 FreezeThaw(DeviceIntPtr dev, Bool frozen)
 {
+    if (dev->deviceGrab.sync.frozen && !frozen)
+        freezeGeneration++;
     dev->deviceGrab.sync.frozen = frozen;
     if (frozen)
         dev->public.processInputProc = dev->public.enqueueInputProc;
@@ -1367,7 +1393,7 @@ ComputeFreezes(void)
         }
     }
     for (dev = inputInfo.devices; dev; dev = dev->next) {
-        if (!dev->deviceGrab.sync.frozen) {
+        if (!dev->deviceGrab.sync.frozen && dev->deviceGrab.sync.pendingEvents) {
             PlayReleasedEvents();
             break;
         }
@@ -2211,8 +2237,13 @@ GetClientsForDelivery(DeviceIntPtr dev, WindowPtr win,
 {
     int rc = 0;
 
-    if (core_get_type(events) != 0)
+    if (core_get_type(events) != 0) {
+        /* Has any client selected for the event? */
+        if (!(wOtherEventMasks(win) & filter))
+            goto out;
+
         *iclients = (InputClients *) wOtherClients(win);
+    }
     else if (xi2_get_type(events) != 0) {
         OtherInputMasks *inputMasks = wOtherInputMasks(win);
 
@@ -2254,14 +2285,21 @@ DeliverEventToInputClients(DeviceIntPtr dev, InputClients * inputclients,
         Mask mask;
         ClientPtr client = rClient(inputclients);
 
+        mask = GetEventMask(dev, events, inputclients);
+
+        /* a client that hasn't selected for the event can never receive
+           it, so check the mask before paying for the grab and security
+           checks below; with one listener among many clients only that
+           listener's checks are run */
+        if (filter != CantBeFiltered && !(mask & filter))
+            continue;
+
         if (IsInterferingGrab(client, dev, events))
             continue;
 
         if (IsWrongPointerBarrierClient(client, dev, events))
             continue;
 
-        mask = GetEventMask(dev, events, inputclients);
-
         if (XaceHook(XACE_RECEIVE_ACCESS, client, win, events, count))
             /* do nothing */ ;
         else if ((attempt = TryClientEvents(client, dev,
@@ -2803,39 +2841,80 @@ DeliverEvent(DeviceIntPtr dev, xEvent *xE, int count,
     return deliveries;
 }
 
+/**
+ * Wire conversions of one internal event, filled in lazily while the
+ * event propagates up the window tree.  The converted forms are window
+ * independent (FixUpEventFromWindow patches the per-window fields in
+ * place each time), so each format needs converting at most once per
+ * delivery pass regardless of how many windows and listeners see it.
+ */
+typedef struct {
+    Bool valid[XI2 + 1];        /* indexed by enum InputLevel */
+    int rc[XI2 + 1];
+    xEvent *xE[XI2 + 1];
+    int count[XI2 + 1];
+} EventConversionCache;
+
+static void
+FreeConvertedEvents(EventConversionCache *cache)
+{
+    int i;
+
+    for (i = CORE; i <= XI2; i++)
+        free(cache->xE[i]);
+}
+
 static int
 DeliverOneEvent(InternalEvent *event, DeviceIntPtr dev, enum InputLevel level,
-                WindowPtr win, Window child, GrabPtr grab)
+                WindowPtr win, Window child, GrabPtr grab,
+                EventConversionCache *cache)
 {
     xEvent *xE = NULL;
     int count = 0;
     int deliveries = 0;
     int rc;
 
-    switch (level) {
-    case XI2:
-        rc = EventToXI2(event, &xE);
-        count = 1;
-        break;
-    case XI:
-        rc = EventToXI(event, &xE, &count);
-        break;
-    case CORE:
-        rc = EventToCore(event, &xE, &count);
-        break;
-    default:
-        rc = BadImplementation;
-        break;
+    if (cache && cache->valid[level]) {
+        rc = cache->rc[level];
+        xE = cache->xE[level];
+        count = cache->count[level];
+    }
+    else {
+        switch (level) {
+        case XI2:
+            rc = EventToXI2(event, &xE);
+            count = 1;
+            break;
+        case XI:
+            rc = EventToXI(event, &xE, &count);
+            break;
+        case CORE:
+            rc = EventToCore(event, &xE, &count);
+            break;
+        default:
+            rc = BadImplementation;
+            break;
+        }
+
+        if (rc != Success)
+            BUG_WARN_MSG(rc != BadMatch,
+                         "%s: conversion to level %d failed with rc %d\n",
+                         dev->name, level, rc);
+
+        if (cache) {
+            cache->valid[level] = TRUE;
+            cache->rc[level] = rc;
+            cache->xE[level] = xE;
+            cache->count[level] = count;
+        }
     }
 
     if (rc == Success) {
         deliveries = DeliverEvent(dev, xE, count, win, child, grab);
-        free(xE);
+        if (!cache)
+            free(xE);
     }
-    else
-        BUG_WARN_MSG(rc != BadMatch,
-                     "%s: conversion to level %d failed with rc %d\n",
-                     dev->name, level, rc);
+
     return deliveries;
 }
 
@@ -2865,6 +2944,7 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
     Window child = None;
     int deliveries = 0;
     int mask;
+    EventConversionCache cache = { .valid = {FALSE} };
 
     verify_internal_event(event);
 
@@ -2873,14 +2953,15 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
             /* XI2 events first */
             if (mask & EVENT_XI2_MASK) {
                 deliveries =
-                    DeliverOneEvent(event, dev, XI2, pWin, child, grab);
+                    DeliverOneEvent(event, dev, XI2, pWin, child, grab, &cache);
                 if (deliveries > 0)
                     break;
             }
 
             /* XI events */
             if (mask & EVENT_XI1_MASK) {
-                deliveries = DeliverOneEvent(event, dev, XI, pWin, child, grab);
+                deliveries = DeliverOneEvent(event, dev, XI, pWin, child, grab,
+                                             &cache);
                 if (deliveries > 0)
                     break;
             }
@@ -2888,7 +2969,8 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
             /* Core event */
             if ((mask & EVENT_CORE_MASK) && IsMaster(dev) && dev->coreEvents) {
                 deliveries =
-                    DeliverOneEvent(event, dev, CORE, pWin, child, grab);
+                    DeliverOneEvent(event, dev, CORE, pWin, child, grab,
+                                    &cache);
                 if (deliveries > 0)
                     break;
             }
@@ -2905,6 +2987,8 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
         pWin = pWin->parent;
     }
 
+    FreeConvertedEvents(&cache);
+
     return deliveries;
 }
 
@@ -4729,6 +4813,16 @@ CoreEnterLeaveEvent(DeviceIntPtr mouse,
         mask = pWin->eventMask | wOtherEventMasks(pWin);
     }
 
+    /* A crossing traverses every window between the old and new sprite
+     * windows, and in a dense widget tree most of them never selected
+     * for crossing events.  The combined mask above is kept up to date
+     * at SelectInput time, so bail before building the event when
+     * nobody listens. */
+    if (!(mask & ((type == EnterNotify)
+                  ? (EnterWindowMask | KeymapStateMask)
+                  : LeaveWindowMask)))
+        return;
+
     memset(&event, 0, sizeof(xEvent));
     event.u.u.type = type;
     event.u.u.detail = detail;
@@ -4799,6 +4893,17 @@ DeviceEnterLeaveEvent(DeviceIntPtr mouse,
         (mode == XINotifyPassiveUngrab && type == XI_Enter))
         return;
 
+    /* Without an XI2 grab the event can only go to listeners selecting
+     * on pWin, so check the per-window XI2 mask before assembling the
+     * event; most windows crossed on the way to the destination never
+     * selected for XI_Enter/XI_Leave. */
+    if (!(grab && grab->grabtype == XI2)) {
+        OtherInputMasks *inputMasks = wOtherInputMasks(pWin);
+
+        if (!inputMasks || !xi2mask_isset(inputMasks->xi2mask, mouse, type))
+            return;
+    }
+
     btlen = (mouse->button) ? bits_to_bytes(mouse->button->numButtons) : 0;
     btlen = bytes_to_int32(btlen);
     len = sizeof(xXIEnterEvent) + btlen * 4;
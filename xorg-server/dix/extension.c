@@ -236,6 +236,9 @@ ProcQueryExtension(ClientPtr client)
     reply.length = 0;
     reply.major_opcode = 0;
 
+    /* bring up the extension now if its init was deferred */
+    InitDeferredExtension((char *) &stuff[1], stuff->nbytes);
+
     if (!NumExtensions)
         reply.present = xFalse;
     else {
@@ -262,6 +265,9 @@ ProcListExtensions(ClientPtr client)
 
     REQUEST_SIZE_MATCH(xReq);
 
+    /* the list must include extensions whose init is still deferred */
+    InitDeferredExtensions();
+
     memset(&reply, 0, sizeof(xListExtensionsReply));
     reply.type = X_Reply;
     reply.nExtensions = 0;
@@ -119,6 +119,32 @@ ValidateGC(DrawablePtr pDraw, GC * pGC)
 #define NEXT_PTR(_type, _var) { \
     _var = (_type)pUnion->ptr; pUnion++; }
 
+/*
+ * Precompute where in the dash list the GC's dash offset lands, so the
+ * rasterizers can start each request from the cached position instead
+ * of walking the pattern afresh every time.  Called whenever the dash
+ * list or dash offset changes; every dash is known to be non-zero.
+ */
+static void
+ComputeDashStart(GCPtr pGC)
+{
+    int dist = pGC->dashOffset;
+    int dashIndex = 0;
+    int totallen = 0;
+    int i;
+
+    for (i = 0; i < pGC->numInDashList; i++)
+        totallen += pGC->dash[i];
+    dist = dist % totallen;
+    while (dist >= pGC->dash[dashIndex]) {
+        dist -= pGC->dash[dashIndex];
+        if (++dashIndex == pGC->numInDashList)
+            dashIndex = 0;
+    }
+    pGC->dashStartIndex = dashIndex;
+    pGC->dashStartOffset = dist;
+}
+
 int
 ChangeGC(ClientPtr client, GC * pGC, BITS32 mask, ChangeGCValPtr pUnion)
 {
@@ -427,6 +453,8 @@ ChangeGC(ClientPtr client, GC * pGC, BITS32 mask, ChangeGCValPtr pUnion)
             error = BadAlloc;
         }
     }
+    if (maskQ & (GCDashOffset | GCDashList))
+        ComputeDashStart(pGC);
     (*pGC->funcs->ChangeGC) (pGC, maskQ);
     return error;
 }
@@ -517,6 +545,8 @@ NewGCObject(ScreenPtr pScreen, int depth)
     pGC->numInDashList = 2;
     pGC->dash = DefaultDash;
     pGC->dashOffset = 0;
+    pGC->dashStartIndex = 0;
+    pGC->dashStartOffset = 0;
 
     /* use the default font and stipple */
     pGC->font = defaultFont;
@@ -773,6 +803,8 @@ CopyGC(GC * pgcSrc, GC * pgcDst, BITS32 mask)
             error = BadAlloc;
         }
     }
+    if (maskQ & (GCDashOffset | GCDashList))
+        ComputeDashStart(pgcDst);
     (*pgcDst->funcs->CopyGC) (pgcSrc, maskQ, pgcDst);
     return error;
 }
@@ -847,6 +879,12 @@ FreeGCperDepth(int screenNum)
         (void) FreeGC(ppGC[i], (XID) 0);
         ppGC[i] = NULL;
     }
+    for (i = 0; i < MAXSCRATCHGCS; i++) {
+        if (pScreen->scratchGCs[i]) {
+            (void) FreeGC(pScreen->scratchGCs[i], (XID) 0);
+            pScreen->scratchGCs[i] = NULL;
+        }
+    }
 }
 
 Bool
@@ -969,6 +1007,8 @@ SetDashes(GCPtr pGC, unsigned offset, unsigned ndash, unsigned char *pdash)
     pGC->stateChanges |= GCDashList;
     maskQ |= GCDashList;
 
+    ComputeDashStart(pGC);
+
     if (pGC->funcs->ChangeGC)
         (*pGC->funcs->ChangeGC) (pGC, maskQ);
     return Success;
@@ -1047,6 +1087,32 @@ SetClipRects(GCPtr pGC, int xOrigin, int yOrigin, int nrects,
     return Success;
 }
 
+static void
+ResetScratchGC(GCPtr pGC)
+{
+    pGC->alu = GXcopy;
+    pGC->planemask = ~0;
+    pGC->serialNumber = 0;
+    pGC->fgPixel = 0;
+    pGC->bgPixel = 1;
+    pGC->lineWidth = 0;
+    pGC->lineStyle = LineSolid;
+    pGC->capStyle = CapButt;
+    pGC->joinStyle = JoinMiter;
+    pGC->fillStyle = FillSolid;
+    pGC->fillRule = EvenOddRule;
+    pGC->arcMode = ArcChord;
+    pGC->patOrg.x = 0;
+    pGC->patOrg.y = 0;
+    pGC->subWindowMode = ClipByChildren;
+    pGC->graphicsExposures = FALSE;
+    pGC->clipOrg.x = 0;
+    pGC->clipOrg.y = 0;
+    if (pGC->clientClip)
+        (*pGC->funcs->ChangeClip) (pGC, CT_NONE, NULL, 0);
+    pGC->stateChanges = GCAllBits;
+}
+
 /*
    sets reasonable defaults
    if we can get a pre-allocated one, use it and mark it as used.
@@ -1063,28 +1129,16 @@ GetScratchGC(unsigned depth, ScreenPtr pScreen)
         pGC = pScreen->GCperDepth[i];
         if (pGC && pGC->depth == depth && !pGC->scratch_inuse) {
             pGC->scratch_inuse = TRUE;
-
-            pGC->alu = GXcopy;
-            pGC->planemask = ~0;
-            pGC->serialNumber = 0;
-            pGC->fgPixel = 0;
-            pGC->bgPixel = 1;
-            pGC->lineWidth = 0;
-            pGC->lineStyle = LineSolid;
-            pGC->capStyle = CapButt;
-            pGC->joinStyle = JoinMiter;
-            pGC->fillStyle = FillSolid;
-            pGC->fillRule = EvenOddRule;
-            pGC->arcMode = ArcChord;
-            pGC->patOrg.x = 0;
-            pGC->patOrg.y = 0;
-            pGC->subWindowMode = ClipByChildren;
-            pGC->graphicsExposures = FALSE;
-            pGC->clipOrg.x = 0;
-            pGC->clipOrg.y = 0;
-            if (pGC->clientClip)
-                (*pGC->funcs->ChangeClip) (pGC, CT_NONE, NULL, 0);
-            pGC->stateChanges = GCAllBits;
+            ResetScratchGC(pGC);
+            return pGC;
+        }
+    }
+    /* the per-depth GC is busy; check for a parked spare */
+    for (i = 0; i < MAXSCRATCHGCS; i++) {
+        pGC = pScreen->scratchGCs[i];
+        if (pGC && pGC->depth == depth) {
+            pScreen->scratchGCs[i] = NULL;
+            ResetScratchGC(pGC);
             return pGC;
         }
     }
@@ -1095,13 +1149,25 @@ GetScratchGC(unsigned depth, ScreenPtr pScreen)
 /*
    if the gc to free is in the table of pre-existing ones,
 mark it as available.
-   if not, free it for real
+   if not, park it as a spare for the next GetScratchGC that finds
+the per-depth one busy, freeing it for real only when the spare
+slots are all full.
 */
 void
 FreeScratchGC(GCPtr pGC)
 {
-    if (pGC->scratch_inuse)
+    ScreenPtr pScreen = pGC->pScreen;
+    int i;
+
+    if (pGC->scratch_inuse) {
         pGC->scratch_inuse = FALSE;
-    else
-        FreeGC(pGC, (GContext) 0);
+        return;
+    }
+    for (i = 0; i < MAXSCRATCHGCS; i++) {
+        if (!pScreen->scratchGCs[i]) {
+            pScreen->scratchGCs[i] = pGC;
+            return;
+        }
+    }
+    FreeGC(pGC, (GContext) 0);
 }
@@ -1354,6 +1354,57 @@ QueuePointerEvents(DeviceIntPtr device, int type,
  *
  * @return the number of events written into events.
  */
+
+/**
+ * Check whether anyone can receive the raw copy of a pointer event
+ * before paying for its generation.  Raw events only ever reach the
+ * owner of an active device grab and XI2 clients that selected a raw
+ * mask on a root window (see DeliverRawEvent), so when neither exists
+ * for the device or its master the raw copy is dead weight.  That is
+ * the common case, and at high sample rates initializing and filling
+ * the raw event is a sizable slice of fill_pointer_events.
+ */
+static Bool
+raw_events_wanted(DeviceIntPtr dev, int type)
+{
+    DeviceIntPtr master;
+    int xitype;
+    int i;
+
+    switch (type) {
+    case MotionNotify:
+        xitype = XI_RawMotion;
+        break;
+    case ButtonPress:
+        xitype = XI_RawButtonPress;
+        break;
+    case ButtonRelease:
+        xitype = XI_RawButtonRelease;
+        break;
+    default:
+        return TRUE;
+    }
+
+    master = GetMaster(dev, MASTER_POINTER);
+
+    if (dev->deviceGrab.grab || (master && master->deviceGrab.grab))
+        return TRUE;
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        WindowPtr root = screenInfo.screens[i]->root;
+        OtherInputMasks *inputMasks = root ? wOtherInputMasks(root) : NULL;
+
+        if (!inputMasks)
+            continue;
+        if (xi2mask_isset(inputMasks->xi2mask, dev, xitype))
+            return TRUE;
+        if (master && xi2mask_isset(inputMasks->xi2mask, master, xitype))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 static int
 fill_pointer_events(InternalEvent *events, DeviceIntPtr pDev, int type,
                     int buttons, CARD32 ms, int flags,
@@ -1708,6 +1759,11 @@ GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
         }
     }
 
+    /* Don't generate raw events nobody can receive; checked after the
+     * scroll conversion above since that may have changed the type */
+    if ((flags & POINTER_NORAW) == 0 && !raw_events_wanted(pDev, type))
+        flags |= POINTER_NORAW;
+
     /* First fill out the original event set, with smooth-scrolling axes. */
     nev_tmp = fill_pointer_events(events, pDev, type, buttons, ms, flags,
                                   &mask);
@@ -57,6 +57,7 @@ SOFTWARE.
 #include "dixfont.h"
 #include "dixstruct.h"
 #include "os.h"
+#include "xserver-trace.h"
 
 ScreenInfo screenInfo;
 
@@ -118,3 +119,5 @@ const char *display;
 intptr_t displayfd = -1;
 Bool explicit_display = FALSE;
 char *ConnectionInfo;
+
+XserverTraceHooks *xserverTraceHooks = NULL;
@@ -48,6 +48,72 @@ from The Open Group.
  *  function.
  */
 
+/*
+ * Pool of recently freed pixmap allocations.  Compositing and trapezoid
+ * rasterisation create and destroy short-lived scratch pixmaps at a high
+ * rate; rather than return each header+data block to the system allocator
+ * just to ask for an equivalent one moments later, FreePixmap parks blocks
+ * on a per-screen free list bucketed by power-of-two size class and
+ * AllocatePixmap reuses them.  Each class holds at most PIXMAP_POOL_DEPTH
+ * blocks (linked through their first word); anything beyond that, or larger
+ * than the biggest class, goes straight back to the allocator.
+ *
+ * The pool is also kept under a total byte budget so that a burst of large
+ * pixmaps (a compositor redirecting every top-level window, say) does not
+ * leave megabytes parked for the rest of a week-long session.  When parking
+ * a block would exceed the budget the largest parked blocks are returned to
+ * the allocator first; everything in the pool is a pure cache, so trimming
+ * costs nothing beyond a later calloc.
+ */
+
+#define PIXMAP_POOL_MIN_SHIFT   9       /* smallest class, 512 bytes */
+#define PIXMAP_POOL_MAX_SHIFT   22      /* largest class, 4 MB */
+#define PIXMAP_POOL_CLASSES     (PIXMAP_POOL_MAX_SHIFT - PIXMAP_POOL_MIN_SHIFT + 1)
+#define PIXMAP_POOL_DEPTH       8       /* high-water mark per class */
+#ifndef PIXMAP_POOL_MAX_BYTES
+#define PIXMAP_POOL_MAX_BYTES   (16 * 1024 * 1024)      /* per screen */
+#endif
+
+typedef struct _PixmapPool {
+    void *freeList[PIXMAP_POOL_CLASSES];
+    int count[PIXMAP_POOL_CLASSES];
+    size_t bytes;
+} PixmapPoolRec;
+
+static int
+PixmapPoolSizeClass(size_t size)
+{
+    int class = 0;
+    size_t classSize = (size_t) 1 << PIXMAP_POOL_MIN_SHIFT;
+
+    while (classSize < size) {
+        classSize <<= 1;
+        class++;
+    }
+    return (class < PIXMAP_POOL_CLASSES) ? class : -1;
+}
+
+/* Free parked blocks, largest first, until the pool holds at most
+   target bytes */
+static void
+PixmapPoolTrim(PixmapPoolRec *pool, size_t target)
+{
+    int class = PIXMAP_POOL_CLASSES - 1;
+
+    while (pool->bytes > target && class >= 0) {
+        if (pool->freeList[class]) {
+            void *block = pool->freeList[class];
+
+            pool->freeList[class] = *(void **) block;
+            pool->count[class]--;
+            pool->bytes -= (size_t) 1 << (class + PIXMAP_POOL_MIN_SHIFT);
+            free(block);
+        }
+        else
+            class--;
+    }
+}
+
 /* callable by ddx */
 PixmapPtr
 GetScratchPixmapHeader(ScreenPtr pScreen, int width, int height, int depth,
@@ -96,6 +162,10 @@ CreateScratchPixmapsForScreen(ScreenPtr pScreen)
 
     /* let it be created on first use */
     pScreen->pScratchPixmap = NULL;
+
+    /* the pool is an optimisation; without it we simply fall back to the
+       system allocator for every pixmap */
+    pScreen->pPixmapPool = calloc(1, sizeof(PixmapPoolRec));
     return TRUE;
 }
 
@@ -103,22 +173,59 @@ void
 FreeScratchPixmapsForScreen(ScreenPtr pScreen)
 {
     FreeScratchPixmapHeader(pScreen->pScratchPixmap);
+
+    if (pScreen->pPixmapPool) {
+        PixmapPoolRec *pool = pScreen->pPixmapPool;
+        int class;
+
+        /* stop FreePixmap repopulating the pool while it drains */
+        pScreen->pPixmapPool = NULL;
+        for (class = 0; class < PIXMAP_POOL_CLASSES; class++) {
+            while (pool->freeList[class]) {
+                void *block = pool->freeList[class];
+
+                pool->freeList[class] = *(void **) block;
+                free(block);
+            }
+        }
+        free(pool);
+    }
 }
 
 /* callable by ddx */
 PixmapPtr
 AllocatePixmap(ScreenPtr pScreen, int pixDataSize)
 {
-    PixmapPtr pPixmap;
+    PixmapPtr pPixmap = NullPixmap;
+    PixmapPoolRec *pool = pScreen->pPixmapPool;
+    size_t totalSize;
+    int class;
 
     assert(pScreen->totalPixmapSize > 0);
 
     if (pScreen->totalPixmapSize > ((size_t) - 1) - pixDataSize)
         return NullPixmap;
 
-    pPixmap = calloc(1, pScreen->totalPixmapSize + pixDataSize);
-    if (!pPixmap)
-        return NullPixmap;
+    totalSize = pScreen->totalPixmapSize + pixDataSize;
+    class = PixmapPoolSizeClass(totalSize);
+
+    if (pool && class >= 0 && pool->freeList[class]) {
+        pPixmap = pool->freeList[class];
+        pool->freeList[class] = *(void **) pPixmap;
+        pool->count[class]--;
+        pool->bytes -= (size_t) 1 << (class + PIXMAP_POOL_MIN_SHIFT);
+        memset(pPixmap, 0, totalSize);
+    }
+    else {
+        /* round pooled allocations up to their class size so any free
+           block in a class can satisfy any request falling in it */
+        if (class >= 0)
+            totalSize = (size_t) 1 << (class + PIXMAP_POOL_MIN_SHIFT);
+        pPixmap = calloc(1, totalSize);
+        if (!pPixmap)
+            return NullPixmap;
+    }
+    pPixmap->size_class = class + 1;
 
     dixInitScreenPrivates(pScreen, pPixmap, pPixmap + 1, PRIVATE_PIXMAP);
     return pPixmap;
@@ -128,7 +235,26 @@ AllocatePixmap(ScreenPtr pScreen, int pixDataSize)
 void
 FreePixmap(PixmapPtr pPixmap)
 {
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
     dixFiniPrivates(pPixmap, PRIVATE_PIXMAP);
+
+    if (pPixmap->size_class && pScreen && pScreen->pPixmapPool) {
+        PixmapPoolRec *pool = pScreen->pPixmapPool;
+        int class = pPixmap->size_class - 1;
+
+        if (pool->count[class] < PIXMAP_POOL_DEPTH) {
+            size_t blockSize = (size_t) 1 << (class + PIXMAP_POOL_MIN_SHIFT);
+
+            if (pool->bytes + blockSize > PIXMAP_POOL_MAX_BYTES)
+                PixmapPoolTrim(pool, PIXMAP_POOL_MAX_BYTES - blockSize);
+            *(void **) pPixmap = pool->freeList[class];
+            pool->freeList[class] = pPixmap;
+            pool->count[class]++;
+            pool->bytes += blockSize;
+            return;
+        }
+    }
     free(pPixmap);
 }
 
@@ -761,18 +761,24 @@ dixPrivateUsage(void)
     int objects = 0;
     int bytes = 0;
     int alloc = 0;
+    /* counts at the previous report, so that successive dumps from a
+       long-lived session show which domain is trending upward */
+    static int prev_created[PRIVATE_LAST];
     DevPrivateType t;
 
     for (t = PRIVATE_XSELINUX + 1; t < PRIVATE_LAST; t++) {
-        if (global_keys[t].offset) {
+        if (global_keys[t].offset || global_keys[t].created) {
             ErrorF
-                ("%s: %d objects of %d bytes = %d total bytes %d private allocs\n",
+                ("%s: %d objects of %d bytes = %d total bytes %d private allocs (%+d objects since last report)\n",
                  key_names[t], global_keys[t].created, global_keys[t].offset,
-                 global_keys[t].created * global_keys[t].offset, global_keys[t].allocated);
+                 global_keys[t].created * global_keys[t].offset,
+                 global_keys[t].allocated,
+                 global_keys[t].created - prev_created[t]);
             bytes += global_keys[t].created * global_keys[t].offset;
             objects += global_keys[t].created;
             alloc += global_keys[t].allocated;
         }
+        prev_created[t] = global_keys[t].created;
     }
     ErrorF("TOTAL: %d objects, %d bytes, %d allocs\n", objects, bytes, alloc);
 }
@@ -90,15 +90,23 @@ int
 dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
                   ClientPtr client, Mask access_mode)
 {
-    PropertyPtr pProp;
+    PropertyPtr pProp, prev = NULL;
     int rc = BadMatch;
 
     client->errorValue = propertyName;
 
-    for (pProp = wUserProps(pWin); pProp; pProp = pProp->next)
+    for (pProp = wUserProps(pWin); pProp; prev = pProp, pProp = pProp->next)
         if (pProp->propertyName == propertyName)
             break;
 
+    /* Move the property to the front of the list so that frequently
+       polled properties hit on the first probe next time */
+    if (pProp && prev) {
+        prev->next = pProp->next;
+        pProp->next = pWin->optional->userProps;
+        pWin->optional->userProps = pProp;
+    }
+
     if (pProp)
         rc = XaceHookPropertyAccess(client, pWin, &pProp, access_mode);
     *result = pProp;
@@ -190,6 +198,7 @@ ProcRotateProperties(ClientPtr client)
             props[j]->type = saved[i].type;
             props[j]->format = saved[i].format;
             props[j]->size = saved[i].size;
+            props[j]->cap = saved[i].cap;
             props[j]->data = saved[i].data;
         }
     }
@@ -285,6 +294,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
         pProp->format = format;
         pProp->data = data;
         pProp->size = len;
+        pProp->cap = len;
         rc = XaceHookPropertyAccess(pClient, pWin, &pProp,
                                     DixCreateAccess | DixWriteAccess);
         if (rc != Success) {
@@ -317,6 +327,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             memcpy(data, value, totalSize);
             pProp->data = data;
             pProp->size = len;
+            pProp->cap = len;
             pProp->type = type;
             pProp->format = format;
         }
@@ -324,13 +335,31 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             /* do nothing */
         }
         else if (mode == PropModeAppend) {
-            data = xallocarray(pProp->size + len, sizeInBytes);
-            if (!data)
-                return BadAlloc;
-            memcpy(data, pProp->data, pProp->size * sizeInBytes);
-            memcpy(data + pProp->size * sizeInBytes, value, totalSize);
-            pProp->data = data;
-            pProp->size += len;
+            if (pProp->size + len <= pProp->cap) {
+                /* Room left over from an earlier append: write in place.
+                   The bytes below pProp->size are untouched, so restoring
+                   savedProp on a XACE denial below still works. */
+                memcpy((unsigned char *) pProp->data +
+                       pProp->size * sizeInBytes, value, totalSize);
+                pProp->size += len;
+            }
+            else {
+                /* Grow geometrically so that repeated appends (session
+                   manager logs, incremental selections) stay linear
+                   instead of copying the whole value every time */
+                uint32_t cap = pProp->size + len;
+
+                if (cap < pProp->cap + pProp->cap / 2)
+                    cap = pProp->cap + pProp->cap / 2;
+                data = xallocarray(cap, sizeInBytes);
+                if (!data)
+                    return BadAlloc;
+                memcpy(data, pProp->data, pProp->size * sizeInBytes);
+                memcpy(data + pProp->size * sizeInBytes, value, totalSize);
+                pProp->data = data;
+                pProp->size += len;
+                pProp->cap = cap;
+            }
         }
         else if (mode == PropModePrepend) {
             data = xallocarray(len + pProp->size, sizeInBytes);
@@ -340,6 +369,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             memcpy(data, value, totalSize);
             pProp->data = data;
             pProp->size += len;
+            pProp->cap = pProp->size;
         }
 
         /* Allow security modules to check the new content */
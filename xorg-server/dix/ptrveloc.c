@@ -754,8 +754,31 @@ ApplyConstantDeceleration(DeviceVelocityPtr vel, double *fdx, double *fdy)
     *fdy *= vel->const_acceleration;
 }
 
+/**
+ * (Re)sample the profile transfer function into the cache table.
+ * Sampling through the regular profile function keeps arbitrary
+ * profiles, including driver-supplied ones, working unmodified.
+ */
+static void
+BuildProfileCache(DeviceIntPtr dev, DeviceVelocityPtr vel,
+                  double threshold, double acc)
+{
+    int i;
+
+    for (i = 0; i < ACCEL_PROFILE_CACHE_SIZE; i++)
+        vel->profile_cache.acc[i] =
+            vel->Profile(dev, vel, (double) i / ACCEL_PROFILE_CACHE_RES,
+                         threshold, acc);
+    vel->profile_cache.threshold = threshold;
+    vel->profile_cache.accel_coeff = acc;
+    vel->profile_cache.min_acceleration = vel->min_acceleration;
+    vel->profile_cache.profile = vel->Profile;
+}
+
 /*
- * compute the acceleration for given velocity and enforce min_acceleration
+ * compute the acceleration for given velocity and enforce min_acceleration.
+ * Most motion is served from the profile cache; the profile function itself
+ * only runs to (re)build the cache or for out-of-range velocities.
  */
 double
 BasicComputeAcceleration(DeviceIntPtr dev,
@@ -765,7 +788,27 @@ BasicComputeAcceleration(DeviceIntPtr dev,
 
     double result;
 
-    result = vel->Profile(dev, vel, velocity, threshold, acc);
+    /* min_acceleration feeds into some profiles, so it invalidates too */
+    if (vel->Profile != vel->profile_cache.profile ||
+        threshold != vel->profile_cache.threshold ||
+        acc != vel->profile_cache.accel_coeff ||
+        vel->min_acceleration != vel->profile_cache.min_acceleration)
+        BuildProfileCache(dev, vel, threshold, acc);
+
+    if (velocity >= 0 &&
+        velocity < (double) (ACCEL_PROFILE_CACHE_SIZE - 1) /
+                   ACCEL_PROFILE_CACHE_RES) {
+        /* interpolate between adjacent samples */
+        double pos = velocity * ACCEL_PROFILE_CACHE_RES;
+        int idx = (int) pos;
+        double frac = pos - idx;
+
+        result = vel->profile_cache.acc[idx] * (1.0 - frac) +
+                 vel->profile_cache.acc[idx + 1] * frac;
+    }
+    else {
+        result = vel->Profile(dev, vel, velocity, threshold, acc);
+    }
 
     /* enforce min_acceleration */
     if (result < vel->min_acceleration)
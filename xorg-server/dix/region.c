@@ -169,7 +169,7 @@ Equipment Corporation.
         ((r1)->y1 <= (r2)->y1) && \
         ((r1)->y2 >= (r2)->y2) )
 
-#define xfreeData(reg) if ((reg)->data && (reg)->data->size) free((reg)->data)
+#define xfreeData(reg) if ((reg)->data && (reg)->data->size) RegionDataFree((reg)->data)
 
 #define RECTALLOC_BAIL(pReg,n,bail) \
 if (!(pReg)->data || (((pReg)->data->numRects + (n)) > (pReg)->data->size)) \
@@ -227,6 +227,79 @@ InitRegions(void)
                                       &RegionBrokenData);
 }
 
+/*
+ * Region data blocks are allocated and freed at a very high rate --
+ * damage tracking and clip validation perform region arithmetic for
+ * nearly every drawing request -- and the vast majority of them hold
+ * only a handful of rectangles.  Rather than going to malloc/free each
+ * time, freed blocks are kept binned by power-of-two capacity and
+ * handed back to later allocations.  Requests are rounded up to the
+ * bin capacity so a recycled block always fits; anything larger than
+ * the biggest bin falls back to malloc/free.  All region arithmetic
+ * happens in the main dispatch thread, so the cache needs no locking.
+ */
+
+#define REGION_DATA_BINS	6       /* capacities of 8 .. 256 rects */
+#define REGION_DATA_MIN_SHIFT	3
+#define REGION_DATA_MAX_BLOCKS	16      /* blocks retained per bin */
+
+static RegDataPtr regionDataCache[REGION_DATA_BINS][REGION_DATA_MAX_BLOCKS];
+static int regionDataCached[REGION_DATA_BINS];
+
+static RegDataPtr
+RegionDataAlloc(int n)
+{
+    RegDataPtr data;
+    size_t rgnSize;
+    int bin;
+
+    for (bin = 0; bin < REGION_DATA_BINS; bin++) {
+        int cap = 1 << (REGION_DATA_MIN_SHIFT + bin);
+
+        if (cap < n)
+            continue;
+        if (regionDataCached[bin]) {
+            data = regionDataCache[bin][--regionDataCached[bin]];
+        }
+        else {
+            data = malloc(RegionSizeof(cap));
+            if (!data)
+                return NULL;
+        }
+        data->size = cap;
+        return data;
+    }
+
+    rgnSize = RegionSizeof(n);
+    data = (rgnSize > 0) ? malloc(rgnSize) : NULL;
+    if (data)
+        data->size = n;
+    return data;
+}
+
+static void
+RegionDataFree(RegDataPtr data)
+{
+    int bin;
+
+    if (!data || !data->size)
+        return;
+    /*
+     * Bin by the largest capacity the block is known to hold; the size
+     * field never exceeds what was actually allocated.
+     */
+    for (bin = REGION_DATA_BINS; bin-- > 0;) {
+        if ((1 << (REGION_DATA_MIN_SHIFT + bin)) <= data->size) {
+            if (regionDataCached[bin] < REGION_DATA_MAX_BLOCKS) {
+                regionDataCache[bin][regionDataCached[bin]++] = data;
+                return;
+            }
+            break;
+        }
+    }
+    free(data);
+}
+
 /*****************************************************************
  *   RegionCreate(rect, size)
  *     This routine does a simple malloc to make a structure of
@@ -349,16 +422,14 @@ RegionRectAlloc(RegionPtr pRgn, int n)
 
     if (!pRgn->data) {
         n++;
-        rgnSize = RegionSizeof(n);
-        pRgn->data = (rgnSize > 0) ? malloc(rgnSize) : NULL;
+        pRgn->data = RegionDataAlloc(n);
         if (!pRgn->data)
             return RegionBreak(pRgn);
         pRgn->data->numRects = 1;
         *RegionBoxptr(pRgn) = pRgn->extents;
     }
     else if (!pRgn->data->size) {
-        rgnSize = RegionSizeof(n);
-        pRgn->data = (rgnSize > 0) ? malloc(rgnSize) : NULL;
+        pRgn->data = RegionDataAlloc(n);
         if (!pRgn->data)
             return RegionBreak(pRgn);
         pRgn->data->numRects = 0;
@@ -375,8 +446,8 @@ RegionRectAlloc(RegionPtr pRgn, int n)
         if (!data)
             return RegionBreak(pRgn);
         pRgn->data = data;
+        pRgn->data->size = n;
     }
-    pRgn->data->size = n;
     return TRUE;
 }
 
@@ -768,7 +839,7 @@ RegionOp(RegionPtr newReg,      /* Place to store result         */
         AppendRegions(newReg, r2BandEnd, r2End);
     }
 
-    free(oldData);
+    RegionDataFree(oldData);
 
     if (!(numRects = newReg->data->numRects)) {
         xfreeData(newReg);
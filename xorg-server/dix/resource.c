@@ -156,7 +156,15 @@ static void RebuildTable(int    /*client */
 
 #define INITBUCKETS 64
 #define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+/*
+ * The table doubles when the load factor reaches REHASH_LOAD, so chains
+ * stay short for clients with very large resource populations (pixmap
+ * caches, toolkits interning one resource per widget).  The old limits
+ * (load factor 4, 2^16 buckets) left lookups walking multi-element
+ * chains once a client held a few hundred thousand resources.
+ */
+#define MAXHASHSIZE 20
+#define REHASH_LOAD 2
 
 typedef struct _Resource {
     struct _Resource *next;
@@ -815,7 +823,8 @@ AddResource(XID id, RESTYPE type, void *value)
                (unsigned long) id, type, (unsigned long)(uintptr_t) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
+    if ((rrec->elements >= REHASH_LOAD * rrec->buckets) &&
+        (rrec->hashsize < MAXHASHSIZE))
         RebuildTable(client);
     head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
     res = malloc(sizeof(ResourceRec));
@@ -71,17 +71,26 @@ int
 dixLookupSelection(Selection ** result, Atom selectionName,
                    ClientPtr client, Mask access_mode)
 {
-    Selection *pSel;
+    Selection *pSel, *pPrev = NULL;
     int rc = BadMatch;
 
     client->errorValue = selectionName;
 
-    for (pSel = CurrentSelections; pSel; pSel = pSel->next)
+    for (pSel = CurrentSelections; pSel; pPrev = pSel, pSel = pSel->next)
         if (pSel->selection == selectionName)
             break;
 
-    if (pSel)
+    if (pSel) {
+        /* move to front: clipboard and drag-and-drop transfers probe
+           the same selection once per offered target, so the busy
+           selection stays at the head of the list */
+        if (pPrev) {
+            pPrev->next = pSel->next;
+            pSel->next = CurrentSelections;
+            CurrentSelections = pSel;
+        }
         rc = XaceHookSelectionAccess(client, &pSel, access_mode);
+    }
     *result = pSel;
     return rc;
 }
@@ -67,8 +67,13 @@ static void SwapFont(xQueryFontReply * pr, Bool hasGlyphs);
  * Thanks to Jack Palevich for testing and subsequently rewriting all this
  *
  *  \param size size in bytes
+ *
+ * The bulk list writers below are deliberately not _X_COLD: the cold
+ * attribute makes gcc optimize the function for size, which disables
+ * the unrolling and vectorization these byte-swapping loops depend on,
+ * and for a swapped client they run over every reply payload.
  */
-void _X_COLD
+void
 Swap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
 {
     int i;
@@ -87,7 +92,7 @@ Swap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
  *
  * \param size size in bytes
  */
-void _X_COLD
+void
 CopySwap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
 {
     int bufsize = size;
@@ -134,7 +139,7 @@ CopySwap32Write(ClientPtr pClient, int size, CARD32 *pbuf)
  *
  * \param size size in bytes
  */
-void _X_COLD
+void
 CopySwap16Write(ClientPtr pClient, int size, short *pbuf)
 {
     int bufsize = size;
@@ -295,7 +300,7 @@ SwapTimecoord(xTimecoord * pCoord)
     swaps(&pCoord->y);
 }
 
-void _X_COLD
+void
 SwapTimeCoordWrite(ClientPtr pClient, int size, xTimecoord * pRep)
 {
     int i, n;
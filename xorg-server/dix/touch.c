@@ -252,6 +252,7 @@ TouchFreeTouchPoint(DeviceIntPtr device, int index)
     ti->sprite.spriteTrace = NULL;
     free(ti->listeners);
     ti->listeners = NULL;
+    ti->listeners_size = 0;
     free(ti->history);
     ti->history = NULL;
     ti->history_size = 0;
@@ -360,13 +361,15 @@ TouchEndTouch(DeviceIntPtr dev, TouchPointInfoPtr ti)
     ti->active = FALSE;
     ti->pending_finish = FALSE;
     ti->sprite.spriteTraceGood = 0;
-    free(ti->listeners);
-    ti->listeners = NULL;
+    /* The listener and history buffers are kept for the next touch on
+     * this slot, so a full complement of fingers reaches a steady state
+     * where begin/end cycles allocate nothing; TouchFreeTouchPoint
+     * releases them with the device. */
     ti->num_listeners = 0;
     ti->num_grabs = 0;
     ti->client_id = 0;
 
-    TouchEventHistoryFree(ti);
+    ti->history_elements = 0;
 
     valuator_mask_zero(ti->valuators);
 }
@@ -521,12 +524,22 @@ TouchBuildSprite(DeviceIntPtr sourcedev, TouchPointInfoPtr ti,
         return FALSE;
 
     /* Mark which grabs/event selections we're delivering to: max one grab per
-     * window plus the bottom-most event selection, plus any active grab. */
-    ti->listeners = calloc(sprite->spriteTraceGood + 2, sizeof(*ti->listeners));
-    if (!ti->listeners) {
-        sprite->spriteTraceGood = 0;
-        return FALSE;
+     * window plus the bottom-most event selection, plus any active grab.
+     * The array persists across touches on this slot and only ever grows,
+     * so repeated touches under the same window depth reuse it. */
+    if ((size_t) sprite->spriteTraceGood + 2 > ti->listeners_size) {
+        TouchListener *listeners = reallocarray(ti->listeners,
+                                                sprite->spriteTraceGood + 2,
+                                                sizeof(*ti->listeners));
+
+        if (!listeners) {
+            sprite->spriteTraceGood = 0;
+            return FALSE;
+        }
+        ti->listeners = listeners;
+        ti->listeners_size = sprite->spriteTraceGood + 2;
     }
+    memset(ti->listeners, 0, ti->listeners_size * sizeof(*ti->listeners));
     ti->num_listeners = 0;
 
     return TRUE;
@@ -162,6 +162,11 @@ int screenIsSaved = SCREEN_SAVER_OFF;
 
 static Bool TileScreenSaver(ScreenPtr pScreen, int kind);
 
+Bool deferWindowValidation = FALSE;
+
+/* per-screen: a batched configure run left the clip lists stale */
+static Bool deferredValidation[MAXSCREENS];
+
 #define INPUTONLY_LEGAL_MASK (CWWinGravity | CWEventMask | \
 			      CWDontPropagate | CWOverrideRedirect | CWCursor )
 
@@ -2149,6 +2154,37 @@ WhereDoIGoInTheStack(WindowPtr pWin,
     }
 }
 
+/*****
+ * ValidateDeferredTrees
+ *    Recompute the clip lists left stale by a batched run of configure
+ *    requests (see ConfigureWindow).  Each affected screen is validated
+ *    once, from the root down, so a run of n moves costs one tree
+ *    validation and one round of exposures instead of n.
+ *****/
+
+void
+ValidateDeferredTrees(void)
+{
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens; i++) {
+        ScreenPtr pScreen = screenInfo.screens[i];
+        WindowPtr pRoot = pScreen->root;
+
+        if (!deferredValidation[i])
+            continue;
+        deferredValidation[i] = FALSE;
+        if (pRoot->firstChild &&
+            (*pScreen->MarkOverlappedWindows) (pRoot->firstChild,
+                                               pRoot->firstChild, NULL)) {
+            (*pScreen->ValidateTree) (pRoot, NullWindow, VTOther);
+            (*pScreen->HandleExposures) (pRoot);
+            if (pScreen->PostValidateTree)
+                (*pScreen->PostValidateTree) (pRoot, NullWindow, VTOther);
+        }
+    }
+}
+
 static void
 ReflectStackChange(WindowPtr pWin, WindowPtr pSib, VTKind kind)
 {
@@ -2166,7 +2202,7 @@ ReflectStackChange(WindowPtr pWin, WindowPtr pSib, VTKind kind)
 
     pFirstChange = MoveWindowInStack(pWin, pSib);
 
-    if (WasViewable) {
+    if (WasViewable && !deferWindowValidation) {
         anyMarked = (*pScreen->MarkOverlappedWindows) (pWin, pFirstChange,
                                                        &pLayerWin);
         if (pLayerWin != pWin)
@@ -2407,6 +2443,21 @@ ConfigureWindow(WindowPtr pWin, Mask mask, XID *vlist, ClientPtr client)
         else
             pWin->borderWidth = bw;
     }
+    /* Session restores and window-manager layout passes commonly issue
+     * long runs of ConfigureWindow back to back, and each move or
+     * restack normally revalidates the window tree and generates
+     * exposures on its own.  When the client's next request is already
+     * buffered and is another ConfigureWindow, leave the clip lists
+     * stale instead and validate the whole tree once at the end of the
+     * run (ValidateDeferredTrees).  Resizes are exempt: the gravity
+     * handling in ResizeWindow copies pixels and needs valid clips.
+     */
+    if ((action == MOVE_WIN || (action == RESTACK_WIN && (mask & CWStackMode))) &&
+        PeekNextRequestMajorOp(client) == X_ConfigureWindow)
+        deferWindowValidation = TRUE;
+    else
+        ValidateDeferredTrees();
+
     if (action == MOVE_WIN)
         (*pWin->drawable.pScreen->MoveWindow) (pWin, x, y, pSib,
                                                (mask & CWBorderWidth) ? VTOther
@@ -2416,6 +2467,11 @@ ConfigureWindow(WindowPtr pWin, Mask mask, XID *vlist, ClientPtr client)
     else if (mask & CWStackMode)
         ReflectStackChange(pWin, pSib, VTOther);
 
+    if (deferWindowValidation) {
+        deferWindowValidation = FALSE;
+        deferredValidation[pWin->drawable.pScreen->myNum] = TRUE;
+    }
+
     if (action != RESTACK_WIN)
         CheckCursorConfinement(pWin);
     return Success;
@@ -415,12 +415,32 @@ typedef struct {
 #define fbGetScreenPrivate(pScreen) ((FbScreenPrivPtr) \
 				     dixLookupPrivate(&(pScreen)->devPrivates, fbGetScreenPrivateKey()))
 
+/*
+ * Memo of a composite clip computed on a previous validation.  A slot
+ * holds the region for one (drawable, drawable serial) pair, so a GC
+ * alternating between two drawables revalidates without redoing the
+ * clip merge each time.  The region is owned by the memo, not by the
+ * GC, and is freed when the slot is evicted or the GC is destroyed.
+ */
+#define FB_CLIP_MEMO_SIZE   2
+
+typedef struct {
+    RegionPtr region;           /* memoized clip, NULL if slot empty */
+    XID drawable;
+    unsigned long serial;       /* drawable serial when computed */
+} FbClipMemoRec;
+
 /* private field of GC */
 typedef struct {
     FbBits and, xor;            /* reduced rop values */
     FbBits bgand, bgxor;        /* for stipples */
     FbBits fg, bg, pm;          /* expanded and filled */
     unsigned int dashLength;    /* total of all dash elements */
+    void (*fill) (DrawablePtr pDrawable, GCPtr pGC,
+                  int x, int y, int width, int height);
+                                /* fill specialized on fillStyle */
+    FbClipMemoRec clipMemo[FB_CLIP_MEMO_SIZE];
+    int clipMemoNext;           /* next slot to evict */
 } FbGCPrivRec, *FbGCPrivPtr;
 
 #define fbGetGCPrivateKey(pGC)  (&fbGetScreenPrivate((pGC)->pScreen)->gcPrivateKeyRec)
@@ -821,6 +841,9 @@ fbCopyPlane(DrawablePtr pSrcDrawable,
 extern _X_EXPORT void
  fbFill(DrawablePtr pDrawable, GCPtr pGC, int x, int y, int width, int height);
 
+extern _X_EXPORT void
+ fbUpdateGCFill(GCPtr pGC);
+
 extern _X_EXPORT void
 
 fbSolidBoxClipped(DrawablePtr pDrawable,
@@ -861,6 +884,9 @@ extern _X_EXPORT void
 extern _X_EXPORT void
  fbValidateGC(GCPtr pGC, unsigned long changes, DrawablePtr pDrawable);
 
+extern _X_EXPORT void
+ fbDestroyGC(GCPtr pGC);
+
 /*
  * fbgetsp.c
  */
@@ -39,6 +39,49 @@
     } \
 }
 
+/*
+ * Specialized forward row loops, one per (alignment, rop class)
+ * combination; fbBlt selects one once per call.  Reverse blts are
+ * rare (overlapping copies only) and stay on the open-coded loops
+ * below.
+ */
+
+#define BLTSPEC fbBltAlignedCopy
+#define BLTSPEC_COPY
+#include "fbbltspec.h"
+#undef BLTSPEC
+#undef BLTSPEC_COPY
+
+#define BLTSPEC fbBltAlignedInvarient
+#define BLTSPEC_INVARIENT
+#include "fbbltspec.h"
+#undef BLTSPEC
+#undef BLTSPEC_INVARIENT
+
+#define BLTSPEC fbBltAlignedGeneral
+#include "fbbltspec.h"
+#undef BLTSPEC
+
+#define BLTSPEC_SHIFTED
+
+#define BLTSPEC fbBltShiftedCopy
+#define BLTSPEC_COPY
+#include "fbbltspec.h"
+#undef BLTSPEC
+#undef BLTSPEC_COPY
+
+#define BLTSPEC fbBltShiftedInvarient
+#define BLTSPEC_INVARIENT
+#include "fbbltspec.h"
+#undef BLTSPEC
+#undef BLTSPEC_INVARIENT
+
+#define BLTSPEC fbBltShiftedGeneral
+#include "fbbltspec.h"
+#undef BLTSPEC
+
+#undef BLTSPEC_SHIFTED
+
 void
 fbBlt(FbBits * srcLine,
       FbStride srcStride,
@@ -90,6 +133,30 @@ fbBlt(FbBits * srcLine,
 
             return;
         }
+#ifndef FB_ACCESS_WRAPPER
+        /* Overlapping rows: memmove handles intra-row overlap, and the
+         * caller already picked a safe row order via upsidedown.  This
+         * keeps scrolls on the one-copy-per-row path instead of the
+         * shifted/masked general code.  Wrapped-access builds must go
+         * through READ/WRITE, so they still fall through.
+         */
+        else {
+            int i;
+
+            if (!upsidedown)
+                for (i = 0; i < height; i++)
+                    memmove(dst_byte + i * dst_byte_stride,
+                            src_byte + i * src_byte_stride,
+                            width_byte);
+            else
+                for (i = height - 1; i >= 0; i--)
+                    memmove(dst_byte + i * dst_byte_stride,
+                            src_byte + i * src_byte_stride,
+                            width_byte);
+
+            return;
+        }
+#endif
     }
 
     FbInitializeMergeRop(alu, pm);
@@ -114,80 +181,79 @@ fbBlt(FbBits * srcLine,
         srcX &= FB_MASK;
         dstX &= FB_MASK;
     }
+    if (!reverse) {
+        /* GXcopy through an all-ones planemask leaves the merge rop a
+         * plain copy; it is by far the most common blt and gets its
+         * own loops without the rop arithmetic.
+         */
+        Bool plainCopy = destInvarient && _ca2 == FB_ALLONES && _cx2 == 0;
+
+        if (srcX == dstX) {
+            if (plainCopy)
+                fbBltAlignedCopy(srcLine, srcStride, dstLine, dstStride,
+                                 height, nmiddle, startmask, endmask,
+                                 startbyte, endbyte, _ca1, _cx1, _ca2, _cx2);
+            else if (destInvarient)
+                fbBltAlignedInvarient(srcLine, srcStride, dstLine, dstStride,
+                                      height, nmiddle, startmask, endmask,
+                                      startbyte, endbyte,
+                                      _ca1, _cx1, _ca2, _cx2);
+            else
+                fbBltAlignedGeneral(srcLine, srcStride, dstLine, dstStride,
+                                    height, nmiddle, startmask, endmask,
+                                    startbyte, endbyte,
+                                    _ca1, _cx1, _ca2, _cx2);
+        }
+        else {
+            InitializeShifts(srcX, dstX, leftShift, rightShift);
+            if (plainCopy)
+                fbBltShiftedCopy(srcLine, srcStride, dstLine, dstStride,
+                                 height, nmiddle, startmask, endmask,
+                                 startbyte, endbyte,
+                                 leftShift, rightShift, srcX > dstX,
+                                 _ca1, _cx1, _ca2, _cx2);
+            else if (destInvarient)
+                fbBltShiftedInvarient(srcLine, srcStride, dstLine, dstStride,
+                                      height, nmiddle, startmask, endmask,
+                                      startbyte, endbyte,
+                                      leftShift, rightShift, srcX > dstX,
+                                      _ca1, _cx1, _ca2, _cx2);
+            else
+                fbBltShiftedGeneral(srcLine, srcStride, dstLine, dstStride,
+                                    height, nmiddle, startmask, endmask,
+                                    startbyte, endbyte,
+                                    leftShift, rightShift, srcX > dstX,
+                                    _ca1, _cx1, _ca2, _cx2);
+        }
+        return;
+    }
     if (srcX == dstX) {
         while (height--) {
             src = srcLine;
             srcLine += srcStride;
             dst = dstLine;
             dstLine += dstStride;
-            if (reverse) {
-                if (endmask) {
-                    bits = READ(--src);
-                    --dst;
-                    FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
-                }
-                n = nmiddle;
-                if (destInvarient) {
-                    while (n--)
-                        WRITE(--dst, FbDoDestInvarientMergeRop(READ(--src)));
-                }
-                else {
-                    while (n--) {
-                        bits = READ(--src);
-                        --dst;
-                        WRITE(dst, FbDoMergeRop(bits, READ(dst)));
-                    }
-                }
-                if (startmask) {
+            if (endmask) {
+                bits = READ(--src);
+                --dst;
+                FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
+            }
+            n = nmiddle;
+            if (destInvarient) {
+                while (n--)
+                    WRITE(--dst, FbDoDestInvarientMergeRop(READ(--src)));
+            }
+            else {
+                while (n--) {
                     bits = READ(--src);
                     --dst;
-                    FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
+                    WRITE(dst, FbDoMergeRop(bits, READ(dst)));
                 }
             }
-            else {
-                if (startmask) {
-                    bits = READ(src++);
-                    FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
-                    dst++;
-                }
-                n = nmiddle;
-                if (destInvarient) {
-#if 0
-                    /*
-                     * This provides some speedup on screen->screen blts
-                     * over the PCI bus, usually about 10%.  But fb
-                     * isn't usually used for this operation...
-                     */
-                    if (_ca2 + 1 == 0 && _cx2 == 0) {
-                        FbBits t1, t2, t3, t4;
-
-                        while (n >= 4) {
-                            t1 = *src++;
-                            t2 = *src++;
-                            t3 = *src++;
-                            t4 = *src++;
-                            *dst++ = t1;
-                            *dst++ = t2;
-                            *dst++ = t3;
-                            *dst++ = t4;
-                            n -= 4;
-                        }
-                    }
-#endif
-                    while (n--)
-                        WRITE(dst++, FbDoDestInvarientMergeRop(READ(src++)));
-                }
-                else {
-                    while (n--) {
-                        bits = READ(src++);
-                        WRITE(dst, FbDoMergeRop(bits, READ(dst)));
-                        dst++;
-                    }
-                }
-                if (endmask) {
-                    bits = READ(src);
-                    FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
-                }
+            if (startmask) {
+                bits = READ(--src);
+                --dst;
+                FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
             }
         }
     }
@@ -207,86 +273,44 @@ fbBlt(FbBits * srcLine,
             dstLine += dstStride;
 
             bits1 = 0;
-            if (reverse) {
-                if (srcX < dstX)
+            if (srcX < dstX)
+                bits1 = READ(--src);
+            if (endmask) {
+                bits = FbScrRight(bits1, rightShift);
+                if (FbScrRight(endmask, leftShift)) {
                     bits1 = READ(--src);
-                if (endmask) {
-                    bits = FbScrRight(bits1, rightShift);
-                    if (FbScrRight(endmask, leftShift)) {
-                        bits1 = READ(--src);
-                        bits |= FbScrLeft(bits1, leftShift);
-                    }
-                    --dst;
-                    FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
-                }
-                n = nmiddle;
-                if (destInvarient) {
-                    while (n--) {
-                        bits = FbScrRight(bits1, rightShift);
-                        bits1 = READ(--src);
-                        bits |= FbScrLeft(bits1, leftShift);
-                        --dst;
-                        WRITE(dst, FbDoDestInvarientMergeRop(bits));
-                    }
+                    bits |= FbScrLeft(bits1, leftShift);
                 }
-                else {
-                    while (n--) {
-                        bits = FbScrRight(bits1, rightShift);
-                        bits1 = READ(--src);
-                        bits |= FbScrLeft(bits1, leftShift);
-                        --dst;
-                        WRITE(dst, FbDoMergeRop(bits, READ(dst)));
-                    }
-                }
-                if (startmask) {
+                --dst;
+                FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
+            }
+            n = nmiddle;
+            if (destInvarient) {
+                while (n--) {
                     bits = FbScrRight(bits1, rightShift);
-                    if (FbScrRight(startmask, leftShift)) {
-                        bits1 = READ(--src);
-                        bits |= FbScrLeft(bits1, leftShift);
-                    }
+                    bits1 = READ(--src);
+                    bits |= FbScrLeft(bits1, leftShift);
                     --dst;
-                    FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
+                    WRITE(dst, FbDoDestInvarientMergeRop(bits));
                 }
             }
             else {
-                if (srcX > dstX)
-                    bits1 = READ(src++);
-                if (startmask) {
-                    bits = FbScrLeft(bits1, leftShift);
-                    if (FbScrLeft(startmask, rightShift)) {
-                        bits1 = READ(src++);
-                        bits |= FbScrRight(bits1, rightShift);
-                    }
-                    FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
-                    dst++;
-                }
-                n = nmiddle;
-                if (destInvarient) {
-                    while (n--) {
-                        bits = FbScrLeft(bits1, leftShift);
-                        bits1 = READ(src++);
-                        bits |= FbScrRight(bits1, rightShift);
-                        WRITE(dst, FbDoDestInvarientMergeRop(bits));
-                        dst++;
-                    }
-                }
-                else {
-                    while (n--) {
-                        bits = FbScrLeft(bits1, leftShift);
-                        bits1 = READ(src++);
-                        bits |= FbScrRight(bits1, rightShift);
-                        WRITE(dst, FbDoMergeRop(bits, READ(dst)));
-                        dst++;
-                    }
+                while (n--) {
+                    bits = FbScrRight(bits1, rightShift);
+                    bits1 = READ(--src);
+                    bits |= FbScrLeft(bits1, leftShift);
+                    --dst;
+                    WRITE(dst, FbDoMergeRop(bits, READ(dst)));
                 }
-                if (endmask) {
-                    bits = FbScrLeft(bits1, leftShift);
-                    if (FbScrLeft(endmask, rightShift)) {
-                        bits1 = READ(src);
-                        bits |= FbScrRight(bits1, rightShift);
-                    }
-                    FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
+            }
+            if (startmask) {
+                bits = FbScrRight(bits1, rightShift);
+                if (FbScrRight(startmask, leftShift)) {
+                    bits1 = READ(--src);
+                    bits |= FbScrLeft(bits1, leftShift);
                 }
+                --dst;
+                FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
             }
         }
     }
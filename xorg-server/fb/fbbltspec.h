@@ -0,0 +1,141 @@
+/*
+ * Copyright © 1998 Keith Packard
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Keith Packard not be used in
+ * advertising or publicity pertaining to distribution of the software without
+ * specific, written prior permission.  Keith Packard makes no
+ * representations about the suitability of this software for any purpose.  It
+ * is provided "as is" without express or implied warranty.
+ *
+ * KEITH PACKARD DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN NO
+ * EVENT SHALL KEITH PACKARD BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE,
+ * DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER
+ * TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * This file generates one specialized forward blt row loop per
+ * inclusion, in the manner of fbbits.h.  fbBlt picks a variant once
+ * per call, so the middle loop carries no raster-op or alignment
+ * tests per word.
+ *
+ * Define the following before including this file:
+ *
+ *  BLTSPEC		name of the generated function
+ *  BLTSPEC_SHIFTED	if source and dest have different word alignment
+ *  BLTSPEC_COPY	if the merge rop reduces to a plain copy
+ *  BLTSPEC_INVARIENT	if the merge rop does not read the destination
+ *
+ * (BLTSPEC_COPY implies dest-invariance; with neither defined the
+ * general read-modify-write rop is generated.)
+ */
+
+static void
+BLTSPEC(FbBits * srcLine,
+        FbStride srcStride,
+        FbBits * dstLine,
+        FbStride dstStride,
+        int height,
+        int nmiddle,
+        FbBits startmask, FbBits endmask,
+        int startbyte, int endbyte,
+#ifdef BLTSPEC_SHIFTED
+        int leftShift, int rightShift, Bool preRead,
+#endif
+        FbBits _ca1, FbBits _cx1, FbBits _ca2, FbBits _cx2)
+{
+    FbBits *src, *dst;
+    FbBits bits;
+    int n;
+
+#ifdef BLTSPEC_SHIFTED
+    FbBits bits1;
+#endif
+
+    while (height--) {
+        src = srcLine;
+        srcLine += srcStride;
+        dst = dstLine;
+        dstLine += dstStride;
+
+#ifndef BLTSPEC_SHIFTED
+        if (startmask) {
+            bits = READ(src++);
+            FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
+            dst++;
+        }
+        n = nmiddle;
+#if defined(BLTSPEC_COPY)
+        while (n--)
+            WRITE(dst++, READ(src++));
+#elif defined(BLTSPEC_INVARIENT)
+        while (n--)
+            WRITE(dst++, FbDoDestInvarientMergeRop(READ(src++)));
+#else
+        while (n--) {
+            bits = READ(src++);
+            WRITE(dst, FbDoMergeRop(bits, READ(dst)));
+            dst++;
+        }
+#endif
+        if (endmask) {
+            bits = READ(src);
+            FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
+        }
+#else                           /* BLTSPEC_SHIFTED */
+        bits1 = 0;
+        if (preRead)
+            bits1 = READ(src++);
+        if (startmask) {
+            bits = FbScrLeft(bits1, leftShift);
+            if (FbScrLeft(startmask, rightShift)) {
+                bits1 = READ(src++);
+                bits |= FbScrRight(bits1, rightShift);
+            }
+            FbDoLeftMaskByteMergeRop(dst, bits, startbyte, startmask);
+            dst++;
+        }
+        n = nmiddle;
+#if defined(BLTSPEC_COPY)
+        while (n--) {
+            bits = FbScrLeft(bits1, leftShift);
+            bits1 = READ(src++);
+            bits |= FbScrRight(bits1, rightShift);
+            WRITE(dst, bits);
+            dst++;
+        }
+#elif defined(BLTSPEC_INVARIENT)
+        while (n--) {
+            bits = FbScrLeft(bits1, leftShift);
+            bits1 = READ(src++);
+            bits |= FbScrRight(bits1, rightShift);
+            WRITE(dst, FbDoDestInvarientMergeRop(bits));
+            dst++;
+        }
+#else
+        while (n--) {
+            bits = FbScrLeft(bits1, leftShift);
+            bits1 = READ(src++);
+            bits |= FbScrRight(bits1, rightShift);
+            WRITE(dst, FbDoMergeRop(bits, READ(dst)));
+            dst++;
+        }
+#endif
+        if (endmask) {
+            bits = FbScrLeft(bits1, leftShift);
+            if (FbScrLeft(endmask, rightShift)) {
+                bits1 = READ(src);
+                bits |= FbScrRight(bits1, rightShift);
+            }
+            FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
+        }
+#endif                          /* BLTSPEC_SHIFTED */
+    }
+}
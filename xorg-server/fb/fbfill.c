@@ -108,8 +108,15 @@ fbStipple(FbBits * dst, FbStride dstStride,
     }
 }
 
-void
-fbFill(DrawablePtr pDrawable, GCPtr pGC, int x, int y, int width, int height)
+/*
+ * Per-fillStyle bodies of fbFill, selected once at ValidateGC time by
+ * fbUpdateGCFill so the span and rectangle loops dispatch through
+ * FbGCPrivRec.fill instead of re-testing the fill style per call.
+ */
+
+static void
+fbFillSolid(DrawablePtr pDrawable, GCPtr pGC, int x, int y,
+            int width, int height)
 {
     FbBits *dst;
     FbStride dstStride;
@@ -119,107 +126,158 @@ fbFill(DrawablePtr pDrawable, GCPtr pGC, int x, int y, int width, int height)
 
     fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
 
-    switch (pGC->fillStyle) {
-    case FillSolid:
 #ifndef FB_ACCESS_WRAPPER
-        if (pPriv->and || !pixman_fill((uint32_t *) dst, dstStride, dstBpp,
-                                       x + dstXoff, y + dstYoff,
-                                       width, height, pPriv->xor))
+    if (pPriv->and || !pixman_fill((uint32_t *) dst, dstStride, dstBpp,
+                                   x + dstXoff, y + dstYoff,
+                                   width, height, pPriv->xor))
 #endif
-            fbSolid(dst + (y + dstYoff) * dstStride,
-                    dstStride,
-                    (x + dstXoff) * dstBpp,
-                    dstBpp, width * dstBpp, height, pPriv->and, pPriv->xor);
-        break;
-    case FillStippled:
-    case FillOpaqueStippled:{
-        PixmapPtr pStip = pGC->stipple;
-        int stipWidth = pStip->drawable.width;
-        int stipHeight = pStip->drawable.height;
-
-        if (dstBpp == 1) {
-            int alu;
-            FbBits *stip;
-            FbStride stipStride;
-            int stipBpp;
-            _X_UNUSED int stipXoff, stipYoff;
-
-            if (pGC->fillStyle == FillStippled)
-                alu = FbStipple1Rop(pGC->alu, pGC->fgPixel);
-            else
-                alu = FbOpaqueStipple1Rop(pGC->alu, pGC->fgPixel, pGC->bgPixel);
-            fbGetDrawable(&pStip->drawable, stip, stipStride, stipBpp, stipXoff,
-                          stipYoff);
-            fbTile(dst + (y + dstYoff) * dstStride, dstStride, x + dstXoff,
-                   width, height, stip, stipStride, stipWidth, stipHeight, alu,
-                   pPriv->pm, dstBpp, (pGC->patOrg.x + pDrawable->x + dstXoff),
-                   pGC->patOrg.y + pDrawable->y - y);
-            fbFinishAccess(&pStip->drawable);
+        fbSolid(dst + (y + dstYoff) * dstStride,
+                dstStride,
+                (x + dstXoff) * dstBpp,
+                dstBpp, width * dstBpp, height, pPriv->and, pPriv->xor);
+    fbValidateDrawable(pDrawable);
+    fbFinishAccess(pDrawable);
+}
+
+static void
+fbFillStippled(DrawablePtr pDrawable, GCPtr pGC, int x, int y,
+               int width, int height)
+{
+    FbBits *dst;
+    FbStride dstStride;
+    int dstBpp;
+    int dstXoff, dstYoff;
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
+    PixmapPtr pStip = pGC->stipple;
+    int stipWidth = pStip->drawable.width;
+    int stipHeight = pStip->drawable.height;
+
+    fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
+
+    if (dstBpp == 1) {
+        int alu;
+        FbBits *stip;
+        FbStride stipStride;
+        int stipBpp;
+        _X_UNUSED int stipXoff, stipYoff;
+
+        if (pGC->fillStyle == FillStippled)
+            alu = FbStipple1Rop(pGC->alu, pGC->fgPixel);
+        else
+            alu = FbOpaqueStipple1Rop(pGC->alu, pGC->fgPixel, pGC->bgPixel);
+        fbGetDrawable(&pStip->drawable, stip, stipStride, stipBpp, stipXoff,
+                      stipYoff);
+        fbTile(dst + (y + dstYoff) * dstStride, dstStride, x + dstXoff,
+               width, height, stip, stipStride, stipWidth, stipHeight, alu,
+               pPriv->pm, dstBpp, (pGC->patOrg.x + pDrawable->x + dstXoff),
+               pGC->patOrg.y + pDrawable->y - y);
+        fbFinishAccess(&pStip->drawable);
+    }
+    else {
+        FbStip *stip;
+        FbStride stipStride;
+        int stipBpp;
+        _X_UNUSED int stipXoff, stipYoff;
+        FbBits fgand, fgxor, bgand, bgxor;
+
+        fgand = pPriv->and;
+        fgxor = pPriv->xor;
+        if (pGC->fillStyle == FillStippled) {
+            bgand = fbAnd(GXnoop, (FbBits) 0, FB_ALLONES);
+            bgxor = fbXor(GXnoop, (FbBits) 0, FB_ALLONES);
         }
         else {
-            FbStip *stip;
-            FbStride stipStride;
-            int stipBpp;
-            _X_UNUSED int stipXoff, stipYoff;
-            FbBits fgand, fgxor, bgand, bgxor;
-
-            fgand = pPriv->and;
-            fgxor = pPriv->xor;
-            if (pGC->fillStyle == FillStippled) {
-                bgand = fbAnd(GXnoop, (FbBits) 0, FB_ALLONES);
-                bgxor = fbXor(GXnoop, (FbBits) 0, FB_ALLONES);
-            }
-            else {
-                bgand = pPriv->bgand;
-                bgxor = pPriv->bgxor;
-            }
-
-            fbGetStipDrawable(&pStip->drawable, stip, stipStride, stipBpp,
-                              stipXoff, stipYoff);
-            fbStipple(dst + (y + dstYoff) * dstStride, dstStride,
-                      (x + dstXoff) * dstBpp, dstBpp, width * dstBpp, height,
-                      stip, stipStride, stipWidth, stipHeight,
-                      fgand, fgxor, bgand, bgxor,
-                      pGC->patOrg.x + pDrawable->x + dstXoff,
-                      pGC->patOrg.y + pDrawable->y - y);
-            fbFinishAccess(&pStip->drawable);
+            bgand = pPriv->bgand;
+            bgxor = pPriv->bgxor;
         }
-        break;
-    }
-    case FillTiled:{
-        PixmapPtr pTile = pGC->tile.pixmap;
-        FbBits *tile;
-        FbStride tileStride;
-        int tileBpp;
-        int tileWidth;
-        int tileHeight;
-        _X_UNUSED int tileXoff, tileYoff;
-
-        fbGetDrawable(&pTile->drawable, tile, tileStride, tileBpp, tileXoff,
-                      tileYoff);
-        tileWidth = pTile->drawable.width;
-        tileHeight = pTile->drawable.height;
-        fbTile(dst + (y + dstYoff) * dstStride,
-               dstStride,
-               (x + dstXoff) * dstBpp,
-               width * dstBpp, height,
-               tile,
-               tileStride,
-               tileWidth * tileBpp,
-               tileHeight,
-               pGC->alu,
-               pPriv->pm,
-               dstBpp,
-               (pGC->patOrg.x + pDrawable->x + dstXoff) * dstBpp,
-               pGC->patOrg.y + pDrawable->y - y);
-        fbFinishAccess(&pTile->drawable);
-        break;
-    }
+
+        fbGetStipDrawable(&pStip->drawable, stip, stipStride, stipBpp,
+                          stipXoff, stipYoff);
+        fbStipple(dst + (y + dstYoff) * dstStride, dstStride,
+                  (x + dstXoff) * dstBpp, dstBpp, width * dstBpp, height,
+                  stip, stipStride, stipWidth, stipHeight,
+                  fgand, fgxor, bgand, bgxor,
+                  pGC->patOrg.x + pDrawable->x + dstXoff,
+                  pGC->patOrg.y + pDrawable->y - y);
+        fbFinishAccess(&pStip->drawable);
     }
     fbValidateDrawable(pDrawable);
     fbFinishAccess(pDrawable);
 }
 
+static void
+fbFillTiled(DrawablePtr pDrawable, GCPtr pGC, int x, int y,
+            int width, int height)
+{
+    FbBits *dst;
+    FbStride dstStride;
+    int dstBpp;
+    int dstXoff, dstYoff;
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
+    PixmapPtr pTile = pGC->tile.pixmap;
+    FbBits *tile;
+    FbStride tileStride;
+    int tileBpp;
+    int tileWidth;
+    int tileHeight;
+    _X_UNUSED int tileXoff, tileYoff;
+
+    fbGetDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
+
+    fbGetDrawable(&pTile->drawable, tile, tileStride, tileBpp, tileXoff,
+                  tileYoff);
+    tileWidth = pTile->drawable.width;
+    tileHeight = pTile->drawable.height;
+    fbTile(dst + (y + dstYoff) * dstStride,
+           dstStride,
+           (x + dstXoff) * dstBpp,
+           width * dstBpp, height,
+           tile,
+           tileStride,
+           tileWidth * tileBpp,
+           tileHeight,
+           pGC->alu,
+           pPriv->pm,
+           dstBpp,
+           (pGC->patOrg.x + pDrawable->x + dstXoff) * dstBpp,
+           pGC->patOrg.y + pDrawable->y - y);
+    fbFinishAccess(&pTile->drawable);
+    fbValidateDrawable(pDrawable);
+    fbFinishAccess(pDrawable);
+}
+
+/*
+ * Select the fill body matching pGC->fillStyle; called from fbCreateGC
+ * and whenever ValidateGC sees GCFillStyle change
+ */
+void
+fbUpdateGCFill(GCPtr pGC)
+{
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
+
+    switch (pGC->fillStyle) {
+    case FillStippled:
+    case FillOpaqueStippled:
+        pPriv->fill = fbFillStippled;
+        break;
+    case FillTiled:
+        pPriv->fill = fbFillTiled;
+        break;
+    case FillSolid:
+    default:
+        pPriv->fill = fbFillSolid;
+        break;
+    }
+}
+
+void
+fbFill(DrawablePtr pDrawable, GCPtr pGC, int x, int y, int width, int height)
+{
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
+
+    (*pPriv->fill) (pDrawable, pGC, x, y, width, height);
+}
+
 void
 fbSolidBoxClipped(DrawablePtr pDrawable,
                   RegionPtr pClip,
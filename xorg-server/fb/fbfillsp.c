@@ -31,6 +31,7 @@ fbFillSpans(DrawablePtr pDrawable,
             GCPtr pGC, int n, DDXPointPtr ppt, int *pwidth, int fSorted)
 {
     RegionPtr pClip = fbGetCompositeClip(pGC);
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
     BoxPtr pextent, pbox;
     int nbox;
     int extentX1, extentX2, extentY1, extentY2;
@@ -49,6 +50,21 @@ fbFillSpans(DrawablePtr pDrawable,
         ppt++;
         pwidth++;
 
+        /*
+         * Merge exactly abutting spans on the same scanline into one wide
+         * fill; scan converters hand us runs of short spans in x order.
+         * Overlapping spans must stay separate so non-copy raster ops
+         * (GXxor and friends) still apply once per span.
+         */
+        if (fSorted) {
+            while (n && ppt->y == fullY1 && ppt->x == fullX2) {
+                fullX2 += (int) *pwidth;
+                ppt++;
+                pwidth++;
+                n--;
+            }
+        }
+
         if (fullY1 < extentY1 || extentY2 <= fullY1)
             continue;
 
@@ -63,7 +79,8 @@ fbFillSpans(DrawablePtr pDrawable,
 
         nbox = RegionNumRects(pClip);
         if (nbox == 1) {
-            fbFill(pDrawable, pGC, fullX1, fullY1, fullX2 - fullX1, 1);
+            (*pPriv->fill) (pDrawable, pGC, fullX1, fullY1,
+                            fullX2 - fullX1, 1);
         }
         else {
             pbox = RegionRects(pClip);
@@ -76,8 +93,8 @@ fbFillSpans(DrawablePtr pDrawable,
                     if (partX2 > fullX2)
                         partX2 = fullX2;
                     if (partX2 > partX1) {
-                        fbFill(pDrawable, pGC,
-                               partX1, fullY1, partX2 - partX1, 1);
+                        (*pPriv->fill) (pDrawable, pGC,
+                                        partX1, fullY1, partX2 - partX1, 1);
                     }
                 }
                 pbox++;
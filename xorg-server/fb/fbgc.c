@@ -32,7 +32,7 @@ const GCFuncs fbGCFuncs = {
     fbValidateGC,
     miChangeGC,
     miCopyGC,
-    miDestroyGC,
+    fbDestroyGC,
     miChangeClip,
     miDestroyClip,
     miCopyClip,
@@ -71,6 +71,8 @@ fbCreateGC(GCPtr pGC)
     pGC->miTranslate = 1;
     pGC->fExpose = 1;
 
+    fbUpdateGCFill(pGC);
+
     return TRUE;
 }
 
@@ -109,6 +111,114 @@ fbPadPixmap(PixmapPtr pPixmap)
     fbFinishAccess(&pPixmap->drawable);
 }
 
+/*
+ * Composite clip memoization
+ *
+ * A GC bouncing between two drawables (draw into a pixmap, copy to the
+ * window, repeat) fails the serial check on every operation and used to
+ * redo the composite clip merge each time even though nothing changed.
+ * When the merge actually costs something -- a client clip to intersect
+ * or IncludeInferiors -- the result is kept in a small per-GC memo
+ * keyed on the drawable and its serial, and revalidation against a
+ * remembered drawable just points the GC back at the saved region.
+ * The trivial cases (whole pixmap, or borrowing the window clip list)
+ * stay on the direct path since they are already cheaper than a memo.
+ */
+
+static Bool
+fbClipMemoizable(GCPtr pGC, DrawablePtr pDrawable)
+{
+    if (pGC->clientClip)
+        return TRUE;
+    return (pDrawable->type == DRAWABLE_WINDOW) &&
+        (pGC->subWindowMode == IncludeInferiors);
+}
+
+/*
+ * Drop all memo slots; called when clip-affecting GC state changes so
+ * every remembered region is stale.  If the GC still points at a memoed
+ * region, ownership moves back to the GC instead of freeing it.
+ */
+static void
+fbFlushClipMemo(GCPtr pGC, FbGCPrivPtr pPriv)
+{
+    int i;
+
+    for (i = 0; i < FB_CLIP_MEMO_SIZE; i++) {
+        if (pPriv->clipMemo[i].region) {
+            if (pGC->pCompositeClip == pPriv->clipMemo[i].region)
+                pGC->freeCompClip = TRUE;
+            else
+                RegionDestroy(pPriv->clipMemo[i].region);
+            pPriv->clipMemo[i].region = NULL;
+        }
+    }
+}
+
+static Bool
+fbLookupClipMemo(GCPtr pGC, FbGCPrivPtr pPriv, DrawablePtr pDrawable)
+{
+    int i;
+
+    if (!fbClipMemoizable(pGC, pDrawable))
+        return FALSE;
+
+    for (i = 0; i < FB_CLIP_MEMO_SIZE; i++) {
+        if (pPriv->clipMemo[i].region &&
+            pPriv->clipMemo[i].drawable == pDrawable->id &&
+            pPriv->clipMemo[i].serial == pDrawable->serialNumber) {
+            /* Serials are allocated from a global counter, so a matching
+               (drawable, serial) pair means neither the drawable nor its
+               clip changed since the region was computed */
+            if (pGC->freeCompClip)
+                RegionDestroy(pGC->pCompositeClip);
+            pGC->pCompositeClip = pPriv->clipMemo[i].region;
+            pGC->freeCompClip = FALSE;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void
+fbStoreClipMemo(GCPtr pGC, FbGCPrivPtr pPriv, DrawablePtr pDrawable)
+{
+    int i;
+
+    /* Only worth remembering if the merge produced a region the GC
+       owns; a borrowed window clip list is already free to revalidate */
+    if (!pGC->freeCompClip || !fbClipMemoizable(pGC, pDrawable))
+        return;
+
+    /* Replace a stale entry for the same drawable, else round-robin */
+    for (i = 0; i < FB_CLIP_MEMO_SIZE; i++)
+        if (pPriv->clipMemo[i].region &&
+            pPriv->clipMemo[i].drawable == pDrawable->id)
+            break;
+    if (i == FB_CLIP_MEMO_SIZE) {
+        i = pPriv->clipMemoNext;
+        pPriv->clipMemoNext = (i + 1) % FB_CLIP_MEMO_SIZE;
+    }
+
+    if (pPriv->clipMemo[i].region)
+        RegionDestroy(pPriv->clipMemo[i].region);
+
+    /* The memo takes ownership of the region, no copy needed */
+    pPriv->clipMemo[i].region = pGC->pCompositeClip;
+    pPriv->clipMemo[i].drawable = pDrawable->id;
+    pPriv->clipMemo[i].serial = pDrawable->serialNumber;
+    pGC->freeCompClip = FALSE;
+}
+
+void
+fbDestroyGC(GCPtr pGC)
+{
+    FbGCPrivPtr pPriv = fbGetGCPrivate(pGC);
+
+    fbFlushClipMemo(pGC, pPriv);
+    miDestroyGC(pGC);
+}
+
 void
 fbValidateGC(GCPtr pGC, unsigned long changes, DrawablePtr pDrawable)
 {
@@ -121,11 +231,19 @@ fbValidateGC(GCPtr pGC, unsigned long changes, DrawablePtr pDrawable)
      * we need to recompute the composite clip
      */
 
-    if ((changes &
-         (GCClipXOrigin | GCClipYOrigin | GCClipMask | GCSubwindowMode)) ||
-        (pDrawable->serialNumber != (pGC->serialNumber & DRAWABLE_SERIAL_BITS))
-        ) {
+    if (changes &
+        (GCClipXOrigin | GCClipYOrigin | GCClipMask | GCSubwindowMode)) {
+        /* Clip-affecting state changed, every memoed region is stale */
+        fbFlushClipMemo(pGC, pPriv);
         miComputeCompositeClip(pGC, pDrawable);
+        fbStoreClipMemo(pGC, pPriv, pDrawable);
+    }
+    else if (pDrawable->serialNumber !=
+             (pGC->serialNumber & DRAWABLE_SERIAL_BITS)) {
+        if (!fbLookupClipMemo(pGC, pPriv, pDrawable)) {
+            miComputeCompositeClip(pGC, pDrawable);
+            fbStoreClipMemo(pGC, pPriv, pDrawable);
+        }
     }
 
     if (changes & GCTile) {
@@ -171,6 +289,8 @@ fbValidateGC(GCPtr pGC, unsigned long changes, DrawablePtr pDrawable)
         pPriv->bgand = fbAnd(pGC->alu, pPriv->bg, pPriv->pm);
         pPriv->bgxor = fbXor(pGC->alu, pPriv->bg, pPriv->pm);
     }
+    if (changes & GCFillStyle)
+        fbUpdateGCFill(pGC);
     if (changes & GCDashList) {
         unsigned short n = pGC->numInDashList;
         unsigned char *dash = pGC->dash;
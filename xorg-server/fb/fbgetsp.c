@@ -24,6 +24,7 @@
 #include <dix-config.h>
 #endif
 
+#include <string.h>
 #include "fb.h"
 
 void
@@ -46,6 +47,31 @@ fbGetSpans(DrawablePtr pDrawable,
 
     fbGetDrawable(pDrawable, src, srcStride, srcBpp, srcXoff, srcYoff);
 
+    /*
+     * Spans always read whole pixels with GXcopy and a full plane
+     * mask, so when pixels are an integral number of bytes each row
+     * is a straight memcpy; only sub-byte depths need the
+     * word-aligning blitter below
+     */
+    if (!(srcBpp & 7)) {
+        int srcBytesPerPixel = srcBpp >> 3;
+        CARD8 *srcBase = (CARD8 *) src;
+        FbStride srcByteStride = srcStride * sizeof(FbBits);
+
+        while (nspans--) {
+            memcpy(pchardstStart,
+                   srcBase + (ppt->y + srcYoff) * srcByteStride +
+                   (ppt->x + srcXoff) * srcBytesPerPixel,
+                   *pwidth * srcBytesPerPixel);
+            pchardstStart += PixmapBytePad(*pwidth, pDrawable->depth);
+            ppt++;
+            pwidth++;
+        }
+
+        fbFinishAccess(pDrawable);
+        return;
+    }
+
     while (nspans--) {
         xoff = (int) (((long)(uintptr_t) pchardstStart) & (FB_MASK >> 3));
         dst = (FbBits *) (pchardstStart - xoff);
@@ -28,6 +28,144 @@
 
 #include "fb.h"
 
+#ifndef FB_ACCESS_WRAPPER
+#include <pthread.h>
+
+/*
+ * Band-parallel ZPixmap stores.  A large PutImage is split into
+ * horizontal bands handed to a small worker pool; rows never share
+ * framebuffer words, so the bands can be blitted concurrently with any
+ * alu and planemask.  The pool is created on first use and the calling
+ * thread works alongside it, blocking until every band is done, so the
+ * rest of the server never observes a partially written image.  Not
+ * compiled for wfb, whose access wrappers are not thread-safe.
+ */
+
+#define FB_PUTIMAGE_THREADS	4
+#define FB_PUTIMAGE_THRESHOLD	(1024 * 1024)   /* pixels */
+
+typedef struct _FbPutZImageBand {
+    FbStip *src;
+    FbStride srcStride;
+    int srcX;
+    FbStip *dst;
+    FbStride dstStride;
+    int dstX;
+    int width;
+    int height;
+    int alu;
+    FbBits pm;
+    int bpp;
+} FbPutZImageBandRec, *FbPutZImageBandPtr;
+
+static pthread_mutex_t fbPutImageLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fbPutImageWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t fbPutImageDone = PTHREAD_COND_INITIALIZER;
+static FbPutZImageBandRec fbPutImageBands[FB_PUTIMAGE_THREADS];
+static int fbPutImagePending;   /* bands not yet picked up */
+static int fbPutImageActive;    /* bands being blitted */
+static int fbPutImageThreads;   /* workers created so far */
+
+static void
+fbPutZImageBand(FbPutZImageBandPtr band)
+{
+    fbBltStip(band->src, band->srcStride, band->srcX,
+              band->dst, band->dstStride, band->dstX,
+              band->width, band->height, band->alu, band->pm, band->bpp);
+}
+
+static void *
+fbPutImageWorker(void *arg)
+{
+    pthread_mutex_lock(&fbPutImageLock);
+    while (1) {
+        FbPutZImageBandRec band;
+
+        while (!fbPutImagePending)
+            pthread_cond_wait(&fbPutImageWake, &fbPutImageLock);
+        band = fbPutImageBands[--fbPutImagePending];
+        fbPutImageActive++;
+        pthread_mutex_unlock(&fbPutImageLock);
+
+        fbPutZImageBand(&band);
+
+        pthread_mutex_lock(&fbPutImageLock);
+        if (--fbPutImageActive == 0 && fbPutImagePending == 0)
+            pthread_cond_signal(&fbPutImageDone);
+    }
+    return NULL;
+}
+
+/*
+ * Blit one clipped rectangle of a ZPixmap image using the worker pool.
+ * Returns FALSE if the rectangle is too small to be worth the fan-out
+ * or if no workers could be created, in which case the caller blits it
+ * in place.
+ */
+static Bool
+fbPutZImageParallel(FbStip * src, FbStride srcStride, int srcX,
+                    FbStip * dst, FbStride dstStride, int dstX,
+                    int width, int height, int alu, FbBits pm, int bpp)
+{
+    int nbands, band, y, bandHeight;
+
+    if ((long) (width / bpp) * height < FB_PUTIMAGE_THRESHOLD ||
+        height < FB_PUTIMAGE_THREADS)
+        return FALSE;
+
+    pthread_mutex_lock(&fbPutImageLock);
+
+    while (fbPutImageThreads < FB_PUTIMAGE_THREADS - 1) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, fbPutImageWorker, NULL) != 0)
+            break;
+        fbPutImageThreads++;
+    }
+    if (!fbPutImageThreads) {
+        pthread_mutex_unlock(&fbPutImageLock);
+        return FALSE;
+    }
+
+    nbands = fbPutImageThreads + 1;
+    bandHeight = height / nbands;
+    y = 0;
+    for (band = 0; band < nbands; band++) {
+        FbPutZImageBandPtr b = &fbPutImageBands[band];
+        int h = (band == nbands - 1) ? height - y : bandHeight;
+
+        b->src = src + (FbStride) y * srcStride;
+        b->srcStride = srcStride;
+        b->srcX = srcX;
+        b->dst = dst + (FbStride) y * dstStride;
+        b->dstStride = dstStride;
+        b->dstX = dstX;
+        b->width = width;
+        b->height = h;
+        b->alu = alu;
+        b->pm = pm;
+        b->bpp = bpp;
+        y += h;
+    }
+    fbPutImagePending = nbands;
+    pthread_cond_broadcast(&fbPutImageWake);
+
+    /* work alongside the pool rather than just waiting */
+    while (fbPutImagePending) {
+        FbPutZImageBandRec myBand = fbPutImageBands[--fbPutImagePending];
+
+        pthread_mutex_unlock(&fbPutImageLock);
+        fbPutZImageBand(&myBand);
+        pthread_mutex_lock(&fbPutImageLock);
+    }
+    while (fbPutImageActive)
+        pthread_cond_wait(&fbPutImageDone, &fbPutImageLock);
+    pthread_mutex_unlock(&fbPutImageLock);
+
+    return TRUE;
+}
+#endif                          /* !FB_ACCESS_WRAPPER */
+
 void
 fbPutImage(DrawablePtr pDrawable,
            GCPtr pGC,
@@ -108,6 +246,17 @@ fbPutZImage(DrawablePtr pDrawable,
             y2 = pbox->y2;
         if (x1 >= x2 || y1 >= y2)
             continue;
+#ifndef FB_ACCESS_WRAPPER
+        if (fbPutZImageParallel(src + (y1 - y) * srcStride,
+                                srcStride,
+                                (x1 - x) * dstBpp,
+                                dst + (y1 + dstYoff) * dstStride,
+                                dstStride,
+                                (x1 + dstXoff) * dstBpp,
+                                (x2 - x1) * dstBpp, (y2 - y1),
+                                alu, pm, dstBpp))
+            continue;
+#endif
         fbBltStip(src + (y1 - y) * srcStride,
                   srcStride,
                   (x1 - x) * dstBpp,
@@ -35,6 +35,294 @@
 #include "mipict.h"
 #include "fbpict.h"
 
+/*
+ * Gradient sources are evaluated per-pixel by pixman's gradient
+ * walkers on every composite.  Clients which paint the same gradient
+ * every frame (panels, plot backgrounds) pay that cost over and over
+ * for identical results, so keep the most recently sampled window of
+ * each gradient picture rasterized in an a8r8g8b8 buffer hung off the
+ * picture.  As long as the sampled rectangle and the picture
+ * parameters the rendering depended on are unchanged, later
+ * composites read the buffer like an ordinary bits image and the
+ * gradient fill becomes a plain blit.  Gradient stops cannot change
+ * after CreateGradient, so comparing the remaining parameters is a
+ * complete validity check.
+ */
+
+#define FB_GRADIENT_CACHE_MAX_PIXELS	(1024 * 1024)
+
+typedef struct {
+    uint32_t *bits;             /* width * height a8r8g8b8 pixels */
+    int x, y;                   /* sampled origin in source space */
+    int width, height;
+    unsigned int repeatType;
+    unsigned int filter;
+    Bool hasTransform;
+    PictTransform transform;
+} FbGradientCacheRec, *FbGradientCachePtr;
+
+static DevPrivateKeyRec fbGradientCacheKeyRec;
+
+#define fbGetGradientCache(pPicture) ((FbGradientCachePtr) \
+    dixLookupPrivate(&(pPicture)->devPrivates, &fbGradientCacheKeyRec))
+
+static void
+fbDestroyPicture(PicturePtr pPicture)
+{
+    FbGradientCachePtr cache = fbGetGradientCache(pPicture);
+
+    free(cache->bits);
+    cache->bits = NULL;
+
+    miDestroyPicture(pPicture);
+}
+
+/*
+ * Return a bits image holding the rasterized window [x, x + width) x
+ * [y, y + height) of a gradient picture, rendering it first if the
+ * cache is empty or stale.  Returns NULL if the picture is not a
+ * cachable gradient; the caller then goes through image_from_pict as
+ * usual.
+ */
+static pixman_image_t *
+fbGradientCacheImage(PicturePtr pict, int x, int y, int width, int height)
+{
+    FbGradientCachePtr cache;
+    Bool hasTransform;
+
+    if (!pict->pSourcePict ||
+        pict->pSourcePict->type == SourcePictTypeSolidFill)
+        return NULL;
+
+    if (pict->alphaMap || pict->componentAlpha)
+        return NULL;
+
+    /* Convolution parameters are not part of the cache key */
+    if (pict->filter == PictFilterConvolution)
+        return NULL;
+
+    if (width <= 0 || height <= 0 ||
+        (long) width * height > FB_GRADIENT_CACHE_MAX_PIXELS)
+        return NULL;
+
+    cache = fbGetGradientCache(pict);
+    hasTransform = pict->transform != NULL;
+
+    if (cache->bits == NULL ||
+        cache->x != x || cache->y != y ||
+        cache->width != width || cache->height != height ||
+        cache->repeatType != pict->repeatType ||
+        cache->filter != pict->filter ||
+        cache->hasTransform != hasTransform ||
+        (hasTransform &&
+         memcmp(&cache->transform, pict->transform,
+                sizeof(PictTransform)) != 0)) {
+        pixman_image_t *gradient, *tmp;
+        int xoff, yoff;
+
+        if (cache->bits == NULL ||
+            cache->width != width || cache->height != height) {
+            free(cache->bits);
+            cache->bits = malloc((size_t) width * height * 4);
+            if (!cache->bits)
+                return NULL;
+        }
+
+        gradient = image_from_pict(pict, FALSE, &xoff, &yoff);
+        if (!gradient) {
+            free(cache->bits);
+            cache->bits = NULL;
+            return NULL;
+        }
+
+        tmp = pixman_image_create_bits(PIXMAN_a8r8g8b8, width, height,
+                                       cache->bits, width * 4);
+        if (!tmp) {
+            pixman_image_unref(gradient);
+            free(cache->bits);
+            cache->bits = NULL;
+            return NULL;
+        }
+
+        pixman_image_composite(PIXMAN_OP_SRC, gradient, NULL, tmp,
+                               x + xoff, y + yoff, 0, 0, 0, 0, width, height);
+
+        pixman_image_unref(tmp);
+        pixman_image_unref(gradient);
+
+        cache->x = x;
+        cache->y = y;
+        cache->width = width;
+        cache->height = height;
+        cache->repeatType = pict->repeatType;
+        cache->filter = pict->filter;
+        cache->hasTransform = hasTransform;
+        if (hasTransform)
+            cache->transform = *pict->transform;
+    }
+
+    return pixman_image_create_bits(PIXMAN_a8r8g8b8, cache->width,
+                                    cache->height, cache->bits,
+                                    cache->width * 4);
+}
+
+#ifndef FB_ACCESS_WRAPPER
+#include <pthread.h>
+
+/*
+ * Band-parallel composites, along the lines of the PutImage pool in
+ * fbimage.c.  A large composite is split into horizontal destination
+ * bands which are independent pointwise operations, so they can run
+ * concurrently on a pool of workers while the calling thread works
+ * alongside them and blocks until every band is done.  Not compiled
+ * for wfb, whose access wrappers are not thread-safe.
+ */
+
+#define FB_COMPOSITE_THREADS	4
+#define FB_COMPOSITE_THRESHOLD	(512 * 512)     /* pixels */
+
+typedef struct _FbCompositeBand {
+    CARD8 op;
+    pixman_image_t *src;
+    pixman_image_t *mask;
+    pixman_image_t *dest;
+    int src_x, src_y;
+    int mask_x, mask_y;
+    int dest_x, dest_y;
+    int width, height;
+} FbCompositeBandRec, *FbCompositeBandPtr;
+
+static pthread_mutex_t fbCompositeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fbCompositeWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t fbCompositeDone = PTHREAD_COND_INITIALIZER;
+static FbCompositeBandRec fbCompositeBands[FB_COMPOSITE_THREADS];
+static int fbCompositePending; /* bands not yet picked up */
+static int fbCompositeActive;  /* bands being composited */
+static int fbCompositeThreads; /* workers created so far */
+
+static void
+fbCompositeBand(FbCompositeBandPtr band)
+{
+    pixman_image_composite(band->op, band->src, band->mask, band->dest,
+                           band->src_x, band->src_y,
+                           band->mask_x, band->mask_y,
+                           band->dest_x, band->dest_y,
+                           band->width, band->height);
+}
+
+static void *
+fbCompositeWorker(void *arg)
+{
+    pthread_mutex_lock(&fbCompositeLock);
+    while (1) {
+        FbCompositeBandRec band;
+
+        while (!fbCompositePending)
+            pthread_cond_wait(&fbCompositeWake, &fbCompositeLock);
+        band = fbCompositeBands[--fbCompositePending];
+        fbCompositeActive++;
+        pthread_mutex_unlock(&fbCompositeLock);
+
+        fbCompositeBand(&band);
+
+        pthread_mutex_lock(&fbCompositeLock);
+        if (--fbCompositeActive == 0 && fbCompositePending == 0)
+            pthread_cond_signal(&fbCompositeDone);
+    }
+    return NULL;
+}
+
+/*
+ * Composite in parallel horizontal bands.  Returns FALSE if the
+ * operation is too small to be worth the fan-out, could read rows
+ * another band is writing, or no workers could be created; the caller
+ * then composites it in one op as usual.
+ */
+static Bool
+fbCompositeParallel(CARD8 op,
+                    pixman_image_t * src,
+                    pixman_image_t * mask,
+                    pixman_image_t * dest,
+                    int src_x, int src_y,
+                    int mask_x, int mask_y,
+                    int dest_x, int dest_y, int width, int height)
+{
+    int nbands, band, y, bandHeight;
+
+    if ((long) width * height < FB_COMPOSITE_THRESHOLD ||
+        height < FB_COMPOSITE_THREADS)
+        return FALSE;
+
+    /* bands write disjoint destination rows, but a self-composite
+       could read rows another band is writing */
+    if (src == dest || mask == dest)
+        return FALSE;
+
+    pthread_mutex_lock(&fbCompositeLock);
+
+    while (fbCompositeThreads < FB_COMPOSITE_THREADS - 1) {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, fbCompositeWorker, NULL) != 0)
+            break;
+        fbCompositeThreads++;
+    }
+    if (!fbCompositeThreads) {
+        pthread_mutex_unlock(&fbCompositeLock);
+        return FALSE;
+    }
+    pthread_mutex_unlock(&fbCompositeLock);
+
+    nbands = fbCompositeThreads + 1;
+    bandHeight = height / nbands;
+
+    /*
+     * Composite the first band on the calling thread before fanning
+     * out: pixman validates the images and caches their fast-path
+     * flags during the first composite, so the concurrent bands that
+     * follow only ever read that state.
+     */
+    fbCompositeBands[0] = (FbCompositeBandRec) {
+        .op = op, .src = src, .mask = mask, .dest = dest,
+        .src_x = src_x, .src_y = src_y,
+        .mask_x = mask_x, .mask_y = mask_y,
+        .dest_x = dest_x, .dest_y = dest_y,
+        .width = width, .height = bandHeight
+    };
+    fbCompositeBand(&fbCompositeBands[0]);
+
+    pthread_mutex_lock(&fbCompositeLock);
+    y = bandHeight;
+    for (band = 1; band < nbands; band++) {
+        FbCompositeBandPtr b = &fbCompositeBands[band - 1];
+        int h = (band == nbands - 1) ? height - y : bandHeight;
+
+        *b = fbCompositeBands[0];
+        b->src_y = src_y + y;
+        b->mask_y = mask_y + y;
+        b->dest_y = dest_y + y;
+        b->height = h;
+        y += h;
+    }
+    fbCompositePending = nbands - 1;
+    pthread_cond_broadcast(&fbCompositeWake);
+
+    /* work alongside the pool rather than just waiting */
+    while (fbCompositePending) {
+        FbCompositeBandRec myBand = fbCompositeBands[--fbCompositePending];
+
+        pthread_mutex_unlock(&fbCompositeLock);
+        fbCompositeBand(&myBand);
+        pthread_mutex_lock(&fbCompositeLock);
+    }
+    while (fbCompositeActive)
+        pthread_cond_wait(&fbCompositeDone, &fbCompositeLock);
+    pthread_mutex_unlock(&fbCompositeLock);
+
+    return TRUE;
+}
+#endif                          /* !FB_ACCESS_WRAPPER */
+
 void
 fbComposite(CARD8 op,
             PicturePtr pSrc,
@@ -54,15 +342,31 @@ fbComposite(CARD8 op,
     if (pMask)
         miCompositeSourceValidate(pMask);
 
-    src = image_from_pict(pSrc, FALSE, &src_xoff, &src_yoff);
+    /* Composite from the cached rasterization of a gradient source,
+       arranging for the sample origin to land on the buffer origin */
+    src = fbGradientCacheImage(pSrc, xSrc, ySrc, width, height);
+    if (src) {
+        src_xoff = -xSrc;
+        src_yoff = -ySrc;
+    }
+    else
+        src = image_from_pict(pSrc, FALSE, &src_xoff, &src_yoff);
     mask = image_from_pict(pMask, FALSE, &msk_xoff, &msk_yoff);
     dest = image_from_pict(pDst, TRUE, &dst_xoff, &dst_yoff);
 
     if (src && dest && !(pMask && !mask)) {
-        pixman_image_composite(op, src, mask, dest,
-                               xSrc + src_xoff, ySrc + src_yoff,
-                               xMask + msk_xoff, yMask + msk_yoff,
-                               xDst + dst_xoff, yDst + dst_yoff, width, height);
+#ifndef FB_ACCESS_WRAPPER
+        if (!fbCompositeParallel(op, src, mask, dest,
+                                 xSrc + src_xoff, ySrc + src_yoff,
+                                 xMask + msk_xoff, yMask + msk_yoff,
+                                 xDst + dst_xoff, yDst + dst_yoff,
+                                 width, height))
+#endif
+            pixman_image_composite(op, src, mask, dest,
+                                   xSrc + src_xoff, ySrc + src_yoff,
+                                   xMask + msk_xoff, yMask + msk_yoff,
+                                   xDst + dst_xoff, yDst + dst_yoff,
+                                   width, height);
     }
 
     free_pixman_pict(pSrc, src);
@@ -107,6 +411,7 @@ fbGlyphs(CARD8 op,
     pixman_image_t *srcImage, *dstImage;
     int srcXoff, srcYoff, dstXoff, dstYoff;
     GlyphPtr glyph;
+    GlyphPtr firstGlyph = NULL;
     int n_glyphs;
     int x, y;
     int i, n;
@@ -121,6 +426,12 @@ fbGlyphs(CARD8 op,
     if (!glyphCache)
 	glyphCache = pixman_glyph_cache_create();
 
+    if (!glyphCache) {
+	/* No cache, no batched compositing; draw the run glyph by glyph */
+	miGlyphs(op, pSrc, pDst, maskFormat, xSrc, ySrc, nlist, list, glyphs);
+	return;
+    }
+
     pixman_glyph_cache_freeze (glyphCache);
 
     if (n_glyphs > N_STACK_GLYPHS) {
@@ -167,6 +478,8 @@ fbGlyphs(CARD8 op,
 	    pglyphs[i].x = x;
 	    pglyphs[i].y = y;
 	    pglyphs[i].glyph = g;
+	    if (i == 0)
+		firstGlyph = glyph;
 	    i++;
 
 	next:
@@ -182,6 +495,20 @@ fbGlyphs(CARD8 op,
     if (!(dstImage = image_from_pict(pDst, TRUE, &dstXoff, &dstYoff)))
 	goto out_free_src;
 
+    /*
+     * A single glyph has no overlaps to accumulate, so when its format
+     * matches the requested mask format the intermediate mask would
+     * just reproduce the glyph; composite it directly and skip the
+     * mask allocation and extra pass.  The format check keeps the
+     * component-alpha treatment identical on both paths.
+     */
+    if (maskFormat && n_glyphs == 1 && firstGlyph) {
+	PicturePtr pGlyphPict = GetGlyphPicture(firstGlyph, pScreen);
+
+	if (pGlyphPict && pGlyphPict->format == maskFormat->format)
+	    maskFormat = NULL;
+    }
+
     if (maskFormat) {
 	pixman_format_code_t format;
 	pixman_box32_t extents;
@@ -490,9 +817,14 @@ fbPictureInit(ScreenPtr pScreen, PictFormatPtr formats, int nformats)
 
     PictureScreenPtr ps;
 
+    if (!dixRegisterPrivateKey(&fbGradientCacheKeyRec, PRIVATE_PICTURE,
+                               sizeof(FbGradientCacheRec)))
+        return FALSE;
+
     if (!miPictureInit(pScreen, formats, nformats))
         return FALSE;
     ps = GetPictureScreen(pScreen);
+    ps->DestroyPicture = fbDestroyPicture;
     ps->Composite = fbComposite;
     ps->Glyphs = fbGlyphs;
     ps->UnrealizeGlyph = fbUnrealizeGlyph;
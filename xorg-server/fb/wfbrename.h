@@ -119,6 +119,7 @@
 #define fbUninstallColormap wfbUninstallColormap
 #define fbUnrealizeWindow wfbUnrealizeWindow
 #define fbUnrealizeFont wfbUnrealizeFont
+#define fbUpdateGCFill wfbUpdateGCFill
 #define fbValidateGC wfbValidateGC
 #define fbWinPrivateKeyRec wfbWinPrivateKeyRec
 #define free_pixman_pict wfb_free_pixman_pict
@@ -259,7 +259,8 @@ glamor_destroy_gc(GCPtr gc)
     glamor_invalidate_stipple(gc);
     if (gc_priv->stipple_damage)
         DamageDestroy(gc_priv->stipple_damage);
-    miDestroyGC(gc);
+    /* fbDestroyGC releases any composite clips memoized by fbValidateGC */
+    fbDestroyGC(gc);
 }
 
 static GCFuncs glamor_gc_funcs = {
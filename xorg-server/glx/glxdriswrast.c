@@ -421,6 +421,7 @@ initializeExtensions(__GLXscreen * screen)
 }
 
 extern Bool g_fswrastwgl;
+extern const char *g_pszGLXDriver;
 static void
 __glXDRIscreenDestroy(__GLXscreen * baseScreen)
 {
@@ -453,7 +454,9 @@ __glXDRIscreenProbe(ScreenPtr pScreen)
     const char *driverName;
     __GLXDRIscreen *screen;
     
-    if (g_fswrastwgl)
+    if (g_pszGLXDriver)
+      driverName = g_pszGLXDriver;
+    else if (g_fswrastwgl)
       driverName = "swrastwgl";
     else
       driverName = "swrast";
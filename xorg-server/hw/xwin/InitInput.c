@@ -97,6 +97,10 @@ InitInput(int argc, char *argv[])
                         FALSE) != Success)
         FatalError("InitInput - Failed to allocate slave devices.\n");
 
+    /* Touch input arrives via WM_POINTER on Windows 8 and later;
+       winTouchInit quietly declines on older systems */
+    winTouchInit();
+
     mieqInit();
 
     /* Do not nitialize the mode key states here yet since the keyboard device is not started yet
@@ -750,6 +750,12 @@ winUseMsg(void)
            "\tversions because they already group GDI operations together\n"
            "\tin a batch, which has a similar effect.\n");
 
+    ErrorF("-scaling percent\n"
+           "\tScale the screen window by the given percentage (100 to 400\n"
+           "\tin steps of 25) when presenting, rendering X at the unscaled\n"
+           "\tresolution.  Only supported windowed with the Shadow GDI and\n"
+           "\tShadow DirectDraw Non-Locking engines.  Default is 100.\n");
+
     ErrorF("-[no]compositewm\n"
            "\tEnable [Disable] Composite extension. Default is enabled.\n"
            "\tUsed in -multiwindow mode.\n"
@@ -792,8 +798,14 @@ winUseMsg(void)
            "\tOverride the server's automatically selected engine type:\n"
            "\t\t1 - Shadow GDI\n"
            "\t\t4 - Shadow DirectDraw4 Non-Locking\n"
+           "\t\t8 - Shadow DXGI flip-model\n"
         );
 
+    ErrorF("-etwtrace\n"
+           "\tRegister an ETW provider emitting request dispatch, input\n"
+           "\tenqueue, damage and shadow present events for use with the\n"
+           "\tWindows Performance Analyzer.\n");
+
     ErrorF("-fullscreen\n" "\tRun the server in fullscreen mode.\n");
 
     ErrorF("-[no]hostintitle\n"
@@ -836,6 +848,14 @@ winUseMsg(void)
            "\tRun the server in multiwindow mode.  Not to be used\n"
            "\ttogether with -rootless or -fullscreen.\n");
 
+    ErrorF("-[no]parallelupdates\n"
+           "\tUse one shadow update thread per physical monitor when\n"
+           "\tthe screen spans multiple monitors.\n");
+
+    ErrorF("-[no]d3dcompositing\n"
+           "\tExecute large RENDER Composite requests with Direct3D\n"
+           "\tpixel shaders (-engine 8 only).  Default is disabled.\n");
+
     ErrorF("-nodecoration\n"
            "\tDo not draw a window border, title bar, etc.  Windowed\n"
            "\tmode only i.e. ignored when -fullscreen specified.\n");
@@ -868,6 +888,12 @@ winUseMsg(void)
            "\t -screen 0 1024x768@3        ; 3rd monitor size 1024x768\n"
            "\t -screen 0 @1 ; on 1st monitor using its full resolution (the default)\n");
 
+    ErrorF("-rawinput\n"
+           "\tDeliver mouse motion from Windows raw input (WM_INPUT) packets\n"
+           "\tinstead of the coalesced WM_MOUSEMOVE messages.  This gives\n"
+           "\tmotion at the device rate, which is mainly useful in fullscreen\n"
+           "\tmode with pointer-intensive applications.\n");
+
     ErrorF("-swcursor\n"
            "\tDisable the usage of the Windows cursor and use the X11 software\n"
            "\tcursor instead.\n");
@@ -888,6 +914,15 @@ winUseMsg(void)
     ErrorF("-swrastwgl\n"
            "\tEnable the GLX extension to use the native Windows WGL interface based on the swrast interface for accelerated OpenGL\n");
 
+    ErrorF("-glxdriver drivername\n"
+           "\tLoad drivername_dri.dll instead of the default swrast driver\n"
+           "\tfor GLX rendering, e.g. a d3d12-backed build of Mesa.\n");
+
+    ErrorF("-swrastthreads n\n"
+           "\tLimit the software rasterizer to n rendering threads.  By\n"
+           "\tdefault one thread per processor is created, which oversubscribes\n"
+           "\tthe machine when many servers run at once.\n");
+
     ErrorF("-[no]winkill\n" "\tAlt+F4 exits the X Server.\n");
 
     ErrorF("-xkblayout XKBLayout\n"
@@ -987,13 +1022,15 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
         pScreenInfo->formats[i] = g_PixmapFormats[i];
     }
 
-    /* Load pointers to DirectDraw functions */
-    winGetDDProcAddresses();
+    /*
+     * DirectDraw/D3D11 loading and engine detection happen lazily in
+     * winSetEngine, and the shell32 property store loads on first use
+     * in winSetAppUserModelID; neither belongs on the cold start path.
+     */
 
-    /* Detect supported engines */
-    winDetectSupportedEngines();
-    /* Load libraries for taskbar grouping */
-    winPropertyStoreInit();
+    /* Register the ETW pipeline trace provider, if requested */
+    if (serverGeneration == 1 && !winTraceInit())
+        ErrorF("InitOutput - Could not register ETW trace provider\n");
 
     /* Store the instance handle */
     g_hInstance = GetModuleHandle(NULL);
@@ -1053,6 +1090,12 @@ InitOutput(ScreenInfo * pScreenInfo, int argc, char *argv[])
 
                           PseudoramiXAddScreen(data.monitorOffsetX, data.monitorOffsetY,
                                                data.monitorWidth, data.monitorHeight);
+
+                          /* also surface the monitor through RandR 1.5 */
+                          winRandRAddMonitor(screenInfo.screens[0], iMonitor - 1,
+                                             data.monitorOffsetX, data.monitorOffsetY,
+                                             data.monitorWidth, data.monitorHeight,
+                                             pass == 0);
                         }
                     }
                 }
@@ -32,11 +32,34 @@
 #include "dixstruct.h"
 #include "extnsionst.h"
 #include "scrnintstr.h"
+#include "pixmapstr.h"
+#include "resource.h"
 #include "swaprep.h"
 #include "protocol-versions.h"
 #include "windowsdri.h"
 #include "glx/dri_helpers.h"
 
+/*
+ * Server-side addition, not yet in windowsdriproto: binds a DXGI legacy
+ * shared handle (from a resource the client created with
+ * D3D11_RESOURCE_MISC_SHARED) as the backing store of a pixmap, so a
+ * local GPU-rendering client shares its buffer with the server instead
+ * of uploading it with PutImage.  Only meaningful with the Shadow DXGI
+ * engine; other engines return BadMatch.
+ */
+#ifndef X_WindowsDRIBindSharedPixmap
+#define X_WindowsDRIBindSharedPixmap 4
+
+typedef struct {
+    CARD8 reqType;              /* always WindowsDRIReqCode */
+    CARD8 driReqType;           /* always X_WindowsDRIBindSharedPixmap */
+    CARD16 length;
+    CARD32 pixmap;
+    CARD32 handle;              /* DXGI legacy shared handle value */
+} xWindowsDRIBindSharedPixmapReq;
+#define sz_xWindowsDRIBindSharedPixmapReq 12
+#endif
+
 static int WindowsDRIErrorBase = 0;
 static unsigned char WindowsDRIReqCode = 0;
 static int WindowsDRIEventBase = 0;
@@ -147,6 +170,23 @@ ProcWindowsDRIFBConfigToPixelFormat(ClientPtr client)
     return Success;
 }
 
+static int
+ProcWindowsDRIBindSharedPixmap(ClientPtr client)
+{
+    PixmapPtr pPixmap;
+    int rc;
+
+    REQUEST(xWindowsDRIBindSharedPixmapReq);
+    REQUEST_SIZE_MATCH(xWindowsDRIBindSharedPixmapReq);
+
+    rc = dixLookupResourceByType((void **) &pPixmap, stuff->pixmap,
+                                 RT_PIXMAP, client, DixWriteAccess);
+    if (rc != Success)
+        return rc;
+
+    return winDxgiBindSharedPixmap(pPixmap, stuff->handle);
+}
+
 /* dispatch */
 
 static int
@@ -172,6 +212,9 @@ ProcWindowsDRIDispatch(ClientPtr client)
     case X_WindowsDRIFBConfigToPixelFormat:
         return ProcWindowsDRIFBConfigToPixelFormat(client);
 
+    case X_WindowsDRIBindSharedPixmap:
+        return ProcWindowsDRIBindSharedPixmap(client);
+
     default:
         return BadRequest;
     }
@@ -224,6 +267,16 @@ SProcWindowsDRIFBConfigToPixelFormat(ClientPtr client)
     return ProcWindowsDRIFBConfigToPixelFormat(client);
 }
 
+static int
+SProcWindowsDRIBindSharedPixmap(ClientPtr client)
+{
+    REQUEST(xWindowsDRIBindSharedPixmapReq);
+    swaps(&stuff->length);
+    swapl(&stuff->pixmap);
+    swapl(&stuff->handle);
+    return ProcWindowsDRIBindSharedPixmap(client);
+}
+
 static int
 SProcWindowsDRIDispatch(ClientPtr client)
 {
@@ -247,6 +300,9 @@ SProcWindowsDRIDispatch(ClientPtr client)
     case X_WindowsDRIFBConfigToPixelFormat:
         return SProcWindowsDRIFBConfigToPixelFormat(client);
 
+    case X_WindowsDRIBindSharedPixmap:
+        return SProcWindowsDRIBindSharedPixmap(client);
+
     default:
         return BadRequest;
     }
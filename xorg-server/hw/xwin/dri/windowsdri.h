@@ -24,6 +24,12 @@
 #ifndef windowsdri_h
 #define windowsdri_h
 
+#include <X11/Xmd.h>
+#include "pixmap.h"
+
 void WindowsDRIExtensionInit(void);
 
+/* implemented by the Shadow DXGI engine, hw/xwin/winshaddxgi.c */
+int winDxgiBindSharedPixmap(PixmapPtr pPixmap, CARD32 dwHandle);
+
 #endif /* windowsdri_h */
@@ -277,6 +277,15 @@ class PreResolveOutputGenerator(OutputGenerator):
         if prefix == 'wgl' and not name in used_wgl_ext_fns:
             return
 
+        # for GL, only resolve what the wrappers below will actually call:
+        # OpenGL 1.0/1.1 functions are linked directly against opengl32.dll,
+        # and functions outside the dispatch table have no wrapper
+        if prefix == 'gl':
+            if self.OldVersion:
+                return
+            if dispatchheader and not name in dispatch:
+                return
+
         self.outFile.write('RESOLVE_DECL(PFN' + name.upper() + 'PROC);\n')
         self.wrappers[name]=1
 
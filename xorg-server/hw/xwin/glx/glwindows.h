@@ -51,6 +51,7 @@ const GLubyte *glGetStringWrapperNonstatic(GLenum name);
 void glAddSwapHintRectWINWrapperNonstatic(GLint x, GLint y, GLsizei width,
                                           GLsizei height);
 void glWinSetupDispatchTable(void);
+void glResolveExtensionProcs(void);
 
 #ifdef _DEBUG
 #ifdef _MSC_VER
@@ -71,53 +71,36 @@ glWinCallDelta(void)
 }
 #endif
 
-static PROC
-glWinResolveHelper(PROC * cache, const char *symbol)
-{
-    PROC proc = NULL;
-
-    /* If not yet cached, call wglGetProcAddress */
-    if ((*cache) == NULL) {
-        proc = wglGetProcAddress(symbol);
-        if (proc == NULL) {
-            winDebug("glwrap: Can't resolve \"%s\"\n", symbol);
-            (*cache) = (PROC) - 1;
-        }
-        else {
-            winDebug("glwrap: Resolved \"%s\"\n", symbol);
-            (*cache) = proc;
-        }
-    }
-    /* Cached wglGetProcAddress failure */
-    else if ((*cache) == (PROC) - 1) {
-        proc = 0;
-    }
-    /* Cached wglGetProcAddress result */
-    else {
-        proc = (*cache);
-    }
-
-    return proc;
-}
-
 #ifdef _DEBUG
 #define INCPROCCALLS   glWinIndirectProcCalls++;
 #else
 #define INCPROCCALLS
 #endif
 
-#define RESOLVE_RET(proctype, symbol, retval) \
-    static PROC cache = NULL; \
-    proctype proc = (proctype)glWinResolveHelper(&cache, symbol); \
-    if (proc == NULL) { \
+/*
+  As in wgl_ext_api.c, each wrapped function calls through a pre-resolved
+  pointer, so the hot path is a NULL check and an indirect call rather
+  than a resolver call per invocation.  glResolveExtensionProcs() fills
+  the pointers in one pass once a context is current.
+*/
+
+#define RESOLVE_DECL(type) \
+    static type type##proc = NULL;
+
+#define PRERESOLVE(type, symbol) \
+    type##proc = (type)wglGetProcAddress(symbol);
+
+#define RESOLVE_RET(type, symbol, retval) \
+    if (type##proc == NULL) { \
+        winDebug("glwrap: Can't resolve \"%s\"\n", symbol); \
         __glXErrorCallBack(0); \
         return retval; \
     } \
     INCPROCCALLS
 
-#define RESOLVE(proctype, symbol) RESOLVE_RET(proctype, symbol,)
+#define RESOLVE(type, symbol) RESOLVE_RET(type, symbol,)
 
-#define RESOLVED_PROC(proctype) proc
+#define RESOLVED_PROC(type) type##proc
 
 /*
   Include generated cdecl wrappers for stdcall gl*() functions in opengl32.dll
@@ -152,6 +135,18 @@ void
 glAddSwapHintRectWINWrapperNonstatic(GLint x, GLint y, GLsizei width,
                                      GLsizei height)
 {
-    RESOLVE(PFNGLADDSWAPHINTRECTWIN, "glAddSwapHintRectWIN");
+    /* not in the generated wrappers, so resolved here on first use */
+    static PFNGLADDSWAPHINTRECTWIN proc = NULL;
+
+    if (proc == NULL)
+        proc = (PFNGLADDSWAPHINTRECTWIN)
+            wglGetProcAddress("glAddSwapHintRectWIN");
+
+    if (proc == NULL) {
+        winDebug("glwrap: Can't resolve \"glAddSwapHintRectWIN\"\n");
+        __glXErrorCallBack(0);
+        return;
+    }
+
     proc(x, y, width, height);
 }
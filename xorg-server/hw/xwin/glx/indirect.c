@@ -597,6 +597,14 @@ glxWinScreenProbe(ScreenPtr pScreen)
         goto error;
     }
 
+    // note the monitor refresh period for frame pacing
+    {
+        int refresh = GetDeviceCaps(hdc, VREFRESH);
+
+        /* 0 and 1 both mean the hardware default rate */
+        screen->swapPeriodMs = (refresh > 1) ? (1000 + refresh / 2) / refresh : 0;
+    }
+
     // we must set a pixel format before we can create a context
     {
         PIXELFORMATDESCRIPTOR pfd = {
@@ -640,6 +648,10 @@ glxWinScreenProbe(ScreenPtr pScreen)
     // (but we need to have a current context for them to be resolvable)
     wglResolveExtensionProcs();
 
+    // likewise for the proc pointers behind the generated gl wrappers, so
+    // each dispatch call is made through an already-resolved pointer
+    glResolveExtensionProcs();
+
     winDebug("GL_VERSION:     %s\n", glGetStringWrapperNonstatic(GL_VERSION));
     winDebug("GL_VENDOR:      %s\n", glGetStringWrapperNonstatic(GL_VENDOR));
     gl_renderer = (const char *) glGetStringWrapperNonstatic(GL_RENDERER);
@@ -739,6 +751,9 @@ glxWinScreenProbe(ScreenPtr pScreen)
             screen->has_WGL_ARB_framebuffer_sRGB = TRUE;
         }
 
+        if (strstr(wgl_extensions, "WGL_EXT_swap_control"))
+            screen->has_WGL_EXT_swap_control = TRUE;
+
         screen->base.destroy = glxWinScreenDestroy;
         screen->base.createContext = glxWinCreateContext;
         screen->base.createDrawable = glxWinCreateDrawable;
@@ -963,6 +978,32 @@ glxWinDestroyWindow(WindowPtr pWin)
  * Drawable functions
  */
 
+/*
+   Frame pacing
+
+   New contexts default to swap interval 0 so that SwapBuffers never blocks
+   the single server thread on vblank, but that lets an unthrottled client
+   spin submitting swaps far faster than the monitor can present them,
+   pegging a core for frames nobody sees.  Rather than blocking everyone,
+   put a client which swaps again within the same refresh period to sleep
+   and wake it when the period has elapsed; other clients keep running in
+   the meantime.
+ */
+
+static Bool
+glxWinSwapPacingWakeup(ClientPtr client, void *closure)
+{
+    ClientWakeup(client);
+    return TRUE;
+}
+
+static CARD32
+glxWinSwapPacingExpired(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    ClientSignal((ClientPtr) arg);
+    return 0;
+}
+
 static GLboolean
 glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
 {
@@ -986,6 +1027,24 @@ glxWinDrawableSwapBuffers(ClientPtr client, __GLXdrawable * base)
         return GL_FALSE;
     }
 
+    if (client && base->pDraw) {
+        glxWinScreen *scr =
+            (glxWinScreen *) glxGetScreen(base->pDraw->pScreen);
+
+        if (scr->swapPeriodMs) {
+            CARD32 now = GetTimeInMillis();
+            CARD32 elapsed = now - draw->lastSwapTime;
+
+            if (elapsed < scr->swapPeriodMs &&
+                ClientSleep(client, glxWinSwapPacingWakeup, draw))
+                draw->swapPacingTimer =
+                    TimerSet(draw->swapPacingTimer, 0,
+                             scr->swapPeriodMs - elapsed,
+                             glxWinSwapPacingExpired, client);
+            draw->lastSwapTime = now;
+        }
+    }
+
     return GL_TRUE;
 }
 
@@ -1029,6 +1088,12 @@ glxWinDrawableDestroy(__GLXdrawable * base)
         glxPriv->base.pDraw->pScreen->DestroyPixmap((PixmapPtr)glxPriv->base.pDraw); /* Decrement reference count since we do not use it any more */
     }
 
+    if (glxPriv->swapPacingTimer) {
+        TimerFree(glxPriv->swapPacingTimer);
+        /* wake anyone still paced on this drawable */
+        ClientSignalAll(CLIENT_SIGNAL_ANY, glxWinSwapPacingWakeup, glxPriv);
+    }
+
     GLWIN_DEBUG_MSG("glxWinDestroyDrawable");
     free(glxPriv);
 }
@@ -1647,6 +1712,21 @@ glxWinContextMakeCurrent(__GLXcontext * base)
     if (!ret)
       drawPriv->drawContext = NULL; /* clear last active context because we return error */
 
+    /*
+       At the driver default interval of 1, SwapBuffers blocks until vblank,
+       and since we process GL requests on the single server thread, one
+       synced client throttles them all.  The compositor already paces
+       presentation of our windows, so default new contexts to interval 0;
+       clients which want sync can still ask for it via GLX_SGI_swap_control
+       (the interval belongs to the native context, so set it once on first
+       bind rather than stomping on a client-requested value later)
+     */
+    if (ret && !gc->swapIntervalDefaulted && scr->has_WGL_EXT_swap_control) {
+        if (!wglSwapIntervalEXTWrapper(0))
+            ErrorF("wglSwapIntervalEXT failed: %s\n", glxWinErrorMessage());
+        gc->swapIntervalDefaulted = TRUE;
+    }
+
     return ret;
 }
 
@@ -1825,6 +1905,15 @@ fbConfigToPixelFormat(__GLXconfig * mode, PIXELFORMATDESCRIPTOR * pfdret,
     }
     if (mode->doubleBufferMode) {
         pfd.dwFlags |= PFD_DOUBLEBUFFER;
+
+        /*
+           Prefer formats the compositor can flip from directly, rather than
+           having the swap copied into the window's redirection surface.
+           Composition is incompatible with GDI bitmap rendering, so only ask
+           for it on formats which aren't also used for pixmap drawables.
+         */
+        if (!(pfd.dwFlags & PFD_SUPPORT_GDI))
+            pfd.dwFlags |= PFD_SUPPORT_COMPOSITION;
     }
 
     pfd.cColorBits = mode->redBits + mode->greenBits + mode->blueBits;
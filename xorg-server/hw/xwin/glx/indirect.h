@@ -49,6 +49,7 @@ struct __GLXWinContext {
     HWND hreadwnd;
     struct _glapi_table *Dispatch;
 
+    Bool swapIntervalDefaulted; /* default swap interval applied on first bind */
 };
 
 struct __GLXWinDrawable {
@@ -65,6 +66,10 @@ struct __GLXWinDrawable {
     HBITMAP hDIB;
     HBITMAP hOldDIB;            /* original DIB for DC */
     void *pOldBits;             /* original pBits for this drawable's pixmap */
+
+    /* frame pacing */
+    CARD32 lastSwapTime;
+    OsTimerPtr swapPacingTimer;
 };
 
 struct __GLXWinScreen {
@@ -76,6 +81,9 @@ struct __GLXWinScreen {
     Bool has_WGL_ARB_render_texture;
     Bool has_WGL_ARB_make_current_read;
     Bool has_WGL_ARB_framebuffer_sRGB;
+    Bool has_WGL_EXT_swap_control;
+
+    int swapPeriodMs;           /* monitor refresh period, 0 if unknown */
 
     /* wrapped screen functions */
     RealizeWindowProcPtr RealizeWindow;
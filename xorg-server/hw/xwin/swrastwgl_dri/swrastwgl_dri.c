@@ -61,8 +61,11 @@ struct __DRIdrawableRec
   HBITMAP hBitmap;
   int winWidth;
   int winHeight;
+  int dibWidth;       /* DIB allocation; may exceed the window size */
+  int dibHeight;
   int bitsPerPixel;
   VOID *bits;
+  VOID *packedBits;   /* winWidth-stride staging buffer for putImage */
 
   void *driverPrivate;
   void *loaderPrivate;
@@ -325,8 +328,8 @@ void setupDIB(__DRIdrawable * pdp)
   bmHeader = &bmInfo->bmiHeader;
 
   bmHeader->biSize = sizeof(*bmHeader);
-  bmHeader->biWidth = pdp->winWidth;
-  bmHeader->biHeight = pdp->winHeight;
+  bmHeader->biWidth = pdp->dibWidth;
+  bmHeader->biHeight = pdp->dibHeight;
   bmHeader->biPlanes = 1;                     /* must be 1 */
   bmHeader->biBitCount = bitsPerPixel;
   bmHeader->biXPelsPerMeter = 0;
@@ -384,6 +387,14 @@ void setupDIB(__DRIdrawable * pdp)
   if (pdp->hBitmap) DeleteObject(pdp->hBitmap);
   pdp->hBitmap = hBitmap;
 
+  free(pdp->packedBits);
+  pdp->packedBits = malloc(((pdp->dibWidth * bitsPerPixel + 31) / 32) * 4 * pdp->dibHeight);
+  if (pdp->packedBits == NULL)
+  {
+    (void) MessageBox(WindowFromDC(pdp->hDC), "Failed to create DIBSection.", "OpenGL application error", MB_ICONERROR | MB_OK);
+    exit(1);
+  }
+
   free(bmInfo);
 }
 
@@ -3173,6 +3184,29 @@ static void driDrawableCheckSize(__DRIdrawable *pdp)
     return;
   pdp->winWidth=w;
   pdp->winHeight=h;
+
+  /*
+   * Only recreate the DIB when the window outgrows it, and then with
+   * half again the headroom, so an interactive resize recreates the
+   * surface O(log n) times instead of once per size step.  The larger
+   * allocation is kept across shrinks; GL renders into its bottom-left
+   * corner and driSwapBuffers copies out the window-sized subrect.
+   */
+  if (pdp->hBitmap && w<=pdp->dibWidth && h<=pdp->dibHeight)
+    return;
+  if (!pdp->hBitmap)
+  {
+    /* first allocation: exact fit for windows which never resize */
+    pdp->dibWidth=w;
+    pdp->dibHeight=h;
+  }
+  else
+  {
+    if (w>pdp->dibWidth)
+      pdp->dibWidth=w+w/2;
+    if (h>pdp->dibHeight)
+      pdp->dibHeight=h+h/2;
+  }
   setupDIB(pdp);
 }
 static __DRIdrawable *driCreateNewDrawable(__DRIscreen *psp, const __DRIconfig *config, void *data)
@@ -3269,6 +3303,7 @@ static void driDestroyDrawable(__DRIdrawable *pdp)
     DeleteObject(pdp->hBitmap);
     if (pdp->hPalette) DeleteObject(pdp->hPalette);
 
+    free(pdp->packedBits);
     free(pdp);
   }
 }
@@ -3335,31 +3370,35 @@ static void driSwapBuffers(__DRIdrawable *pdp)
 //    GET_CURRENT_CONTEXT(ctx);
   /* Revert image */
   int Row;
-  int UpRow;
-  int ColCount;
-  int HalfRowCount;
-  int *pBits;
+  int RowCount;
+  int SrcStride;
+  int DstStride;
+  char *pSrc;
+  char *pDst;
 
   //GdiFlush();
 
   driDrawableCheckSize(pdp);
 
-  ColCount=pdp->winWidth;
-  HalfRowCount=pdp->winHeight/2;
-  pBits=(int*)pdp->bits;
-
-  for (Row=0,UpRow=2*HalfRowCount-1; Row<HalfRowCount; Row++,UpRow--)
+  /*
+   * Copy the window-sized subrect out of the (possibly larger) DIB,
+   * flipping it into the top-down row order putImage expects.  The DIB
+   * itself is left untouched for the next frame.
+   */
+  RowCount=pdp->winHeight;
+  SrcStride=((pdp->dibWidth*pdp->bitsPerPixel+31)/32)*4;
+  DstStride=((pdp->winWidth*pdp->bitsPerPixel+31)/32)*4;
+  pSrc=(char*)pdp->bits+(RowCount-1)*SrcStride;
+  pDst=(char*)pdp->packedBits;
+
+  for (Row=0; Row<RowCount; Row++)
   {
-    int j;
-    for (j=0; j<ColCount; j++)
-    {
-      int Temp=pBits[Row*ColCount+j];
-      pBits[Row*ColCount+j]=pBits[UpRow*ColCount+j];
-      pBits[UpRow*ColCount+j]=Temp;
-    }
+    memcpy(pDst, pSrc, DstStride);
+    pDst+=DstStride;
+    pSrc-=SrcStride;
   }
 
-  pdp->driScreenPriv->swrast_loader->putImage(pdp, __DRI_SWRAST_IMAGE_OP_SWAP, 0, 0, pdp->winWidth, pdp->winHeight, pdp->bits, pdp->loaderPrivate);
+  pdp->driScreenPriv->swrast_loader->putImage(pdp, __DRI_SWRAST_IMAGE_OP_SWAP, 0, 0, pdp->winWidth, pdp->winHeight, pdp->packedBits, pdp->loaderPrivate);
 }
 
 const __DRIcoreExtension driCoreExtension = {
@@ -47,6 +47,18 @@
 #define WM_MOUSEHWHEEL 0x020E
 #endif
 
+/* We can handle WM_POINTER* even though _WIN32_WINNT < 0x0602 */
+#ifndef WM_POINTERUPDATE
+#define WM_POINTERUPDATE 0x0245
+#define WM_POINTERDOWN 0x0246
+#define WM_POINTERUP 0x0247
+#endif
+
+/* We can handle WM_DPICHANGED even though _WIN32_WINNT < 0x0603 */
+#ifndef WM_DPICHANGED
+#define WM_DPICHANGED 0x02E0
+#endif
+
 #define WIN_DEFAULT_BPP				0
 #define WIN_DEFAULT_WHITEPIXEL			255
 #define WIN_DEFAULT_BLACKPIXEL			0
@@ -57,11 +69,29 @@
 #define WIN_DEFAULT_WIN_KILL			TRUE
 #define WIN_DEFAULT_UNIX_KILL			FALSE
 #define WIN_DEFAULT_CLIP_UPDATES_NBOXES		0
+#define WIN_DEFAULT_SCALE			100     /* percent */
 #ifdef XWIN_EMULATEPSEUDO
 #define WIN_DEFAULT_EMULATE_PSEUDO		FALSE
 #endif
 #define WIN_DEFAULT_USER_GAVE_HEIGHT_AND_WIDTH	FALSE
 
+/*
+ * Conversions between logical (X screen) and device (Windows) pixels
+ * for -scaling.  Device extents round up, so a logical rectangle always
+ * covers every device pixel it touches.  Both are the identity when
+ * dwScale is 100.  Logical rectangles fed to a stretching blit must be
+ * aligned to WIN_SCALE_ALIGN so that their device edges land on whole
+ * pixels for any scale in 25% steps; adjacent stretches then tile
+ * without filter seams.
+ */
+#define winScaleToDevice(pScreenInfo, i) \
+    (((i) * (int) (pScreenInfo)->dwScale) / 100)
+#define winScaleToDeviceCeil(pScreenInfo, i) \
+    (((i) * (int) (pScreenInfo)->dwScale + 99) / 100)
+#define winScaleToLogical(pScreenInfo, i) \
+    (((i) * 100) / (int) (pScreenInfo)->dwScale)
+#define WIN_SCALE_ALIGN				4
+
 /*
  * Windows only supports 256 color palettes
  */
@@ -86,6 +116,10 @@
  */
 #define WIN_E3B_TIMER_ID		1
 #define WIN_POLLING_MOUSE_TIMER_ID	2
+#define WIN_DISPLAYCHANGE_TIMER_ID	3
+
+/* Quiescence delay before acting on a burst of WM_DISPLAYCHANGE (ms) */
+#define WIN_DISPLAYCHANGE_DELAY		500
 
 #define MOUSE_POLLING_INTERVAL		50
 
@@ -97,6 +131,7 @@
 #define WIN_SERVER_NONE		0x0L    /* 0 */
 #define WIN_SERVER_SHADOW_GDI	0x1L    /* 1 */
 #define WIN_SERVER_SHADOW_DDNL	0x4L    /* 4 */
+#define WIN_SERVER_SHADOW_DXGI	0x8L    /* 8 */
 
 #define AltMapIndex		Mod1MapIndex
 #define NumLockMapIndex		Mod2MapIndex
@@ -182,6 +217,8 @@ typedef int pid_t;
 #define WM_TRAYICON		(WM_USER + 1000)
 #define WM_INIT_SYS_MENU	(WM_USER + 1001)
 #define WM_GIVEUP		(WM_USER + 1002)
+#define WM_INIT_TRAYICON	(WM_USER + 1003)
+#define WM_DUMPSTATS		(WM_USER + 1004)
 
 /* Local includes */
 #include "winwindow.h"
@@ -265,6 +302,18 @@ typedef struct {
     void *pbBits;
     BITMAPINFOHEADER *pbmih;
     BOOL owned;
+
+    /* Imported DXGI shared textures (Shadow DXGI engine, see
+       winshaddxgi.c); NULL unless WindowsDRI bound a shared handle */
+    void *pSharedTexture;
+    void *pStagingTexture;
+
+    /* Cached shader-resource upload of the pixmap bits (Direct3D
+       compositor, see winrender.c); revalidated against the drawable
+       serial number and the compositor's device generation */
+    void *pCompTexture;
+    unsigned long ulCompSerial;
+    unsigned long ulCompGen;
 } winPrivPixmapRec, *winPrivPixmapPtr;
 
 /*
@@ -283,6 +332,10 @@ typedef struct {
  * Windows Cursor handling.
  */
 
+/* Number of converted HCURSORs kept per screen; animated cursors
+   commonly cycle through up to this many frames */
+#define WIN_CURSOR_CACHE_SIZE 16
+
 typedef struct {
     /* from GetSystemMetrics */
     int sm_cx;
@@ -290,6 +343,17 @@ typedef struct {
 
     BOOL visible;
     HCURSOR handle;
+
+    /* Cache of converted cursors, keyed on CursorPtr and serial number,
+       so cursor animation does not pay a conversion per frame */
+    struct {
+        CursorPtr pCursor;
+        CARD32 dwSerial;
+        HCURSOR hCursor;
+        unsigned long ulLastUsed;
+    } cache[WIN_CURSOR_CACHE_SIZE];
+    unsigned long ulCacheTick;
+
     QueryBestSizeProcPtr QueryBestSize;
     miPointerSpriteFuncPtr spriteFuncs;
 } winCursorRec;
@@ -345,9 +409,26 @@ typedef struct {
     DWORD dwDepth;
     DWORD dwRefreshRate;
     char *pfb;
+
+    /*
+     * Rows actually allocated in the shadow framebuffer; the drawing
+     * engine may over-allocate so that a later RandR resize with an
+     * unchanged stride can reuse the allocation in place rather than
+     * recreating it (see winrandr.c).  Zero when the engine does not
+     * support resizing in place.
+     */
+    DWORD dwShadowHeightMax;
+
     DWORD dwEngine;
     DWORD dwEnginePreferred;
     DWORD dwClipUpdatesNBoxes;
+
+    /*
+     * Display scaling percentage (-scaling); the X screen stays at the
+     * logical dwWidth x dwHeight and the present blit stretches it to
+     * device pixels.  100 means no scaling.
+     */
+    DWORD dwScale;
 #ifdef XWIN_EMULATEPSEUDO
     Bool fEmulatePseudo;
 #endif
@@ -358,6 +439,8 @@ typedef struct {
     Bool fCompositeWM;
     Bool fMultiMonitorOverride;
     Bool fMultipleMonitors;
+    Bool fParallelUpdates;
+    Bool fD3DComposite;
     Bool fLessPointer;
     winResizeMode iResizeMode;
     Bool fNoTrayIcon;
@@ -416,6 +499,7 @@ typedef struct _winPrivScreenRec {
 
     /* Privates used by shadow fb GDI engine */
     HBITMAP hbmpShadow;
+    HANDLE hShadowSection;
     HDC hdcScreen;
     HDC hdcShadow;
     HWND hwndScreen;
@@ -429,6 +513,24 @@ typedef struct _winPrivScreenRec {
     LPDIRECTDRAWCLIPPER pddcPrimary;
     BOOL fRetryCreateSurface;
 
+    /* Privates used by shadow fb DXGI flip-model engine */
+    void *pDXGIPriv;
+
+    /* Privates used by the Direct3D RENDER compositor */
+    void *pD3DRenderPriv;
+
+    /* Per-monitor parallel shadow update workers */
+    struct _winParallelShadow *pParallelShadow;
+    Bool fParallelShadowFailed;
+
+    /* Vblank interval in microseconds, used by winpresent.c */
+    uint64_t qwPresentInterval;
+
+#ifdef XWIN_XV
+    /* CloseScreen chain entry for the Xv adaptor, winvideo.c */
+    CloseScreenProcPtr pwinXvCloseScreen;
+#endif
+
     /* Privates used by multi-window */
     pthread_t ptWMProc;
     pthread_t ptXMsgProc;
@@ -481,6 +583,11 @@ typedef struct _winPrivScreenRec {
     SetShapeProcPtr SetShape;
     ModifyPixmapHeaderProcPtr ModifyPixmapHeader;
 
+    /* Wrapped procedures for DIB-backed pixmaps (Shadow GDI engine) */
+    CreateGCProcPtr CreateGC;
+    CreatePixmapProcPtr CreatePixmap;
+    DestroyPixmapProcPtr DestroyPixmap;
+
     winCursorRec cursor;
 
     Bool fNativeGlActive;
@@ -528,6 +635,7 @@ extern int g_patternROP[];
 extern const char *g_pszQueryHost;
 extern DeviceIntPtr g_pwinPointer;
 extern DeviceIntPtr g_pwinKeyboard;
+extern DeviceIntPtr g_pwinTouch;
 
 /*
  * Extern declares for dynamically loaded library function pointers
@@ -535,6 +643,7 @@ extern DeviceIntPtr g_pwinKeyboard;
 
 extern FARPROC g_fpDirectDrawCreate;
 extern FARPROC g_fpDirectDrawCreateClipper;
+extern FARPROC g_fpD3D11CreateDevice;
 
 /*
  * Screen privates macros
@@ -732,6 +841,9 @@ void
 int
  winTranslateKey(WPARAM wParam, LPARAM lParam);
 
+void
+ winInvalidateKeyMap(void);
+
 int
  winKeybdProc(DeviceIntPtr pDeviceInt, int iState);
 
@@ -775,6 +887,10 @@ CARD8
 Bool
  winUpdateFBPointer(ScreenPtr pScreen, void *pbits);
 
+void
+ winScaleDamageBox(winScreenInfo * pScreenInfo, BoxPtr pBox,
+                   RECT * prcSrc, RECT * prcDst);
+
 /*
  * winmouse.c
  */
@@ -796,6 +912,16 @@ winMouseButtonsHandle(ScreenPtr pScreen,
 void
  winEnqueueMotion(int x, int y);
 
+void
+ winEnqueueMotionRel(int dx, int dy);
+
+Bool
+ winMouseRawInputRegister(HWND hwnd);
+
+void
+ winMouseRawInputHandle(HWND hwnd, LPARAM lParam, int iXOffset, int iYOffset,
+                        int iScale);
+
 /*
  * winscrinit.c
  */
@@ -813,6 +939,53 @@ Bool
 Bool
  winSetEngineFunctionsShadowDDNL(ScreenPtr pScreen);
 
+/*
+ * winshaddxgi.c
+ */
+
+Bool
+ winSetEngineFunctionsShadowDXGI(ScreenPtr pScreen);
+
+int
+ winDxgiBindSharedPixmap(PixmapPtr pPixmap, CARD32 dwHandle);
+
+Bool
+ winCreateGCShadowDXGI(GCPtr pGC);
+
+Bool
+ winDestroyPixmapShadowDXGI(PixmapPtr pPixmap);
+
+Bool
+ winDxgiGetDevice(ScreenPtr pScreen, void **ppDevice, void **ppContext);
+
+/*
+ * winrender.c
+ */
+
+Bool
+ winRenderD3DWrap(ScreenPtr pScreen);
+
+void
+ winRenderD3DReleasePixmap(PixmapPtr pPixmap);
+
+void
+ winRenderD3DRelease(ScreenPtr pScreen);
+
+/*
+ * winshadparallel.c
+ */
+
+typedef struct _winParallelShadow *winParallelShadowPtr;
+
+winParallelShadowPtr
+ winParallelShadowInit(ScreenPtr pScreen);
+
+Bool
+ winParallelShadowUpdate(winParallelShadowPtr pShadow, RegionPtr prgnDamage);
+
+void
+ winParallelShadowFini(winParallelShadowPtr pShadow);
+
 /*
  * winshadgdi.c
  */
@@ -820,6 +993,16 @@ Bool
 Bool
  winSetEngineFunctionsShadowGDI(ScreenPtr pScreen);
 
+PixmapPtr
+winCreatePixmapShadowGDI(ScreenPtr pScreen, int width, int height, int depth,
+                         unsigned usage_hint);
+
+Bool
+ winDestroyPixmapShadowGDI(PixmapPtr pPixmap);
+
+Bool
+ winCreateGCShadowGDI(GCPtr pGC);
+
 /*
  * winwakeup.c
  */
@@ -938,6 +1121,19 @@ int
 LRESULT CALLBACK
 winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
 
+/*
+ * wintrace.c
+ */
+
+#define WIN_TRACE_PRESENT_GDI   1
+#define WIN_TRACE_PRESENT_DDNL  2
+
+Bool
+ winTraceInit(void);
+
+void
+ winTraceShadowPresent(int engine, int nBoxes, BoxPtr pExtents);
+
 /*
  * wintrayicon.c
  */
@@ -979,6 +1175,9 @@ void
 Bool
  winInitCursor(ScreenPtr pScreen);
 
+Bool
+ winInitHardwarePointer(ScreenPtr pScreen);
+
 /*
  * winprocarg.c
  */
@@ -997,12 +1196,50 @@ winGetDisplayName(char *szDisplay, unsigned int screen);
  */
 Bool
  winRandRInit(ScreenPtr pScreen);
+Bool
+ winRandRAddMonitor(ScreenPtr pScreen, int iMonitor,
+                    int x, int y, int w, int h, Bool fPrimary);
 void
 
 winDoRandRScreenSetSize(ScreenPtr pScreen,
                         CARD16 width,
                         CARD16 height, CARD32 mmWidth, CARD32 mmHeight);
 
+/*
+ * winpresent.c
+ */
+#ifdef PRESENT
+Bool
+ winPresentInit(ScreenPtr pScreen);
+#endif
+
+/*
+ * winvideo.c
+ */
+#ifdef XWIN_XV
+Bool
+ winInitVideo(ScreenPtr pScreen);
+#endif
+
+/*
+ * wintouch.c
+ */
+Bool
+ winTouchInit(void);
+
+Bool
+ winTouchProcessPointerMessage(HWND hwnd, UINT message, WPARAM wParam,
+                               LPARAM lParam, winScreenInfoPtr pScreenInfo);
+
+/*
+ * winplacement.c
+ */
+Bool
+ winPlacementQuery(WindowPtr pWin, RECT * prcFrame, DWORD *pdwShowCmd);
+
+void
+ winPlacementRemember(WindowPtr pWin, HWND hWnd);
+
 /*
  * winmsgwindow.c
  */
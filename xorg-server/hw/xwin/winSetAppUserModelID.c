@@ -64,13 +64,22 @@ RemoveWhitespaceAndTruncate(HWND hWnd, const char *AppID)
 void
 winPropertyStoreInit(void)
 {
+    static Bool fInitialized = FALSE;
+
     /*
        Load library and get function pointer to SHGetPropertyStoreForWindow()
 
        SHGetPropertyStoreForWindow is only supported since Windows 7. On previous
        versions the pointer will be NULL and taskbar grouping is not supported.
        winSetAppUserModelID() will do nothing in this case.
+
+       Called lazily from winSetAppUserModelID(), so sessions that never
+       group a taskbar entry do not pay for loading shell32 at startup.
      */
+    if (fInitialized)
+        return;
+    fInitialized = TRUE;
+
     g_hmodShell32Dll = LoadLibrary("shell32.dll");
     if (g_hmodShell32Dll == NULL) {
         ErrorF("winPropertyStoreInit - Could not load shell32.dll\n");
@@ -104,6 +113,8 @@ winSetAppUserModelID(HWND hWnd, const char *AppID)
     IPropertyStore *pps = NULL;
     HRESULT hr;
 
+    winPropertyStoreInit();
+
     if (g_pSHGetPropertyStoreForWindow == NULL) {
         return;
     }
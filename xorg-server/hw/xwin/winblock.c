@@ -50,10 +50,11 @@ winBlockHandler(ScreenPtr pScreen, void *pTimeout)
         */
         *(int*)pTimeout = 0;
       }
-      else {
+      else if (!xserver_poll_wakes_on_messages()) {
         /* Otherwise, lacking /dev/windows, we must wake up again in
            a reasonable time to check the Windows message queue. without
-           noticeable delay.
+           noticeable delay.  Not needed when the wait itself wakes on
+           message queue input.
          */
         *(int*)pTimeout = 1;
       }
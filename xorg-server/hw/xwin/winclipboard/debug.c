@@ -26,6 +26,10 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+/* stands in for the server's copy when building standalone; the
+ * winmsg.h logging macros pre-filter on it */
+int LogEffectiveVerbosity = 3;
+
 #if 1
 int
 winDebug(const char *format, ...)
@@ -90,6 +90,13 @@ void
 void
  winClipboardUNIXtoDOS(char **ppszData, int iLength);
 
+wchar_t
+ *winClipboardTextToUnicode(UINT codepage, const char *pszSource);
+
+char
+ *winClipboardWideToText(UINT codepage, const wchar_t *pwszSource,
+                         int *piLength);
+
 /*
  * winclipboardthread.c
  */
@@ -129,6 +136,7 @@ typedef struct
   xcb_atom_t *targetList;
   unsigned char *incr;
   unsigned long int incrsize;
+  unsigned long int incralloc;
 } ClipboardConversionData;
 
 int
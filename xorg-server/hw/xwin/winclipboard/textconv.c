@@ -33,8 +33,36 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include "internal.h"
 
+/*
+ * Reused conversion scratch buffers
+ *
+ * The clipboard integration runs on its own single thread, so the
+ * converted text can live in buffers owned by this module: each helper
+ * grows its buffer as needed and hands back a pointer which stays valid
+ * until the next call to the same helper.  This avoids a malloc/free
+ * pair, and a second sizing-only conversion pass, on every paste.
+ */
+
+static wchar_t *g_pwszScratchWide = NULL;
+static int g_iScratchWideLen = 0;       /* capacity in wchar_t units */
+
+static char *g_pszScratchText = NULL;
+static int g_iScratchTextLen = 0;       /* capacity in bytes */
+
+/*
+ * Cache of the last Unicode-to-text conversion.  The Windows clipboard
+ * sequence number changes whenever the clipboard contents change, so
+ * while it and the code page match, g_pszScratchText still holds the
+ * right answer and repeated pastes of the same contents are free.
+ */
+
+static DWORD g_dwCacheSequence = 0;
+static UINT g_uiCacheCodepage = 0;
+static int g_iCacheLength = -1; /* -1 means nothing cached */
+
 /*
  * Convert \r\n to \n
  *
@@ -140,3 +168,103 @@ winClipboardUNIXtoDOS(char **ppszData, int iLength)
 
     winDebug("UNIXtoDOS () - Final string:'%s'\n", pszDestBegin);
 }
+
+/*
+ * Convert a null-terminated string in the given code page to UTF-16 in
+ * a single pass.
+ *
+ * The worst case is one UTF-16 unit per source byte (plus the
+ * terminator), so the buffer is sized up front instead of making a
+ * separate MultiByteToWideChar sizing call.  Returns a pointer into the
+ * module-owned scratch buffer, valid until the next call; the caller
+ * must not free it.  Returns NULL on conversion failure.
+ */
+
+wchar_t *
+winClipboardTextToUnicode(UINT codepage, const char *pszSource)
+{
+    int iSourceLen = strlen(pszSource) + 1;
+    int iWideLen;
+
+    /* Grow the scratch buffer to the worst-case size */
+    if (iSourceLen > g_iScratchWideLen) {
+        wchar_t *pwszNew = realloc(g_pwszScratchWide,
+                                   sizeof(wchar_t) * iSourceLen);
+
+        if (!pwszNew)
+            return NULL;
+        g_pwszScratchWide = pwszNew;
+        g_iScratchWideLen = iSourceLen;
+    }
+
+    /* Convert directly into the scratch buffer */
+    iWideLen = MultiByteToWideChar(codepage, 0, pszSource, -1,
+                                   g_pwszScratchWide, g_iScratchWideLen);
+    if (iWideLen == 0)
+        return NULL;
+
+    return g_pwszScratchWide;
+}
+
+/*
+ * Convert a null-terminated UTF-16 string to the given code page and
+ * normalize the line endings to UNIX convention, in a single pass.
+ *
+ * The worst case for the code pages we use is three bytes per UTF-16
+ * unit (a BMP character needs up to three UTF-8 bytes; a surrogate pair
+ * is two units for four bytes), so the buffer is sized up front instead
+ * of making a separate WideCharToMultiByte sizing call.  The result is
+ * cached against the Windows clipboard sequence number, which changes
+ * whenever the clipboard contents do, so converting the same contents
+ * repeatedly only pays for the first conversion.
+ *
+ * Returns a pointer into the module-owned scratch buffer, valid until
+ * the next call, with the string length stored through piLength; the
+ * caller must not free it.  Returns NULL on conversion failure.
+ */
+
+char *
+winClipboardWideToText(UINT codepage, const wchar_t *pwszSource,
+                       int *piLength)
+{
+    DWORD dwSequence = GetClipboardSequenceNumber();
+    int iSourceLen;
+    int iTextLen;
+
+    /* Reuse the previous conversion if the clipboard hasn't changed */
+    if (g_iCacheLength >= 0
+        && dwSequence == g_dwCacheSequence && codepage == g_uiCacheCodepage) {
+        *piLength = g_iCacheLength;
+        return g_pszScratchText;
+    }
+    g_iCacheLength = -1;
+
+    /* Grow the scratch buffer to the worst-case size */
+    iSourceLen = wcslen(pwszSource);
+    if (3 * iSourceLen + 1 > g_iScratchTextLen) {
+        char *pszNew = realloc(g_pszScratchText, 3 * iSourceLen + 1);
+
+        if (!pszNew)
+            return NULL;
+        g_pszScratchText = pszNew;
+        g_iScratchTextLen = 3 * iSourceLen + 1;
+    }
+
+    /* Convert directly into the scratch buffer */
+    iTextLen = WideCharToMultiByte(codepage, 0, pwszSource, -1,
+                                   g_pszScratchText, g_iScratchTextLen,
+                                   NULL, NULL);
+    if (iTextLen == 0)
+        return NULL;
+
+    /* Convert DOS string to UNIX string */
+    winClipboardDOStoUNIX(g_pszScratchText, iTextLen - 1);
+
+    /* Remember what the scratch buffer holds */
+    g_dwCacheSequence = dwSequence;
+    g_uiCacheCodepage = codepage;
+    g_iCacheLength = strlen(g_pszScratchText);
+
+    *piLength = g_iCacheLength;
+    return g_pszScratchText;
+}
@@ -78,6 +78,7 @@ winProcessXEventsTimeout(HWND hwnd, xcb_window_t iWindow, xcb_connection_t *conn
     struct timeval tv;
     int iReturn;
     long endTime;
+    unsigned long lastIncrSize = 0;
 
     winDebug("winProcessXEventsTimeout () - pumping X events, timeout %d seconds\n",
              iTimeoutSec);
@@ -101,6 +102,17 @@ winProcessXEventsTimeout(HWND hwnd, xcb_window_t iWindow, xcb_connection_t *conn
           return iReturn;
         }
 
+        /*
+         * An INCR transfer only times out when the data stops flowing:
+         * the deadline is pushed back for every chunk received, so a
+         * transfer which is many times larger than the timeout allows
+         * for still completes.
+         */
+        if (data->incrsize != lastIncrSize) {
+            lastIncrSize = data->incrsize;
+            endTime = GetTimeInMillis() + iTimeoutSec * 1000;
+        }
+
         /* We need to ensure that all pending requests are sent */
         xcb_flush(conn);
 
@@ -349,6 +361,7 @@ winClipboardWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         /* Process X events */
         data.incr = NULL;
         data.incrsize = 0;
+        data.incralloc = 0;
 
         iReturn = winProcessXEventsTimeout(hwnd,
                                            iWindow,
@@ -255,8 +255,13 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
     if (encoding == atoms->atomIncr) {
         winDebug("winClipboardSelectionNotifyData: starting INCR, anticipated size %d\n", *(int *)value);
         data->incrsize = 0;
-        data->incr = malloc(*(int *)value);
-        // XXX: if malloc failed, we have an error
+        data->incralloc = *(uint32_t *)value;
+        if (data->incralloc < 64 * 1024)
+            data->incralloc = 64 * 1024;
+        data->incr = malloc(data->incralloc);
+        if (!data->incr)
+            data->incralloc = 0;        /* grow from the first chunk instead */
+        free(reply);
         return WIN_XEVENTS_SUCCESS;
     }
     else if (data->incr) {
@@ -272,11 +277,35 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
             xtpText_nitems = data->incrsize;
         }
         else {
-            /* Otherwise, continue appending the INCR data */
+            /* Otherwise, continue appending the INCR data.  The buffer is
+               grown geometrically: the selection owner is already writing
+               the next chunk while we append this one, and reallocating
+               for every chunk would make large transfers quadratic */
             winDebug("winClipboardSelectionNotifyData: INCR, %ld bytes\n", nitems);
-            data->incr = realloc(data->incr, data->incrsize + nitems);
+            if (data->incrsize + nitems > data->incralloc) {
+                unsigned char *incr;
+
+                do {
+                    data->incralloc =
+                        data->incralloc ? data->incralloc * 2 : 64 * 1024;
+                } while (data->incrsize + nitems > data->incralloc);
+                incr = realloc(data->incr, data->incralloc);
+                if (!incr) {
+                    ErrorF("winClipboardSelectionNotifyData: out of memory "
+                           "growing INCR buffer to %ld bytes, aborting transfer\n",
+                           data->incralloc);
+                    free(data->incr);
+                    data->incr = NULL;
+                    data->incrsize = 0;
+                    data->incralloc = 0;
+                    free(reply);
+                    return WIN_XEVENTS_FAILED;
+                }
+                data->incr = incr;
+            }
             memcpy(data->incr + data->incrsize, value, nitems);
             data->incrsize = data->incrsize + nitems;
+            free(reply);
             return WIN_XEVENTS_SUCCESS;
         }
     }
@@ -317,28 +346,25 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
         free(data->incr);
         data->incr = NULL;
         data->incrsize = 0;
+        data->incralloc = 0;
     }
 
     /* Convert the X clipboard string to DOS format */
     winClipboardUNIXtoDOS(&pszReturnData, strlen(pszReturnData));
 
-    /* Find out how much space needed when converted to UTF-16 */
-    int iUnicodeLen = MultiByteToWideChar(codepage, 0,
-                                          pszReturnData, -1, NULL, 0);
-
-    /* NOTE: iUnicodeLen includes space for null terminator */
-    pwszUnicodeStr = malloc(sizeof(wchar_t) * iUnicodeLen);
+    /* Convert to UTF-16 in a single pass into the reused scratch buffer;
+       the result is owned by textconv.c, so it must not be freed here */
+    pwszUnicodeStr = winClipboardTextToUnicode(codepage, pszReturnData);
     if (!pwszUnicodeStr) {
         ErrorF("winClipboardFlushXEvents - SelectionNotify "
-               "malloc failed for pwszUnicodeStr, aborting.\n");
+               "conversion to UTF-16 failed, aborting.\n");
 
         /* Abort */
         goto winClipboardFlushXEvents_SelectionNotify_Done;
     }
 
-    /* Do the actual conversion */
-    MultiByteToWideChar(codepage, 0,
-                        pszReturnData, -1, pwszUnicodeStr, iUnicodeLen);
+    /* NOTE: iUnicodeLen includes space for null terminator */
+    int iUnicodeLen = wcslen(pwszUnicodeStr) + 1;
 
     /* Allocate global memory for the X clipboard data */
     hGlobal = GlobalAlloc(GMEM_MOVEABLE, sizeof(wchar_t) * iUnicodeLen);
@@ -366,8 +392,6 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
 
     /* Copy the returned string into the global memory */
     wcscpy((wchar_t *)pszGlobalData, pwszUnicodeStr);
-    free(pwszUnicodeStr);
-    pwszUnicodeStr = NULL;
 
     /* Release the pointer to the global memory */
     GlobalUnlock(hGlobal);
@@ -386,7 +410,6 @@ winClipboardSelectionNotifyData(HWND hwnd, xcb_window_t iWindow, xcb_connection_
 
  winClipboardFlushXEvents_SelectionNotify_Done:
     /* Free allocated resources */
-    free(pwszUnicodeStr);
     if (hGlobal && pszGlobalData)
         GlobalUnlock(hGlobal);
     if (fSetClipboardData) {
@@ -415,7 +438,6 @@ winClipboardFlushXEvents(HWND hwnd,
     while ((event = xcb_poll_for_event(conn))) {
         const char *pszGlobalData = NULL;
         HGLOBAL hGlobal = NULL;
-        char *pszConvertData = NULL;
         BOOL fAbort = FALSE;
         BOOL fCloseClipboard = FALSE;
 
@@ -559,31 +581,38 @@ winClipboardFlushXEvents(HWND hwnd,
             pszGlobalData = (char *) GlobalLock(hGlobal);
 
             /* Convert to target string style */
-            if (selection_request->target == XCB_ATOM_STRING) {
-                codepage = CP_ISO_8559_1; // code page identifier for iso-8559-1
-            } else if (selection_request->target == atomUTF8String) {
-                codepage = CP_UTF8; // code page identifier for utf8
-            } else if (selection_request->target == atomCompoundText) {
+            if (selection_request->target == atomCompoundText) {
                 // COMPOUND_TEXT is complex, not (yet) implemented
-                pszGlobalData = "COMPOUND_TEXT not implemented";
-                codepage = CP_UTF8; // code page identifier for utf8
-            }
+                static char szCompoundText[] = "COMPOUND_TEXT not implemented";
 
-            /* Convert the UTF16 string to required encoding */
-            int iConvertDataLen = WideCharToMultiByte(codepage, 0,
-                                                      (LPCWSTR) pszGlobalData, -1,
-                                                      NULL, 0, NULL, NULL);
-            /* NOTE: iConvertDataLen includes space for null terminator */
-            pszConvertData = malloc(iConvertDataLen);
-            WideCharToMultiByte(codepage, 0,
-                                (LPCWSTR) pszGlobalData, -1,
-                                pszConvertData, iConvertDataLen, NULL, NULL);
+                xtpText_value = szCompoundText;
+                xtpText_nitems = strlen(szCompoundText);
+            }
+            else {
+                if (selection_request->target == XCB_ATOM_STRING) {
+                    codepage = CP_ISO_8559_1; // code page identifier for iso-8559-1
+                } else { // atomUTF8String
+                    codepage = CP_UTF8; // code page identifier for utf8
+                }
 
-            /* Convert DOS string to UNIX string */
-            winClipboardDOStoUNIX(pszConvertData, strlen(pszConvertData));
+                /* Convert the UTF16 string to the required encoding, with
+                   line endings normalized, in a single pass.  The result
+                   lives in a scratch buffer owned by textconv.c and is
+                   cached against the clipboard sequence number, so pasting
+                   the same contents repeatedly only converts once; it must
+                   not be freed here */
+                xtpText_value = winClipboardWideToText(codepage,
+                                                       (LPCWSTR) pszGlobalData,
+                                                       &xtpText_nitems);
+                if (!xtpText_value) {
+                    ErrorF("winClipboardFlushXEvents - SelectionRequest - "
+                           "conversion from UTF-16 failed\n");
 
-            xtpText_value = strdup(pszConvertData);
-            xtpText_nitems = strlen(pszConvertData);
+                    /* Abort */
+                    fAbort = TRUE;
+                    goto winClipboardFlushXEvents_SelectionRequest_Done;
+                }
+            }
 
             /* data will fit into a single X request? (INCR not yet supported) */
             {
@@ -619,20 +648,12 @@ winClipboardFlushXEvents(HWND hwnd,
                 goto winClipboardFlushXEvents_SelectionRequest_Done;
             }
 
-            /* Free the converted string */
-            free(pszConvertData);
-            pszConvertData = NULL;
-
             /* Release the clipboard data */
             GlobalUnlock(hGlobal);
             pszGlobalData = NULL;
             fCloseClipboard = FALSE;
             CloseClipboard();
 
-            /* Clean up */
-            free(xtpText_value);
-            xtpText_value = NULL;
-
             /* Setup selection notify event */
             xcb_selection_notify_event_t eventSelection;
             eventSelection.response_type = XCB_SELECTION_NOTIFY;
@@ -657,11 +678,6 @@ winClipboardFlushXEvents(HWND hwnd,
 
  winClipboardFlushXEvents_SelectionRequest_Done:
             /* Free allocated resources */
-            if (xtpText_value) {
-                free(xtpText_value);
-            }
-            if (pszConvertData)
-                free(pszConvertData);
             if (hGlobal && pszGlobalData)
                 GlobalUnlock(hGlobal);
 
@@ -727,14 +743,21 @@ winClipboardFlushXEvents(HWND hwnd,
                     ErrorF("winClipboardFlushXEvents - SelectionNotify - "
                            "Conversion to format %d refused.\n",
                            selection_notify->target);
+                    free(event);
                     return WIN_XEVENTS_FAILED;
                 }
 
             if (selection_notify->target == atomTargets) {
-              return winClipboardSelectionNotifyTargets(hwnd, iWindow, conn, data, atoms);
+              int iReturn = winClipboardSelectionNotifyTargets(hwnd, iWindow, conn, data, atoms);
+              free(event);
+              return iReturn;
             }
 
-            return winClipboardSelectionNotifyData(hwnd, iWindow, conn, data, atoms);
+            {
+                int iReturn = winClipboardSelectionNotifyData(hwnd, iWindow, conn, data, atoms);
+                free(event);
+                return iReturn;
+            }
         }
 
         case XCB_SELECTION_CLEAR:
@@ -748,8 +771,11 @@ winClipboardFlushXEvents(HWND hwnd,
             /* If INCR is in progress, collect the data */
             if (data->incr &&
                 (property_notify->atom == atoms->atomLocalProperty) &&
-                (property_notify->state == XCB_PROPERTY_NEW_VALUE))
-                return winClipboardSelectionNotifyData(hwnd, iWindow, conn, data, atoms);
+                (property_notify->state == XCB_PROPERTY_NEW_VALUE)) {
+                int iReturn = winClipboardSelectionNotifyData(hwnd, iWindow, conn, data, atoms);
+                free(event);
+                return iReturn;
+            }
 
             break;
         }
@@ -840,6 +866,9 @@ winClipboardFlushXEvents(HWND hwnd,
             break;
         }
 
+        /* Events are malloc'd by xcb and owned by us once polled */
+        free(event);
+
         /* I/O errors etc. */
         {
             int e = xcb_connection_has_error(conn);
@@ -185,6 +185,7 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
     winScreenPriv(pScreen);
     winCmapPriv(pmap);
     int i;
+    int iFirst = -1, iLast = -1;
     unsigned short nRed, nGreen, nBlue;
 
 #ifdef WINDBG
@@ -199,6 +200,18 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
         nGreen = pdefs[i].green >> 8;
         nBlue = pdefs[i].blue >> 8;
 
+        /* Skip cells that already hold these colors; palette-animating
+           clients often rewrite cells with unchanged values and those
+           must not cost a device palette update */
+        if (pCmapPriv->peColors[pdefs[0].pixel + i].peRed == nRed
+            && pCmapPriv->peColors[pdefs[0].pixel + i].peGreen == nGreen
+            && pCmapPriv->peColors[pdefs[0].pixel + i].peBlue == nBlue)
+            continue;
+
+        if (iFirst < 0)
+            iFirst = i;
+        iLast = i;
+
         /* Copy the colors to a palette entry table */
         pCmapPriv->peColors[pdefs[0].pixel + i].peRed = nRed;
         pCmapPriv->peColors[pdefs[0].pixel + i].peGreen = nGreen;
@@ -213,8 +226,16 @@ winStoreColors(ColormapPtr pmap, int ndef, xColorItem * pdefs)
                  nRed, nGreen, nBlue);
     }
 
-    /* Call the engine specific store colors procedure */
-    if (!((pScreenPriv->pwinStoreColors) (pmap, ndef, pdefs))) {
+    /* Nothing actually changed, no need to touch the device palette */
+    if (iFirst < 0)
+        return;
+
+    /* Call the engine specific store colors procedure for the changed
+       range only.  The engine procedures translate from pdefs[0].pixel,
+       which assumes the cells are contiguous, as they are when coming
+       from ProcStoreColors. */
+    if (!((pScreenPriv->pwinStoreColors) (pmap, iLast - iFirst + 1,
+                                          pdefs + iFirst))) {
         ErrorF ("winStoreColors - Engine cpecific color storage procedure "
                 "failed.  Continuing, but colors may be messed up from now "
                 "on.\n");
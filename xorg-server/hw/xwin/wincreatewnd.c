@@ -211,6 +211,10 @@ winCreateBoundingWindowWindowed(ScreenPtr pScreen)
         pScreenInfo->iResizeMode = resizeNotAllowed;
     }
 
+    /* The client area is dwScale percent of the requested X visual size */
+    iWidth = winScaleToDeviceCeil(pScreenInfo, iWidth);
+    iHeight = winScaleToDeviceCeil(pScreenInfo, iHeight);
+
     /* Did the user specify a height and width? */
     if (pScreenInfo->fUserGaveHeightAndWidth) {
         /* User gave a desired height and width, try to accommodate */
@@ -339,8 +343,12 @@ winCreateBoundingWindowWindowed(ScreenPtr pScreen)
          * than the viewport size that we calculated by subtracting
          * the size of the borders and caption.
          */
-        pScreenInfo->dwWidth = rcClient.right - rcClient.left;
-        pScreenInfo->dwHeight = rcClient.bottom - rcClient.top;
+        pScreenInfo->dwWidth = winScaleToLogical(pScreenInfo,
+                                                 rcClient.right -
+                                                 rcClient.left);
+        pScreenInfo->dwHeight = winScaleToLogical(pScreenInfo,
+                                                  rcClient.bottom -
+                                                  rcClient.top);
     }
 
 #if 0
@@ -424,6 +424,82 @@ winLoadCursor(ScreenPtr pScreen, CursorPtr pCursor, int screen)
 ===========================================================================
 */
 
+/*
+ * Cursor conversion cache.  winLoadCursor does a per-pixel conversion
+ * of the X cursor image, and animated cursors (render/animcur.c)
+ * change the sprite every frame, so converted HCURSORs are kept in a
+ * small per-screen LRU cache keyed on CursorPtr and serial number.
+ * After the first animation cycle every frame is a cache hit.
+ */
+
+static HCURSOR
+winCursorCacheLookup(winPrivScreenPtr pScreenPriv, CursorPtr pCursor)
+{
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; i++) {
+        if ((pScreenPriv->cursor.cache[i].pCursor == pCursor) &&
+            (pScreenPriv->cursor.cache[i].dwSerial == pCursor->serialNumber)) {
+            pScreenPriv->cursor.cache[i].ulLastUsed =
+                ++pScreenPriv->cursor.ulCacheTick;
+            return pScreenPriv->cursor.cache[i].hCursor;
+        }
+    }
+    return NULL;
+}
+
+static void
+winCursorCacheInsert(winPrivScreenPtr pScreenPriv, CursorPtr pCursor,
+                     HCURSOR hCursor)
+{
+    int i, iVictim = -1;
+    unsigned long ulOldest = 0;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; i++) {
+        if (pScreenPriv->cursor.cache[i].hCursor == NULL) {
+            iVictim = i;
+            break;
+        }
+        /* Never evict the cursor currently being displayed */
+        if (pScreenPriv->cursor.cache[i].hCursor == pScreenPriv->cursor.handle)
+            continue;
+        if ((iVictim < 0) ||
+            (pScreenPriv->cursor.cache[i].ulLastUsed < ulOldest)) {
+            iVictim = i;
+            ulOldest = pScreenPriv->cursor.cache[i].ulLastUsed;
+        }
+    }
+    if (iVictim < 0)
+        return;
+    if (pScreenPriv->cursor.cache[iVictim].hCursor != NULL)
+        DestroyCursor(pScreenPriv->cursor.cache[iVictim].hCursor);
+    pScreenPriv->cursor.cache[iVictim].pCursor = pCursor;
+    pScreenPriv->cursor.cache[iVictim].dwSerial = pCursor->serialNumber;
+    pScreenPriv->cursor.cache[iVictim].hCursor = hCursor;
+    pScreenPriv->cursor.cache[iVictim].ulLastUsed =
+        ++pScreenPriv->cursor.ulCacheTick;
+}
+
+static void
+winCursorCacheRemove(winPrivScreenPtr pScreenPriv, CursorPtr pCursor)
+{
+    int i;
+
+    for (i = 0; i < WIN_CURSOR_CACHE_SIZE; i++) {
+        if (pScreenPriv->cursor.cache[i].pCursor != pCursor)
+            continue;
+        if (pScreenPriv->cursor.cache[i].hCursor ==
+            pScreenPriv->cursor.handle) {
+            SetCursor(NULL);
+            pScreenPriv->cursor.handle = NULL;
+        }
+        DestroyCursor(pScreenPriv->cursor.cache[i].hCursor);
+        pScreenPriv->cursor.cache[i].pCursor = NULL;
+        pScreenPriv->cursor.cache[i].hCursor = NULL;
+        pScreenPriv->cursor.cache[i].ulLastUsed = 0;
+    }
+}
+
 /*
  * winRealizeCursor
  *  Convert the X cursor representation to native format if possible.
@@ -446,6 +522,10 @@ winRealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
 static Bool
 winUnrealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
 {
+    winScreenPriv(pScreen);
+
+    /* Drop any converted copies before the CursorRec can be reused */
+    winCursorCacheRemove(pScreenPriv, pCursor);
     return TRUE;
 }
 
@@ -497,15 +577,17 @@ winSetCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor, int x,
         }
     }
     else {
-        if (pScreenPriv->cursor.handle) {
-            if (!bInhibit)
-                SetCursor(NULL);
-            DestroyCursor(pScreenPriv->cursor.handle);
-            pScreenPriv->cursor.handle = NULL;
+        HCURSOR hCursor = winCursorCacheLookup(pScreenPriv, pCursor);
+
+        if (hCursor == NULL) {
+            hCursor = winLoadCursor(pScreen, pCursor, pScreen->myNum);
+            if (hCursor != NULL)
+                winCursorCacheInsert(pScreenPriv, pCursor, hCursor);
         }
-        pScreenPriv->cursor.handle =
-            winLoadCursor(pScreen, pCursor, pScreen->myNum);
-        winDebug("winSetCursor: handle=%p\n", pScreenPriv->cursor.handle); 
+        /* The cache owns the handle, so the previous one is not
+           destroyed here; it stays warm for the next frame */
+        pScreenPriv->cursor.handle = hCursor;
+        winDebug("winSetCursor: handle=%p\n", pScreenPriv->cursor.handle);
 
         if (!bInhibit)
             SetCursor(pScreenPriv->cursor.handle);
@@ -550,6 +632,74 @@ static miPointerSpriteFuncRec winSpriteFuncsRec = {
     winDeviceCursorCleanup
 };
 
+/*
+ * Placeholder sprite functions registered with mi when the Windows
+ * hardware cursor is in use.  They are replaced by winSpriteFuncsRec in
+ * winInitCursor() and only serve as the chained-to layer; nothing is
+ * ever rendered into the frame buffer for the sprite.
+ */
+
+static Bool
+winNullRealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
+{
+    return TRUE;
+}
+
+static Bool
+winNullUnrealizeCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
+{
+    return TRUE;
+}
+
+static void
+winNullSetCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor,
+                 int x, int y)
+{
+}
+
+static void
+winNullMoveCursor(DeviceIntPtr pDev, ScreenPtr pScreen, int x, int y)
+{
+}
+
+static Bool
+winNullDeviceCursorInitialize(DeviceIntPtr pDev, ScreenPtr pScr)
+{
+    return TRUE;
+}
+
+static void
+winNullDeviceCursorCleanup(DeviceIntPtr pDev, ScreenPtr pScr)
+{
+}
+
+static miPointerSpriteFuncRec winNullSpriteFuncsRec = {
+    winNullRealizeCursor,
+    winNullUnrealizeCursor,
+    winNullSetCursor,
+    winNullMoveCursor,
+    winNullDeviceCursorInitialize,
+    winNullDeviceCursorCleanup
+};
+
+/*
+ * winInitHardwarePointer
+ *  Register the pointer with mi without the miDCInitialize()/misprite
+ *  software-sprite layer.  The cursor is composited by Windows, so the
+ *  save-under and damage machinery that misprite sets up would only add
+ *  a sprite-intersection test to every rendering operation.  The Win32
+ *  sprite functions are installed later by winInitCursor().
+ */
+Bool
+winInitHardwarePointer(ScreenPtr pScreen)
+{
+    /* The Windows cursor moves itself, so there is no reason to defer
+     * sprite updates to the block handler.
+     */
+    return miPointerInitialize(pScreen, &winNullSpriteFuncsRec,
+                               &g_winPointerCursorFuncs, FALSE);
+}
+
 /*
 ===========================================================================
 
@@ -604,6 +754,9 @@ winInitCursor(ScreenPtr pScreen)
     pScreenPriv->cursor.handle = NULL;
     pScreenPriv->cursor.visible = FALSE;
 
+    ZeroMemory(pScreenPriv->cursor.cache, sizeof(pScreenPriv->cursor.cache));
+    pScreenPriv->cursor.ulCacheTick = 0;
+
     pScreenPriv->cursor.sm_cx = GetSystemMetrics(SM_CXCURSOR);
     pScreenPriv->cursor.sm_cy = GetSystemMetrics(SM_CYCURSOR);
 
@@ -40,23 +40,74 @@
  */
 FARPROC g_fpDirectDrawCreate = NULL;
 FARPROC g_fpDirectDrawCreateClipper = NULL;
+FARPROC g_fpD3D11CreateDevice = NULL;
 
 /*
   module handle for dynamically loaded directdraw library
 */
 static HMODULE g_hmodDirectDraw = NULL;
 
+/*
+  module handles for dynamically loaded d3d11/dxgi libraries
+*/
+static HMODULE g_hmodD3D11 = NULL;
+static HMODULE g_hmodDXGI = NULL;
+
+/*
+  whether the display driver advertises an accelerated blitter;
+  assume it does until the DirectDraw caps probe says otherwise
+*/
+static Bool g_fAcceleratedBlt = TRUE;
+
+#ifndef SM_REMOTESESSION
+#define SM_REMOTESESSION 0x1000
+#endif
+
 /*
  * Detect engines supported by current Windows version
  * DirectDraw version and hardware
+ *
+ * Called lazily from winSetEngine the first time an engine decision
+ * actually needs the probe results: loading ddraw/d3d11/dxgi and
+ * creating a probe DirectDraw object costs a measurable slice of cold
+ * start, and sessions that settle on ShadowGDI early (multiwindow,
+ * windowed PseudoColor, -engine 1) never need any of it.
  */
 
 void
 winDetectSupportedEngines(void)
 {
+    static Bool fDetected = FALSE;
+
+    if (fDetected)
+        return;
+    fDetected = TRUE;
+
+    /* Load the DirectDraw entry points the probe and DDNL engine use */
+    winGetDDProcAddresses();
+
     /* Initialize the engine support flags */
     g_dwEnginesSupported = WIN_SERVER_SHADOW_GDI;
 
+    /*
+     * Do we have D3D11 and a DXGI 1.2 factory?  Flip-model presentation
+     * needs CreateDXGIFactory1 plus the Win8+ swapchain entry points;
+     * probing for CreateDXGIFactory2 is the conventional way to detect
+     * a DXGI 1.2 runtime without creating a device.
+     */
+    g_hmodD3D11 = LoadLibraryEx("d3d11.dll", NULL, 0);
+    g_hmodDXGI = LoadLibraryEx("dxgi.dll", NULL, 0);
+    if (g_hmodD3D11 != NULL && g_hmodDXGI != NULL) {
+        g_fpD3D11CreateDevice = GetProcAddress(g_hmodD3D11,
+                                               "D3D11CreateDevice");
+        if (g_fpD3D11CreateDevice != NULL
+            && GetProcAddress(g_hmodDXGI, "CreateDXGIFactory2") != NULL) {
+            winDebug (
+                      "winDetectSupportedEngines - D3D11 with DXGI 1.2 installed, allowing ShadowDXGI\n");
+            g_dwEnginesSupported |= WIN_SERVER_SHADOW_DXGI;
+        }
+    }
+
     /* Do we have DirectDraw? */
     if (g_hmodDirectDraw != NULL) {
         LPDIRECTDRAW lpdd = NULL;
@@ -84,10 +135,27 @@ winDetectSupportedEngines(void)
                                             &IID_IDirectDraw4,
                                             (LPVOID *) &lpdd4);
         if (SUCCEEDED(ddrval)) {
+            DDCAPS ddcaps;
+
             /* We have DirectDraw4 */
             winDebug (
                       "winDetectSupportedEngines - DirectDraw4 installed, allowing ShadowDDNL\n");
             g_dwEnginesSupported |= WIN_SERVER_SHADOW_DDNL;
+
+            /*
+             * Ask the driver whether blits are actually accelerated.
+             * Without DDCAPS_BLT in the HAL caps every DirectDraw blit
+             * is emulated on top of GDI, so the DDNL/DXGI engines only
+             * add an extra copy per update.
+             */
+            ZeroMemory(&ddcaps, sizeof(ddcaps));
+            ddcaps.dwSize = sizeof(ddcaps);
+            ddrval = IDirectDraw4_GetCaps(lpdd4, &ddcaps, NULL);
+            if (SUCCEEDED(ddrval) && !(ddcaps.dwCaps & DDCAPS_BLT)) {
+                winDebug (
+                          "winDetectSupportedEngines - Driver has no accelerated blitter\n");
+                g_fAcceleratedBlt = FALSE;
+            }
         }
 
         /* Cleanup DirectDraw interfaces */
@@ -158,6 +226,10 @@ winSetEngine(ScreenPtr pScreen)
         return TRUE;
     }
 
+    /* Every remaining path consults the probe results or needs the
+       DirectDraw/D3D11 entry points loaded */
+    winDetectSupportedEngines();
+
   /* If there is a user's choice, we'll use that */
   if (pScreenInfo->dwEnginePreferred) {
         winDebug ("winSetEngine - Using user's preference: %d\n",
@@ -172,12 +244,49 @@ winSetEngine(ScreenPtr pScreen)
         case WIN_SERVER_SHADOW_DDNL:
             winSetEngineFunctionsShadowDDNL(pScreen);
             break;
+        case WIN_SERVER_SHADOW_DXGI:
+            winSetEngineFunctionsShadowDXGI(pScreen);
+            break;
         default:
             FatalError ("winSetEngine - Invalid engine type %d\n",pScreenInfo->dwEngine);
         }
         return TRUE;
     }
 
+    /*
+     * In a remote desktop session, or when the display driver has no
+     * accelerated blitter, the DirectDraw and DXGI paths degrade to a
+     * GDI emulation with an extra copy per update and plain ShadowGDI
+     * wins by a wide margin.  Pick it outright; -engine still forces
+     * any engine above.
+     */
+    if (GetSystemMetrics(SM_REMOTESESSION) || !g_fAcceleratedBlt) {
+        winDebug (
+                      "winSetEngine - Remote session or unaccelerated blits => ShadowGDI\n");
+        pScreenInfo->dwEngine = WIN_SERVER_SHADOW_GDI;
+
+        /* Set engine function pointers */
+        winSetEngineFunctionsShadowGDI(pScreen);
+        return TRUE;
+    }
+
+    /*
+     * ShadowDXGI presents damaged rects through a flip-model swapchain,
+     * which beats blitting the whole primary; it requires a 32 bpp
+     * desktop, as the swapchain back buffer is always BGRA8888.
+     */
+    if ((g_dwEnginesSupported & WIN_SERVER_SHADOW_DXGI)
+        && dwBPP == 32
+        && (pScreenInfo->dwBPP == WIN_DEFAULT_BPP
+            || pScreenInfo->dwBPP == 32)) {
+        winDebug ("winSetEngine - Using Shadow DXGI flip-model\n");
+        pScreenInfo->dwEngine = WIN_SERVER_SHADOW_DXGI;
+
+        /* Set engine function pointers */
+        winSetEngineFunctionsShadowDXGI(pScreen);
+        return TRUE;
+    }
+
     /* ShadowDDNL has good performance, so why not */
     if (g_dwEnginesSupported & WIN_SERVER_SHADOW_DDNL) {
         winDebug ("winSetEngine - Using Shadow DirectDraw NonLocking\n");
@@ -260,4 +369,13 @@ winReleaseDDProcAddresses(void)
         g_fpDirectDrawCreate = NULL;
         g_fpDirectDrawCreateClipper = NULL;
     }
+    if (g_hmodD3D11 != NULL) {
+        FreeLibrary(g_hmodD3D11);
+        g_hmodD3D11 = NULL;
+        g_fpD3D11CreateDevice = NULL;
+    }
+    if (g_hmodDXGI != NULL) {
+        FreeLibrary(g_hmodDXGI);
+        g_hmodDXGI = NULL;
+    }
 }
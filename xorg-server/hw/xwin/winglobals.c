@@ -77,8 +77,11 @@ DWORD g_dwCurrentThreadID = 0;
 Bool g_fKeyboardHookLL = FALSE;
 Bool g_fNoHelpMessageBox = FALSE;
 Bool g_fSoftwareCursor = FALSE;
+Bool g_fRawInput = FALSE;
+Bool g_fEtwTrace = FALSE;
 Bool g_fNativeGl = TRUE;
 Bool g_fswrastwgl = FALSE;
+const char *g_pszGLXDriver = NULL;
 Bool g_fHostInTitle = TRUE;
 pthread_mutex_t g_pmTerminating = PTHREAD_MUTEX_INITIALIZER;
 
@@ -104,6 +107,7 @@ const char WIN_WINDOW_PROP[]=     "vcxsrv_window_prop_rl";
 const char WIN_WID_PROP[]=        "vcxsrv_wid_prop_rl";
 const char WIN_NEEDMANAGE_PROP[]= "vcxsrv_override_redirect_prop_rl";
 const char WIN_STATE_PROP[]=      "vcxsrv_state_prop_rl";
+const char WIN_MAXIMIZE_PROP[]=   "vcxsrv_maximize_prop_rl";
 const char WIN_SCR_PROP[]=        "vcxsrv_screen_prop_rl";
 
 /*
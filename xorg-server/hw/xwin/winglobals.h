@@ -58,6 +58,7 @@ extern Bool g_fCompositeAlpha;
 extern Bool g_fNoHelpMessageBox;
 extern Bool g_fNativeGl;
 extern Bool g_fswrastwgl;
+extern const char *g_pszGLXDriver;
 extern Bool g_fHostInTitle;
 
 extern HWND g_hDlgDepthChange;
@@ -65,6 +66,8 @@ extern HWND g_hDlgExit;
 extern HWND g_hDlgAbout;
 
 extern Bool g_fSoftwareCursor;
+extern Bool g_fRawInput;
+extern Bool g_fEtwTrace;
 extern Bool g_fCursor;
 
 /* Typedef for DIX wrapper functions */
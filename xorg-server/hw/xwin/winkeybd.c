@@ -46,6 +46,33 @@
 
 static Bool g_winKeyState[NUM_KEYCODES];
 
+/*
+ * Flat translation tables, rebuilt when the keyboard layout changes.
+ *
+ * iKeyMapFlat is indexed by (extended flag << 8 | virtual key) and
+ * holds the fixed-up X scan code for the key, or 0 when the scan code
+ * from the message is used unchanged.  iVKScanCode holds the
+ * MapVirtualKeyEx result per virtual key, so the fallback for messages
+ * without a scan code does not call into Windows per keystroke.
+ *
+ * Layout changes rebuild the tables on a short-lived worker thread and
+ * publish the result by swapping g_pKeyMapTables, so the message thread
+ * never waits on the rebuild; it keeps translating from the old tables
+ * until the new ones appear.  Three table sets rotate so the worker
+ * never writes a set the message thread could still be reading: the set
+ * being built is always two publishes away from the set last unpublished.
+ */
+typedef struct {
+    int iKeyMapFlat[512];
+    int iVKScanCode[256];
+} winKeyMapTables;
+
+static winKeyMapTables g_KeyMapTables[3];
+static winKeyMapTables *volatile g_pKeyMapTables = NULL;
+static int g_iKeyMapTablesNext = 0;
+static LONG g_lKeyMapRebuildBusy = 0;
+static HKL volatile g_hklKeyMapPending = NULL;
+
 /*
  * Local prototypes
  */
@@ -56,6 +83,105 @@ static void
 static void
  winKeybdCtrl(DeviceIntPtr pDevice, KeybdCtrl * pCtrl);
 
+/*
+ * Build a set of flat translation tables from g_iKeyMap and the given
+ * keyboard layout.  hklLayout is passed in because GetKeyboardLayout
+ * is per-thread; the message thread captures it when the layout
+ * changes.
+ */
+
+static void
+winBuildKeyMapTables(winKeyMapTables * pTables, HKL hklLayout)
+{
+    int iVirtKey;
+
+    for (iVirtKey = 0; iVirtKey < 256; ++iVirtKey) {
+        int iKeyFixup = g_iKeyMap[iVirtKey * WIN_KEYMAP_COLS + 1];
+        int iKeyFixupEx = g_iKeyMap[iVirtKey * WIN_KEYMAP_COLS + 2];
+
+        pTables->iKeyMapFlat[iVirtKey] = iKeyFixup;
+        pTables->iKeyMapFlat[256 + iVirtKey] =
+            iKeyFixupEx ? iKeyFixupEx : iKeyFixup;
+        pTables->iVKScanCode[iVirtKey] = MapVirtualKeyEx(iVirtKey,
+                                                         /*MAPVK_VK_TO_VSC */ 0,
+                                                         hklLayout);
+    }
+}
+
+/*
+ * Build the next table set in the rotation and publish it.
+ */
+
+static void
+winPublishKeyMapTables(HKL hklLayout)
+{
+    winKeyMapTables *pNew = &g_KeyMapTables[g_iKeyMapTablesNext];
+
+    winBuildKeyMapTables(pNew, hklLayout);
+    g_iKeyMapTablesNext = (g_iKeyMapTablesNext + 1) % 3;
+    InterlockedExchangePointer((PVOID volatile *) &g_pKeyMapTables, pNew);
+}
+
+/*
+ * Worker thread: rebuild the tables for the most recently requested
+ * layout.  Loops so a layout change arriving during a rebuild is not
+ * lost, and re-claims the busy flag after dropping it in case a
+ * request slipped in between the last check and the release.
+ */
+
+static void *
+winKeyMapRebuildThreadProc(void *pArg)
+{
+    HKL hklLayout;
+
+    do {
+        while ((hklLayout =
+                InterlockedExchangePointer((PVOID volatile *)
+                                           &g_hklKeyMapPending,
+                                           NULL)) != NULL)
+            winPublishKeyMapTables(hklLayout);
+
+        InterlockedExchange(&g_lKeyMapRebuildBusy, 0);
+    } while (g_hklKeyMapPending != NULL
+             && InterlockedCompareExchange(&g_lKeyMapRebuildBusy, 1, 0) == 0);
+
+    return NULL;
+}
+
+/*
+ * Request a rebuild of the flat translation tables; called when the
+ * input language changes (WM_INPUTLANGCHANGE).  The rebuild runs on a
+ * worker thread; keystrokes in the meantime use the previous layout's
+ * tables rather than waiting.
+ */
+
+void
+winInvalidateKeyMap(void)
+{
+    pthread_t ptRebuild;
+
+    /* Nothing built yet; the first keystroke builds fresh tables */
+    if (g_pKeyMapTables == NULL)
+        return;
+
+    InterlockedExchangePointer((PVOID volatile *) &g_hklKeyMapPending,
+                               GetKeyboardLayout(0));
+
+    /* A running worker picks the request up from g_hklKeyMapPending */
+    if (InterlockedCompareExchange(&g_lKeyMapRebuildBusy, 1, 0) != 0)
+        return;
+
+    if (pthread_create(&ptRebuild, NULL, winKeyMapRebuildThreadProc, NULL)) {
+        ErrorF("winInvalidateKeyMap - pthread_create failed, "
+               "rebuilding keymap synchronously\n");
+        g_hklKeyMapPending = NULL;
+        winPublishKeyMapTables(GetKeyboardLayout(0));
+        InterlockedExchange(&g_lKeyMapRebuildBusy, 0);
+        return;
+    }
+    pthread_detach(ptRebuild);
+}
+
 /*
  * Translate a Windows WM_[SYS]KEY(UP/DOWN) message
  * into an ASCII scan code.
@@ -68,14 +194,19 @@ static void
 int
 winTranslateKey(WPARAM wParam, LPARAM lParam)
 {
-    int iKeyFixup = g_iKeyMap[wParam * WIN_KEYMAP_COLS + 1];
-    int iKeyFixupEx = g_iKeyMap[wParam * WIN_KEYMAP_COLS + 2];
     int iParam = HIWORD(lParam);
     int iParamScanCode = LOBYTE(iParam);
     int iScanCode;
+    winKeyMapTables *pTables;
 
     winDebug("winTranslateKey: wParam %08x lParam %08x\n", (int)wParam, (int)lParam);
 
+    /* First keystroke: build the initial tables in place */
+    if ((pTables = g_pKeyMapTables) == NULL) {
+        winPublishKeyMapTables(GetKeyboardLayout(0));
+        pTables = g_pKeyMapTables;
+    }
+
 /* WM_ key messages faked by Vista speech recognition (WSR) don't have a
  * scan code.
  *
@@ -90,19 +221,13 @@ winTranslateKey(WPARAM wParam, LPARAM lParam)
              * numbers instead of navigation keys. */
             iParam |= KF_EXTENDED;
         else
-            iParamScanCode = MapVirtualKeyEx(wParam,
-                                             /*MAPVK_VK_TO_VSC */ 0,
-                                             GetKeyboardLayout(0));
+            iParamScanCode = pTables->iVKScanCode[wParam & 0xff];
     }
 
-    /* Branch on special extended, special non-extended, or normal key */
-    if ((iParam & KF_EXTENDED) && iKeyFixupEx)
-        iScanCode = iKeyFixupEx;
-    else if (iKeyFixup)
-        iScanCode = iKeyFixup;
-    else if (wParam == 0 && iParamScanCode == 0x70)
-        iScanCode = KEY_HKTG;
-    else
+    /* One read covers the special extended and non-extended fixups */
+    iScanCode = pTables->iKeyMapFlat[((iParam & KF_EXTENDED) ? 256 : 0)
+                                     + (wParam & 0xff)];
+    if (!iScanCode)
         switch (iParamScanCode) {
         case 0x70:
             iScanCode = KEY_HKTG;
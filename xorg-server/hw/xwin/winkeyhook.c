@@ -98,9 +98,8 @@ winKeyboardMessageHookLL(int iCode, WPARAM wParam, LPARAM lParam)
     }
 
     /*
-     * Pass message on to our main message loop.
-     * We process this immediately with SendMessage so that the keystroke
-     * appears in, hopefully, the correct order.
+     * Enqueue the keystroke directly, or pass it on to our main
+     * message loop when we have no screen to check against.
      */
     if (fPassKeystroke) {
         LPARAM lParamKey = 0x0;
@@ -114,8 +113,29 @@ winKeyboardMessageHookLL(int iCode, WPARAM wParam, LPARAM lParam)
             | (0x20000000 & ((p->flags & LLKHF_ALTDOWN) << 24));
         lParamKey = lParamKey | (0x80000000 & ((p->flags & LLKHF_UP) << 24));
 
-        /* Send message to our main window that has the keyboard focus */
-        PostMessage(hwnd, (UINT) wParam, (WPARAM) p->vkCode, lParamKey);
+        if (pScreenInfo != NULL && !pScreenInfo->fIgnoreInput) {
+            /*
+             * The hook runs on the thread that pumps our message loop,
+             * so the key event can be enqueued right here instead of
+             * being posted to the window and translated on the next
+             * pass through the loop.
+             */
+            int iScanCode = winTranslateKey((WPARAM) p->vkCode, lParamKey);
+
+            if (p->flags & LLKHF_UP) {
+                winSendKeyEvent(iScanCode, FALSE);
+
+                /* Release all pressed shift keys */
+                if (p->vkCode == VK_SHIFT)
+                    winFixShiftKeys(iScanCode);
+            }
+            else
+                winSendKeyEvent(iScanCode, TRUE);
+        }
+        else {
+            /* Send message to our main window that has the keyboard focus */
+            PostMessage(hwnd, (UINT) wParam, (WPARAM) p->vkCode, lParamKey);
+        }
 
         return 1;
     }
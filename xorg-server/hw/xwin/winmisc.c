@@ -78,3 +78,37 @@ winUpdateFBPointer(ScreenPtr pScreen, void *pbits)
 
     return TRUE;
 }
+
+/*
+ * Map a damaged box in logical (X screen) coordinates to the source and
+ * destination rectangles of a stretching present blit.  The source is
+ * rounded out to WIN_SCALE_ALIGN logical pixels, clamped to the screen,
+ * so that the destination edges land on whole device pixels for any
+ * scale in 25% steps; neighbouring stretches then tile without seams
+ * from the filter sampling different pixels at their shared edge.
+ */
+
+void
+winScaleDamageBox(winScreenInfo * pScreenInfo, BoxPtr pBox,
+                  RECT * prcSrc, RECT * prcDst)
+{
+    int x1 = pBox->x1 & ~(WIN_SCALE_ALIGN - 1);
+    int y1 = pBox->y1 & ~(WIN_SCALE_ALIGN - 1);
+    int x2 = (pBox->x2 + WIN_SCALE_ALIGN - 1) & ~(WIN_SCALE_ALIGN - 1);
+    int y2 = (pBox->y2 + WIN_SCALE_ALIGN - 1) & ~(WIN_SCALE_ALIGN - 1);
+
+    if (x2 > (int) pScreenInfo->dwWidth)
+        x2 = pScreenInfo->dwWidth;
+    if (y2 > (int) pScreenInfo->dwHeight)
+        y2 = pScreenInfo->dwHeight;
+
+    prcSrc->left = x1;
+    prcSrc->top = y1;
+    prcSrc->right = x2;
+    prcSrc->bottom = y2;
+
+    prcDst->left = winScaleToDevice(pScreenInfo, x1);
+    prcDst->top = winScaleToDevice(pScreenInfo, y1);
+    prcDst->right = winScaleToDeviceCeil(pScreenInfo, x2);
+    prcDst->bottom = winScaleToDeviceCeil(pScreenInfo, y2);
+}
@@ -341,3 +341,153 @@ winEnqueueMotion(int x, int y)
                        POINTER_ABSOLUTE | POINTER_SCREEN, &mask);
 
 }
+
+/**
+ * Enqueue a relative motion event.
+ *
+ */
+void
+winEnqueueMotionRel(int dx, int dy)
+{
+    int valuators[2];
+    ValuatorMask mask;
+
+    valuators[0] = dx;
+    valuators[1] = dy;
+
+    valuator_mask_set_range(&mask, 0, 2, valuators);
+    QueuePointerEvents(g_pwinPointer, MotionNotify, 0, POINTER_RELATIVE, &mask);
+}
+
+/*
+ * Raw Input (WM_INPUT) mouse path.
+ *
+ * WM_MOUSEMOVE positions are coalesced by Windows and quantized to the
+ * cursor update rate, which loses motion detail from high-rate mice.
+ * When -rawinput is given we register the mouse as a raw input device
+ * and deliver motion from the WM_INPUT packets instead, which arrive
+ * at the device rate.
+ */
+
+/*
+ * Register the display window for raw mouse input
+ */
+
+Bool
+winMouseRawInputRegister(HWND hwnd)
+{
+    RAWINPUTDEVICE rid;
+
+    rid.usUsagePage = 0x01;     /* HID_USAGE_PAGE_GENERIC */
+    rid.usUsage = 0x02;         /* HID_USAGE_GENERIC_MOUSE */
+    rid.dwFlags = 0;
+    rid.hwndTarget = hwnd;
+
+    if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
+        ErrorF("winMouseRawInputRegister - RegisterRawInputDevices failed\n");
+        return FALSE;
+    }
+
+    winDebug("winMouseRawInputRegister - raw mouse input enabled\n");
+    return TRUE;
+}
+
+/*
+ * Fold one raw packet into the accumulated motion
+ */
+
+static void
+winMouseRawAccumulate(PRAWINPUT pRawInput, int *piDeltaX, int *piDeltaY,
+                      Bool *pfAbsolute, int *piAbsX, int *piAbsY)
+{
+    RAWMOUSE *pMouse;
+
+    if (pRawInput->header.dwType != RIM_TYPEMOUSE)
+        return;
+
+    pMouse = &pRawInput->data.mouse;
+    if (pMouse->usFlags & MOUSE_MOVE_ABSOLUTE) {
+        /* Pens, tablets and virtual machine pointers report normalized
+           0..65535 coordinates instead of deltas */
+        int iLeft = 0, iTop = 0, iWidth, iHeight;
+
+        if (pMouse->usFlags & MOUSE_VIRTUAL_DESKTOP) {
+            iLeft = GetSystemMetrics(SM_XVIRTUALSCREEN);
+            iTop = GetSystemMetrics(SM_YVIRTUALSCREEN);
+            iWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+            iHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+        }
+        else {
+            iWidth = GetSystemMetrics(SM_CXSCREEN);
+            iHeight = GetSystemMetrics(SM_CYSCREEN);
+        }
+
+        *pfAbsolute = TRUE;
+        *piAbsX = iLeft + (int) (((LONGLONG) pMouse->lLastX * iWidth) / 65536);
+        *piAbsY = iTop + (int) (((LONGLONG) pMouse->lLastY * iHeight) / 65536);
+    }
+    else {
+        *piDeltaX += pMouse->lLastX;
+        *piDeltaY += pMouse->lLastY;
+    }
+}
+
+/*
+ * Handle a WM_INPUT message: drain all queued raw packets and enqueue
+ * the batched motion as a single event
+ */
+
+void
+winMouseRawInputHandle(HWND hwnd, LPARAM lParam, int iXOffset, int iYOffset,
+                       int iScale)
+{
+    RAWINPUT rawInput;
+    UINT cbSize = sizeof(rawInput);
+    int iDeltaX = 0, iDeltaY = 0;
+    Bool fAbsolute = FALSE;
+    int iAbsX = 0, iAbsY = 0;
+
+    if (GetRawInputData((HRAWINPUT) lParam, RID_INPUT, &rawInput, &cbSize,
+                        sizeof(RAWINPUTHEADER)) == (UINT) -1)
+        return;
+
+    winMouseRawAccumulate(&rawInput, &iDeltaX, &iDeltaY,
+                          &fAbsolute, &iAbsX, &iAbsY);
+
+    /*
+     * Drain any packets still queued behind this message, so a burst
+     * from a high-rate mouse is folded into one motion event instead
+     * of one wakeup per packet.
+     */
+    for (;;) {
+        BYTE buffer[16 * sizeof(RAWINPUT)];
+        UINT cbBuffer = sizeof(buffer);
+        PRAWINPUT pRawInput = (PRAWINPUT) buffer;
+        UINT uCount = GetRawInputBuffer(pRawInput, &cbBuffer,
+                                        sizeof(RAWINPUTHEADER));
+        UINT i;
+
+        if (uCount == 0 || uCount == (UINT) -1)
+            break;
+
+        for (i = 0; i < uCount; i++) {
+            winMouseRawAccumulate(pRawInput, &iDeltaX, &iDeltaY,
+                                  &fAbsolute, &iAbsX, &iAbsY);
+            pRawInput = NEXTRAWINPUTBLOCK(pRawInput);
+        }
+    }
+
+    if (fAbsolute) {
+        POINT point;
+
+        point.x = iAbsX;
+        point.y = iAbsY;
+        ScreenToClient(hwnd, &point);
+        /* Device client pixels to logical X screen pixels (-scaling) */
+        winEnqueueMotion(((point.x - iXOffset) * 100) / iScale,
+                         ((point.y - iYOffset) * 100) / iScale);
+    }
+
+    if (iDeltaX || iDeltaY)
+        winEnqueueMotionRel(iDeltaX, iDeltaY);
+}
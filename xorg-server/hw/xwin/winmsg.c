@@ -40,10 +40,10 @@
 
 #ifdef WINDBG
 
+/* The header wraps these in same-name macros which pre-filter on
+ * verbosity; undefine them here so the real functions get defined. */
 
-
-
-
+#undef winDebug
 void
 winDebug(const char *format, ...)
 {
@@ -54,6 +54,7 @@ winDebug(const char *format, ...)
     va_end(ap);
 }
 
+#undef winDebug4
 void
 winDebug4 (const char *format, ...)
 {
@@ -93,6 +94,7 @@ winW32ErrorEx(const char *msg, DWORD errorcode)
 }
 
 #ifdef WINDBG
+#undef winDebugWin32Message
 void
 winDebugWin32Message(const char *function, HWND hwnd, UINT message,
                      WPARAM wParam, LPARAM lParam)
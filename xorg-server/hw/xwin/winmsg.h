@@ -45,6 +45,26 @@
 void winDebug (const char *format, ...);
 void winDebug4 (const char *format, ...);
 void winDebugWin32Message(const char* function, HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
+
+/* Messages above this verbosity are compiled out entirely. */
+#ifndef WIN_MSG_MAX_VERBOSITY
+#define WIN_MSG_MAX_VERBOSITY 4
+#endif
+
+#define WIN_MSG_VERB_CHECK(verb) \
+    ((verb) <= WIN_MSG_MAX_VERBOSITY && LogEffectiveVerbosity >= (verb))
+
+/* Function-like macros are painted blue during their own expansion, so
+ * the live branch below reaches the real function; the point is that a
+ * call which the verbosity filter will drop costs one comparison and
+ * never evaluates its format arguments.  winwndproc.c logs per window
+ * message, where the vsnprintf of a discarded message is measurable. */
+#define winDebug(...) \
+    (WIN_MSG_VERB_CHECK(3) ? winDebug(__VA_ARGS__) : (void) 0)
+#define winDebug4(...) \
+    (WIN_MSG_VERB_CHECK(4) ? winDebug4(__VA_ARGS__) : (void) 0)
+#define winDebugWin32Message(...) \
+    (WIN_MSG_VERB_CHECK(3) ? winDebugWin32Message(__VA_ARGS__) : (void) 0)
 #else
 #define winDebug(...)
 #define winDebug4(...)
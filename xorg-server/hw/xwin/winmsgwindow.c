@@ -41,10 +41,28 @@ static
 LRESULT CALLBACK
 winMsgWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
+    static UINT s_uDumpStatsMsg;
+
 #if CYGDEBUG
     winDebugWin32Message("winMsgWindowProc", hwnd, message, wParam, lParam);
 #endif
 
+    /*
+       Diagnostic tools can make a running server log its per-domain
+       allocation counts by sending the registered "XWIN_DUMPSTATS"
+       message here (the Windows stand-in for a SIGUSR dump).  Forward
+       it to the X server thread, which owns the dix structures.
+     */
+    if (s_uDumpStatsMsg == 0)
+        s_uDumpStatsMsg = RegisterWindowMessage("XWIN_DUMPSTATS");
+    if (message != 0 && message == s_uDumpStatsMsg) {
+        ScreenPtr pScreen = screenInfo.screens[0];
+
+        winScreenPriv(pScreen);
+        PostMessage(pScreenPriv->hwndScreen, WM_DUMPSTATS, 0, 0);
+        return 0;
+    }
+
     switch (message) {
     case WM_ENDSESSION:
         if (!wParam)
@@ -89,6 +89,17 @@ winInitMultiWindowClass(void)
 #endif
 
         atomXWinClass = RegisterClassEx(&wcx);
+
+        /*
+         * Same class again with CS_SAVEBITS for override-redirect
+         * popups (menus, tooltips): Windows snapshots the bits such a
+         * window covers and restores them itself when it goes away, so
+         * unmapping a menu repairs the windows underneath without any
+         * expose/redraw round trip through the X server.
+         */
+        wcx.style |= CS_SAVEBITS;
+        wcx.lpszClassName = WINDOW_CLASS_X_POPUP;
+        RegisterClassEx(&wcx);
     }
 }
 
@@ -457,6 +468,9 @@ winCreateWindowsWindow(WindowPtr pWin)
     Window daddyId;
     DWORD dwStyle, dwExStyle;
     RECT rc;
+    RECT rcPlacement;
+    DWORD dwPlacementShowCmd = SW_SHOWNORMAL;
+    Bool fPlacement = FALSE;
 
     winInitMultiWindowClass();
 
@@ -530,6 +544,11 @@ winCreateWindowsWindow(WindowPtr pWin)
               specified position if it's not the origin
             */
         }
+        else if (winPlacementQuery(pWin, &rcPlacement, &dwPlacementShowCmd)) {
+            /* Place the window where its last incarnation ended up,
+               so a session restore does not reshuffle after mapping */
+            fPlacement = TRUE;
+        }
         else {
             /* Use default position */
             iX = CW_USEDEFAULT;
@@ -561,12 +580,23 @@ winCreateWindowsWindow(WindowPtr pWin)
     iHeight = rc.bottom - rc.top;
     iWidth = rc.right - rc.left;
 
+    /* A remembered placement is already a frame rectangle */
+    if (fPlacement) {
+        iX = rcPlacement.left;
+        iY = rcPlacement.top;
+        iWidth = rcPlacement.right - rcPlacement.left;
+        iHeight = rcPlacement.bottom - rcPlacement.top;
+    }
+
     winDebug("winCreateWindowsWindow - 3 - %dx%d @ %dx%d\n", iWidth, iHeight, iX,
              iY);
 
-    /* Create the window */
+    /* Create the window; override-redirect windows are transient
+       popups and get the save-bits class so their uncover needs no
+       X-side redraw */
     hWnd = CreateWindowExA(dwExStyle,   /* Extended styles */
-                           WINDOW_CLASS_X,      /* Class name */
+                           pWin->overrideRedirect ?
+                           WINDOW_CLASS_X_POPUP : WINDOW_CLASS_X, /* Class name */
                            WINDOW_TITLE_X,      /* Window name */
                            dwStyle,     /* Styles */
                            iX,  /* Horizontal position */
@@ -587,9 +617,13 @@ winCreateWindowsWindow(WindowPtr pWin)
        Do this before the next SetWindowPos because this one is generating a WM_STYLECHANGED
        message which is causing a window move, which is wrong if the Xwindow does not
        have the correct coordinates yet */
-    if (iX == CW_USEDEFAULT) {
+    if (iX == CW_USEDEFAULT || fPlacement) {
       winAdjustXWindow(pWin, hWnd);
     }
+
+    /* Re-maximize on first show; the WM checks this when it maps */
+    if (fPlacement && dwPlacementShowCmd == SW_SHOWMAXIMIZED)
+        SetProp(hWnd, WIN_MAXIMIZE_PROP, (HANDLE) 1);
     /* Change style back to popup, already placed... */
     SetWindowLongPtr(hWnd, GWL_STYLE,
                      WS_POPUP | WS_CLIPCHILDREN | WS_CLIPSIBLINGS);
@@ -607,6 +641,11 @@ winCreateWindowsWindow(WindowPtr pWin)
 
     /* Flag that this Windows window handles its own activation */
     SetProp(hWnd, WIN_NEEDMANAGE_PROP, (HANDLE) 0);
+
+    /* Supply taskbar previews from the shadow framebuffer, so hovering
+       the taskbar never makes DWM repaint the window to build one */
+    if (pWinPriv->pScreenPriv->pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI)
+        winEnableIconicPreviews(hWnd);
 }
 
 Bool winInDestroyWindowsWindow = FALSE;
@@ -632,6 +671,9 @@ winDestroyWindowsWindow(WindowPtr pWin)
     if (pWinPriv->hWnd == NULL)
         return;
 
+    /* Remember the placement for the next window of this class */
+    winPlacementRemember(pWin, pWinPriv->hWnd);
+
     winInDestroyWindowsWindow = TRUE;
 
     /* Store the info we need to destroy after this window is gone */
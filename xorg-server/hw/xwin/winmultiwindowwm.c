@@ -39,6 +39,7 @@
 #include <unistd.h>
 #ifdef __CYGWIN__
 #include <sys/select.h>
+#include <sys/timeb.h>
 #endif
 #include <fcntl.h>
 #include <setjmp.h>
@@ -85,7 +86,6 @@ typedef int pid_t;
 #define HOST_NAME_MAX 255
 #endif
 
-extern void winDebug(const char *format, ...);
 extern void winReshapeMultiWindow(WindowPtr pWin);
 extern void winUpdateRgnMultiWindow(WindowPtr pWin);
 
@@ -104,6 +104,13 @@ extern void winSetAuthorization(void);
 #define HINT_MAX	(1L<<0)
 #define HINT_MIN	(1L<<1)
 
+/* Minimum interval between title pushes for one window; a build that
+   prints its progress into the title otherwise causes hundreds of
+   native frame repaints per second */
+#ifndef WIN_WM_NAME_THROTTLE_MS
+#define WIN_WM_NAME_THROTTLE_MS	100
+#endif
+
 /*
  * Local structures
  */
@@ -120,6 +127,37 @@ typedef struct _WMMsgQueueRec {
     pthread_cond_t pcNotEmpty;
 } WMMsgQueueRec, *WMMsgQueuePtr;
 
+/*
+ * Mirror cache of the per-window values the WM consults repeatedly.
+ *
+ * UpdateName()/UpdateIcon()/UpdateStyle() used to re-fetch the native
+ * HWND, the override-redirect flag, WM_HINTS and WM_CLASS with
+ * synchronous round trips on every call, so clients which update their
+ * title frequently (progress indicators etc.) stalled the WM thread on
+ * a string of replies for every change.  Instead we keep a copy here
+ * and refresh it only when a PropertyNotify (forwarded to us as a
+ * WM_WM_*_EVENT message) says it changed.
+ *
+ * Only ever touched from the WM thread (winMultiWindowWMProc), so no
+ * locking is needed; the X message thread invalidates entries
+ * indirectly via the message queue.
+ */
+typedef struct _WMWindowCacheRec {
+    xcb_window_t iWindow;
+    HWND hWnd;                  /* NULL until announced or fetched */
+    Bool fOverrideValid;
+    Bool fOverrideRedirect;
+    Bool fHintsValid;
+    xcb_icccm_wm_hints_t hints;
+    char *pszResName;           /* WM_CLASS pair, NULL until fetched */
+    char *pszResClass;
+    char *pszWindowName;        /* title last set on, or pending for,
+                                   the native window */
+    DWORD dwNameTick;           /* tick of the last title push */
+    Bool fNameDirty;            /* title change held back by the throttle */
+    struct _WMWindowCacheRec *pNext;
+} WMWindowCacheRec, *WMWindowCachePtr;
+
 typedef struct _WMInfo {
     xcb_connection_t *conn;
     xcb_errors_context_t *err_ctx;
@@ -136,6 +174,8 @@ typedef struct _WMInfo {
     xcb_atom_t atmWmState;
     xcb_ewmh_connection_t ewmh;
     Bool fCompositeWM;
+    WMWindowCachePtr pWindowCache;
+    int cDirtyNames;            /* cache entries with a throttled title */
 } WMInfoRec, *WMInfoPtr;
 
 typedef struct _WMProcArgRec {
@@ -194,6 +234,10 @@ static void
 void
  winUpdateWindowPosition(HWND hWnd, HWND * zstyle);
 
+static void
+ winUpdateWindowPositionBatch(HWND hWnd, HWND * zstyle, HDWP * phDWP,
+                              UINT uExtraFlags);
+
 /*
  * Local globals
  */
@@ -295,9 +339,24 @@ PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo)
     /* Lock the queue mutex */
     pthread_mutex_lock(&pQueue->pmMutex);
 
-    /* Wait for --- */
+    /* Wait for a message; with throttled title pushes pending, wait
+       with a timeout so the queue going quiet flushes them */
     while (pQueue->pHead == NULL) {
-        pthread_cond_wait(&pQueue->pcNotEmpty, &pQueue->pmMutex);
+        if (pWMInfo->cDirtyNames > 0) {
+            struct _timeb tb;
+            struct timespec ts;
+
+            _ftime(&tb);
+            ts.tv_sec = (long) tb.time +
+                (tb.millitm + WIN_WM_NAME_THROTTLE_MS) / 1000;
+            ts.tv_nsec = ((tb.millitm + WIN_WM_NAME_THROTTLE_MS) % 1000)
+                * 1000000;
+            if (pthread_cond_timedwait(&pQueue->pcNotEmpty,
+                                       &pQueue->pmMutex, &ts))
+                break;
+        }
+        else
+            pthread_cond_wait(&pQueue->pcNotEmpty, &pQueue->pmMutex);
     }
 
     pNode = pQueue->pHead;
@@ -315,24 +374,129 @@ PopMessage(WMMsgQueuePtr pQueue, WMInfoPtr pWMInfo)
     return pNode;
 }
 
-#if 0
 /*
- * HaveMessage -
+ * TryPopMessage - Pop a message from the queue, without blocking
+ */
+
+static WMMsgNodePtr
+TryPopMessage(WMMsgQueuePtr pQueue)
+{
+    WMMsgNodePtr pNode;
+
+    /* Lock the queue mutex */
+    pthread_mutex_lock(&pQueue->pmMutex);
+
+    pNode = pQueue->pHead;
+    if (pNode != NULL) {
+        pQueue->pHead = pNode->pNext;
+    }
+
+    if (pQueue->pTail == pNode) {
+        pQueue->pTail = NULL;
+    }
+
+    /* Release the queue mutex */
+    pthread_mutex_unlock(&pQueue->pmMutex);
+
+    return pNode;
+}
+
+/*
+ * HaveMessage - Check whether an identical message is already queued
  */
 
 static Bool
 HaveMessage(WMMsgQueuePtr pQueue, UINT msg, xcb_window_t iWindow)
 {
     WMMsgNodePtr pNode;
+    Bool fFound = FALSE;
+
+    /* Lock the queue mutex */
+    pthread_mutex_lock(&pQueue->pmMutex);
 
     for (pNode = pQueue->pHead; pNode != NULL; pNode = pNode->pNext) {
-        if (pNode->msg.msg == msg && pNode->msg.iWindow == iWindow)
-            return True;
+        if (pNode->msg.msg == msg && pNode->msg.iWindow == iWindow) {
+            fFound = TRUE;
+            break;
+        }
     }
 
-    return False;
+    /* Release the queue mutex */
+    pthread_mutex_unlock(&pQueue->pmMutex);
+
+    return fFound;
+}
+
+/*
+ * GetWindowCacheEntry - Find (or create) the mirror cache entry for a window
+ */
+
+static WMWindowCachePtr
+GetWindowCacheEntry(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMWindowCachePtr pEntry;
+
+    for (pEntry = pWMInfo->pWindowCache; pEntry != NULL; pEntry = pEntry->pNext)
+        if (pEntry->iWindow == iWindow)
+            return pEntry;
+
+    pEntry = calloc(1, sizeof(WMWindowCacheRec));
+    if (pEntry == NULL)
+        return NULL;
+
+    pEntry->iWindow = iWindow;
+    pEntry->pNext = pWMInfo->pWindowCache;
+    pWMInfo->pWindowCache = pEntry;
+
+    return pEntry;
+}
+
+/*
+ * RemoveWindowCacheEntry - Forget everything mirrored about a window
+ */
+
+static void
+RemoveWindowCacheEntry(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMWindowCachePtr *ppEntry = &pWMInfo->pWindowCache;
+
+    while (*ppEntry != NULL) {
+        if ((*ppEntry)->iWindow == iWindow) {
+            WMWindowCachePtr pEntry = *ppEntry;
+
+            *ppEntry = pEntry->pNext;
+            if (pEntry->fNameDirty)
+                pWMInfo->cDirtyNames--;
+            free(pEntry->pszResName);
+            free(pEntry->pszResClass);
+            free(pEntry->pszWindowName);
+            free(pEntry);
+            return;
+        }
+        ppEntry = &(*ppEntry)->pNext;
+    }
+}
+
+/*
+ * NoteHwndInCache - A WM_WM_MAP_* message announced a native window;
+ * note it so getHwnd() never has to fetch the property
+ */
+
+static void
+NoteHwndInCache(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd)
+{
+    WMWindowCachePtr pEntry = GetWindowCacheEntry(pWMInfo, iWindow);
+
+    if (pEntry == NULL)
+        return;
+
+    pEntry->hWnd = hWnd;
+
+    /* The new native window has no title yet, so the next UpdateName()
+       must not be skipped as a no-change */
+    free(pEntry->pszWindowName);
+    pEntry->pszWindowName = NULL;
 }
-#endif
 
 /*
  * InitQueue - Initialize the Window Manager message queue
@@ -536,10 +700,19 @@ SendXMessage(xcb_connection_t *conn, xcb_window_t iWin, xcb_atom_t atmType, long
 static HWND
 getHwnd(WMInfoPtr pWMInfo, xcb_window_t iWindow)
 {
+    WMWindowCachePtr pEntry = GetWindowCacheEntry(pWMInfo, iWindow);
     HWND hWnd = NULL;
     xcb_get_property_cookie_t cookie;
     xcb_get_property_reply_t *reply;
 
+    /* Usually already known, either noted from the WM_WM_MAP_* message
+       which announced it or from an earlier fetch */
+    if (pEntry && pEntry->hWnd) {
+        if (IsWindow(pEntry->hWnd))
+            return pEntry->hWnd;
+        pEntry->hWnd = NULL;
+    }
+
     cookie = xcb_get_property(pWMInfo->conn, FALSE, iWindow, pWMInfo->atmPrivMap,
                               XCB_ATOM_INTEGER, 0L, sizeof(HWND)/4L);
     reply = xcb_get_property_reply(pWMInfo->conn, cookie, NULL);
@@ -560,6 +733,9 @@ getHwnd(WMInfoPtr pWMInfo, xcb_window_t iWindow)
     if (!IsWindow(hWnd))
         return NULL;
 
+    if (pEntry)
+        pEntry->hWnd = hWnd;
+
     return hWnd;
 }
 
@@ -586,6 +762,27 @@ IsOverrideRedirect(xcb_connection_t *conn, xcb_window_t iWin)
     return result;
 }
 
+/*
+ * Cached variant for the WM thread; override-redirect is set when the
+ * window is created and doesn't change while we manage it, so one
+ * fetch per window is enough
+ */
+static Bool
+CachedIsOverrideRedirect(WMInfoPtr pWMInfo, xcb_window_t iWindow)
+{
+    WMWindowCachePtr pEntry = GetWindowCacheEntry(pWMInfo, iWindow);
+
+    if (pEntry == NULL)
+        return IsOverrideRedirect(pWMInfo->conn, iWindow);
+
+    if (!pEntry->fOverrideValid) {
+        pEntry->fOverrideRedirect = IsOverrideRedirect(pWMInfo->conn, iWindow);
+        pEntry->fOverrideValid = TRUE;
+    }
+
+    return pEntry->fOverrideRedirect;
+}
+
 /*
  * Helper function to get class and window names
 */
@@ -593,21 +790,36 @@ static void
 GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
               char **res_class, char **window_name)
 {
+    WMWindowCachePtr pEntry = GetWindowCacheEntry(pWMInfo, iWindow);
     xcb_get_property_cookie_t cookie1;
     xcb_icccm_get_wm_class_reply_t reply1;
     xcb_get_property_cookie_t cookie2;
     xcb_icccm_get_text_property_reply_t reply2;
 
-    cookie1 = xcb_icccm_get_wm_class(pWMInfo->conn, iWindow);
-    if (xcb_icccm_get_wm_class_reply(pWMInfo->conn, cookie1, &reply1,
-                                     NULL)) {
-        *res_name = strdup(reply1.instance_name);
-        *res_class = strdup(reply1.class_name);
-        xcb_icccm_get_wm_class_reply_wipe(&reply1);
+    /* WM_CLASS is set before the window is mapped and never changes
+       (ICCCM 4.1.2.5), so the mirrored copy is good for the life of
+       the cache entry */
+    if (pEntry && pEntry->pszResName && pEntry->pszResClass) {
+        *res_name = strdup(pEntry->pszResName);
+        *res_class = strdup(pEntry->pszResClass);
     }
     else {
-        *res_name = strdup("");
-        *res_class = strdup("");
+        cookie1 = xcb_icccm_get_wm_class(pWMInfo->conn, iWindow);
+        if (xcb_icccm_get_wm_class_reply(pWMInfo->conn, cookie1, &reply1,
+                                         NULL)) {
+            *res_name = strdup(reply1.instance_name);
+            *res_class = strdup(reply1.class_name);
+            xcb_icccm_get_wm_class_reply_wipe(&reply1);
+        }
+        else {
+            *res_name = strdup("");
+            *res_class = strdup("");
+        }
+
+        if (pEntry) {
+            pEntry->pszResName = strdup(*res_name);
+            pEntry->pszResClass = strdup(*res_class);
+        }
     }
 
     cookie2 = xcb_icccm_get_wm_name(pWMInfo->conn, iWindow);
@@ -620,6 +832,67 @@ GetClassNames(WMInfoPtr pWMInfo, xcb_window_t iWindow, char **res_name,
     }
 }
 
+/*
+ * PushWindowName - Convert a UTF-8 title to UTF-16 and hand it to
+ * Windows.  The conversion buffer is reused across calls; only the WM
+ * thread comes through here.
+ */
+
+static void
+PushWindowName(HWND hWnd, const char *pszWindowName)
+{
+    static wchar_t *s_pwszWideWindowName;
+    static int s_iWideLen;
+    int iLen;
+
+    /* Convert from UTF-8 to wide char */
+    iLen = MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1, NULL, 0);
+    if (iLen > s_iWideLen) {
+        wchar_t *pwszNew =
+            realloc(s_pwszWideWindowName, sizeof(wchar_t) * iLen);
+
+        if (pwszNew == NULL)
+            return;
+        s_pwszWideWindowName = pwszNew;
+        s_iWideLen = iLen;
+    }
+    MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1,
+                        s_pwszWideWindowName, iLen);
+
+    /* Set the Windows window name */
+    SetWindowTextW(hWnd, s_pwszWideWindowName);
+}
+
+/*
+ * FlushThrottledNames - Push the titles the rate limit in UpdateName
+ * held back, once their interval has passed
+ */
+
+static void
+FlushThrottledNames(WMInfoPtr pWMInfo)
+{
+    WMWindowCachePtr pEntry;
+    DWORD dwNow = GetTickCount();
+
+    for (pEntry = pWMInfo->pWindowCache;
+         pWMInfo->cDirtyNames > 0 && pEntry != NULL; pEntry = pEntry->pNext) {
+        HWND hWnd;
+
+        if (!pEntry->fNameDirty ||
+            (dwNow - pEntry->dwNameTick) < WIN_WM_NAME_THROTTLE_MS)
+            continue;
+
+        pEntry->fNameDirty = FALSE;
+        pWMInfo->cDirtyNames--;
+
+        hWnd = getHwnd(pWMInfo, pEntry->iWindow);
+        if (hWnd && pEntry->pszWindowName) {
+            PushWindowName(hWnd, pEntry->pszWindowName);
+            pEntry->dwNameTick = dwNow;
+        }
+    }
+}
+
 /*
  * Updates the name of a HWND according to its X WM_NAME property
  */
@@ -634,26 +907,52 @@ UpdateName(WMInfoPtr pWMInfo, xcb_window_t iWindow)
         return;
 
     /* If window isn't override-redirect */
-    if (!IsOverrideRedirect(pWMInfo->conn, iWindow)) {
+    if (!CachedIsOverrideRedirect(pWMInfo, iWindow)) {
+        WMWindowCachePtr pEntry = GetWindowCacheEntry(pWMInfo, iWindow);
         char *pszWindowName;
 
         /* Get the X windows window name */
         GetWindowName(pWMInfo, iWindow, &pszWindowName);
 
         if (pszWindowName) {
-            /* Convert from UTF-8 to wide char */
-            int iLen =
-                MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1, NULL, 0);
-            wchar_t *pwszWideWindowName =
-                malloc(sizeof(wchar_t)*(iLen + 1));
-            MultiByteToWideChar(CP_UTF8, 0, pszWindowName, -1,
-                                pwszWideWindowName, iLen);
-
-            /* Set the Windows window name */
-            SetWindowTextW(hWnd, pwszWideWindowName);
-
-            free(pwszWideWindowName);
-            free(pszWindowName);
+            /* A storm of name changes often carries the same effective
+               title; skip the WM_SETTEXT (and the frame repaint it
+               causes) when nothing actually changed */
+            if (pEntry && pEntry->pszWindowName &&
+                strcmp(pEntry->pszWindowName, pszWindowName) == 0) {
+                free(pszWindowName);
+                return;
+            }
+
+            /* Rate-limit the pushes; every WM_SETTEXT repaints the
+               native frame.  A throttled title is kept in the cache
+               and flushed from the WM loop once the interval is up. */
+            if (pEntry &&
+                (GetTickCount() - pEntry->dwNameTick) <
+                WIN_WM_NAME_THROTTLE_MS) {
+                free(pEntry->pszWindowName);
+                pEntry->pszWindowName = pszWindowName;
+                if (!pEntry->fNameDirty) {
+                    pEntry->fNameDirty = TRUE;
+                    pWMInfo->cDirtyNames++;
+                }
+                return;
+            }
+
+            PushWindowName(hWnd, pszWindowName);
+
+            if (pEntry) {
+                pEntry->dwNameTick = GetTickCount();
+                if (pEntry->fNameDirty) {
+                    pEntry->fNameDirty = FALSE;
+                    pWMInfo->cDirtyNames--;
+                }
+                free(pEntry->pszWindowName);
+                pEntry->pszWindowName = pszWindowName;
+            }
+            else {
+                free(pszWindowName);
+            }
         }
     }
 }
@@ -673,7 +972,7 @@ UpdateIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow)
         return;
 
     /* If window isn't override-redirect */
-    if (!IsOverrideRedirect(pWMInfo->conn, iWindow)) {
+    if (!CachedIsOverrideRedirect(pWMInfo, iWindow)) {
         char *window_name = 0;
         char *res_name = 0;
         char *res_class = 0;
@@ -694,14 +993,13 @@ UpdateIcon(WMInfoPtr pWMInfo, xcb_window_t iWindow)
  */
 
 static void
-UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int extra)
+UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int extra, HDWP * phDWP)
 {
     HWND hWnd;
     HWND zstyle = HWND_NOTOPMOST;
-    UINT flags;
 
     /* If window isn't override-redirect */
-    if (IsOverrideRedirect(pWMInfo->conn, iWindow))
+    if (CachedIsOverrideRedirect(pWMInfo, iWindow))
         return;
 
     hWnd = getHwnd(pWMInfo, iWindow);
@@ -712,12 +1010,13 @@ UpdateStyle(WMInfoPtr pWMInfo, xcb_window_t iWindow, unsigned long *maxmin, int
     winApplyHints(pWMInfo, iWindow, hWnd, &zstyle, maxmin);
     if (extra)
     {
-      winUpdateWindowPosition(hWnd, &zstyle);
-      /* Apply the updated window style, without changing its show or activation state */
-      flags = SWP_FRAMECHANGED | SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOSIZE;
-      if (zstyle == HWND_NOTOPMOST)
-          flags |= SWP_NOZORDER | SWP_NOOWNERZORDER;
-      SetWindowPos(hWnd, NULL, 0, 0, 0, 0, flags);
+      /* Apply the updated position, size, z-order and frame style in a
+         single operation, without changing the show or activation state.
+         When the caller has a DeferWindowPos transaction open this goes
+         into it (a window may only appear once per transaction, hence
+         one combined update) */
+      winUpdateWindowPositionBatch(hWnd, &zstyle, phDWP,
+                                   SWP_FRAMECHANGED | SWP_NOACTIVATE);
     }
 
     /*
@@ -772,7 +1071,14 @@ UpdateState(WMInfoPtr pWMInfo, xcb_window_t iWindow, int state)
                     break;
 
                 case XCB_ICCCM_WM_STATE_NORMAL:
-                    ShowWindow(hWnd, SW_SHOWNOACTIVATE);
+                    /* A restored placement may ask for the first show
+                       to be maximized */
+                    if (GetProp(hWnd, WIN_MAXIMIZE_PROP)) {
+                        RemoveProp(hWnd, WIN_MAXIMIZE_PROP);
+                        ShowWindow(hWnd, SW_SHOWMAXIMIZED);
+                    }
+                    else
+                        ShowWindow(hWnd, SW_SHOWNOACTIVATE);
                     break;
 
                 case XCB_ICCCM_WM_STATE_WITHDRAWN:
@@ -879,6 +1185,11 @@ UpdateState(WMInfoPtr pWMInfo, xcb_window_t iWindow, int state)
                                     o, (unsigned char *) &netwmstate);
         }
     }
+
+    /* A withdrawn window loses its native window; forget everything we
+       mirrored about it (a remap announces a fresh HWND) */
+    if (state == XCB_ICCCM_WM_STATE_WITHDRAWN)
+        RemoveWindowCacheEntry(pWMInfo, iWindow);
 }
 
 #if 0
@@ -923,198 +1234,266 @@ PreserveWin32Stack(WMInfoPtr pWMInfo, xcb_window_t iWindow, UINT direction)
 #endif                          /* PreserveWin32Stack */
 
 /*
- * winMultiWindowWMProc
+ * winMultiWindowWMProcessMessage - Process one message from the WM queue
+ *
+ * Window positioning is deferred into the transaction at *phDWP when
+ * one is open, so that a whole queue drain completes in a single
+ * DeferWindowPos/EndDeferWindowPos transaction.
  */
 
-static void *
-winMultiWindowWMProc(void *pArg)
+static void
+winMultiWindowWMProcessMessage(WMInfoPtr pWMInfo, WMMsgNodePtr pNode,
+                               HDWP * phDWP)
 {
-    WMProcArgPtr pProcArg = (WMProcArgPtr) pArg;
-    WMInfoPtr pWMInfo = pProcArg->pWMInfo;
+    winDebug("winMultiWindowWMProc - MSG: %s (%d) ID: %d\n",
+           MessageName(&(pNode->msg)), (int)pNode->msg.msg, (int)pNode->msg.dwID);
 
-    pthread_cleanup_push(&winMultiWindowThreadExit, NULL);
+    /* Branch on the message type */
+    switch (pNode->msg.msg) {
+    case WM_WM_RAISE:
+        /* Raise the window */
+        {
+            const static uint32_t values[] = { XCB_STACK_MODE_ABOVE };
+            xcb_configure_window(pWMInfo->conn, pNode->msg.iWindow,
+                                 XCB_CONFIG_WINDOW_STACK_MODE, values);
+        }
 
-    /* Initialize the Window Manager */
-    winInitMultiWindowWM(pWMInfo, pProcArg);
+        break;
 
-    winDebug ("winMultiWindowWMProc ()\n");
+    case WM_WM_LOWER:
+        /* Lower the window */
+        {
+            const static uint32_t values[] = { XCB_STACK_MODE_BELOW };
+            xcb_configure_window(pWMInfo->conn, pNode->msg.iWindow,
+                                 XCB_CONFIG_WINDOW_STACK_MODE, values);
+        }
+        break;
 
-    /* Loop until we explicitly break out */
-    for (;;) {
-        WMMsgNodePtr pNode;
+    case WM_WM_MAP_UNMANAGED:
+        /* Put a note as to the HWND associated with this Window */
+        xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
+                            pNode->msg.iWindow, pWMInfo->atmPrivMap,
+                            XCB_ATOM_INTEGER, 32,
+                            sizeof(HWND)/4, &(pNode->msg.hwndWindow));
 
-        /* Pop a message off of our queue */
-        pNode = PopMessage(&pWMInfo->wmMsgQueue, pWMInfo);
-        if (pNode == NULL) {
-            /* Bail if PopMessage returns without a message */
-            /* NOTE: Remember that PopMessage is a blocking function. */
-            ErrorF("winMultiWindowWMProc - Queue is Empty?  Exiting.\n");
-            pthread_exit(NULL);
-        }
+        NoteHwndInCache(pWMInfo, pNode->msg.iWindow, pNode->msg.hwndWindow);
 
-        winDebug("winMultiWindowWMProc - MSG: %s (%d) ID: %d\n",
-               MessageName(&(pNode->msg)), (int)pNode->msg.msg, (int)pNode->msg.dwID);
+        break;
 
-        /* Branch on the message type */
-        switch (pNode->msg.msg) {
-        case WM_WM_RAISE:
-            /* Raise the window */
-            {
-                const static uint32_t values[] = { XCB_STACK_MODE_ABOVE };
-                xcb_configure_window(pWMInfo->conn, pNode->msg.iWindow,
-                                     XCB_CONFIG_WINDOW_STACK_MODE, values);
-            }
+    case WM_WM_MAP_MANAGED:
+      {
+        unsigned long maxmin = 0;
 
-            break;
+        /* Put a note as to the HWND associated with this Window */
+        xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
+                            pNode->msg.iWindow, pWMInfo->atmPrivMap,
+                            XCB_ATOM_INTEGER, 32,
+                            sizeof(HWND)/4, &(pNode->msg.hwndWindow));
 
-        case WM_WM_LOWER:
-            /* Lower the window */
-            {
-                const static uint32_t values[] = { XCB_STACK_MODE_BELOW };
-                xcb_configure_window(pWMInfo->conn, pNode->msg.iWindow,
-                                     XCB_CONFIG_WINDOW_STACK_MODE, values);
+        NoteHwndInCache(pWMInfo, pNode->msg.iWindow, pNode->msg.hwndWindow);
+
+        UpdateName(pWMInfo, pNode->msg.iWindow);
+        UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 1, phDWP);
+
+        /* Reshape */
+        {
+            WindowPtr pWin =
+                GetProp(pNode->msg.hwndWindow, WIN_WINDOW_PROP);
+            if (pWin) {
+                winReshapeMultiWindow(pWin);
+                winUpdateRgnMultiWindow(pWin);
             }
-            break;
+        }
 
-        case WM_WM_MAP_UNMANAGED:
-            /* Put a note as to the HWND associated with this Window */
-            xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
-                                pNode->msg.iWindow, pWMInfo->atmPrivMap,
-                                XCB_ATOM_INTEGER, 32,
-                                sizeof(HWND)/4, &(pNode->msg.hwndWindow));
+        UpdateIcon(pWMInfo, pNode->msg.iWindow);
+        /* Establish initial state */
+        UpdateState(pWMInfo, pNode->msg.iWindow, XCB_ICCCM_WM_STATE_NORMAL);
+
+        /*
+          It only makes sense to apply minimize/maximize override as the
+          initial state, otherwise that state can't be changed.
+        */
+        if (maxmin & (HINT_MAX | HINT_MIN)) {
+            /* The deferred positioning must land before the syscommand
+               so that it acts on the final geometry */
+            if (*phDWP != NULL) {
+                EndDeferWindowPos(*phDWP);
+                *phDWP = NULL;
+            }
+            if (maxmin & HINT_MAX)
+                SendMessage(pNode->msg.hwndWindow, WM_SYSCOMMAND, SC_MAXIMIZE, 0);
+            else
+                SendMessage(pNode->msg.hwndWindow, WM_SYSCOMMAND, SC_MINIMIZE, 0);
+        }
+      }
 
-            break;
+        break;
 
-        case WM_WM_MAP_MANAGED:
-          {
-            unsigned long maxmin = 0;
+    case WM_WM_UNMAP:
 
-            /* Put a note as to the HWND associated with this Window */
-            xcb_change_property(pWMInfo->conn, XCB_PROP_MODE_REPLACE,
-                                pNode->msg.iWindow, pWMInfo->atmPrivMap,
-                                XCB_ATOM_INTEGER, 32,
-                                sizeof(HWND)/4, &(pNode->msg.hwndWindow));
+        /* Unmap the window */
+        xcb_unmap_window(pWMInfo->conn, pNode->msg.iWindow);
+        break;
 
-            UpdateName(pWMInfo, pNode->msg.iWindow);
-            UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 1);
+    case WM_WM_KILL:
+        {
+            /* --- */
+            if (IsWmProtocolAvailable(pWMInfo,
+                                      pNode->msg.iWindow,
+                                      pWMInfo->atmWmDelete))
+                SendXMessage(pWMInfo->conn,
+                             pNode->msg.iWindow,
+                             pWMInfo->atmWmProtos, pWMInfo->atmWmDelete);
+            else
+                xcb_kill_client(pWMInfo->conn, pNode->msg.iWindow);
+        }
+        break;
 
-            /* Reshape */
-            {
-                WindowPtr pWin =
-                    GetProp(pNode->msg.hwndWindow, WIN_WINDOW_PROP);
-                if (pWin) {
-                    winReshapeMultiWindow(pWin);
-                    winUpdateRgnMultiWindow(pWin);
-                }
+    case WM_WM_ACTIVATE:
+        /* Set the input focus */
+
+        /*
+           ICCCM 4.1.7 is pretty opaque, but it appears that the rules are
+           actually quite simple:
+           -- the WM_HINTS input field determines whether the WM should call
+           XSetInputFocus()
+           -- independently, the WM_TAKE_FOCUS protocol determines whether
+           the WM should send a WM_TAKE_FOCUS ClientMessage.
+        */
+        if (pNode->msg.iWindow)
+        {
+          Bool neverFocus = FALSE;
+          xcb_icccm_wm_hints_t hints;
+          WMWindowCachePtr pEntry =
+              GetWindowCacheEntry(pWMInfo, pNode->msg.iWindow);
+
+          /* Use the mirrored WM_HINTS; it's refreshed below only after
+             a WM_WM_HINTS_EVENT said it changed */
+          if (pEntry && pEntry->fHintsValid) {
+            hints = pEntry->hints;
+          }
+          else {
+            xcb_get_property_cookie_t cookie;
+
+            cookie = xcb_icccm_get_wm_hints(pWMInfo->conn, pNode->msg.iWindow);
+            if (xcb_icccm_get_wm_hints_reply(pWMInfo->conn, cookie, &hints,
+                                             NULL)) {
+              if (pEntry) {
+                pEntry->hints = hints;
+                pEntry->fHintsValid = TRUE;
+              }
             }
+            else {
+              hints.flags = 0;
+            }
+          }
 
-            UpdateIcon(pWMInfo, pNode->msg.iWindow);
-            /* Establish initial state */
-            UpdateState(pWMInfo, pNode->msg.iWindow, XCB_ICCCM_WM_STATE_NORMAL);
+          if (hints.flags & XCB_ICCCM_WM_HINT_INPUT)
+            neverFocus = !hints.input;
 
-            /*
-              It only makes sense to apply minimize/maximize override as the
-              initial state, otherwise that state can't be changed.
-            */
-            if (maxmin & HINT_MAX)
-                SendMessage(pNode->msg.hwndWindow, WM_SYSCOMMAND, SC_MAXIMIZE, 0);
-            else if (maxmin & HINT_MIN)
-                SendMessage(pNode->msg.hwndWindow, WM_SYSCOMMAND, SC_MINIMIZE, 0);
-          }
+          if (!neverFocus)
+            xcb_set_input_focus(pWMInfo->conn, XCB_INPUT_FOCUS_PARENT,
+                                pNode->msg.iWindow, XCB_CURRENT_TIME);
 
-            break;
+          if (IsWmProtocolAvailable(pWMInfo,
+                                    pNode->msg.iWindow,
+                                    pWMInfo->atmWmTakeFocus))
+            SendXMessage(pWMInfo->conn,
+                         pNode->msg.iWindow,
+                         pWMInfo->atmWmProtos, pWMInfo->atmWmTakeFocus);
 
-        case WM_WM_UNMAP:
+        }
+        else
+        /* Set the input focus to none */
+        {
+          xcb_set_input_focus(pWMInfo->conn, XCB_INPUT_FOCUS_NONE,
+                              XCB_NONE, XCB_CURRENT_TIME);
 
-            /* Unmap the window */
-            xcb_unmap_window(pWMInfo->conn, pNode->msg.iWindow);
-            break;
+        }
+        break;
 
-        case WM_WM_KILL:
-            {
-                /* --- */
-                if (IsWmProtocolAvailable(pWMInfo,
-                                          pNode->msg.iWindow,
-                                          pWMInfo->atmWmDelete))
-                    SendXMessage(pWMInfo->conn,
-                                 pNode->msg.iWindow,
-                                 pWMInfo->atmWmProtos, pWMInfo->atmWmDelete);
-                else
-                    xcb_kill_client(pWMInfo->conn, pNode->msg.iWindow);
-            }
-            break;
+    case WM_WM_NAME_EVENT:
+        UpdateName(pWMInfo, pNode->msg.iWindow);
+        break;
 
-        case WM_WM_ACTIVATE:
-            /* Set the input focus */
+    case WM_WM_ICON_EVENT:
+        UpdateIcon(pWMInfo, pNode->msg.iWindow);
+        break;
 
-            /*
-               ICCCM 4.1.7 is pretty opaque, but it appears that the rules are
-               actually quite simple:
-               -- the WM_HINTS input field determines whether the WM should call
-               XSetInputFocus()
-               -- independently, the WM_TAKE_FOCUS protocol determines whether
-               the WM should send a WM_TAKE_FOCUS ClientMessage.
-            */
-            if (pNode->msg.iWindow)
-            {
-              Bool neverFocus = FALSE;
-              xcb_get_property_cookie_t cookie;
-              xcb_icccm_wm_hints_t hints;
-
-              cookie = xcb_icccm_get_wm_hints(pWMInfo->conn, pNode->msg.iWindow);
-              if (xcb_icccm_get_wm_hints_reply(pWMInfo->conn, cookie, &hints,
-                                               NULL)) {
-                if (hints.flags & XCB_ICCCM_WM_HINT_INPUT)
-                  neverFocus = !hints.input;
-              }
+    case WM_WM_HINTS_EVENT:
+        {
+        unsigned long maxmin = 0;
+        WMWindowCachePtr pEntry =
+            GetWindowCacheEntry(pWMInfo, pNode->msg.iWindow);
 
-              if (!neverFocus)
-                xcb_set_input_focus(pWMInfo->conn, XCB_INPUT_FOCUS_PARENT,
-                                    pNode->msg.iWindow, XCB_CURRENT_TIME);
+        /* One of the hint properties changed; drop the mirrored copy */
+        if (pEntry)
+            pEntry->fHintsValid = FALSE;
 
-              if (IsWmProtocolAvailable(pWMInfo,
-                                        pNode->msg.iWindow,
-                                        pWMInfo->atmWmTakeFocus))
-                SendXMessage(pWMInfo->conn,
-                             pNode->msg.iWindow,
-                             pWMInfo->atmWmProtos, pWMInfo->atmWmTakeFocus);
+        UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 0, phDWP);
+        }
+        break;
 
-            }
-            else
-            /* Set the input focus to none */
-            {
-              xcb_set_input_focus(pWMInfo->conn, XCB_INPUT_FOCUS_NONE,
-                                  XCB_NONE, XCB_CURRENT_TIME);
+    case WM_WM_CHANGE_STATE:
+        UpdateState(pWMInfo, pNode->msg.iWindow, pNode->msg.dwID);
+        break;
 
-            }
-            break;
+    default:
+        ErrorF("winMultiWindowWMProc - Unknown Message.  Exiting.\n");
+        pthread_exit(NULL);
+        break;
+    }
+}
 
-        case WM_WM_NAME_EVENT:
-            UpdateName(pWMInfo, pNode->msg.iWindow);
-            break;
+/*
+ * winMultiWindowWMProc
+ */
 
-        case WM_WM_ICON_EVENT:
-            UpdateIcon(pWMInfo, pNode->msg.iWindow);
-            break;
+static void *
+winMultiWindowWMProc(void *pArg)
+{
+    WMProcArgPtr pProcArg = (WMProcArgPtr) pArg;
+    WMInfoPtr pWMInfo = pProcArg->pWMInfo;
 
-        case WM_WM_HINTS_EVENT:
-            {
-            unsigned long maxmin = 0;
+    pthread_cleanup_push(&winMultiWindowThreadExit, NULL);
 
-            UpdateStyle(pWMInfo, pNode->msg.iWindow, &maxmin, 0);
-            }
-            break;
+    /* Initialize the Window Manager */
+    winInitMultiWindowWM(pWMInfo, pProcArg);
 
-        case WM_WM_CHANGE_STATE:
-            UpdateState(pWMInfo, pNode->msg.iWindow, pNode->msg.dwID);
-            break;
+    winDebug ("winMultiWindowWMProc ()\n");
 
-        default:
-            ErrorF("winMultiWindowWMProc - Unknown Message.  Exiting.\n");
-            pthread_exit(NULL);
-            break;
+    /* Loop until we explicitly break out */
+    for (;;) {
+        WMMsgNodePtr pNode;
+        HDWP hDWP = NULL;
+
+        /* Pop a message off of our queue */
+        pNode = PopMessage(&pWMInfo->wmMsgQueue, pWMInfo);
+        if (pNode == NULL) {
+            /* The wait timed out with throttled title pushes pending;
+               the queue has gone quiet, so deliver them now */
+            FlushThrottledNames(pWMInfo);
+            continue;
         }
 
+        /* Drain the whole queue before flushing, so a burst of messages
+           (e.g. an IDE creating dozens of windows at once) issues its X
+           requests as one batch and its window positioning as one
+           DeferWindowPos transaction */
+        while (pNode != NULL) {
+            winMultiWindowWMProcessMessage(pWMInfo, pNode, &hDWP);
+            free(pNode);
+            pNode = TryPopMessage(&pWMInfo->wmMsgQueue);
+        }
+
+        /* Apply all the deferred window positioning in one go */
+        if (hDWP != NULL)
+            EndDeferWindowPos(hDWP);
+
+        /* Deliver rate-limited title pushes whose interval has passed */
+        if (pWMInfo->cDirtyNames > 0)
+            FlushThrottledNames(pWMInfo);
+
         /* Flush any pending events on our display */
         xcb_flush(pWMInfo->conn);
 
@@ -1138,9 +1517,6 @@ winMultiWindowWMProc(void *pArg)
             }
         }
 
-        /* Free the retrieved message */
-        free(pNode);
-
         /* I/O errors etc. */
         {
             int e = xcb_connection_has_error(pWMInfo->conn);
@@ -1493,14 +1869,20 @@ winMultiWindowXMsgProc(void *pArg)
         else if (type ==  XCB_PROPERTY_NOTIFY) {
             xcb_property_notify_event_t *notify = (xcb_property_notify_event_t *)event;
 
-            xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(pProcArg->conn, notify->atom);
-            xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(pProcArg->conn, cookie, NULL);
-            if (reply) {
-                winDebug("winMultiWindowXMsgProc: PropertyNotify %.*s\n",
-                         xcb_get_atom_name_name_length(reply),
-                         xcb_get_atom_name_name(reply));
-                free(reply);
+#ifdef WINDBG
+            /* Naming the atom costs a synchronous round trip per
+               PropertyNotify, so only do it when it can be logged */
+            {
+                xcb_get_atom_name_cookie_t cookie = xcb_get_atom_name(pProcArg->conn, notify->atom);
+                xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(pProcArg->conn, cookie, NULL);
+                if (reply) {
+                    winDebug("winMultiWindowXMsgProc: PropertyNotify %.*s\n",
+                             xcb_get_atom_name_name_length(reply),
+                             xcb_get_atom_name_name(reply));
+                    free(reply);
+                }
             }
+#endif
 
             if ((notify->atom == atmWmName) ||
                 (notify->atom == atmNetWmName)) {
@@ -1883,6 +2265,20 @@ winSendMessageToWM(void *pWMInfo, winWMMessagePtr pMsg)
 
     winDebug("winSendMessageToWM %s\n", MessageName(pMsg));
 
+    /* Property refresh messages are idempotent - processing one fetches
+       whatever is current - so a burst of PropertyNotify (a client
+       ticking a progress indicator in its title) collapses into a
+       single queued refresh instead of a queue full of re-fetches */
+    switch (pMsg->msg) {
+    case WM_WM_NAME_EVENT:
+    case WM_WM_ICON_EVENT:
+    case WM_WM_HINTS_EVENT:
+        if (HaveMessage(&((WMInfoPtr) pWMInfo)->wmMsgQueue,
+                        pMsg->msg, pMsg->iWindow))
+            return;
+        break;
+    }
+
     pNode = malloc(sizeof(WMMsgNodeRec));
     if (pNode != NULL) {
         memcpy(&pNode->msg, pMsg, sizeof(winWMMessageRec));
@@ -1975,6 +2371,8 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     unsigned long style, exStyle;
     unsigned long oristyle, oriexStyle;
     Bool nodecoration = FALSE;
+    xcb_get_property_cookie_t cookie_wm_state, cookie_mwm_hint,
+        cookie_window_type, cookie_normal_hints;
 
     *maxmin = 0;
 
@@ -1995,8 +2393,15 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
         splashType = intern_atom(conn, "_NET_WM_WINDOW_TYPE_SPLASHSCREEN");
     }
 
+    /* Issue all the property requests up front, then collect the
+       replies: the requests travel to the server as one batch, so the
+       round trips overlap instead of being paid one by one */
+    cookie_wm_state = xcb_get_property(conn, FALSE, iWindow, windowState, XCB_ATOM_ATOM, 0L, INT_MAX);
+    cookie_mwm_hint = xcb_get_property(conn, FALSE, iWindow, motif_wm_hints, motif_wm_hints, 0L, sizeof(MwmHints));
+    cookie_window_type = xcb_ewmh_get_wm_window_type(&pWMInfo->ewmh, iWindow);
+    cookie_normal_hints = xcb_icccm_get_wm_normal_hints(conn, iWindow);
+
     {
-      xcb_get_property_cookie_t cookie_wm_state = xcb_get_property(conn, FALSE, iWindow, windowState, XCB_ATOM_ATOM, 0L, INT_MAX);
       xcb_get_property_reply_t *reply = xcb_get_property_reply(conn, cookie_wm_state, NULL);
       if (reply) {
         int i;
@@ -2030,7 +2435,6 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     }
 
     {
-      xcb_get_property_cookie_t cookie_mwm_hint = xcb_get_property(conn, FALSE, iWindow, motif_wm_hints, motif_wm_hints, 0L, sizeof(MwmHints));
       xcb_get_property_reply_t *reply =  xcb_get_property_reply(conn, cookie_mwm_hint, NULL);
       if (reply) {
         int nitems = xcb_get_property_value_length(reply)/4;
@@ -2100,8 +2504,7 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
     {
       int i;
       xcb_ewmh_get_atoms_reply_t type;
-      xcb_get_property_cookie_t cookie = xcb_ewmh_get_wm_window_type(&pWMInfo->ewmh, iWindow);
-      if (xcb_ewmh_get_wm_window_type_reply(&pWMInfo->ewmh, cookie, &type, NULL)) {
+      if (xcb_ewmh_get_wm_window_type_reply(&pWMInfo->ewmh, cookie_window_type, &type, NULL)) {
         for (i = 0; i < type.atoms_len; i++) {
             if (type.atoms[i] ==  pWMInfo->ewmh._NET_WM_WINDOW_TYPE_DOCK) {
                 hint &= ~(HINT_BORDER | HINT_SIZEBOX | HINT_CAPTION | HINT_NOFRAME);
@@ -2120,10 +2523,8 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
 
     {
         xcb_size_hints_t size_hints;
-        xcb_get_property_cookie_t cookie;
 
-        cookie = xcb_icccm_get_wm_normal_hints(conn, iWindow);
-        if (xcb_icccm_get_wm_normal_hints_reply(conn, cookie, &size_hints, NULL)) {
+        if (xcb_icccm_get_wm_normal_hints_reply(conn, cookie_normal_hints, &size_hints, NULL)) {
             /* Notwithstanding MwmDecorHandle, if we have a border, and
                WM_NORMAL_HINTS indicates the window should be resizeable, let
                the window have a resizing border.  This is necessary for windows
@@ -2290,6 +2691,36 @@ winApplyHints(WMInfoPtr pWMInfo, xcb_window_t iWindow, HWND hWnd, HWND * zstyle,
 
 void
 winUpdateWindowPosition(HWND hWnd, HWND * zstyle)
+{
+    winUpdateWindowPositionBatch(hWnd, zstyle, NULL, 0);
+}
+
+/*
+ * Issue a deferred window positioning operation, falling back to an
+ * immediate SetWindowPos when no transaction is open or it has failed
+ */
+
+static void
+winDeferWindowPos(HDWP * phDWP, HWND hWnd, HWND hWndInsertAfter,
+                  int x, int y, int cx, int cy, UINT uFlags)
+{
+    if (phDWP != NULL) {
+        if (*phDWP == NULL)
+            *phDWP = BeginDeferWindowPos(1);
+        if (*phDWP != NULL) {
+            *phDWP = DeferWindowPos(*phDWP, hWnd, hWndInsertAfter,
+                                    x, y, cx, cy, uFlags);
+            if (*phDWP != NULL)
+                return;
+            /* The transaction failed, so apply this operation immediately */
+        }
+    }
+    SetWindowPos(hWnd, hWndInsertAfter, x, y, cx, cy, uFlags);
+}
+
+static void
+winUpdateWindowPositionBatch(HWND hWnd, HWND * zstyle, HDWP * phDWP,
+                             UINT uExtraFlags)
 {
     int iX, iY, iWidth, iHeight;
     int iDx, iDy;
@@ -2338,7 +2769,7 @@ winUpdateWindowPosition(HWND hWnd, HWND * zstyle)
     }
 
     /* Position the Windows window */
-    SetWindowPos(hWnd, *zstyle, rcNew.left, rcNew.top,
-                 rcNew.right - rcNew.left, rcNew.bottom - rcNew.top, 0);
-
+    winDeferWindowPos(phDWP, hWnd, *zstyle, rcNew.left, rcNew.top,
+                      rcNew.right - rcNew.left, rcNew.bottom - rcNew.top,
+                      uExtraFlags);
 }
@@ -48,6 +48,13 @@
 #include "inputstr.h"
 #include <dwmapi.h>
 
+#ifndef WM_DWMSENDICONICTHUMBNAIL
+#define WM_DWMSENDICONICTHUMBNAIL 0x0323
+#endif
+#ifndef WM_DWMSENDICONICLIVEPREVIEWBITMAP
+#define WM_DWMSENDICONICLIVEPREVIEWBITMAP 0x0326
+#endif
+
 #ifndef WM_DWMCOMPOSITIONCHANGED
 #define WM_DWMCOMPOSITIONCHANGED 0x031e
 #endif
@@ -638,6 +645,24 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
                 (*s_pScreenPriv->pwinBltExposedWindowRegion) (s_pScreen, pWin);
         return 0;
 
+    case WM_DWMSENDICONICTHUMBNAIL:
+        /* DWM wants a taskbar thumbnail; build it from the window's
+           already-rendered contents so the client never has to repaint
+           for a preview.  lParam carries the maximum size. */
+        if (winSendIconicPreview(pWin, hwnd,
+                                 HIWORD(lParam), LOWORD(lParam), FALSE))
+            return 0;
+        break;
+
+    case WM_DWMSENDICONICLIVEPREVIEWBITMAP:
+        /* Aero Peek wants the window at full size */
+        if (pWin != NULL &&
+            winSendIconicPreview(pWin, hwnd,
+                                 pWin->drawable.width,
+                                 pWin->drawable.height, TRUE))
+            return 0;
+        break;
+
     case WM_MOUSEMOVE:
         if (wParam & (MK_LBUTTON|MK_RBUTTON|MK_MBUTTON))
         {
@@ -895,6 +920,12 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
          */
         return 0;
 
+    case WM_INPUTLANGCHANGE:
+        /* The keyboard layout changed: rebuild the key translation
+           tables before the next keystroke */
+        winInvalidateKeyMap();
+        break;
+
     case WM_SYSKEYDOWN:
     case WM_KEYDOWN:
 
@@ -1158,8 +1189,10 @@ winTopLevelWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         SetWindowLongPtr(hwnd, WND_IDX_ENTEREDSIZEMOVE, FALSE);
         winAdjustXWindow(pWin, hwnd);
         KillTimer(hwnd, UPDATETIMER);
-        if (pWin)
+        if (pWin) {
             winAdjustXWindowState(s_pScreenPriv, &wmMsg);
+            winPlacementRemember(pWin, hwnd);
+        }
         return 0;
 
     case WM_SIZE:
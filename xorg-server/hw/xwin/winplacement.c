@@ -0,0 +1,289 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "winmultiwindowclass.h"
+
+/*
+ * Persistent window placement for the multiwindow mode.
+ *
+ * A session restore maps dozens of windows at the origin or at
+ * CW_USEDEFAULT and then reshuffles them one by one as each
+ * application reasserts its geometry; the user watches the storm for
+ * seconds.  Instead, the frame rectangle and maximized state of every
+ * top-level window are remembered per WM_CLASS (name, class) pair in
+ * ~/.XWinplacement when the window is destroyed or finishes a
+ * user move, and the next window created with the same class hints
+ * and no user- or program-specified position is placed there before
+ * it is first shown, so nothing moves after the fact.
+ */
+
+#define PLACEMENT_MAGIC		0x4c505758      /* 'XWPL' */
+#define PLACEMENT_VERSION	1
+#define PLACEMENT_MAX_RECORDS	1024
+#define PLACEMENT_NAME_LEN	80
+#define PLACEMENT_FILE		".XWinplacement"
+
+typedef struct {
+    unsigned int dwMagic;
+    unsigned int dwVersion;
+    unsigned int dwRecords;
+    unsigned int cbRecord;      /* record size of the writer */
+} winPlacementHeader;
+
+typedef struct {
+    char szName[PLACEMENT_NAME_LEN];    /* WM_CLASS instance */
+    char szClass[PLACEMENT_NAME_LEN];   /* WM_CLASS class */
+    RECT rcFrame;               /* frame rect, virtual screen coords */
+    DWORD dwShowCmd;            /* SW_SHOWMAXIMIZED or SW_SHOWNORMAL */
+} winPlacementRec;
+
+static winPlacementRec *g_pPlacements = NULL;
+static unsigned int g_uiPlacements = 0;
+static Bool g_fPlacementLoaded = FALSE;
+static Bool g_fPlacementDirty = FALSE;
+
+/*
+ * Build the path of the placement store.  Returns FALSE (and the
+ * store stays disabled) when no home directory is set.
+ */
+
+static Bool
+winPlacementPath(char *pszPath, size_t cbPath)
+{
+    char *pszHome = getenv("HOME");
+
+    if (pszHome == NULL || pszHome[0] == '\0')
+        return FALSE;
+
+    snprintf(pszPath, cbPath, "%s%s%s", pszHome,
+             (pszHome[strlen(pszHome) - 1] == '\\') ? "" : "\\",
+             PLACEMENT_FILE);
+    pszPath[cbPath - 1] = '\0';
+    return TRUE;
+}
+
+/*
+ * Read the store into memory once; damaged or mismatched files are
+ * discarded and simply start an empty store.
+ */
+
+static void
+winPlacementLoad(void)
+{
+    char szPath[MAX_PATH];
+    FILE *pFile;
+    winPlacementHeader hdr;
+
+    if (g_fPlacementLoaded)
+        return;
+    g_fPlacementLoaded = TRUE;
+
+    if (!winPlacementPath(szPath, sizeof(szPath)))
+        return;
+
+    pFile = fopen(szPath, "rb");
+    if (pFile == NULL)
+        return;
+
+    if (fread(&hdr, sizeof(hdr), 1, pFile) != 1
+        || hdr.dwMagic != PLACEMENT_MAGIC
+        || hdr.dwVersion != PLACEMENT_VERSION
+        || hdr.cbRecord != sizeof(winPlacementRec)
+        || hdr.dwRecords > PLACEMENT_MAX_RECORDS) {
+        fclose(pFile);
+        return;
+    }
+
+    g_pPlacements = malloc(hdr.dwRecords * sizeof(winPlacementRec));
+    if (g_pPlacements == NULL) {
+        fclose(pFile);
+        return;
+    }
+
+    g_uiPlacements = fread(g_pPlacements, sizeof(winPlacementRec),
+                           hdr.dwRecords, pFile);
+    fclose(pFile);
+
+    winDebug("winPlacementLoad - %d placements from %s\n",
+             (int) g_uiPlacements, szPath);
+}
+
+/*
+ * Write the store back out if anything changed.  Called per update;
+ * the file is small and a crash then loses nothing.
+ */
+
+static void
+winPlacementSave(void)
+{
+    char szPath[MAX_PATH];
+    FILE *pFile;
+    winPlacementHeader hdr;
+
+    if (!g_fPlacementDirty || !winPlacementPath(szPath, sizeof(szPath)))
+        return;
+
+    pFile = fopen(szPath, "wb");
+    if (pFile == NULL)
+        return;
+
+    hdr.dwMagic = PLACEMENT_MAGIC;
+    hdr.dwVersion = PLACEMENT_VERSION;
+    hdr.dwRecords = g_uiPlacements;
+    hdr.cbRecord = sizeof(winPlacementRec);
+
+    if (fwrite(&hdr, sizeof(hdr), 1, pFile) == 1)
+        fwrite(g_pPlacements, sizeof(winPlacementRec), g_uiPlacements, pFile);
+    fclose(pFile);
+
+    g_fPlacementDirty = FALSE;
+}
+
+static winPlacementRec *
+winPlacementFind(const char *pszName, const char *pszClass)
+{
+    unsigned int i;
+
+    for (i = 0; i < g_uiPlacements; i++)
+        if (strcmp(g_pPlacements[i].szName, pszName) == 0
+            && strcmp(g_pPlacements[i].szClass, pszClass) == 0)
+            return &g_pPlacements[i];
+    return NULL;
+}
+
+/*
+ * Look up the remembered frame rectangle for a window's class hints.
+ * Returns FALSE when nothing is remembered or the remembered monitor
+ * is gone.
+ */
+
+Bool
+winPlacementQuery(WindowPtr pWin, RECT * prcFrame, DWORD *pdwShowCmd)
+{
+    char *pszName, *pszClass;
+    winPlacementRec *pRec;
+    Bool fFound = FALSE;
+
+    winPlacementLoad();
+
+    if (g_uiPlacements == 0)
+        return FALSE;
+
+    if (!winMultiWindowGetClassHint(pWin, &pszName, &pszClass))
+        return FALSE;
+
+    pRec = winPlacementFind(pszName, pszClass);
+    if (pRec != NULL
+        && MonitorFromRect(&pRec->rcFrame, MONITOR_DEFAULTTONULL) != NULL) {
+        *prcFrame = pRec->rcFrame;
+        *pdwShowCmd = pRec->dwShowCmd;
+        fFound = TRUE;
+    }
+
+    free(pszName);
+    free(pszClass);
+    return fFound;
+}
+
+/*
+ * Remember the current placement of a window.  Called when the
+ * Windows window is destroyed and when the user finishes dragging it.
+ */
+
+void
+winPlacementRemember(WindowPtr pWin, HWND hWnd)
+{
+    char *pszName, *pszClass;
+    winPlacementRec *pRec;
+    WINDOWPLACEMENT wp;
+    RECT rcFrame;
+    DWORD dwShowCmd;
+
+    winPlacementLoad();
+
+    if (pWin == NULL || hWnd == NULL || pWin->overrideRedirect)
+        return;
+
+    wp.length = sizeof(wp);
+    if (!GetWindowPlacement(hWnd, &wp))
+        return;
+
+    /* The normal position is in workspace coordinates; prefer the
+       true frame rect while the window actually is in normal state */
+    dwShowCmd = IsZoomed(hWnd) ? SW_SHOWMAXIMIZED : SW_SHOWNORMAL;
+    if (dwShowCmd == SW_SHOWNORMAL && !IsIconic(hWnd)) {
+        if (!GetWindowRect(hWnd, &rcFrame))
+            return;
+    }
+    else
+        rcFrame = wp.rcNormalPosition;
+
+    if (!winMultiWindowGetClassHint(pWin, &pszName, &pszClass))
+        return;
+
+    pRec = winPlacementFind(pszName, pszClass);
+    if (pRec == NULL) {
+        if (g_uiPlacements >= PLACEMENT_MAX_RECORDS) {
+            /* Full: drop the oldest record */
+            memmove(g_pPlacements, g_pPlacements + 1,
+                    --g_uiPlacements * sizeof(winPlacementRec));
+        }
+        else {
+            winPlacementRec *pNew =
+                realloc(g_pPlacements,
+                        (g_uiPlacements + 1) * sizeof(winPlacementRec));
+
+            if (pNew == NULL) {
+                free(pszName);
+                free(pszClass);
+                return;
+            }
+            g_pPlacements = pNew;
+        }
+        pRec = &g_pPlacements[g_uiPlacements++];
+        memset(pRec, 0, sizeof(*pRec));
+        strncpy(pRec->szName, pszName, PLACEMENT_NAME_LEN - 1);
+        strncpy(pRec->szClass, pszClass, PLACEMENT_NAME_LEN - 1);
+    }
+
+    if (memcmp(&pRec->rcFrame, &rcFrame, sizeof(RECT)) != 0
+        || pRec->dwShowCmd != dwShowCmd) {
+        pRec->rcFrame = rcFrame;
+        pRec->dwShowCmd = dwShowCmd;
+        g_fPlacementDirty = TRUE;
+    }
+
+    free(pszName);
+    free(pszClass);
+
+    winPlacementSave();
+}
@@ -659,17 +659,266 @@ winIconIsOverride(HICON hicon)
     return 0;
 }
 
+/*
+ * Compiled preferences cache
+ *
+ * Parsing a large site-wide XWinrc through the yacc grammar costs
+ * enough to be felt at server start and again on every RELOAD, so the
+ * result of a successful parse is flattened into a binary blob beside
+ * the source file and reloaded from there while the source is
+ * unchanged.  The blob is the WINPREFS structure followed by its
+ * arrays, validated against the source's last-write time and size and
+ * against the structure sizes of the server that wrote it; anything
+ * suspect falls back to the yacc parser, which rewrites the cache.
+ */
+
+#define PREFS_CACHE_MAGIC   0x43525758  /* "XWRC" */
+#define PREFS_CACHE_VERSION 1
+
+/* An XWinrc defining more items than this is not a preferences file */
+#define PREFS_CACHE_MAX_ITEMS 65536
+
+typedef struct {
+    unsigned int dwMagic;
+    unsigned int dwVersion;
+    unsigned int cbPrefs;       /* structure sizes of the writer; a
+                                   rebuilt server must reparse */
+    unsigned int cbMenuParsed;
+    unsigned int cbMenuItem;
+    FILETIME ftSourceWrite;     /* identity of the source XWinrc */
+    DWORD dwSourceSizeLow;
+    DWORD dwSourceSizeHigh;
+} winPrefsCacheHeader;
+
+/*
+ * Free a partially reconstructed preferences structure and leave the
+ * global cleared for the parser
+ */
+static void
+winPrefsCacheAbort(void)
+{
+    int i;
+
+    if (pref.menu)
+        for (i = 0; i < pref.menuItems; i++)
+            free(pref.menu[i].menuItem);
+    free(pref.menu);
+    free(pref.sysMenu);
+    free(pref.icon);
+    free(pref.style);
+    free(pref.taskbar);
+    memset(&pref, 0, sizeof(pref));
+}
+
+/*
+ * Load the compiled preferences beside @path into the global pref
+ * structure.  Returns FALSE (with pref cleared) unless the cache
+ * matches the current source file exactly.
+ */
+static int
+winPrefsReadCache(const char *szCachePath,
+                  const WIN32_FILE_ATTRIBUTE_DATA * pSrcInfo)
+{
+    FILE *pCache;
+    winPrefsCacheHeader hdr;
+    int i;
+
+    pCache = fopen(szCachePath, "rb");
+    if (!pCache)
+        return FALSE;
+
+    if (fread(&hdr, sizeof(hdr), 1, pCache) != 1
+        || hdr.dwMagic != PREFS_CACHE_MAGIC
+        || hdr.dwVersion != PREFS_CACHE_VERSION
+        || hdr.cbPrefs != sizeof(WINPREFS)
+        || hdr.cbMenuParsed != sizeof(MENUPARSED)
+        || hdr.cbMenuItem != sizeof(MENUITEM)
+        || CompareFileTime(&hdr.ftSourceWrite,
+                           &pSrcInfo->ftLastWriteTime) != 0
+        || hdr.dwSourceSizeLow != pSrcInfo->nFileSizeLow
+        || hdr.dwSourceSizeHigh != pSrcInfo->nFileSizeHigh) {
+        fclose(pCache);
+        return FALSE;
+    }
+
+    if (fread(&pref, sizeof(pref), 1, pCache) != 1
+        || pref.menuItems < 0 || pref.menuItems > PREFS_CACHE_MAX_ITEMS
+        || pref.sysMenuItems < 0 || pref.sysMenuItems > PREFS_CACHE_MAX_ITEMS
+        || pref.iconItems < 0 || pref.iconItems > PREFS_CACHE_MAX_ITEMS
+        || pref.styleItems < 0 || pref.styleItems > PREFS_CACHE_MAX_ITEMS
+        || pref.taskbarItems < 0
+        || pref.taskbarItems > PREFS_CACHE_MAX_ITEMS) {
+        memset(&pref, 0, sizeof(pref));
+        fclose(pCache);
+        return FALSE;
+    }
+
+    /* The blob's pointers belonged to the writer; rebuild them before
+       anything can follow them */
+    pref.menu = NULL;
+    pref.sysMenu = NULL;
+    pref.icon = NULL;
+    pref.style = NULL;
+    pref.taskbar = NULL;
+
+    if (pref.menuItems) {
+        int fRead;
+
+        pref.menu = malloc(pref.menuItems * sizeof(MENUPARSED));
+        if (!pref.menu)
+            goto winPrefsReadCache_Fail;
+        fRead = fread(pref.menu, sizeof(MENUPARSED), pref.menuItems,
+                      pCache) == pref.menuItems;
+        /* The blob holds the writer's item pointers; clear them before
+           any failure path can try to free them */
+        for (i = 0; i < pref.menuItems; i++)
+            pref.menu[i].menuItem = NULL;
+        if (!fRead)
+            goto winPrefsReadCache_Fail;
+        for (i = 0; i < pref.menuItems; i++) {
+            if (pref.menu[i].menuItems < 0
+                || pref.menu[i].menuItems > PREFS_CACHE_MAX_ITEMS)
+                goto winPrefsReadCache_Fail;
+            if (pref.menu[i].menuItems == 0)
+                continue;
+            pref.menu[i].menuItem =
+                malloc(pref.menu[i].menuItems * sizeof(MENUITEM));
+            if (!pref.menu[i].menuItem
+                || fread(pref.menu[i].menuItem, sizeof(MENUITEM),
+                         pref.menu[i].menuItems,
+                         pCache) != pref.menu[i].menuItems)
+                goto winPrefsReadCache_Fail;
+        }
+    }
+
+    if (pref.sysMenuItems) {
+        pref.sysMenu = malloc(pref.sysMenuItems * sizeof(SYSMENUITEM));
+        if (!pref.sysMenu
+            || fread(pref.sysMenu, sizeof(SYSMENUITEM), pref.sysMenuItems,
+                     pCache) != pref.sysMenuItems)
+            goto winPrefsReadCache_Fail;
+    }
+
+    if (pref.iconItems) {
+        pref.icon = malloc(pref.iconItems * sizeof(ICONITEM));
+        if (!pref.icon
+            || fread(pref.icon, sizeof(ICONITEM), pref.iconItems,
+                     pCache) != pref.iconItems)
+            goto winPrefsReadCache_Fail;
+        /* Icon handles are loaded lazily at match time, never cached */
+        for (i = 0; i < pref.iconItems; i++)
+            pref.icon[i].hicon = 0;
+    }
+
+    if (pref.styleItems) {
+        pref.style = malloc(pref.styleItems * sizeof(STYLEITEM));
+        if (!pref.style
+            || fread(pref.style, sizeof(STYLEITEM), pref.styleItems,
+                     pCache) != pref.styleItems)
+            goto winPrefsReadCache_Fail;
+    }
+
+    if (pref.taskbarItems) {
+        pref.taskbar = malloc(pref.taskbarItems * sizeof(TASKBARITEM));
+        if (!pref.taskbar
+            || fread(pref.taskbar, sizeof(TASKBARITEM), pref.taskbarItems,
+                     pCache) != pref.taskbarItems)
+            goto winPrefsReadCache_Fail;
+    }
+
+    fclose(pCache);
+    return TRUE;
+
+ winPrefsReadCache_Fail:
+    fclose(pCache);
+    winPrefsCacheAbort();
+    return FALSE;
+}
+
+/*
+ * Flatten the just-parsed pref structure into the cache beside the
+ * source file.  Failure only costs the next start a reparse, so a
+ * half-written cache is simply deleted.
+ */
+static void
+winPrefsWriteCache(const char *szCachePath,
+                   const WIN32_FILE_ATTRIBUTE_DATA * pSrcInfo)
+{
+    FILE *pCache;
+    winPrefsCacheHeader hdr;
+    int i;
+    int fOk;
+
+    pCache = fopen(szCachePath, "wb");
+    if (!pCache)
+        return;
+
+    hdr.dwMagic = PREFS_CACHE_MAGIC;
+    hdr.dwVersion = PREFS_CACHE_VERSION;
+    hdr.cbPrefs = sizeof(WINPREFS);
+    hdr.cbMenuParsed = sizeof(MENUPARSED);
+    hdr.cbMenuItem = sizeof(MENUITEM);
+    hdr.ftSourceWrite = pSrcInfo->ftLastWriteTime;
+    hdr.dwSourceSizeLow = pSrcInfo->nFileSizeLow;
+    hdr.dwSourceSizeHigh = pSrcInfo->nFileSizeHigh;
+
+    fOk = fwrite(&hdr, sizeof(hdr), 1, pCache) == 1
+        && fwrite(&pref, sizeof(pref), 1, pCache) == 1;
+    if (fOk && pref.menuItems)
+        fOk = fwrite(pref.menu, sizeof(MENUPARSED), pref.menuItems,
+                     pCache) == pref.menuItems;
+    for (i = 0; fOk && i < pref.menuItems; i++)
+        if (pref.menu[i].menuItems)
+            fOk = fwrite(pref.menu[i].menuItem, sizeof(MENUITEM),
+                         pref.menu[i].menuItems,
+                         pCache) == pref.menu[i].menuItems;
+    if (fOk && pref.sysMenuItems)
+        fOk = fwrite(pref.sysMenu, sizeof(SYSMENUITEM), pref.sysMenuItems,
+                     pCache) == pref.sysMenuItems;
+    if (fOk && pref.iconItems)
+        fOk = fwrite(pref.icon, sizeof(ICONITEM), pref.iconItems,
+                     pCache) == pref.iconItems;
+    if (fOk && pref.styleItems)
+        fOk = fwrite(pref.style, sizeof(STYLEITEM), pref.styleItems,
+                     pCache) == pref.styleItems;
+    if (fOk && pref.taskbarItems)
+        fOk = fwrite(pref.taskbar, sizeof(TASKBARITEM), pref.taskbarItems,
+                     pCache) == pref.taskbarItems;
+
+    if (fclose(pCache) != 0)
+        fOk = FALSE;
+    if (!fOk) {
+        ErrorF("LoadPreferences: Could not write %s\n", szCachePath);
+        remove(szCachePath);
+    }
+}
+
 /*
  * Open and parse the XWinrc config file @path.
  * If @path is NULL, use the built-in default.
+ * A valid compiled cache beside the file short-circuits the parse.
  */
 static int
 winPrefsLoadPreferences(const char *path)
 {
     FILE *prefFile = NULL;
-
-    if (path)
+    char szCachePath[PATH_MAX + NAME_MAX + 8];
+    WIN32_FILE_ATTRIBUTE_DATA srcInfo;
+    int fHaveSrcInfo = FALSE;
+
+    if (path) {
+        if (GetFileAttributesEx(path, GetFileExInfoStandard, &srcInfo)
+            && !(srcInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            fHaveSrcInfo = TRUE;
+            snprintf(szCachePath, sizeof(szCachePath), "%s.cache", path);
+            if (winPrefsReadCache(szCachePath, &srcInfo)) {
+                winDebug("LoadPreferences: Loaded compiled %s\n",
+                         szCachePath);
+                return TRUE;
+            }
+        }
         prefFile = fopen(path, "r");
+    }
 #ifdef __CYGWIN__
     else {
         char defaultPrefs[] =
@@ -698,6 +947,12 @@ winPrefsLoadPreferences(const char *path)
     }
 
     fclose(prefFile);
+
+    /* Compile what we just parsed so the next start and the next
+       RELOAD skip the grammar */
+    if (fHaveSrcInfo)
+        winPrefsWriteCache(szCachePath, &srcInfo);
+
     return TRUE;
 }
 
@@ -0,0 +1,333 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+
+#ifdef PRESENT
+#include "present.h"
+#include "list.h"
+#include <dwmapi.h>
+
+/*
+ * Present extension support for the shadow framebuffer engines.
+ *
+ * Without driver hooks the Present core falls back to its "fake" CRTC,
+ * which paces PresentPixmap completions off a free-running 60Hz timer
+ * regardless of what the Windows display is actually doing.  Here we
+ * hand the core the RandR CRTC created by winRandRInit() and implement
+ * the timing hooks against the real refresh rate of the monitor the
+ * screen lives on, so clients throttled by PresentCompleteNotify run at
+ * the display's native rate instead of a made-up one.
+ *
+ * We do not implement the flip hooks: every engine scans out of its
+ * own surface (GDI DIB section, DirectDraw primary, DXGI swapchain
+ * back buffer) and blits the shadow framebuffer into it, so there is
+ * no scanout buffer whose storage could be swapped for a client
+ * pixmap.  check_flip therefore declines every flip and Present copies
+ * into the screen pixmap, which the shadow layer then pushes out as
+ * damage in the usual way.
+ */
+
+typedef struct _winPresentVblank {
+    struct xorg_list list;
+    uint64_t event_id;
+    OsTimerPtr timer;
+    ScreenPtr pScreen;
+} winPresentVblankRec, *winPresentVblankPtr;
+
+static struct xorg_list g_winPresentVblankQueue;
+static Bool g_fPresentVblankQueueInit = FALSE;
+
+/* Last known vblank of the DWM composition clock, in server-clock
+ * microseconds, plus the composition interval; zero when DWM timing is
+ * unavailable.  The compositor clock is per-desktop, not per-screen, so
+ * one copy serves all screens.
+ */
+static uint64_t g_qwDwmVblankUst = 0;
+static uint64_t g_qwDwmInterval = 0;
+static uint64_t g_qwDwmLastSync = 0;
+
+/*
+ * GetTimeInMicros() is derived from QueryPerformanceCounter on this
+ * platform, so QPC timestamps reported by DWM convert directly onto
+ * the server clock.  Split the scaling into quotient and remainder to
+ * avoid overflowing 64 bits.
+ */
+
+static uint64_t
+winPresentQpcToUst(uint64_t qpc)
+{
+    static LARGE_INTEGER freq;
+
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+
+    return (qpc / freq.QuadPart) * 1000000 +
+        (qpc % freq.QuadPart) * 1000000 / freq.QuadPart;
+}
+
+/*
+ * Refresh our snapshot of the DWM composition clock, at most once a
+ * second since composition can be toggled and the mode can change under
+ * us.  Returns TRUE when a usable vblank reference is available.
+ */
+
+static Bool
+winPresentSyncDwmClock(uint64_t now)
+{
+    DWM_TIMING_INFO ti;
+    BOOL fCompositionEnabled = FALSE;
+
+    if (g_qwDwmLastSync != 0 && now - g_qwDwmLastSync < 1000000)
+        return g_qwDwmVblankUst != 0;
+    g_qwDwmLastSync = now;
+
+    ZeroMemory(&ti, sizeof(ti));
+    ti.cbSize = sizeof(ti);
+
+    if (FAILED(DwmIsCompositionEnabled(&fCompositionEnabled))
+        || !fCompositionEnabled
+        || FAILED(DwmGetCompositionTimingInfo(NULL, &ti))
+        || ti.rateRefresh.uiNumerator == 0) {
+        g_qwDwmVblankUst = 0;
+        return FALSE;
+    }
+
+    g_qwDwmInterval = (1000000ULL * ti.rateRefresh.uiDenominator) /
+        ti.rateRefresh.uiNumerator;
+    if (g_qwDwmInterval == 0) {
+        g_qwDwmVblankUst = 0;
+        return FALSE;
+    }
+
+    g_qwDwmVblankUst = winPresentQpcToUst(ti.qpcVBlank);
+    return TRUE;
+}
+
+/*
+ * Ask Windows for the refresh rate of the monitor backing this screen
+ * and convert it to a vblank interval in microseconds.  Falls back to
+ * the primary display, then to 60Hz, if the query fails.
+ */
+
+static uint64_t
+winPresentQueryInterval(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    MONITORINFOEX mi;
+    DEVMODE dm;
+    DWORD dwRefresh = 0;
+
+    /* Prefer the DWM composition rate: it carries the exact fraction
+     * (e.g. 60000/1001 for 59.94Hz) where EnumDisplaySettings rounds to
+     * integer Hz, and it is the clock the desktop actually repaints on.
+     */
+    if (winPresentSyncDwmClock(GetTimeInMicros())) {
+        winDebug("winPresentQueryInterval - DWM composition interval %u us\n",
+                 (unsigned int) g_qwDwmInterval);
+        return g_qwDwmInterval;
+    }
+
+    ZeroMemory(&dm, sizeof(dm));
+    dm.dmSize = sizeof(dm);
+
+    mi.cbSize = sizeof(mi);
+    if (pScreenInfo->hMonitor
+        && GetMonitorInfo(pScreenInfo->hMonitor, (LPMONITORINFO) &mi)
+        && EnumDisplaySettings(mi.szDevice, ENUM_CURRENT_SETTINGS, &dm))
+        dwRefresh = dm.dmDisplayFrequency;
+    else if (EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &dm))
+        dwRefresh = dm.dmDisplayFrequency;
+
+    /* 0 and 1 both mean "hardware default" to Windows */
+    if (dwRefresh < 2)
+        dwRefresh = 60;
+
+    winDebug("winPresentQueryInterval - display refresh rate %u Hz\n",
+             (unsigned int) dwRefresh);
+
+    return 1000000 / dwRefresh;
+}
+
+/*
+ * Present a consistent ust/msc pairing derived from the server clock
+ * and the monitor's refresh interval, exactly as the fake CRTC does
+ * but at the real rate.
+ */
+
+static int
+winPresentGetUstMsc(RRCrtcPtr pCrtc, uint64_t * ust, uint64_t * msc)
+{
+    ScreenPtr pScreen = pCrtc->pScreen;
+    winScreenPriv(pScreen);
+
+    *ust = GetTimeInMicros();
+    *msc = (*ust + pScreenPriv->qwPresentInterval / 2) /
+        pScreenPriv->qwPresentInterval;
+
+    return Success;
+}
+
+static void
+winPresentNotify(ScreenPtr pScreen, uint64_t event_id)
+{
+    winScreenPriv(pScreen);
+    uint64_t ust, msc;
+
+    ust = GetTimeInMicros();
+    msc = (ust + pScreenPriv->qwPresentInterval / 2) /
+        pScreenPriv->qwPresentInterval;
+    present_event_notify(event_id, ust, msc);
+}
+
+static CARD32
+winPresentVblankTimer(OsTimerPtr timer, CARD32 time, void *arg)
+{
+    winPresentVblankPtr pVblank = arg;
+
+    winPresentNotify(pVblank->pScreen, pVblank->event_id);
+    xorg_list_del(&pVblank->list);
+    TimerFree(pVblank->timer);
+    free(pVblank);
+    return 0;
+}
+
+static int
+winPresentQueueVblank(RRCrtcPtr pCrtc, uint64_t event_id, uint64_t msc)
+{
+    ScreenPtr pScreen = pCrtc->pScreen;
+    winScreenPriv(pScreen);
+    uint64_t ust = msc * pScreenPriv->qwPresentInterval;
+    uint64_t now = GetTimeInMicros();
+    INT32 delay;
+    winPresentVblankPtr pVblank;
+
+    /* Snap the deadline forward to the next tick of the compositor
+     * clock, so completions land on real vblanks instead of beating
+     * against them, and vblanks queued for the same frame collapse
+     * onto one timer expiry.
+     */
+    if (winPresentSyncDwmClock(now) && ust > g_qwDwmVblankUst)
+        ust = g_qwDwmVblankUst +
+            ((ust - g_qwDwmVblankUst + g_qwDwmInterval - 1) /
+             g_qwDwmInterval) * g_qwDwmInterval;
+
+    delay = ((int64_t) (ust - now)) / 1000;
+
+    if (delay <= 0) {
+        winPresentNotify(pScreen, event_id);
+        return Success;
+    }
+
+    pVblank = calloc(1, sizeof(winPresentVblankRec));
+    if (!pVblank)
+        return BadAlloc;
+
+    pVblank->pScreen = pScreen;
+    pVblank->event_id = event_id;
+    pVblank->timer = TimerSet(NULL, 0, delay, winPresentVblankTimer, pVblank);
+    if (!pVblank->timer) {
+        free(pVblank);
+        return BadAlloc;
+    }
+
+    xorg_list_add(&pVblank->list, &g_winPresentVblankQueue);
+
+    return Success;
+}
+
+static void
+winPresentAbortVblank(RRCrtcPtr pCrtc, uint64_t event_id, uint64_t msc)
+{
+    winPresentVblankPtr pVblank, tmp;
+
+    xorg_list_for_each_entry_safe(pVblank, tmp, &g_winPresentVblankQueue,
+                                  list) {
+        if (pVblank->event_id == event_id) {
+            TimerFree(pVblank->timer);  /* TimerFree will call TimerCancel() */
+            xorg_list_del(&pVblank->list);
+            free(pVblank);
+            break;
+        }
+    }
+}
+
+static RRCrtcPtr
+winPresentGetCrtc(WindowPtr pWindow)
+{
+    ScreenPtr pScreen = pWindow->drawable.pScreen;
+    rrScrPrivPtr pRRScrPriv = rrGetScrPriv(pScreen);
+
+    if (!pRRScrPriv || pRRScrPriv->numCrtcs < 1)
+        return NULL;
+
+    return pRRScrPriv->crtcs[0];
+}
+
+static Bool
+winPresentCheckFlip(RRCrtcPtr pCrtc, WindowPtr pWindow, PixmapPtr pPixmap,
+                    Bool sync_flip)
+{
+    /* The shadow engines cannot scan out of a client pixmap */
+    return FALSE;
+}
+
+static present_screen_info_rec g_winPresentScreenInfo = {
+    PRESENT_SCREEN_INFO_VERSION,
+    winPresentGetCrtc,
+    winPresentGetUstMsc,
+    winPresentQueueVblank,
+    winPresentAbortVblank,
+    NULL,                       /* flush */
+    PresentCapabilityNone,
+    winPresentCheckFlip,
+    NULL,                       /* flip */
+    NULL,                       /* unflip */
+    NULL,                       /* check_flip2 */
+};
+
+Bool
+winPresentInit(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    if (!g_fPresentVblankQueueInit) {
+        xorg_list_init(&g_winPresentVblankQueue);
+        g_fPresentVblankQueueInit = TRUE;
+    }
+
+    pScreenPriv->qwPresentInterval = winPresentQueryInterval(pScreen);
+
+    return present_screen_init(pScreen, &g_winPresentScreenInfo);
+}
+
+#endif /* PRESENT */
@@ -121,6 +121,7 @@ winInitializeScreenDefaults(void)
     defaultScreenInfo.fUserGavePosition = FALSE;
     defaultScreenInfo.dwBPP = WIN_DEFAULT_BPP;
     defaultScreenInfo.dwClipUpdatesNBoxes = WIN_DEFAULT_CLIP_UPDATES_NBOXES;
+    defaultScreenInfo.dwScale = WIN_DEFAULT_SCALE;
 #ifdef XWIN_EMULATEPSEUDO
     defaultScreenInfo.fEmulatePseudo = WIN_DEFAULT_EMULATE_PSEUDO;
 #endif
@@ -652,6 +653,46 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 1;
     }
 
+    /*
+     * Look for the '-parallelupdates' argument
+     */
+    if (IS_OPTION("-parallelupdates")) {
+        screenInfoPtr->fParallelUpdates = TRUE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
+
+    /*
+     * Look for the '-noparallelupdates' argument
+     */
+    if (IS_OPTION("-noparallelupdates")) {
+        screenInfoPtr->fParallelUpdates = FALSE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
+
+    /*
+     * Look for the '-d3dcompositing' argument
+     */
+    if (IS_OPTION("-d3dcompositing")) {
+        screenInfoPtr->fD3DComposite = TRUE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
+
+    /*
+     * Look for the '-nod3dcompositing' argument
+     */
+    if (IS_OPTION("-nod3dcompositing")) {
+        screenInfoPtr->fD3DComposite = FALSE;
+
+        /* Indicate that we have processed this argument */
+        return 1;
+    }
+
     /*
      * Look for the '-scrollbars' argument
      */
@@ -853,6 +894,35 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 2;
     }
 
+    /*
+     * Look for the '-scaling percent' argument
+     */
+    if (IS_OPTION("-scaling")) {
+        DWORD dwScale = 0;
+
+        /* Display the usage message if the argument is malformed */
+        if (++i >= argc) {
+            UseMsg();
+            return 0;
+        }
+
+        /* Grab the argument */
+        dwScale = atoi(argv[i]);
+
+        /* 25% steps keep the stretched blit edges on whole device pixels */
+        if (dwScale < 100 || dwScale > 400 || (dwScale % 25) != 0) {
+            ErrorF("ddxProcessArgument - scaling - Invalid percentage "
+                   "%d, must be 100 to 400 in steps of 25\n", (int) dwScale);
+            UseMsg();
+            return 0;
+        }
+
+        screenInfoPtr->dwScale = dwScale;
+
+        /* Indicate that we have processed the argument */
+        return 2;
+    }
+
 #ifdef XWIN_EMULATEPSEUDO
     /*
      * Look for the '-emulatepseudo' argument
@@ -1087,6 +1157,16 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 1;
     }
 
+    if (IS_OPTION("-rawinput")) {
+        g_fRawInput = TRUE;
+        return 1;
+    }
+
+    if (IS_OPTION("-etwtrace")) {
+        g_fEtwTrace = TRUE;
+        return 1;
+    }
+
     if (IS_OPTION("-wgl")) {
         g_fNativeGl = TRUE;
         return 1;
@@ -1101,6 +1181,23 @@ ddxProcessArgument(int argc, char *argv[], int i)
         g_fswrastwgl = TRUE;
         return 1;
     }
+    else if (IS_OPTION("-glxdriver"))
+    {
+        CHECK_ARGS(1);
+        g_pszGLXDriver = argv[++i];
+        return 2;
+    }
+    else if (IS_OPTION("-swrastthreads"))
+    {
+        /* static because putenv doesn't copy the argument */
+        static char szThreads[40];
+
+        CHECK_ARGS(1);
+        snprintf(szThreads, sizeof(szThreads), "LP_NUM_THREADS=%d",
+                 atoi(argv[++i]));
+        putenv(szThreads);
+        return 2;
+    }
     else if (IS_OPTION("-parentprocessid"))
     {
         DWORD dwProcessId;
@@ -97,12 +97,24 @@ winDoRandRScreenSetSize(ScreenPtr pScreen,
     winScreenPriv(pScreen);
     winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
     WindowPtr pRoot = pScreen->root;
+    Bool fResizeInPlace;
 
     /* Ignore changes which do nothing */
     if ((pScreen->width == width) && (pScreen->height == height) &&
         (pScreen->mmWidth == mmWidth) && (pScreen->mmHeight == mmHeight))
         return;
 
+    /*
+     * If the new size keeps the existing stride and fits in the rows
+     * the drawing engine allocated, the framebuffer can be reused in
+     * place: only the screen dimensions and the root clip need to
+     * change, rather than destroying and recreating the framebuffer,
+     * which blanks the screen noticeably while everything revalidates
+     */
+    fResizeInPlace = (width == pScreenInfo->dwWidth) &&
+        ((DWORD) height <= pScreenInfo->dwShadowHeightMax) &&
+        (pScreenInfo->pfb != NULL);
+
     // Prevent screen updates while we change things around
     SetRootClip(pScreen, ROOT_CLIP_NONE);
 
@@ -111,9 +123,12 @@ winDoRandRScreenSetSize(ScreenPtr pScreen,
     pScreenInfo->dwHeight = height;
 
     /* Reallocate the framebuffer used by the drawing engine */
-    (*pScreenPriv->pwinFreeFB) (pScreen);
-    if (!(*pScreenPriv->pwinAllocateFB) (pScreen)) {
-        ErrorF("winDoRandRScreenSetSize - Could not reallocate framebuffer\n");
+    if (!fResizeInPlace) {
+        (*pScreenPriv->pwinFreeFB) (pScreen);
+        if (!(*pScreenPriv->pwinAllocateFB) (pScreen)) {
+            ErrorF
+                ("winDoRandRScreenSetSize - Could not reallocate framebuffer\n");
+        }
     }
 
     pScreen->width = width;
@@ -218,6 +233,48 @@ winRandRScreenSetSize(ScreenPtr pScreen,
     return TRUE;
 }
 
+/*
+ * Register a RandR 1.5 monitor for a native monitor, mirroring the
+ * geometry registered with pseudoramiX, so toolkits which prefer
+ * RRGetMonitors see the multi-monitor layout without having to poll
+ * Xinerama queries.
+ */
+
+Bool
+winRandRAddMonitor(ScreenPtr pScreen, int iMonitor,
+                   int x, int y, int w, int h, Bool fPrimary)
+{
+    rrScrPrivPtr pRRScrPriv = rrGetScrPriv(pScreen);
+    RRMonitorPtr pMonitor;
+    char name[32];
+
+    if (!pRRScrPriv)
+        return FALSE;
+
+    pMonitor = RRMonitorAlloc(0);
+    if (!pMonitor)
+        return FALSE;
+
+    snprintf(name, sizeof(name), "Monitor-%d", iMonitor);
+    pMonitor->name = MakeAtom(name, strlen(name), TRUE);
+    pMonitor->pScreen = pScreen;
+    pMonitor->primary = fPrimary;
+    pMonitor->automatic = FALSE;
+    pMonitor->geometry.box.x1 = x;
+    pMonitor->geometry.box.y1 = y;
+    pMonitor->geometry.box.x2 = x + w;
+    pMonitor->geometry.box.y2 = y + h;
+    pMonitor->geometry.mmWidth = (w * 25.4) / monitorResolution;
+    pMonitor->geometry.mmHeight = (h * 25.4) / monitorResolution;
+
+    if (RRMonitorAdd(serverClient, pScreen, pMonitor) != Success) {
+        RRMonitorFree(pMonitor);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /*
  * Initialize the RandR layer.
  */
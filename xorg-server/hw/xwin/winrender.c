@@ -0,0 +1,952 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#define COBJMACROS
+#include "win.h"
+#include "picturestr.h"
+#include "mipict.h"
+
+#include <d3d11.h>
+
+/*
+ * Direct3D RENDER compositor (-d3dcompositing, DXGI engine only)
+ *
+ * Large Composite requests whose source and mask are plain untransformed
+ * pixmap pictures are executed by a pixel shader on the engine's D3D11
+ * device instead of pixman: the destination rectangle is uploaded from
+ * the shadow framebuffer into a render target, the quad is drawn with
+ * the source (and optional a8 mask) bound as shader resources, and the
+ * result is read back through a staging texture into the shadow.  The
+ * shadow thus remains the authoritative surface and the engine's
+ * present path is untouched; since we are wrapped before shadowSetup,
+ * the damage layer sits on top of us and records the composited region
+ * as usual.
+ *
+ * Pixmaps bound to DXGI shared handles by WindowsDRI (see winshaddxgi.c)
+ * are sampled in place, so compositing from a GPU-rendering client
+ * skips the readback-and-reupload round trip entirely.  Other source
+ * pixmaps are uploaded once and cached on the pixmap, revalidated
+ * against the drawable serial number.
+ *
+ * Glyphs and Trapezoids need no wrapper of their own: fb accumulates
+ * both into scratch pictures and hands them to ps->Composite.
+ *
+ * Everything this file cannot handle falls through to the wrapped
+ * fbComposite, which stays correct because no shadow bytes are written
+ * until the whole operation has succeeded on the GPU.
+ */
+
+/* Composites smaller than this many destination pixels are not worth
+   the upload/readback latency; pixman wins below it */
+#define WIN_RENDER_D3D_THRESHOLD 4096
+
+typedef struct {
+    float x, y;                 /* clip-space position */
+    float su, sv;               /* normalized source texel coords */
+    float mu, mv;               /* normalized mask texel coords */
+} winRenderVertexRec;
+
+typedef struct {
+    CompositeProcPtr Composite; /* wrapped fbComposite */
+
+    /* Engine device in use; when the engine recreates its device after
+       a loss, everything below is rebuilt and the generation bumped so
+       cached pixmap textures are recognized as stale */
+    ID3D11Device *pDevice;
+    ID3D11DeviceContext *pContext;
+    unsigned long ulDeviceGen;
+
+    ID3D11VertexShader *pVertexShader;
+    ID3D11PixelShader *pPixelShaderSrc;
+    ID3D11PixelShader *pPixelShaderMask;
+    ID3D11InputLayout *pInputLayout;
+    ID3D11Buffer *pVertexBuffer;
+    ID3D11SamplerState *pSampler;
+    ID3D11RasterizerState *pRasterizer;
+    ID3D11BlendState *pBlendOver;
+
+    /* Screen-sized destination round trip */
+    ID3D11Texture2D *pTarget;
+    ID3D11RenderTargetView *pTargetView;
+    ID3D11Texture2D *pStaging;
+    DWORD dwTargetWidth;
+    DWORD dwTargetHeight;
+
+    Bool fBroken;               /* shader setup failed; stay on fb */
+} winRenderD3DPriv, *winRenderD3DPrivPtr;
+
+/*
+ * Shaders, compiled at first use.  The vertex shader is a passthrough;
+ * texel coordinates are computed on the CPU per quad corner so no
+ * constant buffer is needed.  The mask variant modulates by the red
+ * channel of an a8 mask bound as R8_UNORM; RENDER masks and operands
+ * are premultiplied, which is exactly what the Over blend state
+ * (ONE / INV_SRC_ALPHA) expects.
+ */
+static const char g_szRenderHLSL[] =
+    "struct VSIn  { float2 pos : POSITION;\n"
+    "               float2 suv : TEXCOORD0; float2 muv : TEXCOORD1; };\n"
+    "struct VSOut { float4 pos : SV_Position;\n"
+    "               float2 suv : TEXCOORD0; float2 muv : TEXCOORD1; };\n"
+    "Texture2D tSrc : register(t0);\n"
+    "Texture2D tMask : register(t1);\n"
+    "SamplerState sPoint : register(s0);\n"
+    "VSOut vs_main(VSIn i) {\n"
+    "    VSOut o;\n"
+    "    o.pos = float4(i.pos, 0.0, 1.0);\n"
+    "    o.suv = i.suv;\n"
+    "    o.muv = i.muv;\n"
+    "    return o;\n"
+    "}\n"
+    "float4 ps_src(VSOut i) : SV_Target {\n"
+    "    return tSrc.Sample(sPoint, i.suv);\n"
+    "}\n"
+    "float4 ps_mask(VSOut i) : SV_Target {\n"
+    "    return tSrc.Sample(sPoint, i.suv)\n"
+    "         * tMask.Sample(sPoint, i.muv).r;\n"
+    "}\n";
+
+/* D3DCompile out of d3dcompiler_47.dll, loaded on demand so the server
+   still runs on machines without it (we just never leave pixman) */
+typedef HRESULT (WINAPI * WIN_PFN_D3DCOMPILE) (LPCVOID, SIZE_T, LPCSTR,
+                                               const void *, void *,
+                                               LPCSTR, LPCSTR, UINT, UINT,
+                                               ID3DBlob **, ID3DBlob **);
+static FARPROC g_fpD3DCompile = NULL;
+static Bool g_fD3DCompileProbed = FALSE;
+
+/*
+ * Map a picture format onto the texture format it is sampled as.
+ * B8G8R8X8 sources sample with alpha forced to 1.0, matching how
+ * RENDER treats x8r8g8b8.
+ */
+
+static Bool
+winRenderD3DFormat(CARD32 dwPictFormat, DXGI_FORMAT * pFormat)
+{
+    switch (dwPictFormat) {
+    case PICT_a8r8g8b8:
+        *pFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
+        return TRUE;
+    case PICT_x8r8g8b8:
+        *pFormat = DXGI_FORMAT_B8G8R8X8_UNORM;
+        return TRUE;
+    case PICT_a8:
+        *pFormat = DXGI_FORMAT_R8_UNORM;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/*
+ * Release everything created on the engine device.  The wrapper stays
+ * installed; resources come back on the next eligible composite.
+ */
+
+static void
+winRenderD3DReleaseDeviceObjects(winRenderD3DPrivPtr pRender)
+{
+    if (pRender->pStaging) {
+        ID3D11Texture2D_Release(pRender->pStaging);
+        pRender->pStaging = NULL;
+    }
+    if (pRender->pTargetView) {
+        ID3D11RenderTargetView_Release(pRender->pTargetView);
+        pRender->pTargetView = NULL;
+    }
+    if (pRender->pTarget) {
+        ID3D11Texture2D_Release(pRender->pTarget);
+        pRender->pTarget = NULL;
+    }
+    if (pRender->pBlendOver) {
+        ID3D11BlendState_Release(pRender->pBlendOver);
+        pRender->pBlendOver = NULL;
+    }
+    if (pRender->pRasterizer) {
+        ID3D11RasterizerState_Release(pRender->pRasterizer);
+        pRender->pRasterizer = NULL;
+    }
+    if (pRender->pSampler) {
+        ID3D11SamplerState_Release(pRender->pSampler);
+        pRender->pSampler = NULL;
+    }
+    if (pRender->pVertexBuffer) {
+        ID3D11Buffer_Release(pRender->pVertexBuffer);
+        pRender->pVertexBuffer = NULL;
+    }
+    if (pRender->pInputLayout) {
+        ID3D11InputLayout_Release(pRender->pInputLayout);
+        pRender->pInputLayout = NULL;
+    }
+    if (pRender->pPixelShaderMask) {
+        ID3D11PixelShader_Release(pRender->pPixelShaderMask);
+        pRender->pPixelShaderMask = NULL;
+    }
+    if (pRender->pPixelShaderSrc) {
+        ID3D11PixelShader_Release(pRender->pPixelShaderSrc);
+        pRender->pPixelShaderSrc = NULL;
+    }
+    if (pRender->pVertexShader) {
+        ID3D11VertexShader_Release(pRender->pVertexShader);
+        pRender->pVertexShader = NULL;
+    }
+    pRender->dwTargetWidth = 0;
+    pRender->dwTargetHeight = 0;
+    pRender->pDevice = NULL;
+    pRender->pContext = NULL;
+}
+
+static Bool
+winRenderD3DCompileShader(const char *pszEntry, const char *pszTarget,
+                          ID3DBlob ** ppCode)
+{
+    ID3DBlob *pErrors = NULL;
+    HRESULT hr;
+
+    hr = ((WIN_PFN_D3DCOMPILE) g_fpD3DCompile)
+        (g_szRenderHLSL, sizeof(g_szRenderHLSL) - 1, "winrender.hlsl",
+         NULL, NULL, pszEntry, pszTarget, 0, 0, ppCode, &pErrors);
+    if (FAILED(hr)) {
+        ErrorF("winRenderD3DCompileShader - %s failed: %08x\n%s",
+               pszEntry, (unsigned int) hr,
+               pErrors ? (char *) ID3D10Blob_GetBufferPointer(pErrors) : "");
+        if (pErrors)
+            ID3D10Blob_Release(pErrors);
+        return FALSE;
+    }
+    if (pErrors)
+        ID3D10Blob_Release(pErrors);
+    return TRUE;
+}
+
+/*
+ * Build the pipeline objects on the engine device
+ */
+
+static Bool
+winRenderD3DCreateDeviceObjects(winRenderD3DPrivPtr pRender)
+{
+    ID3DBlob *pVSCode = NULL;
+    ID3DBlob *pPSCode = NULL;
+    D3D11_INPUT_ELEMENT_DESC aElements[3];
+    D3D11_BUFFER_DESC bd;
+    D3D11_SAMPLER_DESC sd;
+    D3D11_RASTERIZER_DESC rd;
+    D3D11_BLEND_DESC blendDesc;
+    HRESULT hr;
+
+    if (!g_fD3DCompileProbed) {
+        HMODULE hmodCompiler = LoadLibrary("d3dcompiler_47.dll");
+
+        if (hmodCompiler)
+            g_fpD3DCompile = GetProcAddress(hmodCompiler, "D3DCompile");
+        g_fD3DCompileProbed = TRUE;
+    }
+    if (g_fpD3DCompile == NULL) {
+        ErrorF("winRenderD3DCreateDeviceObjects - d3dcompiler_47.dll not "
+               "available, staying on software compositing\n");
+        return FALSE;
+    }
+
+    if (!winRenderD3DCompileShader("vs_main", "vs_4_0", &pVSCode))
+        return FALSE;
+
+    hr = ID3D11Device_CreateVertexShader(pRender->pDevice,
+                                         ID3D10Blob_GetBufferPointer(pVSCode),
+                                         ID3D10Blob_GetBufferSize(pVSCode),
+                                         NULL, &pRender->pVertexShader);
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    ZeroMemory(aElements, sizeof(aElements));
+    aElements[0].SemanticName = "POSITION";
+    aElements[0].Format = DXGI_FORMAT_R32G32_FLOAT;
+    aElements[0].AlignedByteOffset = 0;
+    aElements[1].SemanticName = "TEXCOORD";
+    aElements[1].SemanticIndex = 0;
+    aElements[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+    aElements[1].AlignedByteOffset = 8;
+    aElements[2].SemanticName = "TEXCOORD";
+    aElements[2].SemanticIndex = 1;
+    aElements[2].Format = DXGI_FORMAT_R32G32_FLOAT;
+    aElements[2].AlignedByteOffset = 16;
+
+    hr = ID3D11Device_CreateInputLayout(pRender->pDevice, aElements, 3,
+                                        ID3D10Blob_GetBufferPointer(pVSCode),
+                                        ID3D10Blob_GetBufferSize(pVSCode),
+                                        &pRender->pInputLayout);
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    ID3D10Blob_Release(pVSCode);
+    pVSCode = NULL;
+
+    if (!winRenderD3DCompileShader("ps_src", "ps_4_0", &pPSCode))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+    hr = ID3D11Device_CreatePixelShader(pRender->pDevice,
+                                        ID3D10Blob_GetBufferPointer(pPSCode),
+                                        ID3D10Blob_GetBufferSize(pPSCode),
+                                        NULL, &pRender->pPixelShaderSrc);
+    ID3D10Blob_Release(pPSCode);
+    pPSCode = NULL;
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    if (!winRenderD3DCompileShader("ps_mask", "ps_4_0", &pPSCode))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+    hr = ID3D11Device_CreatePixelShader(pRender->pDevice,
+                                        ID3D10Blob_GetBufferPointer(pPSCode),
+                                        ID3D10Blob_GetBufferSize(pPSCode),
+                                        NULL, &pRender->pPixelShaderMask);
+    ID3D10Blob_Release(pPSCode);
+    pPSCode = NULL;
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    /* One quad, rewritten per destination box */
+    ZeroMemory(&bd, sizeof(bd));
+    bd.ByteWidth = 4 * sizeof(winRenderVertexRec);
+    bd.Usage = D3D11_USAGE_DYNAMIC;
+    bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    hr = ID3D11Device_CreateBuffer(pRender->pDevice, &bd, NULL,
+                                   &pRender->pVertexBuffer);
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    /* Point sampling; quads are drawn texel-aligned so this fetches
+       exactly the texels pixman would read */
+    ZeroMemory(&sd, sizeof(sd));
+    sd.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+    sd.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sd.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sd.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    hr = ID3D11Device_CreateSamplerState(pRender->pDevice, &sd,
+                                         &pRender->pSampler);
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    ZeroMemory(&rd, sizeof(rd));
+    rd.FillMode = D3D11_FILL_SOLID;
+    rd.CullMode = D3D11_CULL_NONE;
+    rd.DepthClipEnable = TRUE;
+    hr = ID3D11Device_CreateRasterizerState(pRender->pDevice, &rd,
+                                            &pRender->pRasterizer);
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    /* PictOpOver for premultiplied operands; PictOpSrc just disables
+       blending */
+    ZeroMemory(&blendDesc, sizeof(blendDesc));
+    blendDesc.RenderTarget[0].BlendEnable = TRUE;
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
+    blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+    blendDesc.RenderTarget[0].RenderTargetWriteMask =
+        D3D11_COLOR_WRITE_ENABLE_ALL;
+    hr = ID3D11Device_CreateBlendState(pRender->pDevice, &blendDesc,
+                                       &pRender->pBlendOver);
+    if (FAILED(hr))
+        goto winRenderD3DCreateDeviceObjects_Fail;
+
+    return TRUE;
+
+ winRenderD3DCreateDeviceObjects_Fail:
+    ErrorF("winRenderD3DCreateDeviceObjects - failed: %08x\n",
+           (unsigned int) hr);
+    if (pVSCode)
+        ID3D10Blob_Release(pVSCode);
+    if (pPSCode)
+        ID3D10Blob_Release(pPSCode);
+    winRenderD3DReleaseDeviceObjects(pRender);
+    return FALSE;
+}
+
+/*
+ * (Re)create the screen-sized render target and readback staging
+ * texture
+ */
+
+static Bool
+winRenderD3DCreateTarget(winRenderD3DPrivPtr pRender,
+                         winScreenInfoPtr pScreenInfo)
+{
+    D3D11_TEXTURE2D_DESC desc;
+    HRESULT hr;
+
+    if (pRender->pStaging) {
+        ID3D11Texture2D_Release(pRender->pStaging);
+        pRender->pStaging = NULL;
+    }
+    if (pRender->pTargetView) {
+        ID3D11RenderTargetView_Release(pRender->pTargetView);
+        pRender->pTargetView = NULL;
+    }
+    if (pRender->pTarget) {
+        ID3D11Texture2D_Release(pRender->pTarget);
+        pRender->pTarget = NULL;
+    }
+
+    ZeroMemory(&desc, sizeof(desc));
+    desc.Width = pScreenInfo->dwWidth;
+    desc.Height = pScreenInfo->dwHeight;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET;
+    hr = ID3D11Device_CreateTexture2D(pRender->pDevice, &desc, NULL,
+                                      &pRender->pTarget);
+    if (FAILED(hr))
+        goto winRenderD3DCreateTarget_Fail;
+
+    hr = ID3D11Device_CreateRenderTargetView(pRender->pDevice,
+                                             (ID3D11Resource *)
+                                             pRender->pTarget, NULL,
+                                             &pRender->pTargetView);
+    if (FAILED(hr))
+        goto winRenderD3DCreateTarget_Fail;
+
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    hr = ID3D11Device_CreateTexture2D(pRender->pDevice, &desc, NULL,
+                                      &pRender->pStaging);
+    if (FAILED(hr))
+        goto winRenderD3DCreateTarget_Fail;
+
+    pRender->dwTargetWidth = pScreenInfo->dwWidth;
+    pRender->dwTargetHeight = pScreenInfo->dwHeight;
+    return TRUE;
+
+ winRenderD3DCreateTarget_Fail:
+    ErrorF("winRenderD3DCreateTarget - failed: %08x\n", (unsigned int) hr);
+    if (pRender->pTargetView) {
+        ID3D11RenderTargetView_Release(pRender->pTargetView);
+        pRender->pTargetView = NULL;
+    }
+    if (pRender->pTarget) {
+        ID3D11Texture2D_Release(pRender->pTarget);
+        pRender->pTarget = NULL;
+    }
+    return FALSE;
+}
+
+/*
+ * Make sure the pipeline exists on the engine's current device
+ */
+
+static Bool
+winRenderD3DEnsureResources(ScreenPtr pScreen, winRenderD3DPrivPtr pRender)
+{
+    winScreenPriv(pScreen);
+    winScreenInfoPtr pScreenInfo = pScreenPriv->pScreenInfo;
+    void *pDevice;
+    void *pContext;
+
+    if (pRender->fBroken)
+        return FALSE;
+
+    if (!winDxgiGetDevice(pScreen, &pDevice, &pContext))
+        return FALSE;
+
+    /* The engine recreates its device after a loss; rebuild on it and
+       invalidate every cached pixmap texture via the generation */
+    if ((ID3D11Device *) pDevice != pRender->pDevice) {
+        winRenderD3DReleaseDeviceObjects(pRender);
+        pRender->pDevice = (ID3D11Device *) pDevice;
+        pRender->pContext = (ID3D11DeviceContext *) pContext;
+        ++pRender->ulDeviceGen;
+    }
+
+    if (pRender->pVertexShader == NULL
+        && !winRenderD3DCreateDeviceObjects(pRender)) {
+        /* Missing compiler or unsupported device; do not retry */
+        pRender->fBroken = TRUE;
+        return FALSE;
+    }
+
+    if (pRender->pTarget == NULL
+        || pRender->dwTargetWidth != pScreenInfo->dwWidth
+        || pRender->dwTargetHeight != pScreenInfo->dwHeight) {
+        if (!winRenderD3DCreateTarget(pRender, pScreenInfo))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Resolve the pixmap behind a picture drawable, or NULL if the picture
+ * cannot be sampled by the shader (non-drawable source, transform,
+ * repeat, wrong format, ...)
+ */
+
+static PixmapPtr
+winRenderD3DSourcePixmap(PicturePtr pPicture, ScreenPtr pScreen,
+                         DXGI_FORMAT * pFormat)
+{
+    PixmapPtr pPixmap;
+
+    if (pPicture == NULL || pPicture->pDrawable == NULL)
+        return NULL;
+    if (pPicture->pDrawable->type != DRAWABLE_PIXMAP)
+        return NULL;
+    if (pPicture->pDrawable->pScreen != pScreen)
+        return NULL;
+    if (pPicture->transform || pPicture->repeat || pPicture->alphaMap)
+        return NULL;
+    if (!winRenderD3DFormat(pPicture->format, pFormat))
+        return NULL;
+
+    pPixmap = (PixmapPtr) pPicture->pDrawable;
+    if (pPixmap->devPrivate.ptr == NULL)
+        return NULL;
+
+    return pPixmap;
+}
+
+/*
+ * Bind a source pixmap as a shader resource.  WindowsDRI-imported
+ * shared textures are sampled in place; anything else is uploaded into
+ * a texture cached on the pixmap and revalidated against the drawable
+ * serial number.  The returned view is released by the caller.
+ */
+
+static Bool
+winRenderD3DSourceView(winRenderD3DPrivPtr pRender, PixmapPtr pPixmap,
+                       DXGI_FORMAT format,
+                       ID3D11ShaderResourceView ** ppView)
+{
+    winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+    ID3D11Texture2D *pTexture;
+    HRESULT hr;
+
+    if (pPixmapPriv->pSharedTexture) {
+        pTexture = (ID3D11Texture2D *) pPixmapPriv->pSharedTexture;
+    }
+    else {
+        /* Two pictures of different formats over one pixmap also force
+           a reupload; the cached texture carries the sampled format */
+        if (pPixmapPriv->pCompTexture) {
+            D3D11_TEXTURE2D_DESC descCached;
+
+            ID3D11Texture2D_GetDesc((ID3D11Texture2D *)
+                                    pPixmapPriv->pCompTexture, &descCached);
+            if (pPixmapPriv->ulCompSerial != pPixmap->drawable.serialNumber
+                || pPixmapPriv->ulCompGen != pRender->ulDeviceGen
+                || descCached.Format != format)
+                winRenderD3DReleasePixmap(pPixmap);
+        }
+
+        if (pPixmapPriv->pCompTexture == NULL) {
+            D3D11_TEXTURE2D_DESC desc;
+            D3D11_SUBRESOURCE_DATA init;
+
+            ZeroMemory(&desc, sizeof(desc));
+            desc.Width = pPixmap->drawable.width;
+            desc.Height = pPixmap->drawable.height;
+            desc.MipLevels = 1;
+            desc.ArraySize = 1;
+            desc.Format = format;
+            desc.SampleDesc.Count = 1;
+            desc.Usage = D3D11_USAGE_DEFAULT;
+            desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+            init.pSysMem = pPixmap->devPrivate.ptr;
+            init.SysMemPitch = pPixmap->devKind;
+            init.SysMemSlicePitch = 0;
+
+            hr = ID3D11Device_CreateTexture2D(pRender->pDevice, &desc,
+                                              &init, &pTexture);
+            if (FAILED(hr))
+                return FALSE;
+
+            pPixmapPriv->pCompTexture = pTexture;
+            pPixmapPriv->ulCompSerial = pPixmap->drawable.serialNumber;
+            pPixmapPriv->ulCompGen = pRender->ulDeviceGen;
+        }
+        pTexture = (ID3D11Texture2D *) pPixmapPriv->pCompTexture;
+    }
+
+    hr = ID3D11Device_CreateShaderResourceView(pRender->pDevice,
+                                               (ID3D11Resource *) pTexture,
+                                               NULL, ppView);
+    return SUCCEEDED(hr);
+}
+
+/*
+ * Attempt a composite on the GPU.  Returns FALSE if the operation is
+ * not eligible or anything failed before shadow bytes were written, in
+ * which case the caller falls back to fbComposite; nothing is written
+ * into the shadow framebuffer until the staging readback has mapped
+ * successfully, so a fallback never double-applies the operator.
+ */
+
+static Bool
+winRenderD3DTryComposite(ScreenPtr pScreen, winRenderD3DPrivPtr pRender,
+                         CARD8 op, PicturePtr pSrc, PicturePtr pMask,
+                         PicturePtr pDst, INT16 xSrc, INT16 ySrc,
+                         INT16 xMask, INT16 yMask, INT16 xDst, INT16 yDst,
+                         CARD16 width, CARD16 height)
+{
+    PixmapPtr pSrcPixmap;
+    PixmapPtr pMaskPixmap = NULL;
+    PixmapPtr pDstPixmap;
+    DXGI_FORMAT srcFormat;
+    DXGI_FORMAT maskFormat = DXGI_FORMAT_UNKNOWN;
+    ID3D11ShaderResourceView *apView[2] = { NULL, NULL };
+    ID3D11ShaderResourceView *apNullView[2] = { NULL, NULL };
+    ID3D11DeviceContext *pContext;
+    D3D11_VIEWPORT vp;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    RegionRec region;
+    BoxPtr pBox;
+    int iBox;
+    int iDstX, iDstY;           /* dst drawable origin in screen space */
+    char *pDstBits;
+    int iDstPitch;
+    float fltInvWidth, fltInvHeight;
+    float fltInvSrcW, fltInvSrcH;
+    float fltInvMaskW = 0.0f, fltInvMaskH = 0.0f;
+    UINT uiStride = sizeof(winRenderVertexRec);
+    UINT uiOffset = 0;
+    HRESULT hr;
+
+    if (op != PictOpSrc && op != PictOpOver)
+        return FALSE;
+    if ((long) width * height < WIN_RENDER_D3D_THRESHOLD)
+        return FALSE;
+
+    /* Destination must be the shadow framebuffer itself */
+    if (pDst->alphaMap)
+        return FALSE;
+    if (pDst->format != PICT_x8r8g8b8 && pDst->format != PICT_a8r8g8b8)
+        return FALSE;
+    if (pDst->pDrawable->type == DRAWABLE_WINDOW)
+        pDstPixmap =
+            (*pScreen->GetWindowPixmap) ((WindowPtr) pDst->pDrawable);
+    else
+        pDstPixmap = (PixmapPtr) pDst->pDrawable;
+    if (pDstPixmap != (*pScreen->GetScreenPixmap) (pScreen))
+        return FALSE;
+
+    pSrcPixmap = winRenderD3DSourcePixmap(pSrc, pScreen, &srcFormat);
+    if (pSrcPixmap == NULL || pSrcPixmap == pDstPixmap)
+        return FALSE;
+
+    if (pMask) {
+        if (pMask->componentAlpha)
+            return FALSE;
+        pMaskPixmap = winRenderD3DSourcePixmap(pMask, pScreen, &maskFormat);
+        if (pMaskPixmap == NULL || pMaskPixmap == pDstPixmap)
+            return FALSE;
+        if (maskFormat != DXGI_FORMAT_R8_UNORM)
+            return FALSE;
+    }
+
+    if (!winRenderD3DEnsureResources(pScreen, pRender))
+        return FALSE;
+    pContext = pRender->pContext;
+
+    if (!winRenderD3DSourceView(pRender, pSrcPixmap, srcFormat, &apView[0]))
+        return FALSE;
+    if (pMaskPixmap
+        && !winRenderD3DSourceView(pRender, pMaskPixmap, maskFormat,
+                                   &apView[1])) {
+        ID3D11ShaderResourceView_Release(apView[0]);
+        return FALSE;
+    }
+
+    /* Clip exactly as fb would; the region comes back in dst drawable
+       coordinates and the screen pixmap has no offset, so translating
+       by the drawable origin yields shadow coordinates */
+    if (!miComputeCompositeRegion(&region, pSrc, pMask, pDst,
+                                  xSrc, ySrc, xMask, yMask,
+                                  xDst, yDst, width, height)) {
+        /* Empty is success: there is nothing to composite */
+        ID3D11ShaderResourceView_Release(apView[0]);
+        if (apView[1])
+            ID3D11ShaderResourceView_Release(apView[1]);
+        return TRUE;
+    }
+    iDstX = pDst->pDrawable->x;
+    iDstY = pDst->pDrawable->y;
+    RegionTranslate(&region, iDstX, iDstY);
+
+    pDstBits = (char *) pDstPixmap->devPrivate.ptr;
+    iDstPitch = pDstPixmap->devKind;
+
+    fltInvWidth = 1.0f / (float) pRender->dwTargetWidth;
+    fltInvHeight = 1.0f / (float) pRender->dwTargetHeight;
+    fltInvSrcW = 1.0f / (float) pSrcPixmap->drawable.width;
+    fltInvSrcH = 1.0f / (float) pSrcPixmap->drawable.height;
+    if (pMaskPixmap) {
+        fltInvMaskW = 1.0f / (float) pMaskPixmap->drawable.width;
+        fltInvMaskH = 1.0f / (float) pMaskPixmap->drawable.height;
+    }
+
+    /* Full pipeline state every time; the context is shared with the
+       engine's upload path */
+    ID3D11DeviceContext_IASetInputLayout(pContext, pRender->pInputLayout);
+    ID3D11DeviceContext_IASetVertexBuffers(pContext, 0, 1,
+                                           &pRender->pVertexBuffer,
+                                           &uiStride, &uiOffset);
+    ID3D11DeviceContext_IASetPrimitiveTopology(pContext,
+                                               D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    ID3D11DeviceContext_VSSetShader(pContext, pRender->pVertexShader,
+                                    NULL, 0);
+    ID3D11DeviceContext_PSSetShader(pContext,
+                                    pMaskPixmap ? pRender->pPixelShaderMask
+                                    : pRender->pPixelShaderSrc, NULL, 0);
+    ID3D11DeviceContext_PSSetShaderResources(pContext, 0, 2, apView);
+    ID3D11DeviceContext_PSSetSamplers(pContext, 0, 1, &pRender->pSampler);
+    ID3D11DeviceContext_RSSetState(pContext, pRender->pRasterizer);
+    ID3D11DeviceContext_OMSetBlendState(pContext,
+                                        op == PictOpOver ?
+                                        pRender->pBlendOver : NULL,
+                                        NULL, 0xffffffff);
+    ID3D11DeviceContext_OMSetRenderTargets(pContext, 1,
+                                           &pRender->pTargetView, NULL);
+
+    ZeroMemory(&vp, sizeof(vp));
+    vp.Width = (float) pRender->dwTargetWidth;
+    vp.Height = (float) pRender->dwTargetHeight;
+    vp.MaxDepth = 1.0f;
+    ID3D11DeviceContext_RSSetViewports(pContext, 1, &vp);
+
+    /* Upload the destination under each box and draw the quad over it */
+    pBox = RegionRects(&region);
+    iBox = RegionNumRects(&region);
+    while (iBox--) {
+        D3D11_BOX box;
+        winRenderVertexRec *pVertex;
+        int i;
+
+        box.left = pBox->x1;
+        box.top = pBox->y1;
+        box.front = 0;
+        box.right = pBox->x2;
+        box.bottom = pBox->y2;
+        box.back = 1;
+
+        ID3D11DeviceContext_UpdateSubresource(pContext,
+                                              (ID3D11Resource *)
+                                              pRender->pTarget, 0, &box,
+                                              pDstBits
+                                              + pBox->y1 * iDstPitch
+                                              + pBox->x1 * 4, iDstPitch, 0);
+
+        hr = ID3D11DeviceContext_Map(pContext,
+                                     (ID3D11Resource *)
+                                     pRender->pVertexBuffer, 0,
+                                     D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+        if (FAILED(hr))
+            goto winRenderD3DTryComposite_Fail;
+
+        /* Triangle strip: TL, TR, BL, BR, texel coordinates anchored
+           at the box corners so interpolation lands on texel centers */
+        pVertex = (winRenderVertexRec *) mapped.pData;
+        for (i = 0; i < 4; ++i) {
+            int iScreenX = (i & 1) ? pBox->x2 : pBox->x1;
+            int iScreenY = (i & 2) ? pBox->y2 : pBox->y1;
+
+            pVertex[i].x = 2.0f * iScreenX * fltInvWidth - 1.0f;
+            pVertex[i].y = 1.0f - 2.0f * iScreenY * fltInvHeight;
+            pVertex[i].su = (xSrc + iScreenX - (xDst + iDstX)) * fltInvSrcW;
+            pVertex[i].sv = (ySrc + iScreenY - (yDst + iDstY)) * fltInvSrcH;
+            if (pMaskPixmap) {
+                pVertex[i].mu =
+                    (xMask + iScreenX - (xDst + iDstX)) * fltInvMaskW;
+                pVertex[i].mv =
+                    (yMask + iScreenY - (yDst + iDstY)) * fltInvMaskH;
+            }
+            else {
+                pVertex[i].mu = 0.0f;
+                pVertex[i].mv = 0.0f;
+            }
+        }
+        ID3D11DeviceContext_Unmap(pContext,
+                                  (ID3D11Resource *) pRender->pVertexBuffer,
+                                  0);
+
+        ID3D11DeviceContext_Draw(pContext, 4, 0);
+
+        ID3D11DeviceContext_CopySubresourceRegion(pContext,
+                                                  (ID3D11Resource *)
+                                                  pRender->pStaging, 0,
+                                                  pBox->x1, pBox->y1, 0,
+                                                  (ID3D11Resource *)
+                                                  pRender->pTarget, 0, &box);
+        ++pBox;
+    }
+
+    ID3D11DeviceContext_PSSetShaderResources(pContext, 0, 2, apNullView);
+    ID3D11ShaderResourceView_Release(apView[0]);
+    apView[0] = NULL;
+    if (apView[1]) {
+        ID3D11ShaderResourceView_Release(apView[1]);
+        apView[1] = NULL;
+    }
+
+    /* The single point of failure that matters: until this map
+       succeeds nothing has touched the shadow, so the fb fallback is
+       still safe.  The map also blocks until the draws retire. */
+    hr = ID3D11DeviceContext_Map(pContext,
+                                 (ID3D11Resource *) pRender->pStaging, 0,
+                                 D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+        goto winRenderD3DTryComposite_Fail;
+
+    pBox = RegionRects(&region);
+    iBox = RegionNumRects(&region);
+    while (iBox--) {
+        int iRow;
+        int cbRow = (pBox->x2 - pBox->x1) * 4;
+
+        for (iRow = pBox->y1; iRow < pBox->y2; ++iRow)
+            memcpy(pDstBits + iRow * iDstPitch + pBox->x1 * 4,
+                   (char *) mapped.pData + iRow * mapped.RowPitch
+                   + pBox->x1 * 4, cbRow);
+        ++pBox;
+    }
+
+    ID3D11DeviceContext_Unmap(pContext,
+                              (ID3D11Resource *) pRender->pStaging, 0);
+    RegionUninit(&region);
+    return TRUE;
+
+ winRenderD3DTryComposite_Fail:
+    ID3D11DeviceContext_PSSetShaderResources(pContext, 0, 2, apNullView);
+    if (apView[0])
+        ID3D11ShaderResourceView_Release(apView[0]);
+    if (apView[1])
+        ID3D11ShaderResourceView_Release(apView[1]);
+    RegionUninit(&region);
+    return FALSE;
+}
+
+/*
+ * Composite wrapper installed as ps->Composite; the damage layer wraps
+ * this during shadowSetup
+ */
+
+static void
+winRenderD3DComposite(CARD8 op, PicturePtr pSrc, PicturePtr pMask,
+                      PicturePtr pDst, INT16 xSrc, INT16 ySrc,
+                      INT16 xMask, INT16 yMask, INT16 xDst, INT16 yDst,
+                      CARD16 width, CARD16 height)
+{
+    ScreenPtr pScreen = pDst->pDrawable->pScreen;
+
+    winScreenPriv(pScreen);
+    winRenderD3DPrivPtr pRender =
+        (winRenderD3DPrivPtr) pScreenPriv->pD3DRenderPriv;
+
+    if (!winRenderD3DTryComposite(pScreen, pRender, op, pSrc, pMask, pDst,
+                                  xSrc, ySrc, xMask, yMask, xDst, yDst,
+                                  width, height))
+        (*pRender->Composite) (op, pSrc, pMask, pDst, xSrc, ySrc,
+                               xMask, yMask, xDst, yDst, width, height);
+}
+
+/*
+ * Release the texture a composite source was cached in; called when
+ * the pixmap goes away (see winDestroyPixmapShadowDXGI) and when a
+ * cache entry is found stale
+ */
+
+void
+winRenderD3DReleasePixmap(PixmapPtr pPixmap)
+{
+    winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+
+    if (pPixmapPriv->pCompTexture) {
+        ID3D11Texture2D_Release((ID3D11Texture2D *)
+                                pPixmapPriv->pCompTexture);
+        pPixmapPriv->pCompTexture = NULL;
+    }
+}
+
+/*
+ * Drop every object created on the engine device; called by the engine
+ * before it releases the device so our references do not keep a lost
+ * device alive.  The wrapper stays installed and rebuilds on the
+ * replacement device.
+ */
+
+void
+winRenderD3DRelease(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winRenderD3DPrivPtr pRender =
+        (winRenderD3DPrivPtr) pScreenPriv->pD3DRenderPriv;
+
+    if (pRender == NULL)
+        return;
+
+    winRenderD3DReleaseDeviceObjects(pRender);
+}
+
+/*
+ * Wrap ps->Composite.  Must be called after fbPictureInit () and
+ * before shadowSetup () so the damage layer records GPU-composited
+ * regions.
+ */
+
+Bool
+winRenderD3DWrap(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    PictureScreenPtr ps = GetPictureScreenIfSet(pScreen);
+    winRenderD3DPrivPtr pRender;
+
+    if (ps == NULL)
+        return FALSE;
+
+    pRender = calloc(1, sizeof(winRenderD3DPriv));
+    if (pRender == NULL)
+        return FALSE;
+
+    pRender->Composite = ps->Composite;
+    ps->Composite = winRenderD3DComposite;
+    pScreenPriv->pD3DRenderPriv = pRender;
+
+    winDebug("winRenderD3DWrap - Direct3D compositing enabled\n");
+
+    return TRUE;
+}
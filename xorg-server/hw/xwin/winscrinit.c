@@ -82,6 +82,24 @@ winScreenInit(ScreenPtr pScreen, int argc, char **argv)
         return FALSE;
     }
 
+    /* Display scaling is implemented by the GDI and DDNL present paths only */
+    if (pScreenInfo->dwScale != WIN_DEFAULT_SCALE) {
+        if ((pScreenInfo->dwEngine != WIN_SERVER_SHADOW_GDI &&
+             pScreenInfo->dwEngine != WIN_SERVER_SHADOW_DDNL) ||
+            pScreenInfo->fMultiWindow || pScreenInfo->fRootless ||
+            pScreenInfo->fFullScreen) {
+            ErrorF("winScreenInit - -scaling requires a windowed Shadow GDI "
+                   "or Shadow DirectDraw Non-Locking engine, ignoring\n");
+            pScreenInfo->dwScale = WIN_DEFAULT_SCALE;
+        }
+        else {
+            /* Scrollbar offsets and the worker blits are 1:1 device pixels */
+            if (pScreenInfo->iResizeMode == resizeWithScrollbars)
+                pScreenInfo->iResizeMode = resizeNotAllowed;
+            pScreenInfo->fParallelUpdates = FALSE;
+        }
+    }
+
     /* Horribly misnamed function: Allow engine to adjust BPP for screen */
     dwInitialBPP = pScreenInfo->dwBPP;
   
@@ -329,9 +347,41 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
     }
 #endif
 
+#ifdef PRESENT
+    /* Initialize the Present extension with real vblank pacing */
+    if (!winPresentInit(pScreen)) {
+        ErrorF("winFinishScreenInitFB - winPresentInit () failed\n");
+        return FALSE;
+    }
+#endif
+
+#ifdef XWIN_XV
+    /* Register the software Xv adaptor; video is optional, so a
+       failure here does not abort screen init */
+    if (!winInitVideo(pScreen))
+        ErrorF("winFinishScreenInitFB - winInitVideo () failed\n");
+#endif
+
     /* Setup the cursor routines */
-    winDebug("winFinishScreenInitFB - Calling miDCInitialize ()\n");
-    miDCInitialize(pScreen, &g_winPointerCursorFuncs);
+    if (g_fSoftwareCursor) {
+        /* The sprite is rendered into the frame buffer, so the full
+         * misprite machinery is required.
+         */
+        winDebug("winFinishScreenInitFB - Calling miDCInitialize ()\n");
+        miDCInitialize(pScreen, &g_winPointerCursorFuncs);
+    }
+    else {
+        /* The sprite is composited by Windows; register the pointer
+         * without misprite so rendering operations are not checked
+         * against the sprite position.
+         */
+        winDebug("winFinishScreenInitFB - Calling winInitHardwarePointer ()\n");
+        if (!winInitHardwarePointer(pScreen)) {
+            ErrorF("winFinishScreenInitFB - winInitHardwarePointer () "
+                   "failed\n");
+            return FALSE;
+        }
+    }
 
     /* KDrive does winCreateDefColormap right after miDCInitialize */
     /* Create a default colormap */
@@ -341,9 +391,56 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
         return FALSE;
     }
 
+    /*
+     * For the GDI engine, allocate large pixmaps as DIB sections and
+     * copy them to the screen with GDI blits (see winshadgdi.c).  In
+     * -compositewm multiwindow mode every pixmap is a DIB section
+     * already, so the hooks installed below would be redundant.
+     *
+     * Wrapped before shadowSetup () so the damage layer wraps GC
+     * operations on top of ours and records damage for the GDI blits.
+     */
+    if (pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI
+        && !(pScreenInfo->fMultiWindow && pScreenInfo->fCompositeWM)) {
+        pScreenPriv->CreateGC = pScreen->CreateGC;
+        pScreenPriv->CreatePixmap = pScreen->CreatePixmap;
+        pScreenPriv->DestroyPixmap = pScreen->DestroyPixmap;
+        pScreen->CreateGC = winCreateGCShadowGDI;
+        pScreen->CreatePixmap = winCreatePixmapShadowGDI;
+        pScreen->DestroyPixmap = winDestroyPixmapShadowGDI;
+    }
+
+    /*
+     * For the DXGI engine, WindowsDRI can bind a client's DXGI shared
+     * handle as the backing of a pixmap (see winshaddxgi.c); the GC
+     * wrapper reads imported textures back before fb copies from them
+     * and the pixmap wrapper releases them.
+     */
+    if (pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DXGI) {
+        pScreenPriv->CreateGC = pScreen->CreateGC;
+        pScreenPriv->DestroyPixmap = pScreen->DestroyPixmap;
+        pScreen->CreateGC = winCreateGCShadowDXGI;
+        pScreen->DestroyPixmap = winDestroyPixmapShadowDXGI;
+    }
+
+    /*
+     * Optionally composite eligible RENDER requests with Direct3D
+     * pixel shaders on the DXGI engine's device (see winrender.c).
+     * Wrapped before shadowSetup () so the damage layer wraps
+     * Composite on top of ours and records the composited regions.
+     */
+    if (pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DXGI
+        && pScreenInfo->fD3DComposite) {
+        if (!winRenderD3DWrap(pScreen)) {
+            ErrorF("winFinishScreenInitFB - winRenderD3DWrap () failed\n");
+            return FALSE;
+        }
+    }
+
     /* Initialize the shadow framebuffer layer */
     if ((pScreenInfo->dwEngine == WIN_SERVER_SHADOW_GDI
-         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL)) {
+         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL
+         || pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DXGI)) {
         winDebug("winFinishScreenInitFB - Calling shadowSetup ()\n");
         if (!shadowSetup(pScreen)) {
             ErrorF("winFinishScreenInitFB - shadowSetup () failed\n");
@@ -435,6 +532,10 @@ winFinishScreenInitFB(int i, ScreenPtr pScreen, int argc, char **argv)
             pScreen->ModifyPixmapHeader = winModifyPixmapHeaderMultiwindow;
         }
 
+        /* Windows draws the frames of top-level windows, so their X
+           borders are never visible and need not be maintained */
+        pScreen->topLevelBordersExternal = TRUE;
+
         /* Undefine the WRAP macro, as it is not needed elsewhere */
 #undef WRAP
     }
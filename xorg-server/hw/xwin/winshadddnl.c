@@ -608,12 +608,27 @@ winShadowUpdateDDNL(ScreenPtr pScreen, shadowBufPtr pBuf)
     if (!pScreenPriv->pddsPrimary4 || !pScreenPriv->pddsShadow4)
         return;
 
+    winTraceShadowPresent(WIN_TRACE_PRESENT_DDNL, dwBox,
+                          RegionExtents(damage));
+
     /* Get the origin of the window in the screen coords */
     ptOrigin.x = pScreenInfo->dwXOffset;
     ptOrigin.y = pScreenInfo->dwYOffset;
     MapWindowPoints(pScreenPriv->hwndScreen,
                     HWND_DESKTOP, (LPPOINT) &ptOrigin, 1);
 
+    /*
+     * Present at device resolution when -scaling is active.  One
+     * stretching blit of the damage extents; the source alignment from
+     * winScaleDamageBox keeps adjacent stretches from seaming.
+     */
+    if (pScreenInfo->dwScale != WIN_DEFAULT_SCALE) {
+        winScaleDamageBox(pScreenInfo, RegionExtents(damage), &rcSrc, &rcDest);
+        OffsetRect(&rcDest, ptOrigin.x, ptOrigin.y);
+        myIDirectDrawSurface4_Blt(pScreen, &rcDest, &rcSrc);
+        return;
+    }
+
     /*
      * Handle small regions with multiple blits,
      * handle large regions by creating a clipping region and
@@ -925,9 +940,13 @@ winBltExposedRegionsShadowDDNL(ScreenPtr pScreen)
     MapWindowPoints(pScreenPriv->hwndScreen,
                     HWND_DESKTOP, (LPPOINT) &ptOrigin, 1);
     rcDest.left = ptOrigin.x;
-    rcDest.right = ptOrigin.x + pScreenInfo->dwWidth;
+    rcDest.right = ptOrigin.x + winScaleToDeviceCeil(pScreenInfo,
+                                                    (int) pScreenInfo->
+                                                    dwWidth);
     rcDest.top = ptOrigin.y;
-    rcDest.bottom = ptOrigin.y + pScreenInfo->dwHeight;
+    rcDest.bottom = ptOrigin.y + winScaleToDeviceCeil(pScreenInfo,
+                                                      (int) pScreenInfo->
+                                                      dwHeight);
 
     /* Source can be entire shadow surface, as Blt should clip for us */
     rcSrc.left = 0;
@@ -994,9 +1013,13 @@ winRedrawScreenShadowDDNL(ScreenPtr pScreen)
     MapWindowPoints(pScreenPriv->hwndScreen,
                     HWND_DESKTOP, (LPPOINT) &ptOrigin, 1);
     rcDest.left = ptOrigin.x;
-    rcDest.right = ptOrigin.x + pScreenInfo->dwWidth;
+    rcDest.right = ptOrigin.x + winScaleToDeviceCeil(pScreenInfo,
+                                                    (int) pScreenInfo->
+                                                    dwWidth);
     rcDest.top = ptOrigin.y;
-    rcDest.bottom = ptOrigin.y + pScreenInfo->dwHeight;
+    rcDest.bottom = ptOrigin.y + winScaleToDeviceCeil(pScreenInfo,
+                                                      (int) pScreenInfo->
+                                                      dwHeight);
 
     /* Source can be entire shadow surface, as Blt should clip for us */
     rcSrc.left = 0;
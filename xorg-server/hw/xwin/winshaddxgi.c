@@ -0,0 +1,1042 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#define COBJMACROS
+#include "win.h"
+#include "winprefs.h"
+
+#include <d3d11.h>
+#include <dxgi1_2.h>
+
+/*
+ * Shadow framebuffer engine presenting through a DXGI flip-model
+ * swapchain.  The shadow surface lives in a malloc'd buffer exactly as
+ * in the GDI and DDNL engines; on each shadow update the damaged
+ * scanlines are uploaded into the current back buffer and presented
+ * with DXGI_PRESENT_PARAMETERS dirty rectangles, so only the damaged
+ * region crosses the bus and the present completes on the next vblank.
+ *
+ * Because flip-model back buffers rotate, a buffer handed back to us
+ * by Present1 holds the frame from two presents ago.  We therefore
+ * keep the damage accumulated since each back buffer was last
+ * presented and upload the union of the current damage and the
+ * carry-over region.
+ */
+
+#define WIN_DXGI_BUFFER_COUNT 2
+
+typedef struct {
+    ID3D11Device *pDevice;
+    ID3D11DeviceContext *pContext;
+    IDXGISwapChain1 *pSwapChain;
+
+    /* Damage pending for each back buffer in the swapchain */
+    RegionRec rgnPending[WIN_DXGI_BUFFER_COUNT];
+    int iCurrentBuffer;
+} winDXGIPriv, *winDXGIPrivPtr;
+
+/*
+ * Local prototypes
+ */
+
+static Bool
+ winAllocateFBShadowDXGI(ScreenPtr pScreen);
+
+static void
+ winShadowUpdateDXGI(ScreenPtr pScreen, shadowBufPtr pBuf);
+
+static Bool
+ winCloseScreenShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winInitVisualsShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winAdjustVideoModeShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winBltExposedRegionsShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winActivateAppShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winRedrawScreenShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winRealizeInstalledPaletteShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winInstallColormapShadowDXGI(ColormapPtr pColormap);
+
+static Bool
+ winStoreColorsShadowDXGI(ColormapPtr pmap, int ndef, xColorItem * pdefs);
+
+static Bool
+ winCreateColormapShadowDXGI(ColormapPtr pColormap);
+
+static Bool
+ winDestroyColormapShadowDXGI(ColormapPtr pColormap);
+
+static Bool
+ winCreatePrimarySurfaceShadowDXGI(ScreenPtr pScreen);
+
+static Bool
+ winReleasePrimarySurfaceShadowDXGI(ScreenPtr pScreen);
+
+/*
+ * Release the swapchain and device objects
+ */
+
+static void
+winReleaseDXGI(winPrivScreenPtr pScreenPriv)
+{
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+    int i;
+
+    if (pDxgi == NULL)
+        return;
+
+    if (pDxgi->pSwapChain) {
+        IDXGISwapChain1_Release(pDxgi->pSwapChain);
+        pDxgi->pSwapChain = NULL;
+    }
+    if (pDxgi->pContext) {
+        ID3D11DeviceContext_Release(pDxgi->pContext);
+        pDxgi->pContext = NULL;
+    }
+    if (pDxgi->pDevice) {
+        ID3D11Device_Release(pDxgi->pDevice);
+        pDxgi->pDevice = NULL;
+    }
+
+    for (i = 0; i < WIN_DXGI_BUFFER_COUNT; ++i)
+        RegionUninit(&pDxgi->rgnPending[i]);
+
+    free(pDxgi);
+    pScreenPriv->pDXGIPriv = NULL;
+}
+
+/*
+ * Create the D3D11 device and the flip-model swapchain over the
+ * screen window.
+ */
+
+static Bool
+winCreatePrimarySurfaceShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+    HRESULT hr;
+    IDXGIDevice *pDxgiDevice = NULL;
+    IDXGIAdapter *pDxgiAdapter = NULL;
+    IDXGIFactory2 *pDxgiFactory = NULL;
+    DXGI_SWAP_CHAIN_DESC1 scd;
+    D3D_FEATURE_LEVEL featureLevel;
+    int i;
+
+    winDebug("winCreatePrimarySurfaceShadowDXGI - Creating swapchain\n");
+
+    if (pDxgi == NULL) {
+        pDxgi = calloc(1, sizeof(winDXGIPriv));
+        if (pDxgi == NULL) {
+            ErrorF("winCreatePrimarySurfaceShadowDXGI - Out of memory\n");
+            return FALSE;
+        }
+        for (i = 0; i < WIN_DXGI_BUFFER_COUNT; ++i)
+            RegionNull(&pDxgi->rgnPending[i]);
+        pScreenPriv->pDXGIPriv = pDxgi;
+    }
+
+    /* Create the device on the default adapter */
+    hr = ((PFN_D3D11_CREATE_DEVICE) g_fpD3D11CreateDevice)
+        (NULL, D3D_DRIVER_TYPE_HARDWARE, NULL,
+         D3D11_CREATE_DEVICE_BGRA_SUPPORT, NULL, 0,
+         D3D11_SDK_VERSION, &pDxgi->pDevice, &featureLevel,
+         &pDxgi->pContext);
+    if (FAILED(hr)) {
+        ErrorF("winCreatePrimarySurfaceShadowDXGI - D3D11CreateDevice "
+               "failed: %08x\n", (unsigned int) hr);
+        return FALSE;
+    }
+
+    /* Walk up from the device to the factory that owns the adapter */
+    hr = ID3D11Device_QueryInterface(pDxgi->pDevice, &IID_IDXGIDevice,
+                                     (void **) &pDxgiDevice);
+    if (SUCCEEDED(hr))
+        hr = IDXGIDevice_GetAdapter(pDxgiDevice, &pDxgiAdapter);
+    if (SUCCEEDED(hr))
+        hr = IDXGIAdapter_GetParent(pDxgiAdapter, &IID_IDXGIFactory2,
+                                    (void **) &pDxgiFactory);
+    if (FAILED(hr)) {
+        ErrorF("winCreatePrimarySurfaceShadowDXGI - Could not get "
+               "DXGI factory: %08x\n", (unsigned int) hr);
+        goto winCreatePrimarySurfaceShadowDXGI_Fail;
+    }
+
+    ZeroMemory(&scd, sizeof(scd));
+    scd.Width = pScreenInfo->dwWidth;
+    scd.Height = pScreenInfo->dwHeight;
+    scd.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    scd.SampleDesc.Count = 1;
+    scd.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT | DXGI_USAGE_BACK_BUFFER;
+    scd.BufferCount = WIN_DXGI_BUFFER_COUNT;
+    scd.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    scd.Scaling = DXGI_SCALING_STRETCH;
+
+    hr = IDXGIFactory2_CreateSwapChainForHwnd(pDxgiFactory,
+                                              (IUnknown *) pDxgi->pDevice,
+                                              pScreenPriv->hwndScreen,
+                                              &scd, NULL, NULL,
+                                              &pDxgi->pSwapChain);
+    if (FAILED(hr)) {
+        ErrorF("winCreatePrimarySurfaceShadowDXGI - "
+               "CreateSwapChainForHwnd failed: %08x\n", (unsigned int) hr);
+        goto winCreatePrimarySurfaceShadowDXGI_Fail;
+    }
+
+    /* We handle fullscreen ourselves via a borderless window */
+    IDXGIFactory2_MakeWindowAssociation(pDxgiFactory,
+                                        pScreenPriv->hwndScreen,
+                                        DXGI_MWA_NO_ALT_ENTER);
+
+    IDXGIFactory2_Release(pDxgiFactory);
+    IDXGIAdapter_Release(pDxgiAdapter);
+    IDXGIDevice_Release(pDxgiDevice);
+
+    /* Every back buffer starts out needing a full upload */
+    for (i = 0; i < WIN_DXGI_BUFFER_COUNT; ++i) {
+        BoxRec box = { 0, 0, pScreenInfo->dwWidth, pScreenInfo->dwHeight };
+        RegionReset(&pDxgi->rgnPending[i], &box);
+    }
+    pDxgi->iCurrentBuffer = 0;
+
+    winDebug("winCreatePrimarySurfaceShadowDXGI - Created flip-model "
+             "swapchain %dx%d\n",
+             (int) pScreenInfo->dwWidth, (int) pScreenInfo->dwHeight);
+
+    return TRUE;
+
+ winCreatePrimarySurfaceShadowDXGI_Fail:
+    if (pDxgiFactory)
+        IDXGIFactory2_Release(pDxgiFactory);
+    if (pDxgiAdapter)
+        IDXGIAdapter_Release(pDxgiAdapter);
+    if (pDxgiDevice)
+        IDXGIDevice_Release(pDxgiDevice);
+    winReleaseDXGI(pScreenPriv);
+    return FALSE;
+}
+
+/*
+ * Release the swapchain
+ */
+
+static Bool
+winReleasePrimarySurfaceShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    winDebug("winReleasePrimarySurfaceShadowDXGI - Hello\n");
+
+    winReleaseDXGI(pScreenPriv);
+
+    return TRUE;
+}
+
+/*
+ * Allocate the shadow framebuffer and create the swapchain
+ */
+
+static Bool
+winAllocateFBShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    winDebug("winAllocateFBShadowDXGI - w %u h %u d %u\n",
+             (unsigned int) pScreenInfo->dwWidth,
+             (unsigned int) pScreenInfo->dwHeight,
+             (unsigned int) pScreenInfo->dwDepth);
+
+    /* The swapchain back buffer is always 32 bpp BGRA */
+    if (pScreenInfo->dwBPP != 32) {
+        ErrorF("winAllocateFBShadowDXGI - Requires 32 bpp, have %d bpp\n",
+               (int) pScreenInfo->dwBPP);
+        return FALSE;
+    }
+
+    /* Set the padded screen width */
+    pScreenInfo->dwPaddedWidth = PixmapBytePad(pScreenInfo->dwWidth,
+                                               pScreenInfo->dwBPP);
+
+    if (pScreenInfo->pfb == NULL) {
+        pScreenInfo->pfb =
+            malloc(pScreenInfo->dwPaddedWidth * pScreenInfo->dwHeight);
+        if (pScreenInfo->pfb == NULL) {
+            ErrorF("winAllocateFBShadowDXGI - Could not allocate bits\n");
+            return FALSE;
+        }
+
+        /*
+         * Initialize the framebuffer memory so we don't get a
+         * strange display at startup
+         */
+        ZeroMemory(pScreenInfo->pfb,
+                   pScreenInfo->dwPaddedWidth * pScreenInfo->dwHeight);
+    }
+    else {
+        ErrorF("winAllocateFBShadowDXGI - called a second time, "
+               "recreating swapchain\n");
+        winReleaseDXGI(pScreenPriv);
+    }
+
+    if (!winCreatePrimarySurfaceShadowDXGI(pScreen))
+        return FALSE;
+
+    /* Grab the masks our back buffer format dictates */
+    pScreenPriv->dwRedMask = 0x00ff0000;
+    pScreenPriv->dwGreenMask = 0x0000ff00;
+    pScreenPriv->dwBlueMask = 0x000000ff;
+    pScreenPriv->dwBitsPerRGB = 8;
+
+    return TRUE;
+}
+
+/*
+ * Hand out the engine's device and immediate context (used by the
+ * Direct3D compositor, see winrender.c).  Returns FALSE until the
+ * swapchain has been created; callers must refetch on every use, since
+ * a device loss replaces both pointers.
+ */
+
+Bool
+winDxgiGetDevice(ScreenPtr pScreen, void **ppDevice, void **ppContext)
+{
+    winScreenPriv(pScreen);
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+
+    if (pDxgi == NULL || pDxgi->pDevice == NULL)
+        return FALSE;
+
+    *ppDevice = pDxgi->pDevice;
+    *ppContext = pDxgi->pContext;
+    return TRUE;
+}
+
+static void
+winFreeFBShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /* The compositor holds references on the device's children */
+    winRenderD3DRelease(pScreen);
+
+    winReleaseDXGI(pScreenPriv);
+
+    /* Free the shadow framebuffer */
+    free(pScreenInfo->pfb);
+    pScreenInfo->pfb = NULL;
+}
+
+/*
+ * Upload a region of shadow framebuffer rows into the current back
+ * buffer texture.
+ */
+
+static Bool
+winUploadRegionShadowDXGI(ScreenPtr pScreen, RegionPtr prgn)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+    ID3D11Texture2D *pBackBuffer = NULL;
+    BoxPtr pBox = RegionRects(prgn);
+    int iBox = RegionNumRects(prgn);
+    HRESULT hr;
+
+    hr = IDXGISwapChain1_GetBuffer(pDxgi->pSwapChain, 0,
+                                   &IID_ID3D11Texture2D,
+                                   (void **) &pBackBuffer);
+    if (FAILED(hr)) {
+        ErrorF("winUploadRegionShadowDXGI - GetBuffer failed: %08x\n",
+               (unsigned int) hr);
+        return FALSE;
+    }
+
+    while (iBox--) {
+        D3D11_BOX box;
+
+        box.left = pBox->x1;
+        box.top = pBox->y1;
+        box.front = 0;
+        box.right = pBox->x2;
+        box.bottom = pBox->y2;
+        box.back = 1;
+
+        ID3D11DeviceContext_UpdateSubresource(pDxgi->pContext,
+                                              (ID3D11Resource *) pBackBuffer,
+                                              0, &box,
+                                              pScreenInfo->pfb
+                                              + pBox->y1 *
+                                              pScreenInfo->dwPaddedWidth
+                                              + pBox->x1 * 4,
+                                              pScreenInfo->dwPaddedWidth, 0);
+        ++pBox;
+    }
+
+    ID3D11Texture2D_Release(pBackBuffer);
+    return TRUE;
+}
+
+/*
+ * Present a damaged region through the swapchain
+ */
+
+static Bool
+winPresentRegionShadowDXGI(ScreenPtr pScreen, RegionPtr prgnDamage)
+{
+    winScreenPriv(pScreen);
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+    RegionPtr prgnUpload;
+    DXGI_PRESENT_PARAMETERS pp;
+    HRESULT hr;
+    int i;
+
+    if (pDxgi == NULL || pDxgi->pSwapChain == NULL)
+        return FALSE;
+
+    /* Fold the new damage into every back buffer's pending region */
+    for (i = 0; i < WIN_DXGI_BUFFER_COUNT; ++i)
+        RegionUnion(&pDxgi->rgnPending[i], &pDxgi->rgnPending[i], prgnDamage);
+
+    /*
+     * The buffer about to be presented must be updated for all damage
+     * accumulated since it was last on screen, not just this frame's.
+     */
+    prgnUpload = &pDxgi->rgnPending[pDxgi->iCurrentBuffer];
+    if (!RegionNotEmpty(prgnUpload))
+        return TRUE;
+
+    if (!winUploadRegionShadowDXGI(pScreen, prgnUpload))
+        return FALSE;
+
+    ZeroMemory(&pp, sizeof(pp));
+    pp.DirtyRectsCount = RegionNumRects(prgnUpload);
+    pp.pDirtyRects = (RECT *) RegionRects(prgnUpload);
+
+    hr = IDXGISwapChain1_Present1(pDxgi->pSwapChain, 1, 0, &pp);
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET) {
+        ErrorF("winPresentRegionShadowDXGI - Device lost, recreating "
+               "swapchain\n");
+        winReleaseDXGI(pScreenPriv);
+        winCreatePrimarySurfaceShadowDXGI(pScreen);
+        return FALSE;
+    }
+    if (FAILED(hr)) {
+        ErrorF("winPresentRegionShadowDXGI - Present1 failed: %08x\n",
+               (unsigned int) hr);
+        return FALSE;
+    }
+
+    /* This buffer is now clean; rotate to the next one */
+    RegionEmpty(prgnUpload);
+    pDxgi->iCurrentBuffer = (pDxgi->iCurrentBuffer + 1)
+        % WIN_DXGI_BUFFER_COUNT;
+
+    return TRUE;
+}
+
+/*
+ * Transfer the damaged regions of the shadow framebuffer to the screen.
+ */
+
+static void
+winShadowUpdateDXGI(ScreenPtr pScreen, shadowBufPtr pBuf)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    RegionPtr damage = DamageRegion(pBuf->pDamage);
+
+    /*
+     * Return immediately if the app is not active
+     * and we are fullscreen, or if we have a bad display depth
+     */
+    if ((!pScreenPriv->fActive && pScreenInfo->fFullScreen)
+        || pScreenPriv->fBadDepth)
+        return;
+
+    winPresentRegionShadowDXGI(pScreen, damage);
+}
+
+/*
+ * Call the wrapped CloseScreen function.
+ *
+ * Free our resources and private structures.
+ */
+
+static Bool
+winCloseScreenShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    Bool fReturn = TRUE;
+
+    winDebug("winCloseScreenShadowDXGI - Freeing screen resources\n");
+
+    /* Flag that the screen is closed */
+    pScreenPriv->fClosed = TRUE;
+    pScreenPriv->fActive = FALSE;
+
+    /* Call the wrapped CloseScreen procedure */
+    WIN_UNWRAP(CloseScreen);
+    if (pScreen->CloseScreen)
+        fReturn = (*pScreen->CloseScreen) (pScreen);
+
+    winFreeFBShadowDXGI(pScreen);
+
+    /* Delete the window property */
+    RemoveProp(pScreenPriv->hwndScreen, WIN_SCR_PROP);
+
+    /* Delete tray icon, if we have one */
+    if (!pScreenInfo->fNoTrayIcon)
+        winDeleteNotifyIcon(pScreenPriv);
+
+    /* Free the exit confirmation dialog box, if it exists */
+    if (g_hDlgExit != NULL) {
+        DestroyWindow(g_hDlgExit);
+        g_hDlgExit = NULL;
+    }
+
+    /* Kill our window */
+    if (pScreenPriv->hwndScreen) {
+        DestroyWindow(pScreenPriv->hwndScreen);
+        pScreenPriv->hwndScreen = NULL;
+    }
+
+    /* Invalidate our screeninfo's pointer to the screen */
+    pScreenInfo->pScreen = NULL;
+
+    /* Free the screen privates for this screen */
+    free((void *) pScreenPriv);
+
+    return fReturn;
+}
+
+/*
+ * Tell mi what sort of visuals we need.
+ *
+ * The swapchain back buffer is BGRA8888, so we only support 32 bpp
+ * TrueColor; winSetEngine never selects this engine at other depths.
+ */
+
+static Bool
+winInitVisualsShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    winDebug("winInitVisualsShadowDXGI - Masks %08x %08x %08x BPRGB %d "
+             "d %d bpp %d\n",
+             (unsigned int) pScreenPriv->dwRedMask,
+             (unsigned int) pScreenPriv->dwGreenMask,
+             (unsigned int) pScreenPriv->dwBlueMask,
+             (int) pScreenPriv->dwBitsPerRGB,
+             (int) pScreenInfo->dwDepth, (int) pScreenInfo->dwBPP);
+
+    if (pScreenInfo->dwDepth != 24) {
+        ErrorF("winInitVisualsShadowDXGI - Unsupported screen depth %d\n",
+               (int) pScreenInfo->dwDepth);
+        return FALSE;
+    }
+
+    if (!miSetVisualTypesAndMasks(pScreenInfo->dwDepth,
+                                  TrueColorMask,
+                                  pScreenPriv->dwBitsPerRGB,
+                                  TrueColor,
+                                  pScreenPriv->dwRedMask,
+                                  pScreenPriv->dwGreenMask,
+                                  pScreenPriv->dwBlueMask)) {
+        ErrorF("winInitVisualsShadowDXGI - miSetVisualTypesAndMasks "
+               "failed\n");
+        return FALSE;
+    }
+
+    winDebug("winInitVisualsShadowDXGI - Returning\n");
+
+    return TRUE;
+}
+
+/*
+ * Adjust the user proposed video mode
+ */
+
+static Bool
+winAdjustVideoModeShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    HDC hdc;
+    DWORD dwBPP;
+
+    hdc = GetDC(NULL);
+
+    /* We're in serious trouble if we can't get a DC */
+    if (hdc == NULL) {
+        ErrorF("winAdjustVideoModeShadowDXGI - GetDC () failed\n");
+        return FALSE;
+    }
+
+    /* Query GDI for current display depth */
+    dwBPP = GetDeviceCaps(hdc, BITSPIXEL);
+
+    /* The swapchain only does 32 bpp, regardless of the desktop depth */
+    if (pScreenInfo->dwBPP == WIN_DEFAULT_BPP) {
+        winDebug("winAdjustVideoModeShadowDXGI - Using 32 bpp\n");
+        pScreenInfo->dwBPP = 32;
+    }
+    else if (pScreenInfo->dwBPP != 32) {
+        ErrorF("winAdjustVideoModeShadowDXGI - DXGI engine only supports "
+               "32 bpp, requested %d\n", (int) pScreenInfo->dwBPP);
+        ReleaseDC(NULL, hdc);
+        return FALSE;
+    }
+
+    winDebug("winAdjustVideoModeShadowDXGI - Desktop bpp %d, screen "
+             "bpp %d\n", (int) dwBPP, (int) pScreenInfo->dwBPP);
+
+    ReleaseDC(NULL, hdc);
+
+    return TRUE;
+}
+
+/*
+ * Blt exposed regions to the screen: repaint everything the window
+ * system invalidated from the shadow surface.
+ */
+
+static Bool
+winBltExposedRegionsShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    PAINTSTRUCT ps;
+    HDC hdcUpdate;
+    RegionRec rgnFull;
+    BoxRec box = { 0, 0, pScreenInfo->dwWidth, pScreenInfo->dwHeight };
+    Bool fReturn;
+
+    /* BeginPaint/EndPaint just validate the update region; the actual
+     * pixels always come back from the swapchain */
+    hdcUpdate = BeginPaint(pScreenPriv->hwndScreen, &ps);
+    if (hdcUpdate != NULL)
+        EndPaint(pScreenPriv->hwndScreen, &ps);
+
+    /* With flip-model there is no per-rect window blit; re-present the
+     * whole shadow surface */
+    RegionInit(&rgnFull, &box, 1);
+    fReturn = winPresentRegionShadowDXGI(pScreen, &rgnFull);
+    RegionUninit(&rgnFull);
+
+    return fReturn;
+}
+
+/*
+ * Do any engine-specific application-activation processing
+ */
+
+static Bool
+winActivateAppShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    /*
+     * Force a full repaint when we are activated, as the compositor
+     * may have discarded our buffers while we were inactive.
+     */
+    if (pScreenPriv != NULL && pScreenPriv->fActive)
+        winRedrawScreenShadowDXGI(pScreen);
+
+    return TRUE;
+}
+
+/*
+ * Reblit the shadow framebuffer to the screen.
+ */
+
+static Bool
+winRedrawScreenShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    RegionRec rgnFull;
+    BoxRec box = { 0, 0, pScreenInfo->dwWidth, pScreenInfo->dwHeight };
+    Bool fReturn;
+
+    RegionInit(&rgnFull, &box, 1);
+    fReturn = winPresentRegionShadowDXGI(pScreen, &rgnFull);
+    RegionUninit(&rgnFull);
+
+    return fReturn;
+}
+
+/*
+ * Realize the currently installed colormap
+ */
+
+static Bool
+winRealizeInstalledPaletteShadowDXGI(ScreenPtr pScreen)
+{
+    /* TrueColor only, nothing to realize */
+    return TRUE;
+}
+
+/*
+ * Install the specified colormap
+ */
+
+static Bool
+winInstallColormapShadowDXGI(ColormapPtr pColormap)
+{
+    return TRUE;
+}
+
+/*
+ * Store the specified colors in the specified colormap
+ */
+
+static Bool
+winStoreColorsShadowDXGI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
+{
+    return TRUE;
+}
+
+/*
+ * Colormap initialization procedure
+ */
+
+static Bool
+winCreateColormapShadowDXGI(ColormapPtr pColormap)
+{
+    return TRUE;
+}
+
+/*
+ * Colormap destruction procedure
+ */
+
+static Bool
+winDestroyColormapShadowDXGI(ColormapPtr pColormap)
+{
+    return TRUE;
+}
+
+/*
+ * Set pointers to our engine specific functions
+ */
+
+static Bool
+winInitScreenShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+
+    /* Get a device context for the screen  */
+    pScreenPriv->hdcScreen = GetDC(pScreenPriv->hwndScreen);
+
+    return winAllocateFBShadowDXGI(pScreen);
+}
+
+/*
+ * Shared-handle pixmap import
+ *
+ * A local GPU-rendering client can hand us a DXGI legacy shared handle
+ * (a resource created with D3D11_RESOURCE_MISC_SHARED; those handle
+ * values are valid in any process) through the WindowsDRI extension,
+ * and we bind the texture as the backing store of one of its pixmaps.
+ * The client then renders on the GPU and presents with CopyArea as
+ * usual, but instead of a full-frame PutImage upload the pixel transfer
+ * is a GPU copy into a staging texture plus one mapped readback, done
+ * lazily when the pixmap is next copied from.
+ *
+ * Synchronisation relies on the client flushing its device before
+ * issuing the copy request; legacy shared handles carry no keyed
+ * mutex.  Readback happens in the CopyArea wrapper below, which is the
+ * path both plain clients and the Present fallback copy use; core
+ * GetImage of a bound pixmap returns the bits of the last readback.
+ */
+
+static Bool
+winDxgiSyncSharedPixmap(PixmapPtr pPixmap)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
+    winScreenPriv(pScreen);
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+    winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+    ID3D11Texture2D *pShared = (ID3D11Texture2D *) pPixmapPriv->pSharedTexture;
+    ID3D11Texture2D *pStaging =
+        (ID3D11Texture2D *) pPixmapPriv->pStagingTexture;
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    char *pDst;
+    int iRow, cbRow;
+    HRESULT hr;
+
+    if (pDxgi == NULL || pShared == NULL || pStaging == NULL)
+        return FALSE;
+
+    ID3D11DeviceContext_CopyResource(pDxgi->pContext,
+                                     (ID3D11Resource *) pStaging,
+                                     (ID3D11Resource *) pShared);
+
+    hr = ID3D11DeviceContext_Map(pDxgi->pContext,
+                                 (ID3D11Resource *) pStaging, 0,
+                                 D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr)) {
+        ErrorF("winDxgiSyncSharedPixmap - Map failed: %08x\n",
+               (unsigned int) hr);
+        return FALSE;
+    }
+
+    pDst = (char *) pPixmap->devPrivate.ptr;
+    cbRow = pPixmap->drawable.width * (pPixmap->drawable.bitsPerPixel / 8);
+    for (iRow = 0; iRow < pPixmap->drawable.height; ++iRow)
+        memcpy(pDst + iRow * pPixmap->devKind,
+               (char *) mapped.pData + iRow * mapped.RowPitch, cbRow);
+
+    ID3D11DeviceContext_Unmap(pDxgi->pContext,
+                              (ID3D11Resource *) pStaging, 0);
+
+    return TRUE;
+}
+
+static void
+winDxgiReleaseSharedPixmap(PixmapPtr pPixmap)
+{
+    winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+
+    if (pPixmapPriv->pSharedTexture) {
+        ID3D11Texture2D_Release((ID3D11Texture2D *)
+                                pPixmapPriv->pSharedTexture);
+        pPixmapPriv->pSharedTexture = NULL;
+    }
+    if (pPixmapPriv->pStagingTexture) {
+        ID3D11Texture2D_Release((ID3D11Texture2D *)
+                                pPixmapPriv->pStagingTexture);
+        pPixmapPriv->pStagingTexture = NULL;
+    }
+}
+
+/*
+ * Import a DXGI legacy shared handle as the backing of a pixmap.
+ * Returns an X protocol error code; called from the WindowsDRI
+ * extension (see dri/windowsdri.c).
+ */
+
+int
+winDxgiBindSharedPixmap(PixmapPtr pPixmap, CARD32 dwHandle)
+{
+    ScreenPtr pScreen = pPixmap->drawable.pScreen;
+
+    winScreenPriv(pScreen);
+    winDXGIPrivPtr pDxgi = (winDXGIPrivPtr) pScreenPriv->pDXGIPriv;
+    ID3D11Texture2D *pShared = NULL;
+    ID3D11Texture2D *pStaging = NULL;
+    D3D11_TEXTURE2D_DESC desc;
+    HRESULT hr;
+
+    /* Only the DXGI engine has a device to import into */
+    if (pDxgi == NULL || pDxgi->pDevice == NULL)
+        return BadMatch;
+
+    if (pPixmap->drawable.bitsPerPixel != 32)
+        return BadMatch;
+
+    hr = ID3D11Device_OpenSharedResource(pDxgi->pDevice,
+                                         (HANDLE) (uintptr_t) dwHandle,
+                                         &IID_ID3D11Texture2D,
+                                         (void **) &pShared);
+    if (FAILED(hr)) {
+        ErrorF("winDxgiBindSharedPixmap - OpenSharedResource failed: %08x\n",
+               (unsigned int) hr);
+        return BadMatch;
+    }
+
+    /* The texture must match the pixmap's geometry and pixel size */
+    ID3D11Texture2D_GetDesc(pShared, &desc);
+    if (desc.Width != (UINT) pPixmap->drawable.width ||
+        desc.Height != (UINT) pPixmap->drawable.height ||
+        (desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM &&
+         desc.Format != DXGI_FORMAT_B8G8R8X8_UNORM)) {
+        ErrorF("winDxgiBindSharedPixmap - %ux%u format %d does not match "
+               "%dx%d pixmap\n", (unsigned int) desc.Width,
+               (unsigned int) desc.Height, (int) desc.Format,
+               pPixmap->drawable.width, pPixmap->drawable.height);
+        ID3D11Texture2D_Release(pShared);
+        return BadMatch;
+    }
+
+    /* Staging copy for mapped readback */
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    desc.MiscFlags = 0;
+    hr = ID3D11Device_CreateTexture2D(pDxgi->pDevice, &desc, NULL, &pStaging);
+    if (FAILED(hr)) {
+        ErrorF("winDxgiBindSharedPixmap - CreateTexture2D failed: %08x\n",
+               (unsigned int) hr);
+        ID3D11Texture2D_Release(pShared);
+        return BadAlloc;
+    }
+
+    /* Rebinding replaces any previous import */
+    winDxgiReleaseSharedPixmap(pPixmap);
+    {
+        winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+
+        pPixmapPriv->pSharedTexture = pShared;
+        pPixmapPriv->pStagingTexture = pStaging;
+    }
+
+    return Success;
+}
+
+/*
+ * CopyArea - read back bound shared textures before fb copies from them
+ *
+ * fb's GC ops with CopyArea replaced, cloned from whatever ops the
+ * wrapped CreateGC installed; the damage layer wraps on top during
+ * ValidateGC, so damage recording is unaffected.
+ */
+
+static GCOps winGCOpsShadowDXGI;
+static const GCOps *winWrappedGCOpsDXGI = NULL;
+
+static RegionPtr
+winCopyAreaShadowDXGI(DrawablePtr pSrcDrawable, DrawablePtr pDstDrawable,
+                      GCPtr pGC, int srcx, int srcy,
+                      int width, int height, int dstx, int dsty)
+{
+    if (pSrcDrawable->type == DRAWABLE_PIXMAP &&
+        winGetPixmapPriv((PixmapPtr) pSrcDrawable)->pSharedTexture)
+        winDxgiSyncSharedPixmap((PixmapPtr) pSrcDrawable);
+
+    return (*winWrappedGCOpsDXGI->CopyArea) (pSrcDrawable, pDstDrawable, pGC,
+                                             srcx, srcy, width, height,
+                                             dstx, dsty);
+}
+
+Bool
+winCreateGCShadowDXGI(GCPtr pGC)
+{
+    ScreenPtr pScreen = pGC->pScreen;
+
+    winScreenPriv(pScreen);
+    Bool fResult;
+
+    fResult = (*pScreenPriv->CreateGC) (pGC);
+    if (!fResult)
+        return fResult;
+
+    if (winWrappedGCOpsDXGI == NULL) {
+        winGCOpsShadowDXGI = *pGC->ops;
+        winGCOpsShadowDXGI.CopyArea = winCopyAreaShadowDXGI;
+        winWrappedGCOpsDXGI = pGC->ops;
+    }
+
+    if (pGC->ops == winWrappedGCOpsDXGI)
+        pGC->ops = &winGCOpsShadowDXGI;
+
+    return fResult;
+}
+
+/*
+ * DestroyPixmap - release any imported textures with the pixmap
+ */
+
+Bool
+winDestroyPixmapShadowDXGI(PixmapPtr pPixmap)
+{
+    ScreenPtr pScreen;
+
+    if (pPixmap == NULL)
+        return TRUE;
+
+    if (pPixmap->refcnt == 1) {
+        winDxgiReleaseSharedPixmap(pPixmap);
+        winRenderD3DReleasePixmap(pPixmap);
+    }
+
+    pScreen = pPixmap->drawable.pScreen;
+    {
+        winScreenPriv(pScreen);
+
+        return (*pScreenPriv->DestroyPixmap) (pPixmap);
+    }
+}
+
+Bool
+winSetEngineFunctionsShadowDXGI(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    /* Set our pointers */
+    pScreenPriv->pwinAllocateFB = winAllocateFBShadowDXGI;
+    pScreenPriv->pwinFreeFB = winFreeFBShadowDXGI;
+    pScreenPriv->pwinShadowUpdate = winShadowUpdateDXGI;
+    pScreenPriv->pwinInitScreen = winInitScreenShadowDXGI;
+    pScreenPriv->pwinCloseScreen = winCloseScreenShadowDXGI;
+    pScreenPriv->pwinInitVisuals = winInitVisualsShadowDXGI;
+    pScreenPriv->pwinAdjustVideoMode = winAdjustVideoModeShadowDXGI;
+    if (pScreenInfo->fFullScreen)
+        pScreenPriv->pwinCreateBoundingWindow =
+            winCreateBoundingWindowFullScreen;
+    else
+        pScreenPriv->pwinCreateBoundingWindow = winCreateBoundingWindowWindowed;
+    pScreenPriv->pwinFinishScreenInit = winFinishScreenInitFB;
+    pScreenPriv->pwinBltExposedRegions = winBltExposedRegionsShadowDXGI;
+    pScreenPriv->pwinBltExposedWindowRegion = NULL;
+    pScreenPriv->pwinActivateApp = winActivateAppShadowDXGI;
+    pScreenPriv->pwinRedrawScreen = winRedrawScreenShadowDXGI;
+    pScreenPriv->pwinRealizeInstalledPalette
+        = winRealizeInstalledPaletteShadowDXGI;
+    pScreenPriv->pwinInstallColormap = winInstallColormapShadowDXGI;
+    pScreenPriv->pwinStoreColors = winStoreColorsShadowDXGI;
+    pScreenPriv->pwinCreateColormap = winCreateColormapShadowDXGI;
+    pScreenPriv->pwinDestroyColormap = winDestroyColormapShadowDXGI;
+    pScreenPriv->pwinCreatePrimarySurface = winCreatePrimarySurfaceShadowDXGI;
+    pScreenPriv->pwinReleasePrimarySurface = winReleasePrimarySurfaceShadowDXGI;
+
+    return TRUE;
+}
@@ -33,6 +33,12 @@
 #endif
 #include "win.h"
 #include "winprefs.h"
+#include <dwmapi.h>
+
+/* Not defined in older SDK headers */
+#ifndef DWMWA_CLOAKED
+#define DWMWA_CLOAKED 14
+#endif
 
 /*
  * Local function prototypes
@@ -84,6 +90,11 @@ static Bool
 static Bool
  winDestroyColormapShadowGDI(ColormapPtr pColormap);
 
+static RegionPtr
+winCopyAreaShadowGDI(DrawablePtr pSrcDrawable, DrawablePtr pDstDrawable,
+                     GCPtr pGC, int srcx, int srcy,
+                     int width, int height, int dstx, int dsty);
+
 /*
  * Internal function to get the DIB format that is compatible with the screen
  */
@@ -278,38 +289,138 @@ winRedrawAllProcShadowGDI(HWND hwnd, LPARAM lParam)
     return TRUE;
 }
 
+/*
+ * List of damaged boxes handed to winRedrawDamagedWindowShadowGDI for
+ * each top-level window
+ */
+
+typedef struct {
+    BoxPtr pBox;
+    int iBoxes;
+} winDamageBoxesRec;
+
 static wBOOL CALLBACK
 winRedrawDamagedWindowShadowGDI(HWND hwnd, LPARAM lParam)
 {
-    BoxPtr pDamage = (BoxPtr) lParam;
+    winDamageBoxesRec *pDamage = (winDamageBoxesRec *) lParam;
+    BoxPtr pBox = pDamage->pBox;
+    int iBox = pDamage->iBoxes;
     RECT rcClient, rcDamage, rcRedraw;
-    POINT topLeft, bottomRight;
+    POINT ptOrigin;
+    int iXOffset, iYOffset;
+    Bool fInvalidated = FALSE;
+    DWORD dwDamageArea = 0;
+
+    Bool fCloaked = FALSE;
 
     if (IsIconic(hwnd))
         return TRUE;            /* Don't care minimized windows */
 
-    /* Convert the damaged area from Screen coords to Client coords */
-    topLeft.x = pDamage->x1;
-    topLeft.y = pDamage->y1;
-    bottomRight.x = pDamage->x2;
-    bottomRight.y = pDamage->y2;
-    topLeft.x += GetSystemMetrics(SM_XVIRTUALSCREEN);
-    bottomRight.x += GetSystemMetrics(SM_XVIRTUALSCREEN);
-    topLeft.y += GetSystemMetrics(SM_YVIRTUALSCREEN);
-    bottomRight.y += GetSystemMetrics(SM_YVIRTUALSCREEN);
-    ScreenToClient(hwnd, &topLeft);
-    ScreenToClient(hwnd, &bottomRight);
-    SetRect(&rcDamage, topLeft.x, topLeft.y, bottomRight.x, bottomRight.y);
+    /*
+     * A cloaked window (on another virtual desktop, or hidden by the
+     * shell) still receives WM_PAINT even though nothing it draws can
+     * be seen.  Accumulate the damage in its Win32 update region but
+     * skip the synchronous repaint below, so the blits for all damage
+     * it takes while cloaked coalesce into the one WM_PAINT the queue
+     * delivers; nothing goes stale since the update region survives
+     * until it is painted.
+     */
+    DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &fCloaked, sizeof(fCloaked));
+
+    /* Find the client area origin in virtual screen coords */
+    ptOrigin.x = 0;
+    ptOrigin.y = 0;
+    ClientToScreen(hwnd, &ptOrigin);
+    iXOffset = GetSystemMetrics(SM_XVIRTUALSCREEN) - ptOrigin.x;
+    iYOffset = GetSystemMetrics(SM_YVIRTUALSCREEN) - ptOrigin.y;
 
     GetClientRect(hwnd, &rcClient);
 
-    if (IntersectRect(&rcRedraw, &rcClient, &rcDamage)) {
-        InvalidateRect(hwnd, &rcRedraw, FALSE);
-        UpdateWindow(hwnd);
+    /*
+     * Invalidate each damaged box separately, so the WM_PAINT that
+     * follows repaints the union of the damage rather than its
+     * bounding box.  A small dialog dragged across one corner of a
+     * large window then only re-copies the strips it uncovered.
+     */
+    while (iBox--) {
+        SetRect(&rcDamage,
+                pBox->x1 + iXOffset, pBox->y1 + iYOffset,
+                pBox->x2 + iXOffset, pBox->y2 + iYOffset);
+        ++pBox;
+
+        if (IntersectRect(&rcRedraw, &rcClient, &rcDamage)) {
+            InvalidateRect(hwnd, &rcRedraw, FALSE);
+            fInvalidated = TRUE;
+            dwDamageArea += (rcRedraw.right - rcRedraw.left) *
+                (rcRedraw.bottom - rcRedraw.top);
+        }
+    }
+
+    if (fInvalidated) {
+        WindowPtr pWin = GetProp(hwnd, WIN_WINDOW_PROP);
+
+        if (!fCloaked)
+            UpdateWindow(hwnd);
+
+        /* Let DWM refresh its cached taskbar preview once the window
+           has changed enough to be worth it */
+        if (pWin != NULL)
+            winTaskbarPreviewDamage(pWin, hwnd, dwDamageArea);
     }
+
     return TRUE;
 }
 
+/*
+ * Try to create a large-page backed file mapping for the shadow DIB.
+ *
+ * Large pages cut TLB pressure on the blit loops measurably at 4K-ish
+ * framebuffer sizes, but they need the SeLockMemoryPrivilege, which is
+ * not granted to ordinary users by default.  Any failure here is
+ * answered with NULL and the caller falls back to letting GDI allocate
+ * the section itself.
+ */
+
+static HANDLE
+winTryLargePageSection(DWORD dwSize)
+{
+    HANDLE hToken;
+    HANDLE hSection;
+    TOKEN_PRIVILEGES tp;
+    SIZE_T dwLargePageSize;
+
+    dwLargePageSize = GetLargePageMinimum();
+    if (dwLargePageSize == 0)
+        return NULL;
+
+    /* Enable the lock-memory privilege, if the account holds it */
+    if (!OpenProcessToken(GetCurrentProcess(),
+                          TOKEN_ADJUST_PRIVILEGES, &hToken))
+        return NULL;
+    tp.PrivilegeCount = 1;
+    tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    if (!LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME,
+                              &tp.Privileges[0].Luid)) {
+        CloseHandle(hToken);
+        return NULL;
+    }
+    AdjustTokenPrivileges(hToken, FALSE, &tp, 0, NULL, NULL);
+    CloseHandle(hToken);
+    if (GetLastError() != ERROR_SUCCESS)
+        return NULL;
+
+    /* Large-page sections must be a multiple of the large page size */
+    dwSize = (dwSize + dwLargePageSize - 1) & ~(dwLargePageSize - 1);
+
+    hSection = CreateFileMapping(INVALID_HANDLE_VALUE, NULL,
+                                 PAGE_READWRITE | SEC_COMMIT |
+                                 SEC_LARGE_PAGES, 0, dwSize, NULL);
+    if (hSection != NULL)
+        winDebug("winTryLargePageSection - Backing shadow with %d large "
+                 "pages\n", (int) (dwSize / dwLargePageSize));
+    return hSection;
+}
+
 /*
  * Allocate a DIB for the shadow framebuffer GDI server
  */
@@ -321,22 +432,51 @@ winAllocateFBShadowGDI(ScreenPtr pScreen)
     winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
     DIBSECTION dibsection;
     Bool fReturn = TRUE;
+    DWORD dwHeightMax;
+
+    /*
+     * Over-allocate shadow rows up to the tallest display so that a
+     * later RandR resize with an unchanged width can reuse this DIB
+     * in place rather than blanking the screen while it is recreated
+     * (see winDoRandRScreenSetSize)
+     */
+    dwHeightMax = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+    if (dwHeightMax < pScreenInfo->dwHeight)
+        dwHeightMax = pScreenInfo->dwHeight;
 
     /* Describe shadow bitmap to be created */
     pScreenPriv->pbmih->biWidth = pScreenInfo->dwWidth;
-    pScreenPriv->pbmih->biHeight = -pScreenInfo->dwHeight;
+    pScreenPriv->pbmih->biHeight = -dwHeightMax;
 
     winDebug ("winAllocateFBShadowGDI - Creating DIB with width: %d height: %d "
               "depth: %d\n",
               (int) pScreenPriv->pbmih->biWidth,
               (int) -pScreenPriv->pbmih->biHeight, pScreenPriv->pbmih->biBitCount);
 
+    /* Try to back the DIB with a large-page section */
+    pScreenPriv->hShadowSection =
+        winTryLargePageSection(((pScreenInfo->dwWidth
+                                 * pScreenPriv->pbmih->biBitCount
+                                 + 31) / 32) * 4 * dwHeightMax);
+
     /* Create a DI shadow bitmap with a bit pointer */
     pScreenPriv->hbmpShadow = CreateDIBSection(pScreenPriv->hdcScreen,
                                                (BITMAPINFO *) pScreenPriv->
                                                pbmih, DIB_RGB_COLORS,
                                                (VOID **) &pScreenInfo->pfb,
-                                               NULL, 0);
+                                               pScreenPriv->hShadowSection, 0);
+    if (pScreenPriv->hbmpShadow == NULL && pScreenPriv->hShadowSection != NULL) {
+        /* Retry with a GDI-allocated section */
+        winDebug("winAllocateFBShadowGDI - Large-page section rejected, "
+                 "falling back\n");
+        CloseHandle(pScreenPriv->hShadowSection);
+        pScreenPriv->hShadowSection = NULL;
+        pScreenPriv->hbmpShadow = CreateDIBSection(pScreenPriv->hdcScreen,
+                                                   (BITMAPINFO *) pScreenPriv->
+                                                   pbmih, DIB_RGB_COLORS,
+                                                   (VOID **) &pScreenInfo->pfb,
+                                                   NULL, 0);
+    }
     if (pScreenPriv->hbmpShadow == NULL || pScreenInfo->pfb == NULL) {
         winW32Error ("winAllocateFBShadowGDI - CreateDIBSection failed:");
         return FALSE;
@@ -388,6 +528,9 @@ winAllocateFBShadowGDI(ScreenPtr pScreen)
     winDebug("winAllocateFBShadowGDI - Created shadow stride: %d\n",
              (int) pScreenInfo->dwStride);
 
+    /* Remember how many rows the DIB actually has */
+    pScreenInfo->dwShadowHeightMax = dwHeightMax;
+
     /* Redraw all windows */
     if (pScreenInfo->fMultiWindow)
         EnumThreadWindows(g_dwCurrentThreadID, winRedrawAllProcShadowGDI, 0);
@@ -404,8 +547,74 @@ winFreeFBShadowGDI(ScreenPtr pScreen)
     /* Free the shadow bitmap */
     DeleteObject(pScreenPriv->hbmpShadow);
 
+    /* Release the large-page section backing it, if any */
+    if (pScreenPriv->hShadowSection != NULL) {
+        CloseHandle(pScreenPriv->hShadowSection);
+        pScreenPriv->hShadowSection = NULL;
+    }
+
     /* Invalidate the ScreenInfo's fb pointer */
     pScreenInfo->pfb = NULL;
+    pScreenInfo->dwShadowHeightMax = 0;
+}
+
+/*
+ * Coalesce a damage box list before blitting.
+ *
+ * Terminal emulators and the like report hundreds of tiny boxes per
+ * update; at that point the per-call overhead of BitBlt dominates the
+ * cost of the pixels actually copied.  Greedily merge a box into its
+ * predecessor whenever the area wasted by the union (union minus the
+ * two boxes) is below WIN_GDI_COALESCE_WASTE_MAX pixels, and cap the
+ * number of boxes we are prepared to blit per update.  Boxes arrive
+ * from the region code in y-x banded order, so neighbouring list
+ * entries are usually spatial neighbours too.
+ *
+ * Returns the number of boxes written to pOut (at most
+ * WIN_GDI_COALESCE_MAX_BLTS), or -1 if the caller should fall back to
+ * a single extents-clipped blit.
+ */
+
+#define WIN_GDI_COALESCE_WASTE_MAX	4096
+#define WIN_GDI_COALESCE_MAX_BLTS	64
+
+static int
+winCoalesceDamageBoxes(BoxPtr pBox, int nBox, BoxRec * pOut)
+{
+    int nOut = 0;
+    int i;
+
+    for (i = 0; i < nBox; ++i) {
+        if (nOut > 0) {
+            BoxPtr pPrev = &pOut[nOut - 1];
+            int x1 = min(pPrev->x1, pBox[i].x1);
+            int y1 = min(pPrev->y1, pBox[i].y1);
+            int x2 = max(pPrev->x2, pBox[i].x2);
+            int y2 = max(pPrev->y2, pBox[i].y2);
+            int iUnion = (x2 - x1) * (y2 - y1);
+            int iWaste = iUnion
+                - (pPrev->x2 - pPrev->x1) * (pPrev->y2 - pPrev->y1)
+                - (pBox[i].x2 - pBox[i].x1) * (pBox[i].y2 - pBox[i].y1);
+
+            /* Overlapping unions make iWaste an over-estimate, which
+               only makes the merge test more conservative */
+            if (iWaste <= WIN_GDI_COALESCE_WASTE_MAX) {
+                pPrev->x1 = x1;
+                pPrev->y1 = y1;
+                pPrev->x2 = x2;
+                pPrev->y2 = y2;
+                continue;
+            }
+        }
+
+        /* Too many boxes even after merging; blit the extents instead */
+        if (nOut == WIN_GDI_COALESCE_MAX_BLTS)
+            return -1;
+
+        pOut[nOut++] = pBox[i];
+    }
+
+    return nOut;
 }
 
 /*
@@ -427,6 +636,8 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
     static DWORD s_dwNonUnitRegions = 0;
     static DWORD s_dwTotalUpdates = 0;
     static DWORD s_dwTotalBoxes = 0;
+    static DWORD s_dwBoxesIn = 0;
+    static DWORD s_dwBoxesBlitted = 0;
 #endif
     BoxPtr pBoxExtents = RegionExtents(damage);
 
@@ -438,6 +649,56 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
         || pScreenPriv->fBadDepth)
         return;
 
+    /*
+     * None of our pixels can be seen while the screen window is
+     * minimized, so skip the blits; the shadow framebuffer still
+     * accumulates every update.  Windows invalidates the window when
+     * it is restored, and the WM_PAINT that follows repaints it from
+     * the shadow in one pass.  Multiwindow mode skips per-window
+     * instead, in winRedrawDamagedWindowShadowGDI.
+     */
+    if (!pScreenInfo->fMultiWindow && IsIconic(pScreenPriv->hwndScreen))
+        return;
+
+    winTraceShadowPresent(WIN_TRACE_PRESENT_GDI, dwBox, pBoxExtents);
+
+    /*
+     * Present at device resolution when -scaling is active.  One
+     * HALFTONE stretch of the damage extents; HALFTONE box-filters
+     * when shrinking and interpolates when magnifying, and the source
+     * alignment from winScaleDamageBox keeps adjacent stretches from
+     * seaming.
+     */
+    if (pScreenInfo->dwScale != WIN_DEFAULT_SCALE) {
+        RECT rcSrc, rcDest;
+
+        winScaleDamageBox(pScreenInfo, pBoxExtents, &rcSrc, &rcDest);
+        SetStretchBltMode(pScreenPriv->hdcScreen, HALFTONE);
+        SetBrushOrgEx(pScreenPriv->hdcScreen, 0, 0, NULL);
+        StretchBlt(pScreenPriv->hdcScreen,
+                   rcDest.left, rcDest.top,
+                   rcDest.right - rcDest.left, rcDest.bottom - rcDest.top,
+                   pScreenPriv->hdcShadow,
+                   rcSrc.left, rcSrc.top,
+                   rcSrc.right - rcSrc.left, rcSrc.bottom - rcSrc.top,
+                   SRCCOPY);
+        return;
+    }
+
+    /* Farm damage spanning several monitors out to per-monitor workers */
+    if (pScreenInfo->fParallelUpdates && !pScreenInfo->fMultiWindow) {
+        if (pScreenPriv->pParallelShadow == NULL
+            && !pScreenPriv->fParallelShadowFailed) {
+            pScreenPriv->pParallelShadow = winParallelShadowInit(pScreen);
+            if (pScreenPriv->pParallelShadow == NULL)
+                pScreenPriv->fParallelShadowFailed = TRUE;
+        }
+
+        if (pScreenPriv->pParallelShadow != NULL
+            && winParallelShadowUpdate(pScreenPriv->pParallelShadow, damage))
+            return;
+    }
+
 #ifdef XWIN_UPDATESTATS
     ++s_dwTotalUpdates;
     s_dwTotalBoxes += dwBox;
@@ -449,10 +710,11 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
 
     if ((s_dwTotalUpdates % 100) == 0)
         winDebug ("winShadowUpdateGDI - %d%% non-unity regions, avg boxes: %d "
-                  "nu: %d tu: %d\n",
+                  "nu: %d tu: %d coalesce in: %d out: %d\n",
                   (s_dwNonUnitRegions * 100) / s_dwTotalUpdates,
                   s_dwTotalBoxes / s_dwTotalUpdates,
-                  s_dwNonUnitRegions, s_dwTotalUpdates);
+                  s_dwNonUnitRegions, s_dwTotalUpdates,
+                  s_dwBoxesIn, s_dwBoxesBlitted);
 #endif                          /* XWIN_UPDATESTATS */
 
     /*
@@ -463,30 +725,73 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
     if (!pScreenInfo->fMultiWindow &&
         (pScreenInfo->dwClipUpdatesNBoxes == 0 ||
          dwBox < pScreenInfo->dwClipUpdatesNBoxes)) {
-        /* Loop through all boxes in the damaged region */
-        while (dwBox--) {
-            /*
-             * Calculate x offset, y offset, width, and height for
-             * current damage box
-             */
-            x = pBox->x1;
-            y = pBox->y1;
-            w = pBox->x2 - pBox->x1;
-            h = pBox->y2 - pBox->y1;
+        BoxRec boxMerged[WIN_GDI_COALESCE_MAX_BLTS];
+        int iBltBoxes;
+
+        /* Merge neighbouring boxes so tiny damage rects share a blit */
+        iBltBoxes = winCoalesceDamageBoxes(pBox, dwBox, boxMerged);
+
+#ifdef XWIN_UPDATESTATS
+        s_dwBoxesIn += dwBox;
+        s_dwBoxesBlitted += (iBltBoxes < 0) ? 1 : iBltBoxes;
+#endif
+
+        if (iBltBoxes >= 0) {
+            int i;
+
+            /* Loop through the coalesced boxes */
+            for (i = 0; i < iBltBoxes; ++i) {
+                /*
+                 * Calculate x offset, y offset, width, and height for
+                 * current damage box
+                 */
+                x = boxMerged[i].x1;
+                y = boxMerged[i].y1;
+                w = boxMerged[i].x2 - boxMerged[i].x1;
+                h = boxMerged[i].y2 - boxMerged[i].y1;
+
+                BitBlt(pScreenPriv->hdcScreen,
+                       x, y, w, h, pScreenPriv->hdcShadow, x, y, SRCCOPY);
+            }
+        }
+        else {
+            /* Too many boxes after merging; one extents-clipped blit */
+            hrgnCombined =
+                CreateRectRgn(pBoxExtents->x1, pBoxExtents->y1,
+                              pBoxExtents->x2, pBoxExtents->y2);
+            SelectClipRgn(pScreenPriv->hdcScreen, hrgnCombined);
+            DeleteObject(hrgnCombined);
+            hrgnCombined = NULL;
 
             BitBlt(pScreenPriv->hdcScreen,
-                   x, y, w, h, pScreenPriv->hdcShadow, x, y, SRCCOPY);
+                   pBoxExtents->x1, pBoxExtents->y1,
+                   pBoxExtents->x2 - pBoxExtents->x1,
+                   pBoxExtents->y2 - pBoxExtents->y1,
+                   pScreenPriv->hdcShadow,
+                   pBoxExtents->x1, pBoxExtents->y1, SRCCOPY);
 
-            /* Get a pointer to the next box */
-            ++pBox;
+            SelectClipRgn(pScreenPriv->hdcScreen, NULL);
         }
     }
     else if (!pScreenInfo->fMultiWindow) {
+        HRGN hrgnTemp;
+        UINT i;
 
-        /* Compute a GDI region from the damaged region */
+        /*
+         * Compute a GDI region from the damaged region.  The region is
+         * built from the individual damage boxes, not the extents:
+         * dragging a window across a monitor boundary damages two
+         * far-apart areas, and an extents-based region would recopy
+         * every untouched pixel between them on both heads.
+         */
         hrgnCombined =
-            CreateRectRgn(pBoxExtents->x1, pBoxExtents->y1, pBoxExtents->x2,
-                          pBoxExtents->y2);
+            CreateRectRgn(pBox->x1, pBox->y1, pBox->x2, pBox->y2);
+        for (i = 1; i < dwBox; ++i) {
+            hrgnTemp = CreateRectRgn(pBox[i].x1, pBox[i].y1,
+                                     pBox[i].x2, pBox[i].y2);
+            CombineRgn(hrgnCombined, hrgnCombined, hrgnTemp, RGN_OR);
+            DeleteObject(hrgnTemp);
+        }
 
         /* Install the GDI region as a clipping region */
         SelectClipRgn(pScreenPriv->hdcScreen, hrgnCombined);
@@ -509,10 +814,27 @@ winShadowUpdateGDI(ScreenPtr pScreen, shadowBufPtr pBuf)
     }
 
     /* Redraw all multiwindow windows */
-    if (pScreenInfo->fMultiWindow)
+    if (pScreenInfo->fMultiWindow) {
+        winDamageBoxesRec dmgBoxes;
+        BoxRec boxMerged[WIN_GDI_COALESCE_MAX_BLTS];
+        int iBltBoxes;
+
+        /* Merge neighbouring boxes so tiny damage rects share a blit */
+        iBltBoxes = winCoalesceDamageBoxes(pBox, dwBox, boxMerged);
+        if (iBltBoxes >= 0) {
+            dmgBoxes.pBox = boxMerged;
+            dmgBoxes.iBoxes = iBltBoxes;
+        }
+        else {
+            /* Too many boxes after merging; invalidate the extents */
+            dmgBoxes.pBox = pBoxExtents;
+            dmgBoxes.iBoxes = 1;
+        }
+
         EnumThreadWindows(g_dwCurrentThreadID,
                           winRedrawDamagedWindowShadowGDI,
-                          (LPARAM) pBoxExtents);
+                          (LPARAM) &dmgBoxes);
+    }
 }
 
 static Bool
@@ -573,6 +895,12 @@ winCloseScreenShadowGDI(ScreenPtr pScreen)
     /* Delete the window property */
     RemoveProp(pScreenPriv->hwndScreen, WIN_SCR_PROP);
 
+    /* Stop the per-monitor update workers, if we started any */
+    if (pScreenPriv->pParallelShadow != NULL) {
+        winParallelShadowFini(pScreenPriv->pParallelShadow);
+        pScreenPriv->pParallelShadow = NULL;
+    }
+
     /* Free the shadow DC; which allows the bitmap to be freed */
     DeleteDC(pScreenPriv->hdcShadow);
 
@@ -720,6 +1048,90 @@ winAdjustVideoModeShadowGDI(ScreenPtr pScreen)
     return TRUE;
 }
 
+/*
+ * Scale one colour channel of an X pixel value to 8 bits using the
+ * screen's channel mask
+ */
+
+static BYTE
+winScaleChannelShadowGDI(DWORD dwPixel, DWORD dwMask)
+{
+    if (dwMask == 0)
+        return 0;
+
+    /* Shift both down until the mask starts at bit zero */
+    while (!(dwMask & 1)) {
+        dwMask >>= 1;
+        dwPixel >>= 1;
+    }
+
+    return (BYTE) (((dwPixel & dwMask) * 255) / dwMask);
+}
+
+/*
+ * Repaint an exposed area with a plain PatBlt when it shows nothing
+ * but the root window's solid-colour background.  Dragging a native
+ * window across our window generates a storm of such exposures, and
+ * a pattern fill is cheaper than copying the area back out of the
+ * system-memory shadow DIB.  Returns FALSE when the area needs the
+ * full shadow blit.
+ */
+
+static Bool
+winBltExposedRootBackgroundShadowGDI(ScreenPtr pScreen,
+                                     HDC hdcUpdate, RECT * prcPaint)
+{
+    winScreenPriv(pScreen);
+    WindowPtr pRoot = pScreen->root;
+    WindowPtr pChild;
+    BoxRec box;
+    HBRUSH hbrush;
+    HBRUSH hbrushOld;
+
+    /* Only for a root with a solid-colour background, and only in
+       TrueColor modes where a pixel translates directly to a COLORREF */
+    if (pRoot == NULL
+        || pRoot->backgroundState != BackgroundPixel
+        || pScreenPriv->pScreenInfo->dwBPP <= 8)
+        return FALSE;
+
+    box.x1 = prcPaint->left;
+    box.y1 = prcPaint->top;
+    box.x2 = prcPaint->right;
+    box.y2 = prcPaint->bottom;
+
+    /* If any viewable top-level window overlaps the area, its contents
+       are in the shadow buffer and we need the full blit */
+    for (pChild = pRoot->firstChild; pChild != NULL; pChild = pChild->nextSib) {
+        if (!pChild->viewable)
+            continue;
+        if (RegionContainsRect(&pChild->borderSize, &box) != rgnOUT)
+            return FALSE;
+    }
+
+    hbrush = CreateSolidBrush(RGB(winScaleChannelShadowGDI
+                                  (pRoot->background.pixel,
+                                   pScreenPriv->dwRedMask),
+                                  winScaleChannelShadowGDI
+                                  (pRoot->background.pixel,
+                                   pScreenPriv->dwGreenMask),
+                                  winScaleChannelShadowGDI
+                                  (pRoot->background.pixel,
+                                   pScreenPriv->dwBlueMask)));
+    if (hbrush == NULL)
+        return FALSE;
+
+    hbrushOld = SelectObject(hdcUpdate, hbrush);
+    PatBlt(hdcUpdate,
+           prcPaint->left, prcPaint->top,
+           prcPaint->right - prcPaint->left,
+           prcPaint->bottom - prcPaint->top, PATCOPY);
+    SelectObject(hdcUpdate, hbrushOld);
+    DeleteObject(hbrush);
+
+    return TRUE;
+}
+
 /*
  * Blt exposed regions to the screen
  */
@@ -750,29 +1162,51 @@ winBltExposedRegionsShadowGDI(ScreenPtr pScreen)
         RealizePalette(hdcUpdate);
     }
 
-    /* Try to copy from the shadow buffer to the invalidated region */
-    if (!BitBlt(hdcUpdate,
-                ps.rcPaint.left, ps.rcPaint.top,
-                ps.rcPaint.right - ps.rcPaint.left,
-                ps.rcPaint.bottom - ps.rcPaint.top,
-                pScreenPriv->hdcShadow,
-                ps.rcPaint.left,
-                ps.rcPaint.top,
-                SRCCOPY)) {
-        LPVOID lpMsgBuf;
-
-        /* Display an error message */
-        FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER |
-                      FORMAT_MESSAGE_FROM_SYSTEM |
-                      FORMAT_MESSAGE_IGNORE_INSERTS,
-                      NULL,
-                      GetLastError(),
-                      MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
-                      (LPTSTR) &lpMsgBuf, 0, NULL);
-
-        ErrorF("winBltExposedRegionsShadowGDI - BitBlt failed: %s\n",
-               (LPSTR) lpMsgBuf);
-        LocalFree(lpMsgBuf);
+    /* Bare solid root background?  A pattern fill beats copying the
+       area back out of the shadow DIB */
+    if (!winBltExposedRootBackgroundShadowGDI(pScreen, hdcUpdate,
+                                              &ps.rcPaint)) {
+        if (pScreenInfo->dwScale != WIN_DEFAULT_SCALE) {
+            /*
+             * Stretch the whole logical screen; the BeginPaint clip
+             * region constrains the work to the invalidated area.
+             */
+            SetStretchBltMode(hdcUpdate, HALFTONE);
+            SetBrushOrgEx(hdcUpdate, 0, 0, NULL);
+            StretchBlt(hdcUpdate,
+                       0, 0,
+                       winScaleToDeviceCeil(pScreenInfo,
+                                            (int) pScreenInfo->dwWidth),
+                       winScaleToDeviceCeil(pScreenInfo,
+                                            (int) pScreenInfo->dwHeight),
+                       pScreenPriv->hdcShadow,
+                       0, 0,
+                       pScreenInfo->dwWidth, pScreenInfo->dwHeight, SRCCOPY);
+        }
+        /* Try to copy from the shadow buffer to the invalidated region */
+        else if (!BitBlt(hdcUpdate,
+                    ps.rcPaint.left, ps.rcPaint.top,
+                    ps.rcPaint.right - ps.rcPaint.left,
+                    ps.rcPaint.bottom - ps.rcPaint.top,
+                    pScreenPriv->hdcShadow,
+                    ps.rcPaint.left,
+                    ps.rcPaint.top,
+                    SRCCOPY)) {
+            LPVOID lpMsgBuf;
+
+            /* Display an error message */
+            FormatMessage(FORMAT_MESSAGE_ALLOCATE_BUFFER |
+                          FORMAT_MESSAGE_FROM_SYSTEM |
+                          FORMAT_MESSAGE_IGNORE_INSERTS,
+                          NULL,
+                          GetLastError(),
+                          MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT),
+                          (LPTSTR) &lpMsgBuf, 0, NULL);
+
+            ErrorF("winBltExposedRegionsShadowGDI - BitBlt failed: %s\n",
+                   (LPSTR) lpMsgBuf);
+            LocalFree(lpMsgBuf);
+        }
     }
 
     /* EndPaint frees the DC */
@@ -951,6 +1385,36 @@ winActivateAppShadowGDI(ScreenPtr pScreen)
     return TRUE;
 }
 
+/*
+ * Blit the whole shadow framebuffer to the screen, stretching to
+ * device pixels when -scaling is active.
+ */
+
+static void
+winBltWholeShadowGDI(winPrivScreenPtr pScreenPriv)
+{
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+
+    if (pScreenInfo->dwScale != WIN_DEFAULT_SCALE) {
+        SetStretchBltMode(pScreenPriv->hdcScreen, HALFTONE);
+        SetBrushOrgEx(pScreenPriv->hdcScreen, 0, 0, NULL);
+        StretchBlt(pScreenPriv->hdcScreen,
+                   0, 0,
+                   winScaleToDeviceCeil(pScreenInfo,
+                                        (int) pScreenInfo->dwWidth),
+                   winScaleToDeviceCeil(pScreenInfo,
+                                        (int) pScreenInfo->dwHeight),
+                   pScreenPriv->hdcShadow,
+                   0, 0,
+                   pScreenInfo->dwWidth, pScreenInfo->dwHeight, SRCCOPY);
+    }
+    else
+        BitBlt(pScreenPriv->hdcScreen,
+               0, 0,
+               pScreenInfo->dwWidth, pScreenInfo->dwHeight,
+               pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
+}
+
 /*
  * Reblit the shadow framebuffer to the screen.
  */
@@ -962,10 +1426,7 @@ winRedrawScreenShadowGDI(ScreenPtr pScreen)
     winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
 
     /* Redraw the whole window, to take account for the new colors */
-    BitBlt(pScreenPriv->hdcScreen,
-           0, 0,
-           pScreenInfo->dwWidth, pScreenInfo->dwHeight,
-           pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
+    winBltWholeShadowGDI(pScreenPriv);
 
     /* Redraw all windows */
     if (pScreenInfo->fMultiWindow)
@@ -1052,10 +1513,7 @@ winInstallColormapShadowGDI(ColormapPtr pColormap)
     }
 
     /* Redraw the whole window, to take account for the new colors */
-    BitBlt(pScreenPriv->hdcScreen,
-           0, 0,
-           pScreenInfo->dwWidth, pScreenInfo->dwHeight,
-           pScreenPriv->hdcShadow, 0, 0, SRCCOPY);
+    winBltWholeShadowGDI(pScreenPriv);
 
     /* Save a pointer to the newly installed colormap */
     pScreenPriv->pcmapInstalled = pColormap;
@@ -1093,28 +1551,24 @@ winStoreColorsShadowGDI(ColormapPtr pColormap, int ndef, xColorItem * pdefs)
         return TRUE;
     }
 
-    /* Try to install the newly modified colormap */
-    if (!winInstallColormapShadowGDI(pColormap)) {
-        ErrorF("winInstallColormapShadowGDI - winInstallColormapShadowGDI "
-               "failed\n");
-        return FALSE;
-    }
-
-#if 0
-    /* Tell Windows that the palette has changed */
+    /*
+     * The colormap is already installed, so the palette is already
+     * selected into the screen DC; reinstalling it from scratch would
+     * retranslate all 256 DIB entries and redraw every window for each
+     * StoreColors batch.  Realize the changed entries and update just
+     * the modified range of the DIB color table instead.
+     */
     RealizePalette(pScreenPriv->hdcScreen);
 
-    /* Set the DIB color table */
     if (SetDIBColorTable(pScreenPriv->hdcShadow,
                          pdefs[0].pixel,
                          ndef, pCmapPriv->rgbColors + pdefs[0].pixel) == 0) {
-        ErrorF("winInstallColormapShadowGDI - SetDIBColorTable () failed\n");
+        ErrorF("winStoreColorsShadowGDI - SetDIBColorTable () failed\n");
         return FALSE;
     }
 
-    /* Save a pointer to the newly installed colormap */
-    pScreenPriv->pcmapInstalled = pColormap;
-#endif
+    /* One blit to show the recolored contents */
+    winBltWholeShadowGDI(pScreenPriv);
 
     return TRUE;
 }
@@ -1220,6 +1674,202 @@ winDestroyColormapShadowGDI(ColormapPtr pColormap)
     return TRUE;
 }
 
+/*
+ * CreatePixmap - allocate large screen-format pixmaps as DIB sections
+ *
+ * The shadow framebuffer is already a DIB section, so when an offscreen
+ * pixmap is one too, CopyArea from the pixmap to a window can be a
+ * single GDI DIB-to-DIB BitBlt (see winCopyAreaShadowGDI) instead of an
+ * fbBlt into the shadow followed by the shadow update blit.  Small
+ * pixmaps stay in malloc memory; a DIB section costs a kernel object
+ * and section mapping, which only pays off once the copies are big.
+ */
+
+#define WIN_DIB_PIXMAP_BYTES	(128 * 1024)
+
+PixmapPtr
+winCreatePixmapShadowGDI(ScreenPtr pScreen, int width, int height, int depth,
+                         unsigned usage_hint)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    int bpp = BitsPerPixel(depth);
+
+    /*
+     * Only ordinary client pixmaps in the screen pixel format are
+     * eligible; anything with a usage hint (backing pixmaps, scratch
+     * headers) may be reheaded onto storage we do not own.
+     */
+    if (usage_hint == 0
+        && width > 0 && height > 0
+        && bpp == pScreenInfo->dwBPP
+        && ((size_t) PixmapBytePad(width, depth)) * height
+           >= WIN_DIB_PIXMAP_BYTES) {
+        PixmapPtr pPixmap;
+
+        pPixmap = winCreatePixmapMultiwindow(pScreen, width, height, depth,
+                                             usage_hint);
+        if (pPixmap) {
+            if (winGetPixmapPriv(pPixmap)->hBitmap)
+                return pPixmap;
+
+            /* DIB creation failed; fall through to a malloc pixmap */
+            winDestroyPixmapMultiwindow(pPixmap);
+        }
+    }
+
+    return (*pScreenPriv->CreatePixmap) (pScreen, width, height, depth,
+                                         usage_hint);
+}
+
+/*
+ * DestroyPixmap - route DIB-backed pixmaps to the DIB destructor
+ */
+
+Bool
+winDestroyPixmapShadowGDI(PixmapPtr pPixmap)
+{
+    ScreenPtr pScreen;
+
+    if (pPixmap == NULL)
+        return TRUE;
+
+    if (winGetPixmapPriv(pPixmap)->owned)
+        return winDestroyPixmapMultiwindow(pPixmap);
+
+    pScreen = pPixmap->drawable.pScreen;
+    {
+        winScreenPriv(pScreen);
+
+        return (*pScreenPriv->DestroyPixmap) (pPixmap);
+    }
+}
+
+/*
+ * CopyArea - blit DIB-backed pixmaps to the screen with GDI
+ *
+ * fb's GC ops with CopyArea replaced; cloned from whatever ops the
+ * wrapped CreateGC installed, the first time a GC is created.  The
+ * damage layer wraps on top of these during ValidateGC, so damage is
+ * recorded before we are called and the shadow update picks the
+ * region up as usual.
+ */
+
+static GCOps winGCOpsShadowGDI;
+static const GCOps *winWrappedGCOps = NULL;
+
+static RegionPtr
+winCopyAreaShadowGDI(DrawablePtr pSrcDrawable, DrawablePtr pDstDrawable,
+                     GCPtr pGC, int srcx, int srcy,
+                     int width, int height, int dstx, int dsty)
+{
+    ScreenPtr pScreen = pDstDrawable->pScreen;
+
+    winScreenPriv(pScreen);
+    winPrivPixmapPtr pPixmapPriv;
+    HDC hdcSrc;
+    HGDIOBJ hbmpOrig;
+    RegionRec rgnDst;
+    BoxRec boxDst;
+    BoxPtr pBox;
+    int nBox;
+    int iDstX = pDstDrawable->x + dstx;
+    int iDstY = pDstDrawable->y + dsty;
+
+    /*
+     * Take the GDI path only for a plain full-plane copy from an
+     * in-bounds region of a DIB-backed pixmap to a window drawn into
+     * the screen pixmap (i.e. the shadow DIB); everything else goes
+     * down to fb.
+     */
+    if (pSrcDrawable->type != DRAWABLE_PIXMAP
+        || pDstDrawable->type != DRAWABLE_WINDOW
+        || pGC->alu != GXcopy
+        || (pGC->planemask & FbFullMask(pDstDrawable->depth)) !=
+           FbFullMask(pDstDrawable->depth)
+        || pSrcDrawable->depth != pDstDrawable->depth
+        || width <= 0 || height <= 0
+        || srcx < 0 || srcy < 0
+        || srcx + width > pSrcDrawable->width
+        || srcy + height > pSrcDrawable->height
+        || (*pScreen->GetWindowPixmap) ((WindowPtr) pDstDrawable) !=
+           (PixmapPtr) pScreen->devPrivate)
+        return (*winWrappedGCOps->CopyArea) (pSrcDrawable, pDstDrawable, pGC,
+                                             srcx, srcy, width, height,
+                                             dstx, dsty);
+
+    pPixmapPriv = winGetPixmapPriv((PixmapPtr) pSrcDrawable);
+    if (!pPixmapPriv->owned || !pPixmapPriv->hBitmap)
+        return (*winWrappedGCOps->CopyArea) (pSrcDrawable, pDstDrawable, pGC,
+                                             srcx, srcy, width, height,
+                                             dstx, dsty);
+
+    hdcSrc = CreateCompatibleDC(pScreenPriv->hdcShadow);
+    if (hdcSrc == NULL)
+        return (*winWrappedGCOps->CopyArea) (pSrcDrawable, pDstDrawable, pGC,
+                                             srcx, srcy, width, height,
+                                             dstx, dsty);
+    hbmpOrig = SelectObject(hdcSrc, pPixmapPriv->hBitmap);
+
+    /* Clip the destination rectangle against the composite clip */
+    boxDst.x1 = iDstX;
+    boxDst.y1 = iDstY;
+    boxDst.x2 = iDstX + width;
+    boxDst.y2 = iDstY + height;
+    RegionInit(&rgnDst, &boxDst, 1);
+    RegionIntersect(&rgnDst, &rgnDst, pGC->pCompositeClip);
+
+    pBox = RegionRects(&rgnDst);
+    nBox = RegionNumRects(&rgnDst);
+    while (nBox--) {
+        BitBlt(pScreenPriv->hdcShadow,
+               pBox->x1, pBox->y1,
+               pBox->x2 - pBox->x1, pBox->y2 - pBox->y1,
+               hdcSrc, srcx + (pBox->x1 - iDstX), srcy + (pBox->y1 - iDstY),
+               SRCCOPY);
+        ++pBox;
+    }
+
+    RegionUninit(&rgnDst);
+
+    SelectObject(hdcSrc, hbmpOrig);
+    DeleteDC(hdcSrc);
+
+    /* Make the blits visible to fb before anyone reads the shadow */
+    GdiFlush();
+
+    /* Source was entirely in bounds, so there are no graphics exposures */
+    return NULL;
+}
+
+/*
+ * CreateGC - install the GDI CopyArea in newly created GCs
+ */
+
+Bool
+winCreateGCShadowGDI(GCPtr pGC)
+{
+    ScreenPtr pScreen = pGC->pScreen;
+
+    winScreenPriv(pScreen);
+    Bool fResult;
+
+    fResult = (*pScreenPriv->CreateGC) (pGC);
+    if (!fResult)
+        return fResult;
+
+    if (winWrappedGCOps == NULL) {
+        winGCOpsShadowGDI = *pGC->ops;
+        winGCOpsShadowGDI.CopyArea = winCopyAreaShadowGDI;
+        winWrappedGCOps = pGC->ops;
+    }
+
+    if (pGC->ops == winWrappedGCOps)
+        pGC->ops = &winGCOpsShadowGDI;
+
+    return fResult;
+}
+
 /*
  * Set engine specific functions
  */
@@ -0,0 +1,296 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+#include "winmonitors.h"
+
+/*
+ * Per-monitor parallel shadow updates for -multiplemonitors spanning
+ * screens.
+ *
+ * With one spanning screen over several physical monitors the shadow
+ * blit is serialized over the total pixel count, so update cost grows
+ * with the desktop size rather than with the damage on any one head.
+ * When -parallelupdates is enabled each physical monitor gets its own
+ * worker thread; the damage region is partitioned by monitor rectangle
+ * and each worker pushes its share of the scanlines to the screen with
+ * SetDIBitsToDevice from its own device context.  GDI device contexts
+ * are per-thread, and SetDIBitsToDevice reads straight from the shadow
+ * framebuffer bits, so no GDI object is shared between workers.
+ */
+
+typedef struct _winParallelWorker {
+    struct _winParallelShadow *pShadow;
+    pthread_t ptWorker;
+
+    /* Monitor rectangle in screen coordinates */
+    BoxRec boxMonitor;
+
+    /* Damage assigned for the current pass, owned by the worker while
+       a pass is running */
+    RegionRec rgnWork;
+    Bool fHasWork;
+} winParallelWorker;
+
+typedef struct _winParallelShadow {
+    ScreenPtr pScreen;
+    int iWorkers;
+    winParallelWorker *pWorkers;
+
+    /* Pass control */
+    pthread_mutex_t pmxPass;
+    pthread_cond_t pcndWork;
+    pthread_cond_t pcndDone;
+    unsigned uPassGeneration;
+    int iWorkersBusy;
+    Bool fShutdown;
+} winParallelShadow;
+
+/*
+ * Worker thread: wait for a pass, paint our monitor's share of the
+ * damage, signal completion.
+ */
+
+static void *
+winParallelWorkerProc(void *pArg)
+{
+    winParallelWorker *pWorker = (winParallelWorker *) pArg;
+    winParallelShadow *pShadow = pWorker->pShadow;
+    ScreenPtr pScreen = pShadow->pScreen;
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    HDC hdcScreen;
+    unsigned uGeneration = 0;
+
+    /* Device contexts are per-thread; grab our own for the screen window */
+    hdcScreen = GetDC(pScreenPriv->hwndScreen);
+    if (hdcScreen == NULL) {
+        ErrorF("winParallelWorkerProc - GetDC () failed\n");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pShadow->pmxPass);
+    for (;;) {
+        BoxPtr pBox;
+        int iBox;
+
+        while (!pShadow->fShutdown
+               && pShadow->uPassGeneration == uGeneration)
+            pthread_cond_wait(&pShadow->pcndWork, &pShadow->pmxPass);
+
+        if (pShadow->fShutdown)
+            break;
+
+        uGeneration = pShadow->uPassGeneration;
+        pthread_mutex_unlock(&pShadow->pmxPass);
+
+        if (pWorker->fHasWork) {
+            pBox = RegionRects(&pWorker->rgnWork);
+            iBox = RegionNumRects(&pWorker->rgnWork);
+
+            while (iBox--) {
+                SetDIBitsToDevice(hdcScreen,
+                                  pBox->x1, pBox->y1,
+                                  pBox->x2 - pBox->x1,
+                                  pBox->y2 - pBox->y1,
+                                  pBox->x1, pBox->y1,
+                                  pBox->y1, pBox->y2 - pBox->y1,
+                                  pScreenInfo->pfb
+                                  + pBox->y1 * pScreenInfo->dwPaddedWidth,
+                                  (BITMAPINFO *) pScreenPriv->pbmih,
+                                  DIB_RGB_COLORS);
+                ++pBox;
+            }
+            GdiFlush();
+        }
+
+        pthread_mutex_lock(&pShadow->pmxPass);
+        if (--pShadow->iWorkersBusy == 0)
+            pthread_cond_signal(&pShadow->pcndDone);
+    }
+    pthread_mutex_unlock(&pShadow->pmxPass);
+
+    ReleaseDC(pScreenPriv->hwndScreen, hdcScreen);
+
+    return NULL;
+}
+
+/*
+ * Create the per-monitor worker threads.  Returns NULL if there is
+ * nothing to parallelize (single monitor) or on failure; the caller
+ * falls back to the serial update path.
+ */
+
+winParallelShadowPtr
+winParallelShadowInit(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    winParallelShadow *pShadow;
+    struct GetMonitorInfoData data;
+    int iMonitors = 0;
+    int i;
+
+    /* Count the attached monitors */
+    while (QueryMonitor(iMonitors + 1, &data))
+        ++iMonitors;
+
+    if (iMonitors < 2) {
+        winDebug("winParallelShadowInit - %d monitor(s), "
+                 "not parallelizing\n", iMonitors);
+        return NULL;
+    }
+
+    pShadow = calloc(1, sizeof(winParallelShadow));
+    if (pShadow == NULL)
+        return NULL;
+
+    pShadow->pScreen = pScreen;
+    pShadow->iWorkers = iMonitors;
+    pShadow->pWorkers = calloc(iMonitors, sizeof(winParallelWorker));
+    if (pShadow->pWorkers == NULL) {
+        free(pShadow);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pShadow->pmxPass, NULL);
+    pthread_cond_init(&pShadow->pcndWork, NULL);
+    pthread_cond_init(&pShadow->pcndDone, NULL);
+
+    for (i = 0; i < iMonitors; ++i) {
+        winParallelWorker *pWorker = &pShadow->pWorkers[i];
+
+        QueryMonitor(i + 1, &data);
+
+        pWorker->pShadow = pShadow;
+
+        /* Monitor rect relative to the spanning screen origin */
+        pWorker->boxMonitor.x1 =
+            data.monitorOffsetX - GetSystemMetrics(SM_XVIRTUALSCREEN);
+        pWorker->boxMonitor.y1 =
+            data.monitorOffsetY - GetSystemMetrics(SM_YVIRTUALSCREEN);
+        pWorker->boxMonitor.x2 = pWorker->boxMonitor.x1 + data.monitorWidth;
+        pWorker->boxMonitor.y2 = pWorker->boxMonitor.y1 + data.monitorHeight;
+
+        RegionNull(&pWorker->rgnWork);
+
+        if (pthread_create(&pWorker->ptWorker, NULL,
+                           winParallelWorkerProc, pWorker)) {
+            ErrorF("winParallelShadowInit - pthread_create failed "
+                   "for monitor %d\n", i + 1);
+            pShadow->iWorkers = i;
+            winParallelShadowFini(pShadow);
+            return NULL;
+        }
+
+        winDebug("winParallelShadowInit - monitor %d worker covers "
+                 "(%d, %d)-(%d, %d)\n", i + 1,
+                 pWorker->boxMonitor.x1, pWorker->boxMonitor.y1,
+                 pWorker->boxMonitor.x2, pWorker->boxMonitor.y2);
+    }
+
+    winDebug("winParallelShadowInit - %d update threads for screen %d\n",
+             iMonitors, (int) pScreenInfo->dwScreen);
+
+    return pShadow;
+}
+
+/*
+ * Partition the damage by monitor and run one update pass.  Returns
+ * FALSE if the damage lies entirely on one monitor, in which case the
+ * caller should use the serial path and avoid the hand-off cost.
+ */
+
+Bool
+winParallelShadowUpdate(winParallelShadowPtr pShadow, RegionPtr prgnDamage)
+{
+    int i;
+    int iMonitorsHit = 0;
+
+    /* Split the damage between the monitor rectangles */
+    for (i = 0; i < pShadow->iWorkers; ++i) {
+        winParallelWorker *pWorker = &pShadow->pWorkers[i];
+        RegionRec rgnMonitor;
+
+        RegionInit(&rgnMonitor, &pWorker->boxMonitor, 1);
+        RegionIntersect(&pWorker->rgnWork, prgnDamage, &rgnMonitor);
+        RegionUninit(&rgnMonitor);
+
+        pWorker->fHasWork = RegionNotEmpty(&pWorker->rgnWork);
+        if (pWorker->fHasWork)
+            ++iMonitorsHit;
+    }
+
+    /* Not worth waking the pool for damage confined to one head */
+    if (iMonitorsHit < 2)
+        return FALSE;
+
+    /* Kick off the pass and wait for all workers to finish */
+    pthread_mutex_lock(&pShadow->pmxPass);
+    pShadow->iWorkersBusy = pShadow->iWorkers;
+    ++pShadow->uPassGeneration;
+    pthread_cond_broadcast(&pShadow->pcndWork);
+    while (pShadow->iWorkersBusy != 0)
+        pthread_cond_wait(&pShadow->pcndDone, &pShadow->pmxPass);
+    pthread_mutex_unlock(&pShadow->pmxPass);
+
+    return TRUE;
+}
+
+/*
+ * Shut down the worker threads and free the pass state
+ */
+
+void
+winParallelShadowFini(winParallelShadowPtr pShadow)
+{
+    int i;
+
+    if (pShadow == NULL)
+        return;
+
+    pthread_mutex_lock(&pShadow->pmxPass);
+    pShadow->fShutdown = TRUE;
+    pthread_cond_broadcast(&pShadow->pcndWork);
+    pthread_mutex_unlock(&pShadow->pmxPass);
+
+    for (i = 0; i < pShadow->iWorkers; ++i) {
+        pthread_join(pShadow->pWorkers[i].ptWorker, NULL);
+        RegionUninit(&pShadow->pWorkers[i].rgnWork);
+    }
+
+    pthread_mutex_destroy(&pShadow->pmxPass);
+    pthread_cond_destroy(&pShadow->pcndWork);
+    pthread_cond_destroy(&pShadow->pcndDone);
+
+    free(pShadow->pWorkers);
+    free(pShadow);
+}
@@ -27,6 +27,23 @@
 #include "winwindow.h"
 
 #include <shobjidl.h>
+#include <dwmapi.h>
+
+#ifndef DWMWA_FORCE_ICONIC_REPRESENTATION
+#define DWMWA_FORCE_ICONIC_REPRESENTATION 7
+#endif
+#ifndef DWMWA_HAS_ICONIC_BITMAP
+#define DWMWA_HAS_ICONIC_BITMAP 10
+#endif
+
+/*
+  Ask DWM for its cached preview to be refreshed at most every half
+   second, and only once at least a sixteenth of the window area has
+   been repainted; a busy CAD viewport would otherwise invalidate on
+   every frame
+*/
+#define WIN_PREVIEW_INTERVAL_MS 500
+#define WIN_PREVIEW_DAMAGE_SHIFT 4
 
 /*
   This is unnecessarily heavyweight, we could just call CoInitialize() once at
@@ -63,3 +80,174 @@ void winShowWindowOnTaskbar(HWND hWnd, Bool show)
       CoUninitialize();
     }
 }
+
+/*
+  Tell DWM we will supply the taskbar thumbnail and Aero Peek bitmaps
+   for this window ourselves, so hovering the taskbar never makes DWM
+   repaint the window at full resolution to build a preview
+*/
+
+void winEnableIconicPreviews(HWND hWnd)
+{
+  BOOL fEnable = TRUE;
+
+  if (FAILED(DwmSetWindowAttribute(hWnd, DWMWA_HAS_ICONIC_BITMAP,
+                                   &fEnable, sizeof(fEnable))))
+    return;
+
+  DwmSetWindowAttribute(hWnd, DWMWA_FORCE_ICONIC_REPRESENTATION,
+                        &fEnable, sizeof(fEnable));
+}
+
+/*
+  Render a scaled-down copy of the window's current contents into a
+   top-down 32bpp DIB, which is the only format DWM accepts.  The
+   source is the window's composite backing pixmap when it is
+   redirected, and its rectangle of the shadow framebuffer otherwise;
+   either way the bits are already rendered, so no client redraw is
+   triggered.  Returns NULL if the contents are not reachable.
+*/
+
+static HBITMAP
+winCreateWindowPreview(WindowPtr pWin, unsigned int uWidth,
+                       unsigned int uHeight)
+{
+  ScreenPtr pScreen = pWin->drawable.pScreen;
+  winScreenPriv(pScreen);
+  BITMAPINFO bmi;
+  HBITMAP hbmpPreview;
+  HBITMAP hbmpOldPreview;
+  HDC hdcPreview;
+  HDC hdcSource = NULL;
+  HDC hdcPixmap = NULL;
+  int iSrcX = 0, iSrcY = 0;
+  void *pvBits;
+  Bool fStretched;
+
+  /* Preserve the window's aspect ratio within the requested bounds */
+  if (uWidth * pWin->drawable.height > uHeight * pWin->drawable.width)
+    uWidth = max(1, uHeight * pWin->drawable.width / pWin->drawable.height);
+  else
+    uHeight = max(1, uWidth * pWin->drawable.height / pWin->drawable.width);
+
+  ZeroMemory(&bmi, sizeof(bmi));
+  bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+  bmi.bmiHeader.biWidth = uWidth;
+  bmi.bmiHeader.biHeight = -(LONG) uHeight;
+  bmi.bmiHeader.biPlanes = 1;
+  bmi.bmiHeader.biBitCount = 32;
+  bmi.bmiHeader.biCompression = BI_RGB;
+
+  hbmpPreview = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS,
+                                 &pvBits, NULL, 0);
+  if (hbmpPreview == NULL)
+    return NULL;
+
+#ifdef COMPOSITE
+  if (pWin->redirectDraw != RedirectDrawNone)
+    {
+      PixmapPtr pPixmap = (*pScreen->GetWindowPixmap) (pWin);
+      winPrivPixmapPtr pPixmapPriv = winGetPixmapPriv(pPixmap);
+
+      if (pPixmapPriv->hBitmap != NULL)
+        {
+          hdcPixmap = CreateCompatibleDC(pScreenPriv->hdcScreen);
+          SelectObject(hdcPixmap, pPixmapPriv->hBitmap);
+          hdcSource = hdcPixmap;
+          iSrcX = pWin->borderWidth;
+          iSrcY = pWin->borderWidth;
+        }
+    }
+  else
+#endif
+    {
+      hdcSource = pScreenPriv->hdcShadow;
+      iSrcX = pWin->drawable.x;
+      iSrcY = pWin->drawable.y;
+    }
+
+  if (hdcSource == NULL)
+    {
+      DeleteObject(hbmpPreview);
+      return NULL;
+    }
+
+  hdcPreview = CreateCompatibleDC(pScreenPriv->hdcScreen);
+  hbmpOldPreview = SelectObject(hdcPreview, hbmpPreview);
+
+  /* HALFTONE box-filters the shrink */
+  SetStretchBltMode(hdcPreview, HALFTONE);
+  SetBrushOrgEx(hdcPreview, 0, 0, NULL);
+  fStretched = StretchBlt(hdcPreview, 0, 0, uWidth, uHeight,
+                          hdcSource, iSrcX, iSrcY,
+                          pWin->drawable.width, pWin->drawable.height,
+                          SRCCOPY);
+
+  SelectObject(hdcPreview, hbmpOldPreview);
+  DeleteDC(hdcPreview);
+  if (hdcPixmap != NULL)
+    DeleteDC(hdcPixmap);
+
+  if (!fStretched)
+    {
+      DeleteObject(hbmpPreview);
+      return NULL;
+    }
+
+  return hbmpPreview;
+}
+
+/*
+  Answer WM_DWMSENDICONICTHUMBNAIL or WM_DWMSENDICONICLIVEPREVIEWBITMAP
+   with a preview built from the already-rendered window contents
+*/
+
+Bool winSendIconicPreview(WindowPtr pWin, HWND hWnd,
+                          unsigned int uMaxWidth, unsigned int uMaxHeight,
+                          Bool fLivePreview)
+{
+  HBITMAP hbmpPreview;
+  HRESULT hr;
+
+  if (pWin == NULL || uMaxWidth == 0 || uMaxHeight == 0
+      || pWin->drawable.width == 0 || pWin->drawable.height == 0)
+    return FALSE;
+
+  hbmpPreview = winCreateWindowPreview(pWin, uMaxWidth, uMaxHeight);
+  if (hbmpPreview == NULL)
+    return FALSE;
+
+  if (fLivePreview)
+    hr = DwmSetIconicLivePreviewBitmap(hWnd, hbmpPreview, NULL, 0);
+  else
+    hr = DwmSetIconicThumbnail(hWnd, hbmpPreview, 0);
+
+  DeleteObject(hbmpPreview);
+
+  return SUCCEEDED(hr);
+}
+
+/*
+  Track how much of the window has been repainted and nudge DWM to
+   drop its cached preview once enough has changed; DWM then re-sends
+   WM_DWMSENDICONICTHUMBNAIL only while a preview is actually visible
+*/
+
+void winTaskbarPreviewDamage(WindowPtr pWin, HWND hWnd, DWORD dwArea)
+{
+  winWindowPriv(pWin);
+  DWORD dwWindowArea = (DWORD) pWin->drawable.width * pWin->drawable.height;
+  DWORD dwNow;
+
+  pWinPriv->dwPreviewDamage += dwArea;
+  if (pWinPriv->dwPreviewDamage < (dwWindowArea >> WIN_PREVIEW_DAMAGE_SHIFT))
+    return;
+
+  dwNow = GetTickCount();
+  if (dwNow - pWinPriv->dwPreviewTick < WIN_PREVIEW_INTERVAL_MS)
+    return;
+
+  pWinPriv->dwPreviewTick = dwNow;
+  pWinPriv->dwPreviewDamage = 0;
+  DwmInvalidateIconicBitmaps(hWnd);
+}
@@ -0,0 +1,258 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+
+#include <X11/extensions/XI2.h>
+#include "exevents.h"
+#include "xserver-properties.h"
+#include "inpututils.h"
+
+/*
+ * Multitouch input via WM_POINTER messages (Windows 8 and later).
+ *
+ * Without this path, touch contacts only reach X as the single
+ * emulated mouse Windows synthesizes from the primary contact.  Here
+ * each contact becomes an XI2.2 touch sequence on a dedicated
+ * XIDirectTouch slave device; handling the WM_POINTER message (and
+ * not passing it to DefWindowProc) also suppresses the mouse
+ * emulation for touch, so coordinates are not delivered twice.
+ *
+ * The pointer API does not exist before Windows 8 and this tree
+ * builds with WINVER 0x0500, so the entry points are resolved from
+ * user32 at run time and the few structures we consume are declared
+ * here when the SDK headers do not provide them.
+ */
+
+#ifndef POINTER_FLAG_NONE
+
+typedef DWORD POINTER_INPUT_TYPE;
+typedef UINT32 POINTER_FLAGS;
+typedef UINT32 TOUCH_FLAGS;
+typedef UINT32 TOUCH_MASK;
+
+#define PT_TOUCH 2
+
+typedef struct tagPOINTER_INFO {
+    POINTER_INPUT_TYPE pointerType;
+    UINT32 pointerId;
+    UINT32 frameId;
+    POINTER_FLAGS pointerFlags;
+    HANDLE sourceDevice;
+    HWND hwndTarget;
+    POINT ptPixelLocation;
+    POINT ptHimetricLocation;
+    POINT ptPixelLocationRaw;
+    POINT ptHimetricLocationRaw;
+    DWORD dwTime;
+    UINT32 historyCount;
+    INT32 InputData;
+    DWORD dwKeyStates;
+    UINT64 PerformanceCount;
+    DWORD ButtonChangeType;
+} POINTER_INFO;
+
+typedef struct tagPOINTER_TOUCH_INFO {
+    POINTER_INFO pointerInfo;
+    TOUCH_FLAGS touchFlags;
+    TOUCH_MASK touchMask;
+    RECT rcContact;
+    RECT rcContactRaw;
+    UINT32 orientation;
+    UINT32 pressure;
+} POINTER_TOUCH_INFO;
+
+#endif                          /* POINTER_FLAG_NONE */
+
+#define WIN_TOUCH_MAX_CONTACTS	20
+#define WIN_TOUCH_AXIS_MAX	65535
+
+DeviceIntPtr g_pwinTouch = NULL;
+
+typedef BOOL (WINAPI * GETPOINTERTOUCHINFOPROC) (UINT32 pointerId,
+                                                 POINTER_TOUCH_INFO *
+                                                 touchInfo);
+
+static GETPOINTERTOUCHINFOPROC g_pfnGetPointerTouchInfo = NULL;
+
+static ValuatorMask *g_pTouchMask = NULL;
+
+/*
+ * Touch device DeviceProc: two absolute axes scaled onto the screen,
+ * direct touch with room for every contact the pointer API reports.
+ */
+
+static int
+winTouchProc(DeviceIntPtr pDeviceInt, int iState)
+{
+    DevicePtr pDevice = (DevicePtr) pDeviceInt;
+    Atom axes_labels[2];
+    Atom btn_labels[1] = { 0 };
+    BYTE map[2] = { 0 };
+
+    switch (iState) {
+    case DEVICE_INIT:
+        axes_labels[0] = XIGetKnownProperty(AXIS_LABEL_PROP_ABS_MT_POSITION_X);
+        axes_labels[1] = XIGetKnownProperty(AXIS_LABEL_PROP_ABS_MT_POSITION_Y);
+
+        if (!InitValuatorClassDeviceStruct(pDeviceInt, 2, axes_labels,
+                                           GetMotionHistorySize(), Absolute))
+            return BadValue;
+
+        if (!InitButtonClassDeviceStruct(pDeviceInt, 1, btn_labels, map))
+            return BadValue;
+
+        if (!InitTouchClassDeviceStruct(pDeviceInt, WIN_TOUCH_MAX_CONTACTS,
+                                        XIDirectTouch, 2))
+            return BadValue;
+
+        InitValuatorAxisStruct(pDeviceInt, 0, axes_labels[0],
+                               0, WIN_TOUCH_AXIS_MAX, 10000, 0, 10000,
+                               Absolute);
+        InitValuatorAxisStruct(pDeviceInt, 1, axes_labels[1],
+                               0, WIN_TOUCH_AXIS_MAX, 10000, 0, 10000,
+                               Absolute);
+        break;
+
+    case DEVICE_ON:
+        pDevice->on = TRUE;
+        break;
+
+    case DEVICE_CLOSE:
+    case DEVICE_OFF:
+        pDevice->on = FALSE;
+        break;
+    }
+
+    return Success;
+}
+
+/*
+ * Resolve the Windows pointer API and create the touch device.
+ * Quietly does nothing before Windows 8.
+ */
+
+Bool
+winTouchInit(void)
+{
+    HMODULE hmodUser32 = GetModuleHandle("user32.dll");
+
+    if (hmodUser32 != NULL)
+        g_pfnGetPointerTouchInfo = (GETPOINTERTOUCHINFOPROC)
+            GetProcAddress(hmodUser32, "GetPointerTouchInfo");
+
+    if (g_pfnGetPointerTouchInfo == NULL) {
+        winDebug("winTouchInit - no pointer API, multitouch disabled\n");
+        return FALSE;
+    }
+
+    g_pTouchMask = valuator_mask_new(2);
+    if (g_pTouchMask == NULL)
+        return FALSE;
+
+    g_pwinTouch = AddInputDevice(serverClient, winTouchProc, TRUE);
+    if (g_pwinTouch == NULL) {
+        ErrorF("winTouchInit - AddInputDevice failed\n");
+        return FALSE;
+    }
+    g_pwinTouch->name = strdup("Windows touch");
+
+    winDebug("winTouchInit - multitouch device created\n");
+    return TRUE;
+}
+
+/*
+ * Translate one WM_POINTER message into an XI2.2 touch event.
+ * Returns TRUE when the message carried a touch contact and has been
+ * consumed; pen and mouse pointers are left for the caller to pass on
+ * so their emulated messages still arrive.
+ */
+
+Bool
+winTouchProcessPointerMessage(HWND hwnd, UINT message, WPARAM wParam,
+                              LPARAM lParam, winScreenInfoPtr pScreenInfo)
+{
+    POINTER_TOUCH_INFO pti;
+    POINT point;
+    uint16_t uiEventType;
+    int iX, iY;
+
+    if (g_pwinTouch == NULL || g_pfnGetPointerTouchInfo == NULL)
+        return FALSE;
+
+    if (!g_pfnGetPointerTouchInfo(LOWORD(wParam), &pti))
+        return FALSE;
+
+    if (pti.pointerInfo.pointerType != PT_TOUCH)
+        return FALSE;
+
+    switch (message) {
+    case WM_POINTERDOWN:
+        uiEventType = XI_TouchBegin;
+        break;
+    case WM_POINTERUPDATE:
+        uiEventType = XI_TouchUpdate;
+        break;
+    case WM_POINTERUP:
+        uiEventType = XI_TouchEnd;
+        break;
+    default:
+        return FALSE;
+    }
+
+    /* The pointer info carries Windows screen coordinates; map them
+       through the client area like the mouse path does */
+    point = pti.pointerInfo.ptPixelLocation;
+    ScreenToClient(hwnd, &point);
+    iX = winScaleToLogical(pScreenInfo, point.x - pScreenInfo->dwXOffset);
+    iY = winScaleToLogical(pScreenInfo, point.y - pScreenInfo->dwYOffset);
+
+    if (iX < 0)
+        iX = 0;
+    else if (iX >= (int) pScreenInfo->dwWidth)
+        iX = pScreenInfo->dwWidth - 1;
+    if (iY < 0)
+        iY = 0;
+    else if (iY >= (int) pScreenInfo->dwHeight)
+        iY = pScreenInfo->dwHeight - 1;
+
+    valuator_mask_set(g_pTouchMask, 0,
+                      iX * WIN_TOUCH_AXIS_MAX
+                      / ((int) pScreenInfo->dwWidth - 1));
+    valuator_mask_set(g_pTouchMask, 1,
+                      iY * WIN_TOUCH_AXIS_MAX
+                      / ((int) pScreenInfo->dwHeight - 1));
+
+    QueueTouchEvents(g_pwinTouch, uiEventType,
+                     pti.pointerInfo.pointerId, 0, g_pTouchMask);
+
+    return TRUE;
+}
@@ -0,0 +1,197 @@
+/*
+ *Copyright (C) 2003-2004 Harold L Hunt II All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL HAROLD L HUNT II BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of Harold L Hunt II
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from Harold L Hunt II.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+
+#include "win.h"
+#include "xserver-trace.h"
+
+#include <evntprov.h>
+
+/*
+ * ETW provider for the input-to-present pipeline.
+ *
+ * Events are emitted through the pipeline trace hooks (see
+ * include/xserver-trace.h) plus direct calls from the shadow update
+ * routines, so a WPA trace shows request dispatch, input enqueue,
+ * damage accumulation and shadow presentation alongside DWM and the
+ * GPU scheduler.  Enabled with the -etwtrace command line flag; even
+ * then events are only written while a trace session has actually
+ * enabled the provider GUID below, e.g.:
+ *
+ *   wpr -start GeneralProfile
+ *   xperf -start vcxsrv -on 7a8f2d43-5b91-4e0c-9c6e-1d24a3f0b8d1
+ *
+ * All event payloads are arrays of UINT32 fields, in the order given by
+ * the comments on the event ids; keep any consumer-side manifest in
+ * step with those.
+ */
+
+/* VcXsrv pipeline provider: 7a8f2d43-5b91-4e0c-9c6e-1d24a3f0b8d1 */
+static const GUID g_guidEtwProvider = { 0x7a8f2d43, 0x5b91, 0x4e0c,
+    {0x9c, 0x6e, 0x1d, 0x24, 0xa3, 0xf0, 0xb8, 0xd1}
+};
+
+static REGHANDLE g_hEtwProvider = 0;
+
+/* Keywords, one bit per pipeline stage so sessions can filter */
+#define WIN_ETW_KW_REQUEST      0x1
+#define WIN_ETW_KW_INPUT        0x2
+#define WIN_ETW_KW_DAMAGE       0x4
+#define WIN_ETW_KW_PRESENT      0x8
+
+/*
+ * Event descriptors.  Fields are id, version, channel, level, opcode,
+ * task, keyword; levels and opcodes are numeric to avoid dragging in
+ * evntrace.h (4 = informational, 5 = verbose, opcodes 1/2 = start/stop).
+ */
+
+/* RequestBegin: client index, major opcode */
+static const EVENT_DESCRIPTOR g_edRequestBegin =
+    { 1, 0, 0, 5, 1, 0, WIN_ETW_KW_REQUEST };
+
+/* RequestEnd: client index, major opcode, result */
+static const EVENT_DESCRIPTOR g_edRequestEnd =
+    { 2, 0, 0, 5, 2, 0, WIN_ETW_KW_REQUEST };
+
+/* EventEnqueue: device id, internal event type */
+static const EVENT_DESCRIPTOR g_edEventEnqueue =
+    { 3, 0, 0, 4, 0, 0, WIN_ETW_KW_INPUT };
+
+/* DamageAppend: screen number, extents x1, y1, x2, y2 */
+static const EVENT_DESCRIPTOR g_edDamageAppend =
+    { 4, 0, 0, 4, 0, 0, WIN_ETW_KW_DAMAGE };
+
+/* ShadowPresent: engine, box count, extents x1, y1, x2, y2 */
+static const EVENT_DESCRIPTOR g_edShadowPresent =
+    { 5, 0, 0, 4, 0, 0, WIN_ETW_KW_PRESENT };
+
+static void
+winEtwWrite(const EVENT_DESCRIPTOR * pDesc, const UINT32 * pData,
+            unsigned int count)
+{
+    EVENT_DATA_DESCRIPTOR dd[6];
+    unsigned int i;
+
+    /* Cheap in-process mask test; no syscall unless a session listens */
+    if (!EventProviderEnabled(g_hEtwProvider, pDesc->Level, pDesc->Keyword))
+        return;
+
+    for (i = 0; i < count; i++)
+        EventDataDescCreate(&dd[i], &pData[i], sizeof(UINT32));
+    EventWrite(g_hEtwProvider, pDesc, count, dd);
+}
+
+static void
+winTraceRequestBegin(ClientPtr client, int majorOp)
+{
+    UINT32 data[2] = { client->index, majorOp };
+
+    winEtwWrite(&g_edRequestBegin, data, 2);
+}
+
+static void
+winTraceRequestEnd(ClientPtr client, int majorOp, int result)
+{
+    UINT32 data[3] = { client->index, majorOp, result };
+
+    winEtwWrite(&g_edRequestEnd, data, 3);
+}
+
+static void
+winTraceEventEnqueue(DeviceIntPtr device, int eventType)
+{
+    UINT32 data[2] = { device->id, eventType };
+
+    winEtwWrite(&g_edEventEnqueue, data, 2);
+}
+
+static void
+winTraceDamageAppend(ScreenPtr pScreen, BoxPtr pExtents)
+{
+    UINT32 data[5] = { pScreen->myNum,
+        pExtents->x1, pExtents->y1, pExtents->x2, pExtents->y2
+    };
+
+    winEtwWrite(&g_edDamageAppend, data, 5);
+}
+
+static XserverTraceHooks winTraceHooks = {
+    winTraceRequestBegin,
+    winTraceRequestEnd,
+    winTraceEventEnqueue,
+    winTraceDamageAppend,
+};
+
+/*
+ * Called by the shadow update routines when a batch of damage is pushed
+ * to the display; engine is one of the WIN_TRACE_PRESENT_* values.
+ */
+void
+winTraceShadowPresent(int engine, int nBoxes, BoxPtr pExtents)
+{
+    UINT32 data[6];
+
+    if (!g_hEtwProvider)
+        return;
+
+    data[0] = engine;
+    data[1] = nBoxes;
+    data[2] = pExtents->x1;
+    data[3] = pExtents->y1;
+    data[4] = pExtents->x2;
+    data[5] = pExtents->y2;
+    winEtwWrite(&g_edShadowPresent, data, 6);
+}
+
+/*
+ * Register the ETW provider and install the pipeline trace hooks.
+ * Does nothing unless -etwtrace was given.
+ */
+Bool
+winTraceInit(void)
+{
+    ULONG ulError;
+
+    if (!g_fEtwTrace)
+        return TRUE;
+
+    ulError = EventRegister(&g_guidEtwProvider, NULL, NULL, &g_hEtwProvider);
+    if (ulError != ERROR_SUCCESS) {
+        ErrorF("winTraceInit - EventRegister failed: %d\n", (int) ulError);
+        g_hEtwProvider = 0;
+        return FALSE;
+    }
+
+    xserverTraceHooks = &winTraceHooks;
+
+    winDebug("winTraceInit - ETW pipeline provider registered\n");
+    return TRUE;
+}
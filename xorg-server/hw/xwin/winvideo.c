@@ -0,0 +1,534 @@
+/*
+ *Copyright (C) 1994-2000 The XFree86 Project, Inc. All Rights Reserved.
+ *
+ *Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ *"Software"), to deal in the Software without restriction, including
+ *without limitation the rights to use, copy, modify, merge, publish,
+ *distribute, sublicense, and/or sell copies of the Software, and to
+ *permit persons to whom the Software is furnished to do so, subject to
+ *the following conditions:
+ *
+ *The above copyright notice and this permission notice shall be
+ *included in all copies or substantial portions of the Software.
+ *
+ *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *NONINFRINGEMENT. IN NO EVENT SHALL THE XFREE86 PROJECT BE LIABLE FOR
+ *ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF
+ *CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *Except as contained in this notice, the name of the XFree86 Project
+ *shall not be used in advertising or otherwise to promote the sale, use
+ *or other dealings in this Software without prior written authorization
+ *from the XFree86 Project.
+ */
+
+#ifdef HAVE_XWIN_CONFIG_H
+#include <xwin-config.h>
+#endif
+#include "win.h"
+
+#include <X11/extensions/Xv.h>
+#include "xvdix.h"
+#include "fourcc.h"
+#include "resource.h"
+#include "damage.h"
+
+/*
+ * Software Xv adaptor for the XWin screens.
+ *
+ * Video players that find an Xv port hand us their decoded YUV frames
+ * (usually through XvShmPutImage, so straight out of shared memory
+ * with no transport copy) and we convert and scale them in a single
+ * pass directly into the shadow framebuffer, clipped by the GC's
+ * composite clip.  The shadow damage machinery then presents only the
+ * touched rectangles through whichever engine is active.  Without a
+ * port, players fall back to converting every frame themselves and
+ * pushing it through XPutImage, which costs an extra full-frame
+ * convert, a transport copy and an fbPutImage blit.
+ */
+
+#define WIN_XV_NPORTS		16
+#define WIN_XV_MAX_WIDTH	4096
+#define WIN_XV_MAX_HEIGHT	4096
+
+static const XvImageRec g_winVideoImages[] = {
+    XVIMAGE_YUY2,
+    XVIMAGE_YV12,
+    XVIMAGE_I420,
+    XVIMAGE_UYVY
+};
+
+#define WIN_XV_NIMAGES	(sizeof(g_winVideoImages) / sizeof(g_winVideoImages[0]))
+
+/*
+ * BT.601 integer conversion of one video sample to a 32-bit pixel.
+ */
+
+static CARD32
+winVideoYUVToPixel(int iY, int iU, int iV)
+{
+    int iC = iY - 16;
+    int iD = iU - 128;
+    int iE = iV - 128;
+    int iR = (298 * iC + 409 * iE + 128) >> 8;
+    int iG = (298 * iC - 100 * iD - 208 * iE + 128) >> 8;
+    int iB = (298 * iC + 516 * iD + 128) >> 8;
+
+    if (iR < 0)
+        iR = 0;
+    else if (iR > 255)
+        iR = 255;
+    if (iG < 0)
+        iG = 0;
+    else if (iG > 255)
+        iG = 255;
+    if (iB < 0)
+        iB = 0;
+    else if (iB > 255)
+        iB = 255;
+
+    return ((CARD32) iR << 16) | ((CARD32) iG << 8) | (CARD32) iB;
+}
+
+/*
+ * Convert and scale one destination row from planar YUV (YV12/I420).
+ * The source x position walks in 16.16 fixed point so scaling costs
+ * one add per pixel; chroma is at half resolution in both directions.
+ */
+
+static void
+winVideoBlitRowPlanar(CARD32 * pDst, int iWidth,
+                      const CARD8 *pY, const CARD8 *pU, const CARD8 *pV,
+                      CARD32 dwSrcX, CARD32 dwStepX)
+{
+    while (iWidth--) {
+        int iSrcX = dwSrcX >> 16;
+
+        *pDst++ = winVideoYUVToPixel(pY[iSrcX],
+                                     pU[iSrcX >> 1], pV[iSrcX >> 1]);
+        dwSrcX += dwStepX;
+    }
+}
+
+/*
+ * Convert and scale one destination row from packed YUV (YUY2/UYVY).
+ * Each four-byte group holds two pixels sharing one chroma sample.
+ */
+
+static void
+winVideoBlitRowPacked(CARD32 * pDst, int iWidth,
+                      const CARD8 *pRow, CARD32 dwSrcX, CARD32 dwStepX,
+                      Bool fUYVY)
+{
+    while (iWidth--) {
+        int iSrcX = dwSrcX >> 16;
+        const CARD8 *pPair = pRow + ((iSrcX & ~1) << 1);
+
+        if (fUYVY)
+            *pDst++ = winVideoYUVToPixel(pPair[1 + ((iSrcX & 1) << 1)],
+                                         pPair[0], pPair[2]);
+        else
+            *pDst++ = winVideoYUVToPixel(pPair[(iSrcX & 1) << 1],
+                                         pPair[1], pPair[3]);
+        dwSrcX += dwStepX;
+    }
+}
+
+/*
+ * Report the buffer layout for an image of the given size: pitches
+ * are padded to four bytes and planar sizes to even dimensions, the
+ * same layout every other software Xv adaptor advertises.
+ */
+
+static int
+winVideoQueryImageAttributes(XvPortPtr pPort, XvImagePtr pImage,
+                             CARD16 *pWidth, CARD16 *pHeight,
+                             int *pPitches, int *pOffsets)
+{
+    int iSize, iTmp;
+
+    if (*pWidth > WIN_XV_MAX_WIDTH)
+        *pWidth = WIN_XV_MAX_WIDTH;
+    if (*pHeight > WIN_XV_MAX_HEIGHT)
+        *pHeight = WIN_XV_MAX_HEIGHT;
+
+    if (pOffsets)
+        pOffsets[0] = 0;
+
+    switch (pImage->id) {
+    case FOURCC_YV12:
+    case FOURCC_I420:
+        *pWidth = (*pWidth + 1) & ~1;
+        *pHeight = (*pHeight + 1) & ~1;
+        iSize = (*pWidth + 3) & ~3;
+        if (pPitches)
+            pPitches[0] = iSize;
+        iSize *= *pHeight;
+        if (pOffsets)
+            pOffsets[1] = iSize;
+        iTmp = ((*pWidth >> 1) + 3) & ~3;
+        if (pPitches)
+            pPitches[1] = pPitches[2] = iTmp;
+        iTmp *= (*pHeight >> 1);
+        iSize += iTmp;
+        if (pOffsets)
+            pOffsets[2] = iSize;
+        iSize += iTmp;
+        break;
+
+    case FOURCC_YUY2:
+    case FOURCC_UYVY:
+    default:
+        iSize = *pWidth << 1;
+        if (pPitches)
+            pPitches[0] = iSize;
+        iSize *= *pHeight;
+        break;
+    }
+
+    return iSize;
+}
+
+/*
+ * Convert, scale and clip one frame into the drawable.  This writes
+ * straight into the framebuffer bits, so the touched region is pushed
+ * through the damage machinery afterwards for the shadow update.
+ */
+
+static int
+winVideoPutImage(DrawablePtr pDraw, XvPortPtr pPort, GCPtr pGC,
+                 INT16 src_x, INT16 src_y, CARD16 src_w, CARD16 src_h,
+                 INT16 drw_x, INT16 drw_y, CARD16 drw_w, CARD16 drw_h,
+                 XvImagePtr pImage, unsigned char *pBuf, Bool fSync,
+                 CARD16 width, CARD16 height)
+{
+    CARD16 wAligned = width, hAligned = height;
+    int aiPitches[3], aiOffsets[3];
+    FbBits *pDstBits;
+    FbStride iDstStride;
+    int iDstBpp, iDstXoff, iDstYoff;
+    int iDstPitch;
+    CARD8 *pDstBase;
+    RegionRec rgnDst;
+    BoxRec boxDst;
+    BoxPtr pBox;
+    int iBox;
+    CARD32 dwStepX, dwStepY;
+    int iVidX, iVidY;
+
+    if (pDraw->bitsPerPixel != 32)
+        return BadMatch;
+
+    if (src_x < 0 || src_y < 0 ||
+        src_x + src_w > width || src_y + src_h > height)
+        return BadValue;
+
+    winVideoQueryImageAttributes(pPort, pImage, &wAligned, &hAligned,
+                                 aiPitches, aiOffsets);
+
+    /* Destination rectangle in screen space, clipped by the GC */
+    iVidX = pDraw->x + drw_x;
+    iVidY = pDraw->y + drw_y;
+    boxDst.x1 = iVidX;
+    boxDst.y1 = iVidY;
+    boxDst.x2 = iVidX + drw_w;
+    boxDst.y2 = iVidY + drw_h;
+    RegionInit(&rgnDst, &boxDst, 1);
+    RegionIntersect(&rgnDst, &rgnDst, pGC->pCompositeClip);
+    if (RegionNil(&rgnDst)) {
+        RegionUninit(&rgnDst);
+        return Success;
+    }
+
+    fbGetDrawable(pDraw, pDstBits, iDstStride, iDstBpp, iDstXoff, iDstYoff);
+    pDstBase = (CARD8 *) pDstBits;
+    iDstPitch = iDstStride * sizeof(FbBits);
+
+    /* Source position per destination pixel, 16.16 fixed point */
+    dwStepX = ((CARD32) src_w << 16) / drw_w;
+    dwStepY = ((CARD32) src_h << 16) / drw_h;
+
+    pBox = RegionRects(&rgnDst);
+    iBox = RegionNumRects(&rgnDst);
+    while (iBox--) {
+        int iY;
+
+        for (iY = pBox->y1; iY < pBox->y2; ++iY) {
+            CARD32 dwSrcY = ((CARD32) src_y << 16)
+                + (CARD32) (iY - iVidY) * dwStepY;
+            int iSrcY = dwSrcY >> 16;
+            CARD32 dwSrcX = ((CARD32) src_x << 16)
+                + (CARD32) (pBox->x1 - iVidX) * dwStepX;
+            CARD32 *pDst = (CARD32 *) (pDstBase
+                                       + (iY + iDstYoff) * iDstPitch)
+                + pBox->x1 + iDstXoff;
+            int iWidth = pBox->x2 - pBox->x1;
+
+            switch (pImage->id) {
+            case FOURCC_YV12:
+            case FOURCC_I420:
+            {
+                /* YV12 stores the V plane before the U plane */
+                int iU = (pImage->id == FOURCC_YV12) ? 2 : 1;
+                int iV = (pImage->id == FOURCC_YV12) ? 1 : 2;
+
+                winVideoBlitRowPlanar(pDst, iWidth,
+                                      pBuf + aiOffsets[0]
+                                      + iSrcY * aiPitches[0],
+                                      pBuf + aiOffsets[iU]
+                                      + (iSrcY >> 1) * aiPitches[1],
+                                      pBuf + aiOffsets[iV]
+                                      + (iSrcY >> 1) * aiPitches[2],
+                                      dwSrcX, dwStepX);
+                break;
+            }
+
+            case FOURCC_YUY2:
+            case FOURCC_UYVY:
+                winVideoBlitRowPacked(pDst, iWidth,
+                                      pBuf + iSrcY * aiPitches[0],
+                                      dwSrcX, dwStepX,
+                                      pImage->id == FOURCC_UYVY);
+                break;
+            }
+        }
+        ++pBox;
+    }
+
+    DamageDamageRegion(pDraw, &rgnDst);
+    RegionUninit(&rgnDst);
+
+    return Success;
+}
+
+/*
+ * The adaptor only does XvPutImage; the overlay-style entry points
+ * are never reached because the advertised type lacks XvVideoMask,
+ * but the DIX expects the hooks to exist.
+ */
+
+static int
+winVideoPutVideo(DrawablePtr pDraw, XvPortPtr pPort, GCPtr pGC,
+                 INT16 vid_x, INT16 vid_y, CARD16 vid_w, CARD16 vid_h,
+                 INT16 drw_x, INT16 drw_y, CARD16 drw_w, CARD16 drw_h)
+{
+    return BadMatch;
+}
+
+static int
+winVideoPutStill(DrawablePtr pDraw, XvPortPtr pPort, GCPtr pGC,
+                 INT16 vid_x, INT16 vid_y, CARD16 vid_w, CARD16 vid_h,
+                 INT16 drw_x, INT16 drw_y, CARD16 drw_w, CARD16 drw_h)
+{
+    return BadMatch;
+}
+
+static int
+winVideoGetVideo(DrawablePtr pDraw, XvPortPtr pPort, GCPtr pGC,
+                 INT16 vid_x, INT16 vid_y, CARD16 vid_w, CARD16 vid_h,
+                 INT16 drw_x, INT16 drw_y, CARD16 drw_w, CARD16 drw_h)
+{
+    return BadMatch;
+}
+
+static int
+winVideoGetStill(DrawablePtr pDraw, XvPortPtr pPort, GCPtr pGC,
+                 INT16 vid_x, INT16 vid_y, CARD16 vid_w, CARD16 vid_h,
+                 INT16 drw_x, INT16 drw_y, CARD16 drw_w, CARD16 drw_h)
+{
+    return BadMatch;
+}
+
+static int
+winVideoStopVideo(XvPortPtr pPort, DrawablePtr pDraw)
+{
+    return Success;
+}
+
+static int
+winVideoSetPortAttribute(XvPortPtr pPort, Atom attribute, INT32 value)
+{
+    return BadMatch;
+}
+
+static int
+winVideoGetPortAttribute(XvPortPtr pPort, Atom attribute, INT32 *pValue)
+{
+    return BadMatch;
+}
+
+static int
+winVideoQueryBestSize(XvPortPtr pPort, CARD8 motion,
+                      CARD16 vid_w, CARD16 vid_h,
+                      CARD16 drw_w, CARD16 drw_h,
+                      unsigned int *pWidth, unsigned int *pHeight)
+{
+    /* The software scaler handles any size */
+    *pWidth = drw_w;
+    *pHeight = drw_h;
+    return Success;
+}
+
+/*
+ * Free the adaptor on screen close; the DIX XvCloseScreen, wrapped
+ * beneath us, frees the screen record itself.
+ */
+
+static Bool
+winVideoCloseScreen(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    XvScreenPtr pxvs = (XvScreenPtr) dixLookupPrivate(&pScreen->devPrivates,
+                                                      XvGetScreenKey());
+    int i;
+
+    pScreen->CloseScreen = pScreenPriv->pwinXvCloseScreen;
+
+    for (i = 0; i < pxvs->nAdaptors; ++i)
+        XvFreeAdaptor(&pxvs->pAdaptors[i]);
+    free(pxvs->pAdaptors);
+    pxvs->pAdaptors = NULL;
+    pxvs->nAdaptors = 0;
+
+    return (*pScreen->CloseScreen) (pScreen);
+}
+
+/*
+ * Register the software Xv adaptor for a screen.
+ */
+
+Bool
+winInitVideo(ScreenPtr pScreen)
+{
+    winScreenPriv(pScreen);
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    XvScreenPtr pxvs;
+    XvAdaptorPtr pAdaptor;
+    XvEncodingPtr pEncoding;
+    XvFormatPtr pFormats;
+    XvImagePtr pImages;
+    XvPortPtr pPorts, pPort;
+    VisualPtr pVisual;
+    int iVisual, nFormats, iPort, nPorts;
+
+    /* The converters only target 32-bit framebuffer layouts */
+    if (pScreenInfo->dwBPP != 32) {
+        winDebug("winInitVideo - %d bpp framebuffer, no Xv adaptor\n",
+                 (int) pScreenInfo->dwBPP);
+        return TRUE;
+    }
+
+    if (XvScreenInit(pScreen) != Success) {
+        ErrorF("winInitVideo - XvScreenInit failed\n");
+        return FALSE;
+    }
+    pxvs = (XvScreenPtr) dixLookupPrivate(&pScreen->devPrivates,
+                                          XvGetScreenKey());
+
+    pAdaptor = calloc(1, sizeof(XvAdaptorRec));
+    pEncoding = calloc(1, sizeof(XvEncodingRec));
+    pFormats = calloc(pScreen->numVisuals, sizeof(XvFormatRec));
+    pImages = malloc(sizeof(g_winVideoImages));
+    pPorts = calloc(WIN_XV_NPORTS, sizeof(XvPortRec));
+    if (!pAdaptor || !pEncoding || !pFormats || !pImages || !pPorts)
+        goto bail;
+
+    pEncoding->id = 0;
+    pEncoding->pScreen = pScreen;
+    pEncoding->name = strdup("XV_IMAGE");
+    pEncoding->width = WIN_XV_MAX_WIDTH;
+    pEncoding->height = WIN_XV_MAX_HEIGHT;
+    pEncoding->rate.numerator = 1;
+    pEncoding->rate.denominator = 1;
+    if (!pEncoding->name)
+        goto bail;
+
+    /* Accept every visual at the root depth */
+    nFormats = 0;
+    pVisual = pScreen->visuals;
+    for (iVisual = 0; iVisual < pScreen->numVisuals; ++iVisual, ++pVisual) {
+        if (pVisual->nplanes != pScreen->rootDepth)
+            continue;
+        pFormats[nFormats].depth = pScreen->rootDepth;
+        pFormats[nFormats].visual = pVisual->vid;
+        ++nFormats;
+    }
+    if (!nFormats)
+        goto bail;
+
+    memcpy(pImages, g_winVideoImages, sizeof(g_winVideoImages));
+
+    pAdaptor->name = strdup("XWin Software Video");
+    if (!pAdaptor->name)
+        goto bail;
+
+    /* After this point the ports are registered resources, so any
+       failure hands everything to the adaptor record instead of
+       freeing it */
+    nPorts = 0;
+    for (iPort = 0, pPort = pPorts; iPort < WIN_XV_NPORTS; ++iPort) {
+        pPort->id = FakeClientID(0);
+        if (pPort->id == 0)
+            continue;
+        if (!AddResource(pPort->id, XvGetRTPort(), pPort))
+            continue;
+        pPort->pAdaptor = pAdaptor;
+        pPort->time = currentTime;
+        ++pPort;
+        ++nPorts;
+    }
+    pAdaptor->type = XvInputMask | XvImageMask;
+    pAdaptor->pScreen = pScreen;
+    pAdaptor->nEncodings = 1;
+    pAdaptor->pEncodings = pEncoding;
+    pAdaptor->nFormats = nFormats;
+    pAdaptor->pFormats = pFormats;
+    pAdaptor->nImages = WIN_XV_NIMAGES;
+    pAdaptor->pImages = pImages;
+    pAdaptor->nPorts = nPorts;
+    pAdaptor->pPorts = pPorts;
+    pAdaptor->base_id = pPorts->id;
+    pAdaptor->ddPutVideo = winVideoPutVideo;
+    pAdaptor->ddPutStill = winVideoPutStill;
+    pAdaptor->ddGetVideo = winVideoGetVideo;
+    pAdaptor->ddGetStill = winVideoGetStill;
+    pAdaptor->ddStopVideo = winVideoStopVideo;
+    pAdaptor->ddSetPortAttribute = winVideoSetPortAttribute;
+    pAdaptor->ddGetPortAttribute = winVideoGetPortAttribute;
+    pAdaptor->ddQueryBestSize = winVideoQueryBestSize;
+    pAdaptor->ddPutImage = winVideoPutImage;
+    pAdaptor->ddQueryImageAttributes = winVideoQueryImageAttributes;
+
+    if (!nPorts) {
+        ErrorF("winInitVideo - no ports could be registered\n");
+        XvFreeAdaptor(pAdaptor);
+        free(pAdaptor);
+        return FALSE;
+    }
+
+    pxvs->nAdaptors = 1;
+    pxvs->pAdaptors = pAdaptor;
+
+    pScreenPriv->pwinXvCloseScreen = pScreen->CloseScreen;
+    pScreen->CloseScreen = winVideoCloseScreen;
+
+    winDebug("winInitVideo - Xv adaptor registered, %d ports\n", nPorts);
+    return TRUE;
+
+ bail:
+    ErrorF("winInitVideo - out of memory, no Xv adaptor\n");
+    if (pEncoding)
+        free(pEncoding->name);
+    free(pEncoding);
+    free(pFormats);
+    free(pImages);
+    free(pPorts);
+    if (pAdaptor)
+        free(pAdaptor->name);
+    free(pAdaptor);
+    return FALSE;
+}
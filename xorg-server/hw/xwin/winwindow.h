@@ -51,6 +51,7 @@
 #define WINDOW_TITLE_XDMCP      PROJECT_NAME " Server - %s - Display %s:%s.%d"
 extern const char WIN_SCR_PROP[];
 #define WINDOW_CLASS_X          "vcxsrv/x X rl"
+#define WINDOW_CLASS_X_POPUP    "vcxsrv/x X popup"
 #define WINDOW_CLASS_X_MSG      "vcxsrv/x X msg"
 #define WINDOW_TITLE_X          PROJECT_NAME " X"
 extern const char WIN_WINDOW_PROP[];
@@ -60,6 +61,7 @@ extern const char WIN_WINDOW_PROP[];
 extern const char WIN_WID_PROP[];
 extern const char WIN_NEEDMANAGE_PROP[];
 extern const char WIN_STATE_PROP[];
+extern const char WIN_MAXIMIZE_PROP[];
 
 #define VCXSRV_SIGNATURE        0xdeaddeadL
 
@@ -77,6 +79,9 @@ typedef struct {
     winPrivScreenPtr pScreenPriv;
     Bool fXKilled;
     HDWP hDwp;
+    DWORD dwPreviewDamage;      /* area repainted since the last DWM
+                                   iconic bitmap invalidation */
+    DWORD dwPreviewTick;        /* tick count of that invalidation */
 #ifdef XWIN_GLX_WINDOWS
     Bool fWglUsed;
 #endif
@@ -168,4 +173,15 @@ void
 void
  winShowWindowOnTaskbar(HWND hWnd, Bool show);
 
+void
+ winEnableIconicPreviews(HWND hWnd);
+
+Bool
+ winSendIconicPreview(WindowPtr pWin, HWND hWnd,
+                      unsigned int uMaxWidth, unsigned int uMaxHeight,
+                      Bool fLivePreview);
+
+void
+ winTaskbarPreviewDamage(WindowPtr pWin, HWND hWnd, DWORD dwArea);
+
 #endif
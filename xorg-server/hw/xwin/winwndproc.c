@@ -139,6 +139,149 @@ static void gatherWindows(void)
   EnumDesktopWindows(NULL, enumWindowsProc, (LPARAM)processId);
 }
 
+/*
+ * Reconfigure the screen after the display mode has settled.
+ *
+ * Windows fires WM_DISPLAYCHANGE (and WM_DPICHANGED) in bursts while
+ * a monitor topology change settles - docking, undocking, or a mode
+ * switch can produce half a dozen messages in quick succession.
+ * winWindowProc coalesces such a burst with a timer and calls this
+ * once after quiescence, so we tear down and rebuild the drawing
+ * engine a single time.
+ */
+
+static void
+winProcessDisplayChange(HWND hwnd, winPrivScreenPtr pScreenPriv)
+{
+    winScreenInfo *pScreenInfo = pScreenPriv->pScreenInfo;
+    ScreenPtr pScreen = pScreenInfo->pScreen;
+
+    /*
+     * Check for a disruptive change in depth.
+     * We can only display a message for a disruptive depth change,
+     * we cannot do anything to correct the situation.
+     */
+    /*
+       XXX: maybe we need to check if GetSystemMetrics(SM_SAMEDISPLAYFORMAT)
+       has changed as well...
+     */
+    if (pScreenInfo->dwBPP !=
+        GetDeviceCaps(pScreenPriv->hdcScreen, BITSPIXEL)) {
+        if (pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL) {
+            /* Cannot display the visual until the depth is restored */
+            winDebug ("winProcessDisplayChange - Disruptive change in depth\n");
+
+            /* Display depth change dialog */
+            winDisplayDepthChangeDialog(pScreenPriv);
+
+            /* Flag that we have an invalid screen depth */
+            pScreenPriv->fBadDepth = TRUE;
+
+            /* Minimize the display window */
+            ShowWindow(hwnd, SW_MINIMIZE);
+        }
+        else {
+            /* For GDI, performance may suffer until original depth is restored */
+            ErrorF
+                ("winProcessDisplayChange - Performance may be non-optimal after change in depth\n");
+        }
+    }
+    else {
+        /* Flag that we have a valid screen depth */
+        pScreenPriv->fBadDepth = FALSE;
+    }
+
+    /*
+       If we could cheaply check if this WM_DISPLAYCHANGE change
+       affects the monitor(s) which this X screen is displayed on
+       then we should do so here.  For the moment, assume it does.
+       (this is probably usually the case so that might be an
+       overoptimization)
+     */
+    {
+        /*
+           In rootless modes which are monitor or virtual desktop size
+           use RandR to resize the X screen
+         */
+        if ((!pScreenInfo->fUserGaveHeightAndWidth) &&
+            (pScreenInfo->iResizeMode == resizeWithRandr) && (pScreenInfo->
+                                                              fRootless
+                                                              ||
+                                                              pScreenInfo->
+                                                              fMultiWindow
+            )) {
+            DWORD dwWidth = 0, dwHeight = 0;
+
+            if (pScreenInfo->fMultipleMonitors) {
+                /* resize to new virtual desktop size */
+                dwWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
+                dwHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
+            }
+            else {
+                /* resize to new size of specified monitor */
+                struct GetMonitorInfoData data;
+
+                if (QueryMonitor(pScreenInfo->iMonitor, &data)) {
+                        dwWidth = data.monitorWidth;
+                        dwHeight = data.monitorHeight;
+                        /*
+                           XXX: monitor may have changed position,
+                           so we might need to update xinerama data
+                         */
+                    }
+                    else {
+                        ErrorF("Monitor number %d no longer exists!\n",
+                               pScreenInfo->iMonitor);
+                    }
+            }
+
+            /*
+               XXX: probably a small bug here: we don't compute the work area
+               and allow for task bar
+
+               XXX: generally, we don't allow for the task bar being moved after
+               the server is started
+             */
+
+            /* Set screen size to match new size, if it is different to current */
+            if (((dwWidth != 0) && (dwHeight != 0)) &&
+                ((pScreenInfo->dwWidth != dwWidth) ||
+                 (pScreenInfo->dwHeight != dwHeight))) {
+                winDoRandRScreenSetSize(pScreen,
+                                        dwWidth,
+                                        dwHeight,
+                                        (dwWidth * 25.4) /
+                                        monitorResolution,
+                                        (dwHeight * 25.4) /
+                                        monitorResolution);
+            }
+        }
+        else {
+            /*
+             * We can simply recreate the same-sized primary surface when
+             * the display dimensions change.
+             */
+
+            winDebug
+                ("winProcessDisplayChange - Releasing and recreating primary surface\n");
+
+            /* Reallocate the framebuffer used by the drawing engine */
+            (*pScreenPriv->pwinFreeFB)(pScreen);
+            if (!(*pScreenPriv->pwinAllocateFB)(pScreen))
+            {
+                ErrorF ("winProcessDisplayChange - Could not reallocate framebuffer\n");
+            }
+            /* Update the screen pixmap to point to the new framebuffer */
+            winUpdateFBPointer(pScreen, pScreenPriv->pScreenInfo->pfb);
+            // Restore the ability to update screen, now with new dimensions
+            SetRootClip(pScreen, TRUE);
+
+            // and arrange for it to be repainted
+            miPaintWindow(pScreen->root, &pScreen->root->borderClip,  PW_BACKGROUND);
+        }
+    }
+}
+
 /*
  * Called by winWakeupHandler
  * Processes current Windows message
@@ -205,6 +348,10 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         s_uTaskbarRestart = RegisterWindowMessage(TEXT("TaskbarCreated"));
         SetProp(hwnd, WIN_SCR_PROP, s_pScreenPriv);
 
+        /* Register for raw mouse input, if requested */
+        if (g_fRawInput && !winMouseRawInputRegister(hwnd))
+            g_fRawInput = FALSE;
+
         /* Setup tray icon */
         if (!s_pScreenInfo->fNoTrayIcon && !pref.fNoTrayIcon) {
             /*
@@ -218,10 +365,17 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
 
             s_pScreenPriv->hwndScreen = hwnd;
 
-            winInitNotifyIcon(s_pScreenPriv,FALSE);
+            /* Registering with the shell can block for a while when
+               the taskbar is busy; get the window on screen first and
+               add the icon once the message pump is running */
+            PostMessage(hwnd, WM_INIT_TRAYICON, 0, 0);
         }
         return 0;
 
+    case WM_INIT_TRAYICON:
+        winInitNotifyIcon(s_pScreenPriv, FALSE);
+        return 0;
+
     case WM_DISPLAYCHANGE:
         /*
            WM_DISPLAYCHANGE seems to be sent when the monitor layout or
@@ -255,129 +409,27 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             break;
 
         /*
-         * Check for a disruptive change in depth.
-         * We can only display a message for a disruptive depth change,
-         * we cannot do anything to correct the situation.
+         * Topology changes arrive as a burst of WM_DISPLAYCHANGE
+         * messages while Windows settles the new layout; rebuilding
+         * the engine for each one multiplies the blackout.  Restart
+         * a quiescence timer instead and reconfigure once, from
+         * WM_TIMER, after the burst has died down.
          */
-        /*
-           XXX: maybe we need to check if GetSystemMetrics(SM_SAMEDISPLAYFORMAT)
-           has changed as well...
-         */
-        if (s_pScreenInfo->dwBPP !=
-            GetDeviceCaps(s_pScreenPriv->hdcScreen, BITSPIXEL)) {
-            if (s_pScreenInfo->dwEngine == WIN_SERVER_SHADOW_DDNL) {
-                /* Cannot display the visual until the depth is restored */
-                winDebug ("winWindowProc - Disruptive change in depth\n");
+        SetTimer(hwnd, WIN_DISPLAYCHANGE_TIMER_ID,
+                 WIN_DISPLAYCHANGE_DELAY, NULL);
 
-                /* Display depth change dialog */
-                winDisplayDepthChangeDialog(s_pScreenPriv);
+        break;
 
-                /* Flag that we have an invalid screen depth */
-                s_pScreenPriv->fBadDepth = TRUE;
+    case WM_DPICHANGED:
+        winDebug("winWindowProc - WM_DPICHANGED\n");
 
-                /* Minimize the display window */
-                ShowWindow(hwnd, SW_MINIMIZE);
-            }
-            else {
-                /* For GDI, performance may suffer until original depth is restored */
-                ErrorF
-                    ("winWindowProc - Performance may be non-optimal after change in depth\n");
-            }
-        }
-        else {
-            /* Flag that we have a valid screen depth */
-            s_pScreenPriv->fBadDepth = FALSE;
-        }
-
-        /*
-           If we could cheaply check if this WM_DISPLAYCHANGE change
-           affects the monitor(s) which this X screen is displayed on
-           then we should do so here.  For the moment, assume it does.
-           (this is probably usually the case so that might be an
-           overoptimization)
-         */
-        {
-            /*
-               In rootless modes which are monitor or virtual desktop size
-               use RandR to resize the X screen
-             */
-            if ((!s_pScreenInfo->fUserGaveHeightAndWidth) &&
-                (s_pScreenInfo->iResizeMode == resizeWithRandr) && (s_pScreenInfo->
-                                                                    fRootless
-                                                                    ||
-                                                                    s_pScreenInfo->
-                                                                    fMultiWindow
-                )) {
-                DWORD dwWidth = 0, dwHeight = 0;
-
-                if (s_pScreenInfo->fMultipleMonitors) {
-                    /* resize to new virtual desktop size */
-                    dwWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
-                    dwHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
-                }
-                else {
-                    /* resize to new size of specified monitor */
-                    struct GetMonitorInfoData data;
-
-                    if (QueryMonitor(s_pScreenInfo->iMonitor, &data)) {
-                            dwWidth = data.monitorWidth;
-                            dwHeight = data.monitorHeight;
-                            /*
-                               XXX: monitor may have changed position,
-                               so we might need to update xinerama data
-                             */
-                        }
-                        else {
-                            ErrorF("Monitor number %d no longer exists!\n",
-                                   s_pScreenInfo->iMonitor);
-                        }
-                }
-
-                /*
-                   XXX: probably a small bug here: we don't compute the work area
-                   and allow for task bar
-
-                   XXX: generally, we don't allow for the task bar being moved after
-                   the server is started
-                 */
+        if (s_pScreenInfo == NULL)
+            break;
 
-                /* Set screen size to match new size, if it is different to current */
-                if (((dwWidth != 0) && (dwHeight != 0)) &&
-                    ((s_pScreenInfo->dwWidth != dwWidth) ||
-                     (s_pScreenInfo->dwHeight != dwHeight))) {
-                    winDoRandRScreenSetSize(s_pScreen,
-                                            dwWidth,
-                                            dwHeight,
-                                            (dwWidth * 25.4) /
-                                            monitorResolution,
-                                            (dwHeight * 25.4) /
-                                            monitorResolution);
-                }
-            }
-            else {
-                /*
-                 * We can simply recreate the same-sized primary surface when
-                 * the display dimensions change.
-                 */
-
-                winDebug
-                    ("winWindowProc - WM_DISPLAYCHANGE - Releasing and recreating primary surface\n");
-
-                /* Reallocate the framebuffer used by the drawing engine */
-                (*s_pScreenPriv->pwinFreeFB)(s_pScreen);
-                if (!(*s_pScreenPriv->pwinAllocateFB)(s_pScreen))
-                {
-                    ErrorF ("winWindowProc - WM_DISPLAYCHANGE - Could not reallocate framebuffer\n");
-                }
-                /* Update the screen pixmap to point to the new framebuffer */
-                winUpdateFBPointer(s_pScreen, s_pScreenPriv->pScreenInfo->pfb);
-                // Restore the ability to update screen, now with new dimensions
-                SetRootClip(s_pScreen, TRUE);
-
-                // and arrange for it to be repainted
-                miPaintWindow(s_pScreen->root, &s_pScreen->root->borderClip,  PW_BACKGROUND);
-            }
-        }
+        /* A DPI change can resize the monitor's effective resolution;
+         * fold it into the same coalesced reconfiguration */
+        SetTimer(hwnd, WIN_DISPLAYCHANGE_TIMER_ID,
+                 WIN_DISPLAYCHANGE_DELAY, NULL);
 
         break;
       
@@ -504,8 +556,10 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             DWORD dwWidth, dwHeight;
 
             GetClientRect(hwnd, &rcClient);
-            dwWidth = rcClient.right - rcClient.left;
-            dwHeight = rcClient.bottom - rcClient.top;
+            dwWidth = winScaleToLogical(s_pScreenInfo,
+                                        rcClient.right - rcClient.left);
+            dwHeight = winScaleToLogical(s_pScreenInfo,
+                                         rcClient.bottom - rcClient.top);
 
             if ((s_pScreenInfo->dwWidth != dwWidth) ||
                 (s_pScreenInfo->dwHeight != dwHeight)) {
@@ -769,6 +823,22 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         return 0;
     }
 
+    case WM_POINTERDOWN:
+    case WM_POINTERUPDATE:
+    case WM_POINTERUP:
+        /* We can't do anything without privates */
+        if (s_pScreenPriv == NULL || s_pScreenInfo->fIgnoreInput)
+            break;
+
+        /* Touch contacts are delivered as XI2.2 touch events; returning
+           zero here also stops Windows from synthesizing mouse messages
+           for them.  Pen and mouse pointers fall through to
+           DefWindowProc so their emulated messages still arrive. */
+        if (winTouchProcessPointerMessage(hwnd, message, wParam, lParam,
+                                          s_pScreenInfo))
+            return 0;
+        break;
+
     case WM_MOUSEMOVE:
         if (wParam & (MK_LBUTTON|MK_RBUTTON|MK_MBUTTON))
         {
@@ -789,8 +859,12 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         /* Has the mouse pointer crossed screens? */
         if (s_pScreen != miPointerGetScreen(g_pwinPointer))
             miPointerSetScreen(g_pwinPointer, s_pScreenInfo->dwScreen,
-                               GET_X_LPARAM(lParam) - s_pScreenInfo->dwXOffset,
-                               GET_Y_LPARAM(lParam) - s_pScreenInfo->dwYOffset);
+                               winScaleToLogical(s_pScreenInfo,
+                                                 GET_X_LPARAM(lParam) -
+                                                 s_pScreenInfo->dwXOffset),
+                               winScaleToLogical(s_pScreenInfo,
+                                                 GET_Y_LPARAM(lParam) -
+                                                 s_pScreenInfo->dwYOffset));
 
         /* Are we tracking yet? */
         if (!s_fTracking) {
@@ -824,11 +898,28 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
             ShowCursor(TRUE);
         }
 
-        /* Deliver absolute cursor position to X Server */
-        winEnqueueMotion(GET_X_LPARAM(lParam) - s_pScreenInfo->dwXOffset,
-                         GET_Y_LPARAM(lParam) - s_pScreenInfo->dwYOffset);
+        /* Deliver absolute cursor position to X Server, unless motion
+           is being delivered through the raw input path */
+        if (!g_fRawInput)
+            winEnqueueMotion(winScaleToLogical(s_pScreenInfo,
+                                               GET_X_LPARAM(lParam) -
+                                               s_pScreenInfo->dwXOffset),
+                             winScaleToLogical(s_pScreenInfo,
+                                               GET_Y_LPARAM(lParam) -
+                                               s_pScreenInfo->dwYOffset));
         return 0;
 
+    case WM_INPUT:
+        if (s_pScreenPriv != NULL && !s_pScreenInfo->fIgnoreInput &&
+            g_pwinPointer != NULL)
+            winMouseRawInputHandle(hwnd, lParam,
+                                   s_pScreenInfo->dwXOffset,
+                                   s_pScreenInfo->dwYOffset,
+                                   s_pScreenInfo->dwScale);
+
+        /* Always pass WM_INPUT on so DefWindowProc performs cleanup */
+        break;
+
     case WM_NCMOUSEMOVE:
         /*
          * We break instead of returning 0 since we need to call
@@ -929,7 +1020,18 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
                                      HIWORD(wParam) + 7, wParam);
 
     case WM_TIMER:
-        if (s_pScreenPriv == NULL || s_pScreenInfo->fIgnoreInput)
+        if (s_pScreenPriv == NULL)
+            break;
+
+        /* The display reconfiguration timer is not input, so it is
+         * handled before the -ignoreinput check */
+        if (wParam == WIN_DISPLAYCHANGE_TIMER_ID) {
+            KillTimer(hwnd, WIN_DISPLAYCHANGE_TIMER_ID);
+            winProcessDisplayChange(hwnd, s_pScreenPriv);
+            return 0;
+        }
+
+        if (s_pScreenInfo->fIgnoreInput)
             break;
 
         /* Branch on the timer id */
@@ -1031,6 +1133,12 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         winRemoveKeyboardHookLL();
         return 0;
 
+    case WM_INPUTLANGCHANGE:
+        /* The keyboard layout changed: rebuild the key translation
+           tables before the next keystroke */
+        winInvalidateKeyMap();
+        break;
+
     case WM_SYSKEYDOWN:
     case WM_KEYDOWN:
         if (s_pScreenPriv == NULL || s_pScreenInfo->fIgnoreInput)
@@ -1216,6 +1324,13 @@ winWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
         }
         break;
 
+    case WM_DUMPSTATS:
+        /* Log per-domain object counts and trends since the last dump;
+           posted by the msg window when an external diagnostic tool
+           sends the registered XWIN_DUMPSTATS message */
+        dixPrivateUsage();
+        return 0;
+
     case WM_GIVEUP:
         /* Delete the tray Icon */
         if (!s_pScreenInfo->fNoTrayIcon && s_pScreenPriv->hiconNotifyIcon != NULL)
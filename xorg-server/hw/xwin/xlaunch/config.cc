@@ -135,7 +135,12 @@ BOOL getAttributeBool(xmlNodePtr elem, const char *name, bool &ret)
 
 void CConfig::Load(const char *filename)
 {
-  xmlDocPtr doc = xmlReadFile(filename, NULL, 0);
+  /* the config is read once in a single pass, so keep the parse as
+     lean as possible: no blank text nodes, no DTD fetching, no error
+     spew on a missing or hand-damaged file */
+  xmlDocPtr doc = xmlReadFile(filename, NULL,
+                              XML_PARSE_NOBLANKS | XML_PARSE_NONET |
+                              XML_PARSE_NOERROR | XML_PARSE_NOWARNING);
 
   xmlNodePtr root;
 
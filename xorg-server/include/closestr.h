@@ -92,9 +92,11 @@ typedef struct _LFclosure {
     LFWIstateRec current;
     LFWIstateRec saved;
     Bool haveSaved;
-    Bool	from_dispatch;    
+    Bool	from_dispatch;
     char *savedName;
     int savedNameLen;
+    FontNamesPtr *preNames;	/* per-FPE results of overlapped list_fonts */
+    int *preErr;		/* Suspended while a request is in flight */
 } LFclosureRec;
 
 /* PolyText */
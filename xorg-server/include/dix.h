@@ -186,6 +186,8 @@ extern _X_EXPORT void InitClient(ClientPtr client,
 
 extern _X_EXPORT ClientPtr NextAvailableClient(void *ospriv);
 
+extern _X_EXPORT Bool StartClientLatencyRecording(ClientPtr /*client */ );
+
 extern _X_EXPORT void SendErrorToClient(ClientPtr /*client */ ,
                                         unsigned int /*majorCode */ ,
                                         unsigned int /*minorCode */ ,
@@ -291,6 +293,27 @@ extern _X_EXPORT void ClientWakeup(ClientPtr /*client */ );
 
 extern _X_EXPORT Bool ClientIsAsleep(ClientPtr /*client */ );
 
+extern _X_EXPORT void *GetRequestScratch(ClientPtr /*client */ ,
+                                         size_t /*size */ );
+
+/* Power-of-two millisecond buckets in a window's frame interval
+   histogram; the last bucket collects everything slower */
+#define FRAME_TIMING_BUCKETS    8
+/* Windows tracked at a time; the least recently presenting window's
+   slot is recycled when a new window starts presenting */
+#define FRAME_TIMING_SLOTS      64
+
+typedef struct _FrameTimingSlot {
+    XID window;                 /* None while the slot is unused */
+    CARD32 frames;              /* swaps/presents recorded */
+    CARD32 lastTime;            /* ms timestamp of the latest frame */
+    CARD32 intervals[FRAME_TIMING_BUCKETS];
+} FrameTimingSlot;
+
+extern _X_EXPORT void FrameTimingRecord(XID /*window */ );
+
+extern _X_EXPORT FrameTimingSlot *FrameTimingLookup(XID /*window */ );
+
 extern _X_EXPORT void SendGraphicsExpose(ClientPtr /*client */ ,
                                          RegionPtr /*pRgn */ ,
                                          XID /*drawable */ ,
@@ -50,6 +50,9 @@ extern _X_EXPORT void QueryFont(FontPtr /*pFont */ ,
                                 xQueryFontReplyPtr /*pReply */ ,
                                 int /*nProtoCCIStructs */ );
 
+extern _X_EXPORT xQueryFontReplyPtr QueryFontCached(FontPtr /*pFont */ ,
+                                                    int * /*lengthp */ );
+
 extern _X_EXPORT int ListFonts(ClientPtr /*client */ ,
                                unsigned char * /*pattern */ ,
                                unsigned int /*length */ ,
@@ -73,6 +73,10 @@ typedef struct _saveSet {
 #define SaveSetAssignToRoot(ss,tr)  ((ss).toRoot = (tr))
 #define SaveSetAssignMap(ss,m)      ((ss).map = (m))
 
+/* Power-of-two microsecond buckets in a client's request latency
+   histogram; the last bucket collects everything slower */
+#define CLIENT_LATENCY_BUCKETS  16
+
 typedef struct _Client {
     void *requestBuffer;
     void *osPrivate;             /* for OS layer, including scheduler */
@@ -88,11 +92,15 @@ typedef struct _Client {
     unsigned int closeDownMode:2;
     unsigned int clientState:2;
     signed char smart_priority;
+    signed char smart_class;    /* scheduling latency class, see dispatch.c */
+    unsigned char smart_full_slices;    /* consecutive slices fully consumed */
     short noClientException;      /* this client died or needs to be killed */
     int priority;
     ReplySwapPtr pSwapReplyFunc;
     XID errorValue;
-    unsigned short sequence;    //MH
+    uint64_t sequence;          /* requests read; a free-running 64-bit count,
+                                   truncated to the wire width only when a
+                                   reply or event is encoded */
     int ignoreCount;            /* count for Attend/IgnoreClient */
     int numSaved;
     SaveSetElt *saveSet;
@@ -108,6 +116,17 @@ typedef struct _Client {
     int smart_start_tick;
     int smart_stop_tick;
 
+    /* Dispatch cost accounting */
+    unsigned long requestsProcessed;    /* requests dispatched for this client */
+    unsigned long ticksConsumed;        /* ms of dispatch time consumed */
+    CARD32 *requestLatency;     /* per-major-opcode latency histogram,
+                                   [256][CLIENT_LATENCY_BUCKETS]; armed by
+                                   X-Resource, NULL while off.  see dispatch.c */
+
+    void *requestScratch;       /* reusable request-processing buffer,
+                                   see GetRequestScratch in dispatch.c */
+    size_t requestScratchSize;
+
     DeviceIntPtr clientPtr;
     ClientIdPtr clientIds;
     int req_fds;
@@ -177,6 +196,16 @@ static inline Bool any_output_pending(void) {
 #define SMART_MAX_PRIORITY  (20)
 #define SMART_MIN_PRIORITY  (-20)
 
+/*
+ * Latency classes inferred from each client's scheduling behaviour;
+ * bulk clients recover priority slowly, interactive ones quickly.
+ * The explicit per-client priority (XSyncSetPriority) ranks above
+ * both.
+ */
+#define SMART_CLASS_BULK	 (-1)
+#define SMART_CLASS_DEFAULT	 (0)
+#define SMART_CLASS_INTERACTIVE	 (1)
+
 extern void SmartScheduleInit(void);
 
 /* This prototype is used pervasively in Xext, dix */
@@ -84,6 +84,13 @@ typedef struct {
     InitExtension initFunc;
     const char *name;
     Bool *disablePtr;
+    Bool deferred;              /* init on first QueryExtension rather
+                                   than at startup; only safe for
+                                   extensions that wrap no screen
+                                   procedures and that nothing in the
+                                   server itself depends on */
+    Bool pending;               /* deferred and not yet initialized in
+                                   this server generation */
 } ExtensionModule;
 
 extern _X_EXPORT unsigned short StandardMinorOpcode(ClientPtr /*client */ );
@@ -95,6 +102,10 @@ extern _X_EXPORT void EnableDisableExtensionError(const char *name,
 
 extern _X_EXPORT void InitExtensions(int argc, char **argv);
 
+extern _X_EXPORT void InitDeferredExtension(const char *name, int len);
+
+extern _X_EXPORT void InitDeferredExtensions(void);
+
 extern _X_EXPORT void CloseDownExtensions(void);
 
 extern _X_EXPORT void LoadExtensionList(const ExtensionModule ext[],
@@ -246,6 +246,9 @@ typedef struct _GC {
     unsigned short dashOffset;
     unsigned short numInDashList;
     unsigned char *dash;
+    unsigned short dashStartIndex;      /* dash list position of dashOffset */
+    unsigned short dashStartOffset;     /* distance into that dash; both are
+                                           kept current by dix/gc.c */
     unsigned int lineStyle:2;
     unsigned int capStyle:2;
     unsigned int joinStyle:2;
@@ -219,6 +219,8 @@ typedef struct _SpriteRec {
     BoxRec hotLimits;           /* logical constraints of hot spot */
     Bool confined;              /* confined to screen */
     RegionPtr hotShape;         /* additional logical shape constraint */
+    BoxRec hotShapeBox;         /* box of hotShape the hot spot was last
+                                   found in; reset when hotShape is set */
     BoxRec physLimits;          /* physical constraints of hot spot */
     WindowPtr win;              /* window of logical position */
     HotSpot hot;                /* logical pointer position */
@@ -322,6 +324,8 @@ typedef struct _TouchPointInfo {
     SpriteRec sprite;           /* window trace for delivery */
     ValuatorMask *valuators;    /* last recorded axis values */
     TouchListener *listeners;   /* set of listeners */
+    size_t listeners_size;      /* allocated capacity of listeners, kept
+                                 * across touches for reuse */
     int num_listeners;
     int num_grabs;              /* number of open grabs on this touch
                                  * which have not accepted or rejected */
@@ -529,6 +533,8 @@ typedef struct _GrabInfoRec {
         int state;
         GrabPtr other;          /* if other grab has this frozen */
         InternalEvent *event;   /* saved to be replayed */
+        int pendingEvents;      /* events queued for this device in
+                                 * syncEvents.pending */
     } sync;
 } GrabInfoRec, *GrabInfoPtr;
 
@@ -101,6 +101,7 @@ static double __inline trunc(double d)
 #define LIMITCLIENTS	1024     /* Must be a power of 2 and <= MAXCLIENTS */
 #define MAXEXTENSIONS   128
 #define MAXFORMATS	8
+#define MAXSCRATCHGCS	4        /* spare scratch GCs cached per screen */
 #ifndef MAXDEVICES
 #define MAXDEVICES	256      /* input devices */
 #endif
@@ -311,6 +312,10 @@ __builtin_constant_p(int x)
 static inline uint64_t
 bswap_64(uint64_t x)
 {
+#if defined(__clang__) || \
+    (defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 403)) /* 4.3+ */
+    return __builtin_bswap64(x);
+#else
     return (((x & 0xFF00000000000000ull) >> 56) |
             ((x & 0x00FF000000000000ull) >> 40) |
             ((x & 0x0000FF0000000000ull) >> 24) |
@@ -319,6 +324,7 @@ bswap_64(uint64_t x)
             ((x & 0x0000000000FF0000ull) << 24) |
             ((x & 0x000000000000FF00ull) << 40) |
             ((x & 0x00000000000000FFull) << 56));
+#endif
 }
 
 #define swapll(x) do { \
@@ -330,10 +336,15 @@ bswap_64(uint64_t x)
 static inline uint32_t
 bswap_32(uint32_t x)
 {
+#if defined(__clang__) || \
+    (defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 403)) /* 4.3+ */
+    return __builtin_bswap32(x);
+#else
     return (((x & 0xFF000000) >> 24) |
             ((x & 0x00FF0000) >> 8) |
             ((x & 0x0000FF00) << 8) |
             ((x & 0x000000FF) << 24));
+#endif
 }
 
 static inline Bool
@@ -374,8 +385,13 @@ checked_int64_subtract(int64_t *out, int64_t a, int64_t b)
 static inline uint16_t
 bswap_16(uint16_t x)
 {
+#if defined(__clang__) || \
+    (defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 408)) /* 4.8+ */
+    return __builtin_bswap16(x);
+#else
     return (((x & 0xFF00) >> 8) |
             ((x & 0x00FF) << 8));
+#endif
 }
 
 #define swaps(x) do { \
@@ -106,6 +106,8 @@ extern _X_EXPORT Bool WaitForSomething(Bool clients_are_ready);
 
 extern _X_EXPORT int ReadRequestFromClient(ClientPtr /*client */ );
 
+extern _X_EXPORT int PeekNextRequestMajorOp(ClientPtr /*client */ );
+
 extern _X_EXPORT int ReadFdFromClient(ClientPtr client);
 
 extern _X_EXPORT int WriteFdToClient(ClientPtr client, int fd, Bool do_close);
@@ -617,7 +619,8 @@ typedef enum _LogParameter {
     XLOG_FLUSH,
     XLOG_SYNC,
     XLOG_VERBOSITY,
-    XLOG_FILE_VERBOSITY
+    XLOG_FILE_VERBOSITY,
+    XLOG_ASYNC
 } LogParameter;
 
 /* Flags for log messages. */
@@ -644,6 +647,8 @@ extern _X_EXPORT void
 LogClose(enum ExitCode error);
 extern _X_EXPORT Bool
 LogSetParameter(LogParameter param, int value);
+/* max of the console and log file verbosity, for cheap pre-filtering */
+extern _X_EXPORT int LogEffectiveVerbosity;
 extern _X_EXPORT void
 LogVWrite(int verb, const char *f, va_list args)
 _X_ATTRIBUTE_PRINTF(2, 0);
@@ -739,6 +744,13 @@ xorg_backtrace(void);
 typedef _sigset_t sigset_t;
 #endif
 
+#if defined(WIN32) && !defined(__CYGWIN__)
+/* TRUE when blocking waits also wake on Win32 message queue input, so
+   block handlers need not clamp the timeout to poll for messages */
+extern _X_EXPORT int
+xserver_poll_wakes_on_messages(void);
+#endif
+
 extern _X_EXPORT int
 os_move_fd(int fd);
 
@@ -81,6 +81,9 @@ typedef struct _Pixmap {
     short screen_x;
     short screen_y;
     unsigned usage_hint;        /* see CREATE_PIXMAP_USAGE_* */
+    unsigned short size_class;  /* allocation size class + 1, or 0 when the
+                                   allocation is too large for the pixmap
+                                   pool (see dix/pixmap.c) */
 
     PixmapPtr primary_pixmap;    /* pointer to primary copy of pixmap for pixmap sharing */
 } PixmapRec;
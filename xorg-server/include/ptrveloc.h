@@ -40,6 +40,10 @@
 #define AccelProfileSmoothLimited 7
 #define AccelProfileLAST AccelProfileSmoothLimited
 
+/* resolution and range of the cached profile transfer function */
+#define ACCEL_PROFILE_CACHE_RES 8       /* table entries per velocity unit */
+#define ACCEL_PROFILE_CACHE_SIZE 256    /* covers velocities [0..32) */
+
 /* fwd */
 struct _DeviceVelocityRec;
 
@@ -85,6 +89,14 @@ typedef struct _DeviceVelocityRec {
     PointerAccelerationProfileFunc Profile;
     PointerAccelerationProfileFunc deviceSpecificProfile;
     void *profile_private;      /* extended data, see  SetAccelerationProfile() */
+    struct {                    /* profile samples, rebuilt whenever the
+                                   profile or the ctrl parameters change */
+        double acc[ACCEL_PROFILE_CACHE_SIZE];
+        double threshold;
+        double accel_coeff;
+        double min_acceleration;
+        PointerAccelerationProfileFunc profile;
+    } profile_cache;
     struct {                    /* to be able to query this information */
         int profile_number;
     } statistics;
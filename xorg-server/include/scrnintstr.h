@@ -510,6 +510,10 @@ typedef struct _Screen {
     char backingStoreSupport, saveUnderSupport;
     unsigned long whitePixel, blackPixel;
     GCPtr GCperDepth[MAXFORMATS + 1];
+    /* spare scratch GCs of any depth, parked here by FreeScratchGC when
+     * the matching GCperDepth entry was already handed out
+     */
+    GCPtr scratchGCs[MAXSCRATCHGCS];
     /* next field is a stipple to use as default in a GC.  we don't build
      * default tiles of all depths because they are likely to be of a color
      * different from the default fg pixel, so we don't win anything by
@@ -612,6 +616,10 @@ typedef struct _Screen {
 
     unsigned int totalPixmapSize;
 
+    struct _PixmapPool *pPixmapPool;    /* recycled pixmap allocations,
+                                           bucketed by size class
+                                           (see dix/pixmap.c) */
+
     MarkWindowProcPtr MarkWindow;
     MarkOverlappedWindowsProcPtr MarkOverlappedWindows;
     ConfigNotifyProcPtr ConfigNotify;
@@ -636,6 +644,12 @@ typedef struct _Screen {
      * default */
     Bool canDoBGNoneRoot;
 
+    /* set by the ddx when frames of top-level windows are drawn by the
+     * native window system (XWin multiwindow mode), so X borders of
+     * root children are never visible and need not be computed or
+     * painted */
+    Bool topLevelBordersExternal;
+
     Bool isGPU;
 
     /* Info on this screen's secondarys (if any) */
@@ -166,6 +166,12 @@ extern _X_EXPORT int ConfigureWindow(WindowPtr /*pWin */ ,
                                      XID * /*vlist */ ,
                                      ClientPtr /*client */ );
 
+/* TRUE while ConfigureWindow is batching a run of configure requests;
+ * tells the move/restack paths to leave the clip lists stale. */
+extern _X_EXPORT Bool deferWindowValidation;
+
+extern _X_EXPORT void ValidateDeferredTrees(void);
+
 extern _X_EXPORT int CirculateWindow(WindowPtr /*pParent */ ,
                                      int /*direction */ ,
                                      ClientPtr /*client */ );
@@ -202,6 +202,12 @@ extern _X_EXPORT Mask DontPropagateMasks[];
 
 #define HasBorder(w)	((w)->borderWidth || wClipShape(w))
 
+/* true when w's border is covered by a native frame and never visible
+   (see topLevelBordersExternal in scrnintstr.h) */
+
+#define BorderIsExternal(w)	((w)->parent && !(w)->parent->parent && \
+				 (w)->drawable.pScreen->topLevelBordersExternal)
+
 typedef struct _ScreenSaverStuff *ScreenSaverStuffPtr;
 
 #define SCREEN_IS_BLANKED   0
@@ -0,0 +1,34 @@
+/*
+ * Pipeline trace hooks
+ *
+ * A DDX can install a hook table here to be called at the interesting
+ * stages of the input-to-present pipeline: device event enqueue,
+ * request dispatch begin and end, and damage accumulation.  Present is
+ * DDX territory already, so a DDX traces its own present path directly.
+ *
+ * Call sites test the single xserverTraceHooks pointer, so the cost
+ * with tracing off is one predictable branch per site.  hw/xwin
+ * installs an ETW provider through this table (see wintrace.c) so the
+ * server's pipeline shows up in WPA traces alongside DWM and the GPU
+ * scheduler.
+ */
+
+#ifndef XSERVER_TRACE_H
+#define XSERVER_TRACE_H
+
+#include "client.h"
+#include "screenint.h"
+#include "regionstr.h"
+#include "input.h"
+
+typedef struct _XserverTraceHooks {
+    void (*RequestBegin) (ClientPtr client, int majorOp);
+    void (*RequestEnd) (ClientPtr client, int majorOp, int result);
+    void (*EventEnqueue) (DeviceIntPtr device, int eventType);
+    void (*DamageAppend) (ScreenPtr pScreen, BoxPtr pExtents);
+} XserverTraceHooks;
+
+/* NULL unless a DDX has installed hooks */
+extern _X_EXPORT XserverTraceHooks *xserverTraceHooks;
+
+#endif                          /* XSERVER_TRACE_H */
@@ -749,14 +749,47 @@ tailX(double K,
     return xs[0];
 }
 
+/*
+ * Cache of tessellated wide ellipses.  The span set depends only on the
+ * line width and the arc sizes, not on the position or the angles, so
+ * clients which redraw identical arcs every frame (gauges, dials) hit the
+ * cache instead of recomputing the ellipse spans.  Entries are owned by
+ * the cache and replaced least-recently-used; callers must not free the
+ * returned data, and may only hold it until the next call of
+ * miComputeWideEllipse.
+ */
+
+#define CACHESIZE 25
+
+typedef struct {
+    unsigned long lrustamp;
+    unsigned short lw;
+    unsigned short width, height;
+    miArcSpanData *spdata;
+} arcCacheRec;
+
+static arcCacheRec arcCache[CACHESIZE];
+static unsigned long lrustamp;
+
 static miArcSpanData *
 miComputeWideEllipse(int lw, xArc * parc)
 {
     miArcSpanData *spdata = NULL;
+    arcCacheRec *cent, *lruent;
     int k;
 
     if (!lw)
         lw = 1;
+    lruent = &arcCache[0];
+    for (cent = &arcCache[0]; cent < &arcCache[CACHESIZE]; cent++) {
+        if (cent->spdata && cent->lw == lw &&
+            cent->width == parc->width && cent->height == parc->height) {
+            cent->lrustamp = ++lrustamp;
+            return cent->spdata;
+        }
+        if (cent->lrustamp < lruent->lrustamp)
+            lruent = cent;
+    }
     k = (parc->height >> 1) + ((lw - 1) >> 1);
     spdata = malloc(sizeof(miArcSpanData) + sizeof(miArcSpan) * (k + 2));
     if (!spdata)
@@ -769,6 +802,12 @@ miComputeWideEllipse(int lw, xArc * parc)
         miComputeCircleSpans(lw, parc, spdata);
     else
         miComputeEllipseSpans(lw, parc, spdata);
+    free(lruent->spdata);
+    lruent->spdata = spdata;
+    lruent->lrustamp = ++lrustamp;
+    lruent->lw = lw;
+    lruent->width = parc->width;
+    lruent->height = parc->height;
     return spdata;
 }
 
@@ -873,7 +912,6 @@ miFillWideEllipse(DrawablePtr pDraw, GCPtr pGC, xArc * parc)
             wids += 2;
         }
     }
-    free(spdata);
     (*pGC->ops->FillSpans) (pDraw, pGC, pts - points, points, widths, FALSE);
 
     free(widths);
@@ -911,11 +949,8 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
     int halfWidth;
 
     if (width == 0 && pGC->lineStyle == LineSolid) {
-        for (i = narcs, parc = parcs; --i >= 0; parc++) {
-            miArcSpanData *spdata;
-            spdata = miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
-            free(spdata);
-        }
+        for (i = narcs, parc = parcs; --i >= 0; parc++)
+            miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
         fillSpans(pDraw, pGC);
         return;
     }
@@ -1043,13 +1078,10 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
             miArcDataPtr arcData;
 
             arcData = &polyArcs[iphase].arcs[i];
-            if (spdata) {
-                if (lastArc.width != arcData->arc.width ||
-                    lastArc.height != arcData->arc.height) {
-                    free(spdata);
-                    spdata = NULL;
-                }
-            }
+            if (spdata &&
+                (lastArc.width != arcData->arc.width ||
+                 lastArc.height != arcData->arc.height))
+                spdata = NULL;
             memcpy(&lastArc, &arcData->arc, sizeof(xArc));
             spdata = miArcSegment(pDrawTo, pGCTo, arcData->arc,
                                   &arcData->bounds[RIGHT_END],
@@ -1110,7 +1142,6 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
                 }
             }
         }
-        free(spdata);
         spdata = NULL;
     }
     miFreeArcs(polyArcs, pGC);
@@ -288,6 +288,7 @@ miGetPlane(DrawablePtr pDraw, int planeNum,     /* number of the bitPlane */
 
     OUT_TYPE *pOut;
     int delta = 0;
+    char *pRow = NULL;
 
     sx += pDraw->x;
     sy += pDraw->y;
@@ -310,6 +311,18 @@ miGetPlane(DrawablePtr pDraw, int planeNum,     /* number of the bitPlane */
         planeNum += (32 - bitsPerPixel);
 #endif
     }
+    /*
+     * For the common pixel sizes, fetch whole scanlines of pixels with
+     * a single GetSpans call and pull the plane out of the row buffer.
+     * GetSpans on a full-width span is a block copy in the framebuffer
+     * layers, so the cost tracks the image area instead of paying the
+     * GetSpans call overhead once per pixel.
+     */
+#if IMAGE_BYTE_ORDER == LSBFirst
+    if (bitsPerPixel == 8 || bitsPerPixel == 16 || bitsPerPixel == 32)
+        pRow = malloc(PixmapBytePad(w, pDraw->depth));
+#endif
+
     pt.y = sy;
     for (i = h; --i >= 0; pt.y++) {
         pt.x = sx;
@@ -318,6 +331,40 @@ miGetPlane(DrawablePtr pDraw, int planeNum,     /* number of the bitPlane */
                                          (char *) pCharsOut);
             pCharsOut += widthInBytes;
         }
+        else if (pRow) {
+            int rowWidth = w;
+
+            (*pDraw->pScreen->GetSpans) (pDraw, w, &pt, &rowWidth, 1, pRow);
+            k = 0;
+            for (j = 0; j < w; j++) {
+                switch (bitsPerPixel) {
+                case 8:
+                    pixel = ((CARD8 *) pRow)[j];
+                    break;
+                case 16:
+                    pixel = ((CARD16 *) pRow)[j];
+                    break;
+                default:
+                    pixel = ((CARD32 *) pRow)[j];
+                    break;
+                }
+                bit = (pixel >> planeNum) & 1;
+                if (screenInfo.bitmapBitOrder == LSBFirst)
+                    bit <<= k;
+                else
+                    bit <<= ((screenInfo.bitmapScanlineUnit - 1) -
+                             (k % screenInfo.bitmapScanlineUnit)) +
+                        ((k / screenInfo.bitmapScanlineUnit) *
+                         screenInfo.bitmapScanlineUnit);
+                *pOut |= (OUT_TYPE) bit;
+                k++;
+                if (k == BITMAP_SCANLINE_UNIT) {
+                    pOut++;
+                    k = 0;
+                }
+            }
+            pOut += delta;
+        }
         else {
             k = 0;
             for (j = w; --j >= 0; pt.x++) {
@@ -355,6 +402,7 @@ miGetPlane(DrawablePtr pDraw, int planeNum,     /* number of the bitPlane */
             pOut += delta;
         }
     }
+    free(pRow);
     return result;
 
 }
@@ -44,10 +44,48 @@ miCopyRegion(DrawablePtr pSrcDrawable,
     BoxPtr pbox;
     int nbox;
     BoxPtr pboxNew1, pboxNew2, pboxBase, pboxNext, pboxTmp;
+    BoxPtr pboxMerged = NULL;
 
     pbox = RegionRects(pDstRegion);
     nbox = RegionNumRects(pDstRegion);
 
+    /* A pure vertical scroll (terminal scrolling with a scrollbar
+     * clipped out is the common case) often decomposes into many
+     * single-band rects sharing the same horizontal span, which region
+     * banding cannot coalesce.  Merge vertically adjacent rects so the
+     * blitter walks one tall box per column instead of one per band.
+     * With dx == 0 the source and destination of distinct columns
+     * cannot interfere, so merging is safe in either copy direction.
+     */
+    if (dx == 0 && dy != 0 && nbox > 1) {
+        pboxMerged = xallocarray(nbox, sizeof(BoxRec));
+        if (pboxMerged) {
+            int i, j, n = 0;
+
+            for (i = 0; i < nbox; i++) {
+                for (j = n - 1; j >= 0; j--)
+                    if (pboxMerged[j].x1 == pbox[i].x1 &&
+                        pboxMerged[j].x2 == pbox[i].x2 &&
+                        pboxMerged[j].y2 == pbox[i].y1)
+                        break;
+                if (j >= 0)
+                    pboxMerged[j].y2 = pbox[i].y2;
+                else
+                    pboxMerged[n++] = pbox[i];
+            }
+            if (n < nbox) {
+                /* still sorted by y1, so the band reordering below
+                 * continues to work on the merged list */
+                pbox = pboxMerged;
+                nbox = n;
+            }
+            else {
+                free(pboxMerged);
+                pboxMerged = NULL;
+            }
+        }
+    }
+
     /* XXX we have to err on the side of safety when both are windows,
      * because we don't know if IncludeInferiors is being used.
      */
@@ -63,8 +101,10 @@ miCopyRegion(DrawablePtr pSrcDrawable,
         if (nbox > 1) {
             /* keep ordering in each band, reverse order of bands */
             pboxNew1 = xallocarray(nbox, sizeof(BoxRec));
-            if (!pboxNew1)
+            if (!pboxNew1) {
+                free(pboxMerged);
                 return;
+            }
             pboxBase = pboxNext = pbox + nbox - 1;
             while (pboxBase >= pbox) {
                 while ((pboxNext >= pbox) && (pboxBase->y1 == pboxNext->y1))
@@ -96,6 +136,7 @@ miCopyRegion(DrawablePtr pSrcDrawable,
             pboxNew2 = xallocarray(nbox, sizeof(BoxRec));
             if (!pboxNew2) {
                 free(pboxNew1);
+                free(pboxMerged);
                 return;
             }
             pboxBase = pboxNext = pbox;
@@ -125,6 +166,7 @@ miCopyRegion(DrawablePtr pSrcDrawable,
 
     free(pboxNew1);
     free(pboxNew2);
+    free(pboxMerged);
 }
 
 RegionPtr
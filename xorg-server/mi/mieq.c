@@ -53,22 +53,40 @@ in this Software without prior written authorization from The Open Group.
 #include   "extinit.h"
 #include   "exglobals.h"
 #include   "eventstr.h"
+#include   "xserver-trace.h"
 
 #ifdef DPMSExtension
 #include "dpmsproc.h"
 #include <X11/extensions/dpmsconst.h>
 #endif
 
-/* Maximum size should be initial size multiplied by a power of 2 */
-#define QUEUE_INITIAL_SIZE                 1024
-#define QUEUE_RESERVED_SIZE                 64
-#define QUEUE_MAXIMUM_SIZE                4096
+#define QUEUE_SIZE                        4096
 #define QUEUE_DROP_BACKTRACE_FREQUENCY     100
 #define QUEUE_DROP_BACKTRACE_MAX            10
 
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
 
+/*
+ * The queue is a single-producer/single-consumer ring shared between
+ * the input thread and the main thread.  All producers enqueue while
+ * holding input_lock(), which serializes them, so the only concurrency
+ * the ring has to survive is one producer against one consumer; that is
+ * handled with ring discipline (publish the slot before moving tail,
+ * consume the slot before moving head) instead of having the consumer
+ * take the input lock for every event.  On x86 the hardware keeps
+ * stores and loads in program order, so a compiler barrier is all that
+ * is needed to keep the slot/index accesses from being reordered.
+ */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define mieqBarrier() _ReadWriteBarrier()
+#elif defined(__GNUC__)
+#define mieqBarrier() __sync_synchronize()
+#else
+#define mieqBarrier()
+#endif
+
 typedef struct _Event {
     InternalEvent *events;
     ScreenPtr pScreen;
@@ -76,7 +94,7 @@ typedef struct _Event {
 } EventRec, *EventPtr;
 
 typedef struct _EventQueue {
-    HWEventQueueType head, tail;        /* long for SetInputCheck */
+    volatile HWEventQueueType head, tail;       /* long for SetInputCheck */
     CARD32 lastEventTime;       /* to avoid time running backwards */
     int lastMotion;             /* device ID if last event motion? */
     EventRec *events;           /* our queue as an array */
@@ -103,41 +121,23 @@ mieqNumEnqueued(EventQueuePtr eventQueue)
     return n_enqueued;
 }
 
-/* Pre-condition: Called with input_lock held */
+/*
+ * The ring cannot be resized while the producer and consumer run
+ * lock-free against it, so it is allocated at full size up front.
+ */
 static Bool
-mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
+mieqAllocQueue(EventQueuePtr eventQueue, size_t nevents)
 {
-    size_t i, n_enqueued, first_hunk;
+    size_t i;
     EventRec *new_events;
 
-    if (!eventQueue) {
-        ErrorF("[mi] mieqGrowQueue called with a NULL eventQueue\n");
-        return FALSE;
-    }
-
-    if (new_nevents <= eventQueue->nevents)
-        return FALSE;
-
-    new_events = calloc(new_nevents, sizeof(EventRec));
+    new_events = calloc(nevents, sizeof(EventRec));
     if (new_events == NULL) {
-        ErrorF("[mi] mieqGrowQueue memory allocation error.\n");
+        ErrorF("[mi] mieqAllocQueue memory allocation error.\n");
         return FALSE;
     }
 
-    n_enqueued = mieqNumEnqueued(eventQueue);
-
-    /* First copy the existing events */
-    first_hunk = eventQueue->nevents - eventQueue->head;
-    if (eventQueue->events) {
-        memcpy(new_events,
-               &eventQueue->events[eventQueue->head],
-               first_hunk * sizeof(EventRec));
-        memcpy(&new_events[first_hunk],
-               eventQueue->events, eventQueue->head * sizeof(EventRec));
-    }
-
-    /* Initialize the new portion */
-    for (i = eventQueue->nevents; i < new_nevents; i++) {
+    for (i = 0; i < nevents; i++) {
         InternalEvent *evlist = InitEventList(1);
 
         if (!evlist) {
@@ -151,11 +151,9 @@ mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
         new_events[i].events = evlist;
     }
 
-    /* And update our record */
-    eventQueue->tail = n_enqueued;
     eventQueue->head = 0;
-    eventQueue->nevents = new_nevents;
-    free(eventQueue->events);
+    eventQueue->tail = 0;
+    eventQueue->nevents = nevents;
     eventQueue->events = new_events;
 
     return TRUE;
@@ -167,12 +165,11 @@ mieqInit(void)
     memset(&miEventQueue, 0, sizeof(miEventQueue));
     miEventQueue.lastEventTime = GetTimeInMillis();
 
-    input_lock();
-    if (!mieqGrowQueue(&miEventQueue, QUEUE_INITIAL_SIZE))
+    if (!mieqAllocQueue(&miEventQueue, QUEUE_SIZE))
         FatalError("Could not allocate event queue.\n");
-    input_unlock();
 
-    SetInputCheck(&miEventQueue.head, &miEventQueue.tail);
+    SetInputCheck((HWEventQueueType *) &miEventQueue.head,
+                  (HWEventQueueType *) &miEventQueue.tail);
     return TRUE;
 }
 
@@ -192,7 +189,9 @@ mieqFini(void)
 
 /*
  * Must be reentrant with ProcessInputEvents.  Assumption: mieqEnqueue
- * will never be interrupted. Must be called with input_lock held
+ * will never be interrupted. Must be called with input_lock held,
+ * which serializes producers; the consumer runs concurrently without
+ * the lock.
  */
 
 void
@@ -204,48 +203,54 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
     int evlen;
     Time time;
     size_t n_enqueued;
+    Bool coalesce = FALSE;
 
     verify_internal_event(e);
 
+    if (xserverTraceHooks)
+        xserverTraceHooks->EventEnqueue(pDev, e->any.type);
+
     n_enqueued = mieqNumEnqueued(&miEventQueue);
 
     /* avoid merging events from different devices */
     if (e->any.type == ET_Motion)
         isMotion = pDev->id;
 
-    if (isMotion && isMotion == miEventQueue.lastMotion &&
-        oldtail != miEventQueue.head) {
+    /* Coalesce consecutive motion events by overwriting the one most
+     * recently enqueued.  That slot is only known to be untouched by
+     * the consumer while at least one older event sits in front of it,
+     * since the consumer may already be copying out the event at head.
+     */
+    if (isMotion && isMotion == miEventQueue.lastMotion && n_enqueued >= 2) {
         oldtail = (oldtail - 1) % miEventQueue.nevents;
+        coalesce = TRUE;
     }
     else if (n_enqueued + 1 == miEventQueue.nevents) {
-        if (!mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1)) {
-            /* Toss events which come in late.  Usually this means your server's
-             * stuck in an infinite loop in the main thread.
-             */
-            miEventQueue.dropped++;
-            if (miEventQueue.dropped == 1) {
-                ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
-                              "discarded until existing events are processed.\n");
-                xorg_backtrace();
-                ErrorFSigSafe("[mi] These backtraces from mieqEnqueue may point to "
-                              "a culprit higher up the stack.\n");
-                ErrorFSigSafe("[mi] mieq is *NOT* the cause.  It is a victim.\n");
-            }
-            else if (miEventQueue.dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
-                     miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
-                     QUEUE_DROP_BACKTRACE_MAX) {
-                ErrorFSigSafe("[mi] EQ overflow continuing.  %zu events have been "
-                              "dropped.\n", miEventQueue.dropped);
-                if (miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
-                    QUEUE_DROP_BACKTRACE_MAX) {
-                    ErrorFSigSafe("[mi] No further overflow reports will be "
-                                  "reported until the clog is cleared.\n");
-                }
-                xorg_backtrace();
+        /* Toss events which come in late.  Usually this means your server's
+         * stuck in an infinite loop in the main thread.
+         */
+        miEventQueue.dropped++;
+        if (miEventQueue.dropped == 1) {
+            ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
+                          "discarded until existing events are processed.\n");
+            xorg_backtrace();
+            ErrorFSigSafe("[mi] These backtraces from mieqEnqueue may point to "
+                          "a culprit higher up the stack.\n");
+            ErrorFSigSafe("[mi] mieq is *NOT* the cause.  It is a victim.\n");
+        }
+        else if (miEventQueue.dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
+                 miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
+                 QUEUE_DROP_BACKTRACE_MAX) {
+            ErrorFSigSafe("[mi] EQ overflow continuing.  %zu events have been "
+                          "dropped.\n", miEventQueue.dropped);
+            if (miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
+                QUEUE_DROP_BACKTRACE_MAX) {
+                ErrorFSigSafe("[mi] No further overflow reports will be "
+                              "reported until the clog is cleared.\n");
             }
-            return;
+            xorg_backtrace();
         }
-        oldtail = miEventQueue.tail;
+        return;
     }
 
     evlen = e->any.length;
@@ -264,7 +269,12 @@ mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
     miEventQueue.events[oldtail].pDev = pDev;
 
     miEventQueue.lastMotion = isMotion;
-    miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+    if (!coalesce) {
+        /* Publish the slot before moving tail so the consumer never
+         * sees a partially filled event */
+        mieqBarrier();
+        miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+    }
 }
 
 /**
@@ -519,8 +529,6 @@ mieqProcessInputEvents(void)
     DeviceIntPtr dev = NULL, master = NULL;
     static Bool inProcessInputEvents = FALSE;
 
-    input_lock();
-
     /*
      * report an error if mieqProcessInputEvents() is called recursively;
      * this can happen, e.g., if something in the mieqProcessDeviceEvent()
@@ -537,6 +545,12 @@ mieqProcessInputEvents(void)
         miEventQueue.dropped = 0;
     }
 
+    /* Drain the ring without taking the input lock: the producer
+     * publishes tail only after filling the slot, and we release the
+     * slot only after copying it out, so the two sides never touch the
+     * same entry.  The input thread therefore never blocks on dispatch,
+     * however long event processing below takes.
+     */
     while (miEventQueue.head != miEventQueue.tail) {
         e = &miEventQueue.events[miEventQueue.head];
 
@@ -544,10 +558,10 @@ mieqProcessInputEvents(void)
         dev = e->pDev;
         screen = e->pScreen;
 
+        /* Consume the slot contents before handing it back */
+        mieqBarrier();
         miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
 
-        input_unlock();
-
         master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
 
         if (screenIsSaved == SCREEN_SAVER_ON)
@@ -569,14 +583,12 @@ mieqProcessInputEvents(void)
                event.any.type == ET_TouchUpdate) &&
               event.device_event.flags & TOUCH_POINTER_EMULATED)))
             miPointerUpdateSprite(dev);
-
-        input_lock();
     }
 
     inProcessInputEvents = FALSE;
 
+    input_lock();
     CallCallbacks(&miCallbacksWhenDrained, NULL);
-
     input_unlock();
 }
 
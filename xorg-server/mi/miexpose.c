@@ -300,6 +300,104 @@ miHandleExposures(DrawablePtr pSrcDrawable, DrawablePtr pDstDrawable,
     }
 }
 
+/*
+ * Deferred expose delivery
+ *
+ * Interactive window management can expose the same window several
+ * times within one dispatch cycle (each Configure of an overlapping
+ * window uncovers another strip), and every call used to turn into its
+ * own run of Expose events that the client repainted for separately.
+ * Instead, exposures are accumulated per window on this list and
+ * flushed by a work proc, which WaitForSomething runs once per dispatch
+ * cycle before the server goes back to waiting for input, so each
+ * window receives a single merged event set per cycle.
+ *
+ * Windows are remembered by resource ID, not pointer: a window can be
+ * destroyed between accumulation and the flush, so the ID is looked up
+ * again at delivery time and exposures for dead windows are dropped.
+ */
+
+typedef struct _DeferredExposures {
+    struct _DeferredExposures *pNext;
+    XID window;
+    ScreenPtr pScreen;
+    RegionRec region;           /* window-relative accumulated exposures */
+} DeferredExposuresRec, *DeferredExposuresPtr;
+
+static DeferredExposuresPtr pDeferredExposures = NULL;
+static Bool deferredExposuresQueued = FALSE;
+
+static Bool
+miFlushDeferredExposures(ClientPtr pClient, void *closure)
+{
+    DeferredExposuresPtr pDef = pDeferredExposures;
+
+    pDeferredExposures = NULL;
+    deferredExposuresQueued = FALSE;
+
+    while (pDef) {
+        DeferredExposuresPtr pNext = pDef->pNext;
+        WindowPtr pWin;
+
+        if ((dixLookupWindow(&pWin, pDef->window, serverClient,
+                             DixSendAccess) == Success) &&
+            (pWin->drawable.pScreen == pDef->pScreen)) {
+            if (RegionNumRects(&pDef->region) > RECTLIMIT) {
+                /*
+                 * If we have LOTS of rectangles, we decide to take the extents
+                 * and force an exposure on that.  This should require much less
+                 * work overall, on both client and server.  This is cheating, but
+                 * isn't prohibited by the protocol ("spontaneous combustion" :-).
+                 */
+                BoxRec box = *RegionExtents(&pDef->region);
+
+                RegionReset(&pDef->region, &box);
+            }
+            miSendExposures(pWin, &pDef->region, 0, 0);
+        }
+        RegionUninit(&pDef->region);
+        free(pDef);
+        pDef = pNext;
+    }
+    return TRUE;
+}
+
+static void
+miDeferExposures(WindowPtr pWin, RegionPtr pRgn)
+{
+    DeferredExposuresPtr pDef;
+
+    for (pDef = pDeferredExposures; pDef; pDef = pDef->pNext)
+        if (pDef->window == pWin->drawable.id &&
+            pDef->pScreen == pWin->drawable.pScreen)
+            break;
+
+    if (!pDef) {
+        pDef = malloc(sizeof(DeferredExposuresRec));
+        if (!pDef) {
+            /* Fall back to immediate delivery */
+            miSendExposures(pWin, pRgn,
+                            pWin->drawable.x, pWin->drawable.y);
+            return;
+        }
+        pDef->window = pWin->drawable.id;
+        pDef->pScreen = pWin->drawable.pScreen;
+        RegionNull(&pDef->region);
+        pDef->pNext = pDeferredExposures;
+        pDeferredExposures = pDef;
+    }
+
+    /* Accumulate in window-relative coordinates, so that a window which
+       moves again before the flush still exposes the right area */
+    RegionTranslate(pRgn, -pWin->drawable.x, -pWin->drawable.y);
+    RegionUnion(&pDef->region, &pDef->region, pRgn);
+    RegionTranslate(pRgn, pWin->drawable.x, pWin->drawable.y);
+
+    if (!deferredExposuresQueued)
+        deferredExposuresQueued =
+            QueueWorkProc(miFlushDeferredExposures, NULL, NULL);
+}
+
 void
 miSendExposures(WindowPtr pWin, RegionPtr pRgn, int dx, int dy)
 {
@@ -386,8 +484,7 @@ miWindowExposures(WindowPtr pWin, RegionPtr prgn)
         }
         pWin->drawable.pScreen->PaintWindow(pWin, prgn, PW_BACKGROUND);
         if (clientInterested)
-            miSendExposures(pWin, exposures,
-                            pWin->drawable.x, pWin->drawable.y);
+            miDeferExposures(pWin, exposures);
         if (exposures == &expRec)
             RegionUninit(exposures);
         RegionEmpty(prgn);
@@ -446,6 +543,10 @@ miPaintWindow(WindowPtr pWin, RegionPtr prgn, int what)
     else {
         PixmapPtr pixmap;
 
+        /* the native frame covers the border; nothing to paint */
+        if (BorderIsExternal(pWin))
+            return;
+
         fill = pWin->border;
         solid = pWin->borderIsPixel;
 
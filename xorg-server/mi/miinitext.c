@@ -130,7 +130,8 @@ static const ExtensionModule staticExtensions[] = {
     /* must be before Render to layer DisplayCursor correctly */
     {XFixesExtensionInit, "XFIXES", &noXFixesExtension},
 #ifdef XF86BIGFONT
-    {XFree86BigfontExtensionInit, "XFree86-Bigfont", &noXFree86BigfontExtension},
+    {XFree86BigfontExtensionInit, "XFree86-Bigfont", &noXFree86BigfontExtension,
+     TRUE},
 #endif
     {RenderExtensionInit, "RENDER", &noRenderExtension},
 #ifdef RANDR
@@ -143,13 +144,13 @@ static const ExtensionModule staticExtensions[] = {
     {DamageExtensionInit, "DAMAGE", &noDamageExtension},
 #endif
 #ifdef SCREENSAVER
-    {ScreenSaverExtensionInit, "MIT-SCREEN-SAVER", &noScreenSaverExtension},
+    {ScreenSaverExtensionInit, "MIT-SCREEN-SAVER", &noScreenSaverExtension, TRUE},
 #endif
 #ifdef DBE
-    {DbeExtensionInit, "DOUBLE-BUFFER", &noDbeExtension},
+    {DbeExtensionInit, "DOUBLE-BUFFER", &noDbeExtension, TRUE},
 #endif
 #ifdef XRECORD
-    {RecordExtensionInit, "RECORD", &noTestExtensions},
+    {RecordExtensionInit, "RECORD", &noTestExtensions, TRUE},
 #endif
 #ifdef DPMSExtension
     {DPMSExtensionInit, "DPMS", &noDPMSExtension},
@@ -164,8 +165,8 @@ static const ExtensionModule staticExtensions[] = {
     {ResExtensionInit, "X-Resource", &noResExtension},
 #endif
 #ifdef XV
-    {XvExtensionInit, "XVideo", &noXvExtension},
-    {XvMCExtensionInit, "XVideo-MotionCompensation", &noXvExtension},
+    {XvExtensionInit, "XVideo", &noXvExtension, TRUE},
+    {XvMCExtensionInit, "XVideo-MotionCompensation", &noXvExtension, TRUE},
 #endif
 #ifdef XSELINUX
     {SELinuxExtensionInit, "SELinux", &noSELinuxExtension},
@@ -266,11 +267,64 @@ InitExtensions(int argc, char *argv[])
         ext = &ExtensionModuleList[i];
         if (ext->initFunc != NULL &&
             (ext->disablePtr == NULL || !*ext->disablePtr)) {
+            if (ext->deferred) {
+                /* brought up on first QueryExtension instead */
+                ext->pending = TRUE;
+                continue;
+            }
             LogMessageVerb(X_INFO, 3, "Initializing extension %s\n",
                            ext->name);
 
             (ext->initFunc) ();
         }
+        else
+            ext->pending = FALSE;
+    }
+}
+
+/*
+ * Extensions marked deferred in the list above allocate resource types,
+ * per-screen privates and the like that most sessions never use, so
+ * their init is put off until a client asks for them.  Every sane
+ * client goes through QueryExtension to learn the major opcode before
+ * issuing extension requests, which makes that the natural trigger;
+ * ListExtensions brings up everything still pending so the reported
+ * list stays exact.
+ */
+
+void
+InitDeferredExtension(const char *name, int len)
+{
+    int i;
+
+    for (i = 0; i < numExtensionModules; i++) {
+        ExtensionModule *ext = &ExtensionModuleList[i];
+
+        if (ext->pending && strlen(ext->name) == (size_t) len &&
+            memcmp(ext->name, name, len) == 0) {
+            ext->pending = FALSE;
+            LogMessageVerb(X_INFO, 3, "Initializing deferred extension %s\n",
+                           ext->name);
+            (ext->initFunc) ();
+            return;
+        }
+    }
+}
+
+void
+InitDeferredExtensions(void)
+{
+    int i;
+
+    for (i = 0; i < numExtensionModules; i++) {
+        ExtensionModule *ext = &ExtensionModuleList[i];
+
+        if (ext->pending) {
+            ext->pending = FALSE;
+            LogMessageVerb(X_INFO, 3, "Initializing deferred extension %s\n",
+                           ext->name);
+            (ext->initFunc) ();
+        }
     }
 }
 
@@ -177,6 +177,43 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
 				    HasBorder(w) && \
 				    (w)->backgroundState == ParentRelative)
 
+/*
+ * Check whether any window in the subtree rooted at pParent has a pending
+ * geometry change (move, resize or border shape change).  Only when none
+ * does can the clip regions computed by a previous validation be reused
+ * for the whole subtree.
+ */
+static Bool
+miTreeUnchanged(WindowPtr pParent)
+{
+    WindowPtr pChild;
+
+    pChild = pParent;
+    while (1) {
+        if (pChild->viewable) {
+            if (pChild->valdata) {
+                if (pChild->valdata == UnmapValData ||
+                    pChild->valdata->before.resized ||
+                    pChild->valdata->before.borderVisible ||
+                    pChild->drawable.x != pChild->valdata->before.oldAbsCorner.x ||
+                    pChild->drawable.y != pChild->valdata->before.oldAbsCorner.y ||
+                    pChild->visibility == VisibilityNotViewable)
+                    return FALSE;
+            }
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+    return TRUE;
+}
+
 /*
  *-----------------------------------------------------------------------
  * miComputeClips --
@@ -281,6 +318,42 @@ miComputeClips(WindowPtr pParent,
     dx = pParent->drawable.x - pParent->valdata->before.oldAbsCorner.x;
     dy = pParent->drawable.y - pParent->valdata->before.oldAbsCorner.y;
 
+    /*
+     * A window is frequently marked only because a sibling's change might
+     * have uncovered or obscured it.  When its new universe turns out to
+     * be identical to the old borderClip and nothing in the subtree has
+     * moved, resized or changed border shape, every clip region below is
+     * still valid: reuse them wholesale and just hand each marked inferior
+     * empty exposure regions.  This makes a restack cost time proportional
+     * to the windows it actually overlaps instead of the whole tree.
+     */
+    if (!dx && !dy && oldVis == newVis &&
+        (kind == VTOther || kind == VTStack || kind == VTMove) &&
+        !pParent->valdata->before.resized &&
+        !pParent->valdata->before.borderVisible &&
+        RegionEqual(universe, &pParent->borderClip) &&
+        miTreeUnchanged(pParent)) {
+        pChild = pParent;
+        while (1) {
+            if (pChild->viewable) {
+                if (pChild->valdata && pChild->valdata != UnmapValData) {
+                    RegionNull(&pChild->valdata->after.borderExposed);
+                    RegionNull(&pChild->valdata->after.exposed);
+                }
+                if (pChild->firstChild) {
+                    pChild = pChild->firstChild;
+                    continue;
+                }
+            }
+            while (!pChild->nextSib && (pChild != pParent))
+                pChild = pChild->parent;
+            if (pChild == pParent)
+                break;
+            pChild = pChild->nextSib;
+        }
+        return;
+    }
+
     /*
      * avoid computations when dealing with simple operations
      */
@@ -362,7 +435,18 @@ miComputeClips(WindowPtr pParent,
      * This leaves a region of pieces that weren't exposed before.
      */
 
-    if (HasBorder(pParent)) {
+    if (HasBorder(pParent) && BorderIsExternal(pParent)) {
+        /*
+         * The native window system draws this window's frame, so the
+         * border is never visible: skip the exposure arithmetic, but
+         * still deny the border ring to the window itself.
+         */
+        if (borderVisible)
+            RegionDestroy(borderVisible);
+        RegionCopy(&pParent->borderClip, universe);
+        RegionIntersect(universe, universe, &pParent->winSize);
+    }
+    else if (HasBorder(pParent)) {
         if (borderVisible) {
             /*
              * when the border changes shape, the old visible portions
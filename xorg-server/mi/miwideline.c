@@ -423,7 +423,8 @@ miDisposeSpanGroup(SpanGroup * spanGroup)
 }
 
 static void
-miFillUniqueSpanGroup(DrawablePtr pDraw, GCPtr pGC, SpanGroup * spanGroup)
+miFillUniqueSpanGroup(DrawablePtr pDraw, GCPtr pGC, SpanGroup * spanGroup,
+                      Bool careful)
 {
     int i;
     Spans *spans;
@@ -545,8 +546,18 @@ miFillUniqueSpanGroup(DrawablePtr pDraw, GCPtr pGC, SpanGroup * spanGroup)
             if (ycount > 0) {
                 if (ycount > 1) {
                     QuickSortSpansX(yspans[i].points, yspans[i].widths, ycount);
-                    count += UniquifySpansX
-                        (&(yspans[i]), &(points[count]), &(widths[count]));
+                    if (careful)
+                        count += UniquifySpansX
+                            (&(yspans[i]), &(points[count]), &(widths[count]));
+                    else {
+                        /* Overlap is harmless, so the sorted bucket can be
+                           block-copied instead of merged span by span */
+                        memcpy(&points[count], yspans[i].points,
+                               ycount * sizeof(DDXPointRec));
+                        memcpy(&widths[count], yspans[i].widths,
+                               ycount * sizeof(int));
+                        count += ycount;
+                    }
                 }
                 else {
                     points[count] = yspans[i].points[0];
@@ -590,6 +601,8 @@ InitSpans(Spans * spans, size_t nspans)
 
 typedef struct _SpanData {
     SpanGroup fgGroup, bgGroup;
+    Bool easyRop;               /* Overlapping spans are harmless; batch
+                                   without the touch-once uniquify pass */
 } SpanDataRec, *SpanDataPtr;
 
 static void
@@ -1867,8 +1880,24 @@ miWideSegment(DrawablePtr pDrawable,
 static SpanDataPtr
 miSetupSpanData(GCPtr pGC, SpanDataPtr spanData, int npt)
 {
-    if ((npt < 3 && pGC->capStyle != CapRound) || miSpansEasyRop(pGC->alu))
+    if (npt < 3 && pGC->capStyle != CapRound)
         return (SpanDataPtr) NULL;
+    if (miSpansEasyRop(pGC->alu)) {
+        /* These rops give the same result no matter how often a pixel is
+         * touched, so the touch-each-pixel-once bookkeeping is not needed.
+         * Batching still pays off, though: accumulate the spans of every
+         * segment, join and cap of the polyline and flush them through a
+         * single sorted FillSpans instead of one call per polygon piece.
+         * Double-dashed lines keep the unbatched path so that overlapping
+         * foreground and background pieces are still painted in
+         * generation order. */
+        if (pGC->lineStyle == LineDoubleDash)
+            return (SpanDataPtr) NULL;
+        spanData->easyRop = TRUE;
+        miInitSpanGroup(&spanData->fgGroup);
+        return spanData;
+    }
+    spanData->easyRop = FALSE;
     if (pGC->lineStyle == LineDoubleDash)
         miInitSpanGroup(&spanData->bgGroup);
     miInitSpanGroup(&spanData->fgGroup);
@@ -1887,14 +1916,15 @@ miCleanupSpanData(DrawablePtr pDrawable, GCPtr pGC, SpanDataPtr spanData)
             ChangeGC(NullClient, pGC, GCForeground, &pixel);
             ValidateGC(pDrawable, pGC);
         }
-        miFillUniqueSpanGroup(pDrawable, pGC, &spanData->bgGroup);
+        miFillUniqueSpanGroup(pDrawable, pGC, &spanData->bgGroup, TRUE);
         miFreeSpanGroup(&spanData->bgGroup);
         if (pixel.val != oldPixel.val) {
             ChangeGC(NullClient, pGC, GCForeground, &oldPixel);
             ValidateGC(pDrawable, pGC);
         }
     }
-    miFillUniqueSpanGroup(pDrawable, pGC, &spanData->fgGroup);
+    miFillUniqueSpanGroup(pDrawable, pGC, &spanData->fgGroup,
+                          !spanData->easyRop);
     miFreeSpanGroup(&spanData->fgGroup);
 }
 
@@ -2397,10 +2427,10 @@ miWideDash(DrawablePtr pDrawable, GCPtr pGC,
     }
     projectLeft = pGC->capStyle == CapProjecting && !selfJoin;
     projectRight = FALSE;
-    dashIndex = 0;
-    dashOffset = 0;
-    miStepDash((int) pGC->dashOffset, &dashIndex,
-               pGC->dash, (int) pGC->numInDashList, &dashOffset);
+    /* start position in the dash list was precomputed when the GC's
+       dashes or dash offset last changed */
+    dashIndex = pGC->dashStartIndex;
+    dashOffset = pGC->dashStartOffset;
     while (--npt) {
         x1 = x2;
         y1 = y2;
@@ -262,7 +262,7 @@ miMoveWindow(WindowPtr pWin, int x, int y, WindowPtr pNextSib, VTKind kind)
 
     oldpt.x = pWin->drawable.x;
     oldpt.y = pWin->drawable.y;
-    if (WasViewable) {
+    if (WasViewable && !deferWindowValidation) {
         oldRegion = RegionCreate(NullBox, 1);
         RegionCopy(oldRegion, &pWin->borderClip);
         anyMarked = (*pScreen->MarkOverlappedWindows) (pWin, pWin, &pLayerWin);
@@ -281,7 +281,11 @@ miMoveWindow(WindowPtr pWin, int x, int y, WindowPtr pNextSib, VTKind kind)
 
     ResizeChildrenWinSize(pWin, x - oldpt.x, y - oldpt.y, 0, 0);
 
-    if (WasViewable) {
+    /* When ConfigureWindow is batching a run of configure requests the
+     * per-move validation (and the pixel copy, which would need valid
+     * clips) is skipped; the batched validation exposes the window at
+     * its final position instead.  See ValidateDeferredTrees. */
+    if (WasViewable && !deferWindowValidation) {
         if (pLayerWin == pWin)
             anyMarked |= (*pScreen->MarkOverlappedWindows)
                 (pWin, windowToValidate, NULL);
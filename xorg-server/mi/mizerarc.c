@@ -681,11 +681,8 @@ miZeroPolyArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
         dinfo.haveStart = FALSE;
         dinfo.skipStart = FALSE;
         dinfo.haveLast = FALSE;
-        dinfo.dashIndexInit = 0;
-        dinfo.dashOffsetInit = 0;
-        miStepDash((int) pGC->dashOffset, &dinfo.dashIndexInit,
-                   (unsigned char *) pGC->dash, (int) pGC->numInDashList,
-                   &dinfo.dashOffsetInit);
+        dinfo.dashIndexInit = pGC->dashStartIndex;
+        dinfo.dashOffsetInit = pGC->dashStartOffset;
     }
     points = xallocarray(numPts, sizeof(DDXPointRec));
     if (!points) {
@@ -40,6 +40,7 @@
 #include    "gcstruct.h"
 #include    "damage.h"
 #include    "damagestr.h"
+#include    "xserver-trace.h"
 
 #define wrap(priv, real, mem, func) {\
     priv->mem = real->mem; \
@@ -150,6 +151,9 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
     if (!RegionNotEmpty(pRegion))
         return;
 
+    if (xserverTraceHooks)
+        xserverTraceHooks->DamageAppend(pScreen, RegionExtents(pRegion));
+
 #ifdef COMPOSITE
     /*
      * When drawing to a pixmap which is storing window contents,
@@ -95,7 +95,8 @@ SOFTWARE.
 #endif
 
 struct _OsTimerRec {
-    struct xorg_list list;
+    int heap_pos;               /* index into timer_heap, -1 if not pending */
+    CARD64 seq;                 /* insertion order, breaks expiry ties */
     CARD32 expires;
     CARD32 delta;
     OsTimerCallback callback;
@@ -105,15 +106,101 @@ struct _OsTimerRec {
 static void DoTimer(OsTimerPtr timer, CARD32 now);
 static void DoTimers(CARD32 now);
 static void CheckAllTimers(void);
-static volatile struct xorg_list timers;
+
+/*
+ * Pending timers, kept as a binary min-heap ordered on (expires, seq):
+ * the next expiry is the root, insertion and cancellation are O(log n)
+ * where the sorted list needed a linear scan per insert.  The sequence
+ * number keeps timers expiring in the same millisecond firing in the
+ * order they were set, as the list used to.
+ */
+static OsTimerPtr *timer_heap;
+static int timer_count;
+static int timer_alloc;
+static CARD64 timer_seq;
 
 static inline OsTimerPtr
 first_timer(void)
 {
-    /* inline xorg_list_is_empty which can't handle volatile */
-    if (timers.next == &timers)
-        return NULL;
-    return xorg_list_first_entry(&timers, struct _OsTimerRec, list);
+    return timer_count ? timer_heap[0] : NULL;
+}
+
+static inline Bool
+timer_before(OsTimerPtr a, OsTimerPtr b)
+{
+    if (a->expires != b->expires)
+        return (int) (a->expires - b->expires) < 0;
+    return a->seq < b->seq;
+}
+
+static void
+timer_sift_up(int pos)
+{
+    OsTimerPtr timer = timer_heap[pos];
+
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+
+        if (!timer_before(timer, timer_heap[parent]))
+            break;
+        timer_heap[pos] = timer_heap[parent];
+        timer_heap[pos]->heap_pos = pos;
+        pos = parent;
+    }
+    timer_heap[pos] = timer;
+    timer->heap_pos = pos;
+}
+
+static void
+timer_sift_down(int pos)
+{
+    OsTimerPtr timer = timer_heap[pos];
+
+    for (;;) {
+        int child = 2 * pos + 1;
+
+        if (child >= timer_count)
+            break;
+        if (child + 1 < timer_count &&
+            timer_before(timer_heap[child + 1], timer_heap[child]))
+            child++;
+        if (!timer_before(timer_heap[child], timer))
+            break;
+        timer_heap[pos] = timer_heap[child];
+        timer_heap[pos]->heap_pos = pos;
+        pos = child;
+    }
+    timer_heap[pos] = timer;
+    timer->heap_pos = pos;
+}
+
+static void
+timer_insert(OsTimerPtr timer)
+{
+    if (timer_count == timer_alloc) {
+        timer_alloc = timer_alloc ? 2 * timer_alloc : 16;
+        timer_heap = xnfreallocarray(timer_heap, timer_alloc,
+                                     sizeof(OsTimerPtr));
+    }
+    timer->seq = ++timer_seq;
+    timer_heap[timer_count] = timer;
+    timer->heap_pos = timer_count++;
+    timer_sift_up(timer->heap_pos);
+}
+
+static void
+timer_remove(OsTimerPtr timer)
+{
+    int pos = timer->heap_pos;
+
+    timer->heap_pos = -1;
+    timer_heap[pos] = timer_heap[--timer_count];
+    if (pos < timer_count) {
+        /* the replacement may have to move in either direction */
+        timer_heap[pos]->heap_pos = pos;
+        timer_sift_up(pos);
+        timer_sift_down(pos);
+    }
 }
 
 /*
@@ -328,22 +415,24 @@ AdjustWaitForDelay(void *waitTime, int newdelay)
 }
 
 static inline Bool timer_pending(OsTimerPtr timer) {
-    return !xorg_list_is_empty(&timer->list);
+    return timer->heap_pos >= 0;
 }
 
 /* If time has rewound, re-run every affected timer.
- * Timers might drop out of the list, so we have to restart every time. */
+ * Timers might drop out of the heap, so we have to restart every time. */
 static void
 CheckAllTimers(void)
 {
-    OsTimerPtr timer;
     CARD32 now;
+    int i;
 
     input_lock();
  start:
     now = GetTimeInMillis();
 
-    xorg_list_for_each_entry(timer, &timers, list) {
+    for (i = 0; i < timer_count; i++) {
+        OsTimerPtr timer = timer_heap[i];
+
         if (timer->expires - now > timer->delta + 250) {
             DoTimer(timer, now);
             goto start;
@@ -357,7 +446,7 @@ DoTimer(OsTimerPtr timer, CARD32 now)
 {
     CARD32 newTime;
 
-    xorg_list_del(&timer->list);
+    timer_remove(timer);
     newTime = (*timer->callback) (timer, now, timer->arg);
     if (newTime)
         TimerSet(timer, 0, newTime, timer->callback, timer->arg);
@@ -381,19 +470,18 @@ OsTimerPtr
 TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
          OsTimerCallback func, void *arg)
 {
-    OsTimerPtr existing;
     CARD32 now = GetTimeInMillis();
 
     if (!timer) {
         timer = calloc(1, sizeof(struct _OsTimerRec));
         if (!timer)
             return NULL;
-        xorg_list_init(&timer->list);
+        timer->heap_pos = -1;
     }
     else {
         input_lock();
         if (timer_pending(timer)) {
-            xorg_list_del(&timer->list);
+            timer_remove(timer);
             if (flags & TimerForceOld)
                 (void) (*timer->callback) (timer, now, timer->arg);
         }
@@ -413,12 +501,7 @@ TimerSet(OsTimerPtr timer, int flags, CARD32 millis,
     timer->arg = arg;
     input_lock();
 
-    /* Sort into list */
-    xorg_list_for_each_entry(existing, &timers, list)
-        if ((int) (existing->expires - millis) > 0)
-            break;
-    /* This even works at the end of the list -- existing->list will be timers */
-    xorg_list_append(&timer->list, &existing->list);
+    timer_insert(timer);
 
     /* Check to see if the timer is ready to run now */
     if ((int) (millis - now) <= 0)
@@ -447,7 +530,8 @@ TimerCancel(OsTimerPtr timer)
     if (!timer)
         return;
     input_lock();
-    xorg_list_del(&timer->list);
+    if (timer_pending(timer))
+        timer_remove(timer);
     input_unlock();
 }
 
@@ -469,16 +553,10 @@ TimerCheck(void)
 void
 TimerInit(void)
 {
-    static Bool been_here;
-    OsTimerPtr timer, tmp;
-
-    if (!been_here) {
-        been_here = TRUE;
-        xorg_list_init((struct xorg_list*) &timers);
-    }
+    while (timer_count) {
+        OsTimerPtr timer = timer_heap[0];
 
-    xorg_list_for_each_entry_safe(timer, tmp, &timers, list) {
-        xorg_list_del(&timer->list);
+        timer_remove(timer);
         free(timer);
     }
 }
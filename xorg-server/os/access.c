@@ -236,6 +236,64 @@ static int LocalHostEnabled = FALSE;
 static int LocalHostRequested = FALSE;
 static int UsingXdmcp = FALSE;
 
+/*
+ * Per-address verdict cache for InvalidHost.  Clients that reconnect
+ * in storms pay the linear validhosts walk once per address instead of
+ * once per connection; any change to validhosts flushes the cache.
+ * Only plain network families are cached: FamilyLocal also depends on
+ * selfhosts, and FamilyServerInterpreted entries may match on client
+ * state or name resolution, so while any are installed the cache is
+ * bypassed entirely (see siHostCount).
+ */
+
+#define ACCESS_CACHE_BUCKETS	64      /* power of two */
+#define ACCESS_CACHE_MAX_ADDR	16      /* fits an IPv6 address */
+#define ACCESS_CACHE_MAX_ENTRIES 1024
+
+typedef struct _accessCacheEntry {
+    struct _accessCacheEntry *next;
+    short family;
+    short len;
+    unsigned char addr[ACCESS_CACHE_MAX_ADDR];
+    int invalid;
+} AccessCacheEntry;
+
+static AccessCacheEntry *accessCache[ACCESS_CACHE_BUCKETS];
+static int accessCacheEntries = 0;
+
+/* FamilyServerInterpreted entries currently in validhosts */
+static int siHostCount = 0;
+
+static unsigned
+AccessCacheHash(int family, const unsigned char *addr, int len)
+{
+    unsigned hash = (unsigned) family;
+    int i;
+
+    for (i = 0; i < len; i++)
+        hash = hash * 31 + addr[i];
+    return hash & (ACCESS_CACHE_BUCKETS - 1);
+}
+
+static void
+AccessCacheFlush(void)
+{
+    int i;
+
+    for (i = 0; i < ACCESS_CACHE_BUCKETS; i++) {
+        AccessCacheEntry *ent = accessCache[i];
+
+        while (ent) {
+            AccessCacheEntry *next = ent->next;
+
+            free(ent);
+            ent = next;
+        }
+        accessCache[i] = NULL;
+    }
+    accessCacheEntries = 0;
+}
+
 static enum {
     LOCAL_ACCESS_SCOPE_HOST = 0,
 #ifndef NO_LOCAL_CLIENT_CRED
@@ -1038,6 +1096,8 @@ ResetHosts(const char *display)
         validhosts = host->next;
         FreeHost(host);
     }
+    siHostCount = 0;
+    AccessCacheFlush();
 
 #if defined WIN32 && defined __MINGW32__
 #define ETC_HOST_PREFIX "X"
@@ -1472,6 +1532,9 @@ NewHost(int family, const void *addr, int len, int addingLocalHosts)
     memcpy(host->addr, addr, len);
     host->next = validhosts;
     validhosts = host;
+    if (family == FamilyServerInterpreted)
+        siHostCount++;
+    AccessCacheFlush();
     return TRUE;
 }
 
@@ -1519,7 +1582,10 @@ RemoveHost(ClientPtr client, int family, unsigned length,       /* of bytes in p
          prev = &host->next);
     if (host) {
         *prev = host->next;
+        if (host->family == FamilyServerInterpreted)
+            siHostCount--;
         FreeHost(host);
+        AccessCacheFlush();
     }
     return Success;
 }
@@ -1600,21 +1666,14 @@ CheckAddr(int family, const void *pAddr, unsigned length)
     return len;
 }
 
-/* Check if a host is not in the access control list.
+/* Walk the lists for an address the cache could not answer.
  * Returns 1 if host is invalid, 0 if we've found it. */
 
-int
-InvalidHost(register struct sockaddr *saddr, int len, ClientPtr client)
+static int
+CheckInvalidHost(int family, void *addr, int len, ClientPtr client)
 {
-    int family;
-    void *addr = NULL;
     register HOST *selfhost, *host;
 
-    if (!AccessEnabled)         /* just let them in */
-        return 0;
-    family = ConvertAddr(saddr, &len, (void **) &addr);
-    if (family == -1)
-        return 1;
     if (family == FamilyLocal) {
         if (!LocalHostEnabled) {
             /*
@@ -1647,6 +1706,55 @@ InvalidHost(register struct sockaddr *saddr, int len, ClientPtr client)
     return 1;
 }
 
+/* Check if a host is not in the access control list.
+ * Returns 1 if host is invalid, 0 if we've found it. */
+
+int
+InvalidHost(register struct sockaddr *saddr, int len, ClientPtr client)
+{
+    int family;
+    void *addr = NULL;
+    AccessCacheEntry *ent;
+    unsigned bucket;
+    int cacheable;
+    int invalid;
+
+    if (!AccessEnabled)         /* just let them in */
+        return 0;
+    family = ConvertAddr(saddr, &len, (void **) &addr);
+    if (family == -1)
+        return 1;
+
+    cacheable = (siHostCount == 0 && addr != NULL
+                 && len <= ACCESS_CACHE_MAX_ADDR);
+    if (cacheable) {
+        bucket = AccessCacheHash(family, addr, len);
+        for (ent = accessCache[bucket]; ent; ent = ent->next)
+            if (ent->family == family && ent->len == len
+                && memcmp(ent->addr, addr, len) == 0)
+                return ent->invalid;
+    }
+
+    invalid = CheckInvalidHost(family, addr, len, client);
+
+    if (cacheable) {
+        if (accessCacheEntries >= ACCESS_CACHE_MAX_ENTRIES)
+            AccessCacheFlush();
+        ent = malloc(sizeof(AccessCacheEntry));
+        if (ent) {
+            ent->family = family;
+            ent->len = len;
+            memcpy(ent->addr, addr, len);
+            ent->invalid = invalid;
+            ent->next = accessCache[bucket];
+            accessCache[bucket] = ent;
+            accessCacheEntries++;
+        }
+    }
+
+    return invalid;
+}
+
 static int
 ConvertAddr(register struct sockaddr *saddr, int *len, void **addr)
 {
@@ -327,11 +327,41 @@ GenerateRandomData(int len, char *buf)
 #ifdef HAVE_ARC4RANDOM_BUF
     arc4random_buf(buf, len);
 #else
-    int fd;
-
-    fd = open("/dev/urandom", O_RDONLY);
-    read(fd, buf, len);
-    close(fd);
+    /* keep a pool refilled in one read, so that generating a burst of
+     * cookies (the Security extension hands one to every sandboxed
+     * client at session start) does not open and read /dev/urandom
+     * once per cookie
+     */
+    static char pool[256];
+    static int avail, pos;
+
+    while (len > 0) {
+        int n;
+
+        if (pos == avail) {
+            int fd = open("/dev/urandom", O_RDONLY);
+
+            avail = 0;
+            pos = 0;
+            if (fd >= 0) {
+                avail = read(fd, pool, sizeof(pool));
+                close(fd);
+            }
+            if (avail <= 0) {
+                avail = 0;
+                return;
+            }
+        }
+        n = avail - pos;
+        if (n > len)
+            n = len;
+        memcpy(buf, pool + pos, n);
+        /* spent bytes must not be handed out again */
+        memset(pool + pos, 0, n);
+        pos += n;
+        buf += n;
+        len -= n;
+    }
 #endif
 #endif
 }
@@ -367,6 +367,30 @@ ReadRequestFromClient(ClientPtr client)
         }
         oci->bufcnt += result;
         gotnow += result;
+        /*
+         * A request bigger than the default buffer (big PutImage and
+         * friends) arrives in socket-buffer-sized pieces, and a return
+         * to the scheduler costs a whole poll round trip per piece.
+         * Keep draining what the transport already has until the
+         * request completes or the transport would block; the reads
+         * are bounded by the request length because the buffer was
+         * sized to exactly fit the request.
+         */
+        while (needed > BUFSIZE && gotnow < needed &&
+               oci->bufcnt < oci->size) {
+            result = _XSERVTransRead(oc->trans_conn, oci->buffer + oci->bufcnt,
+                                     oci->size - oci->bufcnt);
+            if (result <= 0) {
+                if ((result < 0) && ETEST(errno)) {
+                    mark_client_not_ready(client);
+                    break;
+                }
+                YieldControlDeath();
+                return -1;
+            }
+            oci->bufcnt += result;
+            gotnow += result;
+        }
         /* free up some space after huge requests */
         if ((oci->size > BUFWATERMARK) &&
             (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE)) {
@@ -494,6 +518,45 @@ WriteFdToClient(ClientPtr client, int fd, Bool do_close)
 #endif
 }
 
+/*****************************************************************
+ * PeekNextRequestMajorOp
+ *    Returns the major opcode of the next request already sitting,
+ *    complete, in the client's input buffer, or -1 if the current
+ *    request is the last one buffered.  The buffer is not altered;
+ *    this only lets dispatch code look one request ahead, e.g. to
+ *    batch runs of identical requests.
+ *
+ **********************/
+
+int
+PeekNextRequestMajorOp(ClientPtr client)
+{
+    OsCommPtr oc = (OsCommPtr) client->osPrivate;
+    ConnectionInputPtr oci;
+    xReq *request;
+    char *bufptr;
+    int gotnow;
+    unsigned int needed;
+
+    if (!oc || !(oci = oc->input) || oci->ignoreBytes > 0)
+        return -1;
+    /* advance past the request currently being executed */
+    bufptr = oci->bufptr + oci->lenLastReq;
+    gotnow = oci->bufcnt + oci->buffer - bufptr;
+    if (gotnow < (int) sizeof(xReq))
+        return -1;
+    request = (xReq *) bufptr;
+    needed = get_req_len(request, client);
+    if (!needed && client->big_requests) {
+        if (gotnow < (int) sizeof(xBigReq))
+            return -1;
+        needed = get_big_req_len(request, client);
+    }
+    if (needed > maxBigRequestSize || gotnow < (int) (needed << 2))
+        return -1;
+    return request->reqType;
+}
+
 /*****************************************************************
  * InsertFakeRequest
  *    Splice a consed up (possibly partial) request in as the next request.
@@ -706,7 +769,7 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
             switch (buf[0]) {
             case X_Reply:
                 rep = (xGenericReply *) buf;
-                if (rep->sequenceNumber == who->sequence) {
+                if (rep->sequenceNumber == (CARD16) who->sequence) {
                     snprintf(info, 127, "Xreply: type: 0x%x data: 0x%x "
                              "len: %i seq#: 0x%x", rep->type, rep->data1,
                              rep->length, rep->sequenceNumber);
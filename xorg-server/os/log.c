@@ -128,11 +128,151 @@ static Bool logSync = FALSE;
 static int logVerbosity = DEFAULT_LOG_VERBOSITY;
 static int logFileVerbosity = DEFAULT_LOG_FILE_VERBOSITY;
 
+/* The larger of logVerbosity and logFileVerbosity, exported so that
+ * hot-path logging macros can drop a message with a single comparison
+ * before evaluating their format arguments (see hw/xwin/winmsg.h). */
+int LogEffectiveVerbosity =
+    (DEFAULT_LOG_VERBOSITY > DEFAULT_LOG_FILE_VERBOSITY)
+    ? DEFAULT_LOG_VERBOSITY : DEFAULT_LOG_FILE_VERBOSITY;
+
 /* Buffer to information logged before the log file is opened. */
 static char *saveBuffer = NULL;
 static int bufferSize = 0, bufferUnused = 0, bufferPos = 0;
 static Bool needBuffer = TRUE;
 
+/*
+ * Asynchronous log writer.  When enabled (XLOG_ASYNC), file output is
+ * staged into a ring buffer drained by a worker thread, so the thread
+ * doing the logging never waits on the disk even with -logverbose
+ * cranked up and XLOG_SYNC set.  Producers only ever hold the mutex
+ * long enough to copy their line into the ring; all fwrite/fflush/
+ * fsync work happens on the worker with the mutex dropped.  Output to
+ * stderr stays synchronous.
+ */
+
+#include <pthread.h>
+
+#define LOG_ASYNC_BUFFER_SIZE	(64 * 1024)
+
+static Bool logAsync = FALSE;   /* enabled via XLOG_ASYNC */
+static Bool logAsyncRunning = FALSE;
+static char logAsyncBuffer[LOG_ASYNC_BUFFER_SIZE];
+static size_t logAsyncHead = 0; /* drain point, owned by the worker */
+static size_t logAsyncTail = 0; /* fill point, owned by producers */
+static pthread_t logAsyncThread;
+static pthread_mutex_t logAsyncMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t logAsyncWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t logAsyncSpace = PTHREAD_COND_INITIALIZER;
+
+static void *
+LogAsyncWorker(void *arg)
+{
+    pthread_mutex_lock(&logAsyncMutex);
+    for (;;) {
+        size_t head, n;
+
+        while (logAsyncHead == logAsyncTail && logAsyncRunning)
+            pthread_cond_wait(&logAsyncWake, &logAsyncMutex);
+        if (logAsyncHead == logAsyncTail && !logAsyncRunning)
+            break;
+
+        /* Largest contiguous run; the region can be read with the
+         * mutex dropped because producers only write into free space
+         * and head does not move until we are done with it.
+         */
+        head = logAsyncHead;
+        if (logAsyncTail > head)
+            n = logAsyncTail - head;
+        else
+            n = LOG_ASYNC_BUFFER_SIZE - head;
+        pthread_mutex_unlock(&logAsyncMutex);
+
+        if (logFile) {
+            fwrite(logAsyncBuffer + head, n, 1, logFile);
+            if (logFlush) {
+                fflush(logFile);
+#ifndef WIN32
+                if (logSync)
+                    fsync(fileno(logFile));
+#endif
+            }
+        }
+
+        pthread_mutex_lock(&logAsyncMutex);
+        logAsyncHead = (head + n) % LOG_ASYNC_BUFFER_SIZE;
+        pthread_cond_broadcast(&logAsyncSpace);
+    }
+    pthread_mutex_unlock(&logAsyncMutex);
+    return NULL;
+}
+
+/* Called with logAsyncMutex held */
+static size_t
+LogAsyncFree(void)
+{
+    return (logAsyncHead + LOG_ASYNC_BUFFER_SIZE - logAsyncTail - 1) %
+        LOG_ASYNC_BUFFER_SIZE;
+}
+
+static Bool
+LogAsyncWrite(const char *buf, size_t len)
+{
+    size_t first;
+
+    if (len >= LOG_ASYNC_BUFFER_SIZE)
+        return FALSE;           /* oversized; let the caller write it */
+
+    pthread_mutex_lock(&logAsyncMutex);
+
+    if (!logAsyncRunning) {
+        if (pthread_create(&logAsyncThread, NULL, LogAsyncWorker, NULL)) {
+            logAsync = FALSE;
+            pthread_mutex_unlock(&logAsyncMutex);
+            return FALSE;
+        }
+        logAsyncRunning = TRUE;
+    }
+
+    /* Wait for the worker rather than dropping output; this only
+     * happens once a full buffer of backlog has built up
+     */
+    while (LogAsyncFree() < len)
+        pthread_cond_wait(&logAsyncSpace, &logAsyncMutex);
+
+    first = LOG_ASYNC_BUFFER_SIZE - logAsyncTail;
+    if (first > len)
+        first = len;
+    memcpy(logAsyncBuffer + logAsyncTail, buf, first);
+    memcpy(logAsyncBuffer, buf + first, len - first);
+    logAsyncTail = (logAsyncTail + len) % LOG_ASYNC_BUFFER_SIZE;
+
+    pthread_cond_signal(&logAsyncWake);
+    pthread_mutex_unlock(&logAsyncMutex);
+    return TRUE;
+}
+
+/*
+ * Drop back to synchronous logging after pushing out everything queued.
+ * Called on the FatalError/AbortServer/LogClose paths so nothing is
+ * lost when the server is going down and so the final messages hit the
+ * disk directly.
+ */
+static void
+LogAsyncShutdown(void)
+{
+    logAsync = FALSE;
+
+    if (!logAsyncRunning)
+        return;
+
+    pthread_mutex_lock(&logAsyncMutex);
+    while (logAsyncHead != logAsyncTail) {
+        pthread_cond_signal(&logAsyncWake);
+        pthread_cond_wait(&logAsyncSpace, &logAsyncMutex);
+    }
+    pthread_mutex_unlock(&logAsyncMutex);
+}
+
 #ifdef __APPLE__
 static char __crashreporter_info_buff__[4096] = { 0 };
 
@@ -344,6 +484,14 @@ LogSetDisplay(void)
 void
 LogClose(enum ExitCode error)
 {
+    LogAsyncShutdown();
+    if (logAsyncRunning) {
+        pthread_mutex_lock(&logAsyncMutex);
+        logAsyncRunning = FALSE;
+        pthread_cond_signal(&logAsyncWake);
+        pthread_mutex_unlock(&logAsyncMutex);
+        pthread_join(logAsyncThread, NULL);
+    }
     if (logFile) {
         int msgtype = (error == EXIT_NO_ERROR) ? X_INFO : X_ERROR;
         LogMessageVerbSigSafe(msgtype, -1,
@@ -366,11 +514,21 @@ LogSetParameter(LogParameter param, int value)
     case XLOG_SYNC:
         logSync = value ? TRUE : FALSE;
         return TRUE;
+    case XLOG_ASYNC:
+        if (value)
+            logAsync = TRUE;
+        else
+            LogAsyncShutdown();
+        return TRUE;
     case XLOG_VERBOSITY:
         logVerbosity = value;
+        LogEffectiveVerbosity = (logVerbosity > logFileVerbosity)
+            ? logVerbosity : logFileVerbosity;
         return TRUE;
     case XLOG_FILE_VERBOSITY:
         logFileVerbosity = value;
+        LogEffectiveVerbosity = (logVerbosity > logFileVerbosity)
+            ? logVerbosity : logFileVerbosity;
         return TRUE;
     default:
         return FALSE;
@@ -622,13 +780,15 @@ LogSWrite(int verb, const char *buf, size_t len, Bool end_line)
 //            if (newline)
 //                fprintf(logFile, "[%10.3f] ", GetTimeInMillis() / 1000.0);
             newline = end_line;
-            fwrite(buf, len, 1, logFile);
-            if (logFlush) {
-                fflush(logFile);
+            if (!logAsync || !LogAsyncWrite(buf, len)) {
+                fwrite(buf, len, 1, logFile);
+                if (logFlush) {
+                    fflush(logFile);
 #ifndef WIN32
-                if (logSync)
-                    fsync(fileno(logFile));
+                    if (logSync)
+                        fsync(fileno(logFile));
 #endif
+                }
             }
         }
         else if (needBuffer) {
@@ -864,6 +1024,7 @@ AbortServer(void)
 void
 AbortServer(void)
 {
+    LogAsyncShutdown();
 #ifdef XF86BIGFONT
     XF86BigfontCleanup();
 #endif
@@ -985,6 +1146,9 @@ FatalError(const char *f, ...)
     va_list args2;
     static Bool beenhere = FALSE;
 
+    /* Push out anything queued and log the death synchronously */
+    LogAsyncShutdown();
+
     if (beenhere)
         ErrorFSigSafe("\nFatalError re-entered, aborting\n");
     else
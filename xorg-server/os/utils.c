@@ -472,12 +472,30 @@ ForceClockId(clockid_t forced_clockid)
 CARD32
 GetTimeInMillis(void)
 {
-    return GetTickCount();
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    /* QueryPerformanceCounter is monotonic with sub-microsecond
+       resolution, where GetTickCount advances in 10-16 ms steps.  The
+       CARD32 truncation wraps just as GetTickCount did, which the
+       timer code already copes with. */
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (CARD32) ((count.QuadPart / freq.QuadPart) * 1000 +
+                     (count.QuadPart % freq.QuadPart) * 1000 / freq.QuadPart);
 }
 CARD64
 GetTimeInMicros(void)
 {
-    return (CARD64) GetTickCount() * 1000;
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    if (!freq.QuadPart)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (CARD64) (count.QuadPart / freq.QuadPart) * 1000000 +
+           (CARD64) (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
 }
 #else
 CARD32
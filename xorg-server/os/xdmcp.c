@@ -568,16 +568,49 @@ XdmcpRegisterDisplayClass(const char *name, int length)
         DisplayClass.data[i] = (CARD8) name[i];
 }
 
+/*
+ * Only watch the UDP sockets while the state machine actually expects
+ * a response.  During XDM_RUN_SESSION nothing useful can arrive on
+ * them, but stray broadcast traffic on the segment would still wake
+ * the dispatch loop on every packet; unhooking the sockets keeps that
+ * noise out of an active session.
+ */
+
+static Bool xdmcpListening;
+
 static void
-xdmcp_reset(void)
+xdmcp_start_listen(void)
 {
-    timeOutRtx = 0;
+    if (xdmcpListening)
+        return;
     if (xdmcpSocket >= 0)
         SetNotifyFd(xdmcpSocket, XdmcpSocketNotify, X_NOTIFY_READ, NULL);
 #if defined(IPv6) && defined(AF_INET6)
     if (xdmcpSocket6 >= 0)
         SetNotifyFd(xdmcpSocket6, XdmcpSocketNotify, X_NOTIFY_READ, NULL);
 #endif
+    xdmcpListening = TRUE;
+}
+
+static void
+xdmcp_stop_listen(void)
+{
+    if (!xdmcpListening)
+        return;
+    if (xdmcpSocket >= 0)
+        RemoveNotifyFd(xdmcpSocket);
+#if defined(IPv6) && defined(AF_INET6)
+    if (xdmcpSocket6 >= 0)
+        RemoveNotifyFd(xdmcpSocket6);
+#endif
+    xdmcpListening = FALSE;
+}
+
+static void
+xdmcp_reset(void)
+{
+    timeOutRtx = 0;
+    xdmcp_start_listen();
     xdmcp_timer = TimerSet(NULL, 0, 0, XdmcpTimerNotify, NULL);
     send_packet();
 }
@@ -658,6 +691,7 @@ XdmcpOpenDisplay(int sock)
     if (state != XDM_AWAIT_MANAGE_RESPONSE)
         return;
     state = XDM_RUN_SESSION;
+    xdmcp_stop_listen();
     TimerSet(xdmcp_timer, 0, XDM_DEF_DORMANCY * 1000, XdmcpTimerNotify, NULL);
     sessionSocket = sock;
 }
@@ -689,6 +723,7 @@ XdmcpTimerNotify(OsTimerPtr timer, CARD32 time, void *arg)
 {
     if (state == XDM_RUN_SESSION) {
         state = XDM_KEEPALIVE;
+        xdmcp_start_listen();
         send_packet();
     }
     else
@@ -914,6 +949,7 @@ XdmcpDeadSession(const char *reason)
     dispatchException |= (OneSession ? DE_TERMINATE : DE_RESET);
     TimerCancel(xdmcp_timer);
     timeOutRtx = 0;
+    xdmcp_start_listen();
     send_packet();
 }
 
@@ -1429,6 +1465,7 @@ recv_alive_msg(unsigned length)
         XdmcpReadCARD32(&buffer, &AliveSessionID)) {
         if (/*SessionRunning && */ AliveSessionID == SessionID) { // For one reason or another, we always receive 0 for SessionRunning????, even if the session is still running
             state = XDM_RUN_SESSION;
+            xdmcp_stop_listen();
             TimerSet(xdmcp_timer, 0, XDM_DEF_DORMANCY * 1000, XdmcpTimerNotify, NULL);
         }
         else {
@@ -82,10 +82,163 @@
 #include <sys/time.h>                        /* time definitions */
 #include <assert.h>                          /* assertion macros */
 #include <string.h>                          /* string functions */
+#include <stdlib.h>                          /* malloc/realloc */
 #include "xserver_poll.h"
 
 #if defined(WIN32) && !defined(__CYGWIN__)
 #include <X11/Xwinsock.h>
+
+/*
+ * On Windows Vista and later, winsock provides a native poll(),
+ * WSAPoll(), which avoids rebuilding and scanning three fd_sets on
+ * every call and is not bound by FD_SETSIZE.  The entry point is
+ * resolved dynamically so the server still runs on older systems,
+ * where we keep using the select() emulation below, and the constants
+ * and structure are declared locally since the build targets a
+ * _WIN32_WINNT level that predates them.
+ */
+
+#define WS_POLLRDNORM	0x0100
+#define WS_POLLRDBAND	0x0200
+#define WS_POLLWRNORM	0x0010
+#define WS_POLLERR	0x0001
+#define WS_POLLHUP	0x0002
+#define WS_POLLNVAL	0x0004
+
+typedef struct {
+    SOCKET fd;
+    SHORT events;
+    SHORT revents;
+} xwin_wsapollfd;
+
+typedef int (WINAPI * WSAPollProc) (xwin_wsapollfd *, ULONG, INT);
+
+static WSAPollProc
+xserver_get_wsapoll(void)
+{
+    static WSAPollProc fpWSAPoll;
+    static int fResolved;
+
+    if (!fResolved) {
+        HMODULE hmodWinsock = GetModuleHandle("ws2_32.dll");
+
+        if (hmodWinsock != NULL)
+            fpWSAPoll = (WSAPollProc) GetProcAddress(hmodWinsock, "WSAPoll");
+        fResolved = TRUE;
+    }
+    return fpWSAPoll;
+}
+
+/*
+ * A single winsock event object shared by every socket while the
+ * server blocks.  Waiting on it with MsgWaitForMultipleObjectsEx lets
+ * one thread sleep on the sockets and its Win32 message queue
+ * together, so native events wake the server immediately instead of
+ * being noticed by the 1ms polling winBlockHandler otherwise imposes.
+ */
+static WSAEVENT socket_event = WSA_INVALID_EVENT;
+
+int
+xserver_poll_wakes_on_messages(void)
+{
+    if (xserver_get_wsapoll() == NULL)
+        return FALSE;
+    if (socket_event == WSA_INVALID_EVENT)
+        socket_event = WSACreateEvent();
+    return socket_event != WSA_INVALID_EVENT;
+}
+
+static int
+xserver_poll_wsapoll(WSAPollProc fpWSAPoll,
+                     struct pollfd *pArray, nfds_t n_fds, int timeout)
+{
+    /* Translation buffer, reused between calls; the main loop is
+       single threaded */
+    static xwin_wsapollfd *wfds;
+    static nfds_t n_alloc;
+    nfds_t i;
+    int ready;
+
+    if (n_fds > n_alloc) {
+        xwin_wsapollfd *new_wfds = realloc(wfds, n_fds * sizeof(*wfds));
+
+        if (new_wfds == NULL)
+            return -1;
+        wfds = new_wfds;
+        n_alloc = n_fds;
+    }
+
+    for (i = 0; i < n_fds; i++) {
+        wfds[i].fd = (pArray[i].fd < 0) ? INVALID_SOCKET : pArray[i].fd;
+        wfds[i].events = 0;
+        wfds[i].revents = 0;
+        if (pArray[i].events & POLLIN)
+            wfds[i].events |= WS_POLLRDNORM | WS_POLLRDBAND;
+        if (pArray[i].events & POLLOUT)
+            wfds[i].events |= WS_POLLWRNORM;
+        /* POLLPRI is unsupported by WSAPoll and rejected if requested */
+    }
+
+    /* Check readiness without blocking first; anything pending on
+       entry is reported even if its network event fired before the
+       sockets were associated with socket_event below */
+    ready = fpWSAPoll(wfds, n_fds, 0);
+    if (ready < 0)
+        return -1;
+
+    if (ready == 0 && timeout != 0 && xserver_poll_wakes_on_messages()) {
+        DWORD rc;
+
+        for (i = 0; i < n_fds; i++) {
+            long mask = 0;
+
+            if (pArray[i].fd < 0)
+                continue;
+            if (pArray[i].events & POLLIN)
+                mask |= FD_READ | FD_ACCEPT | FD_OOB | FD_CLOSE;
+            if (pArray[i].events & POLLOUT)
+                mask |= FD_WRITE | FD_CONNECT;
+            WSAEventSelect(pArray[i].fd, socket_event, mask);
+        }
+
+        rc = MsgWaitForMultipleObjectsEx(1, &socket_event,
+                                         (timeout < 0) ? INFINITE : timeout,
+                                         QS_ALLINPUT | QS_ALLPOSTMESSAGE,
+                                         MWMO_INPUTAVAILABLE);
+        if (rc == WAIT_OBJECT_0) {
+            WSAResetEvent(socket_event);
+            ready = fpWSAPoll(wfds, n_fds, 0);
+            if (ready < 0)
+                return -1;
+        }
+        /* WAIT_OBJECT_0 + 1 means the message queue has input; return
+           as a timeout would and let the wakeup handler pump it */
+    }
+    else if (ready == 0 && timeout != 0) {
+        /* no event object available; block in the poll itself */
+        ready = fpWSAPoll(wfds, n_fds, timeout);
+        if (ready < 0)
+            return -1;
+    }
+
+    for (i = 0; i < n_fds; i++) {
+        pArray[i].revents = 0;
+        if (pArray[i].fd < 0)
+            continue;
+        if (wfds[i].revents & (WS_POLLRDNORM | WS_POLLRDBAND))
+            pArray[i].revents |= POLLIN;
+        if (wfds[i].revents & WS_POLLWRNORM)
+            pArray[i].revents |= POLLOUT;
+        if (wfds[i].revents & WS_POLLERR)
+            pArray[i].revents |= POLLERR;
+        if (wfds[i].revents & WS_POLLHUP)
+            pArray[i].revents |= POLLHUP;
+        if (wfds[i].revents & WS_POLLNVAL)
+            pArray[i].revents |= POLLNVAL;
+    }
+
+    return ready;
+}
 #endif
 
 /*---------------------------------------------------------------------------*\
@@ -251,6 +404,16 @@ int xserver_poll
     int	    max_fd;                              /* maximum fd value */
     struct  timeval *pTimeout;                   /* actually passed */
 
+#if defined(WIN32) && !defined(__CYGWIN__)
+    {
+        /* Use the native winsock poll when the system has one */
+        WSAPollProc fpWSAPoll = xserver_get_wsapoll();
+
+        if (fpWSAPoll != NULL)
+            return xserver_poll_wsapoll(fpWSAPoll, pArray, n_fds, timeout);
+    }
+#endif
+
     FD_ZERO (&read_descs);
     FD_ZERO (&write_descs);
     FD_ZERO (&except_descs);
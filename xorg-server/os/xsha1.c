@@ -256,20 +256,22 @@ x_sha1_final(void *ctx, unsigned char result[20])
 
 #else                           /* Use OpenSSL's libcrypto */
 
-#include <stddef.h>             /* buggy openssl/sha.h wants size_t */
-#include <openssl/sha.h>
+/* The EVP interface rather than the legacy SHA1_* one: EVP goes
+ * through OpenSSL's runtime dispatch, so builds whose libcrypto
+ * carries the assembly implementations pick up SHA-NI or SSSE3
+ * automatically, and the legacy names are deprecated from 3.0 on */
+#include <stddef.h>             /* buggy openssl/evp.h wants size_t */
+#include <openssl/evp.h>
 
 void *
 x_sha1_init(void)
 {
-    int ret;
-    SHA_CTX *ctx = malloc(sizeof(*ctx));
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
 
     if (!ctx)
         return NULL;
-    ret = SHA1_Init(ctx);
-    if (!ret) {
-        free(ctx);
+    if (!EVP_DigestInit_ex(ctx, EVP_sha1(), NULL)) {
+        EVP_MD_CTX_free(ctx);
         return NULL;
     }
     return ctx;
@@ -279,11 +281,11 @@ int
 x_sha1_update(void *ctx, void *data, int size)
 {
     int ret;
-    SHA_CTX *sha_ctx = ctx;
+    EVP_MD_CTX *md_ctx = ctx;
 
-    ret = SHA1_Update(sha_ctx, data, size);
+    ret = EVP_DigestUpdate(md_ctx, data, size);
     if (!ret)
-        free(sha_ctx);
+        EVP_MD_CTX_free(md_ctx);
     return ret;
 }
 
@@ -291,10 +293,10 @@ int
 x_sha1_final(void *ctx, unsigned char result[20])
 {
     int ret;
-    SHA_CTX *sha_ctx = ctx;
+    EVP_MD_CTX *md_ctx = ctx;
 
-    ret = SHA1_Final(result, sha_ctx);
-    free(sha_ctx);
+    ret = EVP_DigestFinal_ex(md_ctx, result, NULL);
+    EVP_MD_CTX_free(md_ctx);
     return ret;
 }
 
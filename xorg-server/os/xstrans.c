@@ -17,6 +17,11 @@ _X_ATTRIBUTE_PRINTF(1, 2);
 #ifndef TCPCONN
 #define TCPCONN
 #endif
+#if defined(WIN32) && !defined(UNIXCONN)
+/* Windows 10 supports AF_UNIX; on older systems creating the listener
+   fails gracefully and only the TCP transports remain */
+#define UNIXCONN
+#endif
 #ifdef WIN32
 #undef SO_REUSEADDR
 #define SO_BINDRETRYCOUNT 0  // do not try to bind again when it fails, this will speed up searching for a free listening port
@@ -83,6 +83,9 @@ present_execute_copy(present_vblank_ptr vblank, uint64_t crtc_msc)
         return;
     }
 
+    /* frame statistics for the X-Resource frame timing query */
+    FrameTimingRecord(window->drawable.id);
+
     present_copy_region(&window->drawable, vblank->pixmap, vblank->update, vblank->x_off, vblank->y_off);
 
     /* present_copy_region sticks the region into a scratch GC,
@@ -99,6 +99,13 @@ static int pseudoramiXScreensAllocated = 0;
 static int pseudoramiXNumScreens = 0;
 static unsigned long pseudoramiXGeneration = 0;
 
+/* Encoded XineramaQueryScreens payload, rebuilt only when the screen
+   layout changes.  Clients poll XineramaQueryScreens around every
+   window placement, so the steady state must be a straight buffer
+   write. */
+static xXineramaScreenInfo *pseudoramiXReplyCache = NULL;
+static Bool pseudoramiXReplyCacheStale = TRUE;
+
 static void
 PseudoramiXTrace(const char *format, ...)
     _X_ATTRIBUTE_PRINTF(1, 2);
@@ -152,6 +159,8 @@ PseudoramiXAddScreen(int x, int y, int w, int h)
     s->y = y;
     s->w = w;
     s->h = h;
+
+    pseudoramiXReplyCacheStale = TRUE;
 }
 
 // Initialize PseudoramiX.
@@ -207,6 +216,7 @@ PseudoramiXResetScreens(void)
     TRACE;
 
     pseudoramiXNumScreens = 0;
+    pseudoramiXReplyCacheStale = TRUE;
 }
 
 static void
@@ -365,6 +375,26 @@ ProcPseudoramiXQueryScreens(ClientPtr client)
 
     REQUEST_SIZE_MATCH(xXineramaQueryScreensReq);
 
+    /* Re-encode the payload only when the layout has changed */
+    if (!noPseudoramiXExtension && pseudoramiXReplyCacheStale &&
+        pseudoramiXNumScreens) {
+        int i;
+
+        pseudoramiXReplyCache = reallocarray(pseudoramiXReplyCache,
+                                             pseudoramiXNumScreens,
+                                             sizeof(xXineramaScreenInfo));
+        if (!pseudoramiXReplyCache)
+            return BadAlloc;
+
+        for (i = 0; i < pseudoramiXNumScreens; i++) {
+            pseudoramiXReplyCache[i].x_org = pseudoramiXScreens[i].x;
+            pseudoramiXReplyCache[i].y_org = pseudoramiXScreens[i].y;
+            pseudoramiXReplyCache[i].width = pseudoramiXScreens[i].w;
+            pseudoramiXReplyCache[i].height = pseudoramiXScreens[i].h;
+        }
+        pseudoramiXReplyCacheStale = FALSE;
+    }
+
     rep.type = X_Reply;
     rep.sequenceNumber = client->sequence;
     rep.number = noPseudoramiXExtension ? 0 : pseudoramiXNumScreens;
@@ -376,23 +406,24 @@ ProcPseudoramiXQueryScreens(ClientPtr client)
     }
     WriteToClient(client, sizeof(xXineramaQueryScreensReply),&rep);
 
-    if (!noPseudoramiXExtension) {
-        xXineramaScreenInfo scratch;
-        int i;
-
-        for (i = 0; i < pseudoramiXNumScreens; i++) {
-            scratch.x_org = pseudoramiXScreens[i].x;
-            scratch.y_org = pseudoramiXScreens[i].y;
-            scratch.width = pseudoramiXScreens[i].w;
-            scratch.height = pseudoramiXScreens[i].h;
+    if (!noPseudoramiXExtension && pseudoramiXNumScreens) {
+        if (!client->swapped) {
+            WriteToClient(client,
+                          pseudoramiXNumScreens * sz_XineramaScreenInfo,
+                          pseudoramiXReplyCache);
+        }
+        else {
+            xXineramaScreenInfo scratch;
+            int i;
 
-            if (client->swapped) {
+            for (i = 0; i < pseudoramiXNumScreens; i++) {
+                scratch = pseudoramiXReplyCache[i];
                 swaps(&scratch.x_org);
                 swaps(&scratch.y_org);
                 swaps(&scratch.width);
                 swaps(&scratch.height);
+                WriteToClient(client, sz_XineramaScreenInfo,&scratch);
             }
-            WriteToClient(client, sz_XineramaScreenInfo,&scratch);
         }
     }
 
@@ -63,7 +63,14 @@ static RESTYPE RTContext;       /* internal resource type for Record contexts */
 /* How many bytes of protocol data to buffer in a context. Don't set to less
  * than 32.
  */
-#define REPLY_BUF_SIZE 1024
+#define REPLY_BUF_SIZE 8192
+
+/* The FlushCallback leaves buffered protocol under this watermark to
+ * accumulate, so that bursts of small elements reach the recording client
+ * in batches instead of costing one WriteToClient per client flush.
+ * RecordBlockHandler delivers whatever remains before the server sleeps.
+ */
+#define REPLY_BUF_WATERMARK (REPLY_BUF_SIZE / 2)
 
 /* Record Context structure */
 
@@ -76,7 +83,7 @@ typedef struct {
     char elemHeaders;           /* element header flags (time/seq no.) */
     char bufCategory;           /* category of protocol in replyBuffer */
     int numBufBytes;            /* number of bytes in replyBuffer */
-    char replyBuffer[REPLY_BUF_SIZE];   /* buffered recorded protocol */
+    char *replyBuffer;          /* buffered recorded protocol (REPLY_BUF_SIZE) */
     int inFlush;                /*  are we inside RecordFlushReplyBuffer */
 } RecordContextRec, *RecordContextPtr;
 
@@ -124,6 +131,23 @@ typedef struct _RecordClientsAndProtocolRec {
 /* counts the total number of RCAPs belonging to enabled contexts. */
 static int numEnabledRCAPs;
 
+/*  One bit per client ID, set if any enabled context's RCAP lists that
+ *  client (every bit is set if some RCAP records future clients).  The
+ *  reply and delivered-event callbacks fire for all clients in the server
+ *  once a single context is enabled; this filter lets protocol of clients
+ *  nobody is recording cost one bit test instead of a search of every
+ *  enabled context.  Kept up to date by RecordRebuildClientFilter.
+ */
+static unsigned char recordedClientIDs[(MAXCLIENTS + 7) >> 3];
+
+static Bool
+RecordClientMayBeRecorded(ClientPtr pClient)
+{
+    int id = CLIENT_ID(pClient->clientAsMask);
+
+    return (recordedClientIDs[id >> 3] >> (id & 7)) & 1;
+}                               /* RecordClientMayBeRecorded */
+
 /*  void VERIFY_CONTEXT(RecordContextPtr, XID, ClientPtr)
  *  In the spirit of the VERIFY_* macros in dix.h, this macro fills in
  *  the context pointer if the given ID is a valid Record Context, else it
@@ -210,6 +234,42 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
     }
     return -1;
 }                               /* RecordFindContextOnAllContexts */
+
+/* RecordRebuildClientFilter
+ *
+ * Arguments: none.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	recordedClientIDs is recomputed from the RCAPs of all enabled
+ *	contexts.  Must be called after any change to the set of enabled
+ *	contexts or to the client lists of an enabled context's RCAPs.
+ */
+static void
+RecordRebuildClientFilter(void)
+{
+    RecordClientsAndProtocolPtr pRCAP;
+    int eci, i;
+
+    memset(recordedClientIDs, 0, sizeof(recordedClientIDs));
+    for (eci = 0; eci < numEnabledContexts; eci++) {
+        for (pRCAP = ppAllContexts[eci]->pListOfRCAP; pRCAP;
+             pRCAP = pRCAP->pNextRCAP) {
+            for (i = 0; i < pRCAP->numClients; i++) {
+                if (pRCAP->pClientIDs[i] == XRecordFutureClients) {
+                    memset(recordedClientIDs, 0xff, sizeof(recordedClientIDs));
+                    return;
+                }
+                else {
+                    int id = CLIENT_ID(pRCAP->pClientIDs[i]);
+
+                    recordedClientIDs[id >> 3] |= 1 << (id & 7);
+                }
+            }
+        }
+    }
+}                               /* RecordRebuildClientFilter */
 
 /***************************************************************************/
 
@@ -583,6 +643,8 @@ RecordAReply(CallbackListPtr *pcbl, void *nulldata, void *calldata)
     ReplyInfoRec *pri = (ReplyInfoRec *) calldata;
     ClientPtr client = pri->client;
 
+    if (!RecordClientMayBeRecorded(client))
+        return;
     for (eci = 0; eci < numEnabledContexts; eci++) {
         pContext = ppAllContexts[eci];
         pRCAP = RecordFindClientOnContext(pContext, client->clientAsMask, NULL);
@@ -663,6 +725,8 @@ RecordADeliveredEventOrError(CallbackListPtr *pcbl, void *nulldata,
     int eci;                    /* enabled context index */
     ClientPtr pClient = pei->client;
 
+    if (!RecordClientMayBeRecorded(pClient))
+        return;
     for (eci = 0; eci < numEnabledContexts; eci++) {
         pContext = ppAllContexts[eci];
         pRCAP = RecordFindClientOnContext(pContext, pClient->clientAsMask,
@@ -823,12 +887,42 @@ RecordFlushAllContexts(CallbackListPtr *pcbl,
          * this check, but this function could be called very often, so we
          * check before calling hoping to save the function call cost
          * most of the time.
+         *
+         * Buffered protocol under the watermark is left to accumulate;
+         * RecordBlockHandler delivers it before the server sleeps, so
+         * the recording client's latency stays bounded by the dispatch
+         * cycle.
          */
-        if (pContext->numBufBytes)
+        if (pContext->numBufBytes >= REPLY_BUF_WATERMARK)
             RecordFlushReplyBuffer(ppAllContexts[eci], NULL, 0, NULL, 0);
     }
 }                               /* RecordFlushAllContexts */
 
+/* RecordBlockHandler
+ *
+ * Arguments:
+ *	blockData and timeout are unused.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	All buffered reply data of all enabled contexts, including data
+ *	held back by the flush watermark, is written to the recording
+ *	clients.  Runs each time the server is about to block.
+ */
+static void
+RecordBlockHandler(void *blockData, void *timeout)
+{
+    int eci;                    /* enabled context index */
+    RecordContextPtr pContext;
+
+    for (eci = 0; eci < numEnabledContexts; eci++) {
+        pContext = ppAllContexts[eci];
+        if (pContext->numBufBytes)
+            RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
+    }
+}                               /* RecordBlockHandler */
+
 /* RecordInstallHooks
  *
  * Arguments:
@@ -906,10 +1000,13 @@ RecordInstallHooks(RecordClientsAndProtocolPtr pRCAP, XID oneclient)
             return BadAlloc;
         if (!AddCallback(&FlushCallback, RecordFlushAllContexts, NULL))
             return BadAlloc;
-        /* Alternate context flushing scheme: delete the line above
-         * and call RegisterBlockAndWakeupHandlers here passing
-         * RecordFlushAllContexts.  Is this any better?
+        /* The flush callback only delivers buffers that have reached the
+         * watermark; the block handler picks up whatever it held back.
          */
+        if (!RegisterBlockAndWakeupHandlers(RecordBlockHandler,
+                                            (ServerWakeupHandlerProcPtr)
+                                            NoopDDA, NULL))
+            return BadAlloc;
     }
     return Success;
 }                               /* RecordInstallHooks */
@@ -1000,12 +1097,11 @@ RecordUninstallHooks(RecordClientsAndProtocolPtr pRCAP, XID oneclient)
         DeleteCallback(&DeviceEventCallback, RecordADeviceEvent, NULL);
         DeleteCallback(&ReplyCallback, RecordAReply, NULL);
         DeleteCallback(&FlushCallback, RecordFlushAllContexts, NULL);
-        /* Alternate context flushing scheme: delete the line above
-         * and call RemoveBlockAndWakeupHandlers here passing
-         * RecordFlushAllContexts.  Is this any better?
-         */
-        /* Having deleted the callback, call it one last time. -gildea */
-        RecordFlushAllContexts(&FlushCallback, NULL, NULL);
+        RemoveBlockAndWakeupHandlers(RecordBlockHandler,
+                                     (ServerWakeupHandlerProcPtr) NoopDDA,
+                                     NULL);
+        /* Having deleted the handlers, flush one last time. -gildea */
+        RecordBlockHandler(NULL, NULL);
     }
 }                               /* RecordUninstallHooks */
 
@@ -1051,6 +1147,7 @@ RecordDeleteClientFromRCAP(RecordClientsAndProtocolPtr pRCAP, int position)
             free(pRCAP->pClientIDs);
         free(pRCAP);
     }
+    RecordRebuildClientFilter();
 }                               /* RecordDeleteClientFromRCAP */
 
 /* RecordAddClientToRCAP
@@ -1096,8 +1193,10 @@ RecordAddClientToRCAP(RecordClientsAndProtocolPtr pRCAP, XID clientspec)
         }
     }
     pRCAP->pClientIDs[pRCAP->numClients++] = clientspec;
-    if (pRCAP->pContext->pRecordingClient)
+    if (pRCAP->pContext->pRecordingClient) {
         RecordInstallHooks(pRCAP, clientspec);
+        RecordRebuildClientFilter();
+    }
 }                               /* RecordDeleteClientFromRCAP */
 
 /* RecordDeleteClientFromContext
@@ -1795,8 +1894,10 @@ RecordRegisterClients(RecordContextPtr pContext, ClientPtr client,
     pRCAP->pNextRCAP = pContext->pListOfRCAP;
     pContext->pListOfRCAP = pRCAP;
 
-    if (pContext->pRecordingClient)     /* context enabled */
+    if (pContext->pRecordingClient) {   /* context enabled */
         RecordInstallHooks(pRCAP, 0);
+        RecordRebuildClientFilter();
+    }
 
  bailout:
     if (si) {
@@ -1848,6 +1949,9 @@ ProcRecordCreateContext(ClientPtr client)
     pContext = (RecordContextPtr) malloc(sizeof(RecordContextRec));
     if (!pContext)
         goto bailout;
+    pContext->replyBuffer = malloc(REPLY_BUF_SIZE);
+    if (!pContext->replyBuffer)
+        goto bailout;
 
     /* make sure there is room in ppAllContexts to store the new context */
 
@@ -1880,7 +1984,10 @@ ProcRecordCreateContext(ClientPtr client)
         return BadAlloc;
     }
  bailout:
-    free(pContext);
+    if (pContext) {
+        free(pContext->replyBuffer);
+        free(pContext);
+    }
     return err;
 }                               /* ProcRecordCreateContext */
 
@@ -2327,6 +2434,7 @@ ProcRecordEnableContext(ClientPtr client)
 
     ++numEnabledContexts;
     assert(numEnabledContexts > 0);
+    RecordRebuildClientFilter();
 
     /* send StartOfData */
     RecordAProtocolElement(pContext, NULL, XRecordStartOfData, NULL, 0, 0, 0);
@@ -2383,6 +2491,7 @@ RecordDisableContext(RecordContextPtr pContext)
     }
     --numEnabledContexts;
     assert(numEnabledContexts >= 0);
+    RecordRebuildClientFilter();
 }                               /* RecordDisableContext */
 
 static int
@@ -2441,6 +2550,7 @@ RecordDeleteContext(void *value, XID id)
             ppAllContexts = NULL;
         }
     }
+    free(pContext->replyBuffer);
     free(pContext);
 
     return Success;
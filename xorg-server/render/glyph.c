@@ -82,13 +82,257 @@ static GlyphHashSetRec glyphHashSets[] = {
 
 static GlyphHashRec globalGlyphs[GlyphFormatNum];
 
+/*
+ * Glyph headers all have the same allocation size for a given screen
+ * and private configuration, and clients tear down and rebuild entire
+ * glyph sets at once (a browser re-adds its whole set on a DPI
+ * change), so recently freed headers are kept on a free list instead
+ * of being returned to the heap.  The list is drained in GlyphUninit
+ * since the entry size depends on the screen configuration.
+ */
+#define GLYPH_POOL_MAX_ENTRIES 1024
+
+typedef struct _GlyphPoolEntry {
+    struct _GlyphPoolEntry *next;
+} GlyphPoolEntryRec, *GlyphPoolEntryPtr;
+
+static GlyphPoolEntryPtr glyphPool;
+static int glyphPoolEntries;
+static int glyphPoolEntrySize;
+
+static void
+FreeGlyphStorage(GlyphPtr glyph)
+{
+    int size = glyph->size - sizeof(xGlyphInfo);
+
+    if (glyphPoolEntries < GLYPH_POOL_MAX_ENTRIES &&
+        size >= (int) sizeof(GlyphPoolEntryRec) &&
+        (glyphPoolEntries == 0 || size == glyphPoolEntrySize)) {
+        GlyphPoolEntryPtr entry = (GlyphPoolEntryPtr) glyph;
+
+        dixFiniPrivates(glyph, PRIVATE_GLYPH);
+        entry->next = glyphPool;
+        glyphPool = entry;
+        glyphPoolEntries++;
+        glyphPoolEntrySize = size;
+        return;
+    }
+    dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
+}
+
+/*
+ * Glyph atlas: frequently used glyphs are packed into a shared pixmap
+ * per screen and picture format, so that compositing a text run keeps
+ * reusing one source/mask picture instead of validating and fetching a
+ * separate one-glyph picture per character.  Glyphs are placed with a
+ * simple shelf packer; when the atlas fills up it is reset wholesale,
+ * which is cheap because repopulating it is just one PictOpSrc blt per
+ * glyph the next time each glyph is drawn.
+ */
+
+#define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
+
+#define GLYPH_ATLAS_SIZE	1024
+#define GLYPH_ATLAS_MAX_GLYPH	128     /* bigger glyphs keep their own picture */
+#define GLYPH_ATLAS_HASH_SIZE	1024    /* power of two; open addressing */
+
+typedef struct _GlyphAtlasEntry {
+    GlyphPtr glyph;             /* NULL empty, DeletedGlyph tombstone */
+    INT16 x, y;
+} GlyphAtlasEntryRec, *GlyphAtlasEntryPtr;
+
+typedef struct _GlyphAtlas {
+    struct _GlyphAtlas *next;
+    PictFormatPtr format;
+    PixmapPtr pPixmap;
+    PicturePtr pPicture;
+    int curX, curY, rowHeight;
+    int tableEntries;
+    GlyphAtlasEntryRec table[GLYPH_ATLAS_HASH_SIZE];
+} GlyphAtlasRec, *GlyphAtlasPtr;
+
+static GlyphAtlasPtr glyphAtlases[MAXSCREENS];
+
+static GlyphAtlasEntryPtr
+GlyphAtlasFindEntry(GlyphAtlasPtr atlas, GlyphPtr glyph)
+{
+    CARD32 elt = ((CARD32) ((uintptr_t) glyph >> 4) * 2654435761u) &
+        (GLYPH_ATLAS_HASH_SIZE - 1);
+    GlyphAtlasEntryPtr entry, del = 0;
+
+    for (;;) {
+        entry = &atlas->table[elt];
+        if (!entry->glyph)
+            return del ? del : entry;
+        if (entry->glyph == DeletedGlyph) {
+            if (!del)
+                del = entry;
+            else if (entry == del)
+                return del;
+        }
+        else if (entry->glyph == glyph)
+            return entry;
+        elt = (elt + 1) & (GLYPH_ATLAS_HASH_SIZE - 1);
+    }
+}
+
+static void
+GlyphAtlasReset(GlyphAtlasPtr atlas)
+{
+    memset(atlas->table, 0, sizeof(atlas->table));
+    atlas->tableEntries = 0;
+    atlas->curX = 0;
+    atlas->curY = 0;
+    atlas->rowHeight = 0;
+}
+
+static void
+GlyphAtlasDestroy(GlyphAtlasPtr atlas)
+{
+    ScreenPtr pScreen = atlas->pPixmap->drawable.pScreen;
+
+    FreePicture((void *) atlas->pPicture, 0);
+    (*pScreen->DestroyPixmap) (atlas->pPixmap);
+    free(atlas);
+}
+
+static GlyphAtlasPtr
+GlyphAtlasForFormat(ScreenPtr pScreen, PictFormatPtr format)
+{
+    GlyphAtlasPtr atlas;
+    PixmapPtr pPixmap;
+    PicturePtr pPicture;
+    CARD32 component_alpha;
+    int error;
+
+    for (atlas = glyphAtlases[pScreen->myNum]; atlas; atlas = atlas->next)
+        if (atlas->format == format)
+            return atlas;
+
+    atlas = calloc(1, sizeof(GlyphAtlasRec));
+    if (!atlas)
+        return NULL;
+    pPixmap = (*pScreen->CreatePixmap) (pScreen,
+                                        GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE,
+                                        format->depth,
+                                        CREATE_PIXMAP_USAGE_SCRATCH);
+    if (!pPixmap) {
+        free(atlas);
+        return NULL;
+    }
+    component_alpha = NeedsComponent(format->format);
+    pPicture = CreatePicture(0, &pPixmap->drawable, format,
+                             CPComponentAlpha, &component_alpha,
+                             serverClient, &error);
+    if (!pPicture) {
+        (*pScreen->DestroyPixmap) (pPixmap);
+        free(atlas);
+        return NULL;
+    }
+    atlas->format = format;
+    atlas->pPixmap = pPixmap;
+    atlas->pPicture = pPicture;
+    atlas->next = glyphAtlases[pScreen->myNum];
+    glyphAtlases[pScreen->myNum] = atlas;
+    return atlas;
+}
+
+/*
+ * Locate glyph in the atlas for its picture format, adding it if
+ * missing.  On success, *pAtlasPicture/*xAtlas/*yAtlas identify the
+ * glyph bits within the atlas; on failure the caller composites from
+ * the per-glyph picture as before.
+ */
+static Bool
+GlyphAtlasPosition(ScreenPtr pScreen, GlyphPtr glyph, PicturePtr pGlyphPicture,
+                   PicturePtr *pAtlasPicture, int *xAtlas, int *yAtlas)
+{
+    GlyphAtlasPtr atlas;
+    GlyphAtlasEntryPtr entry;
+
+    if (glyph->info.width > GLYPH_ATLAS_MAX_GLYPH ||
+        glyph->info.height > GLYPH_ATLAS_MAX_GLYPH)
+        return FALSE;
+
+    atlas = GlyphAtlasForFormat(pScreen, pGlyphPicture->pFormat);
+    if (!atlas)
+        return FALSE;
+
+    entry = GlyphAtlasFindEntry(atlas, glyph);
+    if (entry->glyph != glyph) {
+        /* Shelf packing; wrap to a new row, reset when out of rows or
+         * when the hash gets too full to probe efficiently
+         */
+        if (atlas->curX + glyph->info.width > GLYPH_ATLAS_SIZE) {
+            atlas->curX = 0;
+            atlas->curY += atlas->rowHeight;
+            atlas->rowHeight = 0;
+        }
+        if (atlas->curY + glyph->info.height > GLYPH_ATLAS_SIZE ||
+            atlas->tableEntries >= (3 * GLYPH_ATLAS_HASH_SIZE) / 4) {
+            GlyphAtlasReset(atlas);
+            entry = GlyphAtlasFindEntry(atlas, glyph);
+        }
+        CompositePicture(PictOpSrc,
+                         pGlyphPicture,
+                         None,
+                         atlas->pPicture,
+                         0, 0,
+                         0, 0,
+                         atlas->curX, atlas->curY,
+                         glyph->info.width, glyph->info.height);
+        if (!entry->glyph || entry->glyph == DeletedGlyph)
+            atlas->tableEntries++;
+        entry->glyph = glyph;
+        entry->x = atlas->curX;
+        entry->y = atlas->curY;
+        atlas->curX += glyph->info.width;
+        if (glyph->info.height > atlas->rowHeight)
+            atlas->rowHeight = glyph->info.height;
+    }
+    *pAtlasPicture = atlas->pPicture;
+    *xAtlas = entry->x;
+    *yAtlas = entry->y;
+    return TRUE;
+}
+
+static void
+GlyphAtlasRemoveGlyph(GlyphPtr glyph)
+{
+    GlyphAtlasPtr atlas;
+    GlyphAtlasEntryPtr entry;
+    int i;
+
+    for (i = 0; i < screenInfo.numScreens; i++)
+        for (atlas = glyphAtlases[i]; atlas; atlas = atlas->next) {
+            entry = GlyphAtlasFindEntry(atlas, glyph);
+            if (entry->glyph == glyph)
+                entry->glyph = DeletedGlyph;
+        }
+}
+
 void
 GlyphUninit(ScreenPtr pScreen)
 {
     PictureScreenPtr ps = GetPictureScreen(pScreen);
     GlyphPtr glyph;
+    GlyphAtlasPtr atlas;
     int fdepth, i;
 
+    while ((atlas = glyphAtlases[pScreen->myNum])) {
+        glyphAtlases[pScreen->myNum] = atlas->next;
+        GlyphAtlasDestroy(atlas);
+    }
+
+    /* the pooled glyph headers are sized for this screen configuration */
+    while (glyphPool) {
+        GlyphPoolEntryPtr entry = glyphPool;
+
+        glyphPool = entry->next;
+        free(entry);
+    }
+    glyphPoolEntries = 0;
+
     for (fdepth = 0; fdepth < GlyphFormatNum; fdepth++) {
         if (!globalGlyphs[fdepth].hashSet)
             continue;
@@ -233,6 +477,8 @@ FreeGlyphPicture(GlyphPtr glyph)
     PictureScreenPtr ps;
     int i;
 
+    GlyphAtlasRemoveGlyph(glyph);
+
     for (i = 0; i < screenInfo.numScreens; i++) {
         ScreenPtr pScreen = screenInfo.screens[i];
 
@@ -274,7 +520,7 @@ FreeGlyph(GlyphPtr glyph, int format)
         }
 
         FreeGlyphPicture(glyph);
-        dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
+        FreeGlyphStorage(glyph);
     }
 }
 
@@ -291,7 +537,7 @@ AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
                       TRUE, glyph->sha1);
     if (gr->glyph && gr->glyph != DeletedGlyph && gr->glyph != glyph) {
         FreeGlyphPicture(glyph);
-        dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
+        FreeGlyphStorage(glyph);
         glyph = gr->glyph;
     }
     else if (gr->glyph != glyph) {
@@ -351,7 +597,13 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
 
     head_size = sizeof(GlyphRec) + screenInfo.numScreens * sizeof(PicturePtr);
     size = (head_size + dixPrivatesSize(PRIVATE_GLYPH));
-    glyph = (GlyphPtr) malloc(size);
+    if (glyphPoolEntries && glyphPoolEntrySize == size) {
+        glyph = (GlyphPtr) glyphPool;
+        glyphPool = glyphPool->next;
+        glyphPoolEntries--;
+    }
+    else
+        glyph = (GlyphPtr) malloc(size);
     if (!glyph)
         return 0;
     glyph->refcnt = 0;
@@ -379,7 +631,7 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
             (*ps->UnrealizeGlyph) (screenInfo.screens[i], glyph);
     }
 
-    dixFreeObjectWithPrivates(glyph, PRIVATE_GLYPH);
+    FreeGlyphStorage(glyph);
     return 0;
 }
 
@@ -541,8 +793,6 @@ GlyphExtents(int nlist, GlyphListPtr list, GlyphPtr * glyphs, BoxPtr extents)
     }
 }
 
-#define NeedsComponent(f) (PICT_FORMAT_A(f) != 0 && PICT_FORMAT_RGB(f) != 0)
-
 void
 CompositeGlyphs(CARD8 op,
                 PicturePtr pSrc,
@@ -639,12 +889,17 @@ miGlyphs(CARD8 op,
             pPicture = GetGlyphPicture(glyph, pScreen);
 
             if (pPicture) {
+                PicturePtr pGlyphSrc = pPicture;
+                int xGlyphSrc = 0, yGlyphSrc = 0;
+
+                GlyphAtlasPosition(pScreen, glyph, pPicture,
+                                   &pGlyphSrc, &xGlyphSrc, &yGlyphSrc);
                 if (maskFormat) {
                     CompositePicture(PictOpAdd,
-                                     pPicture,
+                                     pGlyphSrc,
                                      None,
                                      pMask,
-                                     0, 0,
+                                     xGlyphSrc, yGlyphSrc,
                                      0, 0,
                                      x - glyph->info.x,
                                      y - glyph->info.y,
@@ -653,11 +908,11 @@ miGlyphs(CARD8 op,
                 else {
                     CompositePicture(op,
                                      pSrc,
-                                     pPicture,
+                                     pGlyphSrc,
                                      pDst,
                                      xSrc + (x - glyph->info.x) - xDst,
                                      ySrc + (y - glyph->info.y) - yDst,
-                                     0, 0,
+                                     xGlyphSrc, yGlyphSrc,
                                      x - glyph->info.x,
                                      y - glyph->info.y,
                                      glyph->info.width, glyph->info.height);
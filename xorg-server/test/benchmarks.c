@@ -0,0 +1,289 @@
+/*
+ * Microbenchmarks for fb, composite and region hot paths.
+ *
+ * Drives the blit (fbBlt), composite (pixman, which backs fbComposite)
+ * and region-operation kernels directly over synthetic buffers, without
+ * a running server, and prints one JSON document on stdout so results
+ * can be recorded and diffed between builds.  This is not part of the
+ * unit test suite; build the 'benchmarks' executable and run it by
+ * hand, or use meson's benchmark runner.
+ */
+
+/* Benchmark relies on assert() */
+#undef NDEBUG
+
+#ifdef HAVE_DIX_CONFIG_H
+#include <dix-config.h>
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <X11/Xwindows.h>
+#else
+#include <time.h>
+#endif
+
+#include "dix.h"
+#include "fb.h"
+#include "regionstr.h"
+
+#define BENCH_WIDTH     1024
+#define BENCH_HEIGHT    1024
+#define BENCH_BPP       32
+#define BENCH_STRIDE    (BENCH_WIDTH * (BENCH_BPP / 8) / sizeof(FbBits))
+
+/* Grid mimicking a tiled terminal layout, for the region benchmarks */
+#define GRID_COLS       40
+#define GRID_ROWS       25
+#define GRID_CELL_W     24
+#define GRID_CELL_H     16
+#define GRID_GAP        2
+
+static double
+now_ns(void)
+{
+#ifdef WIN32
+    LARGE_INTEGER freq, count;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double) count.QuadPart * 1e9 / (double) freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1e9 + (double) ts.tv_nsec;
+#endif
+}
+
+static Bool first_result = TRUE;
+
+/*
+ * Emit one result object.  pixels is the number of pixels (or region
+ * boxes, for the region benchmarks) processed per iteration, so the
+ * derived rate survives changes to the iteration counts.
+ */
+static void
+report(const char *name, int iterations, double total_ns, double pixels)
+{
+    double per_op = total_ns / iterations;
+
+    printf("%s\n        { \"name\": \"%s\", \"iterations\": %d, "
+           "\"ns_per_op\": %.1f, \"mpix_per_s\": %.2f }",
+           first_result ? "" : ",", name, iterations, per_op,
+           pixels * iterations / (total_ns / 1e3));
+    first_result = FALSE;
+}
+
+static FbBits *
+make_bits(unsigned int seed)
+{
+    FbBits *bits = malloc(BENCH_STRIDE * BENCH_HEIGHT * sizeof(FbBits));
+    int i;
+
+    assert(bits);
+    /* Cheap LCG fill; contents only need to be nonuniform */
+    for (i = 0; i < BENCH_STRIDE * BENCH_HEIGHT; i++) {
+        seed = seed * 1103515245 + 12345;
+        bits[i] = seed;
+    }
+    return bits;
+}
+
+static void
+bench_blt(void)
+{
+    FbBits *src = make_bits(1);
+    FbBits *dst = make_bits(2);
+    static const struct {
+        const char *name;
+        int srcX, dstX;         /* in bits */
+        int alu;
+    } cases[] = {
+        {"fbblt/copy/aligned", 0, 0, GXcopy},
+        {"fbblt/copy/unaligned", 32, 0, GXcopy},
+        {"fbblt/xor/aligned", 0, 0, GXxor},
+    };
+    int c;
+
+    for (c = 0; c < ARRAY_SIZE(cases); c++) {
+        const int iterations = 64;
+        double start;
+        int i;
+
+        /* Warm caches and page in the buffers */
+        fbBlt(src, BENCH_STRIDE, cases[c].srcX,
+              dst, BENCH_STRIDE, cases[c].dstX,
+              (BENCH_WIDTH - 2) * BENCH_BPP, BENCH_HEIGHT,
+              cases[c].alu, FB_ALLONES, BENCH_BPP, FALSE, FALSE);
+
+        start = now_ns();
+        for (i = 0; i < iterations; i++)
+            fbBlt(src, BENCH_STRIDE, cases[c].srcX,
+                  dst, BENCH_STRIDE, cases[c].dstX,
+                  (BENCH_WIDTH - 2) * BENCH_BPP, BENCH_HEIGHT,
+                  cases[c].alu, FB_ALLONES, BENCH_BPP, FALSE, FALSE);
+        report(cases[c].name, iterations, now_ns() - start,
+               (double) (BENCH_WIDTH - 2) * BENCH_HEIGHT);
+    }
+
+    free(src);
+    free(dst);
+}
+
+/*
+ * The render path bottoms out in pixman_image_composite(), so timing
+ * pixman directly over synthetic images tracks the fbComposite cost
+ * without needing picture and screen infrastructure.
+ */
+static void
+bench_composite(void)
+{
+    pixman_image_t *src, *dst, *mask;
+    uint32_t *src_bits = (uint32_t *) make_bits(3);
+    uint32_t *dst_bits = (uint32_t *) make_bits(4);
+    uint8_t *mask_bits = malloc(32 * 32);
+    static const struct {
+        const char *name;
+        pixman_op_t op;
+        Bool use_mask;
+        int width, height;
+    } cases[] = {
+        {"composite/over/argb-on-xrgb", PIXMAN_OP_OVER, FALSE,
+         BENCH_WIDTH, BENCH_HEIGHT},
+        {"composite/src/argb-on-xrgb", PIXMAN_OP_SRC, FALSE,
+         BENCH_WIDTH, BENCH_HEIGHT},
+        {"composite/over/a8-glyph", PIXMAN_OP_OVER, TRUE, 32, 32},
+    };
+    int c, i;
+
+    assert(mask_bits);
+    for (i = 0; i < 32 * 32; i++)
+        mask_bits[i] = (uint8_t) (i * 7);
+
+    src = pixman_image_create_bits(PIXMAN_a8r8g8b8, BENCH_WIDTH, BENCH_HEIGHT,
+                                   src_bits, BENCH_WIDTH * 4);
+    dst = pixman_image_create_bits(PIXMAN_x8r8g8b8, BENCH_WIDTH, BENCH_HEIGHT,
+                                   dst_bits, BENCH_WIDTH * 4);
+    mask = pixman_image_create_bits(PIXMAN_a8, 32, 32, (uint32_t *) mask_bits,
+                                    32);
+    assert(src && dst && mask);
+
+    for (c = 0; c < ARRAY_SIZE(cases); c++) {
+        /* The glyph-sized case needs many more iterations to get a
+           measurable total */
+        const int iterations = cases[c].use_mask ? 16384 : 64;
+        double start;
+
+        pixman_image_composite(cases[c].op, src,
+                               cases[c].use_mask ? mask : NULL, dst,
+                               0, 0, 0, 0, 0, 0,
+                               cases[c].width, cases[c].height);
+
+        start = now_ns();
+        for (i = 0; i < iterations; i++)
+            pixman_image_composite(cases[c].op, src,
+                                   cases[c].use_mask ? mask : NULL, dst,
+                                   0, 0, 0, 0, 0, 0,
+                                   cases[c].width, cases[c].height);
+        report(cases[c].name, iterations, now_ns() - start,
+               (double) cases[c].width * cases[c].height);
+    }
+
+    pixman_image_unref(src);
+    pixman_image_unref(dst);
+    pixman_image_unref(mask);
+    free(src_bits);
+    free(dst_bits);
+    free(mask_bits);
+}
+
+/* Build a GRID_COLS x GRID_ROWS grid of boxes, offset by (dx, dy) */
+static void
+make_grid_region(RegionPtr pRegion, int dx, int dy)
+{
+    int row, col;
+
+    RegionNull(pRegion);
+    for (row = 0; row < GRID_ROWS; row++)
+        for (col = 0; col < GRID_COLS; col++) {
+            BoxRec box;
+            RegionRec cell;
+
+            box.x1 = dx + col * (GRID_CELL_W + GRID_GAP);
+            box.y1 = dy + row * (GRID_CELL_H + GRID_GAP);
+            box.x2 = box.x1 + GRID_CELL_W;
+            box.y2 = box.y1 + GRID_CELL_H;
+            RegionInit(&cell, &box, 1);
+            RegionUnion(pRegion, pRegion, &cell);
+            RegionUninit(&cell);
+        }
+}
+
+/*
+ * Region operations are the dominant cost of window tree validation
+ * (miValidateTree is all clip list arithmetic), so fragmented-region
+ * intersect/union/subtract stands in for it here; validation proper
+ * needs a live window tree.
+ */
+static void
+bench_region(void)
+{
+    RegionRec grid, shifted, result;
+    static const struct {
+        const char *name;
+        int op;                 /* 0 intersect, 1 union, 2 subtract */
+    } cases[] = {
+        {"region/intersect/grid", 0},
+        {"region/union/grid", 1},
+        {"region/subtract/grid", 2},
+    };
+    int c, i;
+
+    make_grid_region(&grid, 0, 0);
+    /* Half-cell offset so every box pair partially overlaps */
+    make_grid_region(&shifted, GRID_CELL_W / 2, GRID_CELL_H / 2);
+    RegionNull(&result);
+
+    for (c = 0; c < ARRAY_SIZE(cases); c++) {
+        const int iterations = 1024;
+        double start = now_ns();
+
+        for (i = 0; i < iterations; i++) {
+            switch (cases[c].op) {
+            case 0:
+                RegionIntersect(&result, &grid, &shifted);
+                break;
+            case 1:
+                RegionUnion(&result, &grid, &shifted);
+                break;
+            case 2:
+                RegionSubtract(&result, &grid, &shifted);
+                break;
+            }
+        }
+        report(cases[c].name, iterations, now_ns() - start,
+               (double) RegionNumRects(&grid));
+    }
+
+    RegionUninit(&grid);
+    RegionUninit(&shifted);
+    RegionUninit(&result);
+}
+
+int
+main(int argc, char **argv)
+{
+    printf("{\n    \"benchmarks\": [");
+
+    bench_blt();
+    bench_composite();
+    bench_region();
+
+    printf("\n    ]\n}\n");
+    return 0;
+}
@@ -69,6 +69,7 @@ static DevPrivateKeyRec CursorScreenPrivateKeyRec;
 #define CursorScreenPrivateKey (&CursorScreenPrivateKeyRec)
 
 static void deleteCursorHideCountsForScreen(ScreenPtr pScreen);
+static Bool CursorImageWakeup(ClientPtr client, void *closure);
 
 #define VERIFY_CURSOR(pCursor, cursor, client, access)			\
     do {								\
@@ -186,6 +187,9 @@ CursorDisplayCursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
                 WriteEventsToClient(e->pClient, 1, (xEvent *) &ev);
             }
         }
+        /* reply to clients waiting in GetCursorImageIfNewer */
+        ClientSignalAll(CLIENT_SIGNAL_ANY, CursorImageWakeup,
+                        CLIENT_SIGNAL_ANY);
     }
     Wrap(cs, pScreen, DisplayCursor, backupProc);
 
@@ -359,19 +363,13 @@ CopyCursorToImage(CursorPtr pCursor, CARD32 *image)
     }
 }
 
-int
-ProcXFixesGetCursorImage(ClientPtr client)
+static int
+SendCursorImage(ClientPtr client, CursorPtr pCursor)
 {
-/*    REQUEST(xXFixesGetCursorImageReq); */
     xXFixesGetCursorImageReply *rep;
-    CursorPtr pCursor;
     CARD32 *image;
     int npixels, width, height, rc, x, y;
 
-    REQUEST_SIZE_MATCH(xXFixesGetCursorImageReq);
-    pCursor = CursorForClient(client);
-    if (!pCursor)
-        return BadCursor;
     rc = XaceHook(XACE_RESOURCE_ACCESS, client, pCursor->id, RT_CURSOR,
                   pCursor, RT_NONE, NULL, DixReadAccess);
     if (rc != Success)
@@ -416,6 +414,19 @@ ProcXFixesGetCursorImage(ClientPtr client)
     return Success;
 }
 
+int
+ProcXFixesGetCursorImage(ClientPtr client)
+{
+/*    REQUEST(xXFixesGetCursorImageReq); */
+    CursorPtr pCursor;
+
+    REQUEST_SIZE_MATCH(xXFixesGetCursorImageReq);
+    pCursor = CursorForClient(client);
+    if (!pCursor)
+        return BadCursor;
+    return SendCursorImage(client, pCursor);
+}
+
 int _X_COLD
 SProcXFixesGetCursorImage(ClientPtr client)
 {
@@ -424,6 +435,56 @@ SProcXFixesGetCursorImage(ClientPtr client)
     return (*ProcXFixesVector[stuff->xfixesReqType]) (client);
 }
 
+/*
+ * A cursor-mirroring client polling GetCursorImage re-fetches the full
+ * ARGB image however often it polls, almost always getting the image it
+ * already has.  GetCursorImageIfNewer carries the serial of the image
+ * the client holds: if the displayed cursor already differs it replies
+ * at once, otherwise the client is put to sleep and the reply is sent
+ * when the sprite changes, so unchanged cursors cost nothing.
+ */
+
+static Bool
+CursorImageWakeup(ClientPtr client, void *closure)
+{
+    if (!client->clientGone) {
+        CursorPtr pCursor = CursorForClient(client);
+
+        if (pCursor)
+            SendCursorImage(client, pCursor);
+    }
+    ClientWakeup(client);
+    return TRUE;
+}
+
+int
+ProcXFixesGetCursorImageIfNewer(ClientPtr client)
+{
+    REQUEST(xXFixesGetCursorImageIfNewerReq);
+    CursorPtr pCursor;
+
+    REQUEST_SIZE_MATCH(xXFixesGetCursorImageIfNewerReq);
+    pCursor = CursorForClient(client);
+    if (!pCursor)
+        return BadCursor;
+    if (pCursor->serialNumber == stuff->cursorSerial) {
+        if (!ClientSleep(client, CursorImageWakeup, NULL))
+            return BadAlloc;
+        return Success;
+    }
+    return SendCursorImage(client, pCursor);
+}
+
+int _X_COLD
+SProcXFixesGetCursorImageIfNewer(ClientPtr client)
+{
+    REQUEST(xXFixesGetCursorImageIfNewerReq);
+    REQUEST_SIZE_MATCH(xXFixesGetCursorImageIfNewerReq);
+    swaps(&stuff->length);
+    swapl(&stuff->cursorSerial);
+    return (*ProcXFixesVector[stuff->xfixesReqType]) (client);
+}
+
 int
 ProcXFixesSetCursorName(ClientPtr client)
 {
@@ -105,7 +105,7 @@ static const int version_requests[] = {
     X_XFixesExpandRegion,       /* Version 3 */
     X_XFixesShowCursor,         /* Version 4 */
     X_XFixesDestroyPointerBarrier,      /* Version 5 */
-    X_XFixesGetClientDisconnectMode,    /* Version 6 */
+    X_XFixesGetCursorImageIfNewer,      /* Version 6 */
 };
 
 int (*ProcXFixesVector[XFixesNumberRequests]) (ClientPtr) = {
@@ -145,6 +145,7 @@ int (*ProcXFixesVector[XFixesNumberRequests]) (ClientPtr) = {
         ProcXFixesCreatePointerBarrier, ProcXFixesDestroyPointerBarrier,
 /*************** Version 6 ****************/
         ProcXFixesSetClientDisconnectMode, ProcXFixesGetClientDisconnectMode,
+        ProcXFixesGetCursorImageIfNewer,
 };
 
 static int
@@ -209,6 +210,7 @@ static int (*SProcXFixesVector[XFixesNumberRequests]) (ClientPtr) = {
         SProcXFixesCreatePointerBarrier, SProcXFixesDestroyPointerBarrier,
 /*************** Version 6 ****************/
         SProcXFixesSetClientDisconnectMode, SProcXFixesGetClientDisconnectMode,
+        SProcXFixesGetCursorImageIfNewer,
 };
 
 static _X_COLD int
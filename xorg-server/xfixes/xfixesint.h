@@ -112,6 +112,12 @@ int
 int
  SProcXFixesGetCursorImage(ClientPtr client);
 
+int
+ ProcXFixesGetCursorImageIfNewer(ClientPtr client);
+
+int
+ SProcXFixesGetCursorImageIfNewer(ClientPtr client);
+
 /* Cursor names (Version 2) */
 
 int
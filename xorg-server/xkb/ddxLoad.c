@@ -31,7 +31,9 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <xkb-config.h>
 
 #include <stdio.h>
+#include <stdint.h>
 #include <ctype.h>
+#include <sys/stat.h>
 #include <X11/X.h>
 #include <X11/Xos.h>
 #include <X11/Xproto.h>
@@ -86,6 +88,182 @@ OutputDirectory(char *outdir, size_t size)
     }
 }
 
+#ifdef WIN32
+
+#include <X11/Xwindows.h>
+
+/*
+ * Compiled keymap cache.
+ *
+ * Spawning xkbcomp and re-parsing the xkeyboard-config sources costs
+ * hundreds of milliseconds on every server start, most of it wasted
+ * because the same keymap is compiled again and again.  Keep a copy of
+ * the compiled .xkm next to the other xkb output files, keyed on a
+ * hash of the exact keymap source handed to xkbcomp together with the
+ * mtimes and sizes of the xkeyboard-config component directories and
+ * the xkbcomp binary.  Any change to the inputs changes the key, so a
+ * stale entry is never picked up; it just stops being referenced.
+ */
+
+static uint64_t
+XkbCacheHash(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    /* FNV-1a */
+    while (len--) {
+        hash ^= *p++;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t
+XkbCacheHashStat(uint64_t hash, const char *path)
+{
+    struct stat st;
+
+    hash = XkbCacheHash(hash, path, strlen(path) + 1);
+    if (stat(path, &st) == 0) {
+        hash = XkbCacheHash(hash, &st.st_mtime, sizeof(st.st_mtime));
+        hash = XkbCacheHash(hash, &st.st_size, sizeof(st.st_size));
+    }
+    return hash;
+}
+
+static uint64_t
+XkbCacheHashSources(void)
+{
+    static const char *parts[] = {
+        "rules", "keycodes", "types", "compat", "symbols", "geometry"
+    };
+    char path[PATH_MAX];
+    uint64_t hash = 0xcbf29ce484222325ULL;      /* FNV offset basis */
+    int i;
+
+    hash = XkbCacheHash(hash, &xkbDebugFlags, sizeof(xkbDebugFlags));
+
+    if (XkbBinDirectory != NULL) {
+        if (snprintf(path, PATH_MAX, "%s" PATHSEPARATOR "xkbcomp.exe",
+                     XkbBinDirectory) < PATH_MAX)
+            hash = XkbCacheHashStat(hash, path);
+    }
+
+    if (XkbBaseDirectory != NULL) {
+        hash = XkbCacheHash(hash, XkbBaseDirectory,
+                            strlen(XkbBaseDirectory) + 1);
+        for (i = 0; i < ARRAY_SIZE(parts); i++) {
+            if (snprintf(path, PATH_MAX, "%s" PATHSEPARATOR "%s",
+                         XkbBaseDirectory, parts[i]) < PATH_MAX)
+                hash = XkbCacheHashStat(hash, path);
+        }
+    }
+    return hash;
+}
+
+static Bool
+XkbCacheHashFile(uint64_t *hash, const char *path)
+{
+    char data[4096];
+    size_t n;
+    FILE *file;
+
+    file = fopen(path, "rb");
+    if (file == NULL)
+        return FALSE;
+
+    while ((n = fread(data, 1, sizeof(data), file)) > 0)
+        *hash = XkbCacheHash(*hash, data, n);
+
+    if (ferror(file)) {
+        fclose(file);
+        return FALSE;
+    }
+    fclose(file);
+    return TRUE;
+}
+
+static Bool
+XkbCacheCopyFile(const char *srcname, const char *dstname)
+{
+    char data[4096];
+    size_t n;
+    FILE *src, *dst;
+    Bool ok = TRUE;
+
+    src = fopen(srcname, "rb");
+    if (src == NULL)
+        return FALSE;
+
+    dst = fopen(dstname, "wb");
+    if (dst == NULL) {
+        fclose(src);
+        return FALSE;
+    }
+
+    while ((n = fread(data, 1, sizeof(data), src)) > 0) {
+        if (fwrite(data, 1, n, dst) != n) {
+            ok = FALSE;
+            break;
+        }
+    }
+
+    if (ferror(src))
+        ok = FALSE;
+
+    fclose(src);
+    if (fclose(dst) != 0)
+        ok = FALSE;
+    if (!ok)
+        unlink(dstname);
+    return ok;
+}
+
+/*
+ * In-process keymap compilation.
+ *
+ * When xkbcomp.dll is installed alongside xkbcomp.exe we load it once
+ * and call its compiler entry point directly, avoiding the
+ * CreateProcess and temp-file round trip of System() (and the AV
+ * scanners that sometimes intercept it).  Any failure here simply
+ * leaves the spawn path in place as a fallback.
+ */
+typedef int (*XkbCompCompileKeymapFileProc) (const char *input,
+                                             const char *output,
+                                             const char *baseDir,
+                                             unsigned warningLvl,
+                                             const char *preMsg,
+                                             const char *prefixMsg,
+                                             const char *postMsg);
+
+static XkbCompCompileKeymapFileProc
+XkbCompDllEntry(void)
+{
+    static Bool tried = FALSE;
+    static XkbCompCompileKeymapFileProc compile = NULL;
+
+    if (!tried) {
+        char path[PATH_MAX];
+        HMODULE mod;
+
+        tried = TRUE;
+        if (XkbBinDirectory == NULL ||
+            snprintf(path, PATH_MAX, "%s" PATHSEPARATOR "xkbcomp.dll",
+                     XkbBinDirectory) >= PATH_MAX)
+            return NULL;
+        mod = LoadLibrary(path);
+        if (mod != NULL) {
+            compile = (XkbCompCompileKeymapFileProc)
+                GetProcAddress(mod, "XkbCompCompileKeymapFile");
+            if (compile == NULL)
+                FreeLibrary(mod);
+        }
+    }
+    return compile;
+}
+
+#endif /* WIN32 */
+
 /**
  * Callback invoked by XkbRunXkbComp. Write to out to talk to xkbcomp.
  */
@@ -172,23 +350,74 @@ RunXkbComp(xkbcomp_buffer_callback callback, void *userdata)
 
 #ifndef WIN32
         if (Pclose(out) == 0)
-#else
-        if (fclose(out) == 0 && System(buf) >= 0)
-#endif
         {
             if (xkbDebugFlags)
                 DebugF("[xkb] xkb executes: %s\n", buf);
             free(buf);
-#ifdef WIN32
-            unlink(tmpname);
-#endif
             return xnfstrdup(keymap);
         }
         else {
             LogMessage(X_ERROR, "Error compiling keymap (%s) executing '%s'\n",
                        keymap, buf);
         }
-#ifdef WIN32
+#else
+        if (fclose(out) == 0) {
+            char xkmname[PATH_MAX], cachename[PATH_MAX];
+            Bool cachable, built = FALSE, cached = FALSE;
+            uint64_t hash;
+            XkbCompCompileKeymapFileProc compile;
+
+            if (snprintf(xkmname, PATH_MAX, "%s%s.xkm",
+                         xkm_output_dir, keymap) >= PATH_MAX)
+                xkmname[0] = '\0';
+
+            /* Key the cache on the keymap source we just wrote plus
+               the state of the xkeyboard-config installation */
+            hash = XkbCacheHashSources();
+            cachable = xkmname[0] != '\0' &&
+                XkbCacheHashFile(&hash, tmpname) &&
+                snprintf(cachename, PATH_MAX, "%sxkbcache-%016llx.xkm",
+                         xkm_output_dir,
+                         (unsigned long long) hash) < PATH_MAX;
+
+            /* Warm start: reuse the cached compiled keymap and skip
+               the compile entirely */
+            if (cachable && XkbCacheCopyFile(cachename, xkmname)) {
+                built = cached = TRUE;
+                DebugF("[xkb] using cached keymap %s\n", cachename);
+            }
+
+            /* Next best: compile in-process through xkbcomp.dll */
+            if (!built && xkmname[0] != '\0' &&
+                (compile = XkbCompDllEntry()) != NULL) {
+                built = (*compile)(tmpname, xkmname, XkbBaseDirectory,
+                                   ((xkbDebugFlags < 2) ? 1 :
+                                    ((xkbDebugFlags > 10) ? 10 :
+                                     (int) xkbDebugFlags)),
+                                   "The XKEYBOARD keymap compiler (xkbcomp) reports:",
+                                   "> ",
+                                   "Errors from xkbcomp are not fatal to the X server") == 0;
+                if (built)
+                    DebugF("[xkb] compiled %s in-process\n", xkmname);
+            }
+
+            if (!built && System(buf) >= 0)
+                built = TRUE;
+
+            /* Save the result for the next server start */
+            if (built && !cached && cachable)
+                (void) XkbCacheCopyFile(xkmname, cachename);
+
+            if (built) {
+                if (xkbDebugFlags)
+                    DebugF("[xkb] xkb executes: %s\n", buf);
+                free(buf);
+                unlink(tmpname);
+                return xnfstrdup(keymap);
+            }
+        }
+        LogMessage(X_ERROR, "Error compiling keymap (%s) executing '%s'\n",
+                   keymap, buf);
         /* remove the temporary file */
         unlink(tmpname);
 #endif
@@ -51,6 +51,12 @@
 
 #include <stdio.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define SLIDE_HASH_SIMD
+#endif
+
 #include "deflate.h"
 
 const char deflate_copyright[] =
@@ -203,6 +209,41 @@ local const config configuration_table[10] = {
 local void slide_hash(s)
     deflate_state *s;
 {
+#ifdef SLIDE_HASH_SIMD
+    /* hash_size and w_size are powers of two no smaller than 256, so
+     * both tables can be walked eight 16-bit entries at a time.  The
+     * saturating subtract clamps entries below wsize to zero, which is
+     * NIL.
+     */
+    unsigned n;
+    Posf *p;
+    uInt wsize = s->w_size;
+    const __m128i xmm_wsize = _mm_set1_epi16((short)wsize);
+
+    n = s->hash_size;
+    p = &s->head[n] - 8;
+    do {
+        __m128i value = _mm_loadu_si128((__m128i *)p);
+        __m128i result = _mm_subs_epu16(value, xmm_wsize);
+        _mm_storeu_si128((__m128i *)p, result);
+        p -= 8;
+        n -= 8;
+    } while (n);
+#ifndef FASTEST
+    n = wsize;
+    p = &s->prev[n] - 8;
+    do {
+        __m128i value = _mm_loadu_si128((__m128i *)p);
+        __m128i result = _mm_subs_epu16(value, xmm_wsize);
+        _mm_storeu_si128((__m128i *)p, result);
+        p -= 8;
+        n -= 8;
+        /* If n is not on any hash chain, prev[n] is garbage but
+         * its value will never be used.
+         */
+    } while (n);
+#endif
+#else /* SLIDE_HASH_SIMD */
     unsigned n, m;
     Posf *p;
     uInt wsize = s->w_size;
@@ -224,6 +265,7 @@ local void slide_hash(s)
          */
     } while (--n);
 #endif
+#endif /* SLIDE_HASH_SIMD */
 }
 
 /* ========================================================================= */
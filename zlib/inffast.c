@@ -197,14 +197,17 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         }
 #endif
                     }
+                    /* The window never overlaps the output buffer, so
+                       each window segment can be moved with a single
+                       zmemcpy() of its exact length rather than a byte
+                       loop */
                     from = window;
                     if (wnext == 0) {           /* very common case */
                         from += wsize - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            zmemcpy(out, from, op);
+                            out += op;
                             from = out - dist;  /* rest from output */
                         }
                     }
@@ -213,16 +216,14 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         op -= wnext;
                         if (op < len) {         /* some from end of window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            zmemcpy(out, from, op);
+                            out += op;
                             from = window;
                             if (wnext < len) {  /* some from start of window */
                                 op = wnext;
                                 len -= op;
-                                do {
-                                    *out++ = *from++;
-                                } while (--op);
+                                zmemcpy(out, from, op);
+                                out += op;
                                 from = out - dist;      /* rest from output */
                             }
                         }
@@ -231,36 +232,50 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wnext - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                *out++ = *from++;
-                            } while (--op);
+                            zmemcpy(out, from, op);
+                            out += op;
                             from = out - dist;  /* rest from output */
                         }
                     }
-                    while (len > 2) {
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        len -= 3;
+                    if (from != out - dist || dist >= len) {
+                        /* still in the window, or far enough back in the
+                           output that source and destination can't
+                           overlap */
+                        zmemcpy(out, from, len);
+                        out += len;
                     }
-                    if (len) {
-                        *out++ = *from++;
-                        if (len > 1)
-                            *out++ = *from++;
+                    else {                      /* overlapped copy */
+                        do {
+                            unsigned chunk = (unsigned)(out - from);
+
+                            if (chunk > len)
+                                chunk = len;
+                            zmemcpy(out, from, chunk);
+                            out += chunk;
+                            len -= chunk;
+                        } while (len);
                     }
                 }
                 else {
                     from = out - dist;          /* copy direct from output */
-                    do {                        /* minimum length is three */
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        *out++ = *from++;
-                        len -= 3;
-                    } while (len > 2);
-                    if (len) {
-                        *out++ = *from++;
-                        if (len > 1)
-                            *out++ = *from++;
+                    if (dist >= len) {          /* non-overlapping */
+                        zmemcpy(out, from, len);
+                        out += len;
+                    }
+                    else {
+                        /* Overlapped copy: replicate the period, with the
+                           copyable chunk doubling every pass (this also
+                           covers dist == 1 runs, which memset-style
+                           replication reaches in log2(len) passes) */
+                        do {
+                            unsigned chunk = (unsigned)(out - from);
+
+                            if (chunk > len)
+                                chunk = len;
+                            zmemcpy(out, from, chunk);
+                            out += chunk;
+                            len -= chunk;
+                        } while (len);
                     }
                 }
             }